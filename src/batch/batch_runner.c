@@ -0,0 +1,659 @@
+#include "batch/batch_runner.h"
+
+#include <string.h>
+
+#include "machine/machine.h"
+#include "machine/save_state.h"
+#include "batch/thread_pool.h"
+
+#define MANIFEST_MAX_LINE 4096
+
+/**
+ * @brief Host section of a checkpoint: where the job is in its input and what it printed so
+ * far. The output bytes follow the struct
+ */
+typedef struct BatchCheckpoint_t
+{
+    qword_t inputPosition;
+    qword_t outputSize;
+    dword_t isOutputTruncated;
+    dword_t reserved;
+} BatchCheckpoint_t;
+
+/**
+ * @brief State of a job while it is in the pool
+ */
+typedef struct BatchTask_t
+{
+    BatchRunner_t *runner;
+    size_t index;
+
+    /** @brief Created with the first time slice, destroyed with the last */
+    Machine_t *machine;
+    /** @brief Coverage of this job alone, merged into the runner map by @ref finishTask */
+    Coverage_t *coverage;
+
+    byte_t *input;
+    size_t inputSize;
+    size_t inputPosition;
+
+    /** @brief Checkpoint file, NULL without a runner state directory */
+    char *statePath;
+    /** @brief Cycle count the next checkpoint is written at */
+    qword_t nextCheckpoint;
+} BatchTask_t;
+
+/**
+ * @brief Runs one time slice of a job
+ *
+ * @param argument BatchTask_t
+ * @return ThreadPoolTaskStatus
+ */
+static ThreadPoolTaskStatus runSlice(void *argument);
+
+/**
+ * @brief Creates the machine of a task and loads ROM and input
+ *
+ * @param task
+ * @return bool False if the job can not run, the error is stored in the result
+ */
+static bool startTask(BatchTask_t *task);
+
+/**
+ * @brief Stores the final state in the result, merges the coverage and releases the machine
+ *
+ * @param task
+ */
+static void finishTask(BatchTask_t *task);
+
+/**
+ * @brief Continues a job from its checkpoint file if there is one
+ *
+ * @param task
+ * @return bool False if the file exists but does not belong to the job
+ */
+static bool resumeTask(BatchTask_t *task);
+
+/**
+ * @brief Saves the machine, input position and output of a job to its checkpoint file
+ *
+ * @param task
+ * @return bool False if the file could not be written
+ */
+static bool checkpointTask(BatchTask_t *task);
+
+/**
+ * @brief Console output, appends to the job output
+ *
+ * @param context BatchTask_t
+ * @param value
+ */
+static void consoleWrite(void *context, byte_t value);
+
+/**
+ * @brief Console input, reads the next byte of the job input (0xFF after the end)
+ *
+ * @param context BatchTask_t
+ * @param value
+ */
+static void consoleRead(void *context, byte_t *value);
+
+/**
+ * @brief Reads a whole file into a heap buffer
+ *
+ * @param filename
+ * @param size
+ * @return byte_t* NULL on error
+ */
+static byte_t *readFile(const char *filename, size_t *size);
+
+/**
+ * @brief Copies a string to the heap (C99 has no strdup)
+ *
+ * @param text
+ * @return char*
+ */
+static char *copyString(const char *text);
+
+/**
+ * @brief Writes a JSON string literal
+ *
+ * @param stream
+ * @param text
+ * @param size
+ */
+static void writeJsonString(FILE *stream, const char *text, size_t size);
+
+void batchRunnerInit(BatchRunner_t *runner)
+{
+    memset(runner, 0x00, sizeof(BatchRunner_t));
+    runner->sliceCycles = BATCH_DEFAULT_SLICE_CYCLES;
+    runner->checkpointCycles = BATCH_DEFAULT_CHECKPOINT_CYCLES;
+    romStoreInit(&runner->romStore);
+    mutexInit(&runner->coverageLock);
+}
+
+void batchRunnerDestroy(BatchRunner_t *runner)
+{
+    for(size_t idx = 0; idx < runner->jobCount; idx++)
+    {
+        free(runner->jobs[idx].romPath);
+        free(runner->jobs[idx].inputPath);
+        if(runner->results != NULL)
+        {
+            free(runner->results[idx].output);
+        }
+    }
+    free(runner->jobs);
+    free(runner->results);
+
+    romStoreDestroy(&runner->romStore);
+    mutexDestroy(&runner->coverageLock);
+    memset(runner, 0x00, sizeof(BatchRunner_t));
+}
+
+bool batchRunnerAddJob(BatchRunner_t *runner, const char *romPath, const char *inputPath, long maxCycles)
+{
+    if(runner->jobCount == runner->jobCapacity)
+    {
+        size_t newCapacity = (runner->jobCapacity == 0) ? 64 : runner->jobCapacity * 2;
+        BatchJob_t *jobs = (BatchJob_t *)realloc(runner->jobs, newCapacity * sizeof(BatchJob_t));
+        if(jobs == NULL)
+        {
+            return false;
+        }
+
+        runner->jobs = jobs;
+        runner->jobCapacity = newCapacity;
+    }
+
+    BatchJob_t *job = &runner->jobs[runner->jobCount];
+    job->romPath = copyString(romPath);
+    job->inputPath = (inputPath != NULL) ? copyString(inputPath) : NULL;
+    job->maxCycles = (maxCycles > 0) ? maxCycles : BATCH_DEFAULT_MAX_CYCLES;
+
+    if(job->romPath == NULL || (inputPath != NULL && job->inputPath == NULL))
+    {
+        free(job->romPath);
+        free(job->inputPath);
+        return false;
+    }
+
+    runner->jobCount++;
+
+    return true;
+}
+
+bool batchRunnerLoadManifest(BatchRunner_t *runner, const char *filename)
+{
+    FILE *file = fopen(filename, "r");
+    if(file == NULL)
+    {
+        return false;
+    }
+
+    char line[MANIFEST_MAX_LINE];
+    bool isLoaded = true;
+
+    while(isLoaded == true && fgets(line, sizeof(line), file) != NULL)
+    {
+        char *romPath = strtok(line, " \t\r\n");
+        if(romPath == NULL || romPath[0] == '#')
+        {
+            continue;
+        }
+
+        char *inputPath = strtok(NULL, " \t\r\n");
+        char *maxCycles = strtok(NULL, " \t\r\n");
+
+        if(inputPath != NULL && strcmp(inputPath, "-") == 0)
+        {
+            inputPath = NULL;
+        }
+
+        isLoaded = batchRunnerAddJob(runner, romPath, inputPath, (maxCycles != NULL) ? strtol(maxCycles, NULL, 0) : 0);
+    }
+
+    fclose(file);
+
+    return isLoaded;
+}
+
+bool batchRunnerRun(BatchRunner_t *runner)
+{
+    free(runner->results);
+    runner->results = (BatchResult_t *)calloc(runner->jobCount + 1, sizeof(BatchResult_t));
+    BatchTask_t *tasks = (BatchTask_t *)calloc(runner->jobCount + 1, sizeof(BatchTask_t));
+
+    ThreadPool_t pool;
+    if(runner->results == NULL || tasks == NULL || threadPoolInit(&pool, runner->workerCount) == false)
+    {
+        free(tasks);
+        return false;
+    }
+
+    for(size_t idx = 0; idx < runner->jobCount; idx++)
+    {
+        tasks[idx].runner = runner;
+        tasks[idx].index = idx;
+
+        if(threadPoolSubmit(&pool, runSlice, &tasks[idx]) == false)
+        {
+            runner->results[idx].error = C80_ERROR_MEMORY_INIT_ERROR;
+        }
+    }
+
+    threadPoolWait(&pool);
+    threadPoolDestroy(&pool);
+    free(tasks);
+
+    return true;
+}
+
+void batchRunnerWriteResults(const BatchRunner_t *runner, FILE *stream)
+{
+    for(size_t idx = 0; idx < runner->jobCount; idx++)
+    {
+        const BatchJob_t *job = &runner->jobs[idx];
+        const BatchResult_t *result = &runner->results[idx];
+
+        fprintf(stream, "{\"id\":%zu,\"rom\":", idx);
+        writeJsonString(stream, job->romPath, strlen(job->romPath));
+
+        if(result->isRun == false)
+        {
+            fprintf(stream, ",\"error\":");
+            const char *message = getErrorMessage(result->error);
+            writeJsonString(stream, message, strlen(message));
+            fprintf(stream, "}\n");
+            continue;
+        }
+
+        fprintf(stream, ",\"stop\":\"%s\",\"pc\":%u,\"cycles\":%llu,\"hash\":\"%016llx\",\"output\":",
+                zilogZ80StopReasonName(result->stopReason), (unsigned int)result->pc,
+                (unsigned long long)result->cycles, (unsigned long long)result->stateHash);
+        writeJsonString(stream, result->output, result->outputSize);
+        if(result->isOutputTruncated == true)
+        {
+            fprintf(stream, ",\"truncated\":true");
+        }
+        if(runner->coverage != NULL)
+        {
+            fprintf(stream, ",\"coverage\":{\"addresses\":%zu,\"edges\":%zu,\"new\":%zu}",
+                    result->coverageAddresses, result->coverageEdges, result->coverageNew);
+        }
+        fprintf(stream, "}\n");
+    }
+}
+
+static ThreadPoolTaskStatus runSlice(void *argument)
+{
+    BatchTask_t *task = (BatchTask_t *)argument;
+    const BatchJob_t *job = &task->runner->jobs[task->index];
+
+    if(task->machine == NULL && startTask(task) == false)
+    {
+        return THREAD_POOL_TASK_DONE;
+    }
+
+    Machine_t *machine = task->machine;
+
+    long remainingCycles = job->maxCycles - (long)machine->scheduler.totalCycles;
+    long budget = (remainingCycles < task->runner->sliceCycles) ? remainingCycles : task->runner->sliceCycles;
+
+    StopReason stopReason = machineRun(machine, budget);
+    if(stopReason == STOP_REASON_BUDGET && (long)machine->scheduler.totalCycles < job->maxCycles)
+    {
+        if(task->statePath != NULL && machine->scheduler.totalCycles >= task->nextCheckpoint)
+        {
+            // A failed checkpoint only costs the ability to resume, the job goes on
+            checkpointTask(task);
+            task->nextCheckpoint = machine->scheduler.totalCycles + (qword_t)task->runner->checkpointCycles;
+        }
+        return THREAD_POOL_TASK_YIELD;
+    }
+
+    finishTask(task);
+
+    return THREAD_POOL_TASK_DONE;
+}
+
+static bool startTask(BatchTask_t *task)
+{
+    BatchRunner_t *runner = task->runner;
+    const BatchJob_t *job = &runner->jobs[task->index];
+    BatchResult_t *result = &runner->results[task->index];
+
+    task->machine = (Machine_t *)malloc(sizeof(Machine_t));
+    if(task->machine == NULL)
+    {
+        result->error = C80_ERROR_MEMORY_INIT_ERROR;
+        return false;
+    }
+
+    MachineConfig_t config = machineDefaultConfig();
+    config.romStore = &runner->romStore;
+
+    bool isStarted = machineInit(task->machine, &config)
+        && machineLoadRom(task->machine, job->romPath, ROM_FORMAT_AUTO);
+
+    if(isStarted == true && runner->coverage != NULL)
+    {
+        task->coverage = coverageCreate();
+        isStarted = (task->coverage != NULL);
+        if(isStarted == false)
+        {
+            result->error = C80_ERROR_MEMORY_INIT_ERROR;
+        }
+    }
+
+    if(isStarted == true && job->inputPath != NULL)
+    {
+        task->input = readFile(job->inputPath, &task->inputSize);
+        isStarted = (task->input != NULL);
+        if(isStarted == false)
+        {
+            result->error = C80_ERROR_ROM_FILE_READ_ERROR;
+        }
+    }
+
+    if(isStarted == true && runner->stateDirectory != NULL)
+    {
+        size_t pathSize = strlen(runner->stateDirectory) + 48;
+        task->statePath = (char *)malloc(pathSize);
+        isStarted = (task->statePath != NULL);
+
+        if(isStarted == false)
+        {
+            result->error = C80_ERROR_MEMORY_INIT_ERROR;
+        }
+        else
+        {
+            snprintf(task->statePath, pathSize, "%s/job-%zu.c80s", runner->stateDirectory, task->index);
+            isStarted = resumeTask(task);
+        }
+    }
+
+    if(isStarted == false)
+    {
+        if(task->machine->errors.topIndex >= 0)
+        {
+            result->error = task->machine->errors.errors[task->machine->errors.topIndex].error;
+        }
+
+        machineDestroy(task->machine);
+        free(task->machine);
+        task->machine = NULL;
+        free(task->input);
+        task->input = NULL;
+        coverageDestroy(task->coverage);
+        task->coverage = NULL;
+        free(task->statePath);
+        task->statePath = NULL;
+
+        return false;
+    }
+
+    task->machine->cpu.ioContext = task;
+    task->machine->cpu.coverage = task->coverage;
+    task->machine->cpu.outputCallback[BATCH_CONSOLE_PORT] = consoleWrite;
+    task->machine->cpu.inputCallback[BATCH_CONSOLE_PORT] = consoleRead;
+
+    return true;
+}
+
+static void finishTask(BatchTask_t *task)
+{
+    Machine_t *machine = task->machine;
+    BatchResult_t *result = &task->runner->results[task->index];
+
+    result->isRun = true;
+    result->stopReason = machine->cpu.stopReason;
+    result->pc = machine->cpu.PC;
+    result->cycles = machine->scheduler.totalCycles;
+    result->stateHash = machineHashState(machine);
+
+    if(task->coverage != NULL)
+    {
+        result->coverageAddresses = task->coverage->addressCount;
+        result->coverageEdges = task->coverage->edgeCount;
+
+        mutexLock(&task->runner->coverageLock);
+        result->coverageNew = coverageMerge(task->runner->coverage, task->coverage);
+        mutexUnlock(&task->runner->coverageLock);
+
+        machine->cpu.coverage = NULL;
+        coverageDestroy(task->coverage);
+        task->coverage = NULL;
+    }
+
+    machineDestroy(machine);
+    free(machine);
+    task->machine = NULL;
+
+    free(task->input);
+    task->input = NULL;
+
+    // A finished job starts over when the batch is run again
+    if(task->statePath != NULL)
+    {
+        remove(task->statePath);
+        free(task->statePath);
+        task->statePath = NULL;
+    }
+}
+
+static bool resumeTask(BatchTask_t *task)
+{
+    Machine_t *machine = task->machine;
+    BatchResult_t *result = &task->runner->results[task->index];
+    ErrorStack_t *previousStack = errorStackSetCurrent(&machine->errors);
+
+    task->nextCheckpoint = (qword_t)task->runner->checkpointCycles;
+
+    SaveStateFile_t file;
+    if(saveStateOpen(&file, task->statePath) == false)
+    {
+        // No checkpoint yet, the job starts from the beginning
+        bool isFresh = hasError(C80_ERROR_STATE_FILE_NOT_FOUND);
+        if(isFresh == true)
+        {
+            clearError(C80_ERROR_STATE_FILE_NOT_FOUND);
+        }
+        errorStackSetCurrent(previousStack);
+        return isFresh;
+    }
+
+    size_t hostSize;
+    const byte_t *host = saveStateSection(&file, SAVE_STATE_SECTION_HOST, &hostSize);
+    BatchCheckpoint_t checkpoint = { 0 };
+    bool isResumed = false;
+
+    if(host != NULL && hostSize >= sizeof(BatchCheckpoint_t))
+    {
+        memcpy(&checkpoint, host, sizeof(checkpoint));
+        isResumed = checkpoint.inputPosition <= task->inputSize
+            && checkpoint.outputSize <= BATCH_MAX_OUTPUT_SIZE
+            && hostSize == sizeof(BatchCheckpoint_t) + checkpoint.outputSize;
+    }
+
+    if(isResumed == false)
+    {
+        setError(C80_ERROR_STATE_FILE_FORMAT_ERROR);
+    }
+    else if(checkpoint.outputSize > 0)
+    {
+        result->output = (char *)malloc(BATCH_MAX_OUTPUT_SIZE);
+        isResumed = (result->output != NULL);
+        if(isResumed == false)
+        {
+            setError(C80_ERROR_MEMORY_INIT_ERROR);
+        }
+    }
+
+    isResumed = isResumed && saveStateApply(&file, machine);
+
+    if(isResumed == true)
+    {
+        task->inputPosition = (size_t)checkpoint.inputPosition;
+        if(checkpoint.outputSize > 0)
+        {
+            memcpy(result->output, host + sizeof(BatchCheckpoint_t), (size_t)checkpoint.outputSize);
+        }
+        result->outputSize = (size_t)checkpoint.outputSize;
+        result->isOutputTruncated = (checkpoint.isOutputTruncated != 0);
+        task->nextCheckpoint = machine->scheduler.totalCycles + (qword_t)task->runner->checkpointCycles;
+    }
+    else
+    {
+        free(result->output);
+        result->output = NULL;
+    }
+
+    saveStateClose(&file);
+    errorStackSetCurrent(previousStack);
+
+    return isResumed;
+}
+
+static bool checkpointTask(BatchTask_t *task)
+{
+    const BatchResult_t *result = &task->runner->results[task->index];
+    size_t hostSize = sizeof(BatchCheckpoint_t) + result->outputSize;
+
+    byte_t *host = (byte_t *)malloc(hostSize);
+    if(host == NULL)
+    {
+        return false;
+    }
+
+    BatchCheckpoint_t checkpoint = {
+        .inputPosition = task->inputPosition,
+        .outputSize = result->outputSize,
+        .isOutputTruncated = (result->isOutputTruncated == true) ? 1 : 0,
+        .reserved = 0};
+    memcpy(host, &checkpoint, sizeof(checkpoint));
+    if(result->outputSize > 0)
+    {
+        memcpy(host + sizeof(checkpoint), result->output, result->outputSize);
+    }
+
+    ErrorStack_t *previousStack = errorStackSetCurrent(&task->machine->errors);
+    bool isSaved = saveStateWrite(task->machine, task->statePath, host, hostSize);
+    errorStackSetCurrent(previousStack);
+
+    free(host);
+
+    return isSaved;
+}
+
+static void consoleWrite(void *context, byte_t value)
+{
+    BatchTask_t *task = (BatchTask_t *)context;
+    BatchResult_t *result = &task->runner->results[task->index];
+
+    if(result->outputSize == BATCH_MAX_OUTPUT_SIZE)
+    {
+        result->isOutputTruncated = true;
+        return;
+    }
+
+    if(result->output == NULL)
+    {
+        // Only jobs that print get a buffer
+        result->output = (char *)malloc(BATCH_MAX_OUTPUT_SIZE);
+        if(result->output == NULL)
+        {
+            result->isOutputTruncated = true;
+            return;
+        }
+    }
+
+    result->output[result->outputSize] = (char)value;
+    result->outputSize++;
+}
+
+static void consoleRead(void *context, byte_t *value)
+{
+    BatchTask_t *task = (BatchTask_t *)context;
+
+    if(task->inputPosition < task->inputSize)
+    {
+        *value = task->input[task->inputPosition];
+        task->inputPosition++;
+    }
+    else
+    {
+        *value = 0xFF;
+    }
+}
+
+static byte_t *readFile(const char *filename, size_t *size)
+{
+    FILE *file = fopen(filename, "rb");
+    if(file == NULL)
+    {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    // One extra byte so empty files still get a buffer
+    byte_t *data = (fileSize >= 0) ? (byte_t *)malloc((size_t)fileSize + 1) : NULL;
+    if(data != NULL && fread(data, 1, (size_t)fileSize, file) != (size_t)fileSize)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+
+    *size = (data != NULL) ? (size_t)fileSize : 0;
+
+    return data;
+}
+
+static char *copyString(const char *text)
+{
+    size_t length = strlen(text);
+    char *copy = (char *)malloc(length + 1);
+
+    if(copy != NULL)
+    {
+        memcpy(copy, text, length + 1);
+    }
+
+    return copy;
+}
+
+static void writeJsonString(FILE *stream, const char *text, size_t size)
+{
+    fputc('"', stream);
+
+    for(size_t idx = 0; idx < size; idx++)
+    {
+        unsigned char character = (unsigned char)text[idx];
+
+        if(character == '"' || character == '\\')
+        {
+            fputc('\\', stream);
+            fputc(character, stream);
+        }
+        else if(character == '\n')
+        {
+            fputs("\\n", stream);
+        }
+        else if(character < 0x20 || character >= 0x7F)
+        {
+            // Guest output is raw bytes, escape everything that is not printable ASCII
+            fprintf(stream, "\\u%04x", character);
+        }
+        else
+        {
+            fputc(character, stream);
+        }
+    }
+
+    fputc('"', stream);
+}
@@ -0,0 +1,159 @@
+#ifndef CILOGC80_BATCH_RUNNER_H
+#define CILOGC80_BATCH_RUNNER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "utils/utils.h"
+#include "utils/error_handler.h"
+#include "utils/threading.h"
+#include "cpu/cpu.h"
+#include "cpu/coverage.h"
+#include "emulator/rom_store.h"
+
+/** @brief Console port: OUT writes to the job output, IN reads the job input */
+#define BATCH_CONSOLE_PORT 0x01
+/** @brief Default cycles per time slice */
+#define BATCH_DEFAULT_SLICE_CYCLES 100000
+/** @brief Default cycle limit of a job */
+#define BATCH_DEFAULT_MAX_CYCLES 100000000L
+/** @brief Console output kept per job, the rest is dropped */
+#define BATCH_MAX_OUTPUT_SIZE (64 * 1024)
+/** @brief Default cycles between two checkpoints of a job */
+#define BATCH_DEFAULT_CHECKPOINT_CYCLES 100000000L
+
+/**
+ * @brief One guest program to run
+ */
+typedef struct BatchJob_t
+{
+    /** @brief ROM file */
+    char *romPath;
+    /** @brief File fed to the console port, NULL for no input */
+    char *inputPath;
+    /** @brief Cycle limit, the job stops with STOP_REASON_BUDGET when reached */
+    long maxCycles;
+} BatchJob_t;
+
+/**
+ * @brief Outcome of a job
+ */
+typedef struct BatchResult_t
+{
+    /** @brief False if the job could not be started (see error) */
+    bool isRun;
+    C80_Error_t error;
+
+    StopReason stopReason;
+    /** @brief Final PC */
+    word_t pc;
+    /** @brief Cycles executed */
+    qword_t cycles;
+    /** @brief Hash of the final machine state (see @ref machineHashState) */
+    qword_t stateHash;
+
+    /** @brief Console output (not zero terminated) */
+    char *output;
+    size_t outputSize;
+    /** @brief True if output was dropped after @ref BATCH_MAX_OUTPUT_SIZE */
+    bool isOutputTruncated;
+
+    /** @brief Addresses and edges the job executed (only with a runner coverage map) */
+    size_t coverageAddresses;
+    size_t coverageEdges;
+    /**
+     * @brief Addresses and edges no job merged before this one. Jobs finish in any order,
+     * only the sum over all jobs is reproducible
+     */
+    size_t coverageNew;
+} BatchResult_t;
+
+/**
+ * @brief Runs many jobs on a work stealing thread pool. Every job gets its own machine,
+ * ROMs with the same contents are shared read-only between them
+ */
+typedef struct BatchRunner_t
+{
+    BatchJob_t *jobs;
+    size_t jobCount;
+    size_t jobCapacity;
+
+    /** @brief Results, indexed like jobs (valid after @ref batchRunnerRun) */
+    BatchResult_t *results;
+
+    /** @brief Worker threads, 0 for one per logical processor */
+    int workerCount;
+    /** @brief Cycles a machine runs before the worker moves on */
+    long sliceCycles;
+
+    RomStore_t romStore;
+
+    /**
+     * @brief Coverage of every job is merged into this map when the job finishes, NULL
+     * disables coverage. Owned by the caller, jobs record on the reference core only
+     */
+    Coverage_t *coverage;
+    Mutex_t coverageLock;
+
+    /**
+     * @brief Directory every job saves its state to ("job-<id>.c80s") every checkpointCycles
+     * cycles, NULL disables checkpoints. A job finding its state file resumes from it, the
+     * file is removed when the job finishes. Owned by the caller
+     */
+    const char *stateDirectory;
+    long checkpointCycles;
+} BatchRunner_t;
+
+/**
+ * @brief Initializes an empty runner
+ *
+ * @param runner
+ */
+void batchRunnerInit(BatchRunner_t *runner);
+
+/**
+ * @brief Releases jobs and results
+ *
+ * @param runner
+ */
+void batchRunnerDestroy(BatchRunner_t *runner);
+
+/**
+ * @brief Adds a job
+ *
+ * @param runner
+ * @param romPath
+ * @param inputPath NULL for no input
+ * @param maxCycles 0 for @ref BATCH_DEFAULT_MAX_CYCLES
+ * @return bool False if memory could not be allocated
+ */
+bool batchRunnerAddJob(BatchRunner_t *runner, const char *romPath, const char *inputPath, long maxCycles);
+
+/**
+ * @brief Adds the jobs of a manifest file. One job per line: "rom [input|-] [max-cycles]",
+ * empty lines and lines starting with '#' are skipped
+ *
+ * @param runner
+ * @param filename
+ * @return bool False if the file could not be read
+ */
+bool batchRunnerLoadManifest(BatchRunner_t *runner, const char *filename);
+
+/**
+ * @brief Runs all jobs and waits for them
+ *
+ * @param runner
+ * @return bool False if the thread pool could not be started
+ */
+bool batchRunnerRun(BatchRunner_t *runner);
+
+/**
+ * @brief Writes one JSON object per job, in job order
+ *
+ * @param runner
+ * @param stream
+ */
+void batchRunnerWriteResults(const BatchRunner_t *runner, FILE *stream);
+
+#endif // CILOGC80_BATCH_RUNNER_H
@@ -0,0 +1,404 @@
+#include "batch/thread_pool.h"
+
+#include <string.h>
+
+#define DEQUE_INITIAL_CAPACITY 64
+
+/**
+ * @brief Initializes an empty deque
+ *
+ * @param deque
+ * @return bool
+ */
+static bool dequeInit(ThreadPoolDeque_t *deque);
+
+/**
+ * @brief Releases the deque
+ *
+ * @param deque
+ */
+static void dequeDestroy(ThreadPoolDeque_t *deque);
+
+/**
+ * @brief Pushes a task to the bottom (owner side), growing the ring buffer if needed
+ *
+ * @param deque
+ * @param task
+ * @return bool False if memory could not be allocated
+ */
+static bool dequePushBottom(ThreadPoolDeque_t *deque, ThreadPoolTask_t task);
+
+/**
+ * @brief Pushes a task to the top (thief side), behind every task already queued. Used for
+ * yielded tasks so they take turns with the rest of the deque
+ *
+ * @param deque
+ * @param task
+ * @return bool False if memory could not be allocated
+ */
+static bool dequePushTop(ThreadPoolDeque_t *deque, ThreadPoolTask_t task);
+
+/**
+ * @brief Doubles the ring buffer. Called with the deque mutex held
+ *
+ * @param deque
+ * @return bool False if memory could not be allocated
+ */
+static bool dequeGrow(ThreadPoolDeque_t *deque);
+
+/**
+ * @brief Pops the newest task (owner side)
+ *
+ * @param deque
+ * @param task
+ * @return bool False if the deque is empty
+ */
+static bool dequePopBottom(ThreadPoolDeque_t *deque, ThreadPoolTask_t *task);
+
+/**
+ * @brief Takes the oldest task (thief side)
+ *
+ * @param deque
+ * @param task
+ * @return bool False if the deque is empty
+ */
+static bool dequeStealTop(ThreadPoolDeque_t *deque, ThreadPoolTask_t *task);
+
+/**
+ * @brief Tries to steal a task from the other workers
+ *
+ * @param worker Thief
+ * @param task
+ * @return bool False if every other deque is empty
+ */
+static bool stealTask(ThreadPoolWorker_t *worker, ThreadPoolTask_t *task);
+
+/**
+ * @brief Wakes a sleeping worker, if there is one
+ *
+ * @param pool
+ */
+static void wakeWorker(ThreadPool_t *pool);
+
+/**
+ * @brief Worker thread main loop
+ *
+ * @param argument ThreadPoolWorker_t of the thread
+ */
+static void workerMain(void *argument);
+
+bool threadPoolInit(ThreadPool_t *pool, int workerCount)
+{
+    if(pool == NULL)
+    {
+        return false;
+    }
+
+    if(workerCount <= 0)
+    {
+        workerCount = threadHardwareConcurrency();
+    }
+    if(workerCount > THREAD_POOL_MAX_WORKERS)
+    {
+        workerCount = THREAD_POOL_MAX_WORKERS;
+    }
+
+    memset(pool, 0x00, sizeof(ThreadPool_t));
+    mutexInit(&pool->mutex);
+    conditionInit(&pool->workCondition);
+    conditionInit(&pool->doneCondition);
+
+    pool->workers = (ThreadPoolWorker_t *)calloc((size_t)workerCount, sizeof(ThreadPoolWorker_t));
+    if(pool->workers == NULL)
+    {
+        return false;
+    }
+
+    // All deques have to exist before the first worker starts stealing
+    for(int idx = 0; idx < workerCount; idx++)
+    {
+        pool->workers[idx].pool = pool;
+        pool->workers[idx].index = idx;
+        if(dequeInit(&pool->workers[idx].deque) == false)
+        {
+            for(int created = 0; created <= idx; created++)
+            {
+                dequeDestroy(&pool->workers[created].deque);
+            }
+            free(pool->workers);
+            pool->workers = NULL;
+            return false;
+        }
+    }
+    pool->workerCount = workerCount;
+
+    for(int idx = 0; idx < workerCount; idx++)
+    {
+        if(threadCreate(&pool->workers[idx].thread, workerMain, &pool->workers[idx]) == false)
+        {
+            // Only the started workers are joined
+            pool->workerCount = idx;
+            threadPoolDestroy(pool);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void threadPoolDestroy(ThreadPool_t *pool)
+{
+    if(pool == NULL || pool->workers == NULL)
+    {
+        return;
+    }
+
+    threadPoolWait(pool);
+
+    mutexLock(&pool->mutex);
+    pool->isShuttingDown = true;
+    conditionBroadcast(&pool->workCondition);
+    mutexUnlock(&pool->mutex);
+
+    for(int idx = 0; idx < pool->workerCount; idx++)
+    {
+        threadJoin(&pool->workers[idx].thread);
+    }
+    for(int idx = 0; idx < pool->workerCount; idx++)
+    {
+        dequeDestroy(&pool->workers[idx].deque);
+    }
+    free(pool->workers);
+    pool->workers = NULL;
+    pool->workerCount = 0;
+
+    conditionDestroy(&pool->workCondition);
+    conditionDestroy(&pool->doneCondition);
+    mutexDestroy(&pool->mutex);
+}
+
+bool threadPoolSubmit(ThreadPool_t *pool, ThreadPoolTaskFunction_t function, void *argument)
+{
+    ThreadPoolTask_t task = { .function = function, .argument = argument };
+
+    int workerIndex = (int)((unsigned long)atomicAdd(&pool->nextWorker, 1) % (unsigned long)pool->workerCount);
+
+    atomicAdd(&pool->pendingCount, 1);
+    if(dequePushBottom(&pool->workers[workerIndex].deque, task) == false)
+    {
+        atomicAdd(&pool->pendingCount, -1);
+        return false;
+    }
+    atomicAdd(&pool->queuedCount, 1);
+    wakeWorker(pool);
+
+    return true;
+}
+
+void threadPoolWait(ThreadPool_t *pool)
+{
+    mutexLock(&pool->mutex);
+    while(atomicLoad(&pool->pendingCount) > 0)
+    {
+        conditionWait(&pool->doneCondition, &pool->mutex);
+    }
+    mutexUnlock(&pool->mutex);
+}
+
+static void workerMain(void *argument)
+{
+    ThreadPoolWorker_t *worker = (ThreadPoolWorker_t *)argument;
+    ThreadPool_t *pool = worker->pool;
+
+    while(true)
+    {
+        ThreadPoolTask_t task;
+
+        if(dequePopBottom(&worker->deque, &task) == true || stealTask(worker, &task) == true)
+        {
+            atomicAdd(&pool->queuedCount, -1);
+
+            ThreadPoolTaskStatus status = task.function(task.argument);
+            worker->sliceCount++;
+
+            // A yielded task goes behind everything in the own deque, the bottom would hand
+            // it straight back. Without memory to queue it, it keeps the worker instead
+            while(status == THREAD_POOL_TASK_YIELD && dequePushTop(&worker->deque, task) == false)
+            {
+                status = task.function(task.argument);
+                worker->sliceCount++;
+            }
+
+            if(status == THREAD_POOL_TASK_YIELD)
+            {
+                // Idle workers steal from the top, so the task may continue elsewhere
+                atomicAdd(&pool->queuedCount, 1);
+                wakeWorker(pool);
+            }
+            else if(atomicAdd(&pool->pendingCount, -1) == 1)
+            {
+                mutexLock(&pool->mutex);
+                conditionBroadcast(&pool->doneCondition);
+                mutexUnlock(&pool->mutex);
+            }
+            continue;
+        }
+
+        // Every deque looked empty, sleep until new work is queued
+        mutexLock(&pool->mutex);
+        atomicAdd(&pool->idleCount, 1);
+        while(atomicLoad(&pool->queuedCount) == 0 && pool->isShuttingDown == false)
+        {
+            conditionWait(&pool->workCondition, &pool->mutex);
+        }
+        atomicAdd(&pool->idleCount, -1);
+        bool isDone = pool->isShuttingDown == true && atomicLoad(&pool->queuedCount) == 0;
+        mutexUnlock(&pool->mutex);
+
+        if(isDone == true)
+        {
+            break;
+        }
+    }
+}
+
+static void wakeWorker(ThreadPool_t *pool)
+{
+    // Workers increment idleCount before checking queuedCount, the counter is bumped before
+    // this check, so either the worker sees the task or this sees the worker
+    if(atomicLoad(&pool->idleCount) > 0)
+    {
+        mutexLock(&pool->mutex);
+        conditionSignal(&pool->workCondition);
+        mutexUnlock(&pool->mutex);
+    }
+}
+
+static bool stealTask(ThreadPoolWorker_t *worker, ThreadPoolTask_t *task)
+{
+    ThreadPool_t *pool = worker->pool;
+
+    for(int offset = 1; offset < pool->workerCount; offset++)
+    {
+        ThreadPoolWorker_t *victim = &pool->workers[(worker->index + offset) % pool->workerCount];
+
+        if(dequeStealTop(&victim->deque, task) == true)
+        {
+            worker->stolenCount++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool dequeInit(ThreadPoolDeque_t *deque)
+{
+    deque->tasks = (ThreadPoolTask_t *)malloc(DEQUE_INITIAL_CAPACITY * sizeof(ThreadPoolTask_t));
+    deque->capacity = DEQUE_INITIAL_CAPACITY;
+    deque->top = 0;
+    deque->bottom = 0;
+    mutexInit(&deque->mutex);
+
+    return deque->tasks != NULL;
+}
+
+static void dequeDestroy(ThreadPoolDeque_t *deque)
+{
+    free(deque->tasks);
+    deque->tasks = NULL;
+    mutexDestroy(&deque->mutex);
+}
+
+static bool dequePushBottom(ThreadPoolDeque_t *deque, ThreadPoolTask_t task)
+{
+    mutexLock(&deque->mutex);
+
+    if(deque->bottom - deque->top == deque->capacity && dequeGrow(deque) == false)
+    {
+        mutexUnlock(&deque->mutex);
+        return false;
+    }
+
+    deque->tasks[deque->bottom & (deque->capacity - 1)] = task;
+    deque->bottom++;
+
+    mutexUnlock(&deque->mutex);
+
+    return true;
+}
+
+static bool dequePushTop(ThreadPoolDeque_t *deque, ThreadPoolTask_t task)
+{
+    mutexLock(&deque->mutex);
+
+    if(deque->bottom - deque->top == deque->capacity && dequeGrow(deque) == false)
+    {
+        mutexUnlock(&deque->mutex);
+        return false;
+    }
+
+    // top may wrap below 0, the indices are only used modulo the capacity
+    deque->top--;
+    deque->tasks[deque->top & (deque->capacity - 1)] = task;
+
+    mutexUnlock(&deque->mutex);
+
+    return true;
+}
+
+static bool dequeGrow(ThreadPoolDeque_t *deque)
+{
+    size_t count = deque->bottom - deque->top;
+    ThreadPoolTask_t *tasks = (ThreadPoolTask_t *)malloc(deque->capacity * 2 * sizeof(ThreadPoolTask_t));
+    if(tasks == NULL)
+    {
+        return false;
+    }
+
+    // Unwrap the ring into the new buffer
+    for(size_t idx = 0; idx < count; idx++)
+    {
+        tasks[idx] = deque->tasks[(deque->top + idx) & (deque->capacity - 1)];
+    }
+    free(deque->tasks);
+
+    deque->tasks = tasks;
+    deque->top = 0;
+    deque->bottom = count;
+    deque->capacity *= 2;
+
+    return true;
+}
+
+static bool dequePopBottom(ThreadPoolDeque_t *deque, ThreadPoolTask_t *task)
+{
+    bool isTaken = false;
+
+    mutexLock(&deque->mutex);
+    if(deque->bottom != deque->top)
+    {
+        deque->bottom--;
+        *task = deque->tasks[deque->bottom & (deque->capacity - 1)];
+        isTaken = true;
+    }
+    mutexUnlock(&deque->mutex);
+
+    return isTaken;
+}
+
+static bool dequeStealTop(ThreadPoolDeque_t *deque, ThreadPoolTask_t *task)
+{
+    bool isTaken = false;
+
+    mutexLock(&deque->mutex);
+    if(deque->bottom != deque->top)
+    {
+        *task = deque->tasks[deque->top & (deque->capacity - 1)];
+        deque->top++;
+        isTaken = true;
+    }
+    mutexUnlock(&deque->mutex);
+
+    return isTaken;
+}
@@ -0,0 +1,125 @@
+#ifndef CILOGC80_THREAD_POOL_H
+#define CILOGC80_THREAD_POOL_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "utils/threading.h"
+
+/** @brief Upper limit of worker threads */
+#define THREAD_POOL_MAX_WORKERS 256
+
+/**
+ * @brief Enum struct for defining what happens to a task after it ran
+ */
+typedef enum ThreadPoolTaskStatus
+{
+    /** @brief The task is finished */
+    THREAD_POOL_TASK_DONE = 0,
+    /** @brief The task used up its time slice and has to run again */
+    THREAD_POOL_TASK_YIELD
+} ThreadPoolTaskStatus;
+
+/**
+ * @brief Task function, runs one time slice of the task
+ */
+typedef ThreadPoolTaskStatus (*ThreadPoolTaskFunction_t)(void *argument);
+
+typedef struct ThreadPoolTask_t
+{
+    ThreadPoolTaskFunction_t function;
+    void *argument;
+} ThreadPoolTask_t;
+
+/**
+ * @brief Double ended task queue of a worker. The owner pushes / pops at the bottom (LIFO,
+ * warm caches), other workers steal from the top (oldest task first). Yielded tasks are put
+ * back at the top, so every task in the deque gets a slice before one runs again
+ */
+typedef struct ThreadPoolDeque_t
+{
+    ThreadPoolTask_t *tasks;
+    /** @brief Ring buffer capacity (power of 2) */
+    size_t capacity;
+    size_t top;
+    size_t bottom;
+
+    Mutex_t mutex;
+} ThreadPoolDeque_t;
+
+struct ThreadPool_t;
+
+typedef struct ThreadPoolWorker_t
+{
+    struct ThreadPool_t *pool;
+    int index;
+    Thread_t thread;
+    ThreadPoolDeque_t deque;
+
+    /** @brief Tasks taken from other workers */
+    long stolenCount;
+    /** @brief Time slices run */
+    long sliceCount;
+} ThreadPoolWorker_t;
+
+/**
+ * @brief Work stealing thread pool. Tasks are spread round robin over the worker deques,
+ * idle workers steal from the others and sleep only when every deque is empty
+ */
+typedef struct ThreadPool_t
+{
+    ThreadPoolWorker_t *workers;
+    int workerCount;
+
+    /** @brief Next deque used by @ref threadPoolSubmit */
+    long nextWorker;
+
+    /** @brief Tasks waiting in a deque */
+    long queuedCount;
+    /** @brief Tasks submitted but not finished */
+    long pendingCount;
+    /** @brief Workers sleeping on workCondition */
+    long idleCount;
+    bool isShuttingDown;
+
+    Mutex_t mutex;
+    /** @brief Signaled when work is queued or the pool shuts down */
+    Condition_t workCondition;
+    /** @brief Signaled when pendingCount reaches 0 */
+    Condition_t doneCondition;
+} ThreadPool_t;
+
+/**
+ * @brief Starts the workers
+ *
+ * @param pool
+ * @param workerCount Number of worker threads, 0 for one per logical processor
+ * @return bool False if the workers could not be started
+ */
+bool threadPoolInit(ThreadPool_t *pool, int workerCount);
+
+/**
+ * @brief Waits for all tasks and stops the workers
+ *
+ * @param pool
+ */
+void threadPoolDestroy(ThreadPool_t *pool);
+
+/**
+ * @brief Queues a task. Can be called from any thread, including workers
+ *
+ * @param pool
+ * @param function
+ * @param argument
+ * @return bool False if memory could not be allocated
+ */
+bool threadPoolSubmit(ThreadPool_t *pool, ThreadPoolTaskFunction_t function, void *argument);
+
+/**
+ * @brief Blocks until every submitted task is finished
+ *
+ * @param pool
+ */
+void threadPoolWait(ThreadPool_t *pool);
+
+#endif // CILOGC80_THREAD_POOL_H
@@ -0,0 +1,506 @@
+#include "bench/bench_compare.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** @brief Seed of the bootstrap, fixed so a comparison always gives the same interval */
+#define BOOTSTRAP_SEED 0x2545F491u
+
+/**
+ * @brief Reads a whole file into a zero terminated buffer
+ *
+ * @param filename
+ * @return char* NULL on errors, free with free()
+ */
+static char *readTextFile(const char *filename);
+
+/* ---------------------------- Minimal JSON reader -------------------------- */
+// Just enough for the output of benchmarkWriteJson: objects of strings, numbers and number arrays
+
+/**
+ * @brief Skips white space
+ *
+ * @param text
+ * @return const char* First non white space character
+ */
+static const char *skipSpace(const char *text);
+
+/**
+ * @brief Reads a string (text points at the opening quote)
+ *
+ * @param text
+ * @param value Destination, may be NULL
+ * @param valueSize
+ * @return const char* Character after the closing quote, NULL on errors
+ */
+static const char *parseString(const char *text, char *value, size_t valueSize);
+
+/**
+ * @brief Skips any value (string, number, literal or array)
+ *
+ * @param text
+ * @return const char* Character after the value, NULL on errors
+ */
+static const char *skipValue(const char *text);
+
+/**
+ * @brief Reads one workload object (text points at the opening brace)
+ *
+ * @param text
+ * @param result
+ * @return const char* Character after the closing brace, NULL on errors
+ */
+static const char *parseWorkload(const char *text, BenchmarkResult_t *result);
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Emulated MHz of every run of a result
+ *
+ * @param result
+ * @param mhz Destination, result->runCount values
+ */
+static void runSpeeds(const BenchmarkResult_t *result, double *mhz);
+
+/**
+ * @brief Median of an array, sorts the array
+ *
+ * @param values
+ * @param count
+ * @return double
+ */
+static double median(double *values, int count);
+
+/**
+ * @brief Median of count values drawn with replacement
+ *
+ * @param values
+ * @param count
+ * @param randomState
+ * @return double
+ */
+static double resampledMedian(const double *values, int count, unsigned int *randomState);
+
+/**
+ * @brief qsort comparator for doubles
+ */
+static int compareDoubles(const void *first, const void *second);
+
+bool benchBaselineLoad(const char *filename, BenchBaseline_t *baseline)
+{
+    baseline->results = NULL;
+    baseline->count = 0;
+
+    char *text = readTextFile(filename);
+    if(text == NULL)
+    {
+        return false;
+    }
+
+    const char *format = strstr(text, "\"format\"");
+    const char *workloads = strstr(text, "\"workloads\"");
+    if(format == NULL || workloads == NULL)
+    {
+        free(text);
+        return false;
+    }
+
+    format = skipSpace(format + strlen("\"format\""));
+    if(*format != ':' || atoi(format + 1) != BENCHMARK_JSON_FORMAT)
+    {
+        free(text);
+        return false;
+    }
+
+    const char *cursor = strchr(workloads, '[');
+    size_t capacity = 0;
+    bool isValid = (cursor != NULL);
+
+    cursor = isValid ? cursor + 1 : NULL;
+    while(isValid == true)
+    {
+        cursor = skipSpace(cursor);
+
+        if(*cursor == ']')
+        {
+            break;
+        }
+        if(*cursor == ',')
+        {
+            cursor++;
+            continue;
+        }
+        if(*cursor != '{')
+        {
+            isValid = false;
+            break;
+        }
+
+        if(baseline->count == capacity)
+        {
+            capacity = (capacity == 0) ? 16 : capacity * 2;
+            BenchmarkResult_t *results = (BenchmarkResult_t *)realloc(baseline->results,
+                                                                       capacity * sizeof(BenchmarkResult_t));
+            if(results == NULL)
+            {
+                isValid = false;
+                break;
+            }
+            baseline->results = results;
+        }
+
+        BenchmarkResult_t *result = &baseline->results[baseline->count];
+        cursor = parseWorkload(cursor, result);
+        if(cursor == NULL)
+        {
+            isValid = false;
+            break;
+        }
+
+        benchmarkSummarize(result);
+        baseline->count++;
+    }
+
+    free(text);
+
+    if(isValid == false)
+    {
+        benchBaselineDestroy(baseline);
+    }
+
+    return isValid;
+}
+
+void benchBaselineDestroy(BenchBaseline_t *baseline)
+{
+    free(baseline->results);
+    baseline->results = NULL;
+    baseline->count = 0;
+}
+
+const BenchmarkResult_t *benchBaselineFind(const BenchBaseline_t *baseline, const char *name)
+{
+    for(size_t idx = 0; idx < baseline->count; idx++)
+    {
+        if(strcmp(baseline->results[idx].name, name) == 0)
+        {
+            return &baseline->results[idx];
+        }
+    }
+
+    return NULL;
+}
+
+BenchComparison_t benchCompare(const BenchmarkResult_t *baseline, const BenchmarkResult_t *current, double threshold)
+{
+    BenchComparison_t comparison = { BENCH_VERDICT_UNCHANGED, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    double baselineSpeeds[BENCHMARK_MAX_REPEATS];
+    double currentSpeeds[BENCHMARK_MAX_REPEATS];
+    double ratios[BENCH_COMPARE_BOOTSTRAP_ROUNDS];
+    unsigned int randomState = BOOTSTRAP_SEED;
+
+    if(baseline == NULL)
+    {
+        comparison.verdict = BENCH_VERDICT_NEW;
+        comparison.currentMHz = current->medianMHz;
+        return comparison;
+    }
+    if(current->isRun == false || current->runCount == 0 || baseline->isRun == false || baseline->runCount == 0)
+    {
+        comparison.verdict = BENCH_VERDICT_FAILED;
+        return comparison;
+    }
+
+    runSpeeds(baseline, baselineSpeeds);
+    runSpeeds(current, currentSpeeds);
+
+    comparison.baselineMHz = baseline->medianMHz;
+    comparison.currentMHz = current->medianMHz;
+    comparison.ratio = (comparison.baselineMHz > 0.0) ? comparison.currentMHz / comparison.baselineMHz : 0.0;
+
+    // Percentile bootstrap of the ratio of the medians
+    for(int round = 0; round < BENCH_COMPARE_BOOTSTRAP_ROUNDS; round++)
+    {
+        double baselineMedian = resampledMedian(baselineSpeeds, baseline->runCount, &randomState);
+        double currentMedian = resampledMedian(currentSpeeds, current->runCount, &randomState);
+
+        ratios[round] = (baselineMedian > 0.0) ? currentMedian / baselineMedian : 0.0;
+    }
+    qsort(ratios, BENCH_COMPARE_BOOTSTRAP_ROUNDS, sizeof(double), compareDoubles);
+
+    int tail = (int)((1.0 - BENCH_COMPARE_CONFIDENCE) / 2.0 * BENCH_COMPARE_BOOTSTRAP_ROUNDS);
+    comparison.ratioLow = ratios[tail];
+    comparison.ratioHigh = ratios[BENCH_COMPARE_BOOTSTRAP_ROUNDS - 1 - tail];
+
+    if(comparison.ratioHigh < 1.0 && comparison.ratio < 1.0 - threshold)
+    {
+        comparison.verdict = BENCH_VERDICT_REGRESSION;
+    }
+    else if(comparison.ratioLow > 1.0 && comparison.ratio > 1.0 + threshold)
+    {
+        comparison.verdict = BENCH_VERDICT_FASTER;
+    }
+
+    return comparison;
+}
+
+size_t benchCompareAll(FILE *stream, const BenchBaseline_t *baseline, const BenchmarkResult_t *results, size_t count,
+                       double threshold)
+{
+    static const char *verdictNames[] = { "", "faster", "REGRESSION", "new", "failed" };
+    size_t regressionCount = 0;
+
+    fprintf(stream, "%-20s %10s %10s %9s %20s  %s\n", "workload", "base MHz", "MHz", "change", "95% interval", "");
+
+    for(size_t idx = 0; idx < count; idx++)
+    {
+        BenchComparison_t comparison = benchCompare(benchBaselineFind(baseline, results[idx].name), &results[idx],
+                                                    threshold);
+
+        if(comparison.verdict == BENCH_VERDICT_NEW || comparison.verdict == BENCH_VERDICT_FAILED)
+        {
+            fprintf(stream, "%-20s %10s %10.2f %9s %20s  %s\n", results[idx].name, "-", comparison.currentMHz, "-", "-",
+                    verdictNames[comparison.verdict]);
+            continue;
+        }
+
+        char interval[32];
+        snprintf(interval, sizeof(interval), "[%+.1f%%, %+.1f%%]", (comparison.ratioLow - 1.0) * 100.0,
+                 (comparison.ratioHigh - 1.0) * 100.0);
+        fprintf(stream, "%-20s %10.2f %10.2f %+8.1f%% %20s  %s\n", results[idx].name, comparison.baselineMHz,
+                comparison.currentMHz, (comparison.ratio - 1.0) * 100.0, interval, verdictNames[comparison.verdict]);
+
+        if(comparison.verdict == BENCH_VERDICT_REGRESSION)
+        {
+            regressionCount++;
+        }
+    }
+
+    return regressionCount;
+}
+
+static char *readTextFile(const char *filename)
+{
+    FILE *file = fopen(filename, "rb");
+    if(file == NULL)
+    {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *text = (size >= 0) ? (char *)malloc((size_t)size + 1) : NULL;
+    if(text != NULL)
+    {
+        size_t readSize = fread(text, 1, (size_t)size, file);
+        text[readSize] = '\0';
+    }
+
+    fclose(file);
+
+    return text;
+}
+
+static const char *skipSpace(const char *text)
+{
+    while(isspace((unsigned char)*text))
+    {
+        text++;
+    }
+
+    return text;
+}
+
+static const char *parseString(const char *text, char *value, size_t valueSize)
+{
+    size_t length = 0;
+
+    if(*text != '"')
+    {
+        return NULL;
+    }
+    text++;
+
+    while(*text != '"')
+    {
+        if(*text == '\0')
+        {
+            return NULL;
+        }
+        if(*text == '\\' && text[1] != '\0')
+        {
+            text++;
+        }
+        if(value != NULL && length + 1 < valueSize)
+        {
+            value[length++] = *text;
+        }
+        text++;
+    }
+
+    if(value != NULL && valueSize > 0)
+    {
+        value[length] = '\0';
+    }
+
+    return text + 1;
+}
+
+static const char *skipValue(const char *text)
+{
+    if(*text == '"')
+    {
+        return parseString(text, NULL, 0);
+    }
+
+    if(*text == '[')
+    {
+        text++;
+        while(*text != ']')
+        {
+            if(*text == '\0')
+            {
+                return NULL;
+            }
+            text = (*text == '"') ? parseString(text, NULL, 0) : text + 1;
+            if(text == NULL)
+            {
+                return NULL;
+            }
+        }
+        return text + 1;
+    }
+
+    while(*text != '\0' && *text != ',' && *text != '}' && *text != ']')
+    {
+        text++;
+    }
+
+    return text;
+}
+
+static const char *parseWorkload(const char *text, BenchmarkResult_t *result)
+{
+    char key[32];
+
+    memset(result, 0x00, sizeof(BenchmarkResult_t));
+    text++;
+
+    while(text != NULL)
+    {
+        text = skipSpace(text);
+
+        if(*text == '}')
+        {
+            result->isRun = (result->runCount > 0);
+            return text + 1;
+        }
+        if(*text == ',')
+        {
+            text++;
+            continue;
+        }
+
+        text = parseString(text, key, sizeof(key));
+        if(text == NULL)
+        {
+            return NULL;
+        }
+        text = skipSpace(text);
+        if(*text != ':')
+        {
+            return NULL;
+        }
+        text = skipSpace(text + 1);
+
+        if(strcmp(key, "name") == 0)
+        {
+            text = parseString(text, result->name, sizeof(result->name));
+        }
+        else if(strcmp(key, "cycles") == 0)
+        {
+            result->cycles = strtoull(text, NULL, 10);
+            text = skipValue(text);
+        }
+        else if(strcmp(key, "instructions") == 0)
+        {
+            result->instructions = strtoull(text, NULL, 10);
+            text = skipValue(text);
+        }
+        else if(strcmp(key, "ns") == 0 && *text == '[')
+        {
+            text++;
+            while(text != NULL && *(text = skipSpace(text)) != ']')
+            {
+                char *end = NULL;
+
+                if(*text == ',')
+                {
+                    text++;
+                    continue;
+                }
+
+                qword_t nanoseconds = strtoull(text, &end, 10);
+                if(end == text)
+                {
+                    return NULL;
+                }
+                if(result->runCount < BENCHMARK_MAX_REPEATS)
+                {
+                    result->nanoseconds[result->runCount++] = nanoseconds;
+                }
+                text = end;
+            }
+            text = (text != NULL) ? text + 1 : NULL;
+        }
+        else
+        {
+            text = skipValue(text);
+        }
+    }
+
+    return NULL;
+}
+
+static void runSpeeds(const BenchmarkResult_t *result, double *mhz)
+{
+    for(int run = 0; run < result->runCount; run++)
+    {
+        mhz[run] = (result->nanoseconds[run] > 0)
+            ? (double)result->cycles / (double)result->nanoseconds[run] * 1e3
+            : 0.0;
+    }
+}
+
+static double median(double *values, int count)
+{
+    qsort(values, (size_t)count, sizeof(double), compareDoubles);
+
+    return (count % 2 == 1) ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2.0;
+}
+
+static double resampledMedian(const double *values, int count, unsigned int *randomState)
+{
+    double sample[BENCHMARK_MAX_REPEATS];
+
+    for(int idx = 0; idx < count; idx++)
+    {
+        *randomState ^= *randomState << 13;
+        *randomState ^= *randomState >> 17;
+        *randomState ^= *randomState << 5;
+
+        sample[idx] = values[*randomState % (unsigned int)count];
+    }
+
+    return median(sample, count);
+}
+
+static int compareDoubles(const void *first, const void *second)
+{
+    double a = *(const double *)first;
+    double b = *(const double *)second;
+
+    return (a > b) - (a < b);
+}
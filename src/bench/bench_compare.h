@@ -0,0 +1,108 @@
+#ifndef CILOGC80_BENCH_COMPARE_H
+#define CILOGC80_BENCH_COMPARE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "bench/benchmark.h"
+
+/** @brief Default slowdown of the median that counts as a regression (5 %) */
+#define BENCH_COMPARE_DEFAULT_THRESHOLD 0.05
+/** @brief Resampling rounds of the bootstrap confidence interval */
+#define BENCH_COMPARE_BOOTSTRAP_ROUNDS 2000
+/** @brief Two sided confidence level of the interval */
+#define BENCH_COMPARE_CONFIDENCE 0.95
+
+/**
+ * @brief Workloads of a JSON file written by @ref benchmarkWriteJson
+ */
+typedef struct BenchBaseline_t
+{
+    BenchmarkResult_t *results;
+    size_t count;
+} BenchBaseline_t;
+
+/**
+ * @brief Enum struct for defining the outcome of a comparison
+ */
+typedef enum BenchVerdict
+{
+    /** @brief No significant change, or one below the threshold */
+    BENCH_VERDICT_UNCHANGED = 0,
+    /** @brief Significantly faster by more than the threshold */
+    BENCH_VERDICT_FASTER,
+    /** @brief Significantly slower by more than the threshold */
+    BENCH_VERDICT_REGRESSION,
+    /** @brief Not in the baseline */
+    BENCH_VERDICT_NEW,
+    /** @brief Failed in the current or the baseline run */
+    BENCH_VERDICT_FAILED
+} BenchVerdict;
+
+/**
+ * @brief Comparison of one workload
+ */
+typedef struct BenchComparison_t
+{
+    BenchVerdict verdict;
+    double baselineMHz;
+    double currentMHz;
+    /** @brief Current median MHz / baseline median MHz, below 1 is slower */
+    double ratio;
+    /** @brief Bootstrap confidence interval of the ratio */
+    double ratioLow;
+    double ratioHigh;
+} BenchComparison_t;
+
+/**
+ * @brief Reads a JSON file written by @ref benchmarkWriteJson. The raw run times are read
+ * back and the statistics recomputed
+ *
+ * @param filename
+ * @param baseline
+ * @return bool False if the file can not be read or has another format version
+ */
+bool benchBaselineLoad(const char *filename, BenchBaseline_t *baseline);
+
+/**
+ * @brief Frees a loaded baseline
+ *
+ * @param baseline
+ */
+void benchBaselineDestroy(BenchBaseline_t *baseline);
+
+/**
+ * @brief Looks up a workload by name
+ *
+ * @param baseline
+ * @param name
+ * @return const BenchmarkResult_t* NULL if the baseline does not have it
+ */
+const BenchmarkResult_t *benchBaselineFind(const BenchBaseline_t *baseline, const char *name);
+
+/**
+ * @brief Compares the runs of a workload with its baseline runs. The ratio of the median
+ * speeds gets a bootstrap confidence interval; a change only counts if the interval
+ * excludes 1 and the ratio is off by more than the threshold
+ *
+ * @param baseline NULL if the workload is new
+ * @param current
+ * @param threshold Relative change, e.g. 0.05
+ * @return BenchComparison_t
+ */
+BenchComparison_t benchCompare(const BenchmarkResult_t *baseline, const BenchmarkResult_t *current, double threshold);
+
+/**
+ * @brief Compares every result with the baseline and prints a table
+ *
+ * @param stream
+ * @param baseline
+ * @param results
+ * @param count
+ * @param threshold
+ * @return size_t Number of regressions
+ */
+size_t benchCompareAll(FILE *stream, const BenchBaseline_t *baseline, const BenchmarkResult_t *results, size_t count,
+                       double threshold);
+
+#endif // CILOGC80_BENCH_COMPARE_H
@@ -0,0 +1,584 @@
+#include "bench/bench_workloads.h"
+
+#include <string.h>
+
+// Hand assembled kernels. They only use instructions the core executes correctly today (no
+// ADD HL,rr, CB shifts, ADC A,r or CP r) and store their result in RAM, so a kernel can be
+// checked against the value in its description after changes to the core
+
+/** @brief Sieve of Eratosthenes over 2048 flags, prime count at 0x9000 */
+static const byte_t sieveKernel[] =
+{
+    0x31, 0x00, 0xF0,         // LD SP,0xF000
+    // outer:
+    0x21, 0x00, 0x80,         // LD HL,0x8000
+    0x01, 0x00, 0x08,         // LD BC,2048
+    // fill:
+    0x36, 0x01,               // LD (HL),1
+    0x23,                     // INC HL
+    0x0B,                     // DEC BC
+    0x79,                     // LD A,C
+    0xB0,                     // OR B
+    0x20, 0xF8,               // JR NZ,fill
+    0x21, 0x00, 0x00,         // LD HL,0
+    0x22, 0x00, 0x90,         // LD (0x9000),HL
+    0x21, 0x02, 0x80,         // LD HL,0x8002
+    0x01, 0x02, 0x00,         // LD BC,2
+    // scan:
+    0x7E,                     // LD A,(HL)
+    0xB7,                     // OR A
+    0x28, 0x1C,               // JR Z,next
+    0xE5,                     // PUSH HL
+    0x2A, 0x00, 0x90,         // LD HL,(0x9000)
+    0x23,                     // INC HL
+    0x22, 0x00, 0x90,         // LD (0x9000),HL
+    0xE1,                     // POP HL
+    0xE5,                     // PUSH HL
+    // mark:
+    0x7D,                     // LD A,L
+    0x81,                     // ADD A,C
+    0x6F,                     // LD L,A
+    0x7C,                     // LD A,H
+    0x30, 0x01,               // JR NC,nocarry
+    0x3C,                     // INC A
+    // nocarry:
+    0x80,                     // ADD A,B
+    0x67,                     // LD H,A
+    0xFE, 0x88,               // CP 0x88
+    0x30, 0x04,               // JR NC,marked
+    0x36, 0x00,               // LD (HL),0
+    0x18, 0xEF,               // JR mark
+    // marked:
+    0xE1,                     // POP HL
+    // next:
+    0x23,                     // INC HL
+    0x03,                     // INC BC
+    0x7C,                     // LD A,H
+    0xFE, 0x88,               // CP 0x88
+    0x20, 0xD9,               // JR NZ,scan
+    0xC3, 0x03, 0x00,         // JP outer
+};
+
+/** @brief Table driven CRC-16/CCITT of 0x0000-0x00FF, result at 0x9000 */
+static const byte_t crc16Kernel[] =
+{
+    0x31, 0x00, 0xF0,         // LD SP,0xF000
+    // outer:
+    0x21, 0x00, 0x00,         // LD HL,0x0000
+    0x01, 0xFF, 0xFF,         // LD BC,0xFFFF
+    // byte:
+    0x7E,                     // LD A,(HL)
+    0xA8,                     // XOR B
+    0xEB,                     // EX DE,HL
+    0x6F,                     // LD L,A
+    0x26, 0x02,               // LD H,0x02
+    0x7E,                     // LD A,(HL)
+    0xA9,                     // XOR C
+    0x47,                     // LD B,A
+    0x24,                     // INC H
+    0x7E,                     // LD A,(HL)
+    0x4F,                     // LD C,A
+    0xEB,                     // EX DE,HL
+    0x23,                     // INC HL
+    0x7D,                     // LD A,L
+    0xB7,                     // OR A
+    0x20, 0xEE,               // JR NZ,byte
+    0x60,                     // LD H,B
+    0x69,                     // LD L,C
+    0x22, 0x00, 0x90,         // LD (0x9000),HL
+    0xC3, 0x03, 0x00,         // JP outer
+};
+
+/** @brief Table driven CRC-32 of 0x0000-0x00FF, result at 0x9000 */
+static const byte_t crc32Kernel[] =
+{
+    0x31, 0x00, 0xF0,         // LD SP,0xF000
+    // outer:
+    0x21, 0x00, 0x00,         // LD HL,0x0000
+    0x01, 0xFF, 0xFF,         // LD BC,0xFFFF
+    0x16, 0xFF,               // LD D,0xFF
+    0x1E, 0xFF,               // LD E,0xFF
+    // byte:
+    0x7E,                     // LD A,(HL)
+    0xAB,                     // XOR E
+    0xE5,                     // PUSH HL
+    0x6F,                     // LD L,A
+    0x26, 0x04,               // LD H,0x04
+    0x7E,                     // LD A,(HL)
+    0xAA,                     // XOR D
+    0x5F,                     // LD E,A
+    0x24,                     // INC H
+    0x7E,                     // LD A,(HL)
+    0xA9,                     // XOR C
+    0x57,                     // LD D,A
+    0x24,                     // INC H
+    0x7E,                     // LD A,(HL)
+    0xA8,                     // XOR B
+    0x4F,                     // LD C,A
+    0x24,                     // INC H
+    0x7E,                     // LD A,(HL)
+    0x47,                     // LD B,A
+    0xE1,                     // POP HL
+    0x23,                     // INC HL
+    0x7D,                     // LD A,L
+    0xB7,                     // OR A
+    0x20, 0xE6,               // JR NZ,byte
+    0x7B,                     // LD A,E
+    0xEE, 0xFF,               // XOR 0xFF
+    0x32, 0x00, 0x90,         // LD (0x9000),A
+    0x7A,                     // LD A,D
+    0xEE, 0xFF,               // XOR 0xFF
+    0x32, 0x01, 0x90,         // LD (0x9001),A
+    0x79,                     // LD A,C
+    0xEE, 0xFF,               // XOR 0xFF
+    0x32, 0x02, 0x90,         // LD (0x9002),A
+    0xAF,                     // XOR A
+    0xB0,                     // OR B
+    0xEE, 0xFF,               // XOR 0xFF
+    0x32, 0x03, 0x90,         // LD (0x9003),A
+    0xC3, 0x03, 0x00,         // JP outer
+};
+
+/** @brief Fills 4K of RAM byte by byte */
+static const byte_t memsetKernel[] =
+{
+    0x31, 0x00, 0xF0,         // LD SP,0xF000
+    0x1E, 0x00,               // LD E,0
+    // outer:
+    0x1C,                     // INC E
+    0x21, 0x00, 0x80,         // LD HL,0x8000
+    0x01, 0x00, 0x10,         // LD BC,0x1000
+    // fill:
+    0x73,                     // LD (HL),E
+    0x23,                     // INC HL
+    0x0B,                     // DEC BC
+    0x79,                     // LD A,C
+    0xB0,                     // OR B
+    0x20, 0xF9,               // JR NZ,fill
+    0xC3, 0x05, 0x00,         // JP outer
+};
+
+/** @brief Copies 4K of ROM to RAM byte by byte */
+static const byte_t memcpyKernel[] =
+{
+    0x31, 0x00, 0xF0,         // LD SP,0xF000
+    // outer:
+    0x21, 0x00, 0x00,         // LD HL,0x0000
+    0x16, 0x80,               // LD D,0x80
+    0x1E, 0x00,               // LD E,0x00
+    0x01, 0x00, 0x10,         // LD BC,0x1000
+    // copy:
+    0x7E,                     // LD A,(HL)
+    0x12,                     // LD (DE),A
+    0x23,                     // INC HL
+    0x13,                     // INC DE
+    0x0B,                     // DEC BC
+    0x79,                     // LD A,C
+    0xB0,                     // OR B
+    0x20, 0xF7,               // JR NZ,copy
+    0xC3, 0x03, 0x00,         // JP outer
+};
+
+/** @brief Adds a 32 digit BCD constant to a BCD accumulator at 0x8000 (ADD / DAA) */
+static const byte_t bcdKernel[] =
+{
+    0x31, 0x00, 0xF0,         // LD SP,0xF000
+    0x21, 0x00, 0x80,         // LD HL,0x8000
+    0x06, 0x10,               // LD B,16
+    // clear:
+    0x36, 0x00,               // LD (HL),0
+    0x23,                     // INC HL
+    0x10, 0xFB,               // DJNZ clear
+    // outer:
+    0x21, 0x0F, 0x80,         // LD HL,0x800F
+    0x1E, 0x00,               // LD E,0
+    0x7E,                     // LD A,(HL)
+    0x83,                     // ADD A,E
+    0x27,                     // DAA
+    0x1E, 0x00,               // LD E,0
+    0x30, 0x01,               // JR NC,carry0
+    0x1C,                     // INC E
+    // carry0:
+    0xC6, 0x37,               // ADD A,0x37
+    0x27,                     // DAA
+    0x30, 0x02,               // JR NC,stored0
+    0x1E, 0x01,               // LD E,1
+    // stored0:
+    0x77,                     // LD (HL),A
+    0x2B,                     // DEC HL
+    0x7E,                     // LD A,(HL)
+    0x83,                     // ADD A,E
+    0x27,                     // DAA
+    0x1E, 0x00,               // LD E,0
+    0x30, 0x01,               // JR NC,carry1
+    0x1C,                     // INC E
+    // carry1:
+    0xC6, 0x91,               // ADD A,0x91
+    0x27,                     // DAA
+    0x30, 0x02,               // JR NC,stored1
+    0x1E, 0x01,               // LD E,1
+    // stored1:
+    0x77,                     // LD (HL),A
+    0x2B,                     // DEC HL
+    0x7E,                     // LD A,(HL)
+    0x83,                     // ADD A,E
+    0x27,                     // DAA
+    0x1E, 0x00,               // LD E,0
+    0x30, 0x01,               // JR NC,carry2
+    0x1C,                     // INC E
+    // carry2:
+    0xC6, 0x05,               // ADD A,0x05
+    0x27,                     // DAA
+    0x30, 0x02,               // JR NC,stored2
+    0x1E, 0x01,               // LD E,1
+    // stored2:
+    0x77,                     // LD (HL),A
+    0x2B,                     // DEC HL
+    0x7E,                     // LD A,(HL)
+    0x83,                     // ADD A,E
+    0x27,                     // DAA
+    0x1E, 0x00,               // LD E,0
+    0x30, 0x01,               // JR NC,carry3
+    0x1C,                     // INC E
+    // carry3:
+    0xC6, 0x68,               // ADD A,0x68
+    0x27,                     // DAA
+    0x30, 0x02,               // JR NC,stored3
+    0x1E, 0x01,               // LD E,1
+    // stored3:
+    0x77,                     // LD (HL),A
+    0x2B,                     // DEC HL
+    0x7E,                     // LD A,(HL)
+    0x83,                     // ADD A,E
+    0x27,                     // DAA
+    0x1E, 0x00,               // LD E,0
+    0x30, 0x01,               // JR NC,carry4
+    0x1C,                     // INC E
+    // carry4:
+    0xC6, 0x42,               // ADD A,0x42
+    0x27,                     // DAA
+    0x30, 0x02,               // JR NC,stored4
+    0x1E, 0x01,               // LD E,1
+    // stored4:
+    0x77,                     // LD (HL),A
+    0x2B,                     // DEC HL
+    0x7E,                     // LD A,(HL)
+    0x83,                     // ADD A,E
+    0x27,                     // DAA
+    0x1E, 0x00,               // LD E,0
+    0x30, 0x01,               // JR NC,carry5
+    0x1C,                     // INC E
+    // carry5:
+    0xC6, 0x13,               // ADD A,0x13
+    0x27,                     // DAA
+    0x30, 0x02,               // JR NC,stored5
+    0x1E, 0x01,               // LD E,1
+    // stored5:
+    0x77,                     // LD (HL),A
+    0x2B,                     // DEC HL
+    0x7E,                     // LD A,(HL)
+    0x83,                     // ADD A,E
+    0x27,                     // DAA
+    0x1E, 0x00,               // LD E,0
+    0x30, 0x01,               // JR NC,carry6
+    0x1C,                     // INC E
+    // carry6:
+    0xC6, 0x99,               // ADD A,0x99
+    0x27,                     // DAA
+    0x30, 0x02,               // JR NC,stored6
+    0x1E, 0x01,               // LD E,1
+    // stored6:
+    0x77,                     // LD (HL),A
+    0x2B,                     // DEC HL
+    0x7E,                     // LD A,(HL)
+    0x83,                     // ADD A,E
+    0x27,                     // DAA
+    0x1E, 0x00,               // LD E,0
+    0x30, 0x01,               // JR NC,carry7
+    0x1C,                     // INC E
+    // carry7:
+    0xC6, 0x27,               // ADD A,0x27
+    0x27,                     // DAA
+    0x30, 0x02,               // JR NC,stored7
+    0x1E, 0x01,               // LD E,1
+    // stored7:
+    0x77,                     // LD (HL),A
+    0x2B,                     // DEC HL
+    0x7E,                     // LD A,(HL)
+    0x83,                     // ADD A,E
+    0x27,                     // DAA
+    0x1E, 0x00,               // LD E,0
+    0x30, 0x01,               // JR NC,carry8
+    0x1C,                     // INC E
+    // carry8:
+    0xC6, 0x80,               // ADD A,0x80
+    0x27,                     // DAA
+    0x30, 0x02,               // JR NC,stored8
+    0x1E, 0x01,               // LD E,1
+    // stored8:
+    0x77,                     // LD (HL),A
+    0x2B,                     // DEC HL
+    0x7E,                     // LD A,(HL)
+    0x83,                     // ADD A,E
+    0x27,                     // DAA
+    0x1E, 0x00,               // LD E,0
+    0x30, 0x01,               // JR NC,carry9
+    0x1C,                     // INC E
+    // carry9:
+    0xC6, 0x56,               // ADD A,0x56
+    0x27,                     // DAA
+    0x30, 0x02,               // JR NC,stored9
+    0x1E, 0x01,               // LD E,1
+    // stored9:
+    0x77,                     // LD (HL),A
+    0x2B,                     // DEC HL
+    0x7E,                     // LD A,(HL)
+    0x83,                     // ADD A,E
+    0x27,                     // DAA
+    0x1E, 0x00,               // LD E,0
+    0x30, 0x01,               // JR NC,carry10
+    0x1C,                     // INC E
+    // carry10:
+    0xC6, 0x34,               // ADD A,0x34
+    0x27,                     // DAA
+    0x30, 0x02,               // JR NC,stored10
+    0x1E, 0x01,               // LD E,1
+    // stored10:
+    0x77,                     // LD (HL),A
+    0x2B,                     // DEC HL
+    0x7E,                     // LD A,(HL)
+    0x83,                     // ADD A,E
+    0x27,                     // DAA
+    0x1E, 0x00,               // LD E,0
+    0x30, 0x01,               // JR NC,carry11
+    0x1C,                     // INC E
+    // carry11:
+    0xC6, 0x71,               // ADD A,0x71
+    0x27,                     // DAA
+    0x30, 0x02,               // JR NC,stored11
+    0x1E, 0x01,               // LD E,1
+    // stored11:
+    0x77,                     // LD (HL),A
+    0x2B,                     // DEC HL
+    0x7E,                     // LD A,(HL)
+    0x83,                     // ADD A,E
+    0x27,                     // DAA
+    0x1E, 0x00,               // LD E,0
+    0x30, 0x01,               // JR NC,carry12
+    0x1C,                     // INC E
+    // carry12:
+    0xC6, 0x09,               // ADD A,0x09
+    0x27,                     // DAA
+    0x30, 0x02,               // JR NC,stored12
+    0x1E, 0x01,               // LD E,1
+    // stored12:
+    0x77,                     // LD (HL),A
+    0x2B,                     // DEC HL
+    0x7E,                     // LD A,(HL)
+    0x83,                     // ADD A,E
+    0x27,                     // DAA
+    0x1E, 0x00,               // LD E,0
+    0x30, 0x01,               // JR NC,carry13
+    0x1C,                     // INC E
+    // carry13:
+    0xC6, 0x88,               // ADD A,0x88
+    0x27,                     // DAA
+    0x30, 0x02,               // JR NC,stored13
+    0x1E, 0x01,               // LD E,1
+    // stored13:
+    0x77,                     // LD (HL),A
+    0x2B,                     // DEC HL
+    0x7E,                     // LD A,(HL)
+    0x83,                     // ADD A,E
+    0x27,                     // DAA
+    0x1E, 0x00,               // LD E,0
+    0x30, 0x01,               // JR NC,carry14
+    0x1C,                     // INC E
+    // carry14:
+    0xC6, 0x23,               // ADD A,0x23
+    0x27,                     // DAA
+    0x30, 0x02,               // JR NC,stored14
+    0x1E, 0x01,               // LD E,1
+    // stored14:
+    0x77,                     // LD (HL),A
+    0x2B,                     // DEC HL
+    0x7E,                     // LD A,(HL)
+    0x83,                     // ADD A,E
+    0x27,                     // DAA
+    0x1E, 0x00,               // LD E,0
+    0x30, 0x01,               // JR NC,carry15
+    0x1C,                     // INC E
+    // carry15:
+    0xC6, 0x64,               // ADD A,0x64
+    0x27,                     // DAA
+    0x30, 0x02,               // JR NC,stored15
+    0x1E, 0x01,               // LD E,1
+    // stored15:
+    0x77,                     // LD (HL),A
+    0x2B,                     // DEC HL
+    0xC3, 0x0D, 0x00,         // JP outer
+};
+
+/** @brief Naive search of a 4 byte needle in a 1K haystack, match count at 0x9000 */
+static const byte_t searchKernel[] =
+{
+    0x31, 0x00, 0xF0,         // LD SP,0xF000
+    0x21, 0x00, 0x04,         // LD HL,0x0400
+    0x16, 0x80,               // LD D,0x80
+    0x1E, 0x00,               // LD E,0x00
+    // gen:
+    0x7E,                     // LD A,(HL)
+    0xE6, 0x03,               // AND 3
+    0xC6, 0x61,               // ADD A,0x61
+    0x12,                     // LD (DE),A
+    0x23,                     // INC HL
+    0x13,                     // INC DE
+    0x7C,                     // LD A,H
+    0xFE, 0x08,               // CP 0x08
+    0x20, 0xF3,               // JR NZ,gen
+    // outer:
+    0x21, 0x00, 0x80,         // LD HL,0x8000
+    0x01, 0xFD, 0x03,         // LD BC,0x03FD
+    0x16, 0x00,               // LD D,0
+    0x1E, 0x00,               // LD E,0
+    // pos:
+    0xE5,                     // PUSH HL
+    0x7E,                     // LD A,(HL)
+    0xFE, 0x61,               // CP 0x61
+    0x20, 0x13,               // JR NZ,miss
+    0x23,                     // INC HL
+    0x7E,                     // LD A,(HL)
+    0xFE, 0x62,               // CP 0x62
+    0x20, 0x0D,               // JR NZ,miss
+    0x23,                     // INC HL
+    0x7E,                     // LD A,(HL)
+    0xFE, 0x63,               // CP 0x63
+    0x20, 0x07,               // JR NZ,miss
+    0x23,                     // INC HL
+    0x7E,                     // LD A,(HL)
+    0xFE, 0x61,               // CP 0x61
+    0x20, 0x01,               // JR NZ,miss
+    0x13,                     // INC DE
+    // miss:
+    0xE1,                     // POP HL
+    0x23,                     // INC HL
+    0x0B,                     // DEC BC
+    0x79,                     // LD A,C
+    0xB0,                     // OR B
+    0x20, 0xE0,               // JR NZ,pos
+    0xEB,                     // EX DE,HL
+    0x22, 0x00, 0x90,         // LD (0x9000),HL
+    0xC3, 0x17, 0x00,         // JP outer
+};
+
+/** @brief Dhrystone style mix: calls, stack, 16 bit counters, array updates, string copy */
+static const byte_t mixKernel[] =
+{
+    0x31, 0x00, 0xF0,         // LD SP,0xF000
+    0x21, 0x00, 0x00,         // LD HL,0
+    0x22, 0x00, 0x81,         // LD (0x8100),HL
+    // outer:
+    0x06, 0x00,               // LD B,0
+    // loop:
+    0xC5,                     // PUSH BC
+    0xCD, 0x18, 0x00,         // CALL proc1
+    0xCD, 0x34, 0x00,         // CALL proc2
+    0xC1,                     // POP BC
+    0x10, 0xF6,               // DJNZ loop
+    0xC3, 0x09, 0x00,         // JP outer
+    // proc1:
+    0x3A, 0x00, 0x81,         // LD A,(0x8100)
+    0xC6, 0x07,               // ADD A,7
+    0x32, 0x00, 0x81,         // LD (0x8100),A
+    0x3A, 0x01, 0x81,         // LD A,(0x8101)
+    0xCE, 0x00,               // ADC A,0
+    0x32, 0x01, 0x81,         // LD (0x8101),A
+    0x3A, 0x00, 0x81,         // LD A,(0x8100)
+    0xE6, 0x0F,               // AND 0x0F
+    0x6F,                     // LD L,A
+    0x26, 0x82,               // LD H,0x82
+    0x7E,                     // LD A,(HL)
+    0x3C,                     // INC A
+    0x77,                     // LD (HL),A
+    0xC9,                     // RET
+    // proc2:
+    0x21, 0x50, 0x00,         // LD HL,text
+    0x16, 0x83,               // LD D,0x83
+    0x1E, 0x10,               // LD E,0x10
+    0x0E, 0x08,               // LD C,8
+    // copy:
+    0x7E,                     // LD A,(HL)
+    0x12,                     // LD (DE),A
+    0x23,                     // INC HL
+    0x13,                     // INC DE
+    0x0D,                     // DEC C
+    0x20, 0xF9,               // JR NZ,copy
+    0x3A, 0x00, 0x82,         // LD A,(0x8200)
+    0xFE, 0x80,               // CP 0x80
+    0x38, 0x04,               // JR C,low
+    0xAF,                     // XOR A
+    0x32, 0x00, 0x82,         // LD (0x8200),A
+    // low:
+    0xC9,                     // RET
+    // text:
+    0x44, 0x48, 0x52, 0x59, 0x53, 0x54, 0x4F, 0x4E, // DB 0x44, 0x48, 0x52, 0x59, 0x53, 0x54, 0x4F, 0x4E
+};
+
+static const BenchWorkload_t workloads[] =
+{
+    { "sieve", "Sieve of Eratosthenes, 2048 entries", sieveKernel, sizeof(sieveKernel) },
+    { "crc16", "Table driven CRC-16/CCITT", crc16Kernel, sizeof(crc16Kernel) },
+    { "crc32", "Table driven CRC-32", crc32Kernel, sizeof(crc32Kernel) },
+    { "memset", "4K byte fill loop", memsetKernel, sizeof(memsetKernel) },
+    { "memcpy", "4K byte copy loop", memcpyKernel, sizeof(memcpyKernel) },
+    { "bcd", "32 digit BCD addition (DAA)", bcdKernel, sizeof(bcdKernel) },
+    { "strsearch", "Naive substring search", searchKernel, sizeof(searchKernel) },
+    { "mix", "Dhrystone style instruction mix", mixKernel, sizeof(mixKernel) }
+};
+
+/**
+ * @brief Writes the CRC lookup tables into a ROM
+ *
+ * @param rom
+ */
+static void buildCrcTables(byte_t *rom);
+
+size_t benchWorkloadCount()
+{
+    return sizeof(workloads) / sizeof(workloads[0]);
+}
+
+const BenchWorkload_t *benchWorkloadGet(size_t index)
+{
+    return (index < benchWorkloadCount()) ? &workloads[index] : NULL;
+}
+
+void benchWorkloadBuildRom(const BenchWorkload_t *workload, byte_t *rom)
+{
+    memset(rom, 0x00, BENCH_ROM_SIZE);
+    memcpy(rom, workload->code, workload->codeSize);
+    buildCrcTables(rom);
+}
+
+static void buildCrcTables(byte_t *rom)
+{
+    for(int index = 0; index < 0x100; index++)
+    {
+        word_t crc16 = (word_t)(index << 8);
+        dword_t crc32 = (dword_t)index;
+
+        for(int bit = 0; bit < 8; bit++)
+        {
+            crc16 = (crc16 & 0x8000) ? (word_t)((crc16 << 1) ^ 0x1021) : (word_t)(crc16 << 1);
+            crc32 = (crc32 & 0x01) ? (crc32 >> 1) ^ 0xEDB88320UL : (crc32 >> 1);
+        }
+
+        rom[BENCH_CRC16_TABLE_ADDRESS + index] = UPPER_BYTE(crc16);
+        rom[BENCH_CRC16_TABLE_ADDRESS + 0x100 + index] = LOWER_BYTE(crc16);
+
+        for(int part = 0; part < 4; part++)
+        {
+            rom[BENCH_CRC32_TABLE_ADDRESS + part * 0x100 + index] = (byte_t)(crc32 >> (8 * part));
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef CILOGC80_BENCH_WORKLOADS_H
+#define CILOGC80_BENCH_WORKLOADS_H
+
+#include <stdlib.h>
+
+#include "utils/utils.h"
+#include "cpu/cpu.h"
+
+/** @brief Size of a built-in workload ROM (the whole ROM window) */
+#define BENCH_ROM_SIZE CPU_ROM_SIZE
+
+/* ------------------------------ Lookup tables ----------------------------- */
+// Page aligned, so the kernels index them with LD H,page / LD L,index
+/** @brief CRC-16/CCITT table, high bytes at 0x0200, low bytes at 0x0300 */
+#define BENCH_CRC16_TABLE_ADDRESS 0x0200
+/** @brief CRC-32 table, byte n of each entry at 0x0400 + n * 0x100 */
+#define BENCH_CRC32_TABLE_ADDRESS 0x0400
+/** @brief Kernels have to end before the tables */
+#define BENCH_MAX_KERNEL_SIZE BENCH_CRC16_TABLE_ADDRESS
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Built-in guest workload. Every kernel loops forever, the benchmark decides how
+ * long it runs
+ */
+typedef struct BenchWorkload_t
+{
+    const char *name;
+    const char *description;
+    const byte_t *code;
+    size_t codeSize;
+} BenchWorkload_t;
+
+/**
+ * @brief Returns the number of built-in workloads
+ * 
+ * @return size_t 
+ */
+size_t benchWorkloadCount();
+
+/**
+ * @brief Returns a built-in workload
+ * 
+ * @param index 
+ * @return const BenchWorkload_t* NULL if the index is out of range
+ */
+const BenchWorkload_t *benchWorkloadGet(size_t index);
+
+/**
+ * @brief Builds the ROM of a workload: the kernel at 0x0000 followed by the lookup tables
+ * 
+ * @param workload 
+ * @param rom BENCH_ROM_SIZE bytes
+ */
+void benchWorkloadBuildRom(const BenchWorkload_t *workload, byte_t *rom);
+
+#endif // CILOGC80_BENCH_WORKLOADS_H
@@ -0,0 +1,294 @@
+#include "bench/benchmark.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "machine/machine.h"
+#include "utils/clock.h"
+
+/**
+ * @brief Measures a machine that has its ROM loaded
+ *
+ * @param machine
+ * @param config
+ * @param result
+ */
+static void measureMachine(Machine_t *machine, const BenchmarkConfig_t *config, BenchmarkResult_t *result);
+
+/**
+ * @brief Runs the machine for a number of cycles, restarting it whenever it halts
+ *
+ * @param machine
+ * @param cycles
+ * @param executedInstructions
+ * @return qword_t Cycles executed
+ */
+static qword_t runCycles(Machine_t *machine, long cycles, qword_t *executedInstructions);
+
+/**
+ * @brief Prepares a result for a new measurement
+ *
+ * @param name
+ * @param result
+ */
+static void resetResult(const char *name, BenchmarkResult_t *result);
+
+/**
+ * @brief Emulated MHz of one run
+ *
+ * @param result
+ * @param run
+ * @return double
+ */
+static double runMHz(const BenchmarkResult_t *result, int run);
+
+/**
+ * @brief qsort comparator for doubles
+ */
+static int compareDoubles(const void *first, const void *second);
+
+BenchmarkConfig_t benchmarkDefaultConfig()
+{
+    BenchmarkConfig_t config;
+
+    config.cycles = BENCHMARK_DEFAULT_CYCLES;
+    config.repeats = BENCHMARK_DEFAULT_REPEATS;
+    config.isWarmup = true;
+    config.backend = NULL;
+
+    return config;
+}
+
+bool benchmarkRunRom(const char *name, const byte_t *rom, size_t romSize, const BenchmarkConfig_t *config,
+                     BenchmarkResult_t *result)
+{
+    resetResult(name, result);
+
+    Machine_t *machine = (Machine_t *)malloc(sizeof(Machine_t));
+    if(machine == NULL)
+    {
+        return false;
+    }
+
+    MachineConfig_t machineConfig = machineDefaultConfig();
+    machineConfig.backend = config->backend;
+
+    bool isLoaded = machineInit(machine, &machineConfig) && machineLoadRomData(machine, rom, romSize);
+    if(isLoaded == true)
+    {
+        measureMachine(machine, config, result);
+    }
+
+    machineDestroy(machine);
+    free(machine);
+
+    return isLoaded;
+}
+
+bool benchmarkRunFile(const char *name, const char *filename, const BenchmarkConfig_t *config,
+                      BenchmarkResult_t *result)
+{
+    resetResult(name, result);
+
+    Machine_t *machine = (Machine_t *)malloc(sizeof(Machine_t));
+    if(machine == NULL)
+    {
+        return false;
+    }
+
+    MachineConfig_t machineConfig = machineDefaultConfig();
+    machineConfig.backend = config->backend;
+
+    bool isLoaded = machineInit(machine, &machineConfig) && machineLoadRom(machine, filename, ROM_FORMAT_AUTO);
+    if(isLoaded == true)
+    {
+        measureMachine(machine, config, result);
+    }
+
+    machineDestroy(machine);
+    free(machine);
+
+    return isLoaded;
+}
+
+void benchmarkSummarize(BenchmarkResult_t *result)
+{
+    double mhz[BENCHMARK_MAX_REPEATS];
+    double sum = 0.0;
+
+    if(result->runCount == 0)
+    {
+        return;
+    }
+
+    for(int run = 0; run < result->runCount; run++)
+    {
+        mhz[run] = runMHz(result, run);
+        sum += mhz[run];
+    }
+    result->meanMHz = sum / result->runCount;
+
+    double squares = 0.0;
+    for(int run = 0; run < result->runCount; run++)
+    {
+        squares += (mhz[run] - result->meanMHz) * (mhz[run] - result->meanMHz);
+    }
+    result->stddevMHz = (result->runCount > 1) ? sqrt(squares / (result->runCount - 1)) : 0.0;
+
+    qsort(mhz, (size_t)result->runCount, sizeof(double), compareDoubles);
+    int middle = result->runCount / 2;
+    result->medianMHz = (result->runCount % 2 == 1) ? mhz[middle] : (mhz[middle - 1] + mhz[middle]) / 2.0;
+    result->minMHz = mhz[0];
+    result->maxMHz = mhz[result->runCount - 1];
+
+    // Time of the median run: cycles are the same for every run
+    double medianNanoseconds = (result->medianMHz > 0.0) ? (double)result->cycles / result->medianMHz * 1e3 : 0.0;
+    result->nsPerInstruction = (result->instructions > 0) ? medianNanoseconds / (double)result->instructions : 0.0;
+}
+
+void benchmarkPrintTable(FILE *stream, const BenchmarkResult_t *results, size_t count)
+{
+    fprintf(stream, "%-20s %10s %8s %10s %10s %10s\n", "workload", "MHz", "cv %", "min", "max", "ns/instr");
+
+    for(size_t idx = 0; idx < count; idx++)
+    {
+        const BenchmarkResult_t *result = &results[idx];
+
+        if(result->isRun == false)
+        {
+            fprintf(stream, "%-20s %10s\n", result->name, "failed");
+            continue;
+        }
+
+        double variation = (result->meanMHz > 0.0) ? result->stddevMHz / result->meanMHz * 100.0 : 0.0;
+        fprintf(stream, "%-20s %10.2f %8.2f %10.2f %10.2f %10.2f\n", result->name, result->medianMHz, variation,
+                result->minMHz, result->maxMHz, result->nsPerInstruction);
+    }
+}
+
+void benchmarkWriteJson(FILE *stream, const BenchmarkConfig_t *config, const BenchmarkResult_t *results, size_t count)
+{
+    const MachineBackend_t *backend = (config->backend != NULL) ? config->backend : machineBackendGet(0);
+
+    fprintf(stream, "{\n  \"format\": %d,\n  \"tool\": \"cilogc80-bench\",\n  \"backend\": \"%s\",\n  \"cycles\": %ld,\n  \"repeats\": %d,\n  \"workloads\": [",
+            BENCHMARK_JSON_FORMAT, backend->name, config->cycles, config->repeats);
+
+    for(size_t idx = 0; idx < count; idx++)
+    {
+        const BenchmarkResult_t *result = &results[idx];
+
+        // Names are ROM file names or built-in names, only quotes and backslashes need escaping
+        fprintf(stream, "%s\n    {\"name\": \"", (idx > 0) ? "," : "");
+        for(const char *character = result->name; *character != '\0'; character++)
+        {
+            if(*character == '"' || *character == '\\')
+            {
+                fputc('\\', stream);
+            }
+            fputc(*character, stream);
+        }
+        fprintf(stream, "\"");
+
+        if(result->isRun == false)
+        {
+            fprintf(stream, ", \"error\": \"could not load\"}");
+            continue;
+        }
+
+        fprintf(stream, ", \"cycles\": %llu, \"instructions\": %llu, \"ns\": [",
+                (unsigned long long)result->cycles, (unsigned long long)result->instructions);
+        for(int run = 0; run < result->runCount; run++)
+        {
+            fprintf(stream, "%s%llu", (run > 0) ? ", " : "", (unsigned long long)result->nanoseconds[run]);
+        }
+        fprintf(stream, "], \"mhz\": [");
+        for(int run = 0; run < result->runCount; run++)
+        {
+            fprintf(stream, "%s%.4f", (run > 0) ? ", " : "", runMHz(result, run));
+        }
+        fprintf(stream, "],\n     \"median_mhz\": %.4f, \"mean_mhz\": %.4f, \"stddev_mhz\": %.4f, "
+                        "\"min_mhz\": %.4f, \"max_mhz\": %.4f, \"ns_per_instruction\": %.4f}",
+                result->medianMHz, result->meanMHz, result->stddevMHz, result->minMHz, result->maxMHz,
+                result->nsPerInstruction);
+    }
+
+    fprintf(stream, "\n  ]\n}\n");
+}
+
+static void measureMachine(Machine_t *machine, const BenchmarkConfig_t *config, BenchmarkResult_t *result)
+{
+    int repeats = (config->repeats < BENCHMARK_MAX_REPEATS) ? config->repeats : BENCHMARK_MAX_REPEATS;
+    qword_t instructions = 0;
+
+    if(config->isWarmup == true)
+    {
+        machineReset(machine);
+        runCycles(machine, config->cycles / 10, &instructions);
+    }
+
+    for(int run = 0; run < repeats; run++)
+    {
+        // Reset outside the measurement, every run starts from the same state
+        machineReset(machine);
+
+        qword_t startTime = clockNowNanoseconds();
+        qword_t cycles = runCycles(machine, config->cycles, &instructions);
+        result->nanoseconds[run] = clockNowNanoseconds() - startTime;
+
+        result->cycles = cycles;
+        result->instructions = instructions;
+        result->runCount++;
+    }
+
+    result->isRun = true;
+    benchmarkSummarize(result);
+}
+
+static qword_t runCycles(Machine_t *machine, long cycles, qword_t *executedInstructions)
+{
+    qword_t executedCycles = 0;
+    *executedInstructions = 0;
+
+    while(executedCycles < (qword_t)cycles)
+    {
+        StopReason stopReason = machineRun(machine, cycles - (long)executedCycles);
+        executedCycles += (qword_t)machine->cpu.runCycles;
+        *executedInstructions += (qword_t)machine->cpu.runInstructions;
+
+        if(stopReason == STOP_REASON_HALT)
+        {
+            // Short programs (asm/) halt after a few instructions, start them again
+            if(machine->cpu.runCycles == 0)
+            {
+                break;
+            }
+            machineReset(machine);
+        }
+        else if(stopReason != STOP_REASON_BUDGET)
+        {
+            break;
+        }
+    }
+
+    return executedCycles;
+}
+
+static void resetResult(const char *name, BenchmarkResult_t *result)
+{
+    memset(result, 0x00, sizeof(BenchmarkResult_t));
+    strncpy(result->name, name, BENCHMARK_MAX_NAME - 1);
+}
+
+static double runMHz(const BenchmarkResult_t *result, int run)
+{
+    // cycles / ns * 1e3 = cycles / us = MHz
+    return (result->nanoseconds[run] > 0) ? (double)result->cycles / (double)result->nanoseconds[run] * 1e3 : 0.0;
+}
+
+static int compareDoubles(const void *first, const void *second)
+{
+    double a = *(const double *)first;
+    double b = *(const double *)second;
+
+    return (a > b) - (a < b);
+}
@@ -0,0 +1,122 @@
+#ifndef CILOGC80_BENCHMARK_H
+#define CILOGC80_BENCHMARK_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "utils/utils.h"
+#include "machine/machine_backend.h"
+
+/** @brief Maximum number of measured runs per workload */
+#define BENCHMARK_MAX_REPEATS 64
+#define BENCHMARK_MAX_NAME 64
+
+#define BENCHMARK_DEFAULT_CYCLES 20000000L
+#define BENCHMARK_DEFAULT_REPEATS 5
+
+/** @brief Version of the JSON output, bumped on incompatible changes */
+#define BENCHMARK_JSON_FORMAT 1
+
+/**
+ * @brief Benchmark parameters, shared by all workloads
+ */
+typedef struct BenchmarkConfig_t
+{
+    /** @brief Emulated cycles per run */
+    long cycles;
+    /** @brief Measured runs per workload */
+    int repeats;
+    /** @brief Unmeasured run before the first measured one (cycles / 10) */
+    bool isWarmup;
+    /** @brief Backend the workloads run on, NULL for the default */
+    const MachineBackend_t *backend;
+} BenchmarkConfig_t;
+
+/**
+ * @brief Measurements of one workload
+ */
+typedef struct BenchmarkResult_t
+{
+    char name[BENCHMARK_MAX_NAME];
+    /** @brief False if the workload could not be loaded */
+    bool isRun;
+
+    int runCount;
+    /** @brief Emulated cycles and instructions of each run (equal between runs) */
+    qword_t cycles;
+    qword_t instructions;
+    /** @brief Host time of every run */
+    qword_t nanoseconds[BENCHMARK_MAX_REPEATS];
+
+    /* ------------------------------- Statistics ------------------------------- */
+    // Emulated MHz, computed by @ref benchmarkSummarize
+    double medianMHz;
+    double meanMHz;
+    double stddevMHz;
+    double minMHz;
+    double maxMHz;
+    /** @brief Host nanoseconds per emulated instruction (median run) */
+    double nsPerInstruction;
+    /* -------------------------------------------------------------------------- */
+} BenchmarkResult_t;
+
+/**
+ * @brief Returns the default configuration
+ * 
+ * @return BenchmarkConfig_t 
+ */
+BenchmarkConfig_t benchmarkDefaultConfig();
+
+/**
+ * @brief Runs a ROM image for config->cycles emulated cycles, config->repeats times. A
+ * program that halts is reset and started again until the cycles are used up
+ * 
+ * @param name 
+ * @param rom 
+ * @param romSize 
+ * @param config 
+ * @param result 
+ * @return bool False if the machine could not be created
+ */
+bool benchmarkRunRom(const char *name, const byte_t *rom, size_t romSize, const BenchmarkConfig_t *config,
+                     BenchmarkResult_t *result);
+
+/**
+ * @brief Same as @ref benchmarkRunRom for a ROM file
+ * 
+ * @param name 
+ * @param filename 
+ * @param config 
+ * @param result 
+ * @return bool False if the file could not be loaded
+ */
+bool benchmarkRunFile(const char *name, const char *filename, const BenchmarkConfig_t *config,
+                      BenchmarkResult_t *result);
+
+/**
+ * @brief Computes the statistics of a result from its runs
+ * 
+ * @param result 
+ */
+void benchmarkSummarize(BenchmarkResult_t *result);
+
+/**
+ * @brief Prints a human readable table
+ * 
+ * @param stream 
+ * @param results 
+ * @param count 
+ */
+void benchmarkPrintTable(FILE *stream, const BenchmarkResult_t *results, size_t count);
+
+/**
+ * @brief Writes the results as one JSON document (raw run times included)
+ * 
+ * @param stream 
+ * @param config 
+ * @param results 
+ * @param count 
+ */
+void benchmarkWriteJson(FILE *stream, const BenchmarkConfig_t *config, const BenchmarkResult_t *results, size_t count);
+
+#endif // CILOGC80_BENCHMARK_H
@@ -0,0 +1,297 @@
+#include "bench/opcode_bench.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu/cpu.h"
+#include "utils/clock.h"
+
+/**
+ * @brief Register state loaded before an execution
+ */
+typedef struct RegisterSet_t
+{
+    byte_t A, B, C, D, E, H, L;
+    F_t F;
+    word_t IX, IY;
+} RegisterSet_t;
+
+/**
+ * @brief Step function timed by the loop (@ref zilogZ80Step or @ref stepNothing)
+ */
+typedef int (*StepFunction_t)(ZilogZ80_t *cpu);
+
+/**
+ * @brief Step function of the overhead loop
+ *
+ * @param cpu
+ * @return int 0
+ */
+static int stepNothing(ZilogZ80_t *cpu);
+
+/**
+ * @brief Executes the slots round robin, every execution from its own register set
+ *
+ * @param cpu
+ * @param registerSets OPCODE_BENCH_SLOTS sets
+ * @param step
+ * @param iterations
+ * @param cycles Sum of the cycles returned by step
+ * @return qword_t Host nanoseconds
+ */
+static qword_t timeLoop(ZilogZ80_t *cpu, const RegisterSet_t *registerSets, StepFunction_t step, long iterations,
+                        qword_t *cycles);
+
+/**
+ * @brief Writes the instruction copies of an opcode to the ROM
+ *
+ * @param rom
+ * @param group
+ * @param opcode
+ * @param randomState
+ */
+static void writeSlots(byte_t *rom, OpcodeGroup group, byte_t opcode, unsigned int *randomState);
+
+/**
+ * @brief xorshift32
+ *
+ * @param randomState
+ * @return byte_t
+ */
+static byte_t randomByte(unsigned int *randomState);
+
+/**
+ * @brief Returns true for the prefix bytes, they are groups of their own
+ *
+ * @param opcode
+ * @return bool
+ */
+static bool isPrefix(byte_t opcode);
+
+/**
+ * @brief qsort comparator, slowest first
+ */
+static int compareResults(const void *first, const void *second);
+
+OpcodeBenchConfig_t opcodeBenchDefaultConfig()
+{
+    OpcodeBenchConfig_t config;
+
+    config.iterations = OPCODE_BENCH_DEFAULT_ITERATIONS;
+    config.repeats = OPCODE_BENCH_DEFAULT_REPEATS;
+    config.seed = 0x12345678;
+
+    return config;
+}
+
+bool opcodeBenchIsGroupDecoded(OpcodeGroup group)
+{
+    // bit_op, misc_op, ix_op and iy_op only report an invalid opcode so far, timing them
+    // would measure the stub and the error push
+    return group == OPCODE_GROUP_MAIN;
+}
+
+size_t opcodeBenchRunGroup(OpcodeGroup group, const OpcodeBenchConfig_t *config, OpcodeBenchResult_t *results)
+{
+    RegisterSet_t registerSets[OPCODE_BENCH_SLOTS];
+    unsigned int randomState = (config->seed != 0) ? config->seed : 1;
+    size_t count = 0;
+
+    if(opcodeBenchIsGroupDecoded(group) == false)
+    {
+        return 0;
+    }
+
+    ZilogZ80_t *cpu = (ZilogZ80_t *)malloc(sizeof(ZilogZ80_t));
+    if(cpu == NULL)
+    {
+        return 0;
+    }
+    zilogZ80Init(cpu);
+
+    for(int slot = 0; slot < OPCODE_BENCH_SLOTS; slot++)
+    {
+        RegisterSet_t *set = &registerSets[slot];
+
+        set->A = randomByte(&randomState);
+        set->B = randomByte(&randomState);
+        set->C = randomByte(&randomState);
+        set->D = randomByte(&randomState);
+        set->E = randomByte(&randomState);
+        set->H = randomByte(&randomState);
+        set->L = randomByte(&randomState);
+        set->IX = TO_WORD(randomByte(&randomState), randomByte(&randomState));
+        set->IY = TO_WORD(randomByte(&randomState), randomByte(&randomState));
+
+        set->F = zilogZ80FlagsFromByte(randomByte(&randomState));
+    }
+
+    for(int opcode = 0; opcode < 0x100; opcode++)
+    {
+        if(group == OPCODE_GROUP_MAIN && isPrefix((byte_t)opcode) == true)
+        {
+            continue;
+        }
+
+        // The slots live in ROM, instructions that write memory can not overwrite them
+        writeSlots(cpu->rom.data, group, (byte_t)opcode, &randomState);
+
+        qword_t bestTime = 0;
+        qword_t bestOverhead = 0;
+        qword_t cycles = 0;
+
+        for(int repeat = 0; repeat < config->repeats; repeat++)
+        {
+            qword_t overheadCycles = 0;
+            qword_t overhead = timeLoop(cpu, registerSets, stepNothing, config->iterations, &overheadCycles);
+            qword_t time = timeLoop(cpu, registerSets, zilogZ80Step, config->iterations, &cycles);
+
+            if(repeat == 0 || overhead < bestOverhead)
+            {
+                bestOverhead = overhead;
+            }
+            if(repeat == 0 || time < bestTime)
+            {
+                bestTime = time;
+            }
+        }
+
+        OpcodeBenchResult_t *result = &results[count++];
+        result->group = group;
+        result->opcode = (byte_t)opcode;
+        result->cycles = (double)cycles / (double)config->iterations;
+        result->nanoseconds = (bestTime > bestOverhead)
+            ? (double)(bestTime - bestOverhead) / (double)config->iterations
+            : 0.0;
+    }
+
+    memoryDestroy(&cpu->rom);
+    memoryDestroy(&cpu->ram);
+    free(cpu);
+
+    return count;
+}
+
+void opcodeBenchSort(OpcodeBenchResult_t *results, size_t count)
+{
+    qsort(results, count, sizeof(OpcodeBenchResult_t), compareResults);
+}
+
+void opcodeBenchPrintTable(FILE *stream, const OpcodeBenchResult_t *results, size_t count, size_t limit)
+{
+    if(limit == 0 || limit > count)
+    {
+        limit = count;
+    }
+
+    fprintf(stream, "%-6s %-12s %10s %8s %10s\n", "group", "opcode", "ns", "cycles", "ns/cycle");
+
+    for(size_t idx = 0; idx < limit; idx++)
+    {
+        const OpcodeBenchResult_t *result = &results[idx];
+        char opcode[16];
+
+        opcodeProfileFormat(result->group, result->opcode, opcode, sizeof(opcode));
+        fprintf(stream, "%-6s %-12s %10.2f %8.2f %10.3f\n", opcodeGroupName(result->group), opcode,
+                result->nanoseconds, result->cycles,
+                (result->cycles > 0.0) ? result->nanoseconds / result->cycles : 0.0);
+    }
+}
+
+static int stepNothing(ZilogZ80_t *cpu)
+{
+    (void)cpu;
+    return 0;
+}
+
+static qword_t timeLoop(ZilogZ80_t *cpu, const RegisterSet_t *registerSets, StepFunction_t step, long iterations,
+                        qword_t *cycles)
+{
+    // Called through a volatile pointer, the overhead loop can not be optimized differently
+    StepFunction_t volatile stepFunction = step;
+    qword_t cycleSum = 0;
+
+    qword_t startTime = clockNowNanoseconds();
+
+    for(long iteration = 0; iteration < iterations; iteration++)
+    {
+        int slot = (int)(iteration & (OPCODE_BENCH_SLOTS - 1));
+        const RegisterSet_t *set = &registerSets[slot];
+
+        cpu->A = set->A;
+        cpu->B = set->B;
+        cpu->C = set->C;
+        cpu->D = set->D;
+        cpu->E = set->E;
+        cpu->H = set->H;
+        cpu->L = set->L;
+        cpu->F = set->F;
+        cpu->IX = set->IX;
+        cpu->IY = set->IY;
+        cpu->SP = OPCODE_BENCH_STACK_ADDRESS;
+        cpu->PC = (word_t)(slot * OPCODE_BENCH_SLOT_SIZE);
+        cpu->isHaltered = false;
+
+        cycleSum += (qword_t)stepFunction(cpu);
+    }
+
+    qword_t elapsedTime = clockNowNanoseconds() - startTime;
+    *cycles = cycleSum;
+
+    return elapsedTime;
+}
+
+static void writeSlots(byte_t *rom, OpcodeGroup group, byte_t opcode, unsigned int *randomState)
+{
+    for(int slot = 0; slot < OPCODE_BENCH_SLOTS; slot++)
+    {
+        byte_t *code = &rom[slot * OPCODE_BENCH_SLOT_SIZE];
+        int length = 0;
+
+        for(int idx = 0; idx < OPCODE_BENCH_SLOT_SIZE; idx++)
+        {
+            code[idx] = randomByte(randomState);
+        }
+
+        switch(group)
+        {
+        case OPCODE_GROUP_CB:   code[length++] = 0xCB; break;
+        case OPCODE_GROUP_ED:   code[length++] = 0xED; break;
+        case OPCODE_GROUP_DD:   code[length++] = 0xDD; break;
+        case OPCODE_GROUP_FD:   code[length++] = 0xFD; break;
+        case OPCODE_GROUP_DDCB:
+        case OPCODE_GROUP_FDCB:
+            code[length++] = (group == OPCODE_GROUP_DDCB) ? 0xDD : 0xFD;
+            code[length++] = 0xCB;
+            // Random displacement
+            length++;
+            break;
+        default:
+            break;
+        }
+
+        code[length] = opcode;
+    }
+}
+
+static byte_t randomByte(unsigned int *randomState)
+{
+    *randomState ^= *randomState << 13;
+    *randomState ^= *randomState >> 17;
+    *randomState ^= *randomState << 5;
+
+    return (byte_t)*randomState;
+}
+
+static bool isPrefix(byte_t opcode)
+{
+    return opcode == 0xCB || opcode == 0xDD || opcode == 0xED || opcode == 0xFD;
+}
+
+static int compareResults(const void *first, const void *second)
+{
+    double a = ((const OpcodeBenchResult_t *)first)->nanoseconds;
+    double b = ((const OpcodeBenchResult_t *)second)->nanoseconds;
+
+    return (a < b) - (a > b);
+}
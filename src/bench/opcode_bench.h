@@ -0,0 +1,97 @@
+#ifndef CILOGC80_OPCODE_BENCH_H
+#define CILOGC80_OPCODE_BENCH_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "utils/utils.h"
+#include "cpu/opcode_profile.h"
+
+/** @brief Number of instruction copies (and register sets) cycled through per opcode */
+#define OPCODE_BENCH_SLOTS 256
+/** @brief Bytes per instruction copy: prefixes, opcode and random operands */
+#define OPCODE_BENCH_SLOT_SIZE 8
+/** @brief Stack pointer loaded before every execution */
+#define OPCODE_BENCH_STACK_ADDRESS 0xF000
+
+#define OPCODE_BENCH_DEFAULT_ITERATIONS 100000L
+#define OPCODE_BENCH_DEFAULT_REPEATS 3
+/** @brief Upper bound of results of one run (every group, 256 opcodes each) */
+#define OPCODE_BENCH_MAX_RESULTS (OPCODE_GROUP_COUNT * 0x100)
+
+/**
+ * @brief Microbenchmark parameters
+ */
+typedef struct OpcodeBenchConfig_t
+{
+    /** @brief Executions per opcode and repeat */
+    long iterations;
+    /** @brief The fastest of the repeats is kept */
+    int repeats;
+    /** @brief Seed of the random operands and registers */
+    unsigned int seed;
+} OpcodeBenchConfig_t;
+
+/**
+ * @brief Cost of one opcode
+ */
+typedef struct OpcodeBenchResult_t
+{
+    OpcodeGroup group;
+    byte_t opcode;
+    /** @brief Average emulated cycles per execution (conditional instructions vary) */
+    double cycles;
+    /** @brief Host nanoseconds per execution, loop overhead subtracted */
+    double nanoseconds;
+} OpcodeBenchResult_t;
+
+/**
+ * @brief Returns the default configuration
+ *
+ * @return OpcodeBenchConfig_t
+ */
+OpcodeBenchConfig_t opcodeBenchDefaultConfig();
+
+/**
+ * @brief Returns true if the core dispatches the opcodes of a group. The prefixed groups
+ * are not decoded yet (their prefix reports an invalid opcode), so only the main group can
+ * be timed
+ *
+ * @param group
+ * @return bool
+ */
+bool opcodeBenchIsGroupDecoded(OpcodeGroup group);
+
+/**
+ * @brief Times every opcode of a group. Each opcode is executed config->iterations times
+ * from @ref OPCODE_BENCH_SLOTS copies with random operands, every execution starts from
+ * one of as many random register sets. The same loop with an empty step function is timed
+ * as well and subtracted
+ *
+ * @param group
+ * @param config
+ * @param results Room for 256 results
+ * @return size_t Number of results written, 0 if the group is not decoded (see
+ * @ref opcodeBenchIsGroupDecoded) or the CPU could not be created
+ */
+size_t opcodeBenchRunGroup(OpcodeGroup group, const OpcodeBenchConfig_t *config, OpcodeBenchResult_t *results);
+
+/**
+ * @brief Sorts results by host time, slowest first
+ *
+ * @param results
+ * @param count
+ */
+void opcodeBenchSort(OpcodeBenchResult_t *results, size_t count);
+
+/**
+ * @brief Prints a table of the results in their current order
+ *
+ * @param stream
+ * @param results
+ * @param count
+ * @param limit Maximum number of rows, 0 prints all
+ */
+void opcodeBenchPrintTable(FILE *stream, const OpcodeBenchResult_t *results, size_t count, size_t limit);
+
+#endif // CILOGC80_OPCODE_BENCH_H
@@ -0,0 +1,148 @@
+#ifndef CILOG_C80_ALU_H
+#define CILOG_C80_ALU_H
+
+#include <stdbool.h>
+
+#include "utils/utils.h"
+
+/* ------------------------------- Flag masks ------------------------------- */
+// Bit positions of the F register as pushed by PUSH AF
+#define ALU_FLAG_C 0x01
+#define ALU_FLAG_N 0x02
+#define ALU_FLAG_P 0x04
+#define ALU_FLAG_H 0x10
+#define ALU_FLAG_Z 0x40
+#define ALU_FLAG_S 0x80
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Enum struct for defining the 8 bit ALU operations, in opcode order (bits 3-5 of
+ * 0x80-0xBF and 0xC6-0xFE)
+ */
+typedef enum AluOperation
+{
+    ALU_ADD = 0,
+    ALU_ADC,
+    ALU_SUB,
+    ALU_SBC,
+    ALU_AND,
+    ALU_XOR,
+    ALU_OR,
+    ALU_CP
+} AluOperation;
+
+/**
+ * @brief Returns ALU_FLAG_P if value has an even number of set bits
+ *
+ * @param value
+ * @return byte_t ALU_FLAG_P or 0
+ */
+static inline byte_t aluParity(byte_t value)
+{
+    // Fold the byte onto its lowest bit
+    byte_t parity = value;
+    parity ^= parity >> 4;
+    parity ^= parity >> 2;
+    parity ^= parity >> 1;
+
+    return (byte_t)(((parity & 0x01) == 0) ? ALU_FLAG_P : 0);
+}
+
+/**
+ * @brief Flags of an 8 bit addition or subtraction (ADD, ADC, SUB, SBC, CP). Shared by the
+ * scalar and the lane core, so both always agree. Branch free, the lane core calls it
+ * inside vectorized loops
+ *
+ * @param regA Value of A before the operation
+ * @param operand
+ * @param result Unmasked result including the carry in (bit 8 = carry / borrow)
+ * @param isSubstraction
+ * @return byte_t Flags, see ALU_FLAG_*. P is the overflow flag
+ */
+static inline byte_t aluFlags(byte_t regA, byte_t operand, word_t result, bool isSubstraction)
+{
+    byte_t value = (byte_t)(result & 0xFF);
+
+    // Bit 4 of a ^ operand ^ result is the carry (borrow) out of bit 3, carry in included
+    byte_t halfCarry = (byte_t)((regA ^ operand ^ value) & ALU_FLAG_H);
+
+    // Signed overflow: the operands have the same sign (addition) or different signs
+    // (subtraction) and the sign of the result differs from A
+    byte_t signChange = (byte_t)(isSubstraction ? (regA ^ operand) : ~(regA ^ operand));
+    byte_t overflow = (byte_t)(signChange & (regA ^ value) & 0x80);
+
+    return (byte_t)(
+        (value & ALU_FLAG_S) |
+        ((value == 0) ? ALU_FLAG_Z : 0) |
+        halfCarry |
+        (overflow >> 5) |
+        (isSubstraction ? ALU_FLAG_N : 0) |
+        ((result > 0xFF) ? ALU_FLAG_C : 0)
+    );
+}
+
+/**
+ * @brief Flags of AND, XOR and OR: P is the parity, C and N are reset, H is set by AND only
+ *
+ * @param result
+ * @param isAnd
+ * @return byte_t
+ */
+static inline byte_t aluLogicFlags(byte_t result, bool isAnd)
+{
+    return (byte_t)(
+        (result & ALU_FLAG_S) |
+        ((result == 0) ? ALU_FLAG_Z : 0) |
+        (isAnd ? ALU_FLAG_H : 0) |
+        aluParity(result)
+    );
+}
+
+/**
+ * @brief Flags of an 8 bit INC or DEC, which keep the carry
+ *
+ * @param value Value before the operation
+ * @param isDecrement
+ * @param flags Flags before the operation
+ * @return byte_t
+ */
+static inline byte_t aluIncDecFlags(byte_t value, bool isDecrement, byte_t flags)
+{
+    word_t result = isDecrement ? (word_t)(value - 1) : (word_t)(value + 1);
+
+    return (byte_t)((aluFlags(value, 1, result, isDecrement) & ~ALU_FLAG_C) | (flags & ALU_FLAG_C));
+}
+
+/**
+ * @brief DAA: corrects A to packed BCD after an addition or subtraction (N) of two BCD
+ * values
+ *
+ * @param regA
+ * @param flags Flags before the operation, H, N and C select the correction
+ * @param result Receives the corrected A
+ * @return byte_t Flags, N is kept
+ */
+static inline byte_t aluDaa(byte_t regA, byte_t flags, byte_t *result)
+{
+    bool isSubstraction = (flags & ALU_FLAG_N) != 0;
+    byte_t lowNibble = (byte_t)(regA & 0x0F);
+    byte_t correction = (byte_t)(
+        (((flags & ALU_FLAG_H) != 0 || lowNibble > 9) ? 0x06 : 0) |
+        (((flags & ALU_FLAG_C) != 0 || regA > 0x99) ? 0x60 : 0)
+    );
+    byte_t value = (byte_t)(isSubstraction ? regA - correction : regA + correction);
+    bool isHalfCarry = isSubstraction ? ((flags & ALU_FLAG_H) != 0 && lowNibble < 6) : (lowNibble > 9);
+
+    *result = value;
+
+    return (byte_t)(
+        (value & ALU_FLAG_S) |
+        ((value == 0) ? ALU_FLAG_Z : 0) |
+        (isHalfCarry ? ALU_FLAG_H : 0) |
+        aluParity(value) |
+        (flags & ALU_FLAG_N) |
+        (((correction & 0x60) != 0) ? ALU_FLAG_C : 0)
+    );
+}
+
+#endif // CILOG_C80_ALU_H
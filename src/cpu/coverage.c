@@ -0,0 +1,646 @@
+#include "cpu/coverage.h"
+
+#include <string.h>
+
+/** @brief Knuth's multiplicative hash constant */
+#define EDGE_HASH_MULTIPLIER 2654435761u
+/** @brief Longest Z80 instruction, straight line code never moves the PC further */
+#define COVERAGE_MAX_INSTRUCTION_LENGTH 4
+
+/**
+ * @brief Returns the slot of an edge, or the free slot it would go into
+ *
+ * @param coverage
+ * @param from
+ * @param to
+ * @return CoverageEdge_t*
+ */
+static CoverageEdge_t *findEdge(const Coverage_t *coverage, word_t from, word_t to);
+
+/**
+ * @brief Adds hits to an edge, inserting it if it is new
+ *
+ * @param coverage
+ * @param from
+ * @param to
+ * @param hits
+ * @return bool True if the edge is new
+ */
+static bool addEdge(Coverage_t *coverage, word_t from, word_t to, dword_t hits);
+
+/**
+ * @brief Doubles the edge table
+ *
+ * @param coverage
+ * @return bool False at COVERAGE_MAX_EDGES or if out of memory
+ */
+static bool growEdges(Coverage_t *coverage);
+
+/**
+ * @brief Returns whether an edge is the fall through of its branch (the not taken side)
+ *
+ * @param edge
+ * @return bool
+ */
+static bool isFallThrough(const CoverageEdge_t *edge);
+
+/**
+ * @brief Copies the used edge slots into an array sorted by from, then to
+ *
+ * @param coverage
+ * @return CoverageEdge_t* edgeCount entries (free it), NULL if out of memory
+ */
+static CoverageEdge_t *sortEdges(const Coverage_t *coverage);
+
+/**
+ * @brief Sums the hits of the edges into every symbol address, an executed symbol nothing
+ * jumped to (reset vector, code running into it) counts as entered once
+ *
+ * @param coverage
+ * @param symbols
+ * @return qword_t* symbols->count entries (free it), NULL if out of memory
+ */
+static qword_t *countEntries(const Coverage_t *coverage, const SymbolTable_t *symbols);
+
+/**
+ * @brief Counts the executed addresses in [start, end)
+ *
+ * @param coverage
+ * @param start
+ * @param end Up to 0x10000
+ * @return size_t
+ */
+static size_t countExecuted(const Coverage_t *coverage, size_t start, size_t end);
+
+/**
+ * @brief Formats an address with the symbol it belongs to ("main+0x12")
+ *
+ * @param symbols NULL if no symbols are loaded
+ * @param address
+ * @param buffer
+ * @param bufferSize
+ * @return const char* buffer
+ */
+static const char *formatLocation(const SymbolTable_t *symbols, word_t address, char *buffer, size_t bufferSize);
+
+/**
+ * @brief Writes a JSON string literal, symbol names only need quotes and backslashes escaped
+ *
+ * @param stream
+ * @param text
+ */
+static void writeJsonString(FILE *stream, const char *text);
+
+/**
+ * @brief qsort comparator for edges
+ */
+static int compareEdges(const void *first, const void *second);
+
+/** @brief Branch kinds of the unprefixed opcodes */
+static const byte_t mainBranches[0x100] = {
+    [0x10] = COVERAGE_BRANCH_CONDITIONAL,  // DJNZ
+    [0x18] = COVERAGE_BRANCH_ALWAYS,       // JR
+    [0x20] = COVERAGE_BRANCH_CONDITIONAL, [0x28] = COVERAGE_BRANCH_CONDITIONAL,
+    [0x30] = COVERAGE_BRANCH_CONDITIONAL, [0x38] = COVERAGE_BRANCH_CONDITIONAL,
+    // RET cc
+    [0xC0] = COVERAGE_BRANCH_CONDITIONAL, [0xC8] = COVERAGE_BRANCH_CONDITIONAL,
+    [0xD0] = COVERAGE_BRANCH_CONDITIONAL, [0xD8] = COVERAGE_BRANCH_CONDITIONAL,
+    [0xE0] = COVERAGE_BRANCH_CONDITIONAL, [0xE8] = COVERAGE_BRANCH_CONDITIONAL,
+    [0xF0] = COVERAGE_BRANCH_CONDITIONAL, [0xF8] = COVERAGE_BRANCH_CONDITIONAL,
+    // JP cc
+    [0xC2] = COVERAGE_BRANCH_CONDITIONAL, [0xCA] = COVERAGE_BRANCH_CONDITIONAL,
+    [0xD2] = COVERAGE_BRANCH_CONDITIONAL, [0xDA] = COVERAGE_BRANCH_CONDITIONAL,
+    [0xE2] = COVERAGE_BRANCH_CONDITIONAL, [0xEA] = COVERAGE_BRANCH_CONDITIONAL,
+    [0xF2] = COVERAGE_BRANCH_CONDITIONAL, [0xFA] = COVERAGE_BRANCH_CONDITIONAL,
+    // CALL cc
+    [0xC4] = COVERAGE_BRANCH_CONDITIONAL, [0xCC] = COVERAGE_BRANCH_CONDITIONAL,
+    [0xD4] = COVERAGE_BRANCH_CONDITIONAL, [0xDC] = COVERAGE_BRANCH_CONDITIONAL,
+    [0xE4] = COVERAGE_BRANCH_CONDITIONAL, [0xEC] = COVERAGE_BRANCH_CONDITIONAL,
+    [0xF4] = COVERAGE_BRANCH_CONDITIONAL, [0xFC] = COVERAGE_BRANCH_CONDITIONAL,
+    // RST
+    [0xC7] = COVERAGE_BRANCH_ALWAYS, [0xCF] = COVERAGE_BRANCH_ALWAYS,
+    [0xD7] = COVERAGE_BRANCH_ALWAYS, [0xDF] = COVERAGE_BRANCH_ALWAYS,
+    [0xE7] = COVERAGE_BRANCH_ALWAYS, [0xEF] = COVERAGE_BRANCH_ALWAYS,
+    [0xF7] = COVERAGE_BRANCH_ALWAYS, [0xFF] = COVERAGE_BRANCH_ALWAYS,
+    [0xC3] = COVERAGE_BRANCH_ALWAYS,       // JP nn
+    [0xC9] = COVERAGE_BRANCH_ALWAYS,       // RET
+    [0xCD] = COVERAGE_BRANCH_ALWAYS,       // CALL nn
+    [0xE9] = COVERAGE_BRANCH_ALWAYS};      // JP (HL)
+
+Coverage_t *coverageCreate()
+{
+    Coverage_t *coverage = (Coverage_t *)calloc(1, sizeof(Coverage_t));
+    if(coverage == NULL)
+    {
+        return NULL;
+    }
+
+    coverage->edges = (CoverageEdge_t *)calloc(COVERAGE_INITIAL_EDGES, sizeof(CoverageEdge_t));
+    if(coverage->edges == NULL)
+    {
+        free(coverage);
+        return NULL;
+    }
+    coverage->edgeCapacity = COVERAGE_INITIAL_EDGES;
+    coverage->edgeShift = 32;
+    for(size_t capacity = COVERAGE_INITIAL_EDGES; capacity > 1; capacity >>= 1)
+    {
+        coverage->edgeShift--;
+    }
+
+    return coverage;
+}
+
+void coverageDestroy(Coverage_t *coverage)
+{
+    if(coverage != NULL)
+    {
+        free(coverage->edges);
+        free(coverage);
+    }
+}
+
+void coverageClear(Coverage_t *coverage)
+{
+    // Cheap for maps that are cleared per test case and often stay empty
+    if(coverage->addressCount > 0)
+    {
+        memset(coverage->executed, 0x00, sizeof(coverage->executed));
+        memset(coverage->conditional, 0x00, sizeof(coverage->conditional));
+    }
+    if(coverage->edgeCount > 0)
+    {
+        memset(coverage->edges, 0x00, coverage->edgeCapacity * sizeof(CoverageEdge_t));
+    }
+
+    coverage->addressCount = 0;
+    coverage->edgeCount = 0;
+    coverage->droppedEdges = 0;
+}
+
+CoverageBranch coverageBranchKind(OpcodeGroup group, byte_t opcode)
+{
+    switch(group)
+    {
+        case OPCODE_GROUP_MAIN:
+            return (CoverageBranch)mainBranches[opcode];
+        case OPCODE_GROUP_ED:
+            // RETN / RETI and their mirrors
+            if((opcode & 0xC7) == 0x45)
+            {
+                return COVERAGE_BRANCH_ALWAYS;
+            }
+            // LDIR, CPIR, INIR, OTIR, LDDR, CPDR, INDR, OTDR jump back to themselves
+            if((opcode & 0xF4) == 0xB0)
+            {
+                return COVERAGE_BRANCH_CONDITIONAL;
+            }
+            return COVERAGE_BRANCH_NONE;
+        case OPCODE_GROUP_DD:
+        case OPCODE_GROUP_FD:
+            // JP (IX) / JP (IY)
+            return (opcode == 0xE9) ? COVERAGE_BRANCH_ALWAYS : COVERAGE_BRANCH_NONE;
+        default:
+            return COVERAGE_BRANCH_NONE;
+    }
+}
+
+void coverageRecord(Coverage_t *coverage, word_t pc, OpcodeGroup group, byte_t opcode, word_t nextPC)
+{
+    byte_t bit = (byte_t)(1 << (pc & 7));
+
+    if((coverage->executed[pc >> 3] & bit) == 0)
+    {
+        coverage->executed[pc >> 3] |= bit;
+        coverage->addressCount++;
+    }
+
+    CoverageBranch kind = coverageBranchKind(group, opcode);
+    if(kind == COVERAGE_BRANCH_CONDITIONAL)
+    {
+        coverage->conditional[pc >> 3] |= bit;
+    }
+
+    // Straight line code moves forward by its length, anything else entered a new block
+    if(kind != COVERAGE_BRANCH_NONE || (word_t)(nextPC - pc) > COVERAGE_MAX_INSTRUCTION_LENGTH)
+    {
+        addEdge(coverage, pc, nextPC, 1);
+    }
+}
+
+dword_t coverageEdgeHits(const Coverage_t *coverage, word_t from, word_t to)
+{
+    return findEdge(coverage, from, to)->hits;
+}
+
+size_t coverageMerge(Coverage_t *destination, const Coverage_t *source)
+{
+    size_t newCount = 0;
+
+    for(size_t idx = 0; idx < COVERAGE_BITMAP_SIZE; idx++)
+    {
+        byte_t newBits = (byte_t)(source->executed[idx] & ~destination->executed[idx]);
+
+        for(; newBits != 0; newBits &= (byte_t)(newBits - 1))
+        {
+            newCount++;
+        }
+        destination->executed[idx] |= source->executed[idx];
+        destination->conditional[idx] |= source->conditional[idx];
+    }
+    destination->addressCount += newCount;
+
+    for(size_t idx = 0; idx < source->edgeCapacity; idx++)
+    {
+        const CoverageEdge_t *edge = &source->edges[idx];
+
+        if(edge->hits != 0 && addEdge(destination, edge->from, edge->to, edge->hits) == true)
+        {
+            newCount++;
+        }
+    }
+    destination->droppedEdges += source->droppedEdges;
+
+    return newCount;
+}
+
+bool coverageWriteJson(const Coverage_t *coverage, FILE *stream, const SymbolTable_t *symbols)
+{
+    char fromText[SYMBOL_MAX_NAME + 16];
+    char toText[SYMBOL_MAX_NAME + 16];
+    bool hasSymbols = symbols != NULL && symbols->count > 0;
+
+    CoverageEdge_t *edges = sortEdges(coverage);
+    qword_t *entries = hasSymbols ? countEntries(coverage, symbols) : NULL;
+    if(edges == NULL || (hasSymbols == true && entries == NULL))
+    {
+        free(edges);
+        free(entries);
+        return false;
+    }
+
+    fprintf(stream, "{\n  \"format\": %d,\n  \"address_count\": %zu,\n  \"edge_count\": %zu,\n  \"dropped_edges\": %llu,\n",
+            COVERAGE_JSON_FORMAT, coverage->addressCount, coverage->edgeCount,
+            (unsigned long long)coverage->droppedEdges);
+
+    // Instruction starts closer than the longest instruction are one range of code
+    fprintf(stream, "  \"ranges\": [");
+    size_t rangeCount = 0;
+    for(size_t address = 0; address < 0x10000; address++)
+    {
+        if(coverageIsExecuted(coverage, (word_t)address) == false)
+        {
+            continue;
+        }
+
+        size_t last = address;
+        for(size_t next = address + 1; next < 0x10000 && next <= last + COVERAGE_MAX_INSTRUCTION_LENGTH; next++)
+        {
+            if(coverageIsExecuted(coverage, (word_t)next) == true)
+            {
+                last = next;
+            }
+        }
+
+        fprintf(stream, "%s[%zu, %zu]", (rangeCount > 0) ? ", " : "", address, last);
+        rangeCount++;
+        address = last;
+    }
+    fprintf(stream, "],\n");
+
+    if(hasSymbols == true)
+    {
+        fprintf(stream, "  \"symbols\": [");
+        for(size_t idx = 0; idx < symbols->count; idx++)
+        {
+            const Symbol_t *symbol = &symbols->symbols[idx];
+            size_t end = (idx + 1 < symbols->count) ? symbols->symbols[idx + 1].address : 0x10000;
+
+            fprintf(stream, "%s\n    {\"name\": ", (idx > 0) ? "," : "");
+            writeJsonString(stream, symbol->name);
+            fprintf(stream, ", \"address\": %u, \"entries\": %llu, \"executed\": %zu}", (unsigned int)symbol->address,
+                    (unsigned long long)entries[idx], countExecuted(coverage, symbol->address, end));
+        }
+        fprintf(stream, "\n  ],\n");
+    }
+
+    fprintf(stream, "  \"edges\": [");
+    for(size_t idx = 0; idx < coverage->edgeCount; idx++)
+    {
+        const CoverageEdge_t *edge = &edges[idx];
+
+        fprintf(stream, "%s\n    {\"from\": %u, \"to\": %u, \"hits\": %lu, \"conditional\": %s",
+                (idx > 0) ? "," : "", (unsigned int)edge->from, (unsigned int)edge->to, (unsigned long)edge->hits,
+                (coverage->conditional[edge->from >> 3] & (1 << (edge->from & 7))) ? "true" : "false");
+        if(hasSymbols == true)
+        {
+            fprintf(stream, ", \"from_symbol\": ");
+            writeJsonString(stream, formatLocation(symbols, edge->from, fromText, sizeof(fromText)));
+            fprintf(stream, ", \"to_symbol\": ");
+            writeJsonString(stream, formatLocation(symbols, edge->to, toText, sizeof(toText)));
+        }
+        fprintf(stream, "}");
+    }
+    fprintf(stream, "\n  ]\n}\n");
+
+    free(edges);
+    free(entries);
+
+    return true;
+}
+
+bool coverageWriteLcov(const Coverage_t *coverage, FILE *stream, const char *sourceName,
+                       const SymbolTable_t *symbols)
+{
+    bool hasSymbols = symbols != NULL && symbols->count > 0;
+
+    CoverageEdge_t *edges = sortEdges(coverage);
+    qword_t *entries = hasSymbols ? countEntries(coverage, symbols) : NULL;
+    if(edges == NULL || (hasSymbols == true && entries == NULL))
+    {
+        free(edges);
+        free(entries);
+        return false;
+    }
+
+    fprintf(stream, "TN:\nSF:%s\n", sourceName);
+
+    size_t functionsHit = 0;
+    for(size_t idx = 0; hasSymbols == true && idx < symbols->count; idx++)
+    {
+        fprintf(stream, "FN:%u,%s\n", (unsigned int)symbols->symbols[idx].address + 1, symbols->symbols[idx].name);
+    }
+    for(size_t idx = 0; hasSymbols == true && idx < symbols->count; idx++)
+    {
+        fprintf(stream, "FNDA:%llu,%s\n", (unsigned long long)entries[idx], symbols->symbols[idx].name);
+        functionsHit += (entries[idx] > 0) ? 1 : 0;
+    }
+    fprintf(stream, "FNF:%zu\nFNH:%zu\n", hasSymbols ? symbols->count : (size_t)0, functionsHit);
+
+    // The edges are sorted by source, every conditional branch has its edges in one run
+    size_t branchesFound = 0;
+    size_t branchesHit = 0;
+    for(size_t idx = 0; idx < coverage->edgeCount;)
+    {
+        word_t from = edges[idx].from;
+        qword_t taken = 0;
+        qword_t notTaken = 0;
+
+        for(; idx < coverage->edgeCount && edges[idx].from == from; idx++)
+        {
+            if(isFallThrough(&edges[idx]) == true)
+            {
+                notTaken += edges[idx].hits;
+            }
+            else
+            {
+                taken += edges[idx].hits;
+            }
+        }
+
+        if((coverage->conditional[from >> 3] & (1 << (from & 7))) == 0)
+        {
+            continue;
+        }
+
+        fprintf(stream, "BRDA:%u,0,0,", (unsigned int)from + 1);
+        fprintf(stream, (taken > 0) ? "%llu\n" : "-\n", (unsigned long long)taken);
+        fprintf(stream, "BRDA:%u,0,1,", (unsigned int)from + 1);
+        fprintf(stream, (notTaken > 0) ? "%llu\n" : "-\n", (unsigned long long)notTaken);
+
+        branchesFound += 2;
+        branchesHit += ((taken > 0) ? 1 : 0) + ((notTaken > 0) ? 1 : 0);
+    }
+    fprintf(stream, "BRF:%zu\nBRH:%zu\n", branchesFound, branchesHit);
+
+    for(size_t address = 0; address < 0x10000; address++)
+    {
+        if(coverageIsExecuted(coverage, (word_t)address) == true)
+        {
+            fprintf(stream, "DA:%zu,1\n", address + 1);
+        }
+    }
+    fprintf(stream, "LF:%zu\nLH:%zu\nend_of_record\n", coverage->addressCount, coverage->addressCount);
+
+    free(edges);
+    free(entries);
+
+    return true;
+}
+
+bool coverageSaveFile(const Coverage_t *coverage, const char *path, const char *sourceName,
+                      const SymbolTable_t *symbols)
+{
+    size_t length = strlen(path);
+    bool isLcov = length >= 5 && strcmp(path + length - 5, ".info") == 0;
+
+    FILE *stream = fopen(path, "w");
+    if(stream == NULL)
+    {
+        return false;
+    }
+
+    bool isWritten = isLcov ? coverageWriteLcov(coverage, stream, sourceName, symbols)
+                            : coverageWriteJson(coverage, stream, symbols);
+
+    // fclose flushes, a full disk shows up there
+    return (fclose(stream) == 0) && isWritten;
+}
+
+static CoverageEdge_t *findEdge(const Coverage_t *coverage, word_t from, word_t to)
+{
+    size_t mask = coverage->edgeCapacity - 1;
+    // The low bits of the product only depend on the low bits of the key (to), the high bits
+    // mix in from as well
+    dword_t hash = (dword_t)((((dword_t)from << 16) | to) * EDGE_HASH_MULTIPLIER);
+    size_t slot = (size_t)(hash >> coverage->edgeShift) & mask;
+
+    // The table is never more than 3/4 full, probing always ends
+    while(coverage->edges[slot].hits != 0
+          && (coverage->edges[slot].from != from || coverage->edges[slot].to != to))
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return &coverage->edges[slot];
+}
+
+static bool addEdge(Coverage_t *coverage, word_t from, word_t to, dword_t hits)
+{
+    CoverageEdge_t *edge = findEdge(coverage, from, to);
+
+    if(edge->hits != 0)
+    {
+        edge->hits = (edge->hits > 0xFFFFFFFFu - hits) ? 0xFFFFFFFFu : edge->hits + hits;
+        return false;
+    }
+
+    if((coverage->edgeCount + 1) * 4 > coverage->edgeCapacity * 3)
+    {
+        if(growEdges(coverage) == false)
+        {
+            coverage->droppedEdges++;
+            return false;
+        }
+        edge = findEdge(coverage, from, to);
+    }
+
+    edge->from = from;
+    edge->to = to;
+    edge->hits = hits;
+    coverage->edgeCount++;
+
+    return true;
+}
+
+static bool growEdges(Coverage_t *coverage)
+{
+    if(coverage->edgeCapacity >= COVERAGE_MAX_EDGES)
+    {
+        return false;
+    }
+
+    CoverageEdge_t *oldEdges = coverage->edges;
+    size_t oldCapacity = coverage->edgeCapacity;
+
+    CoverageEdge_t *edges = (CoverageEdge_t *)calloc(oldCapacity * 2, sizeof(CoverageEdge_t));
+    if(edges == NULL)
+    {
+        return false;
+    }
+
+    coverage->edges = edges;
+    coverage->edgeCapacity = oldCapacity * 2;
+    coverage->edgeShift--;
+
+    for(size_t idx = 0; idx < oldCapacity; idx++)
+    {
+        if(oldEdges[idx].hits != 0)
+        {
+            *findEdge(coverage, oldEdges[idx].from, oldEdges[idx].to) = oldEdges[idx];
+        }
+    }
+    free(oldEdges);
+
+    return true;
+}
+
+static bool isFallThrough(const CoverageEdge_t *edge)
+{
+    word_t distance = (word_t)(edge->to - edge->from);
+
+    // A repeating block instruction jumps to itself, DJNZ / JR backwards wrap around
+    return distance > 0 && distance <= COVERAGE_MAX_INSTRUCTION_LENGTH;
+}
+
+static CoverageEdge_t *sortEdges(const Coverage_t *coverage)
+{
+    // One extra entry, an empty map still gets a buffer
+    CoverageEdge_t *edges = (CoverageEdge_t *)malloc((coverage->edgeCount + 1) * sizeof(CoverageEdge_t));
+    size_t count = 0;
+
+    if(edges == NULL)
+    {
+        return NULL;
+    }
+
+    for(size_t idx = 0; idx < coverage->edgeCapacity; idx++)
+    {
+        if(coverage->edges[idx].hits != 0)
+        {
+            edges[count++] = coverage->edges[idx];
+        }
+    }
+    qsort(edges, count, sizeof(CoverageEdge_t), compareEdges);
+
+    return edges;
+}
+
+static qword_t *countEntries(const Coverage_t *coverage, const SymbolTable_t *symbols)
+{
+    qword_t *entries = (qword_t *)calloc(symbols->count, sizeof(qword_t));
+    if(entries == NULL)
+    {
+        return NULL;
+    }
+
+    for(size_t idx = 0; idx < coverage->edgeCapacity; idx++)
+    {
+        const CoverageEdge_t *edge = &coverage->edges[idx];
+        const Symbol_t *symbol = (edge->hits != 0) ? symbolTableLookup(symbols, edge->to) : NULL;
+
+        if(symbol != NULL && symbol->address == edge->to)
+        {
+            entries[symbol - symbols->symbols] += edge->hits;
+        }
+    }
+
+    for(size_t idx = 0; idx < symbols->count; idx++)
+    {
+        if(entries[idx] == 0 && coverageIsExecuted(coverage, symbols->symbols[idx].address) == true)
+        {
+            entries[idx] = 1;
+        }
+    }
+
+    return entries;
+}
+
+static size_t countExecuted(const Coverage_t *coverage, size_t start, size_t end)
+{
+    size_t count = 0;
+
+    for(size_t address = start; address < end; address++)
+    {
+        count += coverageIsExecuted(coverage, (word_t)address) ? 1 : 0;
+    }
+
+    return count;
+}
+
+static const char *formatLocation(const SymbolTable_t *symbols, word_t address, char *buffer, size_t bufferSize)
+{
+    const Symbol_t *symbol = (symbols != NULL) ? symbolTableLookup(symbols, address) : NULL;
+
+    if(symbol == NULL)
+    {
+        snprintf(buffer, bufferSize, "0x%04X", (unsigned int)address);
+    }
+    else if(symbol->address == address)
+    {
+        snprintf(buffer, bufferSize, "%s", symbol->name);
+    }
+    else
+    {
+        snprintf(buffer, bufferSize, "%s+0x%X", symbol->name, (unsigned int)(address - symbol->address));
+    }
+
+    return buffer;
+}
+
+static void writeJsonString(FILE *stream, const char *text)
+{
+    fputc('"', stream);
+    for(const char *character = text; *character != '\0'; character++)
+    {
+        if(*character == '"' || *character == '\\')
+        {
+            fputc('\\', stream);
+        }
+        fputc(*character, stream);
+    }
+    fputc('"', stream);
+}
+
+static int compareEdges(const void *first, const void *second)
+{
+    const CoverageEdge_t *a = (const CoverageEdge_t *)first;
+    const CoverageEdge_t *b = (const CoverageEdge_t *)second;
+
+    if(a->from != b->from)
+    {
+        return (a->from > b->from) - (a->from < b->from);
+    }
+
+    return (a->to > b->to) - (a->to < b->to);
+}
@@ -0,0 +1,180 @@
+#ifndef CILOGC80_COVERAGE_H
+#define CILOGC80_COVERAGE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "utils/utils.h"
+#include "cpu/opcode_profile.h"
+#include "emulator/symbol_table.h"
+
+/** @brief Bytes of a bitmap with one bit per guest address */
+#define COVERAGE_BITMAP_SIZE (0x10000 / 8)
+/** @brief Edge slots allocated by @ref coverageCreate, the table doubles when it is 3/4 full */
+#define COVERAGE_INITIAL_EDGES 0x400
+/** @brief Largest edge table, edges seen for the first time after it filled up are dropped */
+#define COVERAGE_MAX_EDGES 0x20000
+/** @brief Version of the JSON export, bumped on incompatible changes */
+#define COVERAGE_JSON_FORMAT 1
+
+/**
+ * @brief Enum struct for defining how an instruction can leave the straight line
+ */
+typedef enum CoverageBranch
+{
+    COVERAGE_BRANCH_NONE = 0,
+    /** @brief JP, JR, CALL, RET, RST, JP (HL), RETI / RETN */
+    COVERAGE_BRANCH_ALWAYS,
+    /** @brief Conditional JP, JR, CALL and RET, DJNZ and the repeating block instructions */
+    COVERAGE_BRANCH_CONDITIONAL
+} CoverageBranch;
+
+/**
+ * @brief Control flow edge, from a branch instruction to the address executed after it
+ */
+typedef struct CoverageEdge_t
+{
+    word_t from;
+    word_t to;
+    /** @brief Times the edge was taken (saturates), 0 marks a free slot */
+    dword_t hits;
+} CoverageEdge_t;
+
+/**
+ * @brief Guest code coverage: one bit per address an instruction was executed at, plus the
+ * edges between basic blocks. Every branch instruction records an edge to the address
+ * executed next whether it was taken or not, so a conditional branch seen with a single edge
+ * is a path the program never tried. Any other jump of the PC (interrupts, code running
+ * into a new block) also counts as an edge
+ */
+typedef struct Coverage_t
+{
+    byte_t executed[COVERAGE_BITMAP_SIZE];
+    /** @brief Addresses of conditional branches seen, they have two possible edges */
+    byte_t conditional[COVERAGE_BITMAP_SIZE];
+    /** @brief Bits set in executed */
+    size_t addressCount;
+
+    /** @brief Open addressing hash table of the edges */
+    CoverageEdge_t *edges;
+    size_t edgeCapacity;
+    /** @brief 32 - log2(edgeCapacity), the hash uses the high bits of its product */
+    unsigned int edgeShift;
+    size_t edgeCount;
+    /** @brief Edges not recorded because the table was full */
+    qword_t droppedEdges;
+} Coverage_t;
+
+/**
+ * @brief Allocates an empty coverage map
+ *
+ * @return Coverage_t* NULL if out of memory
+ */
+Coverage_t *coverageCreate();
+
+/**
+ * @brief Frees a coverage map (detach it from the CPU first)
+ *
+ * @param coverage
+ */
+void coverageDestroy(Coverage_t *coverage);
+
+/**
+ * @brief Forgets everything recorded, the edge table keeps its size
+ *
+ * @param coverage
+ */
+void coverageClear(Coverage_t *coverage);
+
+/**
+ * @brief Returns how an opcode can branch
+ *
+ * @param group
+ * @param opcode
+ * @return CoverageBranch
+ */
+CoverageBranch coverageBranchKind(OpcodeGroup group, byte_t opcode);
+
+/**
+ * @brief Records an executed instruction
+ *
+ * @param coverage
+ * @param pc Address of the instruction
+ * @param group Decoded before the instruction
+ * @param opcode Decoded before the instruction
+ * @param nextPC PC after the instruction
+ */
+void coverageRecord(Coverage_t *coverage, word_t pc, OpcodeGroup group, byte_t opcode, word_t nextPC);
+
+/**
+ * @brief Returns whether an instruction was executed at an address
+ *
+ * @param coverage
+ * @param address
+ * @return bool
+ */
+static inline bool coverageIsExecuted(const Coverage_t *coverage, word_t address)
+{
+    return (coverage->executed[address >> 3] & (1 << (address & 7))) != 0;
+}
+
+/**
+ * @brief Returns how often an edge was taken
+ *
+ * @param coverage
+ * @param from
+ * @param to
+ * @return dword_t 0 if never
+ */
+dword_t coverageEdgeHits(const Coverage_t *coverage, word_t from, word_t to);
+
+/**
+ * @brief Adds the addresses and edges of source to destination (hits are summed)
+ *
+ * @param destination
+ * @param source
+ * @return size_t Addresses and edges destination did not have before
+ */
+size_t coverageMerge(Coverage_t *destination, const Coverage_t *source);
+
+/**
+ * @brief Writes the coverage as one JSON document: counts, ranges of executed code, the
+ * edges sorted by address and, with symbols, every symbol with its entry count and the
+ * number of executed addresses up to the next symbol
+ *
+ * @param coverage
+ * @param stream
+ * @param symbols NULL if no symbols are loaded
+ * @return bool False if out of memory
+ */
+bool coverageWriteJson(const Coverage_t *coverage, FILE *stream, const SymbolTable_t *symbols);
+
+/**
+ * @brief Writes the coverage as an lcov tracefile (genhtml, IDE coverage gutters). There are
+ * no source lines, line n stands for guest address n - 1 (lcov counts from 1). Symbols
+ * become functions, conditional branches become two branches: 0 taken, 1 not taken
+ *
+ * @param coverage
+ * @param stream
+ * @param sourceName Name for the SF record, usually the ROM file
+ * @param symbols NULL if no symbols are loaded
+ * @return bool False if out of memory
+ */
+bool coverageWriteLcov(const Coverage_t *coverage, FILE *stream, const char *sourceName,
+                       const SymbolTable_t *symbols);
+
+/**
+ * @brief Writes the coverage to a file, as an lcov tracefile if the name ends in ".info",
+ * as JSON otherwise
+ *
+ * @param coverage
+ * @param path
+ * @param sourceName Name for the SF record of the lcov tracefile
+ * @param symbols NULL if no symbols are loaded
+ * @return bool False if the file could not be written
+ */
+bool coverageSaveFile(const Coverage_t *coverage, const char *path, const char *sourceName,
+                      const SymbolTable_t *symbols);
+
+#endif // CILOGC80_COVERAGE_H
@@ -1,9 +1,31 @@
 #include "cpu/cpu.h"
 
 #include <stdbool.h>
+#include <stdio.h>
 
 #include "cpu/instructions.h"
 #include "cpu/instruction_handler.h"
+#include "cpu/opcode_profile.h"
+#include "cpu/host_profile.h"
+#include "cpu/pc_profile.h"
+#include "cpu/coverage.h"
+#include "trace/trace_ring.h"
+#include "utils/clock.h"
+
+/** @brief Backs the part of the ROM window an external ROM does not cover, read-only */
+static byte_t zeroRomPage[MEMORY_PAGE_SIZE];
+
+#if CILOGC80_OPCODE_PROFILE
+/**
+ * @brief Executes one instruction with the attached profiles: counts it in the opcode
+ * histogram, times it if a host cost sample is due, updates the guest PC profile, records
+ * it in the trace ring and marks it in the coverage map
+ *
+ * @param cpu
+ * @return int Cycles of the instruction
+ */
+static int executeProfiled(ZilogZ80_t *cpu);
+#endif
 
 void zilogZ80Init(ZilogZ80_t *cpu)
 {
@@ -43,8 +65,33 @@ void zilogZ80Init(ZilogZ80_t *cpu)
     cpu->frequency = 3.5f;
     cpu->frequencyFactor = 1000000; // 1MHz
 
-    memoryInit(&cpu->rom, 0x0000, 0x4000);
-    memoryInit(&cpu->ram, 0x8000, 0x8000);
+    memoryInit(&cpu->rom, CPU_ROM_START_ADDRESS, CPU_ROM_SIZE);
+    memoryInit(&cpu->ram, CPU_RAM_START_ADDRESS, CPU_RAM_SIZE);
+
+    memoryMapInit(&cpu->memoryMap);
+    memoryMapMapRegion(&cpu->memoryMap, cpu->rom.memoryStartAddress, cpu->rom.memorySize, cpu->rom.data, false);
+    memoryMapMapRegion(&cpu->memoryMap, cpu->ram.memoryStartAddress, cpu->ram.memorySize, cpu->ram.data, true);
+}
+
+void zilogZ80MapRom(ZilogZ80_t *cpu, byte_t *data, size_t size)
+{
+    if(cpu == NULL || data == NULL)
+    {
+        return;
+    }
+
+    size_t mappedSize = (size < CPU_ROM_SIZE) ? size : CPU_ROM_SIZE;
+
+    memoryMapUnmap(&cpu->memoryMap, CPU_ROM_START_ADDRESS, CPU_ROM_SIZE);
+    memoryMapMapRegion(&cpu->memoryMap, CPU_ROM_START_ADDRESS, mappedSize, data, false);
+    memoryAttach(&cpu->rom, data, mappedSize);
+
+    // Past a short image the window reads 0x00 like the zeroed private ROM buffer, not open bus
+    for(size_t offset = mappedSize; offset < CPU_ROM_SIZE; offset += MEMORY_PAGE_SIZE)
+    {
+        memoryMapMapRegion(&cpu->memoryMap, (word_t)(CPU_ROM_START_ADDRESS + offset), MEMORY_PAGE_SIZE,
+                           zeroRomPage, false);
+    }
 }
 
 void zilogZ80Reset(ZilogZ80_t *cpu)
@@ -77,14 +124,180 @@ void zilogZ80Reset(ZilogZ80_t *cpu)
     cpu->isHaltered = false;
 }
 
-void zilogZ80Step(ZilogZ80_t *cpu)
+int zilogZ80Step(ZilogZ80_t *cpu)
 {
+    int cycles = 0;
+
     if(cpu->isHaltered == false)
     {
-        int cycles = executeInstruction(cpu);
+        cpu->instructionPC = cpu->PC;
+
+#if CILOGC80_OPCODE_PROFILE
+        if(cpu->profile != NULL || cpu->hostProfile != NULL || cpu->pcProfile != NULL || cpu->trace != NULL
+           || cpu->coverage != NULL)
+        {
+            cycles = executeProfiled(cpu);
+        }
+        else
+        {
+            cycles = executeInstruction(cpu);
+        }
+#else
+        cycles = executeInstruction(cpu);
+#endif
         cpu->cyclesInFrame -= cycles;
         cpu->totalCycles += cycles;
-        int iterations = 0;
+    }
+
+    return cycles;
+}
+
+StopReason zilogZ80Run(ZilogZ80_t *cpu, long cycleBudget)
+{
+    MemoryMap_t *map = &cpu->memoryMap;
+    long cycles = 0;
+    long instructions = 0;
+
+    cpu->stopReason = STOP_REASON_NONE;
+    memoryMapClearHits(map);
+
+    while(cpu->stopReason == STOP_REASON_NONE)
+    {
+        if(cpu->isHaltered == true)
+        {
+            cpu->stopReason = STOP_REASON_HALT;
+            cpu->stopPC = cpu->instructionPC;
+            break;
+        }
+        if(cycles >= cycleBudget)
+        {
+            cpu->stopReason = STOP_REASON_BUDGET;
+            cpu->stopPC = cpu->PC;
+            break;
+        }
+
+        cycles += zilogZ80Step(cpu);
+        instructions++;
+
+        // Only pages with trap bits ever record hits, this is a single compare otherwise
+        if(map->pendingHitCount > 0)
+        {
+            for(size_t idx = 0; idx < map->pendingHitCount; idx++)
+            {
+                const WatchpointHit_t *hit = &map->pendingHits[idx];
+
+                if(hit->action == WATCHPOINT_ACTION_LOG)
+                {
+                    // Never stdout, that is where the tools put the guest output
+                    fprintf((cpu->watchpointLog != NULL) ? cpu->watchpointLog : stderr,
+                            "Watchpoint %d: %s 0x%04X = 0x%02X at PC 0x%04X\n", hit->watchpoint,
+                            (hit->access == WATCHPOINT_WRITE) ? "write" : "read",
+                            hit->address, hit->value, cpu->instructionPC);
+                }
+                else if(cpu->stopReason == STOP_REASON_NONE)
+                {
+                    cpu->stopReason = STOP_REASON_WATCHPOINT;
+                    cpu->stopPC = cpu->instructionPC;
+                    cpu->stopWatchpoint = *hit;
+                }
+            }
+            memoryMapClearHits(map);
+        }
+    }
+
+    cpu->runCycles = cycles;
+    cpu->runInstructions = instructions;
+
+    return cpu->stopReason;
+}
+
+void zilogZ80RequestStop(ZilogZ80_t *cpu)
+{
+    // The run loop only continues while no stop reason is set
+    if(cpu->stopReason == STOP_REASON_NONE)
+    {
+        cpu->stopReason = STOP_REASON_REQUESTED;
+        cpu->stopPC = cpu->instructionPC;
     }
 }
 
+const char *zilogZ80StopReasonName(StopReason stopReason)
+{
+    switch(stopReason)
+    {
+        case STOP_REASON_NONE:
+            return "none";
+        case STOP_REASON_BUDGET:
+            return "budget";
+        case STOP_REASON_HALT:
+            return "halt";
+        case STOP_REASON_WATCHPOINT:
+            return "watchpoint";
+        case STOP_REASON_REQUESTED:
+            return "requested";
+    }
+
+    return "unknown";
+}
+
+#if CILOGC80_OPCODE_PROFILE
+static int executeProfiled(ZilogZ80_t *cpu)
+{
+    // Decoded before executing, the instruction may overwrite itself
+    byte_t opcode;
+    OpcodeGroup group = opcodeProfileDecode(&cpu->memoryMap, cpu->PC, &opcode);
+    word_t previousSP = cpu->SP;
+    word_t pc = cpu->PC;
+    byte_t opcodeBytes[TRACE_OPCODE_BYTES];
+    int cycles;
+
+    if(cpu->trace != NULL)
+    {
+        for(int idx = 0; idx < TRACE_OPCODE_BYTES; idx++)
+        {
+            opcodeBytes[idx] = memoryMapPeekByte(&cpu->memoryMap, (word_t)(pc + idx));
+        }
+    }
+
+    if(cpu->hostProfile != NULL && hostProfileIsSampleDue(cpu->hostProfile) == true)
+    {
+        HostPathCost_t cost = { { 0 }, { 0 } };
+
+        cpu->memoryMap.hostCost = &cost;
+        qword_t startTicks = clockNowTicks();
+
+        cycles = executeInstruction(cpu);
+
+        qword_t ticks = clockNowTicks() - startTicks;
+        cpu->memoryMap.hostCost = NULL;
+
+        hostProfileRecord(cpu->hostProfile, group, opcode, ticks, &cost);
+    }
+    else
+    {
+        cycles = executeInstruction(cpu);
+    }
+
+    if(cpu->profile != NULL)
+    {
+        opcodeProfileRecord(cpu->profile, group, opcode, cycles);
+    }
+
+    if(cpu->pcProfile != NULL)
+    {
+        pcProfileStep(cpu->pcProfile, cpu, group, opcode, previousSP, cycles);
+    }
+
+    if(cpu->trace != NULL)
+    {
+        traceRingRecord(cpu->trace, cpu, pc, opcodeBytes, cycles);
+    }
+
+    if(cpu->coverage != NULL)
+    {
+        coverageRecord(cpu->coverage, pc, group, opcode, cpu->PC);
+    }
+
+    return cycles;
+}
+#endif
@@ -1,12 +1,21 @@
 #ifndef CILOG_C80_CPU_H
 #define CILOG_C80_CPU_H
 
+#include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdbool.h>
 
 #include "utils/utils.h"
 #include "memory/mem.h"
+#include "memory/memory_map.h"
+
+/** @brief Default ROM window */
+#define CPU_ROM_START_ADDRESS 0x0000
+#define CPU_ROM_SIZE 0x4000
+/** @brief Default RAM window */
+#define CPU_RAM_START_ADDRESS 0x8000
+#define CPU_RAM_SIZE 0x8000
 
 /**
  * @brief Flag struct containing all flags as bitfield
@@ -29,6 +38,29 @@ typedef struct F_t
     byte_t S : 1;
 } F_t;
 
+/**
+ * @brief Packs the flags into the F register layout (S Z - H - P N C)
+ *
+ * @param flags
+ * @return byte_t
+ */
+static inline byte_t zilogZ80FlagsToByte(F_t flags)
+{
+    return (byte_t)(flags.C | (flags.N << 1) | (flags.P << 2) | (flags.H << 4) | (flags.Z << 6) | (flags.S << 7));
+}
+
+/**
+ * @brief Unpacks an F register value (S Z - H - P N C)
+ *
+ * @param value
+ * @return F_t
+ */
+static inline F_t zilogZ80FlagsFromByte(byte_t value)
+{
+    return (F_t){ .C = value & 0x01, .N = (value >> 1) & 0x01, .P = (value >> 2) & 0x01,
+                  .H = (value >> 4) & 0x01, .Z = (value >> 6) & 0x01, .S = (value >> 7) & 0x01 };
+}
+
 /**
  * @brief Enum struct for defining the interrupt status
  */
@@ -48,6 +80,22 @@ typedef enum InterruptMode
     INTERRUPT_MODE_2
 } InterruptMode;
 
+/**
+ * @brief Enum struct for defining why the run loop returned
+ */
+typedef enum StopReason
+{
+    STOP_REASON_NONE = 0,
+    /** @brief The cycle budget was used up */
+    STOP_REASON_BUDGET,
+    /** @brief The CPU executed HALT */
+    STOP_REASON_HALT,
+    /** @brief A watchpoint with @ref WATCHPOINT_ACTION_BREAK was hit */
+    STOP_REASON_WATCHPOINT,
+    /** @brief The host called @ref zilogZ80RequestStop (e.g. from an I/O callback) */
+    STOP_REASON_REQUESTED
+} StopReason;
+
 /**
  * @brief Zilog Z80 processor struct containing all registers and flags
  */
@@ -100,10 +148,17 @@ typedef struct ZilogZ80_t
 
     byte_t I, R;
 
-    /** @brief Input callback */
-    void (*inputCallback[256])(byte_t* value);
-    /** @brief Output callback */
-    void (*outputCallback[256])(byte_t value);
+    /** @brief Input callback, NULL ports read as 0xFF */
+    void (*inputCallback[256])(void *context, byte_t* value);
+    /** @brief Output callback, writes to NULL ports are dropped */
+    void (*outputCallback[256])(void *context, byte_t value);
+    /** @brief Context passed to the I/O callbacks (usually the owning machine) */
+    void *ioContext;
+    /**
+     * @brief Context passed to the callbacks of a single port instead of ioContext (ports of the
+     * machine itself, e.g. bank registers), NULL for ioContext. Clear it when replacing such a callback
+     */
+    void *portContext[256];
 
     InterruptStatus interruptStatus;
     InterruptMode interruptMode;
@@ -119,11 +174,40 @@ typedef struct ZilogZ80_t
 
     bool isHaltered;
 
+    /** @brief Address of the instruction currently executed */
+    word_t instructionPC;
+
+    /** @brief Reason the last call of @ref zilogZ80Run returned */
+    StopReason stopReason;
+    /** @brief Cycles executed by the last call of @ref zilogZ80Run */
+    long runCycles;
+    /** @brief Instructions executed by the last call of @ref zilogZ80Run */
+    long runInstructions;
+    /** @brief Address of the instruction that caused the stop */
+    word_t stopPC;
+    /** @brief Watchpoint hit that caused the stop (STOP_REASON_WATCHPOINT only) */
+    WatchpointHit_t stopWatchpoint;
+    /** @brief Stream @ref WATCHPOINT_ACTION_LOG hits are written to by @ref zilogZ80Run, NULL for stderr */
+    FILE *watchpointLog;
 
     /** @brief RAM memory */
     Memory_t ram;
     /** @brief ROM memory */
     Memory_t rom;
+
+    /** @brief Page table of the address space seen by the CPU */
+    MemoryMap_t memoryMap;
+
+    /** @brief Opcode histogram filled by @ref zilogZ80Step, NULL disables it */
+    struct OpcodeProfile_t *profile;
+    /** @brief Host cost samples taken by @ref zilogZ80Step, NULL disables them */
+    struct HostProfile_t *hostProfile;
+    /** @brief Guest PC samples and shadow call stack kept by @ref zilogZ80Step, NULL disables them */
+    struct PcProfile_t *pcProfile;
+    /** @brief Ring every retired instruction is recorded into by @ref zilogZ80Step, NULL disables it */
+    struct TraceRing_t *trace;
+    /** @brief Executed addresses and branch edges recorded by @ref zilogZ80Step, NULL disables them */
+    struct Coverage_t *coverage;
 } ZilogZ80_t;
 
 /**
@@ -133,6 +217,18 @@ typedef struct ZilogZ80_t
  */
 void zilogZ80Init(ZilogZ80_t* cpu);
 
+/**
+ * @brief Replaces the private ROM buffer with external, read-only ROM storage (e.g. a memory
+ * mapped file or an image shared between machines). The ROM window of the page table points
+ * into the storage, the part of the window not covered by the storage reads as 0x00 (like the
+ * zeroed private buffer) and ignores writes
+ * 
+ * @param cpu 
+ * @param data ROM storage, has to outlive the CPU
+ * @param size Size of the storage (multiple of @ref MEMORY_PAGE_SIZE)
+ */
+void zilogZ80MapRom(ZilogZ80_t* cpu, byte_t* data, size_t size);
+
 /**
  * @brief Resets the CPU
  * 
@@ -144,9 +240,36 @@ void zilogZ80Reset(ZilogZ80_t* cpu);
  * @brief Fetches the next instruction and executes it
  * 
  * @param cpu 
- * @param memory 
+ * @return int Cycle count of the executed instruction (0 if the CPU is halted)
+ */
+int zilogZ80Step(ZilogZ80_t* cpu);
+
+/**
+ * @brief Executes instructions until the cycle budget is used up, the CPU halts or a
+ * watchpoint breaks. The reason and the faulting PC are stored in stopReason / stopPC.
+ * Watchpoints with @ref WATCHPOINT_ACTION_LOG are printed and execution continues
+ * 
+ * @param cpu 
+ * @param cycleBudget Number of cycles to run
+ * @return StopReason 
+ */
+StopReason zilogZ80Run(ZilogZ80_t* cpu, long cycleBudget);
+
+/**
+ * @brief Makes @ref zilogZ80Run return after the current instruction. Meant to be called
+ * from I/O callbacks, costs nothing while no stop is requested
+ *
+ * @param cpu
+ */
+void zilogZ80RequestStop(ZilogZ80_t* cpu);
+
+/**
+ * @brief Returns a short lower case name of a stop reason ("halt", "budget", ...)
+ * 
+ * @param stopReason 
+ * @return const char* 
  */
-void zilogZ80Step(ZilogZ80_t* cpu);
+const char *zilogZ80StopReasonName(StopReason stopReason);
 
 #endif // CILOG_C80_CPU_H
 
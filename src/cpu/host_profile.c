@@ -0,0 +1,262 @@
+#include "cpu/host_profile.h"
+
+#include <string.h>
+
+#include "utils/clock.h"
+
+/** @brief Counter reads used to find the cost of a timed region with nothing in it */
+#define TIMER_OVERHEAD_ROUNDS 256
+
+static const char *pathNames[HOST_PATH_COUNT] = { "slow memory", "memory handler", "I/O port" };
+
+/**
+ * @brief Draws the distance to the next sample, uniform in [interval / 2, interval * 3 / 2)
+ *
+ * @param profile
+ * @return int
+ */
+static int nextCountdown(HostProfile_t *profile);
+
+/**
+ * @brief Subtracts the counter overhead of a number of timed regions, never below 0
+ *
+ * @param profile
+ * @param ticks
+ * @param regions
+ * @return qword_t
+ */
+static qword_t withoutOverhead(const HostProfile_t *profile, qword_t ticks, qword_t regions);
+
+/**
+ * @brief qsort comparator of @ref HostProfileEntry_t, most host time first
+ */
+static int compareEntries(const void *first, const void *second);
+
+HostProfile_t *hostProfileCreate(int sampleInterval)
+{
+    if(sampleInterval < 1)
+    {
+        return NULL;
+    }
+
+    HostProfile_t *profile = (HostProfile_t *)malloc(sizeof(HostProfile_t));
+    if(profile == NULL)
+    {
+        return NULL;
+    }
+
+    qword_t overhead = 0;
+    for(int round = 0; round < TIMER_OVERHEAD_ROUNDS; round++)
+    {
+        qword_t start = clockNowTicks();
+        qword_t ticks = clockNowTicks() - start;
+
+        if(round == 0 || ticks < overhead)
+        {
+            overhead = ticks;
+        }
+    }
+
+    profile->sampleInterval = sampleInterval;
+    profile->timerOverhead = overhead;
+    profile->ticksPerNanosecond = clockTicksPerNanosecond();
+    hostProfileClear(profile);
+
+    return profile;
+}
+
+void hostProfileDestroy(HostProfile_t *profile)
+{
+    free(profile);
+}
+
+void hostProfileClear(HostProfile_t *profile)
+{
+    memset(profile->samples, 0x00, sizeof(profile->samples));
+    memset(profile->ticks, 0x00, sizeof(profile->ticks));
+    memset(profile->accessTicks, 0x00, sizeof(profile->accessTicks));
+    memset(&profile->paths, 0x00, sizeof(profile->paths));
+
+    profile->instructions = 0;
+    profile->sampledInstructions = 0;
+    profile->sampledTicks = 0;
+
+    profile->randomState = 0x2545F491;
+    profile->countdown = nextCountdown(profile);
+}
+
+void hostProfileRecord(HostProfile_t *profile, OpcodeGroup group, byte_t opcode, qword_t ticks,
+                       const HostPathCost_t *cost)
+{
+    qword_t accesses = 0;
+    qword_t accessTicks = 0;
+
+    for(int path = 0; path < HOST_PATH_COUNT; path++)
+    {
+        qword_t pathTicks = withoutOverhead(profile, cost->ticks[path], cost->accesses[path]);
+
+        profile->paths.accesses[path] += cost->accesses[path];
+        profile->paths.ticks[path] += pathTicks;
+        accesses += cost->accesses[path];
+        accessTicks += pathTicks;
+    }
+
+    // Every nested timed region adds its counter reads to the instruction as well
+    ticks = withoutOverhead(profile, ticks, accesses + 1);
+    if(accessTicks > ticks)
+    {
+        ticks = accessTicks;
+    }
+
+    profile->samples[group][opcode]++;
+    profile->ticks[group][opcode] += ticks;
+    profile->accessTicks[group][opcode] += accessTicks;
+    profile->sampledInstructions++;
+    profile->sampledTicks += ticks;
+
+    profile->countdown = nextCountdown(profile);
+}
+
+size_t hostProfileTop(const HostProfile_t *profile, HostProfileEntry_t *entries, size_t maxEntries)
+{
+    HostProfileEntry_t all[OPCODE_GROUP_COUNT * 0x100];
+    size_t count = 0;
+
+    for(int group = 0; group < OPCODE_GROUP_COUNT; group++)
+    {
+        for(int opcode = 0; opcode < 0x100; opcode++)
+        {
+            if(profile->samples[group][opcode] > 0)
+            {
+                all[count].group = (OpcodeGroup)group;
+                all[count].opcode = (byte_t)opcode;
+                all[count].samples = profile->samples[group][opcode];
+                all[count].ticks = profile->ticks[group][opcode];
+                all[count].accessTicks = profile->accessTicks[group][opcode];
+                count++;
+            }
+        }
+    }
+
+    qsort(all, count, sizeof(HostProfileEntry_t), compareEntries);
+
+    count = (count < maxEntries) ? count : maxEntries;
+    memcpy(entries, all, count * sizeof(HostProfileEntry_t));
+
+    return count;
+}
+
+void hostProfileShares(const HostProfile_t *profile, double *executeShare, double *pathShares)
+{
+    double total = (profile->sampledTicks > 0) ? (double)profile->sampledTicks : 1.0;
+    qword_t pathTicks = 0;
+
+    for(int path = 0; path < HOST_PATH_COUNT; path++)
+    {
+        pathShares[path] = (double)profile->paths.ticks[path] / total;
+        pathTicks += profile->paths.ticks[path];
+    }
+
+    *executeShare = (profile->sampledTicks > pathTicks) ? (double)(profile->sampledTicks - pathTicks) / total : 0.0;
+}
+
+void hostProfileDump(FILE *stream, const HostProfile_t *profile, size_t limit)
+{
+    HostProfileEntry_t *entries = (HostProfileEntry_t *)malloc(limit * sizeof(HostProfileEntry_t));
+    double pathShares[HOST_PATH_COUNT];
+    double executeShare;
+    char opcode[16];
+
+    if(entries == NULL)
+    {
+        return;
+    }
+
+    double ticksPerNanosecond = (profile->ticksPerNanosecond > 0.0) ? profile->ticksPerNanosecond : 1.0;
+    double samples = (profile->sampledInstructions > 0) ? (double)profile->sampledInstructions : 1.0;
+    double total = (profile->sampledTicks > 0) ? (double)profile->sampledTicks : 1.0;
+
+    hostProfileShares(profile, &executeShare, pathShares);
+
+    fprintf(stream, "instructions: %llu, sampled: %llu, %.1f ns per instruction (%.2f ticks/ns)\n\n",
+            (unsigned long long)profile->instructions, (unsigned long long)profile->sampledInstructions,
+            total / samples / ticksPerNanosecond, ticksPerNanosecond);
+
+    fprintf(stream, "%-16s %12s %8s %12s\n", "path", "accesses", "% host", "ns/access");
+    fprintf(stream, "%-16s %12s %7.2f%% %12s\n", "execute", "-", executeShare * 100.0, "-");
+    for(int path = 0; path < HOST_PATH_COUNT; path++)
+    {
+        qword_t accesses = profile->paths.accesses[path];
+
+        fprintf(stream, "%-16s %12llu %7.2f%% %12.1f\n", pathNames[path], (unsigned long long)accesses,
+                pathShares[path] * 100.0,
+                (accesses > 0) ? (double)profile->paths.ticks[path] / (double)accesses / ticksPerNanosecond : 0.0);
+    }
+
+    // Fast path memory accesses are too cheap to time on their own, they count as execution
+    double memoryShare = pathShares[HOST_PATH_SLOW_MEMORY];
+    double deviceShare = pathShares[HOST_PATH_MEMORY_HANDLER] + pathShares[HOST_PATH_IO_PORT];
+    const char *verdict = (deviceShare >= executeShare && deviceShare >= memoryShare) ? "device"
+                        : (memoryShare >= executeShare) ? "memory"
+                        : "dispatch";
+
+    if(profile->sampledInstructions > 0)
+    {
+        fprintf(stream, "\n%s bound\n\n", verdict);
+    }
+    else
+    {
+        fprintf(stream, "\nnothing sampled\n\n");
+    }
+
+    fprintf(stream, "%-12s %10s %8s %10s %8s\n", "opcode", "samples", "% host", "ns/exec", "% access");
+
+    size_t count = hostProfileTop(profile, entries, limit);
+    for(size_t idx = 0; idx < count; idx++)
+    {
+        const HostProfileEntry_t *entry = &entries[idx];
+
+        fprintf(stream, "%-12s %10llu %7.2f%% %10.1f %7.2f%%\n",
+                opcodeProfileFormat(entry->group, entry->opcode, opcode, sizeof(opcode)),
+                (unsigned long long)entry->samples, (double)entry->ticks / total * 100.0,
+                (double)entry->ticks / (double)entry->samples / ticksPerNanosecond,
+                (entry->ticks > 0) ? (double)entry->accessTicks / (double)entry->ticks * 100.0 : 0.0);
+    }
+
+    free(entries);
+}
+
+const char *hostPathName(HostPath path)
+{
+    return (path >= 0 && path < HOST_PATH_COUNT) ? pathNames[path] : "unknown";
+}
+
+static int nextCountdown(HostProfile_t *profile)
+{
+    if(profile->sampleInterval <= 1)
+    {
+        return 1;
+    }
+
+    // xorshift32
+    profile->randomState ^= profile->randomState << 13;
+    profile->randomState ^= profile->randomState >> 17;
+    profile->randomState ^= profile->randomState << 5;
+
+    return profile->sampleInterval / 2 + (int)(profile->randomState % (unsigned int)profile->sampleInterval);
+}
+
+static qword_t withoutOverhead(const HostProfile_t *profile, qword_t ticks, qword_t regions)
+{
+    qword_t overhead = profile->timerOverhead * regions;
+
+    return (ticks > overhead) ? ticks - overhead : 0;
+}
+
+static int compareEntries(const void *first, const void *second)
+{
+    qword_t a = ((const HostProfileEntry_t *)first)->ticks;
+    qword_t b = ((const HostProfileEntry_t *)second)->ticks;
+
+    return (a < b) - (a > b);
+}
@@ -0,0 +1,144 @@
+#ifndef CILOGC80_HOST_PROFILE_H
+#define CILOGC80_HOST_PROFILE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "utils/utils.h"
+#include "utils/host_cost.h"
+#include "cpu/opcode_profile.h"
+
+/** @brief Default mean distance between two sampled instructions */
+#define HOST_PROFILE_DEFAULT_INTERVAL 97
+
+/**
+ * @brief Host cycles (@ref clockNowTicks) spent executing sampled guest instructions. Only about
+ * one instruction in sampleInterval is timed, the distance is jittered so loops whose length
+ * divides the interval are not sampled at the same spot every time
+ */
+typedef struct HostProfile_t
+{
+    int sampleInterval;
+    /** @brief Instructions left until the next sample */
+    int countdown;
+    unsigned int randomState;
+
+    /** @brief Cost of reading the counter twice, subtracted from every timed region */
+    qword_t timerOverhead;
+    /** @brief Calibrated counter rate, converts ticks to nanoseconds */
+    double ticksPerNanosecond;
+
+    qword_t samples[OPCODE_GROUP_COUNT][0x100];
+    /** @brief Whole instruction, access paths included */
+    qword_t ticks[OPCODE_GROUP_COUNT][0x100];
+    /** @brief Part of ticks spent on the slow memory path, memory handlers and I/O ports */
+    qword_t accessTicks[OPCODE_GROUP_COUNT][0x100];
+
+    /** @brief Access path totals of all samples */
+    HostPathCost_t paths;
+
+    /** @brief Every instruction executed while attached, sampled or not */
+    qword_t instructions;
+    qword_t sampledInstructions;
+    qword_t sampledTicks;
+} HostProfile_t;
+
+/**
+ * @brief One row of @ref hostProfileTop
+ */
+typedef struct HostProfileEntry_t
+{
+    OpcodeGroup group;
+    byte_t opcode;
+    qword_t samples;
+    qword_t ticks;
+    qword_t accessTicks;
+} HostProfileEntry_t;
+
+/**
+ * @brief Allocates a cleared profile and calibrates the counter (takes a few milliseconds)
+ *
+ * @param sampleInterval Mean instructions per sample, 1 times every instruction
+ * @return HostProfile_t* NULL if out of memory or sampleInterval < 1
+ */
+HostProfile_t *hostProfileCreate(int sampleInterval);
+
+/**
+ * @brief Frees a profile (detach it from the CPU first)
+ *
+ * @param profile
+ */
+void hostProfileDestroy(HostProfile_t *profile);
+
+/**
+ * @brief Resets all counters, the calibration is kept
+ *
+ * @param profile
+ */
+void hostProfileClear(HostProfile_t *profile);
+
+/**
+ * @brief Counts an instruction and tells whether it is to be timed
+ *
+ * @param profile
+ * @return bool
+ */
+static inline bool hostProfileIsSampleDue(HostProfile_t *profile)
+{
+    profile->instructions++;
+
+    return --profile->countdown <= 0;
+}
+
+/**
+ * @brief Records a timed instruction and schedules the next sample
+ *
+ * @param profile
+ * @param group
+ * @param opcode
+ * @param ticks Counter difference around the execution
+ * @param cost Access paths timed during the execution
+ */
+void hostProfileRecord(HostProfile_t *profile, OpcodeGroup group, byte_t opcode, qword_t ticks,
+                       const HostPathCost_t *cost);
+
+/**
+ * @brief Returns the opcodes with the most host time, most expensive first
+ *
+ * @param profile
+ * @param entries Destination
+ * @param maxEntries
+ * @return size_t Number of entries written (opcodes never sampled are left out)
+ */
+size_t hostProfileTop(const HostProfile_t *profile, HostProfileEntry_t *entries, size_t maxEntries);
+
+/**
+ * @brief Share of the sampled host time spent in the execution itself (dispatch, ALU and
+ * fast path memory accesses) and on every access path
+ *
+ * @param profile
+ * @param executeShare
+ * @param pathShares HOST_PATH_COUNT shares
+ */
+void hostProfileShares(const HostProfile_t *profile, double *executeShare, double *pathShares);
+
+/**
+ * @brief Prints where the host time goes: the access paths, the verdict (dispatch, memory or
+ * device bound) and the most expensive opcodes
+ *
+ * @param stream
+ * @param profile
+ * @param limit Rows of the opcode table
+ */
+void hostProfileDump(FILE *stream, const HostProfile_t *profile, size_t limit);
+
+/**
+ * @brief Returns the name of an access path ("slow memory", "memory handler", "I/O port")
+ *
+ * @param path
+ * @return const char*
+ */
+const char *hostPathName(HostPath path);
+
+#endif // CILOGC80_HOST_PROFILE_H
@@ -3,8 +3,10 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include "cpu/cpu.h"
+#include "cpu/alu.h"
 #include "utils/utils.h"
 
+#include "utils/clock.h"
 #include "utils/error_handler.h"
 
 #define MAX_INSTRUCTION_COUNT 256
@@ -49,6 +51,13 @@ static bool calculateParity(word_t value);
  * @param isSubstraction Flag to indicate if the operation is a substraction
  */
 static void setFlags(ZilogZ80_t *cpu, byte_t regA, byte_t operand, word_t result, bool isSubstraction);
+/**
+ * @brief Set the documented flags (S, Z, H, P, N, C) from a value in the F register layout
+ * 
+ * @param cpu 
+ * @param flags See ALU_FLAG_*
+ */
+static void applyFlags(ZilogZ80_t *cpu, byte_t flags);
 /**
  * @brief Set the Flags of the CPU depending on the result of an operation with a word
  * 
@@ -221,6 +230,23 @@ static void rst(ZilogZ80_t *cpu, byte_t address);
  */
 static void exWordHelper(ZilogZ80_t *cpu, word_t *reg1, word_t *reg2);
 
+/**
+ * @brief Reads a value from an I/O port. Ports without a device read as 0xFF
+ * 
+ * @param cpu 
+ * @param port 
+ * @param value 
+ */
+static void portRead(ZilogZ80_t *cpu, byte_t port, byte_t *value);
+/**
+ * @brief Writes a value to an I/O port. Writes to ports without a device are dropped
+ * 
+ * @param cpu 
+ * @param port 
+ * @param value 
+ */
+static void portWrite(ZilogZ80_t *cpu, byte_t port, byte_t value);
+
 // TODO: Document this function
 static void ld(ZilogZ80_t *cpu, byte_t *reg, byte_t value);
 static void ldPair(ZilogZ80_t *cpu, byte_t *upperByte, byte_t *lowerByte, word_t value);
@@ -2517,15 +2543,14 @@ static const InstructionHandler_t miscInstructionTable[MAX_INSTRUCTION_COUNT] =
 
 int executeInstruction(ZilogZ80_t *cpu)
 {
-    cpu->currentOpcode = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    cpu->currentOpcode = memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     cpu->PC++;
 
     int cycles = mainInstructionTable[cpu->currentOpcode](cpu);
 
     cpu->currentCycles = cycles;
-    cpu->totalCycles += cycles;
 
-    return 0;
+    return cycles;
 }
 
 
@@ -2576,12 +2601,16 @@ static bool calculateParity(word_t value)
 
 static void setFlags(ZilogZ80_t *cpu, byte_t regA, byte_t operand, word_t result, bool isSubstraction)
 {
-    cpu->F.Z = (result & 0xFF) == 0;
-    cpu->F.S = (result & 0x80) >> 7;
-    cpu->F.H = isSubstraction ? ((regA & 0x0F) - (operand & 0x0F)) < 0 : ((regA & 0x0F) + (operand & 0x0F)) > 0x0F;
-    cpu->F.P = calculateParity(result & 0xFF);
-    cpu->F.N = isSubstraction;
-    cpu->F.C = result > 0xFF;
+    applyFlags(cpu, aluFlags(regA, operand, result, isSubstraction));
+}
+static void applyFlags(ZilogZ80_t *cpu, byte_t flags)
+{
+    cpu->F.Z = (flags & ALU_FLAG_Z) != 0;
+    cpu->F.S = (flags & ALU_FLAG_S) != 0;
+    cpu->F.H = (flags & ALU_FLAG_H) != 0;
+    cpu->F.P = (flags & ALU_FLAG_P) != 0;
+    cpu->F.N = (flags & ALU_FLAG_N) != 0;
+    cpu->F.C = (flags & ALU_FLAG_C) != 0;
 }
 static void setFlagsWord(ZilogZ80_t *cpu, word_t reg1, word_t reg2, dword_t result)
 {
@@ -2624,9 +2653,8 @@ static void addToRegisterPairWithCarry(ZilogZ80_t *cpu, word_t value1, word_t va
 }
 static void incrementRegister(ZilogZ80_t *cpu, byte_t *reg)
 {
-    word_t result = (word_t)(*reg + 1);
-    setFlags(cpu, *reg, 1, result, false);
-    *reg = result & 0xFF;
+    applyFlags(cpu, aluIncDecFlags(*reg, false, zilogZ80FlagsToByte(cpu->F)));
+    *reg = (byte_t)(*reg + 1);
 }
 static void incrementRegisterPair(ZilogZ80_t *cpu, byte_t* upperByte, byte_t* lowerByte)
 {
@@ -2656,9 +2684,8 @@ static void subtractFromRegisterPairWithCarry(ZilogZ80_t *cpu, word_t val1, word
 }
 static void decrementRegister(ZilogZ80_t *cpu, byte_t *reg)
 {
-    word_t result = (word_t)(*reg - 1);
-    setFlags(cpu, *reg, 1, result, true);
-    *reg = result & 0xFF;
+    applyFlags(cpu, aluIncDecFlags(*reg, true, zilogZ80FlagsToByte(cpu->F)));
+    *reg = (byte_t)(*reg - 1);
 }
 static void decrementRegisterPair(ZilogZ80_t *cpu, byte_t* upperByte, byte_t* lowerByte)
 {
@@ -2669,21 +2696,18 @@ static void decrementRegisterPair(ZilogZ80_t *cpu, byte_t* upperByte, byte_t* lo
 
 static void andWithRegister(ZilogZ80_t *cpu, byte_t value)
 {
-    word_t result = (word_t)(cpu->A & value);
-    setFlags(cpu, cpu->A, value, result, false);
-    cpu->A = result & 0xFF;
+    cpu->A = (byte_t)(cpu->A & value);
+    applyFlags(cpu, aluLogicFlags(cpu->A, true));
 }
 static void orWithRegister(ZilogZ80_t *cpu, byte_t value)
 {
-    word_t result = (word_t)(cpu->A | value);
-    setFlags(cpu, cpu->A, value, result, false);
-    cpu->A = result & 0xFF;
+    cpu->A = (byte_t)(cpu->A | value);
+    applyFlags(cpu, aluLogicFlags(cpu->A, false));
 }
 static void xorWithRegister(ZilogZ80_t *cpu, byte_t value)
 {
-    word_t result = (word_t)(cpu->A ^ value);
-    setFlags(cpu, cpu->A, value, result, false);
-    cpu->A = result & 0xFF;
+    cpu->A = (byte_t)(cpu->A ^ value);
+    applyFlags(cpu, aluLogicFlags(cpu->A, false));
 }
 static void cpWithRegister(ZilogZ80_t *cpu, byte_t value)
 {
@@ -2693,14 +2717,14 @@ static void cpWithRegister(ZilogZ80_t *cpu, byte_t value)
 
 static void pushWord(ZilogZ80_t *cpu, word_t value)
 {
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, cpu->SP - 1, UPPER_BYTE(value));
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, cpu->SP - 2, LOWER_BYTE(value));
+    memoryMapWriteByte(&cpu->memoryMap, cpu->SP - 1, UPPER_BYTE(value));
+    memoryMapWriteByte(&cpu->memoryMap, cpu->SP - 2, LOWER_BYTE(value));
     cpu->SP -= 2;
 }
 static void popWord(ZilogZ80_t *cpu, byte_t *upperByte, byte_t *lowerByte)
 {
-    *lowerByte = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->SP);
-    *upperByte = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->SP + 1);
+    *lowerByte = memoryMapReadByte(&cpu->memoryMap, cpu->SP);
+    *upperByte = memoryMapReadByte(&cpu->memoryMap, cpu->SP + 1);
     cpu->SP += 2;
 }
 
@@ -2722,7 +2746,7 @@ static int returnHelper(ZilogZ80_t *cpu, bool condition)
 static int callHelper(ZilogZ80_t *cpu, bool condition)
 {
     int cycles = 10;
-    word_t address = fetchWordAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    word_t address = memoryMapReadWord(&cpu->memoryMap, cpu->PC);
     cpu->PC += 2;
 
     if(condition)
@@ -2738,9 +2762,11 @@ static int callHelper(ZilogZ80_t *cpu, bool condition)
 
 static int jumpHelper(ZilogZ80_t *cpu, bool condition)
 {
+    word_t address = memoryMapReadWord(&cpu->memoryMap, cpu->PC);
+    cpu->PC += 2;
+
     if(condition)
     {
-        word_t address = fetchWordAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
         cpu->PC = address;
     }
 
@@ -2750,9 +2776,12 @@ static int jumpRelativeHelper(ZilogZ80_t *cpu, bool condition)
 {
     int cycles = 7;
 
+    // Signed displacement, relative to the address after the instruction
+    int8_t offset = (int8_t)memoryMapReadByte(&cpu->memoryMap, cpu->PC);
+    cpu->PC++;
+
     if(condition)
     {
-        byte_t offset = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
         cpu->PC += offset;
         cycles = 12;
     }
@@ -2773,6 +2802,44 @@ static void exWordHelper(ZilogZ80_t *cpu, word_t *reg1, word_t *reg2)
     *reg2 = temp;
 }
 
+static void portRead(ZilogZ80_t *cpu, byte_t port, byte_t *value)
+{
+    if(cpu->inputCallback[port] == NULL)
+    {
+        *value = 0xFF;
+        return;
+    }
+
+    // The host cost profiler attaches its record to the memory map, ports report into it too
+    HostPathCost_t *hostCost = cpu->memoryMap.hostCost;
+    qword_t startTicks = (hostCost != NULL) ? clockNowTicks() : 0;
+
+    cpu->inputCallback[port]((cpu->portContext[port] != NULL) ? cpu->portContext[port] : cpu->ioContext, value);
+
+    if(hostCost != NULL)
+    {
+        hostCost->accesses[HOST_PATH_IO_PORT]++;
+        hostCost->ticks[HOST_PATH_IO_PORT] += clockNowTicks() - startTicks;
+    }
+}
+
+static void portWrite(ZilogZ80_t *cpu, byte_t port, byte_t value)
+{
+    if(cpu->outputCallback[port] != NULL)
+    {
+        HostPathCost_t *hostCost = cpu->memoryMap.hostCost;
+        qword_t startTicks = (hostCost != NULL) ? clockNowTicks() : 0;
+
+        cpu->outputCallback[port]((cpu->portContext[port] != NULL) ? cpu->portContext[port] : cpu->ioContext, value);
+
+        if(hostCost != NULL)
+        {
+            hostCost->accesses[HOST_PATH_IO_PORT]++;
+            hostCost->ticks[HOST_PATH_IO_PORT] += clockNowTicks() - startTicks;
+        }
+    }
+}
+
 static void ld(ZilogZ80_t *cpu, byte_t *reg, byte_t value)
 {
     *reg = value;
@@ -2831,7 +2898,7 @@ static int add_hl_sp_imm(ZilogZ80_t *cpu)
 
 static int add_a_n(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     addToRegister(cpu, &cpu->A, val);
     cpu->PC++;
     return 7;
@@ -2873,7 +2940,7 @@ static int add_a_l(ZilogZ80_t *cpu)
 }
 static int add_a_hl_addr(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
     addToRegister(cpu, &cpu->A, val);
     cpu->PC++;
     return 7;
@@ -2883,7 +2950,7 @@ static int add_a_hl_addr(ZilogZ80_t *cpu)
 // ADC      -----------------------------------------------------------------------------
 static int adc_a_n(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     addToRegisterWithCarry(cpu, &cpu->A, val);
     cpu->PC++;
     return 7;
@@ -2895,37 +2962,37 @@ static int adc_a_a(ZilogZ80_t *cpu)
 }
 static int adc_a_b(ZilogZ80_t *cpu)
 {
-    addToRegisterWithCarry(cpu, &cpu->A, cpu->A);
+    addToRegisterWithCarry(cpu, &cpu->A, cpu->B);
     return 4;
 }
 static int adc_a_c(ZilogZ80_t *cpu)
 {
-    addToRegisterWithCarry(cpu, &cpu->A, cpu->A);
+    addToRegisterWithCarry(cpu, &cpu->A, cpu->C);
     return 4;
 }
 static int adc_a_d(ZilogZ80_t *cpu)
 {
-    addToRegisterWithCarry(cpu, &cpu->A, cpu->A);
+    addToRegisterWithCarry(cpu, &cpu->A, cpu->D);
     return 4;
 }
 static int adc_a_e(ZilogZ80_t *cpu)
 {
-    addToRegisterWithCarry(cpu, &cpu->A, cpu->A);
+    addToRegisterWithCarry(cpu, &cpu->A, cpu->E);
     return 4;
 }
 static int adc_a_h(ZilogZ80_t *cpu)
 {
-    addToRegisterWithCarry(cpu, &cpu->A, cpu->A);
+    addToRegisterWithCarry(cpu, &cpu->A, cpu->H);
     return 4;
 }
 static int adc_a_l(ZilogZ80_t *cpu)
 {
-    addToRegisterWithCarry(cpu, &cpu->A, cpu->A);
+    addToRegisterWithCarry(cpu, &cpu->A, cpu->L);
     return 4;
 }
 static int adc_a_hl_addr(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
     addToRegisterWithCarry(cpu, &cpu->A, val);
     cpu->PC++;
     return 7;
@@ -3017,10 +3084,10 @@ static int inc_l(ZilogZ80_t *cpu)
 }
 static int inc_hl_addr(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
     cpu->PC++;
     incrementRegister(cpu, &val);
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L), val);
+    memoryMapWriteByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L), val);
     cpu->PC++;
     return 11;
 }
@@ -3028,7 +3095,7 @@ static int inc_hl_addr(ZilogZ80_t *cpu)
 // SUB      -----------------------------------------------------------------------------
 static int sub_n(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     subtractFromRegister(cpu, val);
     cpu->PC++;
     return 7;
@@ -3070,7 +3137,7 @@ static int sub_l(ZilogZ80_t *cpu)
 }
 static int sub_hl_addr(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
     subtractFromRegister(cpu, val);
     cpu->PC++;
     return 7;
@@ -3079,7 +3146,7 @@ static int sub_hl_addr(ZilogZ80_t *cpu)
 // SBC      -----------------------------------------------------------------------------
 static int sbc_a_n(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     subtractFromRegisterWithCarry(cpu, val);
     cpu->PC++;
     return 7;
@@ -3121,7 +3188,7 @@ static int sbc_l(ZilogZ80_t *cpu)
 }
 static int sbc_hl_addr(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
     subtractFromRegisterWithCarry(cpu, val);
     cpu->PC++;
     return 7;
@@ -3211,10 +3278,10 @@ static int dec_l(ZilogZ80_t *cpu)
 }
 static int dec_hl_addr(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
     cpu->PC++;
     decrementRegister(cpu, &val);
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L), val);
+    memoryMapWriteByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L), val);
     cpu->PC++;
     return 11;
 }
@@ -3222,7 +3289,7 @@ static int dec_hl_addr(ZilogZ80_t *cpu)
 // AND      -----------------------------------------------------------------------------
 static int and_n(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     andWithRegister(cpu, val);
     cpu->PC++;
     return 7;
@@ -3264,7 +3331,7 @@ static int and_l(ZilogZ80_t *cpu)
 }
 static int and_hl_addr(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
     andWithRegister(cpu, val);
     cpu->PC++;
     return 7;
@@ -3273,7 +3340,7 @@ static int and_hl_addr(ZilogZ80_t *cpu)
 // OR       -----------------------------------------------------------------------------
 static int or_n(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     orWithRegister(cpu, val);
     cpu->PC++;
     return 7;
@@ -3315,7 +3382,7 @@ static int or_l(ZilogZ80_t *cpu)
 }
 static int or_hl_addr(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
     andWithRegister(cpu, val);
     cpu->PC++;
     return 7;
@@ -3324,7 +3391,7 @@ static int or_hl_addr(ZilogZ80_t *cpu)
 // XOR      -----------------------------------------------------------------------------
 static int xor_n(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     xorWithRegister(cpu, val);
     cpu->PC++;
     return 7;
@@ -3366,7 +3433,7 @@ static int xor_l(ZilogZ80_t *cpu)
 }
 static int xor_hl_addr(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
     xorWithRegister(cpu, val);
     cpu->PC++;
     return 7;
@@ -3375,7 +3442,7 @@ static int xor_hl_addr(ZilogZ80_t *cpu)
 // CP       -----------------------------------------------------------------------------
 static int cp_n(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     cpWithRegister(cpu, val);
     cpu->PC++;
     return 7;
@@ -3387,44 +3454,44 @@ static int cp_a(ZilogZ80_t *cpu)
 }
 static int cp_b(ZilogZ80_t *cpu)
 {
-    cpWithRegister(cpu, cpu->A);
+    cpWithRegister(cpu, cpu->B);
     return 4;
 }
 static int cp_c(ZilogZ80_t *cpu)
 {
-    cpWithRegister(cpu, cpu->A);
+    cpWithRegister(cpu, cpu->C);
     return 4;
 }
 static int cp_d(ZilogZ80_t *cpu)
 {
-    cpWithRegister(cpu, cpu->A);
+    cpWithRegister(cpu, cpu->D);
     return 4;
 }
 static int cp_e(ZilogZ80_t *cpu)
 {
-    cpWithRegister(cpu, cpu->A);
+    cpWithRegister(cpu, cpu->E);
     return 4;
 }
 static int cp_h(ZilogZ80_t *cpu)
 {
-    cpWithRegister(cpu, cpu->A);
+    cpWithRegister(cpu, cpu->H);
     return 4;
 }
 static int cp_l(ZilogZ80_t *cpu)
 {
-    cpWithRegister(cpu, cpu->A);
+    cpWithRegister(cpu, cpu->L);
     return 4;
 }
 static int cp_hl_addr(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
     cpWithRegister(cpu, val);
     cpu->PC++;
     return 7;
 }
 static int cpi(ZilogZ80_t *cpu)
 {
-    byte_t value = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t value = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
 
     andWithRegister(cpu, value);
 
@@ -3443,7 +3510,7 @@ static int cpir(ZilogZ80_t *cpu)
 }
 static int cpd(ZilogZ80_t *cpu)
 {
-    byte_t value = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t value = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
 
     andWithRegister(cpu, value);
 
@@ -3897,11 +3964,11 @@ static int ex_sp_hl_addr(ZilogZ80_t *cpu)
 {
     word_t address = cpu->SP;
 
-    byte_t lowerByte = fetchByteAddressSpace(&cpu->ram, &cpu->rom, address);
-    byte_t upperByte = fetchByteAddressSpace(&cpu->ram, &cpu->rom, address + 1);
+    byte_t lowerByte = memoryMapReadByte(&cpu->memoryMap, address);
+    byte_t upperByte = memoryMapReadByte(&cpu->memoryMap, address + 1);
 
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, address, cpu->L);
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, address + 1, cpu->H);
+    memoryMapWriteByte(&cpu->memoryMap, address, cpu->L);
+    memoryMapWriteByte(&cpu->memoryMap, address + 1, cpu->H);
 
     cpu->H = upperByte;
     cpu->L = lowerByte;
@@ -3924,7 +3991,7 @@ static int ex_de_hl(ZilogZ80_t *cpu)
 // LD       -----------------------------------------------------------------------------
 static int ld_a_n(ZilogZ80_t *cpu)
 {
-    cpu->A = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    cpu->A = memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     cpu->PC++;
     return 7;
 }
@@ -3965,14 +4032,14 @@ static int ld_a_l(ZilogZ80_t *cpu)
 }
 static int ld_a_hl_addr(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
     cpu->A = val;
     return 7;
 }
 
 static int ld_b_n(ZilogZ80_t *cpu)
 {
-    cpu->B = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    cpu->B = memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     cpu->PC++;
     return 7;
 }
@@ -4013,7 +4080,7 @@ static int ld_b_l(ZilogZ80_t *cpu)
 }
 static int ld_b_hl_addr(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
     cpu->B = val;
     cpu->PC++;
     return 7;
@@ -4021,7 +4088,7 @@ static int ld_b_hl_addr(ZilogZ80_t *cpu)
 
 static int ld_c_n(ZilogZ80_t *cpu)
 {
-    cpu->C = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    cpu->C = memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     cpu->PC++;
     return 7;
 }
@@ -4062,7 +4129,7 @@ static int ld_c_l(ZilogZ80_t *cpu)
 }
 static int ld_c_hl_addr(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
     cpu->C = val;
     cpu->PC++;
     return 7;
@@ -4070,7 +4137,7 @@ static int ld_c_hl_addr(ZilogZ80_t *cpu)
 
 static int ld_d_n(ZilogZ80_t *cpu)
 {
-    cpu->D = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    cpu->D = memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     cpu->PC++;
     return 7;
 }
@@ -4111,7 +4178,7 @@ static int ld_d_l(ZilogZ80_t *cpu)
 }
 static int ld_d_hl_addr(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
     cpu->D = val;
     cpu->PC++;
     return 7;
@@ -4119,7 +4186,7 @@ static int ld_d_hl_addr(ZilogZ80_t *cpu)
 
 static int ld_e_n(ZilogZ80_t *cpu)
 {
-    cpu->E = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    cpu->E = memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     cpu->PC++;
     return 7;
 }
@@ -4160,7 +4227,7 @@ static int ld_e_l(ZilogZ80_t *cpu)
 }
 static int ld_e_hl_addr(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
     cpu->E = val;
     cpu->PC++;
     return 7;
@@ -4168,7 +4235,7 @@ static int ld_e_hl_addr(ZilogZ80_t *cpu)
 
 static int ld_h_n(ZilogZ80_t *cpu)
 {
-    cpu->H = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    cpu->H = memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     cpu->PC++;
     return 7;
 }
@@ -4209,7 +4276,7 @@ static int ld_h_l(ZilogZ80_t *cpu)
 }
 static int ld_h_hl_addr(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
     cpu->H = val;
     cpu->PC++;
     return 7;
@@ -4217,7 +4284,7 @@ static int ld_h_hl_addr(ZilogZ80_t *cpu)
 
 static int ld_l_n(ZilogZ80_t *cpu)
 {
-    cpu->L = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    cpu->L = memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     cpu->PC++;
     return 7;
 }
@@ -4258,7 +4325,7 @@ static int ld_l_l(ZilogZ80_t *cpu)
 }
 static int ld_l_hl_addr(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
     cpu->L = val;
     cpu->PC++;
     return 7;
@@ -4266,59 +4333,59 @@ static int ld_l_hl_addr(ZilogZ80_t *cpu)
 
 static int ld_hl_n_addr(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L), val);
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, cpu->PC);
+    memoryMapWriteByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L), val);
     cpu->PC++;
     return 10;
 }
 static int ld_hl_a_addr(ZilogZ80_t *cpu)
 {
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L), cpu->A);
+    memoryMapWriteByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L), cpu->A);
     return 7;
 }
 static int ld_hl_b_addr(ZilogZ80_t *cpu)
 {
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L), cpu->B);
+    memoryMapWriteByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L), cpu->B);
     return 7;
 }
 static int ld_hl_c_addr(ZilogZ80_t *cpu)
 {
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L), cpu->C);
+    memoryMapWriteByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L), cpu->C);
     return 7;
 }
 static int ld_hl_d_addr(ZilogZ80_t *cpu)
 {
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L), cpu->D);
+    memoryMapWriteByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L), cpu->D);
     return 7;
 }
 static int ld_hl_e_addr(ZilogZ80_t *cpu)
 {
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L), cpu->E);
+    memoryMapWriteByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L), cpu->E);
     return 7;
 }
 static int ld_hl_h_addr(ZilogZ80_t *cpu)
 {
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L), cpu->H);
+    memoryMapWriteByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L), cpu->H);
     return 7;
 }
 static int ld_hl_l_addr(ZilogZ80_t *cpu)
 {
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L), cpu->L);
+    memoryMapWriteByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L), cpu->L);
     return 7;
 }
 static int ld_hl_hl_addr(ZilogZ80_t *cpu)
 {
-    byte_t val = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L), val);
+    byte_t val = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
+    memoryMapWriteByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L), val);
     return 7;
 }
 
 static int ld_hl_nn_addr(ZilogZ80_t *cpu)
 {
-    word_t address = fetchWordAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    word_t address = memoryMapReadWord(&cpu->memoryMap, cpu->PC);
     
-    byte_t lowerByte = fetchByteAddressSpace(&cpu->ram, &cpu->rom, address);
-    byte_t upperByte = fetchByteAddressSpace(&cpu->ram, &cpu->rom, address + 1);
+    byte_t lowerByte = memoryMapReadByte(&cpu->memoryMap, address);
+    byte_t upperByte = memoryMapReadByte(&cpu->memoryMap, address + 1);
 
     cpu->H = upperByte;
     cpu->L = lowerByte;
@@ -4329,16 +4396,16 @@ static int ld_hl_nn_addr(ZilogZ80_t *cpu)
 }
 static int ld_a_nn_addr(ZilogZ80_t *cpu)
 {
-    word_t address = fetchWordAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
-    cpu->A = fetchByteAddressSpace(&cpu->ram, &cpu->rom, address);
+    word_t address = memoryMapReadWord(&cpu->memoryMap, cpu->PC);
+    cpu->A = memoryMapReadByte(&cpu->memoryMap, address);
     cpu->PC += 2;
     return 13;
 }
 
 static int ld_nn_hl_addr(ZilogZ80_t *cpu)
 {
-    word_t address = fetchWordAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
-    storeWordAddressSpace(&cpu->ram, &cpu->rom, address, TO_WORD(cpu->H, cpu->L));
+    word_t address = memoryMapReadWord(&cpu->memoryMap, cpu->PC);
+    memoryMapWriteWord(&cpu->memoryMap, address, TO_WORD(cpu->H, cpu->L));
 
     cpu->PC += 2;
 
@@ -4346,34 +4413,34 @@ static int ld_nn_hl_addr(ZilogZ80_t *cpu)
 }
 static int ld_nn_a_addr(ZilogZ80_t *cpu)
 {
-    word_t address = fetchWordAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, address, cpu->A);
+    word_t address = memoryMapReadWord(&cpu->memoryMap, cpu->PC);
+    memoryMapWriteByte(&cpu->memoryMap, address, cpu->A);
     cpu->PC += 2;
     return 13;
 }
 
 static int ld_de_nn_imm(ZilogZ80_t *cpu)
 {
-    word_t address = fetchWordAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, address, cpu->E);
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, address + 1, cpu->D);
+    word_t address = memoryMapReadWord(&cpu->memoryMap, cpu->PC);
+    memoryMapWriteByte(&cpu->memoryMap, address, cpu->E);
+    memoryMapWriteByte(&cpu->memoryMap, address + 1, cpu->D);
     cpu->PC += 2;
     return 16;
 }
 static int ld_de_a_addr(ZilogZ80_t *cpu)
 {
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->D, cpu->E), cpu->A);
+    memoryMapWriteByte(&cpu->memoryMap, TO_WORD(cpu->D, cpu->E), cpu->A);
     return 7;
 }
 static int ld_a_de_addr(ZilogZ80_t *cpu)
 {
-    cpu->A = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->D, cpu->E));
+    cpu->A = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->D, cpu->E));
     return 7;
 }
 
 static int ld_bc_nn_imm(ZilogZ80_t *cpu)
 {
-    word_t immediate = fetchWordAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    word_t immediate = memoryMapReadWord(&cpu->memoryMap, cpu->PC);
     cpu->B = UPPER_BYTE(immediate);
     cpu->C = LOWER_BYTE(immediate);
     cpu->PC += 2;
@@ -4383,18 +4450,18 @@ static int ld_bc_nn_imm(ZilogZ80_t *cpu)
 }
 static int ld_bc_a_addr(ZilogZ80_t *cpu)
 {
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->B, cpu->C), cpu->A);
+    memoryMapWriteByte(&cpu->memoryMap, TO_WORD(cpu->B, cpu->C), cpu->A);
     return 7;
 }
 static int ld_a_bc_addr(ZilogZ80_t *cpu)
 {
-    cpu->A = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->B, cpu->C));
+    cpu->A = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->B, cpu->C));
     return 7;
 }
 
 static int ld_hl_nn_imm(ZilogZ80_t *cpu)
 {
-    word_t immediate = fetchWordAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    word_t immediate = memoryMapReadWord(&cpu->memoryMap, cpu->PC);
     cpu->H = UPPER_BYTE(immediate);
     cpu->L = LOWER_BYTE(immediate);
     cpu->PC += 2;
@@ -4404,7 +4471,7 @@ static int ld_hl_nn_imm(ZilogZ80_t *cpu)
 
 static int ld_sp_nn_imm(ZilogZ80_t *cpu)
 {
-    word_t immediate = fetchWordAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    word_t immediate = memoryMapReadWord(&cpu->memoryMap, cpu->PC);
     cpu->SP = immediate;
     cpu->PC += 2;
 
@@ -4419,10 +4486,10 @@ static int ld_sp_hl(ZilogZ80_t *cpu)
 
 static int ld_bc_nn_addr(ZilogZ80_t *cpu)
 {
-    word_t address = (word_t) fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    word_t address = (word_t) memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     cpu->PC += 2;
     
-    word_t value = (word_t) fetchWordAddressSpace(&cpu->ram, &cpu->rom, address);
+    word_t value = (word_t) memoryMapReadWord(&cpu->memoryMap, address);
 
     cpu->B = UPPER_BYTE(value);
     cpu->C = UPPER_BYTE(value);
@@ -4431,10 +4498,10 @@ static int ld_bc_nn_addr(ZilogZ80_t *cpu)
 }
 static int ld_de_nn_addr(ZilogZ80_t *cpu)
 {
-    word_t address = (word_t) fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    word_t address = (word_t) memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     cpu->PC += 2;
     
-    word_t value = (word_t) fetchWordAddressSpace(&cpu->ram, &cpu->rom, address);
+    word_t value = (word_t) memoryMapReadWord(&cpu->memoryMap, address);
 
     cpu->D = UPPER_BYTE(value);
     cpu->E = UPPER_BYTE(value);
@@ -4443,44 +4510,44 @@ static int ld_de_nn_addr(ZilogZ80_t *cpu)
 }
 static int ld_sp_nn_addr(ZilogZ80_t *cpu)
 {
-    word_t address = (word_t) fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    word_t address = (word_t) memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     cpu->PC += 2;
     
-    cpu->SP = (word_t) fetchWordAddressSpace(&cpu->ram, &cpu->rom, address);
+    cpu->SP = (word_t) memoryMapReadWord(&cpu->memoryMap, address);
 
     return 20;
 }
 static int ld_nn_bc_addr(ZilogZ80_t *cpu)
 {
-    word_t address = (word_t) fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    word_t address = (word_t) memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     cpu->PC += 2;
     
-    storeWordAddressSpace(&cpu->ram, &cpu->rom, address, TO_WORD(cpu->B, cpu->C));
+    memoryMapWriteWord(&cpu->memoryMap, address, TO_WORD(cpu->B, cpu->C));
 
     return 20;
 }
 static int ld_nn_de_addr(ZilogZ80_t *cpu)
 {
-    word_t address = (word_t) fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    word_t address = (word_t) memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     cpu->PC += 2;
     
-    storeWordAddressSpace(&cpu->ram, &cpu->rom, address, TO_WORD(cpu->D, cpu->E));
+    memoryMapWriteWord(&cpu->memoryMap, address, TO_WORD(cpu->D, cpu->E));
 
     return 20;
 }
 static int ld_nn_sp_addr(ZilogZ80_t *cpu)
 {
-    word_t address = (word_t) fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
+    word_t address = (word_t) memoryMapReadByte(&cpu->memoryMap, cpu->PC);
     cpu->PC += 2;
     
-    storeWordAddressSpace(&cpu->ram, &cpu->rom, address, cpu->SP);
+    memoryMapWriteWord(&cpu->memoryMap, address, cpu->SP);
 
     return 20;
 }
 static int ldi(ZilogZ80_t *cpu)
 {
-    byte_t value = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->B, cpu->C), value);
+    byte_t value = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
+    memoryMapWriteByte(&cpu->memoryMap, TO_WORD(cpu->B, cpu->C), value);
 
     incrementRegisterPair(cpu, &cpu->H, &cpu->L);
     incrementRegisterPair(cpu, &cpu->E, &cpu->E);
@@ -4538,21 +4605,22 @@ static int ld_a_i(ZilogZ80_t *cpu)
 }
 
 // OTHER INSTRUCTION    -----------------------------------------------------------------------------
+// The prefixed groups are not decoded yet, they report an invalid opcode until they are
 static int bit_op(ZilogZ80_t *cpu)
 {
-    return 0;
+    return no_func(cpu);
 }
 static int ix_op(ZilogZ80_t *cpu)
 {
-    return 0;
+    return no_func(cpu);
 }
 static int misc_op(ZilogZ80_t *cpu)
 {
-    return 0;
+    return no_func(cpu);
 }
 static int iy_op(ZilogZ80_t *cpu)
 {
-    return 0;
+    return no_func(cpu);
 }
 
 // INTERRUPTS           -----------------------------------------------------------------------------
@@ -4570,8 +4638,8 @@ static int di(ZilogZ80_t *cpu)
 // PORT     -----------------------------------------------------------------------------
 static int in_a_n(ZilogZ80_t *cpu)
 {
-    byte_t port = fetchByteAddressSpace(&cpu->ram, &cpu->rom, (word_t) cpu->PC);
-    cpu->inputCallback[port](&cpu->A);
+    byte_t port = memoryMapReadByte(&cpu->memoryMap, (word_t) cpu->PC);
+    portRead(cpu, port, &cpu->A);
     cpu->PC++;
     
     return 11;
@@ -4579,56 +4647,17 @@ static int in_a_n(ZilogZ80_t *cpu)
 static int out_n_a_addr(ZilogZ80_t *cpu)
 {
     // TODO: Port
-    byte_t port = fetchByteAddressSpace(&cpu->ram, &cpu->rom, cpu->PC);
-    cpu->outputCallback[port](cpu->A);
+    byte_t port = memoryMapReadByte(&cpu->memoryMap, cpu->PC);
+    portWrite(cpu, port, cpu->A);
     cpu->PC++;
     return 11;
 }
 static int daa(ZilogZ80_t *cpu)
 {
-    byte_t halfCarry = cpu->F.H;
-    byte_t carry = cpu->F.C;
-    byte_t subtract = cpu->F.N;
-    byte_t correction = 0;
-    byte_t a = cpu->A;
-
-    if(subtract == 0)
-    {
-        if(halfCarry == 1 || LOWER_NIBBLE(a) > 9)
-        {
-            correction |= 0x06;
-        }
-        if(carry == 1 || a > 0x99)
-        {
-            correction |= 0x60;
-            cpu->F.C = 1;
-        }
-    }
-    else
-    {
-        if(halfCarry == 1 || LOWER_NIBBLE(a) > 9)
-        {
-            correction |= 0x06;
-        }
-        if(carry == 1 || a > 0x99)
-        {
-            correction |= 0x60;
-            cpu->F.C = 1;
-        }
-    }
-
-    if(subtract == 0)
-    {
-        cpu->A += correction;
-    }
-    else
-    {
-        cpu->A -= correction;
-    }
-
-    cpu->F.Z = cpu->A == 0;
+    byte_t result;
 
-    cpu->F.H = 0;
+    applyFlags(cpu, aluDaa(cpu->A, zilogZ80FlagsToByte(cpu->F), &result));
+    cpu->A = result;
 
     return 4;
 }
@@ -4643,43 +4672,43 @@ static int scf(ZilogZ80_t *cpu)
 
 static int in_a_c(ZilogZ80_t *cpu)
 {
-    cpu->inputCallback[cpu->C](&cpu->A);
+    portRead(cpu, cpu->C, &cpu->A);
 
     return 12;
 }
 static int in_b_c(ZilogZ80_t *cpu)
 {
-    cpu->inputCallback[cpu->C](&cpu->B);
+    portRead(cpu, cpu->C, &cpu->B);
     
     return 12;
 }
 static int in_c_c(ZilogZ80_t *cpu)
 {
-    cpu->inputCallback[cpu->C](&cpu->C);
+    portRead(cpu, cpu->C, &cpu->C);
     
     return 12;
 }
 static int in_d_c(ZilogZ80_t *cpu)
 {
-    cpu->inputCallback[cpu->C](&cpu->D);
+    portRead(cpu, cpu->C, &cpu->D);
     
     return 12;
 }
 static int in_e_c(ZilogZ80_t *cpu)
 {
-    cpu->inputCallback[cpu->C](&cpu->E);
+    portRead(cpu, cpu->C, &cpu->E);
     
     return 12;
 }
 static int in_h_c(ZilogZ80_t *cpu)
 {
-    cpu->inputCallback[cpu->C](&cpu->H);
+    portRead(cpu, cpu->C, &cpu->H);
     
     return 12;
 }
 static int in_l_c(ZilogZ80_t *cpu)
 {
-    cpu->inputCallback[cpu->C](&cpu->L);
+    portRead(cpu, cpu->C, &cpu->L);
     
     return 12;
 }
@@ -4688,10 +4717,10 @@ static int ini(ZilogZ80_t *cpu)
     byte_t value;
 
     // Get value of I/O pointed by register C
-    cpu->inputCallback[cpu->C](&value);
+    portRead(cpu, cpu->C, &value);
     
     // Store value in memory address (HL)
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L), value);
+    memoryMapWriteByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L), value);
 
     // Increment HL
     incrementRegisterPair(cpu, &cpu->H, &cpu->L);
@@ -4707,9 +4736,9 @@ static int inir(ZilogZ80_t *cpu)
 
     do
     {        
-        cpu->inputCallback[cpu->C](&value);
+        portRead(cpu, cpu->C, &value);
         
-        storeByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L), value);
+        memoryMapWriteByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L), value);
 
         incrementRegisterPair(cpu, &cpu->H, &cpu->L);
         cpu->B--;
@@ -4729,10 +4758,10 @@ static int ind(ZilogZ80_t *cpu)
     byte_t   value;
 
     // Get value of I/O pointed by register C
-    cpu->inputCallback[cpu->C](&value);
+    portRead(cpu, cpu->C, &value);
     
     // Store value in memory address (HL)
-    storeByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L), value);
+    memoryMapWriteByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L), value);
 
     // Increment HL
     decrementRegisterPair(cpu, &cpu->H, &cpu->L);
@@ -4748,9 +4777,9 @@ static int indr(ZilogZ80_t *cpu)
 
     do
     {        
-        cpu->inputCallback[cpu->C](&value);
+        portRead(cpu, cpu->C, &value);
         
-        storeByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L), value);
+        memoryMapWriteByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L), value);
 
         decrementRegisterPair(cpu, &cpu->H, &cpu->L);
         cpu->B--;
@@ -4805,37 +4834,37 @@ static int out_c_0(ZilogZ80_t *cpu)
 }
 static int out_c_a(ZilogZ80_t *cpu)
 {
-    cpu->outputCallback[cpu->C](cpu->A);
+    portWrite(cpu, cpu->C, cpu->A);
     return 12;
 }
 static int out_c_b(ZilogZ80_t *cpu)
 {
-    cpu->outputCallback[cpu->C](cpu->B);
+    portWrite(cpu, cpu->C, cpu->B);
     return 12;
 }
 static int out_c_c(ZilogZ80_t *cpu)
 {
-    cpu->outputCallback[cpu->C](cpu->C);
+    portWrite(cpu, cpu->C, cpu->C);
     return 12;
 }
 static int out_c_d(ZilogZ80_t *cpu)
 {
-    cpu->outputCallback[cpu->C](cpu->D);
+    portWrite(cpu, cpu->C, cpu->D);
     return 12;
 }
 static int out_c_e(ZilogZ80_t *cpu)
 {
-    cpu->outputCallback[cpu->C](cpu->E);
+    portWrite(cpu, cpu->C, cpu->E);
     return 12;
 }
 static int out_c_h(ZilogZ80_t *cpu)
 {
-    cpu->outputCallback[cpu->C](cpu->H);
+    portWrite(cpu, cpu->C, cpu->H);
     return 12;
 }
 static int out_c_l(ZilogZ80_t *cpu)
 {
-    cpu->outputCallback[cpu->C](cpu->L);
+    portWrite(cpu, cpu->C, cpu->L);
     return 12;
 }
 static int outi(ZilogZ80_t *cpu)
@@ -4844,10 +4873,10 @@ static int outi(ZilogZ80_t *cpu)
     cpu->B--;
 
     // Get byte pointed by (HL)
-    byte_t portValue = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t portValue = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
 
     // Write value to port pointed by C
-    cpu->outputCallback[cpu->C](portValue);
+    portWrite(cpu, cpu->C, portValue);
 
     // Increment HL
     incrementRegisterPair(cpu, &cpu->H, &cpu->L);
@@ -4863,10 +4892,10 @@ static int otir(ZilogZ80_t *cpu)
         cpu->B--;
 
         // Get byte pointed by (HL)
-        byte_t portValue = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+        byte_t portValue = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
 
         // Write value to port pointed by C
-        cpu->outputCallback[cpu->C](portValue);
+        portWrite(cpu, cpu->C, portValue);
 
         // Increment HL
         incrementRegisterPair(cpu, &cpu->H, &cpu->L);
@@ -4933,10 +4962,10 @@ static int outd(ZilogZ80_t *cpu)
     cpu->B++;
 
     // Get byte pointed by (HL)
-    byte_t portValue = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+    byte_t portValue = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
 
     // Write value to port pointed by C
-    cpu->outputCallback[cpu->C](portValue);
+    portWrite(cpu, cpu->C, portValue);
 
     // Decrement HL
     decrementRegisterPair(cpu, &cpu->H, &cpu->L);
@@ -4952,10 +4981,10 @@ static int otdr(ZilogZ80_t *cpu)
         cpu->B--;
 
         // Get byte pointed by (HL)
-        byte_t portValue = fetchByteAddressSpace(&cpu->ram, &cpu->rom, TO_WORD(cpu->H, cpu->L));
+        byte_t portValue = memoryMapReadByte(&cpu->memoryMap, TO_WORD(cpu->H, cpu->L));
 
         // Write value to port pointed by C
-        cpu->outputCallback[cpu->C](portValue);
+        portWrite(cpu, cpu->C, portValue);
 
         // Decrement HL
         decrementRegisterPair(cpu, &cpu->H, &cpu->L);
@@ -5062,15 +5091,21 @@ static int cpl(ZilogZ80_t *cpu)
 }
 static int ccf(ZilogZ80_t *cpu)
 {
+    // H gets the carry before the complement
+    cpu->F.H = cpu->F.C;
     cpu->F.C = !cpu->F.C;
-    cpu->F.H = 0;
     cpu->F.N = 0;
 
     return 4;
 }
 static int neg(ZilogZ80_t *cpu)
 {
-    // TODO
+    // A = 0 - A: P is the overflow of 0x80, C is set for every A but 0
+    word_t result = (word_t)(0 - cpu->A);
+    applyFlags(cpu, aluFlags(0x00, cpu->A, result, true));
+    cpu->A = result & 0xFF;
+
+    return 8;
 }
 static int slp(ZilogZ80_t *cpu)
 {
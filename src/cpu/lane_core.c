@@ -0,0 +1,599 @@
+#include "cpu/lane_core.h"
+
+#include <string.h>
+
+#include "cpu/alu.h"
+
+/** @brief Bits of the packed flags the ALU never writes (F_t._) */
+#define LANE_FLAG_UNUSED 0x28
+
+#define LANE_OPEN_BUS_START 0x4000
+#define LANE_OPEN_BUS_SIZE 0x4000
+
+// Lane loops: no aliasing between the lane arrays, lets the compiler vectorize
+#if defined(_MSC_VER)
+#define LANE_RESTRICT __restrict
+#else
+#define LANE_RESTRICT __restrict__
+#endif
+
+/**
+ * @brief Enum struct for defining the lane kernels
+ */
+typedef enum LaneKernel
+{
+    LANE_KERNEL_NONE = 0,
+    LANE_KERNEL_NOP,
+    /** @brief LD r,r' */
+    LANE_KERNEL_LOAD_REGISTER,
+    /** @brief LD r,n */
+    LANE_KERNEL_LOAD_IMMEDIATE,
+    /** @brief ADD/ADC/SUB/SBC/AND/XOR/OR/CP A,r */
+    LANE_KERNEL_ALU_REGISTER,
+    /** @brief ADD/ADC/SUB/SBC/AND/XOR/OR/CP A,n */
+    LANE_KERNEL_ALU_IMMEDIATE,
+    /** @brief INC r */
+    LANE_KERNEL_INCREMENT,
+    /** @brief DEC r */
+    LANE_KERNEL_DECREMENT,
+    /** @brief JP nn */
+    LANE_KERNEL_JUMP
+} LaneKernel;
+
+/**
+ * @brief Opcodes the scalar core executes differently from their encoding (e.g. operand
+ * taken from the wrong register). They stay on the scalar fallback until the scalar
+ * handler is fixed, lanes must never disagree with the scalar core
+ */
+static const byte_t scalarOnlyOpcodes[] =
+{
+    // LD E,B / LD L,B / LD A,B decode to LD D,B / LD H,B / LD (HL),B
+    0x58, 0x68, 0x78
+};
+
+/**
+ * @brief Decodes the lane kernel of an opcode
+ *
+ * @param opcode
+ * @return LaneKernel
+ */
+static LaneKernel decodeKernel(byte_t opcode);
+
+/**
+ * @brief Executes an opcode on the masked lanes with a lane kernel
+ *
+ * @param core
+ * @param opcode
+ * @param mask 0xFF for lanes that execute the opcode
+ */
+static void executeKernel(LaneCore_t *core, byte_t opcode, const byte_t *mask);
+
+/**
+ * @brief Executes one instruction of a lane on its scalar core
+ *
+ * @param core
+ * @param lane
+ */
+static void stepScalar(LaneCore_t *core, int lane);
+
+/**
+ * @brief Gathers the byte at PC + offset of every lane
+ *
+ * @param core
+ * @param offset
+ * @param values
+ */
+static void gatherOperand(const LaneCore_t *core, word_t offset, byte_t *values);
+
+/**
+ * @brief Advances PC and the cycle counter of the masked lanes
+ *
+ * @param core
+ * @param mask
+ * @param length Instruction length
+ * @param cycles
+ */
+static void advanceLanes(LaneCore_t *core, const byte_t *mask, word_t length, int cycles);
+
+/**
+ * @brief Kernel for ALU operations with A
+ *
+ * @param core
+ * @param operation
+ * @param operand Operand of every lane
+ * @param mask
+ */
+static void kernelAlu(LaneCore_t *core, AluOperation operation, const byte_t *operand, const byte_t *mask);
+
+/**
+ * @brief Kernel for INC r / DEC r
+ *
+ * @param core
+ * @param reg Register index
+ * @param isDecrement
+ * @param mask
+ */
+static void kernelIncrement(LaneCore_t *core, int reg, bool isDecrement, const byte_t *mask);
+
+bool laneCoreInit(LaneCore_t *core)
+{
+    memset(core, 0x00, sizeof(LaneCore_t));
+
+    core->memory = (byte_t *)calloc((size_t)LANE_COUNT * LANE_MEMORY_SIZE, sizeof(byte_t));
+    core->scalarCores = (ZilogZ80_t *)calloc(LANE_COUNT, sizeof(ZilogZ80_t));
+    if(core->memory == NULL || core->scalarCores == NULL)
+    {
+        free(core->memory);
+        free(core->scalarCores);
+        return false;
+    }
+
+    for(int lane = 0; lane < LANE_COUNT; lane++)
+    {
+        byte_t *memory = laneCoreMemory(core, lane);
+        memset(memory + LANE_OPEN_BUS_START, 0xFF, LANE_OPEN_BUS_SIZE);
+
+        // Same layout as the default machine, but backed by the lane memory
+        ZilogZ80_t *cpu = &core->scalarCores[lane];
+        zilogZ80Init(cpu);
+        zilogZ80MapRom(cpu, memory + CPU_ROM_START_ADDRESS, CPU_ROM_SIZE);
+
+        memoryAttach(&cpu->ram, memory + CPU_RAM_START_ADDRESS, CPU_RAM_SIZE);
+        memoryMapMapRegion(&cpu->memoryMap, CPU_RAM_START_ADDRESS, CPU_RAM_SIZE, cpu->ram.data, true);
+    }
+
+    laneCoreReset(core);
+
+    return true;
+}
+
+void laneCoreDestroy(LaneCore_t *core)
+{
+    for(int lane = 0; lane < LANE_COUNT && core->scalarCores != NULL; lane++)
+    {
+        // ROM and RAM are attached to the lane memory, this only drops the references
+        memoryDestroy(&core->scalarCores[lane].rom);
+        memoryDestroy(&core->scalarCores[lane].ram);
+    }
+
+    free(core->scalarCores);
+    free(core->memory);
+    core->scalarCores = NULL;
+    core->memory = NULL;
+}
+
+void laneCoreReset(LaneCore_t *core)
+{
+    memset(core->registers, 0x00, sizeof(core->registers));
+    memset(core->shadowRegisters, 0x00, sizeof(core->shadowRegisters));
+    memset(core->F, 0x00, sizeof(core->F));
+    memset(core->F_, 0x00, sizeof(core->F_));
+    memset(core->SP, 0x00, sizeof(core->SP));
+    memset(core->PC, 0x00, sizeof(core->PC));
+    memset(core->IX, 0x00, sizeof(core->IX));
+    memset(core->IY, 0x00, sizeof(core->IY));
+    memset(core->I, 0x00, sizeof(core->I));
+    memset(core->R, 0x00, sizeof(core->R));
+    memset(core->interruptStatus, INTERRUPTS_ENABLED, sizeof(core->interruptStatus));
+    memset(core->interruptMode, INTERRUPT_MODE_0, sizeof(core->interruptMode));
+    memset(core->isHalted, 0x00, sizeof(core->isHalted));
+    memset(core->cycles, 0x00, sizeof(core->cycles));
+
+    core->vectorLaneSteps = 0;
+    core->scalarLaneSteps = 0;
+}
+
+void laneCoreLoadRom(LaneCore_t *core, int lane, const byte_t *data, size_t size)
+{
+    size_t romSize = (size < CPU_ROM_SIZE) ? size : CPU_ROM_SIZE;
+
+    memcpy(laneCoreMemory(core, lane) + CPU_ROM_START_ADDRESS, data, romSize);
+}
+
+byte_t *laneCoreMemory(LaneCore_t *core, int lane)
+{
+    return core->memory + (size_t)lane * LANE_MEMORY_SIZE;
+}
+
+void laneCoreGetState(const LaneCore_t *core, int lane, ZilogZ80_t *cpu)
+{
+    cpu->B = core->registers[LANE_REGISTER_B][lane];
+    cpu->C = core->registers[LANE_REGISTER_C][lane];
+    cpu->D = core->registers[LANE_REGISTER_D][lane];
+    cpu->E = core->registers[LANE_REGISTER_E][lane];
+    cpu->H = core->registers[LANE_REGISTER_H][lane];
+    cpu->L = core->registers[LANE_REGISTER_L][lane];
+    cpu->A = core->registers[LANE_REGISTER_A][lane];
+
+    cpu->B_ = core->shadowRegisters[LANE_REGISTER_B][lane];
+    cpu->C_ = core->shadowRegisters[LANE_REGISTER_C][lane];
+    cpu->D_ = core->shadowRegisters[LANE_REGISTER_D][lane];
+    cpu->E_ = core->shadowRegisters[LANE_REGISTER_E][lane];
+    cpu->H_ = core->shadowRegisters[LANE_REGISTER_H][lane];
+    cpu->L_ = core->shadowRegisters[LANE_REGISTER_L][lane];
+    cpu->A_ = core->shadowRegisters[LANE_REGISTER_A][lane];
+
+    cpu->F = laneCoreUnpackFlags(core->F[lane]);
+    cpu->F_ = laneCoreUnpackFlags(core->F_[lane]);
+
+    cpu->SP = core->SP[lane];
+    cpu->PC = core->PC[lane];
+    cpu->IX = core->IX[lane];
+    cpu->IY = core->IY[lane];
+    cpu->I = core->I[lane];
+    cpu->R = core->R[lane];
+
+    cpu->interruptStatus = (InterruptStatus)core->interruptStatus[lane];
+    cpu->interruptMode = (InterruptMode)core->interruptMode[lane];
+    cpu->isHaltered = core->isHalted[lane] != 0;
+}
+
+void laneCoreSetState(LaneCore_t *core, int lane, const ZilogZ80_t *cpu)
+{
+    core->registers[LANE_REGISTER_B][lane] = cpu->B;
+    core->registers[LANE_REGISTER_C][lane] = cpu->C;
+    core->registers[LANE_REGISTER_D][lane] = cpu->D;
+    core->registers[LANE_REGISTER_E][lane] = cpu->E;
+    core->registers[LANE_REGISTER_H][lane] = cpu->H;
+    core->registers[LANE_REGISTER_L][lane] = cpu->L;
+    core->registers[LANE_REGISTER_A][lane] = cpu->A;
+
+    core->shadowRegisters[LANE_REGISTER_B][lane] = cpu->B_;
+    core->shadowRegisters[LANE_REGISTER_C][lane] = cpu->C_;
+    core->shadowRegisters[LANE_REGISTER_D][lane] = cpu->D_;
+    core->shadowRegisters[LANE_REGISTER_E][lane] = cpu->E_;
+    core->shadowRegisters[LANE_REGISTER_H][lane] = cpu->H_;
+    core->shadowRegisters[LANE_REGISTER_L][lane] = cpu->L_;
+    core->shadowRegisters[LANE_REGISTER_A][lane] = cpu->A_;
+
+    core->F[lane] = laneCorePackFlags(cpu->F);
+    core->F_[lane] = laneCorePackFlags(cpu->F_);
+
+    core->SP[lane] = cpu->SP;
+    core->PC[lane] = cpu->PC;
+    core->IX[lane] = cpu->IX;
+    core->IY[lane] = cpu->IY;
+    core->I[lane] = cpu->I;
+    core->R[lane] = cpu->R;
+
+    core->interruptStatus[lane] = (byte_t)cpu->interruptStatus;
+    core->interruptMode[lane] = (byte_t)cpu->interruptMode;
+    core->isHalted[lane] = cpu->isHaltered ? 1 : 0;
+}
+
+int laneCoreStep(LaneCore_t *core)
+{
+    byte_t opcodes[LANE_COUNT];
+    byte_t mask[LANE_COUNT];
+    gatherOperand(core, 0, opcodes);
+
+    // The first running lane picks the opcode, lanes agreeing with it run the kernel
+    int leader = -1;
+    for(int lane = 0; lane < LANE_COUNT && leader < 0; lane++)
+    {
+        if(core->isHalted[lane] == 0)
+        {
+            leader = lane;
+        }
+    }
+    if(leader < 0)
+    {
+        return 0;
+    }
+
+    byte_t opcode = opcodes[leader];
+    bool isVector = laneCoreIsVectorOpcode(opcode);
+    int laneCount = 0;
+
+    for(int lane = 0; lane < LANE_COUNT; lane++)
+    {
+        bool isRunning = core->isHalted[lane] == 0;
+        bool isAgreeing = isVector && isRunning && opcodes[lane] == opcode;
+
+        mask[lane] = isAgreeing ? 0xFF : 0x00;
+        laneCount += isRunning ? 1 : 0;
+    }
+
+    if(isVector == true)
+    {
+        executeKernel(core, opcode, mask);
+    }
+
+    // Diverged lanes (and unsupported opcodes) take the scalar path
+    for(int lane = 0; lane < LANE_COUNT; lane++)
+    {
+        if(core->isHalted[lane] == 0 && mask[lane] == 0x00)
+        {
+            stepScalar(core, lane);
+        }
+        else if(mask[lane] != 0x00)
+        {
+            core->vectorLaneSteps++;
+        }
+    }
+
+    return laneCount;
+}
+
+long laneCoreRun(LaneCore_t *core, long maxSteps)
+{
+    long steps = 0;
+
+    while(steps < maxSteps && laneCoreStep(core) > 0)
+    {
+        steps++;
+    }
+
+    return steps;
+}
+
+bool laneCoreIsVectorOpcode(byte_t opcode)
+{
+    if(decodeKernel(opcode) == LANE_KERNEL_NONE)
+    {
+        return false;
+    }
+
+    for(size_t idx = 0; idx < sizeof(scalarOnlyOpcodes); idx++)
+    {
+        if(scalarOnlyOpcodes[idx] == opcode)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+byte_t laneCorePackFlags(F_t flags)
+{
+    return (byte_t)(
+        (flags.S << 7) |
+        (flags.Z << 6) |
+        ((flags._ >> 1) << 5) |
+        (flags.H << 4) |
+        ((flags._ & 0x01) << 3) |
+        (flags.P << 2) |
+        (flags.N << 1) |
+        (flags.C)
+    );
+}
+
+F_t laneCoreUnpackFlags(byte_t value)
+{
+    F_t flags;
+
+    flags.S = (value & ALU_FLAG_S) != 0;
+    flags.Z = (value & ALU_FLAG_Z) != 0;
+    flags._ = (byte_t)(((value >> 4) & 0x02) | ((value >> 3) & 0x01));
+    flags.H = (value & ALU_FLAG_H) != 0;
+    flags.P = (value & ALU_FLAG_P) != 0;
+    flags.N = (value & ALU_FLAG_N) != 0;
+    flags.C = (value & ALU_FLAG_C) != 0;
+
+    return flags;
+}
+
+static LaneKernel decodeKernel(byte_t opcode)
+{
+    int destination = (opcode >> 3) & 0x07;
+    int source = opcode & 0x07;
+
+    if(opcode == 0x00)
+    {
+        return LANE_KERNEL_NOP;
+    }
+    if(opcode == 0xC3)
+    {
+        return LANE_KERNEL_JUMP;
+    }
+    // 0x76 (LD (HL),(HL)) is HALT
+    if(opcode >= 0x40 && opcode <= 0x7F)
+    {
+        bool isMemory = destination == LANE_REGISTER_HL_ADDR || source == LANE_REGISTER_HL_ADDR;
+        if(isMemory == true)
+        {
+            return LANE_KERNEL_NONE;
+        }
+        // LD r,r with the same register changes nothing but PC and cycles, like NOP. The load
+        // kernel must not see it, its restrict rows would alias
+        return (destination == source) ? LANE_KERNEL_NOP : LANE_KERNEL_LOAD_REGISTER;
+    }
+    if(opcode >= 0x80 && opcode <= 0xBF)
+    {
+        return (source == LANE_REGISTER_HL_ADDR) ? LANE_KERNEL_NONE : LANE_KERNEL_ALU_REGISTER;
+    }
+    if((opcode & 0xC7) == 0xC6)
+    {
+        return LANE_KERNEL_ALU_IMMEDIATE;
+    }
+    if(opcode < 0x40 && destination != LANE_REGISTER_HL_ADDR)
+    {
+        switch(source)
+        {
+            case 0x04:
+                return LANE_KERNEL_INCREMENT;
+            case 0x05:
+                return LANE_KERNEL_DECREMENT;
+            case 0x06:
+                return LANE_KERNEL_LOAD_IMMEDIATE;
+            default:
+                break;
+        }
+    }
+
+    return LANE_KERNEL_NONE;
+}
+
+static void executeKernel(LaneCore_t *core, byte_t opcode, const byte_t *mask)
+{
+    int destination = (opcode >> 3) & 0x07;
+    int source = opcode & 0x07;
+    byte_t operand[LANE_COUNT];
+
+    switch(decodeKernel(opcode))
+    {
+        case LANE_KERNEL_NOP:
+            advanceLanes(core, mask, 1, 4);
+            break;
+
+        case LANE_KERNEL_LOAD_REGISTER:
+        {
+            byte_t *LANE_RESTRICT target = core->registers[destination];
+            const byte_t *LANE_RESTRICT value = core->registers[source];
+            for(int lane = 0; lane < LANE_COUNT; lane++)
+            {
+                target[lane] = (byte_t)((value[lane] & mask[lane]) | (target[lane] & ~mask[lane]));
+            }
+            advanceLanes(core, mask, 1, 4);
+            break;
+        }
+
+        case LANE_KERNEL_LOAD_IMMEDIATE:
+        {
+            byte_t *LANE_RESTRICT target = core->registers[destination];
+            gatherOperand(core, 1, operand);
+            for(int lane = 0; lane < LANE_COUNT; lane++)
+            {
+                target[lane] = (byte_t)((operand[lane] & mask[lane]) | (target[lane] & ~mask[lane]));
+            }
+            advanceLanes(core, mask, 2, 7);
+            break;
+        }
+
+        case LANE_KERNEL_ALU_REGISTER:
+            // Copy first, the source row can be A itself
+            memcpy(operand, core->registers[source], LANE_COUNT);
+            kernelAlu(core, (AluOperation)destination, operand, mask);
+            advanceLanes(core, mask, 1, 4);
+            break;
+
+        case LANE_KERNEL_ALU_IMMEDIATE:
+            gatherOperand(core, 1, operand);
+            kernelAlu(core, (AluOperation)destination, operand, mask);
+            advanceLanes(core, mask, 2, 7);
+            break;
+
+        case LANE_KERNEL_INCREMENT:
+        case LANE_KERNEL_DECREMENT:
+            kernelIncrement(core, destination, decodeKernel(opcode) == LANE_KERNEL_DECREMENT, mask);
+            advanceLanes(core, mask, 1, 4);
+            break;
+
+        case LANE_KERNEL_JUMP:
+        {
+            byte_t upper[LANE_COUNT];
+            gatherOperand(core, 1, operand);
+            gatherOperand(core, 2, upper);
+
+            advanceLanes(core, mask, 0, 10);
+            for(int lane = 0; lane < LANE_COUNT; lane++)
+            {
+                word_t target = (word_t)TO_WORD(upper[lane], operand[lane]);
+                core->PC[lane] = (mask[lane] != 0x00) ? target : core->PC[lane];
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+static void stepScalar(LaneCore_t *core, int lane)
+{
+    ZilogZ80_t *cpu = &core->scalarCores[lane];
+
+    laneCoreGetState(core, lane, cpu);
+    core->cycles[lane] += (qword_t)zilogZ80Step(cpu);
+    laneCoreSetState(core, lane, cpu);
+
+    core->scalarLaneSteps++;
+}
+
+static void gatherOperand(const LaneCore_t *core, word_t offset, byte_t *values)
+{
+    for(int lane = 0; lane < LANE_COUNT; lane++)
+    {
+        word_t address = (word_t)(core->PC[lane] + offset);
+        values[lane] = core->memory[(size_t)lane * LANE_MEMORY_SIZE + address];
+    }
+}
+
+static void advanceLanes(LaneCore_t *core, const byte_t *mask, word_t length, int cycles)
+{
+    word_t *LANE_RESTRICT pc = core->PC;
+    qword_t *LANE_RESTRICT laneCycles = core->cycles;
+
+    for(int lane = 0; lane < LANE_COUNT; lane++)
+    {
+        pc[lane] = (word_t)(pc[lane] + (length & (word_t)(int8_t)mask[lane]));
+        laneCycles[lane] += (mask[lane] != 0x00) ? (qword_t)cycles : 0;
+    }
+}
+
+// One loop per operation: the operation is constant inside the loop and the body is
+// branch free, so the compiler can turn each loop into vector instructions
+#define LANE_ALU_LOOP(resultExpression, flagsExpression, isStored)                                \
+    for(int lane = 0; lane < LANE_COUNT; lane++)                                                  \
+    {                                                                                             \
+        byte_t a = regA[lane];                                                                    \
+        byte_t value = operand[lane];                                                             \
+        word_t carry = flags[lane] & ALU_FLAG_C;                                                  \
+        word_t result = (word_t)(resultExpression);                                               \
+        byte_t newFlags = (byte_t)((flags[lane] & LANE_FLAG_UNUSED) | (flagsExpression));         \
+        byte_t newA = (isStored) ? (byte_t)result : a;                                            \
+        regA[lane] = (byte_t)((newA & mask[lane]) | (a & ~mask[lane]));                           \
+        flags[lane] = (byte_t)((newFlags & mask[lane]) | (flags[lane] & ~mask[lane]));            \
+        (void)carry;                                                                              \
+    }
+
+static void kernelAlu(LaneCore_t *core, AluOperation operation, const byte_t *operand, const byte_t *mask)
+{
+    byte_t *LANE_RESTRICT regA = core->registers[LANE_REGISTER_A];
+    byte_t *LANE_RESTRICT flags = core->F;
+
+    switch(operation)
+    {
+        case ALU_ADD:
+            LANE_ALU_LOOP(a + value, aluFlags(a, value, result, false), true);
+            break;
+        case ALU_ADC:
+            LANE_ALU_LOOP(a + value + carry, aluFlags(a, value, result, false), true);
+            break;
+        case ALU_SUB:
+            LANE_ALU_LOOP(a - value, aluFlags(a, value, result, true), true);
+            break;
+        case ALU_SBC:
+            LANE_ALU_LOOP(a - value - carry, aluFlags(a, value, result, true), true);
+            break;
+        case ALU_AND:
+            LANE_ALU_LOOP(a & value, aluLogicFlags((byte_t)result, true), true);
+            break;
+        case ALU_XOR:
+            LANE_ALU_LOOP(a ^ value, aluLogicFlags((byte_t)result, false), true);
+            break;
+        case ALU_OR:
+            LANE_ALU_LOOP(a | value, aluLogicFlags((byte_t)result, false), true);
+            break;
+        case ALU_CP:
+            LANE_ALU_LOOP(a - value, aluFlags(a, value, result, true), false);
+            break;
+    }
+}
+
+static void kernelIncrement(LaneCore_t *core, int reg, bool isDecrement, const byte_t *mask)
+{
+    byte_t *LANE_RESTRICT target = core->registers[reg];
+    byte_t *LANE_RESTRICT flags = core->F;
+
+    for(int lane = 0; lane < LANE_COUNT; lane++)
+    {
+        byte_t value = target[lane];
+        word_t result = isDecrement ? (word_t)(value - 1) : (word_t)(value + 1);
+        byte_t newFlags = (byte_t)((flags[lane] & LANE_FLAG_UNUSED) | aluIncDecFlags(value, isDecrement, flags[lane]));
+
+        target[lane] = (byte_t)(((byte_t)result & mask[lane]) | (value & ~mask[lane]));
+        flags[lane] = (byte_t)((newFlags & mask[lane]) | (flags[lane] & ~mask[lane]));
+    }
+}
@@ -0,0 +1,176 @@
+#ifndef CILOG_C80_LANE_CORE_H
+#define CILOG_C80_LANE_CORE_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "utils/utils.h"
+#include "cpu/cpu.h"
+
+/** @brief Number of Z80 instances stepped together (16 bytes = one SSE / half an AVX2 register) */
+#define LANE_COUNT 16
+/** @brief Address space of a lane */
+#define LANE_MEMORY_SIZE 0x10000
+
+/* ---------------------------- Register indices ---------------------------- */
+// Indices into LaneCore_t.registers, in opcode order (r field), so decoding is a shift
+#define LANE_REGISTER_B 0
+#define LANE_REGISTER_C 1
+#define LANE_REGISTER_D 2
+#define LANE_REGISTER_E 3
+#define LANE_REGISTER_H 4
+#define LANE_REGISTER_L 5
+/** @brief r = 6 encodes (HL), the row is unused */
+#define LANE_REGISTER_HL_ADDR 6
+#define LANE_REGISTER_A 7
+#define LANE_REGISTER_COUNT 8
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Experimental core keeping LANE_COUNT Z80 instances in structure of arrays form.
+ * While the lanes agree on the opcode, the instruction is executed for all of them by one
+ * loop over the lane arrays (auto vectorized). Lanes with a different opcode, and opcodes
+ * without a lane kernel, run one by one on the scalar core, so the results always match
+ * the scalar core.
+ *
+ * Every lane has a flat 64K address space laid out like @ref zilogZ80Init: ROM at
+ * 0x0000-0x3FFF (read-only), open bus at 0x4000-0x7FFF, RAM at 0x8000-0xFFFF
+ */
+typedef struct LaneCore_t
+{
+    /* --------------------------- Register definition -------------------------- */
+    byte_t registers[LANE_REGISTER_COUNT][LANE_COUNT];
+    byte_t shadowRegisters[LANE_REGISTER_COUNT][LANE_COUNT];
+    /** @brief Flags as a byte, see @ref laneCorePackFlags */
+    byte_t F[LANE_COUNT];
+    byte_t F_[LANE_COUNT];
+
+    word_t SP[LANE_COUNT];
+    word_t PC[LANE_COUNT];
+    word_t IX[LANE_COUNT];
+    word_t IY[LANE_COUNT];
+    byte_t I[LANE_COUNT];
+    byte_t R[LANE_COUNT];
+
+    byte_t interruptStatus[LANE_COUNT];
+    byte_t interruptMode[LANE_COUNT];
+    byte_t isHalted[LANE_COUNT];
+    /* -------------------------------------------------------------------------- */
+
+    /** @brief Cycles executed per lane */
+    qword_t cycles[LANE_COUNT];
+
+    /** @brief Lane memories, lane n starts at n * LANE_MEMORY_SIZE */
+    byte_t *memory;
+
+    /** @brief Scalar cores for the fallback, one per lane, mapped onto the lane memory */
+    ZilogZ80_t *scalarCores;
+
+    /** @brief Instructions executed by lane kernels (per lane) */
+    qword_t vectorLaneSteps;
+    /** @brief Instructions executed by the scalar fallback */
+    qword_t scalarLaneSteps;
+} LaneCore_t;
+
+/**
+ * @brief Allocates the lane memories and resets all lanes
+ *
+ * @param core
+ * @return bool False if memory could not be allocated
+ */
+bool laneCoreInit(LaneCore_t *core);
+
+/**
+ * @brief Releases the lane memories
+ *
+ * @param core
+ */
+void laneCoreDestroy(LaneCore_t *core);
+
+/**
+ * @brief Resets the registers of all lanes, memory is kept
+ *
+ * @param core
+ */
+void laneCoreReset(LaneCore_t *core);
+
+/**
+ * @brief Copies a ROM into the ROM window of a lane
+ *
+ * @param core
+ * @param lane
+ * @param data
+ * @param size Bytes past the ROM window are ignored
+ */
+void laneCoreLoadRom(LaneCore_t *core, int lane, const byte_t *data, size_t size);
+
+/**
+ * @brief Returns the address space of a lane
+ *
+ * @param core
+ * @param lane
+ * @return byte_t*
+ */
+byte_t *laneCoreMemory(LaneCore_t *core, int lane);
+
+/**
+ * @brief Copies the registers of a lane into a scalar CPU
+ *
+ * @param core
+ * @param lane
+ * @param cpu
+ */
+void laneCoreGetState(const LaneCore_t *core, int lane, ZilogZ80_t *cpu);
+
+/**
+ * @brief Copies the registers of a scalar CPU into a lane
+ *
+ * @param core
+ * @param lane
+ * @param cpu
+ */
+void laneCoreSetState(LaneCore_t *core, int lane, const ZilogZ80_t *cpu);
+
+/**
+ * @brief Executes one instruction on every lane that is not halted
+ *
+ * @param core
+ * @return int Number of lanes that executed an instruction (0 = all halted)
+ */
+int laneCoreStep(LaneCore_t *core);
+
+/**
+ * @brief Steps until all lanes halted or the step limit is reached
+ *
+ * @param core
+ * @param maxSteps
+ * @return long Steps executed
+ */
+long laneCoreRun(LaneCore_t *core, long maxSteps);
+
+/**
+ * @brief Returns true if the opcode has a lane kernel
+ *
+ * @param opcode
+ * @return bool
+ */
+bool laneCoreIsVectorOpcode(byte_t opcode);
+
+/**
+ * @brief Packs the flags of the scalar core into a byte (S Z _ H _ P N C, the two unused
+ * bits keep the value of F_t._)
+ *
+ * @param flags
+ * @return byte_t
+ */
+byte_t laneCorePackFlags(F_t flags);
+
+/**
+ * @brief Inverse of @ref laneCorePackFlags
+ *
+ * @param value
+ * @return F_t
+ */
+F_t laneCoreUnpackFlags(byte_t value);
+
+#endif // CILOG_C80_LANE_CORE_H
@@ -0,0 +1,272 @@
+#include "cpu/lockstep.h"
+
+#include <string.h>
+
+#include "trace/trace_diff.h"
+
+/**
+ * @brief Moves the writes recorded by a memory map into a write stream and forgets them
+ *
+ * @param map
+ * @param writes
+ */
+static void collectWrites(MemoryMap_t *map, LockstepWrites_t *writes);
+
+/**
+ * @brief Returns whether two write streams are equal
+ *
+ * @param first
+ * @param second
+ * @return bool
+ */
+static bool writesEqual(const LockstepWrites_t *first, const LockstepWrites_t *second);
+
+/**
+ * @brief Prints a write stream
+ *
+ * @param stream
+ * @param label
+ * @param writes
+ */
+static void dumpWrites(FILE *stream, const char *label, const LockstepWrites_t *writes);
+
+bool lockstepInit(LockstepRunner_t *runner)
+{
+    memset(runner, 0x00, sizeof(LockstepRunner_t));
+
+    if(laneCoreInit(&runner->lanes) == false)
+    {
+        return false;
+    }
+
+    zilogZ80Init(&runner->reference);
+    runner->memoryInterval = LOCKSTEP_DEFAULT_MEMORY_INTERVAL;
+
+    // Only lane 0 runs, it starts from the state of the reference
+    laneCoreSetState(&runner->lanes, 0, &runner->reference);
+    for(int lane = 1; lane < LANE_COUNT; lane++)
+    {
+        runner->lanes.isHalted[lane] = 1;
+    }
+
+    // Lane kernels never write memory, every write of lane 0 goes through its scalar core
+    memoryMapAddWatchpoint(&runner->reference.memoryMap, 0x0000, 0xFFFF, WATCHPOINT_WRITE, WATCHPOINT_ACTION_LOG);
+    memoryMapAddWatchpoint(&runner->lanes.scalarCores[0].memoryMap, 0x0000, 0xFFFF, WATCHPOINT_WRITE,
+                           WATCHPOINT_ACTION_LOG);
+
+    return true;
+}
+
+void lockstepDestroy(LockstepRunner_t *runner)
+{
+    memoryDestroy(&runner->reference.rom);
+    memoryDestroy(&runner->reference.ram);
+    laneCoreDestroy(&runner->lanes);
+}
+
+void lockstepLoadRom(LockstepRunner_t *runner, word_t address, const byte_t *data, size_t size)
+{
+    if(address >= CPU_ROM_SIZE)
+    {
+        return;
+    }
+
+    size_t copySize = (size < (size_t)(CPU_ROM_SIZE - address)) ? size : (size_t)(CPU_ROM_SIZE - address);
+
+    memcpy(runner->reference.rom.data + address, data, copySize);
+    memcpy(laneCoreMemory(&runner->lanes, 0) + CPU_ROM_START_ADDRESS + address, data, copySize);
+}
+
+bool lockstepStep(LockstepRunner_t *runner)
+{
+    ZilogZ80_t *reference = &runner->reference;
+    ZilogZ80_t candidate;
+    byte_t opcode[TRACE_OPCODE_BYTES];
+    TraceRecord_t referenceState;
+    TraceRecord_t candidateState;
+    LockstepWrites_t referenceWrites;
+    LockstepWrites_t candidateWrites;
+
+    if(runner->mismatch != LOCKSTEP_MISMATCH_NONE || reference->isHaltered == true)
+    {
+        return false;
+    }
+
+    word_t pc = reference->PC;
+    for(int idx = 0; idx < TRACE_OPCODE_BYTES; idx++)
+    {
+        opcode[idx] = memoryMapPeekByte(&reference->memoryMap, (word_t)(pc + idx));
+    }
+
+    runner->referenceCycles += (qword_t)zilogZ80Step(reference);
+    collectWrites(&reference->memoryMap, &referenceWrites);
+
+    qword_t laneCycles = runner->lanes.cycles[0];
+    laneCoreStep(&runner->lanes);
+    runner->candidateCycles += runner->lanes.cycles[0] - laneCycles;
+    collectWrites(&runner->lanes.scalarCores[0].memoryMap, &candidateWrites);
+
+    laneCoreGetState(&runner->lanes, 0, &candidate);
+    traceRecordCapture(reference, pc, opcode, runner->referenceCycles, &referenceState);
+    traceRecordCapture(&candidate, pc, opcode, runner->candidateCycles, &candidateState);
+
+    LockstepMismatch mismatch = LOCKSTEP_MISMATCH_NONE;
+
+    if(traceRecordEqual(&referenceState, &candidateState) == false)
+    {
+        TraceRecord_t timed = candidateState;
+        timed.cycle = referenceState.cycle;
+
+        mismatch = (traceRecordEqual(&referenceState, &timed) == true)
+            ? LOCKSTEP_MISMATCH_CYCLES : LOCKSTEP_MISMATCH_REGISTERS;
+    }
+    else if(writesEqual(&referenceWrites, &candidateWrites) == false)
+    {
+        mismatch = LOCKSTEP_MISMATCH_WRITES;
+    }
+    else if(runner->memoryInterval > 0 && (runner->instructions + 1) % (qword_t)runner->memoryInterval == 0)
+    {
+        const byte_t *referenceRam = reference->ram.data;
+        const byte_t *candidateRam = laneCoreMemory(&runner->lanes, 0) + CPU_RAM_START_ADDRESS;
+
+        if(memcmp(referenceRam, candidateRam, CPU_RAM_SIZE) != 0)
+        {
+            size_t offset = 0;
+            while(referenceRam[offset] == candidateRam[offset])
+            {
+                offset++;
+            }
+
+            mismatch = LOCKSTEP_MISMATCH_MEMORY;
+            runner->memoryAddress = (word_t)(CPU_RAM_START_ADDRESS + offset);
+        }
+    }
+
+    if(mismatch != LOCKSTEP_MISMATCH_NONE)
+    {
+        runner->mismatch = mismatch;
+        runner->referenceState = referenceState;
+        runner->candidateState = candidateState;
+        runner->referenceWrites = referenceWrites;
+        runner->candidateWrites = candidateWrites;
+        return false;
+    }
+
+    runner->previous = referenceState;
+    runner->instructions++;
+
+    return true;
+}
+
+LockstepMismatch lockstepRun(LockstepRunner_t *runner, qword_t cycleBudget)
+{
+    while(runner->referenceCycles < cycleBudget && lockstepStep(runner) == true)
+    {
+    }
+
+    return runner->mismatch;
+}
+
+const char *lockstepMismatchName(LockstepMismatch mismatch)
+{
+    switch(mismatch)
+    {
+        case LOCKSTEP_MISMATCH_NONE:
+            return "none";
+        case LOCKSTEP_MISMATCH_REGISTERS:
+            return "registers";
+        case LOCKSTEP_MISMATCH_CYCLES:
+            return "cycles";
+        case LOCKSTEP_MISMATCH_WRITES:
+            return "writes";
+        case LOCKSTEP_MISMATCH_MEMORY:
+            return "memory";
+    }
+
+    return "unknown";
+}
+
+void lockstepDump(FILE *stream, const LockstepRunner_t *runner)
+{
+    if(runner->mismatch == LOCKSTEP_MISMATCH_NONE)
+    {
+        fprintf(stream, "agree: %llu instructions, %llu cycles%s\n", (unsigned long long)runner->instructions,
+                (unsigned long long)runner->referenceCycles, (runner->reference.isHaltered == true) ? ", halted" : "");
+        fprintf(stream, "lane kernels: %llu instructions, scalar fallback: %llu\n",
+                (unsigned long long)runner->lanes.vectorLaneSteps, (unsigned long long)runner->lanes.scalarLaneSteps);
+        return;
+    }
+
+    const TraceRecord_t *state = &runner->referenceState;
+
+    fprintf(stream, "%s mismatch at instruction %llu, pc 0x%04X, bytes %02X %02X %02X %02X\n",
+            lockstepMismatchName(runner->mismatch), (unsigned long long)runner->instructions,
+            (unsigned int)state->pc, state->opcode[0], state->opcode[1], state->opcode[2], state->opcode[3]);
+    fprintf(stream, "executed by the %s\n\n",
+            laneCoreIsVectorOpcode(state->opcode[0]) ? "lane kernel" : "scalar fallback of the lane core");
+
+    traceRecordDumpDiff(stream, "reference", "lane", (runner->instructions > 0) ? &runner->previous : NULL,
+                        &runner->referenceState, &runner->candidateState);
+
+    fprintf(stream, "\n");
+    dumpWrites(stream, "reference", &runner->referenceWrites);
+    dumpWrites(stream, "lane", &runner->candidateWrites);
+
+    if(runner->mismatch == LOCKSTEP_MISMATCH_MEMORY)
+    {
+        word_t address = runner->memoryAddress;
+
+        fprintf(stream, "first differing RAM byte: 0x%04X, reference 0x%02X, lane 0x%02X\n", (unsigned int)address,
+                runner->reference.ram.data[address - CPU_RAM_START_ADDRESS],
+                runner->lanes.memory[address]);
+    }
+}
+
+static void collectWrites(MemoryMap_t *map, LockstepWrites_t *writes)
+{
+    writes->count = 0;
+
+    for(size_t idx = 0; idx < map->pendingHitCount; idx++)
+    {
+        if(map->pendingHits[idx].access == WATCHPOINT_WRITE)
+        {
+            writes->addresses[writes->count] = map->pendingHits[idx].address;
+            writes->values[writes->count] = map->pendingHits[idx].value;
+            writes->count++;
+        }
+    }
+
+    memoryMapClearHits(map);
+}
+
+static bool writesEqual(const LockstepWrites_t *first, const LockstepWrites_t *second)
+{
+    if(first->count != second->count)
+    {
+        return false;
+    }
+
+    for(size_t idx = 0; idx < first->count; idx++)
+    {
+        if(first->addresses[idx] != second->addresses[idx] || first->values[idx] != second->values[idx])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void dumpWrites(FILE *stream, const char *label, const LockstepWrites_t *writes)
+{
+    fprintf(stream, "%-10s writes:", label);
+    if(writes->count == 0)
+    {
+        fprintf(stream, " none");
+    }
+    for(size_t idx = 0; idx < writes->count; idx++)
+    {
+        fprintf(stream, " 0x%04X=0x%02X", (unsigned int)writes->addresses[idx], writes->values[idx]);
+    }
+    fprintf(stream, "\n");
+}
@@ -0,0 +1,138 @@
+#ifndef CILOGC80_LOCKSTEP_H
+#define CILOGC80_LOCKSTEP_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "utils/utils.h"
+#include "cpu/cpu.h"
+#include "cpu/lane_core.h"
+#include "trace/trace_ring.h"
+
+/** @brief Writes one instruction can make is 2, the memory map records up to this many */
+#define LOCKSTEP_MAX_WRITES MEMORY_MAX_PENDING_HITS
+/** @brief Default instructions between two full compares of the RAM */
+#define LOCKSTEP_DEFAULT_MEMORY_INTERVAL 1
+
+/**
+ * @brief Enum struct for defining what two backends disagreed on
+ */
+typedef enum LockstepMismatch
+{
+    LOCKSTEP_MISMATCH_NONE = 0,
+    /** @brief Registers, flags or halt state after the instruction */
+    LOCKSTEP_MISMATCH_REGISTERS,
+    /** @brief Same state but a different cycle count */
+    LOCKSTEP_MISMATCH_CYCLES,
+    /** @brief Addresses, values or order of the memory writes of the instruction */
+    LOCKSTEP_MISMATCH_WRITES,
+    /** @brief The RAM differs although the writes seen agreed (found by the full compare) */
+    LOCKSTEP_MISMATCH_MEMORY
+} LockstepMismatch;
+
+/**
+ * @brief Memory writes of one instruction, in program order
+ */
+typedef struct LockstepWrites_t
+{
+    word_t addresses[LOCKSTEP_MAX_WRITES];
+    byte_t values[LOCKSTEP_MAX_WRITES];
+    size_t count;
+} LockstepWrites_t;
+
+/**
+ * @brief Runs the reference core (the handlers of instruction_handler.c) and a lane of the
+ * lane core side by side from identical state, one instruction at a time, and compares
+ * registers, cycles and memory writes after every instruction. The RAM is compared in
+ * full every memoryInterval instructions to catch writes one side made behind the other's
+ * back. Lanes 1 to LANE_COUNT - 1 stay halted, lane 0 runs the lane kernels whenever the
+ * opcode has one and the scalar fallback otherwise
+ */
+typedef struct LockstepRunner_t
+{
+    ZilogZ80_t reference;
+    LaneCore_t lanes;
+
+    /** @brief Instructions between full RAM compares, 0 only compares the writes */
+    long memoryInterval;
+
+    /** @brief Instructions both sides executed and agreed on */
+    qword_t instructions;
+    /** @brief Cycles of the reference */
+    qword_t referenceCycles;
+    qword_t candidateCycles;
+
+    /** @brief First disagreement, NONE while both sides agree */
+    LockstepMismatch mismatch;
+    /** @brief State after the last instruction both sides agreed on */
+    TraceRecord_t previous;
+    /** @brief State of both sides after the disagreeing instruction */
+    TraceRecord_t referenceState;
+    TraceRecord_t candidateState;
+    LockstepWrites_t referenceWrites;
+    LockstepWrites_t candidateWrites;
+    /** @brief First RAM address that differs (LOCKSTEP_MISMATCH_MEMORY only) */
+    word_t memoryAddress;
+} LockstepRunner_t;
+
+/**
+ * @brief Initializes both sides with empty memory and reset registers. Watches every write
+ * of both sides, the comparison runs on the slow memory path
+ *
+ * @param runner
+ * @return bool False if out of memory
+ */
+bool lockstepInit(LockstepRunner_t *runner);
+
+/**
+ * @brief Releases both sides
+ *
+ * @param runner
+ */
+void lockstepDestroy(LockstepRunner_t *runner);
+
+/**
+ * @brief Copies a program into the ROM window of both sides
+ *
+ * @param runner
+ * @param address Load address inside the ROM window
+ * @param data
+ * @param size Bytes past the ROM window are ignored
+ */
+void lockstepLoadRom(LockstepRunner_t *runner, word_t address, const byte_t *data, size_t size);
+
+/**
+ * @brief Executes one instruction on both sides and compares them
+ *
+ * @param runner
+ * @return bool False on a mismatch (see runner->mismatch) or if the reference halted
+ */
+bool lockstepStep(LockstepRunner_t *runner);
+
+/**
+ * @brief Steps until a mismatch, HALT or the cycle budget is used up
+ *
+ * @param runner
+ * @param cycleBudget Cycles of the reference
+ * @return LockstepMismatch
+ */
+LockstepMismatch lockstepRun(LockstepRunner_t *runner, qword_t cycleBudget);
+
+/**
+ * @brief Returns a short lower case name of a mismatch ("registers", "writes", ...)
+ *
+ * @param mismatch
+ * @return const char*
+ */
+const char *lockstepMismatchName(LockstepMismatch mismatch);
+
+/**
+ * @brief Prints the outcome, and for a mismatch the instruction, the state before it, both
+ * states after it and both write streams
+ *
+ * @param stream
+ * @param runner
+ */
+void lockstepDump(FILE *stream, const LockstepRunner_t *runner);
+
+#endif // CILOGC80_LOCKSTEP_H
@@ -0,0 +1,349 @@
+#include "cpu/opcode_profile.h"
+
+#include <string.h>
+
+/** @brief Mixing constant of the pair hash (golden ratio) */
+#define PAIR_HASH_MULTIPLIER 0x9E3779B1u
+
+static const char *groupNames[OPCODE_GROUP_COUNT] = { "main", "cb", "ed", "dd", "fd", "ddcb", "fdcb" };
+static const char *groupPrefixes[OPCODE_GROUP_COUNT] = { "", "CB ", "ED ", "DD ", "FD ", "DD CB d ", "FD CB d " };
+
+/**
+ * @brief Counts executions of a pair
+ *
+ * @param profile
+ * @param key
+ * @param count
+ */
+static void recordPair(OpcodeProfile_t *profile, dword_t key, qword_t count);
+
+/**
+ * @brief qsort comparator of @ref OpcodeProfileEntry_t, most frequent first
+ */
+static int compareEntries(const void *first, const void *second);
+
+/**
+ * @brief qsort comparator of @ref OpcodePairEntry_t, most frequent first
+ */
+static int comparePairs(const void *first, const void *second);
+
+OpcodeProfile_t *opcodeProfileCreate()
+{
+    OpcodeProfile_t *profile = (OpcodeProfile_t *)malloc(sizeof(OpcodeProfile_t));
+
+    if(profile != NULL)
+    {
+        opcodeProfileClear(profile);
+    }
+
+    return profile;
+}
+
+void opcodeProfileDestroy(OpcodeProfile_t *profile)
+{
+    free(profile);
+}
+
+void opcodeProfileClear(OpcodeProfile_t *profile)
+{
+    memset(profile, 0x00, sizeof(OpcodeProfile_t));
+    profile->previousIndex = -1;
+}
+
+OpcodeGroup opcodeProfileDecode(const MemoryMap_t *map, word_t address, byte_t *opcode)
+{
+    byte_t first = memoryMapPeekByte(map, address);
+    byte_t second = memoryMapPeekByte(map, (word_t)(address + 1));
+
+    switch(first)
+    {
+    case 0xCB:
+        *opcode = second;
+        return OPCODE_GROUP_CB;
+    case 0xED:
+        *opcode = second;
+        return OPCODE_GROUP_ED;
+    case 0xDD:
+    case 0xFD:
+        if(second == 0xCB)
+        {
+            // Displacement first, then the opcode
+            *opcode = memoryMapPeekByte(map, (word_t)(address + 3));
+            return (first == 0xDD) ? OPCODE_GROUP_DDCB : OPCODE_GROUP_FDCB;
+        }
+        *opcode = second;
+        return (first == 0xDD) ? OPCODE_GROUP_DD : OPCODE_GROUP_FD;
+    default:
+        *opcode = first;
+        return OPCODE_GROUP_MAIN;
+    }
+}
+
+OpcodeGroup opcodeProfileDecodeBytes(const byte_t *bytes, byte_t *opcode)
+{
+    switch(bytes[0])
+    {
+    case 0xCB:
+        *opcode = bytes[1];
+        return OPCODE_GROUP_CB;
+    case 0xED:
+        *opcode = bytes[1];
+        return OPCODE_GROUP_ED;
+    case 0xDD:
+    case 0xFD:
+        if(bytes[1] == 0xCB)
+        {
+            *opcode = bytes[3];
+            return (bytes[0] == 0xDD) ? OPCODE_GROUP_DDCB : OPCODE_GROUP_FDCB;
+        }
+        *opcode = bytes[1];
+        return (bytes[0] == 0xDD) ? OPCODE_GROUP_DD : OPCODE_GROUP_FD;
+    default:
+        *opcode = bytes[0];
+        return OPCODE_GROUP_MAIN;
+    }
+}
+
+void opcodeProfileRecord(OpcodeProfile_t *profile, OpcodeGroup group, byte_t opcode, int cycles)
+{
+    int index = ((int)group << 8) | opcode;
+
+    profile->counts[group][opcode]++;
+    profile->cycles[group][opcode] += (qword_t)cycles;
+    profile->instructions++;
+    profile->totalCycles += (qword_t)cycles;
+
+    if(profile->previousIndex >= 0)
+    {
+        recordPair(profile, (((dword_t)profile->previousIndex << 16) | (dword_t)index) + 1, 1);
+    }
+    profile->previousIndex = index;
+}
+
+void opcodeProfileRecordPair(OpcodeProfile_t *profile, OpcodeGroup group, byte_t opcode)
+{
+    int index = ((int)group << 8) | opcode;
+
+    if(profile->previousIndex >= 0)
+    {
+        recordPair(profile, (((dword_t)profile->previousIndex << 16) | (dword_t)index) + 1, 1);
+    }
+    profile->previousIndex = index;
+}
+
+void opcodeProfileMerge(OpcodeProfile_t *profile, const OpcodeProfile_t *other)
+{
+    for(int group = 0; group < OPCODE_GROUP_COUNT; group++)
+    {
+        for(int opcode = 0; opcode < 0x100; opcode++)
+        {
+            profile->counts[group][opcode] += other->counts[group][opcode];
+            profile->cycles[group][opcode] += other->cycles[group][opcode];
+        }
+    }
+
+    for(size_t slot = 0; slot < OPCODE_PROFILE_PAIR_CAPACITY; slot++)
+    {
+        if(other->pairs[slot].key != 0)
+        {
+            recordPair(profile, other->pairs[slot].key, other->pairs[slot].count);
+        }
+    }
+
+    profile->droppedPairs += other->droppedPairs;
+    profile->instructions += other->instructions;
+    profile->totalCycles += other->totalCycles;
+}
+
+size_t opcodeProfileTop(const OpcodeProfile_t *profile, OpcodeProfileEntry_t *entries, size_t maxEntries)
+{
+    OpcodeProfileEntry_t all[OPCODE_GROUP_COUNT * 0x100];
+    size_t count = 0;
+
+    for(int group = 0; group < OPCODE_GROUP_COUNT; group++)
+    {
+        for(int opcode = 0; opcode < 0x100; opcode++)
+        {
+            if(profile->counts[group][opcode] > 0)
+            {
+                all[count].group = (OpcodeGroup)group;
+                all[count].opcode = (byte_t)opcode;
+                all[count].count = profile->counts[group][opcode];
+                all[count].cycles = profile->cycles[group][opcode];
+                count++;
+            }
+        }
+    }
+
+    qsort(all, count, sizeof(OpcodeProfileEntry_t), compareEntries);
+
+    count = (count < maxEntries) ? count : maxEntries;
+    memcpy(entries, all, count * sizeof(OpcodeProfileEntry_t));
+
+    return count;
+}
+
+size_t opcodeProfileTopPairs(const OpcodeProfile_t *profile, OpcodePairEntry_t *entries, size_t maxEntries)
+{
+    OpcodePairEntry_t *all = (OpcodePairEntry_t *)malloc(OPCODE_PROFILE_PAIR_CAPACITY * sizeof(OpcodePairEntry_t));
+    size_t count = 0;
+
+    if(all == NULL)
+    {
+        return 0;
+    }
+
+    for(size_t slot = 0; slot < OPCODE_PROFILE_PAIR_CAPACITY; slot++)
+    {
+        const OpcodePairSlot_t *pair = &profile->pairs[slot];
+        if(pair->key == 0)
+        {
+            continue;
+        }
+
+        dword_t key = pair->key - 1;
+        all[count].firstGroup = (OpcodeGroup)((key >> 24) & 0xFF);
+        all[count].firstOpcode = (byte_t)(key >> 16);
+        all[count].secondGroup = (OpcodeGroup)((key >> 8) & 0xFF);
+        all[count].secondOpcode = (byte_t)key;
+        all[count].count = pair->count;
+        count++;
+    }
+
+    qsort(all, count, sizeof(OpcodePairEntry_t), comparePairs);
+
+    count = (count < maxEntries) ? count : maxEntries;
+    memcpy(entries, all, count * sizeof(OpcodePairEntry_t));
+    free(all);
+
+    return count;
+}
+
+const char *opcodeProfileFormat(OpcodeGroup group, byte_t opcode, char *buffer, size_t bufferSize)
+{
+    snprintf(buffer, bufferSize, "%s%02X", (group < OPCODE_GROUP_COUNT) ? groupPrefixes[group] : "?? ",
+             (unsigned int)opcode);
+
+    return buffer;
+}
+
+void opcodeProfileDump(FILE *stream, const OpcodeProfile_t *profile, size_t limit)
+{
+    OpcodeProfileEntry_t *entries = (OpcodeProfileEntry_t *)malloc(limit * sizeof(OpcodeProfileEntry_t));
+    OpcodePairEntry_t *pairs = (OpcodePairEntry_t *)malloc(limit * sizeof(OpcodePairEntry_t));
+    char first[16];
+    char second[16];
+
+    if(entries == NULL || pairs == NULL)
+    {
+        free(entries);
+        free(pairs);
+        return;
+    }
+
+    double instructions = (profile->instructions > 0) ? (double)profile->instructions : 1.0;
+    double totalCycles = (profile->totalCycles > 0) ? (double)profile->totalCycles : 1.0;
+
+    fprintf(stream, "instructions: %llu, cycles: %llu\n\n", (unsigned long long)profile->instructions,
+            (unsigned long long)profile->totalCycles);
+    fprintf(stream, "%-12s %14s %7s %14s %7s\n", "opcode", "count", "%", "cycles", "% cyc");
+
+    size_t count = opcodeProfileTop(profile, entries, limit);
+    for(size_t idx = 0; idx < count; idx++)
+    {
+        fprintf(stream, "%-12s %14llu %6.2f%% %14llu %6.2f%%\n",
+                opcodeProfileFormat(entries[idx].group, entries[idx].opcode, first, sizeof(first)),
+                (unsigned long long)entries[idx].count, (double)entries[idx].count / instructions * 100.0,
+                (unsigned long long)entries[idx].cycles, (double)entries[idx].cycles / totalCycles * 100.0);
+    }
+
+    fprintf(stream, "\n%-25s %14s %7s\n", "pair", "count", "%");
+
+    count = opcodeProfileTopPairs(profile, pairs, limit);
+    for(size_t idx = 0; idx < count; idx++)
+    {
+        char pair[sizeof(first) + sizeof(second) + 2];
+
+        snprintf(pair, sizeof(pair), "%s, %s",
+                 opcodeProfileFormat(pairs[idx].firstGroup, pairs[idx].firstOpcode, first, sizeof(first)),
+                 opcodeProfileFormat(pairs[idx].secondGroup, pairs[idx].secondOpcode, second, sizeof(second)));
+        fprintf(stream, "%-25s %14llu %6.2f%%\n", pair, (unsigned long long)pairs[idx].count,
+                (double)pairs[idx].count / instructions * 100.0);
+    }
+
+    if(profile->droppedPairs > 0)
+    {
+        fprintf(stream, "(%llu pair executions not tracked, table full)\n", (unsigned long long)profile->droppedPairs);
+    }
+
+    free(entries);
+    free(pairs);
+}
+
+const char *opcodeGroupName(OpcodeGroup group)
+{
+    return (group >= 0 && group < OPCODE_GROUP_COUNT) ? groupNames[group] : "unknown";
+}
+
+bool opcodeGroupFromName(const char *name, OpcodeGroup *group)
+{
+    for(int idx = 0; idx < OPCODE_GROUP_COUNT; idx++)
+    {
+        if(strcmp(name, groupNames[idx]) == 0)
+        {
+            *group = (OpcodeGroup)idx;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void recordPair(OpcodeProfile_t *profile, dword_t key, qword_t count)
+{
+    size_t slot = (size_t)((key * PAIR_HASH_MULTIPLIER) >> 18) & (OPCODE_PROFILE_PAIR_CAPACITY - 1);
+
+    // Linear probing, the table never shrinks
+    for(size_t probe = 0; probe < OPCODE_PROFILE_PAIR_CAPACITY; probe++)
+    {
+        OpcodePairSlot_t *pair = &profile->pairs[slot];
+
+        if(pair->key == key)
+        {
+            pair->count += count;
+            return;
+        }
+        if(pair->key == 0)
+        {
+            // Keep a quarter free, probing gets slow in a full table
+            if(profile->pairCount >= OPCODE_PROFILE_PAIR_CAPACITY - OPCODE_PROFILE_PAIR_CAPACITY / 4)
+            {
+                break;
+            }
+            pair->key = key;
+            pair->count = count;
+            profile->pairCount++;
+            return;
+        }
+
+        slot = (slot + 1) & (OPCODE_PROFILE_PAIR_CAPACITY - 1);
+    }
+
+    profile->droppedPairs += count;
+}
+
+static int compareEntries(const void *first, const void *second)
+{
+    qword_t a = ((const OpcodeProfileEntry_t *)first)->count;
+    qword_t b = ((const OpcodeProfileEntry_t *)second)->count;
+
+    return (a < b) - (a > b);
+}
+
+static int comparePairs(const void *first, const void *second)
+{
+    qword_t a = ((const OpcodePairEntry_t *)first)->count;
+    qword_t b = ((const OpcodePairEntry_t *)second)->count;
+
+    return (a < b) - (a > b);
+}
@@ -0,0 +1,221 @@
+#ifndef CILOGC80_OPCODE_PROFILE_H
+#define CILOGC80_OPCODE_PROFILE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "utils/utils.h"
+#include "memory/memory_map.h"
+
+/**
+ * @brief Compile time switch of the profiling hooks (opcode histogram, host cost and guest PC
+ * samples, instruction trace, coverage) in @ref zilogZ80Step. With 0 the hooks are not compiled
+ * at all, with 1 they cost five NULL checks per instruction (profile, hostProfile, pcProfile,
+ * trace, coverage) while nothing is attached
+ */
+#ifndef CILOGC80_OPCODE_PROFILE
+#define CILOGC80_OPCODE_PROFILE 1
+#endif
+
+/** @brief Distinct opcode pairs tracked, further pairs are only counted as dropped */
+#define OPCODE_PROFILE_PAIR_CAPACITY 0x4000
+
+/**
+ * @brief Enum struct for defining the opcode groups (prefixes)
+ */
+typedef enum OpcodeGroup
+{
+    /** @brief Unprefixed opcodes */
+    OPCODE_GROUP_MAIN = 0,
+    OPCODE_GROUP_CB,
+    OPCODE_GROUP_ED,
+    OPCODE_GROUP_DD,
+    OPCODE_GROUP_FD,
+    /** @brief DD CB d op */
+    OPCODE_GROUP_DDCB,
+    /** @brief FD CB d op */
+    OPCODE_GROUP_FDCB,
+    OPCODE_GROUP_COUNT
+} OpcodeGroup;
+
+/**
+ * @brief Slot of the opcode pair hash table
+ */
+typedef struct OpcodePairSlot_t
+{
+    /** @brief (first index << 16 | second index) + 1, 0 marks a free slot */
+    dword_t key;
+    qword_t count;
+} OpcodePairSlot_t;
+
+/**
+ * @brief Execution counters of every opcode of every group and of consecutive opcode pairs
+ */
+typedef struct OpcodeProfile_t
+{
+    qword_t counts[OPCODE_GROUP_COUNT][0x100];
+    qword_t cycles[OPCODE_GROUP_COUNT][0x100];
+
+    OpcodePairSlot_t pairs[OPCODE_PROFILE_PAIR_CAPACITY];
+    size_t pairCount;
+    /** @brief Pair executions not recorded because the table was full */
+    qword_t droppedPairs;
+
+    /** @brief Index (group * 256 + opcode) of the previous instruction, -1 after clearing */
+    int previousIndex;
+
+    qword_t instructions;
+    qword_t totalCycles;
+} OpcodeProfile_t;
+
+/**
+ * @brief One row of @ref opcodeProfileTop
+ */
+typedef struct OpcodeProfileEntry_t
+{
+    OpcodeGroup group;
+    byte_t opcode;
+    qword_t count;
+    qword_t cycles;
+} OpcodeProfileEntry_t;
+
+/**
+ * @brief One row of @ref opcodeProfileTopPairs
+ */
+typedef struct OpcodePairEntry_t
+{
+    OpcodeGroup firstGroup;
+    byte_t firstOpcode;
+    OpcodeGroup secondGroup;
+    byte_t secondOpcode;
+    qword_t count;
+} OpcodePairEntry_t;
+
+/**
+ * @brief Allocates a cleared profile
+ *
+ * @return OpcodeProfile_t* NULL if out of memory
+ */
+OpcodeProfile_t *opcodeProfileCreate();
+
+/**
+ * @brief Frees a profile (detach it from the CPU first)
+ *
+ * @param profile
+ */
+void opcodeProfileDestroy(OpcodeProfile_t *profile);
+
+/**
+ * @brief Resets all counters
+ *
+ * @param profile
+ */
+void opcodeProfileClear(OpcodeProfile_t *profile);
+
+/**
+ * @brief Decodes the prefixes and the opcode of the instruction at an address. Uses
+ * @ref memoryMapPeekByte, so devices and watchpoints do not see the reads
+ *
+ * @param map
+ * @param address
+ * @param opcode Opcode after the prefixes (and the displacement of DD CB / FD CB)
+ * @return OpcodeGroup
+ */
+OpcodeGroup opcodeProfileDecode(const MemoryMap_t *map, word_t address, byte_t *opcode);
+
+/**
+ * @brief Same as @ref opcodeProfileDecode on instruction bytes already read (a trace record)
+ *
+ * @param bytes At least 4 bytes
+ * @param opcode Opcode after the prefixes (and the displacement of DD CB / FD CB)
+ * @return OpcodeGroup
+ */
+OpcodeGroup opcodeProfileDecodeBytes(const byte_t *bytes, byte_t *opcode);
+
+/**
+ * @brief Counts one execution
+ *
+ * @param profile
+ * @param group
+ * @param opcode
+ * @param cycles Cycles of the execution
+ */
+void opcodeProfileRecord(OpcodeProfile_t *profile, OpcodeGroup group, byte_t opcode, int cycles);
+
+/**
+ * @brief Counts only the pair of the previous opcode and this one, not the execution itself.
+ * For streams counted in pieces: the piece before the seam adds the first opcode of the next
+ *
+ * @param profile
+ * @param group
+ * @param opcode
+ */
+void opcodeProfileRecordPair(OpcodeProfile_t *profile, OpcodeGroup group, byte_t opcode);
+
+/**
+ * @brief Adds the counters of another profile, e.g. one filled by another thread
+ *
+ * @param profile
+ * @param other
+ */
+void opcodeProfileMerge(OpcodeProfile_t *profile, const OpcodeProfile_t *other);
+
+/**
+ * @brief Returns the most executed opcodes, most frequent first
+ *
+ * @param profile
+ * @param entries Destination
+ * @param maxEntries
+ * @return size_t Number of entries written (opcodes never executed are left out)
+ */
+size_t opcodeProfileTop(const OpcodeProfile_t *profile, OpcodeProfileEntry_t *entries, size_t maxEntries);
+
+/**
+ * @brief Returns the most frequent pairs of consecutive opcodes, most frequent first
+ *
+ * @param profile
+ * @param entries Destination
+ * @param maxEntries
+ * @return size_t Number of entries written
+ */
+size_t opcodeProfileTopPairs(const OpcodeProfile_t *profile, OpcodePairEntry_t *entries, size_t maxEntries);
+
+/**
+ * @brief Formats an opcode with its prefixes ("3E", "CB 06", "DD CB d 06")
+ *
+ * @param group
+ * @param opcode
+ * @param buffer
+ * @param bufferSize
+ * @return const char* buffer
+ */
+const char *opcodeProfileFormat(OpcodeGroup group, byte_t opcode, char *buffer, size_t bufferSize);
+
+/**
+ * @brief Prints the most executed opcodes and opcode pairs
+ *
+ * @param stream
+ * @param profile
+ * @param limit Rows per table
+ */
+void opcodeProfileDump(FILE *stream, const OpcodeProfile_t *profile, size_t limit);
+
+/**
+ * @brief Returns the lower case name of a group ("main", "cb", "ed", "dd", "fd", "ddcb", "fdcb")
+ *
+ * @param group
+ * @return const char*
+ */
+const char *opcodeGroupName(OpcodeGroup group);
+
+/**
+ * @brief Looks up a group by its name
+ *
+ * @param name
+ * @param group Set if the name is known
+ * @return bool
+ */
+bool opcodeGroupFromName(const char *name, OpcodeGroup *group);
+
+#endif // CILOGC80_OPCODE_PROFILE_H
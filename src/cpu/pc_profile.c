@@ -0,0 +1,338 @@
+#include "cpu/pc_profile.h"
+
+#include <string.h>
+
+#include "cpu/cpu.h"
+
+/** @brief FNV-1a parameters of the stack hash */
+#define STACK_HASH_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define STACK_HASH_PRIME 0x100000001B3ULL
+
+/** @brief Longest name of a level: a symbol or "sub_1234" */
+#define LEVEL_NAME_SIZE (SYMBOL_MAX_NAME + 8)
+
+/**
+ * @brief One line of the collapsed output before duplicates are merged
+ */
+typedef struct CollapsedLine_t
+{
+    char *text;
+    qword_t samples;
+} CollapsedLine_t;
+
+/**
+ * @brief Counts a sample of the current shadow stack with pc as the innermost level
+ *
+ * @param profile
+ * @param pc
+ */
+static void recordSample(PcProfile_t *profile, word_t pc);
+
+/**
+ * @brief Returns true if SP is above the slot, i.e. the frame has been returned from. Works
+ * across the wrap around at 0x0000
+ *
+ * @param frame
+ * @param stackPointer
+ * @return bool
+ */
+static bool isFrameDead(const PcProfileFrame_t *frame, word_t stackPointer);
+
+/**
+ * @brief Returns true for the opcodes that push the PC and jump (CALL, CALL cc, RST)
+ *
+ * @param group
+ * @param opcode
+ * @return bool
+ */
+static bool isCall(OpcodeGroup group, byte_t opcode);
+
+/**
+ * @brief Names a level of a stack
+ *
+ * @param symbols NULL if no symbols are loaded
+ * @param level 0 for the outermost level
+ * @param entry Entry point of the function of the level
+ * @param location Address executed in the level
+ * @param buffer LEVEL_NAME_SIZE bytes
+ * @return const char*
+ */
+static const char *levelName(const SymbolTable_t *symbols, size_t level, word_t entry, word_t location,
+                             char *buffer);
+
+/**
+ * @brief qsort comparator of @ref CollapsedLine_t, by text
+ */
+static int compareLines(const void *first, const void *second);
+
+PcProfile_t *pcProfileCreate(long sampleInterval)
+{
+    if(sampleInterval < 1)
+    {
+        return NULL;
+    }
+
+    PcProfile_t *profile = (PcProfile_t *)calloc(1, sizeof(PcProfile_t));
+    if(profile == NULL)
+    {
+        return NULL;
+    }
+
+    profile->sampleInterval = sampleInterval;
+    pcProfileClear(profile);
+
+    return profile;
+}
+
+void pcProfileDestroy(PcProfile_t *profile)
+{
+    if(profile == NULL)
+    {
+        return;
+    }
+
+    free(profile->pool);
+    free(profile);
+}
+
+void pcProfileClear(PcProfile_t *profile)
+{
+    memset(profile->stacks, 0x00, sizeof(profile->stacks));
+    profile->stackCount = 0;
+    profile->poolSize = 0;
+
+    profile->depth = 0;
+    profile->countdown = profile->sampleInterval;
+
+    profile->samples = 0;
+    profile->droppedSamples = 0;
+    profile->droppedFrames = 0;
+}
+
+void pcProfileStep(PcProfile_t *profile, const ZilogZ80_t *cpu, OpcodeGroup group, byte_t opcode,
+                   word_t previousSP, int cycles)
+{
+    // Samples belong to the instruction that used the cycles, on the stack it ran on
+    profile->countdown -= cycles;
+    while(profile->countdown <= 0)
+    {
+        recordSample(profile, cpu->instructionPC);
+        profile->countdown += profile->sampleInterval;
+    }
+
+    // Covers RET, RETI / RETN and code that pops its return address or reloads SP
+    pcProfileUnwind(profile, cpu->SP);
+
+    if(isCall(group, opcode) == true && cpu->SP == (word_t)(previousSP - 2))
+    {
+        word_t returnAddress = TO_WORD(memoryMapPeekByte(&cpu->memoryMap, (word_t)(cpu->SP + 1)),
+                                       memoryMapPeekByte(&cpu->memoryMap, cpu->SP));
+
+        pcProfileEnter(profile, cpu->PC, returnAddress, cpu->SP);
+    }
+}
+
+void pcProfileEnter(PcProfile_t *profile, word_t target, word_t returnAddress, word_t slot)
+{
+    if(profile->depth >= PC_PROFILE_MAX_DEPTH)
+    {
+        profile->droppedFrames++;
+        return;
+    }
+
+    profile->frames[profile->depth++] = (PcProfileFrame_t){
+        .target = target,
+        .returnAddress = returnAddress,
+        .slot = slot};
+}
+
+void pcProfileUnwind(PcProfile_t *profile, word_t stackPointer)
+{
+    while(profile->depth > 0 && isFrameDead(&profile->frames[profile->depth - 1], stackPointer) == true)
+    {
+        profile->depth--;
+    }
+}
+
+size_t pcProfileWriteCollapsed(const PcProfile_t *profile, FILE *stream, const SymbolTable_t *symbols)
+{
+    CollapsedLine_t *lines = (CollapsedLine_t *)malloc((profile->stackCount + 1) * sizeof(CollapsedLine_t));
+    size_t lineCount = 0;
+    size_t written = 0;
+
+    if(lines == NULL)
+    {
+        return 0;
+    }
+
+    for(size_t slot = 0; slot < PC_PROFILE_STACK_CAPACITY; slot++)
+    {
+        const PcProfileStack_t *stack = &profile->stacks[slot];
+        if(stack->levels == 0)
+        {
+            continue;
+        }
+
+        char *text = (char *)malloc(stack->levels * (LEVEL_NAME_SIZE + 1) + 1);
+        if(text == NULL)
+        {
+            continue;
+        }
+
+        size_t length = 0;
+        for(size_t level = 0; level < stack->levels; level++)
+        {
+            char name[LEVEL_NAME_SIZE];
+            const word_t *pair = &profile->pool[stack->offset + level * 2];
+
+            length += (size_t)sprintf(text + length, "%s%s", (level > 0) ? ";" : "",
+                                      levelName(symbols, level, pair[0], pair[1], name));
+        }
+
+        lines[lineCount].text = text;
+        lines[lineCount].samples = stack->samples;
+        lineCount++;
+    }
+
+    // Different addresses can resolve to the same names, the tools expect one line per stack
+    qsort(lines, lineCount, sizeof(CollapsedLine_t), compareLines);
+
+    for(size_t idx = 0; idx < lineCount; idx++)
+    {
+        qword_t samples = lines[idx].samples;
+
+        while(idx + 1 < lineCount && strcmp(lines[idx].text, lines[idx + 1].text) == 0)
+        {
+            free(lines[idx].text);
+            samples += lines[++idx].samples;
+        }
+
+        fprintf(stream, "%s %llu\n", lines[idx].text, (unsigned long long)samples);
+        free(lines[idx].text);
+        written++;
+    }
+
+    free(lines);
+
+    return written;
+}
+
+static void recordSample(PcProfile_t *profile, word_t pc)
+{
+    size_t levels = (size_t)profile->depth + 1;
+    word_t path[(PC_PROFILE_MAX_DEPTH + 1) * 2];
+    qword_t hash = STACK_HASH_OFFSET_BASIS;
+
+    for(size_t level = 0; level < levels; level++)
+    {
+        // Level i runs the function entered by frame i - 1 and is at the call of frame i
+        path[level * 2] = (level > 0) ? profile->frames[level - 1].target : 0x0000;
+        path[level * 2 + 1] = (level < (size_t)profile->depth)
+            ? (word_t)(profile->frames[level].returnAddress - 1)
+            : pc;
+    }
+
+    const byte_t *bytes = (const byte_t *)path;
+    for(size_t idx = 0; idx < levels * 2 * sizeof(word_t); idx++)
+    {
+        hash = (hash ^ bytes[idx]) * STACK_HASH_PRIME;
+    }
+
+    profile->samples++;
+
+    size_t slot = (size_t)hash & (PC_PROFILE_STACK_CAPACITY - 1);
+    for(size_t probe = 0; probe < PC_PROFILE_STACK_CAPACITY; probe++)
+    {
+        PcProfileStack_t *stack = &profile->stacks[slot];
+
+        if(stack->levels == levels && stack->hash == hash
+            && memcmp(&profile->pool[stack->offset], path, levels * 2 * sizeof(word_t)) == 0)
+        {
+            stack->samples++;
+            return;
+        }
+        if(stack->levels == 0)
+        {
+            // Keep a quarter free, probing gets slow in a full table
+            if(profile->stackCount >= PC_PROFILE_STACK_CAPACITY - PC_PROFILE_STACK_CAPACITY / 4)
+            {
+                break;
+            }
+
+            if(profile->poolSize + levels * 2 > profile->poolCapacity)
+            {
+                size_t capacity = (profile->poolCapacity > 0) ? profile->poolCapacity * 2 : 4096;
+                while(capacity < profile->poolSize + levels * 2)
+                {
+                    capacity *= 2;
+                }
+
+                word_t *pool = (word_t *)realloc(profile->pool, capacity * sizeof(word_t));
+                if(pool == NULL)
+                {
+                    break;
+                }
+                profile->pool = pool;
+                profile->poolCapacity = capacity;
+            }
+
+            memcpy(&profile->pool[profile->poolSize], path, levels * 2 * sizeof(word_t));
+            *stack = (PcProfileStack_t){
+                .hash = hash,
+                .levels = levels,
+                .offset = profile->poolSize,
+                .samples = 1};
+            profile->poolSize += levels * 2;
+            profile->stackCount++;
+            return;
+        }
+
+        slot = (slot + 1) & (PC_PROFILE_STACK_CAPACITY - 1);
+    }
+
+    profile->droppedSamples++;
+}
+
+static bool isFrameDead(const PcProfileFrame_t *frame, word_t stackPointer)
+{
+    word_t distance = (word_t)(stackPointer - frame->slot);
+
+    return distance != 0 && distance < 0x8000;
+}
+
+static bool isCall(OpcodeGroup group, byte_t opcode)
+{
+    if(group != OPCODE_GROUP_MAIN)
+    {
+        return false;
+    }
+
+    // CALL nn, CALL cc,nn and RST p
+    return opcode == 0xCD || (opcode & 0xC7) == 0xC4 || (opcode & 0xC7) == 0xC7;
+}
+
+static const char *levelName(const SymbolTable_t *symbols, size_t level, word_t entry, word_t location,
+                             char *buffer)
+{
+    const Symbol_t *symbol = (symbols != NULL) ? symbolTableLookup(symbols, location) : NULL;
+
+    if(symbol != NULL)
+    {
+        snprintf(buffer, LEVEL_NAME_SIZE, "%s", symbol->name);
+    }
+    else if(level == 0)
+    {
+        snprintf(buffer, LEVEL_NAME_SIZE, "root");
+    }
+    else
+    {
+        snprintf(buffer, LEVEL_NAME_SIZE, "sub_%04X", (unsigned int)entry);
+    }
+
+    return buffer;
+}
+
+static int compareLines(const void *first, const void *second)
+{
+    return strcmp(((const CollapsedLine_t *)first)->text, ((const CollapsedLine_t *)second)->text);
+}
@@ -0,0 +1,148 @@
+#ifndef CILOGC80_PC_PROFILE_H
+#define CILOGC80_PC_PROFILE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "utils/utils.h"
+#include "cpu/opcode_profile.h"
+#include "emulator/symbol_table.h"
+
+struct ZilogZ80_t;
+
+/** @brief Default emulated cycles between two samples */
+#define PC_PROFILE_DEFAULT_INTERVAL 1000
+/** @brief Deepest call stack tracked, deeper calls are sampled as their deepest tracked caller */
+#define PC_PROFILE_MAX_DEPTH 64
+/** @brief Distinct call stacks kept, samples of further stacks are only counted as dropped */
+#define PC_PROFILE_STACK_CAPACITY 0x4000
+
+/**
+ * @brief Entry of the shadow call stack
+ */
+typedef struct PcProfileFrame_t
+{
+    /** @brief Address called (entry point of the callee) */
+    word_t target;
+    /** @brief Address pushed by the call */
+    word_t returnAddress;
+    /** @brief Stack address the return address was pushed to, the frame is dead once SP is above it */
+    word_t slot;
+} PcProfileFrame_t;
+
+/**
+ * @brief Slot of the hash table of sampled call stacks
+ */
+typedef struct PcProfileStack_t
+{
+    qword_t hash;
+    /** @brief Levels of the stack (frames + 1), 0 marks a free slot */
+    size_t levels;
+    /** @brief Index of the first level in the address pool */
+    size_t offset;
+    qword_t samples;
+} PcProfileStack_t;
+
+/**
+ * @brief Guest PC samples taken every sampleInterval emulated cycles, aggregated by call stack.
+ * The call stack is rebuilt from a shadow stack kept on CALL, RST, RET and interrupts
+ */
+typedef struct PcProfile_t
+{
+    long sampleInterval;
+    /** @brief Cycles left until the next sample */
+    long countdown;
+
+    PcProfileFrame_t frames[PC_PROFILE_MAX_DEPTH];
+    int depth;
+
+    PcProfileStack_t stacks[PC_PROFILE_STACK_CAPACITY];
+    size_t stackCount;
+
+    /**
+     * @brief Levels of the sampled stacks, two words per level: entry point of the function
+     * (0 for the outermost level) and the address executed in it
+     */
+    word_t *pool;
+    size_t poolSize;
+    size_t poolCapacity;
+
+    qword_t samples;
+    /** @brief Samples not recorded because the stack table was full */
+    qword_t droppedSamples;
+    /** @brief Calls not pushed because the shadow stack was full */
+    qword_t droppedFrames;
+} PcProfile_t;
+
+/**
+ * @brief Allocates an empty profile
+ *
+ * @param sampleInterval Emulated cycles between two samples
+ * @return PcProfile_t* NULL if out of memory or sampleInterval < 1
+ */
+PcProfile_t *pcProfileCreate(long sampleInterval);
+
+/**
+ * @brief Frees a profile (detach it from the CPU first)
+ *
+ * @param profile
+ */
+void pcProfileDestroy(PcProfile_t *profile);
+
+/**
+ * @brief Forgets the samples and the shadow stack
+ *
+ * @param profile
+ */
+void pcProfileClear(PcProfile_t *profile);
+
+/**
+ * @brief Updates the profile after an instruction: takes the samples that fell into its cycles
+ * (attributed to the instruction and the stack it ran on), then pushes or pops the shadow
+ * stack if it was a taken call, restart or return
+ *
+ * @param profile
+ * @param cpu State after the instruction
+ * @param group Decoded before the instruction
+ * @param opcode Decoded before the instruction
+ * @param previousSP SP before the instruction
+ * @param cycles Cycles of the instruction
+ */
+void pcProfileStep(PcProfile_t *profile, const struct ZilogZ80_t *cpu, OpcodeGroup group, byte_t opcode,
+                   word_t previousSP, int cycles);
+
+/**
+ * @brief Pushes a frame on the shadow stack. Called for taken CALL / RST instructions and by
+ * the interrupt acceptance
+ *
+ * @param profile
+ * @param target Address jumped to
+ * @param returnAddress Address pushed
+ * @param slot SP after the push
+ */
+void pcProfileEnter(PcProfile_t *profile, word_t target, word_t returnAddress, word_t slot);
+
+/**
+ * @brief Drops the frames whose return address slot is below SP (returned from, or abandoned
+ * by code that reset the stack)
+ *
+ * @param profile
+ * @param stackPointer
+ */
+void pcProfileUnwind(PcProfile_t *profile, word_t stackPointer);
+
+/**
+ * @brief Writes the samples as collapsed stacks ("outer;inner;leaf count" per line), the input
+ * format of flamegraph.pl and speedscope. With symbols every level is named after the symbol
+ * of the address executed in it, without them after the entry point of its function
+ * ("sub_1234", the outermost level is "root")
+ *
+ * @param profile
+ * @param stream
+ * @param symbols NULL if no symbols are loaded
+ * @return size_t Number of lines written
+ */
+size_t pcProfileWriteCollapsed(const PcProfile_t *profile, FILE *stream, const SymbolTable_t *symbols);
+
+#endif // CILOGC80_PC_PROFILE_H
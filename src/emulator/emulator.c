@@ -3,52 +3,45 @@
 #include <stdbool.h>
 #include <stdio.h>
 
-#include "cpu/cpu.h"
-#include "memory/mem.h"
+#include "machine/machine.h"
 #include "utils/error_handler.h"
 
 #if !defined(HEADLESS)
 #include "emulator/graphics_interface.h"
 #endif
 
-// Enums
-// -----------------------------------------------------------
-typedef enum
-{
-    EMULATION_STATE_STOPPED = 0,
-    EMULATION_STATE_RUNNING,
-    EMULATION_STATE_PAUSED
-} C80_EmulationState_t;
-
-
-// Global variables
-// -----------------------------------------------------------
-static ZilogZ80_t                cpu;
-static Memory_t             memory;
-static C80_EmulationState_t emulationState = EMULATION_STATE_STOPPED;
-// -----------------------------------------------------------
-
 // Emulator functions
 // -----------------------------------------------------------
 void emulatorInit(int argc, char** argv);
-void outputPrint(byte_t value);
+void outputPrint(void *context, byte_t value);
 // -----------------------------------------------------------
 
 // Emulator function definitions
 // -----------------------------------------------------------
 void emulatorInit(int argc, char** argv)
 {
-    zilogZ80Init(&cpu);
-    cpu.outputCallback[0x01] = &outputPrint;
+    Machine_t machine;
+
     errorStackInit();
+    if(machineInit(&machine, NULL) == false)
+    {
+        errorStackSetCurrent(&machine.errors);
+        pollError();
+        errorStackSetCurrent(NULL);
+    }
+    machine.cpu.outputCallback[0x01] = &outputPrint;
 
     #if !defined(HEADLESS)
-    graphicsInit(argc, argv, &cpu);
+    graphicsInit(argc, argv, &machine);
+    #else
+    printf("Built without the GUI, run ROMs with cilogc80-run\n");
     #endif
+
+    machineDestroy(&machine);
 }
 
-void outputPrint(byte_t value)
+void outputPrint(void *context, byte_t value)
 {
-    printf("Port: 0x01X -> %c | 0x%02X\n", (char)value, value);
+    printf("Port: 0x01 -> %c | 0x%02X\n", (char)value, value);
 }
-// -----------------------------------------------------------
\ No newline at end of file
+// -----------------------------------------------------------
@@ -35,19 +35,18 @@
 #define GUI_EMULATOR_INFO_VIEW_IMPLEMENTATION
 #include "gui_components/gui_emulator_info_view.h"
 
+#define GUI_OPCODE_PROFILE_VIEW_IMPLEMENTATION
+#include "gui_components/gui_opcode_profile_view.h"
+
 #include "file_grabber.h"
+#include "machine/save_state.h"
 
 /* -------------------------------------------------------------------------- */
 /*                                   Defines                                  */
 /* -------------------------------------------------------------------------- */
 #define FONT_SIZE 10
-/* -------------------------------------------------------------------------- */
-
-/* -------------------------------------------------------------------------- */
-/*                              Global variables                              */
-/* -------------------------------------------------------------------------- */
-static ZilogZ80_t                *cpu;
-/* -------------------------------------------------------------------------- */
+/** @brief Quick save slot (F5 saves, F9 loads), in the working directory */
+#define QUICK_SAVE_FILE "quicksave.c80s"
 /* -------------------------------------------------------------------------- */
 
 /* -------------------------------------------------------------------------- */
@@ -80,8 +79,10 @@ static inline void renderMenuBarCallback(void *state);
 static inline void renderFileDialogCallback(void *state);
 static inline void renderToolTipTextCallback(void *state);
 static inline void renderToastCallback(void *state);
+static inline void renderOpcodeProfileViewCallback(void *state);
 
 static void checkPriority(RenderObject *renderObjects, size_t *renderObjectsPriority, const size_t renderStatesCount);
+static int findBackendIndex(const MachineBackend_t *backend);
 /* -------------------------------------------------------------------------- */
 /*                             Callback functions                             */
 /* -------------------------------------------------------------------------- */
@@ -91,13 +92,14 @@ static void checkPriority(RenderObject *renderObjects, size_t *renderObjectsPrio
 /* -------------------------------------------------------------------------- */
 /*                            Function definitions                            */
 /* -------------------------------------------------------------------------- */
-int graphicsInit(int argc, char **argv, ZilogZ80_t *cpu)
+int graphicsInit(int argc, char **argv, Machine_t *machine)
 {
     int status;
 
     int screenWidth = 1280;
     int screenHeight = 720;
 
+    ZilogZ80_t *cpu = &machine->cpu;
     bool isProgramLoaded = false;
 
     SetConfigFlags(FLAG_VSYNC_HINT | FLAG_WINDOW_RESIZABLE | FLAG_WINDOW_MINIMIZED);  // Set window configuration flags
@@ -112,16 +114,20 @@ int graphicsInit(int argc, char **argv, ZilogZ80_t *cpu)
     GuiRamMemoryViewState ramMemoryViewState = InitGuiRamMemoryView();
     GuiRomMemoryViewState romMemoryViewState = InitGuiRomMemoryView();
     GuiPreferencesState preferencesState = InitGuiPreferences((Vector2){ screenWidth / 2, screenHeight / 2 }, 400, 300);   
+    preferencesState.backendIndex = findBackendIndex(machine->backend);
     GuiToastState toastState = InitGuiToast();
+    GuiOpcodeProfileViewState opcodeProfileViewState = InitGuiOpcodeProfileView();
+    OpcodeProfile_t *opcodeProfile = NULL;
     //--------------------------------------------------------------------------------------
     RenderObject renderObjects[] = 
     {
         { &cpuViewState, (void (*)(void *))renderCpuViewCallback, 0 },
         { &ramMemoryViewState, (void (*)(void *))renderRamMemoryViewCallback, 1 },
         { &romMemoryViewState, (void (*)(void *))renderRomMemoryViewCallback, 2},
-        { &preferencesState, (void (*)(void *))renderPreferencesCallback, 3 },
-        { &fileDialogState, (void (*)(void *))renderFileDialogCallback, 4 },
-        { &toastState, (void (*)(void *))renderToastCallback, 5 }
+        { &opcodeProfileViewState, (void (*)(void *))renderOpcodeProfileViewCallback, 3 },
+        { &preferencesState, (void (*)(void *))renderPreferencesCallback, 4 },
+        { &fileDialogState, (void (*)(void *))renderFileDialogCallback, 5 },
+        { &toastState, (void (*)(void *))renderToastCallback, 6 }
     };
     const int renderStatesCount = sizeof(renderObjects) / sizeof(RenderObject);
     size_t renderObjectsPriority[renderStatesCount];
@@ -165,6 +171,52 @@ int graphicsInit(int argc, char **argv, ZilogZ80_t *cpu)
         {
             romMemoryViewState.isWindowActive = !romMemoryViewState.isWindowActive;
         }
+        if(menuBarState.profileButtonActive == true)
+        {
+            opcodeProfileViewState.isWindowActive = !opcodeProfileViewState.isWindowActive;
+        }
+        if(menuBarState.settingsButtonActive == true)
+        {
+            preferencesState.isWindowActive = !preferencesState.isWindowActive;
+        }
+
+        /* ---------------------------- Execution backend --------------------------- */
+        // Switching between frames, the new backend starts from the state the old one published
+        if(preferencesState.isBackendChanged == true)
+        {
+            if(machineSetBackend(machine, machineBackendGet((size_t)preferencesState.backendIndex)) == true)
+            {
+                GuiToastDisplayMessage(&toastState, "Execution backend changed.", 2000, GUI_TOAST_MESSAGE);
+            }
+            else
+            {
+                GuiToastDisplayMessage(&toastState, "Execution backend could not be created.", 5000, GUI_TOAST_ERROR);
+                preferencesState.backendIndex = findBackendIndex(machine->backend);
+            }
+            preferencesState.isBackendChanged = false;
+        }
+        /* -------------------------------------------------------------------------- */
+
+        /* ----------------------------- Opcode profile ----------------------------- */
+        // The profile is only attached while recording, the counters stay visible afterwards
+        if(opcodeProfileViewState.isRecording == true && cpu->profile == NULL)
+        {
+            if(opcodeProfile == NULL)
+            {
+                opcodeProfile = opcodeProfileCreate();
+            }
+            cpu->profile = opcodeProfile;
+        }
+        else if(opcodeProfileViewState.isRecording == false)
+        {
+            cpu->profile = NULL;
+        }
+        if(opcodeProfileViewState.isClearPressed == true && opcodeProfile != NULL)
+        {
+            opcodeProfileClear(opcodeProfile);
+        }
+        opcodeProfileViewState.isClearPressed = false;
+        /* -------------------------------------------------------------------------- */
 
         if(fileDialogState.SelectFilePressed == true)
         {
@@ -172,19 +224,22 @@ int graphicsInit(int argc, char **argv, ZilogZ80_t *cpu)
             createFilePath(fileDialogState.dirPathText, fileDialogState.fileNameText, selectedFileBuffer, sizeof(selectedFileBuffer));
 
             fileDialogState.windowActive = false;
-            byte_t data[cpu->rom.memorySize];
 
-            bool fileLoaded = loadFile(selectedFileBuffer, data, cpu->rom.memorySize);
-            loadProgramToRom(&cpu->rom, data, cpu->rom.memorySize);
+            // The previous image stays mapped if the new one can not be loaded
+            bool fileLoaded = machineLoadRom(machine, selectedFileBuffer, ROM_FORMAT_AUTO);
             if(fileLoaded == true)
             {
-                zilogZ80Reset(cpu);
+                machineReset(machine);
                 GuiRamMemoryViewUpdate(&ramMemoryViewState, true);
                 GuiRomMemoryViewUpdate(&romMemoryViewState, true);
                 GuiToastDisplayMessage(&toastState, "File loaded.", 5000, GUI_TOAST_SUCCESS);
 
                 isProgramLoaded = true;
             }
+            else
+            {
+                GuiToastDisplayMessage(&toastState, "File could not be loaded.", 5000, GUI_TOAST_ERROR);
+            }
 
             fileDialogState.SelectFilePressed = false;
         }
@@ -214,12 +269,39 @@ int graphicsInit(int argc, char **argv, ZilogZ80_t *cpu)
             {
                 GuiToastDisplayMessage(&toastState, "CPU step.", 2000, GUI_TOAST_MESSAGE);
             }
-            zilogZ80Step(cpu); 
+            machineStep(machine);
 
             GuiRamMemoryViewUpdate(&ramMemoryViewState, true);
             GuiRomMemoryViewUpdate(&romMemoryViewState, true);
             GuiCpuViewUpdate(&cpuViewState, true);
         }
+        if(IsKeyPressed(KEY_F5) == true)
+        {
+            if(saveStateWrite(machine, QUICK_SAVE_FILE, NULL, 0) == true)
+            {
+                GuiToastDisplayMessage(&toastState, "State saved.", 2000, GUI_TOAST_SUCCESS);
+            }
+            else
+            {
+                GuiToastDisplayMessage(&toastState, "State could not be saved.", 5000, GUI_TOAST_ERROR);
+            }
+        }
+        if(IsKeyPressed(KEY_F9) == true)
+        {
+            // Nothing changes if the state is missing or belongs to another ROM
+            if(saveStateLoad(machine, QUICK_SAVE_FILE) == true)
+            {
+                GuiToastDisplayMessage(&toastState, "State loaded.", 2000, GUI_TOAST_SUCCESS);
+
+                GuiRamMemoryViewUpdate(&ramMemoryViewState, true);
+                GuiRomMemoryViewUpdate(&romMemoryViewState, true);
+                GuiCpuViewUpdate(&cpuViewState, true);
+            }
+            else
+            {
+                GuiToastDisplayMessage(&toastState, "State could not be loaded.", 5000, GUI_TOAST_ERROR);
+            }
+        }
         if(menuBarState.startEmulationButtonActive == true)
         {
             emulationState = EMULATION_RUNNING;
@@ -257,17 +339,23 @@ int graphicsInit(int argc, char **argv, ZilogZ80_t *cpu)
                 {
                     GuiToastDisplayMessage(&toastState, "CPU running.", 2000, GUI_TOAST_MESSAGE);
                 }
-                int cyclesPerFrame = (cpu->frequency * cpu->frequencyFactor) / 60; // Cycles per 60Hz frame (TODO: Make this configurable)
-                while(cpu->totalCycles < cyclesPerFrame && cpu->isHaltered == false)
-                {
-                    zilogZ80Step(cpu);
-                }
+                // The frequency can be changed in the CPU view
+                machine->scheduler.cyclesPerFrame = (cpu->frequency * cpu->frequencyFactor) / MACHINE_DEFAULT_FRAME_RATE;
+                StopReason stopReason = machineRunFrame(machine);
                 cpu->totalCycles = 0;
 
-                if(cpu->isHaltered == true)
+                if(stopReason == STOP_REASON_HALT)
                 {
                     GuiToastDisplayMessage(&toastState, "CPU halted.", 2000, GUI_TOAST_WARNING);
                 }
+                else if(stopReason == STOP_REASON_WATCHPOINT)
+                {
+                    static char watchpointMessage[64];
+                    snprintf(watchpointMessage, sizeof(watchpointMessage), "Watchpoint hit at 0x%04X (PC 0x%04X).",
+                             cpu->stopWatchpoint.address, cpu->stopPC);
+                    GuiToastDisplayMessage(&toastState, watchpointMessage, 5000, GUI_TOAST_WARNING);
+                    emulationState = EMULATION_PAUSED;
+                }
 
                 GuiRamMemoryViewUpdate(&ramMemoryViewState, true);
                 GuiRomMemoryViewUpdate(&romMemoryViewState, true);
@@ -277,7 +365,7 @@ int graphicsInit(int argc, char **argv, ZilogZ80_t *cpu)
 
         if(menuBarState.restartEmulationButtonActive == true)
         {
-            zilogZ80Reset(cpu);
+            machineReset(machine);
         }
 
         /* ----------------------------- CPU view update ---------------------------- */
@@ -288,6 +376,10 @@ int graphicsInit(int argc, char **argv, ZilogZ80_t *cpu)
         GuiCpuViewUpdateCycleCount(&cpuViewState, cpu->totalCycles);
         /* -------------------------------------------------------------------------- */
 
+        /* ------------------------ Opcode profile view update ---------------------- */
+        GuiOpcodeProfileViewUpdate(&opcodeProfileViewState, opcodeProfile);
+        /* -------------------------------------------------------------------------- */
+
         /* --------------------------- Memory view update --------------------------- */
         GuiRamMemoryViewAddressUpdate(&ramMemoryViewState, cpu->ram.data, cpu->ram.memorySize);
         GuiRomMemoryViewAddressUpdate(&romMemoryViewState, cpu->rom.data, cpu->rom.memorySize);
@@ -312,6 +404,9 @@ int graphicsInit(int argc, char **argv, ZilogZ80_t *cpu)
         /* ------------------------------ End Drawing ----------------------------- */
     }
 
+    cpu->profile = NULL;
+    opcodeProfileDestroy(opcodeProfile);
+
     CloseWindow();
 
     return status;
@@ -353,6 +448,10 @@ static inline void renderToastCallback(void *state)
 {
     GuiToast((GuiToastState *)state);
 }
+static inline void renderOpcodeProfileViewCallback(void *state)
+{
+    GuiOpcodeProfileView((GuiOpcodeProfileViewState *)state);
+}
 
 static void checkPriority(RenderObject *renderObjects, size_t *renderObjectsPriority, const size_t renderStatesCount)
 {
@@ -381,4 +480,17 @@ static void checkPriority(RenderObject *renderObjects, size_t *renderObjectsPrio
             }
         }
     }
-}
\ No newline at end of file
+}
+
+static int findBackendIndex(const MachineBackend_t *backend)
+{
+    for(size_t idx = 0; idx < machineBackendCount(); idx++)
+    {
+        if(machineBackendGet(idx) == backend)
+        {
+            return (int)idx;
+        }
+    }
+
+    return 0;
+}
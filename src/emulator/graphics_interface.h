@@ -1,19 +1,17 @@
 #ifndef GRAPHICS_INTERFACE_H
 #define GRAPHICS_INTERFACE_H
 
-#include "cpu/cpu.h"
-#include "memory/mem.h"
+#include "machine/machine.h"
 
 /**
  * @brief Initializes the graphical interface
  * 
  * @param argc 
  * @param argv 
- * @param cpu 
- * @param memory 
+ * @param machine Machine shown and controlled by the interface
  * @return int 
  */
-int graphicsInit(int argc, char **argv, ZilogZ80_t *cpu);
+int graphicsInit(int argc, char **argv, Machine_t *machine);
 
 /**
  * @brief Destroys the graphical interface
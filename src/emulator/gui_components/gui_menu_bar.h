@@ -27,6 +27,7 @@ typedef struct
     GuiMenuButton cpuButton;
     GuiMenuButton ramMemoryButton;
     GuiMenuButton romMemoryButton;
+    GuiMenuButton profileButton;
     GuiMenuButton displayButton;
 
     GuiMenuButton startEmulationButton;
@@ -47,6 +48,7 @@ typedef struct
     bool cpuButtonActive;
     bool ramMemoryButtonActive;
     bool romMemoryButtonActive;
+    bool profileButtonActive;
     bool displayButtonActive;
 
     bool startEmulationButtonActive;
@@ -67,6 +69,7 @@ typedef struct
     bool cpuButtonHover;
     bool ramMemoryButtonHover;
     bool romMemoryButtonHover;
+    bool profileButtonHover;
     bool displayButtonHover;
 
     bool startEmulationButtonHover;
@@ -167,6 +170,14 @@ void GuiMenuBar(GuiMenuBarState *state)
         state->buttonSize,
         state->buttonSize
     }, GuiIconText(ICON_ROM, ""));
+
+    state->profileButtonActive = GuiButton((Rectangle)
+    {
+        state->openButton.position.x + BUTTON_SPACING(state->buttonSize, state->buttonPadding, 5),
+        state->openButton.position.y,
+        state->buttonSize,
+        state->buttonSize
+    }, GuiIconText(ICON_INFO, ""));
     
     state->startEmulationButtonActive = GuiButton((Rectangle)
     {
@@ -203,6 +214,14 @@ void GuiMenuBar(GuiMenuBarState *state)
         state->buttonSize,
         state->buttonSize
     }, GuiIconText(ICON_RESTART, ""));
+
+    state->settingsButtonActive = GuiButton((Rectangle)
+    {
+        state->openButton.position.x + BUTTON_SPACING(state->buttonSize, state->buttonPadding, 11),
+        state->openButton.position.y,
+        state->buttonSize,
+        state->buttonSize
+    }, GuiIconText(ICON_GEAR, ""));
     /* -------------------------------------------------------------------------- */
 
     /* ----------------------------- Check on hover ----------------------------- */
@@ -246,6 +265,14 @@ void GuiMenuBar(GuiMenuBarState *state)
         state->buttonSize
     });
 
+    state->profileButtonHover = CheckCollisionPointRec(GetMousePosition(), (Rectangle)
+    {
+        state->openButton.position.x + BUTTON_SPACING(state->buttonSize, state->buttonPadding, 5),
+        state->openButton.position.y,
+        state->buttonSize,
+        state->buttonSize
+    });
+
     state->startEmulationButtonHover = CheckCollisionPointRec(GetMousePosition(), (Rectangle)
     {
         state->openButton.position.x + BUTTON_SPACING(state->buttonSize, state->buttonPadding, 6),
@@ -281,6 +308,13 @@ void GuiMenuBar(GuiMenuBarState *state)
         state->buttonSize,
         state->buttonSize
     });
+    state->settingsButtonHover = CheckCollisionPointRec(GetMousePosition(), (Rectangle)
+    {
+        state->openButton.position.x + BUTTON_SPACING(state->buttonSize, state->buttonPadding, 11),
+        state->openButton.position.y,
+        state->buttonSize,
+        state->buttonSize
+    });
     /* -------------------------------------------------------------------------- */
 }
 
@@ -292,11 +326,13 @@ char *GuiMenuBarGetTooltip(GuiMenuBarState *state, bool *isAnyHovered)
     else if(state->cpuButtonHover) text = "Open CPU window";
     else if(state->ramMemoryButtonHover) text = "Open RAM window";
     else if(state->romMemoryButtonHover) text = "Open ROM window";
+    else if(state->profileButtonHover) text = "Open opcode profile window";
     else if(state->startEmulationButtonHover) text = "Start emulation";
     else if(state->pauseEmulationButtonHover) text = "Pause emulation";
     else if(state->stepEmulationButtonHover) text = "Step emulation";
     else if(state->stopEmulationButtonHover) text = "Stop emulation";
     else if(state->restartEmulationButtonHover) text = "Restart emulation";
+    else if(state->settingsButtonHover) text = "Open preferences window";
 
 
     if(state->openButtonHover 
@@ -304,11 +340,13 @@ char *GuiMenuBarGetTooltip(GuiMenuBarState *state, bool *isAnyHovered)
     || state->cpuButtonHover 
     || state->ramMemoryButtonHover
     || state->romMemoryButtonHover
+    || state->profileButtonHover
     || state->startEmulationButtonHover
     || state->pauseEmulationButtonHover
     || state->stepEmulationButtonHover
     || state->stopEmulationButtonHover
     || state->restartEmulationButtonHover
+    || state->settingsButtonHover
     )
     {
         *isAnyHovered = true;
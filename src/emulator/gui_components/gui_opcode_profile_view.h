@@ -0,0 +1,225 @@
+#ifndef GUI_OPCODE_PROFILE_VIEW_H
+#define GUI_OPCODE_PROFILE_VIEW_H
+
+#include "raylib.h"
+#include "cpu/opcode_profile.h"
+#include <stdio.h>
+
+#define OPCODE_PROFILE_VIEW_ROWS 16
+#define OPCODE_PROFILE_VIEW_SPACING(size, padding, count) ((size + padding) * count)
+
+typedef struct
+{
+    /* ---------------------------- Window attributes --------------------------- */
+    Rectangle bounds;
+    Vector2 position;
+    int padding;
+
+    bool isWindowActive;
+
+    bool dragMode;
+    bool supportDrag;
+
+    Vector2 panOffset;
+    /* -------------------------------------------------------------------------- */
+
+    /* ----------------------- Opcode profile GUI attributes -------------------- */
+    int rowWidth;
+    int rowHeight;
+
+    /** @brief Set by the record button, the owner attaches / detaches the profile */
+    bool isRecording;
+    bool isClearPressed;
+
+    char summaryText[64];
+    char opcodeRows[OPCODE_PROFILE_VIEW_ROWS][64];
+    char pairRows[OPCODE_PROFILE_VIEW_ROWS][64];
+    /* -------------------------------------------------------------------------- */
+
+} GuiOpcodeProfileViewState;
+
+GuiOpcodeProfileViewState InitGuiOpcodeProfileView(void);
+void GuiOpcodeProfileView(GuiOpcodeProfileViewState *state);
+void GuiOpcodeProfileViewUpdate(GuiOpcodeProfileViewState *state, const OpcodeProfile_t *profile);
+
+#endif //GUI_OPCODE_PROFILE_VIEW_H
+
+#ifdef GUI_OPCODE_PROFILE_VIEW_IMPLEMENTATION
+
+#include "raygui.h"
+
+GuiOpcodeProfileViewState InitGuiOpcodeProfileView(void)
+{
+    GuiOpcodeProfileViewState state = { 0 };
+
+    /* ---------------------------- Window attributes --------------------------- */
+    state.padding = 12;
+
+    state.isWindowActive = false;
+
+    state.supportDrag = true;
+    state.dragMode = false;
+
+    state.panOffset = (Vector2){ 0, 0 };
+    /* -------------------------------------------------------------------------- */
+
+    /* ----------------------- Opcode profile GUI attributes -------------------- */
+    state.rowWidth = 220;
+    state.rowHeight = 14;
+
+    state.isRecording = false;
+    state.isClearPressed = false;
+
+    snprintf(state.summaryText, sizeof(state.summaryText), "Not recording");
+    /* -------------------------------------------------------------------------- */
+
+    state.bounds.width = state.rowWidth * 2 + state.padding * 4;
+    state.bounds.height = RAYGUI_WINDOWBOX_STATUSBAR_HEIGHT
+                        + OPCODE_PROFILE_VIEW_SPACING(state.rowHeight, 2, OPCODE_PROFILE_VIEW_ROWS + 4)
+                        + state.padding * 3;
+    state.bounds.x = GetScreenWidth() / 2 - state.bounds.width / 2;
+    state.bounds.y = GetScreenHeight() / 2 - state.bounds.height / 2;
+    state.position = (Vector2){ state.bounds.x, state.bounds.y };
+
+    return state;
+}
+
+void GuiOpcodeProfileView(GuiOpcodeProfileViewState *state)
+{
+    if(state->isWindowActive == true)
+    {
+        if(state->supportDrag == true)
+        {
+            Vector2 mousePosition = GetMousePosition();
+
+            if(IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
+            {
+                if(CheckCollisionPointRec(mousePosition, (Rectangle){ state->bounds.x, state->bounds.y, (float)state->bounds.width, RAYGUI_WINDOWBOX_STATUSBAR_HEIGHT }))
+                {
+                    state->dragMode = true;
+                    state->panOffset.x = mousePosition.x - state->bounds.x;
+                    state->panOffset.y = mousePosition.y - state->bounds.y;
+                }
+            }
+
+            if(state->dragMode == true)
+            {
+                state->bounds.x = (mousePosition.x - state->panOffset.x);
+                state->bounds.y = (mousePosition.y - state->panOffset.y);
+
+                if(state->bounds.x < 0)
+                {
+                    state->bounds.x = 0;
+                }
+                else if(state->bounds.x > (GetScreenWidth() - state->bounds.width))
+                {
+                    state->bounds.x = GetScreenWidth() - state->bounds.width;
+                }
+
+                if(state->bounds.y < 40)
+                {
+                    state->bounds.y = 40;
+                }
+                else if(state->bounds.y > (GetScreenHeight() - state->bounds.height))
+                {
+                    state->bounds.y = GetScreenHeight() - state->bounds.height;
+                }
+
+                if(IsMouseButtonReleased(MOUSE_LEFT_BUTTON))
+                {
+                    state->dragMode = false;
+                }
+            }
+        }
+
+        /* --------------------------- Render GUI elements -------------------------- */
+        if(GuiWindowBox(state->bounds, "Opcode profile") == true)
+        {
+            state->isWindowActive = false;
+        }
+
+        const Vector2 startPos = (Vector2)
+        {
+            state->bounds.x + state->padding,
+            state->bounds.y + RAYGUI_WINDOWBOX_STATUSBAR_HEIGHT + state->padding
+        };
+
+        if(GuiButton((Rectangle){ startPos.x, startPos.y, 80, state->rowHeight + 4 }, state->isRecording ? "Stop" : "Record") == true)
+        {
+            state->isRecording = !state->isRecording;
+        }
+        if(GuiButton((Rectangle){ startPos.x + 80 + state->padding, startPos.y, 80, state->rowHeight + 4 }, "Clear") == true)
+        {
+            state->isClearPressed = true;
+        }
+        GuiLabel((Rectangle){ startPos.x + (80 + state->padding) * 2, startPos.y, state->rowWidth * 2, state->rowHeight + 4 }, state->summaryText);
+
+        /* ------------------------------ Opcode tables ----------------------------- */
+        const float tableY = startPos.y + OPCODE_PROFILE_VIEW_SPACING(state->rowHeight, 2, 2);
+        const float tableHeight = OPCODE_PROFILE_VIEW_SPACING(state->rowHeight, 2, OPCODE_PROFILE_VIEW_ROWS + 1) + state->padding;
+
+        GuiGroupBox((Rectangle){ startPos.x, tableY, state->rowWidth + state->padding, tableHeight }, "Opcodes");
+        GuiGroupBox((Rectangle){ startPos.x + state->rowWidth + state->padding * 2, tableY, state->rowWidth + state->padding, tableHeight }, "Pairs");
+
+        for(int i = 0; i < OPCODE_PROFILE_VIEW_ROWS; i++)
+        {
+            const float rowY = tableY + state->padding + OPCODE_PROFILE_VIEW_SPACING(state->rowHeight, 2, i);
+
+            GuiLabel((Rectangle){ startPos.x + state->padding / 2, rowY, state->rowWidth, state->rowHeight }, state->opcodeRows[i]);
+            GuiLabel((Rectangle){ startPos.x + state->rowWidth + state->padding * 2 + state->padding / 2, rowY, state->rowWidth, state->rowHeight }, state->pairRows[i]);
+        }
+        /* -------------------------------------------------------------------------- */
+    }
+}
+
+void GuiOpcodeProfileViewUpdate(GuiOpcodeProfileViewState *state, const OpcodeProfile_t *profile)
+{
+    OpcodeProfileEntry_t entries[OPCODE_PROFILE_VIEW_ROWS];
+    OpcodePairEntry_t pairs[OPCODE_PROFILE_VIEW_ROWS];
+    char first[16];
+    char second[16];
+
+    if(state->isWindowActive == false || profile == NULL)
+    {
+        return;
+    }
+
+    double instructions = (profile->instructions > 0) ? (double)profile->instructions : 1.0;
+    double totalCycles = (profile->totalCycles > 0) ? (double)profile->totalCycles : 1.0;
+
+    snprintf(state->summaryText, sizeof(state->summaryText), "%llu instructions, %llu cycles",
+             (unsigned long long)profile->instructions, (unsigned long long)profile->totalCycles);
+
+    size_t count = opcodeProfileTop(profile, entries, OPCODE_PROFILE_VIEW_ROWS);
+    for(size_t i = 0; i < OPCODE_PROFILE_VIEW_ROWS; i++)
+    {
+        if(i < count)
+        {
+            snprintf(state->opcodeRows[i], sizeof(state->opcodeRows[i]), "%-10s %5.1f%%  %5.1f%% cyc",
+                     opcodeProfileFormat(entries[i].group, entries[i].opcode, first, sizeof(first)),
+                     (double)entries[i].count / instructions * 100.0, (double)entries[i].cycles / totalCycles * 100.0);
+        }
+        else
+        {
+            state->opcodeRows[i][0] = '\0';
+        }
+    }
+
+    count = opcodeProfileTopPairs(profile, pairs, OPCODE_PROFILE_VIEW_ROWS);
+    for(size_t i = 0; i < OPCODE_PROFILE_VIEW_ROWS; i++)
+    {
+        if(i < count)
+        {
+            snprintf(state->pairRows[i], sizeof(state->pairRows[i]), "%s, %s  %5.1f%%",
+                     opcodeProfileFormat(pairs[i].firstGroup, pairs[i].firstOpcode, first, sizeof(first)),
+                     opcodeProfileFormat(pairs[i].secondGroup, pairs[i].secondOpcode, second, sizeof(second)),
+                     (double)pairs[i].count / instructions * 100.0);
+        }
+        else
+        {
+            state->pairRows[i][0] = '\0';
+        }
+    }
+}
+
+#endif //GUI_OPCODE_PROFILE_VIEW_IMPLEMENTATION
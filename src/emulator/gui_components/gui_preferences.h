@@ -2,6 +2,7 @@
 #define GUI_PREFERENCES_H
 
 #include "raylib.h"
+#include "machine/machine_backend.h"
 
 typedef struct
 {
@@ -34,6 +35,12 @@ typedef struct
     const char *preferencesLabelText;
 
     const char *uiStyleLabelText;
+
+    const char *backendLabelText;
+    /** @brief Index of the selected execution backend (see @ref machineBackendGet) */
+    int backendIndex;
+    /** @brief Set when the user picked another backend, the owner switches the machine */
+    bool isBackendChanged;
     /* -------------------------------------------------------------------------- */
 } GuiPreferencesState;
 
@@ -73,6 +80,11 @@ GuiPreferencesState InitGuiPreferences(const Vector2 position, const int width,
 
     state.panOffset = (Vector2){ 0, 0 };
 
+    state.preferencesLabelText = "Preferences";
+    state.backendLabelText = "Execution backend";
+    state.backendIndex = 0;
+    state.isBackendChanged = false;
+
     return state;
 }
 
@@ -80,7 +92,27 @@ void GuiPreferences(GuiPreferencesState *state)
 {
     if(state->isWindowActive == true)
     {
-
+        if(GuiWindowBox(state->bounds, state->preferencesLabelText) == true)
+        {
+            state->isWindowActive = false;
+        }
+
+        const Vector2 startPos = (Vector2)
+        {
+            state->bounds.x + state->padding,
+            state->bounds.y + RAYGUI_WINDOWBOX_STATUSBAR_HEIGHT + state->padding
+        };
+        const float labelWidth = (state->bounds.width - state->padding * 2) / 2;
+        const MachineBackend_t *backend = machineBackendGet((size_t)state->backendIndex);
+
+        // One button cycles through the backends, the description of the selected one is shown below
+        GuiLabel((Rectangle){ startPos.x, startPos.y, labelWidth, state->fontSize + 4 }, state->backendLabelText);
+        if(GuiButton((Rectangle){ startPos.x + labelWidth, startPos.y, labelWidth, state->fontSize + 4 }, backend->name) == true)
+        {
+            state->backendIndex = (state->backendIndex + 1) % (int)machineBackendCount();
+            state->isBackendChanged = true;
+        }
+        GuiLabel((Rectangle){ startPos.x, startPos.y + state->fontSize + 4 + state->padding, state->bounds.width - state->padding * 2, state->fontSize + 4 }, backend->description);
     }
 }
 
@@ -0,0 +1,429 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "rom_loader.h"
+
+#include <string.h>
+#include <ctype.h>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+#include "utils/error_handler.h"
+
+/** @brief Largest image accepted (banked images included) */
+#define ROM_MAX_IMAGE_SIZE (16 * 1024 * 1024)
+/** @brief Longest Intel HEX record line (255 data bytes) */
+#define INTEL_HEX_MAX_LINE 600
+
+#define ROUND_UP_TO_PAGE(x) (((x) + MEMORY_PAGE_MASK) & ~(size_t)MEMORY_PAGE_MASK)
+
+/**
+ * @brief Returns true if the filename has an Intel HEX extension
+ *
+ * @param filename
+ * @return bool
+ */
+static bool hasHexExtension(const char *filename);
+
+/**
+ * @brief Makes sure the image is a heap buffer (base address 0) of at least requiredSize bytes.
+ * A memory mapped image is copied into the heap buffer first
+ *
+ * @param image
+ * @param requiredSize
+ * @return bool False if the size is too large or allocation failed
+ */
+static bool ensureHeapImage(RomImage_t *image, size_t requiredSize);
+
+/**
+ * @brief Appends a run of loaded bytes to the segment list, merging with the previous segment
+ *
+ * @param image
+ * @param offset
+ * @param size
+ */
+static void addSegment(RomImage_t *image, size_t offset, size_t size);
+
+/**
+ * @brief Loads a raw binary file
+ *
+ * @param image
+ * @param file
+ * @param fileSize
+ * @param loadOffset
+ * @return bool
+ */
+static bool loadBinary(RomImage_t *image, FILE *file, size_t fileSize, size_t loadOffset);
+
+/**
+ * @brief Parses the hex digits of a byte
+ *
+ * @param text Two hex digits
+ * @param value
+ * @return bool False if text does not start with two hex digits
+ */
+static bool parseHexByte(const char *text, byte_t *value);
+
+void romImageInit(RomImage_t *image)
+{
+    if(image == NULL)
+    {
+        return;
+    }
+
+    memset(image, 0x00, sizeof(RomImage_t));
+}
+
+bool romImageLoadFile(RomImage_t *image, const char *filename, RomImageFormat format, size_t loadOffset)
+{
+    if(image == NULL || filename == NULL)
+    {
+        setError(C80_ERROR_ROM_FILE_READ_ERROR);
+        return false;
+    }
+
+    FILE *file = fopen(filename, "rb");
+    if(file == NULL)
+    {
+        setError(C80_ERROR_ROM_FILE_NOT_FOUND);
+        return false;
+    }
+
+    if(format == ROM_FORMAT_AUTO)
+    {
+        format = hasHexExtension(filename) ? ROM_FORMAT_INTEL_HEX : ROM_FORMAT_BINARY;
+    }
+
+    bool isLoaded = false;
+    if(format == ROM_FORMAT_INTEL_HEX)
+    {
+        isLoaded = romImageLoadIntelHex(image, file);
+    }
+    else
+    {
+        fseek(file, 0, SEEK_END);
+        long fileSize = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        if(fileSize <= 0)
+        {
+            setError(C80_ERROR_ROM_FILE_EMPTY);
+        }
+        else
+        {
+            isLoaded = loadBinary(image, file, (size_t)fileSize, loadOffset);
+        }
+    }
+
+    fclose(file);
+
+    return isLoaded;
+}
+
+bool romImageLoadIntelHex(RomImage_t *image, FILE *stream)
+{
+    char line[INTEL_HEX_MAX_LINE];
+    size_t upperAddress = 0;
+
+    while(fgets(line, sizeof(line), stream) != NULL)
+    {
+        const char *record = line;
+        while(isspace((unsigned char)*record))
+        {
+            record++;
+        }
+        if(*record == '\0')
+        {
+            continue;
+        }
+        if(*record != ':')
+        {
+            setError(C80_ERROR_ROM_FILE_FORMAT_ERROR);
+            return false;
+        }
+        record++;
+
+        // Record header: byte count, address (2), type
+        byte_t header[4];
+        for(size_t idx = 0; idx < 4; idx++)
+        {
+            if(parseHexByte(record + idx * 2, &header[idx]) == false)
+            {
+                setError(C80_ERROR_ROM_FILE_FORMAT_ERROR);
+                return false;
+            }
+        }
+
+        byte_t byteCount = header[0];
+        size_t address = TO_WORD(header[1], header[2]);
+        byte_t type = header[3];
+        byte_t checksum = header[0] + header[1] + header[2] + header[3];
+
+        byte_t data[256];
+        const char *dataText = record + 8;
+        for(size_t idx = 0; idx <= byteCount; idx++)
+        {
+            // The checksum byte follows the data bytes
+            byte_t value;
+            if(parseHexByte(dataText + idx * 2, &value) == false)
+            {
+                setError(C80_ERROR_ROM_FILE_FORMAT_ERROR);
+                return false;
+            }
+            checksum += value;
+            data[idx] = value;
+        }
+
+        if(checksum != 0x00)
+        {
+            setError(C80_ERROR_ROM_FILE_FORMAT_ERROR);
+            return false;
+        }
+
+        switch(type)
+        {
+            case 0x00: // Data
+            {
+                size_t offset = upperAddress + address;
+                if(ensureHeapImage(image, offset + byteCount) == false)
+                {
+                    return false;
+                }
+                memcpy(image->data + offset, data, byteCount);
+                addSegment(image, offset, byteCount);
+                break;
+            }
+            case 0x01: // End of file
+                return true;
+            case 0x02: // Extended segment address
+            case 0x04: // Extended linear address
+                if(byteCount != 2)
+                {
+                    setError(C80_ERROR_ROM_FILE_FORMAT_ERROR);
+                    return false;
+                }
+                upperAddress = (size_t)TO_WORD(data[0], data[1]) << ((type == 0x02) ? 4 : 16);
+                break;
+            default: // Start addresses are not needed
+                break;
+        }
+    }
+
+    return true;
+}
+
+size_t romImageMap(const RomImage_t *image, MemoryMap_t *map, word_t windowStartAddress, size_t windowSize)
+{
+    if(image == NULL || map == NULL || image->data == NULL)
+    {
+        return 0;
+    }
+
+    size_t windowEnd = (size_t)windowStartAddress + windowSize;
+    size_t imageEnd = image->baseAddress + image->size;
+
+    size_t start = (image->baseAddress > windowStartAddress) ? image->baseAddress : windowStartAddress;
+    size_t end = (imageEnd < windowEnd) ? imageEnd : windowEnd;
+
+    if(end <= start)
+    {
+        return 0;
+    }
+
+    memoryMapMapRegion(map, (word_t)start, end - start, image->data + (start - image->baseAddress), false);
+
+    return end - start;
+}
+
+void romImageClose(RomImage_t *image)
+{
+    if(image == NULL || image->data == NULL)
+    {
+        return;
+    }
+
+#if !defined(_WIN32)
+    if(image->isMapped == true)
+    {
+        munmap(image->data, image->size);
+    }
+    else
+#endif
+    {
+        free(image->data);
+    }
+
+    romImageInit(image);
+}
+
+static bool hasHexExtension(const char *filename)
+{
+    const char *extension = strrchr(filename, '.');
+    if(extension == NULL)
+    {
+        return false;
+    }
+
+    char lower[8] = { 0 };
+    for(size_t idx = 0; idx < sizeof(lower) - 1 && extension[idx] != '\0'; idx++)
+    {
+        lower[idx] = (char)tolower((unsigned char)extension[idx]);
+    }
+
+    return strcmp(lower, ".hex") == 0 || strcmp(lower, ".ihx") == 0;
+}
+
+static bool ensureHeapImage(RomImage_t *image, size_t requiredSize)
+{
+    if(requiredSize > ROM_MAX_IMAGE_SIZE)
+    {
+        setError(C80_ERROR_ROM_FILE_TOO_LARGE);
+        return false;
+    }
+
+    if(image->isMapped == true)
+    {
+        // Mixing files forces a private copy of the mapped part
+        size_t mappedEnd = image->baseAddress + image->size;
+        size_t newSize = ROUND_UP_TO_PAGE((requiredSize > mappedEnd) ? requiredSize : mappedEnd);
+
+        byte_t *buffer = (byte_t *)calloc(newSize, sizeof(byte_t));
+        if(buffer == NULL)
+        {
+            setError(C80_ERROR_MEMORY_INIT_ERROR);
+            return false;
+        }
+        memcpy(buffer + image->baseAddress, image->data, image->size);
+
+#if !defined(_WIN32)
+        munmap(image->data, image->size);
+#endif
+        for(size_t idx = 0; idx < image->segmentCount; idx++)
+        {
+            image->segments[idx].offset += image->baseAddress;
+        }
+
+        image->data = buffer;
+        image->size = newSize;
+        image->baseAddress = 0;
+        image->isMapped = false;
+
+        return true;
+    }
+
+    if(requiredSize <= image->size)
+    {
+        return true;
+    }
+
+    size_t newSize = ROUND_UP_TO_PAGE(requiredSize);
+    byte_t *buffer = (byte_t *)realloc(image->data, newSize);
+    if(buffer == NULL)
+    {
+        setError(C80_ERROR_MEMORY_INIT_ERROR);
+        return false;
+    }
+    memset(buffer + image->size, 0x00, newSize - image->size);
+
+    image->data = buffer;
+    image->size = newSize;
+
+    return true;
+}
+
+static void addSegment(RomImage_t *image, size_t offset, size_t size)
+{
+    if(image->segmentCount > 0)
+    {
+        RomSegment_t *last = &image->segments[image->segmentCount - 1];
+        if(last->offset + last->size == offset)
+        {
+            last->size += size;
+            return;
+        }
+    }
+
+    if(image->segmentCount < ROM_MAX_SEGMENTS)
+    {
+        image->segments[image->segmentCount] = (RomSegment_t){ .offset = offset, .size = size };
+        image->segmentCount++;
+    }
+}
+
+static bool loadBinary(RomImage_t *image, FILE *file, size_t fileSize, size_t loadOffset)
+{
+    if(loadOffset + fileSize > ROM_MAX_IMAGE_SIZE)
+    {
+        setError(C80_ERROR_ROM_FILE_TOO_LARGE);
+        return false;
+    }
+
+#if !defined(_WIN32)
+    // Zero copy: the page table will point straight into the page cache. The mapping is
+    // rounded up to whole emulator pages, the tail of the last one reads as zero
+    if(image->data == NULL && (loadOffset & MEMORY_PAGE_MASK) == 0)
+    {
+        size_t mappedSize = ROUND_UP_TO_PAGE(fileSize);
+        void *mapping = mmap(NULL, mappedSize, PROT_READ, MAP_SHARED, fileno(file), 0);
+
+        if(mapping != MAP_FAILED)
+        {
+            image->data = (byte_t *)mapping;
+            image->size = mappedSize;
+            image->baseAddress = loadOffset;
+            image->isMapped = true;
+            addSegment(image, 0, fileSize);
+
+            return true;
+        }
+    }
+#endif
+
+    if(ensureHeapImage(image, loadOffset + fileSize) == false)
+    {
+        return false;
+    }
+
+    if(fread(image->data + loadOffset, sizeof(byte_t), fileSize, file) != fileSize)
+    {
+        setError(C80_ERROR_ROM_FILE_READ_ERROR);
+        return false;
+    }
+    addSegment(image, loadOffset, fileSize);
+
+    return true;
+}
+
+static bool parseHexByte(const char *text, byte_t *value)
+{
+    byte_t result = 0;
+
+    for(size_t idx = 0; idx < 2; idx++)
+    {
+        char digit = text[idx];
+        result <<= 4;
+
+        if(digit >= '0' && digit <= '9')
+        {
+            result |= (byte_t)(digit - '0');
+        }
+        else if(digit >= 'A' && digit <= 'F')
+        {
+            result |= (byte_t)(digit - 'A' + 10);
+        }
+        else if(digit >= 'a' && digit <= 'f')
+        {
+            result |= (byte_t)(digit - 'a' + 10);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    *value = result;
+    return true;
+}
@@ -0,0 +1,106 @@
+#ifndef ROM_LOADER_H
+#define ROM_LOADER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "utils/utils.h"
+#include "memory/memory_map.h"
+
+/** @brief Maximum number of segments tracked for one image */
+#define ROM_MAX_SEGMENTS 32
+
+/**
+ * @brief Enum struct for defining the supported image formats
+ */
+typedef enum RomImageFormat
+{
+    /** @brief Detect by extension (.hex / .ihx = Intel HEX, everything else raw binary) */
+    ROM_FORMAT_AUTO = 0,
+    /** @brief Raw binary, loaded at the given offset */
+    ROM_FORMAT_BINARY,
+    /** @brief Intel HEX (data, EOF, extended segment / linear address records) */
+    ROM_FORMAT_INTEL_HEX
+} RomImageFormat;
+
+/**
+ * @brief Contiguous run of loaded bytes inside an image
+ */
+typedef struct RomSegment_t
+{
+    /** @brief Offset of the segment inside the image */
+    size_t offset;
+    size_t size;
+} RomSegment_t;
+
+/**
+ * @brief ROM image, either a read-only memory mapping of the file or a heap buffer for
+ * formats that have to be parsed or images assembled from several files
+ */
+typedef struct RomImage_t
+{
+    /** @brief Image data, byte 0 belongs to baseAddress */
+    byte_t *data;
+    /** @brief Size of the image (multiple of @ref MEMORY_PAGE_SIZE) */
+    size_t size;
+    /** @brief Address the first byte of the image is loaded to */
+    size_t baseAddress;
+
+    /** @brief True if data is a read-only mapping of the file (zero copy) */
+    bool isMapped;
+
+    /** @brief Loaded segments, in load order */
+    RomSegment_t segments[ROM_MAX_SEGMENTS];
+    size_t segmentCount;
+} RomImage_t;
+
+/**
+ * @brief Initializes an empty image
+ *
+ * @param image
+ */
+void romImageInit(RomImage_t *image);
+
+/**
+ * @brief Loads a file into the image. The first raw binary loaded at a page aligned offset
+ * is memory mapped read-only, every other case is parsed / copied into a heap buffer.
+ * Can be called several times to build multi-segment images
+ *
+ * @param image
+ * @param filename
+ * @param format
+ * @param loadOffset Offset of the file inside the image (binary only, HEX carries addresses)
+ * @return bool False on error (see error handler)
+ */
+bool romImageLoadFile(RomImage_t *image, const char *filename, RomImageFormat format, size_t loadOffset);
+
+/**
+ * @brief Parses Intel HEX records from a stream into the image
+ *
+ * @param image
+ * @param stream
+ * @return bool False on malformed records or checksum errors
+ */
+bool romImageLoadIntelHex(RomImage_t *image, FILE *stream);
+
+/**
+ * @brief Maps the part of the image that falls into a window of the address space as read-only
+ * pages. Nothing is copied, the page table points into the image
+ *
+ * @param image
+ * @param map
+ * @param windowStartAddress Page aligned start of the ROM window
+ * @param windowSize Page aligned size of the ROM window
+ * @return size_t Number of bytes mapped
+ */
+size_t romImageMap(const RomImage_t *image, MemoryMap_t *map, word_t windowStartAddress, size_t windowSize);
+
+/**
+ * @brief Releases the mapping / buffer of the image
+ *
+ * @param image
+ */
+void romImageClose(RomImage_t *image);
+
+#endif // ROM_LOADER_H
@@ -0,0 +1,323 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+// MAP_ANONYMOUS is not part of POSIX.1-2008
+#define _DEFAULT_SOURCE
+#endif
+
+#include "rom_store.h"
+
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+#include "utils/error_handler.h"
+
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x00000100000001B3ULL
+
+#define ROUND_UP_TO_PAGE(x) (((x) + MEMORY_PAGE_MASK) & ~(size_t)MEMORY_PAGE_MASK)
+
+/**
+ * @brief Hash of data zero padded to a whole number of pages, i.e. the hash of the image
+ * the data ends up in
+ *
+ * @param data
+ * @param size
+ * @return qword_t
+ */
+static qword_t hashPadded(const byte_t *data, size_t size);
+
+/**
+ * @brief Looks up an entry whose image holds the given data (zero padded). Store has to be locked
+ *
+ * @param store
+ * @param hash Hash returned by @ref hashPadded
+ * @param data
+ * @param size
+ * @return RomStoreEntry_t* NULL if the contents are not in the store
+ */
+static RomStoreEntry_t *findEntry(RomStore_t *store, qword_t hash, const byte_t *data, size_t size);
+
+/**
+ * @brief Adds an entry taking ownership of the image. Store has to be locked
+ *
+ * @param store
+ * @param hash
+ * @param image
+ * @return RomStoreEntry_t* NULL if memory could not be allocated
+ */
+static RomStoreEntry_t *addEntry(RomStore_t *store, qword_t hash, const RomImage_t *image);
+
+/**
+ * @brief Copies data into a fresh read-only page aligned image
+ *
+ * @param image
+ * @param data
+ * @param size
+ * @return bool
+ */
+static bool createReadOnlyImage(RomImage_t *image, const byte_t *data, size_t size);
+
+void romStoreInit(RomStore_t *store)
+{
+    if(store == NULL)
+    {
+        return;
+    }
+
+    store->entries = NULL;
+    store->entryCount = 0;
+    store->entryCapacity = 0;
+    mutexInit(&store->mutex);
+}
+
+void romStoreDestroy(RomStore_t *store)
+{
+    if(store == NULL)
+    {
+        return;
+    }
+
+    for(size_t idx = 0; idx < store->entryCount; idx++)
+    {
+        romImageClose(&store->entries[idx]->image);
+        free(store->entries[idx]);
+    }
+    free(store->entries);
+
+    store->entries = NULL;
+    store->entryCount = 0;
+    store->entryCapacity = 0;
+    mutexDestroy(&store->mutex);
+}
+
+const RomImage_t *romStoreAcquireFile(RomStore_t *store, const char *filename, RomImageFormat format)
+{
+    RomImage_t image;
+    romImageInit(&image);
+
+    if(romImageLoadFile(&image, filename, format, 0) == false)
+    {
+        romImageClose(&image);
+        return NULL;
+    }
+
+    // Hashing happens outside of the lock, only the lookup is serialized
+    qword_t hash = hashPadded(image.data, image.size);
+
+    mutexLock(&store->mutex);
+    RomStoreEntry_t *entry = findEntry(store, hash, image.data, image.size);
+    if(entry != NULL)
+    {
+        entry->refCount++;
+        romImageClose(&image);
+    }
+    else
+    {
+        entry = addEntry(store, hash, &image);
+        if(entry == NULL)
+        {
+            romImageClose(&image);
+        }
+    }
+    mutexUnlock(&store->mutex);
+
+    return (entry != NULL) ? &entry->image : NULL;
+}
+
+const RomImage_t *romStoreAcquireData(RomStore_t *store, const byte_t *data, size_t size)
+{
+    if(store == NULL || data == NULL || size == 0)
+    {
+        return NULL;
+    }
+
+    qword_t hash = hashPadded(data, size);
+
+    mutexLock(&store->mutex);
+    RomStoreEntry_t *entry = findEntry(store, hash, data, size);
+    if(entry != NULL)
+    {
+        entry->refCount++;
+    }
+    else
+    {
+        RomImage_t image;
+        if(createReadOnlyImage(&image, data, size) == true)
+        {
+            entry = addEntry(store, hash, &image);
+            if(entry == NULL)
+            {
+                romImageClose(&image);
+            }
+        }
+    }
+    mutexUnlock(&store->mutex);
+
+    return (entry != NULL) ? &entry->image : NULL;
+}
+
+void romStoreRelease(RomStore_t *store, const RomImage_t *image)
+{
+    if(store == NULL || image == NULL)
+    {
+        return;
+    }
+
+    mutexLock(&store->mutex);
+    for(size_t idx = 0; idx < store->entryCount; idx++)
+    {
+        RomStoreEntry_t *entry = store->entries[idx];
+        if(&entry->image != image)
+        {
+            continue;
+        }
+
+        entry->refCount--;
+        if(entry->refCount == 0)
+        {
+            romImageClose(&entry->image);
+            free(entry);
+
+            store->entries[idx] = store->entries[store->entryCount - 1];
+            store->entryCount--;
+        }
+        break;
+    }
+    mutexUnlock(&store->mutex);
+}
+
+size_t romStoreGetEntryCount(RomStore_t *store)
+{
+    mutexLock(&store->mutex);
+    size_t count = store->entryCount;
+    mutexUnlock(&store->mutex);
+
+    return count;
+}
+
+qword_t romStoreHash(const byte_t *data, size_t size)
+{
+    qword_t hash = FNV_OFFSET_BASIS;
+
+    for(size_t idx = 0; idx < size; idx++)
+    {
+        hash ^= data[idx];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+static qword_t hashPadded(const byte_t *data, size_t size)
+{
+    qword_t hash = romStoreHash(data, size);
+
+    for(size_t idx = size; idx < ROUND_UP_TO_PAGE(size); idx++)
+    {
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+static RomStoreEntry_t *findEntry(RomStore_t *store, qword_t hash, const byte_t *data, size_t size)
+{
+    for(size_t idx = 0; idx < store->entryCount; idx++)
+    {
+        RomStoreEntry_t *entry = store->entries[idx];
+
+        // The hash only narrows the search, equal contents are confirmed byte by byte
+        if(entry->hash != hash
+            || entry->image.size != ROUND_UP_TO_PAGE(size)
+            || memcmp(entry->image.data, data, size) != 0)
+        {
+            continue;
+        }
+
+        bool isPaddingEqual = true;
+        for(size_t offset = size; offset < entry->image.size; offset++)
+        {
+            isPaddingEqual &= (entry->image.data[offset] == 0x00);
+        }
+        if(isPaddingEqual == true)
+        {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+static RomStoreEntry_t *addEntry(RomStore_t *store, qword_t hash, const RomImage_t *image)
+{
+    if(store->entryCount == store->entryCapacity)
+    {
+        size_t newCapacity = (store->entryCapacity == 0) ? 8 : store->entryCapacity * 2;
+        RomStoreEntry_t **entries = (RomStoreEntry_t **)realloc(store->entries, newCapacity * sizeof(RomStoreEntry_t *));
+        if(entries == NULL)
+        {
+            setError(C80_ERROR_MEMORY_INIT_ERROR);
+            return NULL;
+        }
+
+        store->entries = entries;
+        store->entryCapacity = newCapacity;
+    }
+
+    RomStoreEntry_t *entry = (RomStoreEntry_t *)malloc(sizeof(RomStoreEntry_t));
+    if(entry == NULL)
+    {
+        setError(C80_ERROR_MEMORY_INIT_ERROR);
+        return NULL;
+    }
+
+    entry->hash = hash;
+    entry->image = *image;
+    entry->refCount = 1;
+
+    store->entries[store->entryCount] = entry;
+    store->entryCount++;
+
+    return entry;
+}
+
+static bool createReadOnlyImage(RomImage_t *image, const byte_t *data, size_t size)
+{
+    romImageInit(image);
+
+    size_t imageSize = ROUND_UP_TO_PAGE(size);
+
+#if !defined(_WIN32)
+    void *pages = mmap(NULL, imageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(pages == MAP_FAILED)
+    {
+        setError(C80_ERROR_MEMORY_INIT_ERROR);
+        return false;
+    }
+
+    memcpy(pages, data, size);
+    // Shared pages must never be written by any instance
+    mprotect(pages, imageSize, PROT_READ);
+
+    image->isMapped = true;
+#else
+    void *pages = calloc(imageSize, sizeof(byte_t));
+    if(pages == NULL)
+    {
+        setError(C80_ERROR_MEMORY_INIT_ERROR);
+        return false;
+    }
+
+    memcpy(pages, data, size);
+#endif
+
+    image->data = (byte_t *)pages;
+    image->size = imageSize;
+    image->segments[0] = (RomSegment_t){ .offset = 0, .size = size };
+    image->segmentCount = 1;
+
+    return true;
+}
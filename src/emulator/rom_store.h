@@ -0,0 +1,98 @@
+#ifndef ROM_STORE_H
+#define ROM_STORE_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "utils/utils.h"
+#include "utils/threading.h"
+#include "emulator/rom_loader.h"
+
+/**
+ * @brief Shared, read-only ROM image
+ */
+typedef struct RomStoreEntry_t
+{
+    /** @brief Content hash of the image */
+    qword_t hash;
+    /** @brief Image data, never written after it was added to the store */
+    RomImage_t image;
+    /** @brief Number of machines using the image */
+    size_t refCount;
+} RomStoreEntry_t;
+
+/**
+ * @brief Content addressed store of ROM images. Machines loading the same ROM contents get the
+ * same read-only pages, only RAM / VRAM stay per instance. The store is thread safe
+ */
+typedef struct RomStore_t
+{
+    RomStoreEntry_t **entries;
+    size_t entryCount;
+    size_t entryCapacity;
+
+    Mutex_t mutex;
+} RomStore_t;
+
+/**
+ * @brief Initializes an empty store
+ *
+ * @param store
+ */
+void romStoreInit(RomStore_t *store);
+
+/**
+ * @brief Releases every image of the store, all acquired images become invalid
+ *
+ * @param store
+ */
+void romStoreDestroy(RomStore_t *store);
+
+/**
+ * @brief Loads a ROM file (see @ref romImageLoadFile) and returns the shared image with the
+ * same contents. The freshly loaded file is dropped if the contents are already in the store
+ *
+ * @param store
+ * @param filename
+ * @param format
+ * @return const RomImage_t* NULL if the file could not be loaded
+ */
+const RomImage_t *romStoreAcquireFile(RomStore_t *store, const char *filename, RomImageFormat format);
+
+/**
+ * @brief Returns the shared image with the given contents, the data is copied into read-only
+ * pages if the contents are not in the store yet
+ *
+ * @param store
+ * @param data
+ * @param size
+ * @return const RomImage_t* NULL if memory could not be allocated
+ */
+const RomImage_t *romStoreAcquireData(RomStore_t *store, const byte_t *data, size_t size);
+
+/**
+ * @brief Drops a reference to an image, the image is freed with its last reference
+ *
+ * @param store
+ * @param image Image returned by one of the acquire functions
+ */
+void romStoreRelease(RomStore_t *store, const RomImage_t *image);
+
+/**
+ * @brief Returns the number of distinct images in the store
+ *
+ * @param store
+ * @return size_t
+ */
+size_t romStoreGetEntryCount(RomStore_t *store);
+
+/**
+ * @brief Content hash used by the store (64 bit FNV-1a)
+ *
+ * @param data
+ * @param size
+ * @return qword_t
+ */
+qword_t romStoreHash(const byte_t *data, size_t size);
+
+#endif // ROM_STORE_H
@@ -0,0 +1,454 @@
+#include "symbol_table.h"
+
+#include <string.h>
+#include <ctype.h>
+
+#include "utils/error_handler.h"
+
+/** @brief Longest line of a symbol file or listing, the rest of a longer line is ignored */
+#define SYMBOL_MAX_LINE 512
+/** @brief Tokens looked at per line */
+#define SYMBOL_MAX_TOKENS 16
+
+/**
+ * @brief Returns true if the filename has a listing extension (.lst)
+ *
+ * @param filename
+ * @return bool
+ */
+static bool hasListingExtension(const char *filename);
+
+/**
+ * @brief Splits a line at white space, in place. A ';' starts a comment
+ *
+ * @param line
+ * @param tokens
+ * @return int Number of tokens
+ */
+static int tokenize(char *line, char **tokens);
+
+/**
+ * @brief Reads a line, dropping the rest of lines longer than the buffer
+ *
+ * @param line SYMBOL_MAX_LINE bytes
+ * @param stream
+ * @return bool False at the end of the stream
+ */
+static bool readLine(char *line, FILE *stream);
+
+/**
+ * @brief Parses an assembler number: 0x1234, $1234, #1234, 1234h or decimal
+ *
+ * @param text
+ * @param value Lower 16 bits (some assemblers put the bank above them)
+ * @return bool
+ */
+static bool parseNumber(const char *text, word_t *value);
+
+/**
+ * @brief Parses a run of hex digits
+ *
+ * @param text
+ * @param digits Exact number of digits, 0 accepts 1 to 8
+ * @param value Lower 16 bits
+ * @return bool
+ */
+static bool parseHex(const char *text, size_t digits, word_t *value);
+
+/**
+ * @brief Adds a label unless it is local, strips a trailing ':' and a ".local" part
+ *
+ * @param table
+ * @param label
+ * @param address
+ * @return bool True if the label was added
+ */
+static bool addLabel(SymbolTable_t *table, const char *label, word_t address);
+
+/**
+ * @brief Compares two strings ignoring case
+ *
+ * @param first
+ * @param second
+ * @return bool
+ */
+static bool equalsIgnoreCase(const char *first, const char *second);
+
+/**
+ * @brief qsort comparator of @ref Symbol_t, by address then name
+ */
+static int compareSymbols(const void *first, const void *second);
+
+void symbolTableInit(SymbolTable_t *table)
+{
+    if(table == NULL)
+    {
+        return;
+    }
+
+    memset(table, 0x00, sizeof(SymbolTable_t));
+}
+
+void symbolTableDestroy(SymbolTable_t *table)
+{
+    if(table == NULL)
+    {
+        return;
+    }
+
+    free(table->symbols);
+    memset(table, 0x00, sizeof(SymbolTable_t));
+}
+
+bool symbolTableAdd(SymbolTable_t *table, const char *name, word_t address)
+{
+    if(table->count == table->capacity)
+    {
+        size_t capacity = (table->capacity > 0) ? table->capacity * 2 : 256;
+        Symbol_t *symbols = (Symbol_t *)realloc(table->symbols, capacity * sizeof(Symbol_t));
+
+        if(symbols == NULL)
+        {
+            setError(C80_ERROR_MEMORY_INIT_ERROR);
+            return false;
+        }
+
+        table->symbols = symbols;
+        table->capacity = capacity;
+    }
+
+    Symbol_t *symbol = &table->symbols[table->count++];
+    symbol->address = address;
+    snprintf(symbol->name, sizeof(symbol->name), "%s", name);
+
+    return true;
+}
+
+void symbolTableSort(SymbolTable_t *table)
+{
+    if(table->count > 0)
+    {
+        qsort(table->symbols, table->count, sizeof(Symbol_t), compareSymbols);
+    }
+}
+
+bool symbolTableLoadFile(SymbolTable_t *table, const char *filename)
+{
+    if(table == NULL || filename == NULL)
+    {
+        setError(C80_ERROR_SYMBOL_FILE_READ_ERROR);
+        return false;
+    }
+
+    FILE *file = fopen(filename, "r");
+    if(file == NULL)
+    {
+        setError(C80_ERROR_SYMBOL_FILE_NOT_FOUND);
+        return false;
+    }
+
+    size_t count = (hasListingExtension(filename) == true)
+        ? symbolTableLoadListing(table, file)
+        : symbolTableLoadSym(table, file);
+
+    fclose(file);
+
+    if(count == 0)
+    {
+        setError(C80_ERROR_SYMBOL_FILE_FORMAT_ERROR);
+        return false;
+    }
+
+    symbolTableSort(table);
+
+    return true;
+}
+
+size_t symbolTableLoadSym(SymbolTable_t *table, FILE *stream)
+{
+    char line[SYMBOL_MAX_LINE];
+    char *tokens[SYMBOL_MAX_TOKENS];
+    size_t count = 0;
+
+    while(readLine(line, stream) == true)
+    {
+        int tokenCount = tokenize(line, tokens);
+        word_t address;
+
+        if(tokenCount >= 3
+            && (equalsIgnoreCase(tokens[1], "equ") == true || strcmp(tokens[1], "=") == 0)
+            && parseNumber(tokens[2], &address) == true)
+        {
+            count += (addLabel(table, tokens[0], address) == true) ? 1 : 0;
+        }
+        else if(tokenCount >= 2)
+        {
+            // Optional bank in front of the address
+            const char *text = strchr(tokens[0], ':');
+            text = (text != NULL) ? text + 1 : tokens[0];
+
+            if(parseHex(text, 0, &address) == true)
+            {
+                count += (addLabel(table, tokens[1], address) == true) ? 1 : 0;
+            }
+        }
+    }
+
+    return count;
+}
+
+size_t symbolTableLoadListing(SymbolTable_t *table, FILE *stream)
+{
+    char line[SYMBOL_MAX_LINE];
+    char *tokens[SYMBOL_MAX_TOKENS];
+    size_t count = 0;
+
+    while(readLine(line, stream) == true)
+    {
+        int tokenCount = tokenize(line, tokens);
+        int labelIndex = -1;
+
+        for(int idx = 1; idx < tokenCount; idx++)
+        {
+            size_t length = strlen(tokens[idx]);
+            if(length > 1 && tokens[idx][length - 1] == ':')
+            {
+                labelIndex = idx;
+                break;
+            }
+        }
+
+        if(labelIndex < 0)
+        {
+            continue;
+        }
+
+        // Walk back over the instruction bytes to the address
+        int idx = labelIndex - 1;
+        word_t value;
+        while(idx >= 0 && parseHex(tokens[idx], 2, &value) == true)
+        {
+            idx--;
+        }
+
+        if(idx >= 0 && parseHex(tokens[idx], 4, &value) == true)
+        {
+            count += (addLabel(table, tokens[labelIndex], value) == true) ? 1 : 0;
+        }
+    }
+
+    return count;
+}
+
+const Symbol_t *symbolTableLookup(const SymbolTable_t *table, word_t address)
+{
+    if(table == NULL || table->count == 0 || table->symbols[0].address > address)
+    {
+        return NULL;
+    }
+
+    // Last symbol at or below the address
+    size_t low = 0;
+    size_t high = table->count;
+    while(high - low > 1)
+    {
+        size_t middle = low + (high - low) / 2;
+
+        if(table->symbols[middle].address <= address)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    // Several names for one address: the first in sort order wins
+    while(low > 0 && table->symbols[low - 1].address == table->symbols[low].address)
+    {
+        low--;
+    }
+
+    return &table->symbols[low];
+}
+
+static bool hasListingExtension(const char *filename)
+{
+    const char *extension = strrchr(filename, '.');
+
+    return extension != NULL && equalsIgnoreCase(extension, ".lst") == true;
+}
+
+static int tokenize(char *line, char **tokens)
+{
+    int count = 0;
+    char *cursor = line;
+
+    while(*cursor != '\0' && *cursor != ';' && count < SYMBOL_MAX_TOKENS)
+    {
+        while(*cursor != '\0' && isspace((unsigned char)*cursor))
+        {
+            cursor++;
+        }
+        if(*cursor == '\0' || *cursor == ';')
+        {
+            break;
+        }
+
+        tokens[count++] = cursor;
+        while(*cursor != '\0' && *cursor != ';' && !isspace((unsigned char)*cursor))
+        {
+            cursor++;
+        }
+
+        if(*cursor == ';')
+        {
+            *cursor = '\0';
+            break;
+        }
+        if(*cursor != '\0')
+        {
+            *cursor++ = '\0';
+        }
+    }
+
+    return count;
+}
+
+static bool readLine(char *line, FILE *stream)
+{
+    if(fgets(line, SYMBOL_MAX_LINE, stream) == NULL)
+    {
+        return false;
+    }
+
+    size_t length = strlen(line);
+    if(length > 0 && line[length - 1] != '\n' && feof(stream) == 0)
+    {
+        int character;
+        while((character = fgetc(stream)) != EOF && character != '\n')
+        {
+        }
+    }
+
+    return true;
+}
+
+static bool parseNumber(const char *text, word_t *value)
+{
+    size_t length = strlen(text);
+
+    if(strncmp(text, "0x", 2) == 0 || strncmp(text, "0X", 2) == 0)
+    {
+        return parseHex(text + 2, 0, value);
+    }
+    if(text[0] == '$' || text[0] == '#')
+    {
+        return parseHex(text + 1, 0, value);
+    }
+    if(length > 1 && (text[length - 1] == 'h' || text[length - 1] == 'H'))
+    {
+        char digits[16];
+
+        if(length - 1 >= sizeof(digits))
+        {
+            return false;
+        }
+        memcpy(digits, text, length - 1);
+        digits[length - 1] = '\0';
+
+        return parseHex(digits, 0, value);
+    }
+
+    if(length == 0 || length > 10)
+    {
+        return false;
+    }
+
+    unsigned long number = 0;
+    for(size_t idx = 0; idx < length; idx++)
+    {
+        if(!isdigit((unsigned char)text[idx]))
+        {
+            return false;
+        }
+        number = number * 10 + (unsigned long)(text[idx] - '0');
+    }
+
+    *value = (word_t)(number & 0xFFFF);
+    return true;
+}
+
+static bool parseHex(const char *text, size_t digits, word_t *value)
+{
+    size_t length = strlen(text);
+
+    if(length == 0 || length > 8 || (digits != 0 && length != digits))
+    {
+        return false;
+    }
+
+    dword_t number = 0;
+    for(size_t idx = 0; idx < length; idx++)
+    {
+        if(!isxdigit((unsigned char)text[idx]))
+        {
+            return false;
+        }
+        number = (number << 4) | (dword_t)(isdigit((unsigned char)text[idx])
+            ? text[idx] - '0'
+            : tolower((unsigned char)text[idx]) - 'a' + 10);
+    }
+
+    *value = (word_t)(number & 0xFFFF);
+    return true;
+}
+
+static bool addLabel(SymbolTable_t *table, const char *label, word_t address)
+{
+    char name[SYMBOL_MAX_NAME];
+    size_t length = 0;
+
+    if(!isalpha((unsigned char)label[0]) && label[0] != '_')
+    {
+        return false;
+    }
+
+    while(label[length] != '\0' && label[length] != ':' && label[length] != '.' && length < sizeof(name) - 1)
+    {
+        name[length] = label[length];
+        length++;
+    }
+    name[length] = '\0';
+
+    return symbolTableAdd(table, name, address);
+}
+
+static bool equalsIgnoreCase(const char *first, const char *second)
+{
+    while(*first != '\0' && *second != '\0')
+    {
+        if(tolower((unsigned char)*first) != tolower((unsigned char)*second))
+        {
+            return false;
+        }
+        first++;
+        second++;
+    }
+
+    return *first == *second;
+}
+
+static int compareSymbols(const void *first, const void *second)
+{
+    const Symbol_t *a = (const Symbol_t *)first;
+    const Symbol_t *b = (const Symbol_t *)second;
+
+    if(a->address != b->address)
+    {
+        return (a->address < b->address) ? -1 : 1;
+    }
+
+    return strcmp(a->name, b->name);
+}
@@ -0,0 +1,106 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "utils/utils.h"
+
+/** @brief Longest symbol name kept, longer names are cut */
+#define SYMBOL_MAX_NAME 64
+
+/**
+ * @brief Named guest address
+ */
+typedef struct Symbol_t
+{
+    word_t address;
+    char name[SYMBOL_MAX_NAME];
+} Symbol_t;
+
+/**
+ * @brief Symbols of the guest program, sorted by address after loading
+ */
+typedef struct SymbolTable_t
+{
+    Symbol_t *symbols;
+    size_t count;
+    size_t capacity;
+} SymbolTable_t;
+
+/**
+ * @brief Initializes an empty table
+ *
+ * @param table
+ */
+void symbolTableInit(SymbolTable_t *table);
+
+/**
+ * @brief Frees the symbols
+ *
+ * @param table
+ */
+void symbolTableDestroy(SymbolTable_t *table);
+
+/**
+ * @brief Adds a symbol, call @ref symbolTableSort before looking anything up
+ *
+ * @param table
+ * @param name
+ * @param address
+ * @return bool False if out of memory
+ */
+bool symbolTableAdd(SymbolTable_t *table, const char *name, word_t address);
+
+/**
+ * @brief Sorts the symbols by address
+ *
+ * @param table
+ */
+void symbolTableSort(SymbolTable_t *table);
+
+/**
+ * @brief Loads the labels of a symbol file (.sym, .map) or an assembler listing (.lst) and sorts
+ * the table
+ *
+ * Symbol files take one label per line, "name: EQU 0x1234", "name equ 1234h", "name = $1234"
+ * or "[bank:]1234 name". Listings take labels defined as "name:" after the address and the
+ * bytes of the line ("12  0100 3E 01   main: ld a,1"). Local labels (".loop", "@@1") are
+ * skipped, "main.loop" counts as part of main
+ *
+ * @param table
+ * @param filename
+ * @return bool False if the file can not be read or holds no symbols (see error handler)
+ */
+bool symbolTableLoadFile(SymbolTable_t *table, const char *filename);
+
+/**
+ * @brief Parses a symbol file from a stream (see @ref symbolTableLoadFile)
+ *
+ * @param table
+ * @param stream
+ * @return size_t Number of symbols added
+ */
+size_t symbolTableLoadSym(SymbolTable_t *table, FILE *stream);
+
+/**
+ * @brief Parses an assembler listing from a stream (see @ref symbolTableLoadFile)
+ *
+ * @param table
+ * @param stream
+ * @return size_t Number of symbols added
+ */
+size_t symbolTableLoadListing(SymbolTable_t *table, FILE *stream);
+
+/**
+ * @brief Returns the symbol an address belongs to: the one with the highest address at or
+ * below it
+ *
+ * @param table
+ * @param address
+ * @return const Symbol_t* NULL if every symbol is above the address
+ */
+const Symbol_t *symbolTableLookup(const SymbolTable_t *table, word_t address);
+
+#endif // SYMBOL_TABLE_H
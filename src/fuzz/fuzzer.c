@@ -0,0 +1,931 @@
+#include "fuzz/fuzzer.h"
+
+#include <string.h>
+
+#include "utils/clock.h"
+
+/** @brief Cycles the ROM may run from reset until it first reads the input port */
+#define FUZZ_MAX_BOOT_CYCLES 100000000L
+/** @brief Test cases a worker runs before it publishes its counters */
+#define FUZZ_FLUSH_INTERVAL 64
+/** @brief Findings kept, later ones are only counted */
+#define FUZZ_MAX_FINDINGS 1024
+/** @brief Milliseconds between two checks of the limits by the calling thread */
+#define FUZZ_POLL_MILLISECONDS 100
+
+/**
+ * @brief Machine running test cases from the snapshot of the fuzzer
+ */
+typedef struct FuzzExecutor_t
+{
+    Fuzzer_t *fuzzer;
+    Machine_t machine;
+    /** @brief Coverage of the current test case only */
+    Coverage_t *coverage;
+    /** @brief Index of the stack guard watchpoint, -1 if there is none */
+    int stackWatchpoint;
+
+    const byte_t *input;
+    size_t inputSize;
+    size_t inputPosition;
+    /** @brief Set by the boot run when the ROM reads the input port */
+    bool isInputRead;
+
+    /** @brief PC of the finding of the last test case */
+    word_t pc;
+    /** @brief Cycles of the last test case */
+    long cycles;
+} FuzzExecutor_t;
+
+/**
+ * @brief Worker thread with its own machine and random state
+ */
+typedef struct FuzzWorker_t
+{
+    Fuzzer_t *fuzzer;
+    Thread_t thread;
+    bool isStarted;
+
+    FuzzExecutor_t executor;
+    /** @brief Everything this worker has seen, filters test cases before the lock is taken */
+    Coverage_t *seen;
+    dword_t randomState;
+
+    byte_t *data;
+    size_t size;
+    byte_t *partner;
+    size_t partnerSize;
+
+    /** @brief Counters not yet added to the fuzzer */
+    qword_t executions;
+    qword_t outcomes[FUZZ_OUTCOME_COUNT];
+    qword_t cycles;
+} FuzzWorker_t;
+
+/**
+ * @brief Creates the machine of an executor from the snapshot of the fuzzer and installs
+ * the I/O callbacks and crash watchpoints
+ *
+ * @param executor
+ * @param fuzzer
+ * @return bool False if out of memory
+ */
+static bool executorInit(FuzzExecutor_t *executor, Fuzzer_t *fuzzer);
+
+/**
+ * @brief Releases the machine and coverage map of an executor
+ *
+ * @param executor
+ */
+static void executorDestroy(FuzzExecutor_t *executor);
+
+/**
+ * @brief Runs one test case from the snapshot. Crashes found at the end of a slice are run
+ * again instruction by instruction to find the exact PC
+ *
+ * @param executor
+ * @param data
+ * @param size
+ * @return FuzzOutcome
+ */
+static FuzzOutcome executorRun(FuzzExecutor_t *executor, const byte_t *data, size_t size);
+
+/**
+ * @brief Returns the crash the machine is in, FUZZ_OUTCOME_OK if there is none
+ *
+ * @param executor
+ * @return FuzzOutcome
+ */
+static FuzzOutcome checkCrash(const FuzzExecutor_t *executor);
+
+/**
+ * @brief Runs the ROM from reset until it reads the input port and stores the state right
+ * before that instruction as the snapshot
+ *
+ * @param fuzzer
+ * @return bool False if the ROM never read the input port
+ */
+static bool boot(Fuzzer_t *fuzzer);
+
+/**
+ * @brief Thread function of a worker
+ *
+ * @param argument FuzzWorker_t
+ */
+static void workerMain(void *argument);
+
+/**
+ * @brief Picks a corpus entry (and sometimes a second one to splice with) and mutates it
+ *
+ * @param worker
+ */
+static void nextTestCase(FuzzWorker_t *worker);
+
+/**
+ * @brief Applies one random mutation to the test case of a worker
+ *
+ * @param worker
+ */
+static void mutate(FuzzWorker_t *worker);
+
+/**
+ * @brief Counts a test case, keeps it if it reached something new and records findings.
+ * Takes the lock only if needed
+ *
+ * @param worker
+ * @param outcome
+ */
+static void reportTestCase(FuzzWorker_t *worker, FuzzOutcome outcome);
+
+/**
+ * @brief Adds the pending counters of a worker to the fuzzer (lock held)
+ *
+ * @param worker
+ */
+static void flushCounters(FuzzWorker_t *worker);
+
+/**
+ * @brief Appends a test case to the corpus (lock held)
+ *
+ * @param fuzzer
+ * @param data
+ * @param size
+ * @return bool False if out of memory
+ */
+static bool addCorpus(Fuzzer_t *fuzzer, const byte_t *data, size_t size);
+
+/**
+ * @brief Counts a crash or hang, keeps its input the first time it is seen (lock held).
+ * Hangs rarely stop at the same PC, a hang is only kept if it is the first one or reached
+ * new coverage
+ *
+ * @param fuzzer
+ * @param outcome
+ * @param pc
+ * @param data
+ * @param size
+ * @param isNew True if the test case reached new coverage
+ */
+static void recordFinding(Fuzzer_t *fuzzer, FuzzOutcome outcome, word_t pc, const byte_t *data, size_t size,
+                          bool isNew);
+
+/**
+ * @brief Copies a buffer to the heap, one extra byte so empty inputs still get one
+ *
+ * @param data
+ * @param size
+ * @return byte_t* NULL if out of memory
+ */
+static byte_t *copyBytes(const byte_t *data, size_t size);
+
+/**
+ * @brief Test case input, returns the next byte and stops the machine when it is used up
+ *
+ * @param context FuzzExecutor_t
+ * @param value
+ */
+static void readInput(void *context, byte_t *value);
+
+/**
+ * @brief Input port during boot, stops the machine at the first read
+ *
+ * @param context FuzzExecutor_t
+ * @param value
+ */
+static void readBoot(void *context, byte_t *value);
+
+/**
+ * @brief Exit port, ends the test case
+ *
+ * @param context FuzzExecutor_t
+ * @param value
+ */
+static void writeExit(void *context, byte_t value);
+
+/**
+ * @brief xorshift32
+ *
+ * @param randomState
+ * @param limit
+ * @return dword_t Random number below limit (limit > 0)
+ */
+static dword_t randomBelow(dword_t *randomState, dword_t limit);
+
+/** @brief Bytes that often sit on a boundary of an input parser */
+static const byte_t interestingBytes[] = { 0x00, 0x01, 0x7F, 0x80, 0xFF, '\n', '\r', ' ', '0', '9', 'A', 'F', 'G',
+                                           'a', 'f', 'g', '/', ':', '@', '`' };
+
+static const char *outcomeNames[FUZZ_OUTCOME_COUNT] = { "ok", "hang", "invalid-opcode", "watchpoint",
+                                                        "stack-overflow" };
+
+FuzzConfig_t fuzzerDefaultConfig()
+{
+    FuzzConfig_t config;
+
+    memset(&config, 0x00, sizeof(FuzzConfig_t));
+    config.inputPort = FUZZ_DEFAULT_INPUT_PORT;
+    config.exitPort = -1;
+    config.maxCycles = FUZZ_DEFAULT_MAX_CYCLES;
+    config.maxInputSize = FUZZ_DEFAULT_MAX_INPUT_SIZE;
+    config.stackBound = -1;
+    config.seed = 1;
+
+    return config;
+}
+
+bool fuzzerInit(Fuzzer_t *fuzzer, const FuzzConfig_t *config, const char *romPath)
+{
+    memset(fuzzer, 0x00, sizeof(Fuzzer_t));
+    fuzzer->config = *config;
+    if(fuzzer->config.maxInputSize == 0)
+    {
+        fuzzer->config.maxInputSize = 1;
+    }
+
+    mutexInit(&fuzzer->lock);
+    romStoreInit(&fuzzer->romStore);
+
+    fuzzer->rom = romStoreAcquireFile(&fuzzer->romStore, romPath, ROM_FORMAT_AUTO);
+    fuzzer->coverage = coverageCreate();
+
+    if(fuzzer->rom == NULL || fuzzer->coverage == NULL || boot(fuzzer) == false)
+    {
+        fuzzerDestroy(fuzzer);
+        return false;
+    }
+
+    return true;
+}
+
+void fuzzerDestroy(Fuzzer_t *fuzzer)
+{
+    for(size_t idx = 0; idx < fuzzer->corpusCount; idx++)
+    {
+        free(fuzzer->corpus[idx].data);
+    }
+    for(size_t idx = 0; idx < fuzzer->findingCount; idx++)
+    {
+        free(fuzzer->findings[idx].input.data);
+    }
+    free(fuzzer->corpus);
+    free(fuzzer->findings);
+
+    coverageDestroy(fuzzer->coverage);
+    machineSnapshotDestroy(&fuzzer->snapshot);
+
+    if(fuzzer->rom != NULL)
+    {
+        romStoreRelease(&fuzzer->romStore, fuzzer->rom);
+    }
+    romStoreDestroy(&fuzzer->romStore);
+    mutexDestroy(&fuzzer->lock);
+
+    memset(fuzzer, 0x00, sizeof(Fuzzer_t));
+}
+
+bool fuzzerAddSeed(Fuzzer_t *fuzzer, const byte_t *data, size_t size)
+{
+    bool isAdded;
+
+    mutexLock(&fuzzer->lock);
+    isAdded = addCorpus(fuzzer, data, (size < fuzzer->config.maxInputSize) ? size : fuzzer->config.maxInputSize);
+    mutexUnlock(&fuzzer->lock);
+
+    return isAdded;
+}
+
+bool fuzzerRun(Fuzzer_t *fuzzer, void (*progress)(void *context, const Fuzzer_t *fuzzer), void *context)
+{
+    if(fuzzer->corpusCount == 0 && fuzzerAddSeed(fuzzer, (const byte_t *)"\n", 1) == false)
+    {
+        return false;
+    }
+
+    int workerCount = (fuzzer->config.workerCount > 0) ? fuzzer->config.workerCount : threadHardwareConcurrency();
+    if(workerCount < 1)
+    {
+        workerCount = 1;
+    }
+
+    FuzzWorker_t *workers = (FuzzWorker_t *)calloc((size_t)workerCount, sizeof(FuzzWorker_t));
+    if(workers == NULL)
+    {
+        return false;
+    }
+
+    bool isStarted = true;
+    for(int idx = 0; idx < workerCount && isStarted == true; idx++)
+    {
+        FuzzWorker_t *worker = &workers[idx];
+
+        worker->fuzzer = fuzzer;
+        worker->randomState = (fuzzer->config.seed + (dword_t)idx * 0x9E3779B9u) | 1;
+        worker->seen = coverageCreate();
+        worker->data = (byte_t *)malloc(fuzzer->config.maxInputSize);
+        worker->partner = (byte_t *)malloc(fuzzer->config.maxInputSize);
+
+        isStarted = worker->seen != NULL && worker->data != NULL && worker->partner != NULL
+            && executorInit(&worker->executor, fuzzer);
+    }
+
+    // The seeds run first on worker 0, their coverage is the baseline the mutations start from
+    mutexLock(&fuzzer->lock);
+    for(size_t idx = 0; idx < fuzzer->corpusCount && isStarted == true; idx++)
+    {
+        FuzzWorker_t *worker = &workers[0];
+        const FuzzInput_t *seed = &fuzzer->corpus[idx];
+        FuzzOutcome outcome = executorRun(&worker->executor, seed->data, seed->size);
+
+        worker->executions++;
+        worker->outcomes[outcome]++;
+        worker->cycles += (qword_t)worker->executor.cycles;
+
+        coverageMerge(worker->seen, worker->executor.coverage);
+        coverageMerge(fuzzer->coverage, worker->executor.coverage);
+        if(outcome != FUZZ_OUTCOME_OK)
+        {
+            recordFinding(fuzzer, outcome, worker->executor.pc, seed->data, seed->size, true);
+        }
+    }
+    flushCounters(&workers[0]);
+    mutexUnlock(&fuzzer->lock);
+
+    for(int idx = 0; idx < workerCount && isStarted == true; idx++)
+    {
+        workers[idx].isStarted = threadCreate(&workers[idx].thread, workerMain, &workers[idx]);
+        isStarted = workers[idx].isStarted;
+    }
+
+    qword_t startTime = clockNowNanoseconds();
+    qword_t lastProgress = startTime;
+
+    while(isStarted == true && atomicLoad(&fuzzer->isStopRequested) == 0)
+    {
+        threadSleepMilliseconds(FUZZ_POLL_MILLISECONDS);
+
+        qword_t now = clockNowNanoseconds();
+        if(fuzzer->config.maxSeconds > 0.0 && (double)(now - startTime) / 1e9 >= fuzzer->config.maxSeconds)
+        {
+            fuzzerStop(fuzzer);
+        }
+
+        if(progress != NULL && now - lastProgress >= 1000000000ULL)
+        {
+            mutexLock(&fuzzer->lock);
+            progress(context, fuzzer);
+            mutexUnlock(&fuzzer->lock);
+            lastProgress = now;
+        }
+    }
+
+    fuzzerStop(fuzzer);
+    for(int idx = 0; idx < workerCount; idx++)
+    {
+        if(workers[idx].isStarted == true)
+        {
+            threadJoin(&workers[idx].thread);
+        }
+
+        executorDestroy(&workers[idx].executor);
+        coverageDestroy(workers[idx].seen);
+        free(workers[idx].data);
+        free(workers[idx].partner);
+    }
+    free(workers);
+
+    if(progress != NULL && isStarted == true)
+    {
+        progress(context, fuzzer);
+    }
+
+    return isStarted;
+}
+
+FuzzOutcome fuzzerReplay(Fuzzer_t *fuzzer, const byte_t *data, size_t size, word_t *pc)
+{
+    FuzzExecutor_t executor;
+
+    if(executorInit(&executor, fuzzer) == false)
+    {
+        executorDestroy(&executor);
+        return FUZZ_OUTCOME_COUNT;
+    }
+
+    FuzzOutcome outcome = executorRun(&executor, data, size);
+    if(pc != NULL)
+    {
+        *pc = executor.pc;
+    }
+
+    executorDestroy(&executor);
+
+    return outcome;
+}
+
+void fuzzerStop(Fuzzer_t *fuzzer)
+{
+    atomicStore(&fuzzer->isStopRequested, 1);
+}
+
+const char *fuzzerOutcomeName(FuzzOutcome outcome)
+{
+    return (outcome >= 0 && outcome < FUZZ_OUTCOME_COUNT) ? outcomeNames[outcome] : "unknown";
+}
+
+static bool executorInit(FuzzExecutor_t *executor, Fuzzer_t *fuzzer)
+{
+    MachineConfig_t config = machineDefaultConfig();
+    config.romStore = &fuzzer->romStore;
+
+    memset(executor, 0x00, sizeof(FuzzExecutor_t));
+    executor->fuzzer = fuzzer;
+    executor->stackWatchpoint = -1;
+    executor->coverage = coverageCreate();
+
+    if(executor->coverage == NULL || machineInit(&executor->machine, &config) == false
+        || machineLoadRomData(&executor->machine, fuzzer->rom->data, fuzzer->rom->size) == false)
+    {
+        return false;
+    }
+
+    ZilogZ80_t *cpu = &executor->machine.cpu;
+    cpu->ioContext = executor;
+    cpu->inputCallback[fuzzer->config.inputPort] = readInput;
+    if(fuzzer->config.exitPort >= 0 && fuzzer->config.exitPort <= 0xFF)
+    {
+        cpu->outputCallback[fuzzer->config.exitPort] = writeExit;
+    }
+
+    // Any push below the bound writes into the guard, the run stops at that instruction
+    if(fuzzer->config.stackBound > FUZZ_STACK_GUARD_SIZE && fuzzer->config.stackBound <= 0x10000)
+    {
+        executor->stackWatchpoint = memoryMapAddWatchpoint(&cpu->memoryMap,
+            (word_t)(fuzzer->config.stackBound - FUZZ_STACK_GUARD_SIZE), (word_t)(fuzzer->config.stackBound - 1),
+            WATCHPOINT_WRITE, WATCHPOINT_ACTION_BREAK);
+    }
+    for(int idx = 0; idx < fuzzer->config.watchCount; idx++)
+    {
+        memoryMapAddWatchpoint(&cpu->memoryMap, fuzzer->config.watchStart[idx], fuzzer->config.watchEnd[idx],
+                               WATCHPOINT_WRITE, WATCHPOINT_ACTION_BREAK);
+    }
+
+    cpu->coverage = executor->coverage;
+
+    return true;
+}
+
+static void executorDestroy(FuzzExecutor_t *executor)
+{
+    executor->machine.cpu.coverage = NULL;
+    machineDestroy(&executor->machine);
+    coverageDestroy(executor->coverage);
+    executor->coverage = NULL;
+}
+
+static FuzzOutcome executorRun(FuzzExecutor_t *executor, const byte_t *data, size_t size)
+{
+    Machine_t *machine = &executor->machine;
+    long maxCycles = executor->fuzzer->config.maxCycles;
+    FuzzOutcome outcome = FUZZ_OUTCOME_HANG;
+
+    machineRestoreSnapshot(machine, &executor->fuzzer->snapshot);
+    errorStackReset(&machine->errors);
+    coverageClear(executor->coverage);
+
+    executor->input = data;
+    executor->inputSize = size;
+    executor->inputPosition = 0;
+    executor->cycles = 0;
+
+    while(executor->cycles < maxCycles)
+    {
+        long budget = (maxCycles - executor->cycles < FUZZ_SLICE_CYCLES) ? maxCycles - executor->cycles
+                                                                          : FUZZ_SLICE_CYCLES;
+        StopReason stopReason = machineRun(machine, budget);
+        executor->cycles += machine->cpu.runCycles;
+
+        outcome = checkCrash(executor);
+        if(outcome != FUZZ_OUTCOME_OK || stopReason != STOP_REASON_BUDGET)
+        {
+            break;
+        }
+        outcome = FUZZ_OUTCOME_HANG;
+    }
+
+    executor->pc = (outcome == FUZZ_OUTCOME_HANG) ? machine->cpu.PC : machine->cpu.stopPC;
+
+    // Watchpoints stop at the instruction, the other crashes are only seen after the slice
+    if((outcome == FUZZ_OUTCOME_INVALID_OPCODE || outcome == FUZZ_OUTCOME_STACK_OVERFLOW)
+        && machine->cpu.stopReason != STOP_REASON_WATCHPOINT)
+    {
+        long cycles = 0;
+
+        machineRestoreSnapshot(machine, &executor->fuzzer->snapshot);
+        errorStackReset(&machine->errors);
+        machine->cpu.coverage = NULL;
+        executor->inputPosition = 0;
+
+        while(cycles <= executor->cycles && machine->cpu.isHaltered == false
+              && checkCrash(executor) == FUZZ_OUTCOME_OK)
+        {
+            cycles += machineStep(machine);
+        }
+
+        executor->pc = machine->cpu.instructionPC;
+        machine->cpu.coverage = executor->coverage;
+    }
+
+    return outcome;
+}
+
+static FuzzOutcome checkCrash(const FuzzExecutor_t *executor)
+{
+    const Machine_t *machine = &executor->machine;
+    long stackBound = executor->fuzzer->config.stackBound;
+
+    if(machine->cpu.stopReason == STOP_REASON_WATCHPOINT)
+    {
+        return (machine->cpu.stopWatchpoint.watchpoint == executor->stackWatchpoint) ? FUZZ_OUTCOME_STACK_OVERFLOW
+                                                                                     : FUZZ_OUTCOME_WATCHPOINT;
+    }
+    if(machine->errors.topIndex >= 0
+        && machine->errors.errors[machine->errors.topIndex].error == C80_ERROR_CPU_INVALID_OPCODE)
+    {
+        return FUZZ_OUTCOME_INVALID_OPCODE;
+    }
+    if(stackBound >= 0 && (long)machine->cpu.SP < stackBound)
+    {
+        return FUZZ_OUTCOME_STACK_OVERFLOW;
+    }
+
+    return FUZZ_OUTCOME_OK;
+}
+
+static bool boot(Fuzzer_t *fuzzer)
+{
+    FuzzExecutor_t executor;
+    MachineSnapshot_t reset;
+    bool isBooted = false;
+
+    memset(&reset, 0x00, sizeof(MachineSnapshot_t));
+
+    if(executorInit(&executor, fuzzer) == true && machineSaveSnapshot(&executor.machine, &reset) == true)
+    {
+        Machine_t *machine = &executor.machine;
+
+        machine->cpu.coverage = NULL;
+        machine->cpu.inputCallback[fuzzer->config.inputPort] = readBoot;
+        memoryMapClearWatchpoints(&machine->cpu.memoryMap);
+        machineRun(machine, FUZZ_MAX_BOOT_CYCLES);
+
+        // The read happened inside the IN instruction, step up to the instruction before it
+        // on a second run, the snapshot is taken with the IN about to execute
+        if(executor.isInputRead == true)
+        {
+            long instructions = machine->cpu.runInstructions - 1;
+
+            machineRestoreSnapshot(machine, &reset);
+            for(long idx = 0; idx < instructions; idx++)
+            {
+                machineStep(machine);
+            }
+
+            isBooted = machineSaveSnapshot(machine, &fuzzer->snapshot);
+            fuzzer->bootCycles = machine->scheduler.totalCycles;
+        }
+    }
+
+    machineSnapshotDestroy(&reset);
+    executorDestroy(&executor);
+
+    return isBooted;
+}
+
+static void workerMain(void *argument)
+{
+    FuzzWorker_t *worker = (FuzzWorker_t *)argument;
+    Fuzzer_t *fuzzer = worker->fuzzer;
+
+    while(atomicLoad(&fuzzer->isStopRequested) == 0)
+    {
+        nextTestCase(worker);
+        reportTestCase(worker, executorRun(&worker->executor, worker->data, worker->size));
+    }
+
+    mutexLock(&fuzzer->lock);
+    flushCounters(worker);
+    mutexUnlock(&fuzzer->lock);
+}
+
+static void nextTestCase(FuzzWorker_t *worker)
+{
+    Fuzzer_t *fuzzer = worker->fuzzer;
+
+    // The corpus may grow (realloc) under the other workers, copy under the lock
+    mutexLock(&fuzzer->lock);
+    const FuzzInput_t *parent = &fuzzer->corpus[randomBelow(&worker->randomState, (dword_t)fuzzer->corpusCount)];
+    const FuzzInput_t *partner = &fuzzer->corpus[randomBelow(&worker->randomState, (dword_t)fuzzer->corpusCount)];
+
+    worker->size = parent->size;
+    memcpy(worker->data, parent->data, parent->size);
+    worker->partnerSize = partner->size;
+    memcpy(worker->partner, partner->data, partner->size);
+    mutexUnlock(&fuzzer->lock);
+
+    int mutations = 1 << (1 + randomBelow(&worker->randomState, 4));
+    for(int idx = 0; idx < mutations && idx < FUZZ_MAX_STACKED_MUTATIONS; idx++)
+    {
+        mutate(worker);
+    }
+}
+
+static void mutate(FuzzWorker_t *worker)
+{
+    dword_t *randomState = &worker->randomState;
+    size_t maxSize = worker->fuzzer->config.maxInputSize;
+    byte_t *data = worker->data;
+    size_t size = worker->size;
+
+    if(size == 0)
+    {
+        data[0] = interestingBytes[randomBelow(randomState, sizeof(interestingBytes))];
+        worker->size = 1;
+        return;
+    }
+
+    size_t position = randomBelow(randomState, (dword_t)size);
+
+    switch(randomBelow(randomState, 9))
+    {
+        case 0:
+            data[position] ^= (byte_t)(1 << randomBelow(randomState, 8));
+            break;
+        case 1:
+            data[position] = interestingBytes[randomBelow(randomState, sizeof(interestingBytes))];
+            break;
+        case 2:
+            data[position] = (byte_t)randomBelow(randomState, 0x100);
+            break;
+        case 3:
+            data[position] += (byte_t)(randomBelow(randomState, 2) ? 1 + randomBelow(randomState, 35)
+                                                                    : 0x100 - 1 - randomBelow(randomState, 35));
+            break;
+        case 4:
+            // Insert an interesting byte
+            if(size < maxSize)
+            {
+                memmove(data + position + 1, data + position, size - position);
+                data[position] = interestingBytes[randomBelow(randomState, sizeof(interestingBytes))];
+                worker->size = size + 1;
+            }
+            break;
+        case 5:
+        {
+            // Delete a block, keep at least one byte
+            size_t length = 1 + randomBelow(randomState, (dword_t)((size - position < 16) ? size - position : 16));
+            if(length < size)
+            {
+                memmove(data + position, data + position + length, size - position - length);
+                worker->size = size - length;
+            }
+            break;
+        }
+        case 6:
+        {
+            // Duplicate a block of the test case in place
+            size_t source = randomBelow(randomState, (dword_t)size);
+            size_t length = 1 + randomBelow(randomState, (dword_t)((size - source < 32) ? size - source : 32));
+            if(size + length <= maxSize)
+            {
+                byte_t block[32];
+                memcpy(block, data + source, length);
+                memmove(data + position + length, data + position, size - position);
+                memcpy(data + position, block, length);
+                worker->size = size + length;
+            }
+            break;
+        }
+        case 7:
+        {
+            // Insert a block of the partner (token reuse across corpus entries)
+            if(worker->partnerSize > 0)
+            {
+                size_t source = randomBelow(randomState, (dword_t)worker->partnerSize);
+                size_t length = worker->partnerSize - source;
+
+                length = 1 + randomBelow(randomState, (dword_t)((length < 32) ? length : 32));
+                if(size + length <= maxSize)
+                {
+                    memmove(data + position + length, data + position, size - position);
+                    memcpy(data + position, worker->partner + source, length);
+                    worker->size = size + length;
+                }
+            }
+            break;
+        }
+        default:
+        {
+            // Splice: our head, the partner's tail
+            if(worker->partnerSize > 1)
+            {
+                size_t split = randomBelow(randomState, (dword_t)worker->partnerSize);
+                size_t length = worker->partnerSize - split;
+
+                if(position + length > maxSize)
+                {
+                    length = maxSize - position;
+                }
+                memcpy(data + position, worker->partner + split, length);
+                worker->size = position + length;
+            }
+            break;
+        }
+    }
+}
+
+static void reportTestCase(FuzzWorker_t *worker, FuzzOutcome outcome)
+{
+    Fuzzer_t *fuzzer = worker->fuzzer;
+    FuzzExecutor_t *executor = &worker->executor;
+
+    worker->executions++;
+    worker->outcomes[outcome]++;
+    worker->cycles += (qword_t)executor->cycles;
+
+    // Checked against this worker's own history first, the shared map is only locked for
+    // test cases that might be new to everyone
+    bool isNewHere = coverageMerge(worker->seen, executor->coverage) > 0;
+
+    if(isNewHere == false && outcome == FUZZ_OUTCOME_OK && worker->executions < FUZZ_FLUSH_INTERVAL)
+    {
+        return;
+    }
+
+    mutexLock(&fuzzer->lock);
+
+    bool isNew = isNewHere == true && coverageMerge(fuzzer->coverage, executor->coverage) > 0;
+
+    if(outcome == FUZZ_OUTCOME_OK)
+    {
+        if(isNew == true)
+        {
+            addCorpus(fuzzer, worker->data, worker->size);
+        }
+    }
+    else
+    {
+        recordFinding(fuzzer, outcome, executor->pc, worker->data, worker->size, isNew);
+    }
+
+    flushCounters(worker);
+
+    mutexUnlock(&fuzzer->lock);
+}
+
+static void flushCounters(FuzzWorker_t *worker)
+{
+    Fuzzer_t *fuzzer = worker->fuzzer;
+
+    fuzzer->executions += worker->executions;
+    fuzzer->cycles += worker->cycles;
+    for(int idx = 0; idx < FUZZ_OUTCOME_COUNT; idx++)
+    {
+        fuzzer->outcomes[idx] += worker->outcomes[idx];
+        worker->outcomes[idx] = 0;
+    }
+    worker->executions = 0;
+    worker->cycles = 0;
+
+    if(fuzzer->config.maxExecutions > 0 && fuzzer->executions >= fuzzer->config.maxExecutions)
+    {
+        fuzzerStop(fuzzer);
+    }
+}
+
+static bool addCorpus(Fuzzer_t *fuzzer, const byte_t *data, size_t size)
+{
+    if(fuzzer->corpusCount == fuzzer->corpusCapacity)
+    {
+        size_t newCapacity = (fuzzer->corpusCapacity == 0) ? 64 : fuzzer->corpusCapacity * 2;
+        FuzzInput_t *corpus = (FuzzInput_t *)realloc(fuzzer->corpus, newCapacity * sizeof(FuzzInput_t));
+        if(corpus == NULL)
+        {
+            return false;
+        }
+
+        fuzzer->corpus = corpus;
+        fuzzer->corpusCapacity = newCapacity;
+    }
+
+    byte_t *copy = copyBytes(data, size);
+    if(copy == NULL)
+    {
+        return false;
+    }
+
+    fuzzer->corpus[fuzzer->corpusCount] = (FuzzInput_t){ copy, size };
+    fuzzer->corpusCount++;
+
+    return true;
+}
+
+static void recordFinding(Fuzzer_t *fuzzer, FuzzOutcome outcome, word_t pc, const byte_t *data, size_t size,
+                          bool isNew)
+{
+    bool isFirstHang = true;
+
+    for(size_t idx = 0; idx < fuzzer->findingCount; idx++)
+    {
+        FuzzFinding_t *finding = &fuzzer->findings[idx];
+
+        if(finding->outcome == outcome && finding->pc == pc)
+        {
+            finding->count++;
+            return;
+        }
+        isFirstHang &= (finding->outcome != FUZZ_OUTCOME_HANG);
+    }
+
+    if((outcome == FUZZ_OUTCOME_HANG && isFirstHang == false && isNew == false)
+        || fuzzer->findingCount == FUZZ_MAX_FINDINGS)
+    {
+        return;
+    }
+
+    if(fuzzer->findingCount == fuzzer->findingCapacity)
+    {
+        size_t newCapacity = (fuzzer->findingCapacity == 0) ? 16 : fuzzer->findingCapacity * 2;
+        FuzzFinding_t *findings = (FuzzFinding_t *)realloc(fuzzer->findings, newCapacity * sizeof(FuzzFinding_t));
+        if(findings == NULL)
+        {
+            return;
+        }
+
+        fuzzer->findings = findings;
+        fuzzer->findingCapacity = newCapacity;
+    }
+
+    byte_t *copy = copyBytes(data, size);
+    if(copy == NULL)
+    {
+        return;
+    }
+
+    fuzzer->findings[fuzzer->findingCount] = (FuzzFinding_t){ outcome, pc, 1, { copy, size } };
+    fuzzer->findingCount++;
+}
+
+static byte_t *copyBytes(const byte_t *data, size_t size)
+{
+    byte_t *copy = (byte_t *)malloc(size + 1);
+
+    if(copy != NULL && size > 0)
+    {
+        memcpy(copy, data, size);
+    }
+
+    return copy;
+}
+
+static void readInput(void *context, byte_t *value)
+{
+    FuzzExecutor_t *executor = (FuzzExecutor_t *)context;
+
+    if(executor->inputPosition < executor->inputSize)
+    {
+        *value = executor->input[executor->inputPosition];
+        executor->inputPosition++;
+    }
+    else
+    {
+        // Asking for more than the test case holds ends it
+        *value = 0xFF;
+        zilogZ80RequestStop(&executor->machine.cpu);
+    }
+}
+
+static void readBoot(void *context, byte_t *value)
+{
+    FuzzExecutor_t *executor = (FuzzExecutor_t *)context;
+
+    *value = 0xFF;
+    executor->isInputRead = true;
+    zilogZ80RequestStop(&executor->machine.cpu);
+}
+
+static void writeExit(void *context, byte_t value)
+{
+    FuzzExecutor_t *executor = (FuzzExecutor_t *)context;
+    (void)value;
+
+    zilogZ80RequestStop(&executor->machine.cpu);
+}
+
+static dword_t randomBelow(dword_t *randomState, dword_t limit)
+{
+    *randomState ^= *randomState << 13;
+    *randomState ^= *randomState >> 17;
+    *randomState ^= *randomState << 5;
+
+    return *randomState % limit;
+}
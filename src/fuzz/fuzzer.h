@@ -0,0 +1,213 @@
+#ifndef CILOGC80_FUZZER_H
+#define CILOGC80_FUZZER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "utils/utils.h"
+#include "utils/threading.h"
+#include "cpu/coverage.h"
+#include "emulator/rom_store.h"
+#include "machine/machine.h"
+
+/** @brief Port the test cases are read from (the console port of the other tools) */
+#define FUZZ_DEFAULT_INPUT_PORT 0x01
+/** @brief Cycles a test case may run before it counts as a hang */
+#define FUZZ_DEFAULT_MAX_CYCLES 1000000L
+/** @brief Largest test case the mutations produce */
+#define FUZZ_DEFAULT_MAX_INPUT_SIZE 1024
+/** @brief Cycles between two checks for invalid opcodes */
+#define FUZZ_SLICE_CYCLES 20000L
+/** @brief Bytes below the stack bound watched for pushes */
+#define FUZZ_STACK_GUARD_SIZE 0x10
+/** @brief Maximum number of crash watchpoints */
+#define FUZZ_MAX_WATCHPOINTS 8
+/** @brief Largest number of stacked mutations applied to one test case */
+#define FUZZ_MAX_STACKED_MUTATIONS 16
+
+/**
+ * @brief Enum struct for defining how a test case ended
+ */
+typedef enum FuzzOutcome
+{
+    /** @brief Input used up, HALT or a write to the exit port */
+    FUZZ_OUTCOME_OK = 0,
+    /** @brief Cycle budget ran out */
+    FUZZ_OUTCOME_HANG,
+    FUZZ_OUTCOME_INVALID_OPCODE,
+    FUZZ_OUTCOME_WATCHPOINT,
+    /** @brief A push went below the stack bound */
+    FUZZ_OUTCOME_STACK_OVERFLOW,
+    FUZZ_OUTCOME_COUNT
+} FuzzOutcome;
+
+/**
+ * @brief Fuzzing parameters
+ */
+typedef struct FuzzConfig_t
+{
+    /** @brief Port the test case bytes are read from */
+    byte_t inputPort;
+    /** @brief Port that ends a test case when written to, -1 for none */
+    int exitPort;
+    /** @brief Cycles from the snapshot until a test case counts as a hang */
+    long maxCycles;
+    size_t maxInputSize;
+
+    /** @brief Lowest valid stack pointer, -1 disables the stack check */
+    long stackBound;
+    /** @brief Address ranges (inclusive) any write to is a crash */
+    word_t watchStart[FUZZ_MAX_WATCHPOINTS];
+    word_t watchEnd[FUZZ_MAX_WATCHPOINTS];
+    int watchCount;
+
+    /** @brief Worker threads, 0 for one per logical processor */
+    int workerCount;
+    /** @brief Test cases to run, 0 for no limit */
+    qword_t maxExecutions;
+    /** @brief Wall clock limit in seconds, 0 for no limit */
+    double maxSeconds;
+    dword_t seed;
+} FuzzConfig_t;
+
+/**
+ * @brief Test case, either a corpus entry or the input of a finding
+ */
+typedef struct FuzzInput_t
+{
+    byte_t *data;
+    size_t size;
+} FuzzInput_t;
+
+/**
+ * @brief Crash or hang, findings are unique per outcome and PC
+ */
+typedef struct FuzzFinding_t
+{
+    FuzzOutcome outcome;
+    /** @brief Instruction that crashed, PC at the end of the budget for hangs */
+    word_t pc;
+    /** @brief Test cases that ended here */
+    qword_t count;
+    /** @brief First test case that ended here */
+    FuzzInput_t input;
+} FuzzFinding_t;
+
+/**
+ * @brief Coverage guided fuzzer. Boots the ROM once until it first reads the input port,
+ * then every worker thread restores its own machine to that snapshot, feeds it a mutated
+ * corpus entry through the input port and keeps the test case if it reached new addresses
+ * or edges. Crashes and hangs are collected per outcome and PC
+ */
+typedef struct Fuzzer_t
+{
+    FuzzConfig_t config;
+
+    /** @brief ROM the workers map (shared read-only) */
+    RomStore_t romStore;
+    const RomImage_t *rom;
+    /** @brief State right before the first read of the input port, every test case starts here */
+    MachineSnapshot_t snapshot;
+
+    /** @brief Guards everything below */
+    Mutex_t lock;
+
+    /** @brief Coverage of all test cases run so far */
+    Coverage_t *coverage;
+
+    FuzzInput_t *corpus;
+    size_t corpusCount;
+    size_t corpusCapacity;
+
+    FuzzFinding_t *findings;
+    size_t findingCount;
+    size_t findingCapacity;
+
+    qword_t executions;
+    qword_t outcomes[FUZZ_OUTCOME_COUNT];
+    /** @brief Cycles executed by all test cases */
+    qword_t cycles;
+    /** @brief Cycles from reset to the snapshot */
+    qword_t bootCycles;
+
+    /** @brief Non-zero ends the run, see fuzzerStop */
+    long isStopRequested;
+} Fuzzer_t;
+
+/**
+ * @brief Returns the default parameters
+ *
+ * @return FuzzConfig_t
+ */
+FuzzConfig_t fuzzerDefaultConfig();
+
+/**
+ * @brief Initializes a fuzzer, loads the ROM and runs it from reset to the snapshot
+ *
+ * @param fuzzer
+ * @param config
+ * @param romPath
+ * @return bool False if the ROM could not be loaded, never read the input port within
+ * 100M cycles or out of memory
+ */
+bool fuzzerInit(Fuzzer_t *fuzzer, const FuzzConfig_t *config, const char *romPath);
+
+/**
+ * @brief Releases corpus, findings and the ROM
+ *
+ * @param fuzzer
+ */
+void fuzzerDestroy(Fuzzer_t *fuzzer);
+
+/**
+ * @brief Adds a test case to the corpus. Without seeds the corpus starts with a single
+ * newline
+ *
+ * @param fuzzer
+ * @param data
+ * @param size Cut to maxInputSize
+ * @return bool False if out of memory
+ */
+bool fuzzerAddSeed(Fuzzer_t *fuzzer, const byte_t *data, size_t size);
+
+/**
+ * @brief Runs the seeds, then fuzzes on the worker threads until maxExecutions, maxSeconds
+ * or fuzzerStop
+ *
+ * @param fuzzer
+ * @param progress Called about once a second from the calling thread, may be NULL
+ * @param context Passed to progress
+ * @return bool False if the workers could not be started
+ */
+bool fuzzerRun(Fuzzer_t *fuzzer, void (*progress)(void *context, const Fuzzer_t *fuzzer), void *context);
+
+/**
+ * @brief Asks fuzzerRun to return after the test cases being run. Safe to call from a signal
+ * handler or another thread
+ *
+ * @param fuzzer
+ */
+void fuzzerStop(Fuzzer_t *fuzzer);
+
+/**
+ * @brief Runs one test case on a fresh machine from the snapshot and returns how it ended,
+ * to reproduce a finding
+ *
+ * @param fuzzer Initialized fuzzer
+ * @param data
+ * @param size
+ * @param pc Receives the PC of the finding, may be NULL
+ * @return FuzzOutcome FUZZ_OUTCOME_COUNT if the machine could not be booted
+ */
+FuzzOutcome fuzzerReplay(Fuzzer_t *fuzzer, const byte_t *data, size_t size, word_t *pc);
+
+/**
+ * @brief Returns the name of an outcome ("ok", "hang", "invalid-opcode", ...)
+ *
+ * @param outcome
+ * @return const char*
+ */
+const char *fuzzerOutcomeName(FuzzOutcome outcome);
+
+#endif // CILOGC80_FUZZER_H
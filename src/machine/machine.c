@@ -0,0 +1,797 @@
+#include "machine/machine.h"
+
+#include <string.h>
+
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x00000100000001B3ULL
+
+/** @brief Number of 16K windows of the generic layout (0x0000 and 0x4000) */
+#define GENERIC_WINDOW_COUNT 2
+/** @brief Slot the cartridge layouts plug the image into */
+#define CARTRIDGE_SLOT 1
+
+/**
+ * @brief Command line names of the layouts, indexed by @ref MachineMapper
+ */
+static const char *mapperNames[] = { "none", "generic16k", "ascii8", "ascii16", "konami", "scc" };
+
+/**
+ * @brief Installs the port handlers of the layout and moves the flat layout into slot 0 for
+ * the cartridge layouts
+ *
+ * @param machine
+ * @return bool False if out of memory
+ */
+static bool initLayout(Machine_t *machine);
+
+/**
+ * @brief Maps an image with the layout of the machine
+ *
+ * @param machine
+ * @param data
+ * @param size
+ * @return bool False if the image is not a whole number of banks, nothing was changed then
+ */
+static bool mapImage(Machine_t *machine, byte_t *data, size_t size);
+
+/**
+ * @brief Returns the bank size an image has to be a multiple of, 0 for the flat layout
+ *
+ * @param mapperType
+ * @return size_t
+ */
+static size_t layoutBankSize(MachineMapper mapperType);
+
+/**
+ * @brief Port handlers of the generic layout, one per window
+ */
+static void bankPort0Write(void *context, byte_t value);
+static void bankPort1Write(void *context, byte_t value);
+static void bankPort0Read(void *context, byte_t *value);
+static void bankPort1Read(void *context, byte_t *value);
+
+/**
+ * @brief Port handlers of the primary slot select register
+ */
+static void slotPortWrite(void *context, byte_t value);
+static void slotPortRead(void *context, byte_t *value);
+
+/**
+ * @brief Maps an image acquired from the store, releasing the previous one
+ *
+ * @param machine
+ * @param image NULL if acquiring failed
+ * @return bool
+ */
+static bool attachSharedRom(Machine_t *machine, const RomImage_t *image);
+
+/**
+ * @brief Maps a private image, the machine takes ownership (image is emptied)
+ *
+ * @param machine
+ * @param image
+ * @return bool
+ */
+static bool attachPrivateRom(Machine_t *machine, RomImage_t *image);
+
+/**
+ * @brief Continues a FNV-1a hash over a buffer
+ *
+ * @param hash
+ * @param data
+ * @param size
+ * @return qword_t
+ */
+static qword_t hashBytes(qword_t hash, const byte_t *data, size_t size);
+
+/**
+ * @brief Copies registers, interrupt state and cycle counters, nothing that points into the
+ * machine (memory, callbacks, profiles)
+ *
+ * @param destination
+ * @param source
+ */
+static void copyRegisters(ZilogZ80_t *destination, const ZilogZ80_t *source);
+
+/**
+ * @brief Copies a memory into a snapshot buffer, allocating it the first time
+ *
+ * @param buffer
+ * @param bufferSize
+ * @param memory
+ * @return bool False if out of memory
+ */
+static bool saveMemory(byte_t **buffer, size_t *bufferSize, const Memory_t *memory);
+
+MachineConfig_t machineDefaultConfig()
+{
+    return (MachineConfig_t){
+        .frequencyMHz = MACHINE_DEFAULT_FREQUENCY_MHZ,
+        .frameRate = MACHINE_DEFAULT_FRAME_RATE,
+        .romStore = NULL,
+        .backend = NULL,
+        .mapper = MACHINE_MAPPER_NONE};
+}
+
+const char *machineMapperName(MachineMapper mapper)
+{
+    return ((size_t)mapper < sizeof(mapperNames) / sizeof(mapperNames[0])) ? mapperNames[mapper] : NULL;
+}
+
+bool machineMapperFind(const char *name, MachineMapper *mapper)
+{
+    for(size_t idx = 0; name != NULL && idx < sizeof(mapperNames) / sizeof(mapperNames[0]); idx++)
+    {
+        if(strcmp(mapperNames[idx], name) == 0)
+        {
+            *mapper = (MachineMapper)idx;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool machineInit(Machine_t *machine, const MachineConfig_t *config)
+{
+    if(machine == NULL)
+    {
+        return false;
+    }
+
+    MachineConfig_t defaultConfig = machineDefaultConfig();
+    if(config == NULL)
+    {
+        config = &defaultConfig;
+    }
+
+    memset(machine, 0x00, sizeof(Machine_t));
+    errorStackReset(&machine->errors);
+
+    // Everything the components report during init belongs to this machine
+    ErrorStack_t *previousErrors = errorStackSetCurrent(&machine->errors);
+
+    zilogZ80Init(&machine->cpu);
+    machine->cpu.frequency = config->frequencyMHz;
+    machine->cpu.ioContext = machine;
+
+    tms9918Init(&machine->vdp);
+
+    machine->scheduler.cyclesPerFrame = (long)(config->frequencyMHz * machine->cpu.frequencyFactor) / config->frameRate;
+    machine->romStore = config->romStore;
+    romImageInit(&machine->privateRom);
+
+    machine->mapperType = config->mapper;
+    if(initLayout(machine) == false)
+    {
+        setError(C80_ERROR_MEMORY_INIT_ERROR);
+    }
+
+    if(machineSetBackend(machine, config->backend) == false)
+    {
+        setError(C80_ERROR_MEMORY_INIT_ERROR);
+    }
+
+    errorStackSetCurrent(previousErrors);
+
+    return machine->errors.topIndex < 0;
+}
+
+void machineDestroy(Machine_t *machine)
+{
+    if(machine == NULL)
+    {
+        return;
+    }
+
+    ErrorStack_t *previousErrors = errorStackSetCurrent(&machine->errors);
+
+    if(machine->backend != NULL)
+    {
+        machine->backend->destroy(machine, machine->backendState);
+        machine->backend = NULL;
+        machine->backendState = NULL;
+    }
+
+    // Unmap the ROM window first, the page table must never point into released images.
+    // Banks and slots can show the image anywhere
+    memoryMapUnmap(&machine->cpu.memoryMap, CPU_ROM_START_ADDRESS,
+                   (machine->mapperType == MACHINE_MAPPER_NONE) ? CPU_ROM_SIZE : 0x10000);
+    free(machine->slots);
+    machine->slots = NULL;
+
+    if(machine->romStore != NULL && machine->rom != NULL)
+    {
+        romStoreRelease(machine->romStore, machine->rom);
+    }
+    romImageClose(&machine->privateRom);
+    machine->rom = NULL;
+
+    memoryDestroy(&machine->cpu.rom);
+    memoryDestroy(&machine->cpu.ram);
+    tms9918Destroy(&machine->vdp);
+
+    errorStackSetCurrent(previousErrors);
+}
+
+void machineReset(Machine_t *machine)
+{
+    float frequency = machine->cpu.frequency;
+
+    zilogZ80Reset(&machine->cpu);
+    machine->cpu.frequency = frequency;
+    machine->cpu.totalCycles = 0;
+
+    tms9918Reset(&machine->vdp);
+
+    // Power-on bank and slot selection
+    if(machine->slots != NULL)
+    {
+        machine->slots->primarySelect = 0x00;
+        memset(machine->slots->secondarySelect, 0x00, sizeof(machine->slots->secondarySelect));
+        msxSlotsRefresh(machine->slots);
+    }
+    if(machine->mapper.image != NULL)
+    {
+        mapperReset(&machine->mapper);
+    }
+    if(machine->mapperType != MACHINE_MAPPER_NONE)
+    {
+        machineInvalidate(machine, 0x0000, 0x10000);
+    }
+
+    machine->scheduler.frameCycles = 0;
+    machine->scheduler.frameCount = 0;
+    machine->scheduler.totalCycles = 0;
+
+    machineSyncState(machine);
+}
+
+bool machineLoadRom(Machine_t *machine, const char *filename, RomImageFormat format)
+{
+    ErrorStack_t *previousErrors = errorStackSetCurrent(&machine->errors);
+    bool isLoaded = false;
+
+    if(machine->romStore != NULL)
+    {
+        isLoaded = attachSharedRom(machine, romStoreAcquireFile(machine->romStore, filename, format));
+    }
+    else
+    {
+        RomImage_t image;
+        romImageInit(&image);
+
+        if(romImageLoadFile(&image, filename, format, 0) == true)
+        {
+            isLoaded = attachPrivateRom(machine, &image);
+        }
+        romImageClose(&image);
+    }
+
+    errorStackSetCurrent(previousErrors);
+
+    return isLoaded;
+}
+
+bool machineLoadRomData(Machine_t *machine, const byte_t *data, size_t size)
+{
+    if(data == NULL || size == 0)
+    {
+        return false;
+    }
+
+    ErrorStack_t *previousErrors = errorStackSetCurrent(&machine->errors);
+    bool isLoaded = false;
+
+    if(machine->romStore != NULL)
+    {
+        isLoaded = attachSharedRom(machine, romStoreAcquireData(machine->romStore, data, size));
+    }
+    else
+    {
+        RomImage_t image;
+        romImageInit(&image);
+
+        image.size = (size + MEMORY_PAGE_MASK) & ~(size_t)MEMORY_PAGE_MASK;
+        image.data = (byte_t *)calloc(image.size, sizeof(byte_t));
+        if(image.data == NULL)
+        {
+            setError(C80_ERROR_MEMORY_INIT_ERROR);
+        }
+        else
+        {
+            memcpy(image.data, data, size);
+            image.segments[0] = (RomSegment_t){ .offset = 0, .size = size };
+            image.segmentCount = 1;
+
+            isLoaded = attachPrivateRom(machine, &image);
+        }
+        romImageClose(&image);
+    }
+
+    errorStackSetCurrent(previousErrors);
+
+    return isLoaded;
+}
+
+bool machineSetBackend(Machine_t *machine, const MachineBackend_t *backend)
+{
+    void *state = NULL;
+
+    if(backend == NULL)
+    {
+        backend = machineBackendGet(0);
+    }
+    if(backend == machine->backend)
+    {
+        return true;
+    }
+
+    // The machine holds the published state, the new backend starts from it
+    if(backend->init(machine, &state) == false)
+    {
+        return false;
+    }
+
+    if(machine->backend != NULL)
+    {
+        machine->backend->destroy(machine, machine->backendState);
+    }
+    machine->backend = backend;
+    machine->backendState = state;
+
+    return true;
+}
+
+void machineInvalidate(Machine_t *machine, word_t address, size_t size)
+{
+    if(machine->backend != NULL)
+    {
+        machine->backend->invalidate(machine, machine->backendState, address, size);
+    }
+}
+
+void machineSyncState(Machine_t *machine)
+{
+    if(machine->backend != NULL)
+    {
+        machine->backend->syncState(machine, machine->backendState);
+    }
+}
+
+int machineStep(Machine_t *machine)
+{
+    ErrorStack_t *previousErrors = errorStackSetCurrent(&machine->errors);
+
+    int cycles = zilogZ80Step(&machine->cpu);
+    machine->scheduler.totalCycles += (qword_t)cycles;
+
+    // The instruction may have written anywhere the memory map allows
+    machineSyncState(machine);
+    machineInvalidate(machine, 0x0000, 0x10000);
+
+    errorStackSetCurrent(previousErrors);
+
+    return cycles;
+}
+
+StopReason machineRun(Machine_t *machine, long cycleBudget)
+{
+    ErrorStack_t *previousErrors = errorStackSetCurrent(&machine->errors);
+
+    StopReason stopReason = machine->backend->run(machine, machine->backendState, cycleBudget);
+    machine->scheduler.totalCycles += (qword_t)machine->cpu.runCycles;
+
+    errorStackSetCurrent(previousErrors);
+
+    return stopReason;
+}
+
+StopReason machineRunFrame(Machine_t *machine)
+{
+    MachineScheduler_t *scheduler = &machine->scheduler;
+
+    StopReason stopReason = machineRun(machine, scheduler->cyclesPerFrame - scheduler->frameCycles);
+
+    // A halt or watchpoint leaves the frame unfinished, the next call continues it
+    scheduler->frameCycles += machine->cpu.runCycles;
+    if(scheduler->frameCycles >= scheduler->cyclesPerFrame)
+    {
+        scheduler->frameCycles -= scheduler->cyclesPerFrame;
+        scheduler->frameCount++;
+    }
+
+    return stopReason;
+}
+
+qword_t machineHashState(const Machine_t *machine)
+{
+    const ZilogZ80_t *cpu = &machine->cpu;
+
+    // Field by field, struct padding must not end up in the hash
+    byte_t registers[] =
+    {
+        cpu->A, cpu->B, cpu->C, cpu->D, cpu->E, cpu->H, cpu->L,
+        cpu->A_, cpu->B_, cpu->C_, cpu->D_, cpu->E_, cpu->H_, cpu->L_,
+        zilogZ80FlagsToByte(cpu->F),
+        zilogZ80FlagsToByte(cpu->F_),
+        LOWER_BYTE(cpu->SP), UPPER_BYTE(cpu->SP),
+        LOWER_BYTE(cpu->PC), UPPER_BYTE(cpu->PC),
+        LOWER_BYTE(cpu->IX), UPPER_BYTE(cpu->IX),
+        LOWER_BYTE(cpu->IY), UPPER_BYTE(cpu->IY),
+        cpu->I, cpu->R,
+        (byte_t)cpu->interruptStatus, (byte_t)cpu->interruptMode, (byte_t)cpu->isHaltered
+    };
+
+    qword_t hash = hashBytes(FNV_OFFSET_BASIS, registers, sizeof(registers));
+    hash = hashBytes(hash, cpu->ram.data, cpu->ram.memorySize);
+    hash = hashBytes(hash, machine->vdp.registers, TMS_REGISTER_COUNT);
+    hash = hashBytes(hash, machine->vdp.vram.data, machine->vdp.vram.memorySize);
+
+    return hash;
+}
+
+qword_t machineHashRom(const Machine_t *machine)
+{
+    if(machine->rom != NULL)
+    {
+        return hashBytes(FNV_OFFSET_BASIS, machine->rom->data, machine->rom->size);
+    }
+
+    return hashBytes(FNV_OFFSET_BASIS, machine->cpu.rom.data, machine->cpu.rom.memorySize);
+}
+
+void machineGetBanks(const Machine_t *machine, MachineBanks_t *banks)
+{
+    memset(banks, 0x00, sizeof(MachineBanks_t));
+
+    for(size_t window = 0; machine->mapper.image != NULL && window < machine->mapper.windowCount; window++)
+    {
+        banks->banks[window] = machine->mapper.banks[window];
+    }
+
+    if(machine->slots != NULL)
+    {
+        banks->primarySlotSelect = machine->slots->primarySelect;
+        memcpy(banks->secondarySlotSelect, machine->slots->secondarySelect, MSX_SLOT_COUNT);
+    }
+}
+
+void machineSetBanks(Machine_t *machine, const MachineBanks_t *banks)
+{
+    if(machine->mapperType == MACHINE_MAPPER_NONE)
+    {
+        return;
+    }
+
+    if(machine->slots != NULL)
+    {
+        machine->slots->primarySelect = banks->primarySlotSelect;
+        memcpy(machine->slots->secondarySelect, banks->secondarySlotSelect, MSX_SLOT_COUNT);
+        msxSlotsRefresh(machine->slots);
+    }
+
+    // Bank switches of a visible cartridge are mirrored into the CPU map by the slots
+    for(size_t window = 0; machine->mapper.image != NULL && window < machine->mapper.windowCount; window++)
+    {
+        mapperSelectBank(&machine->mapper, window, banks->banks[window]);
+    }
+
+    machineInvalidate(machine, 0x0000, 0x10000);
+}
+
+bool machineSaveSnapshot(const Machine_t *machine, MachineSnapshot_t *snapshot)
+{
+    if(saveMemory(&snapshot->ram, &snapshot->ramSize, &machine->cpu.ram) == false
+        || saveMemory(&snapshot->vram, &snapshot->vramSize, &machine->vdp.vram) == false)
+    {
+        return false;
+    }
+
+    copyRegisters(&snapshot->cpu, &machine->cpu);
+    memcpy(snapshot->vdpRegisters, machine->vdp.registers, TMS_REGISTER_COUNT);
+    snapshot->vramAddress = machine->vdp.vramAddress;
+    snapshot->vdpMode = machine->vdp.mode;
+    machineGetBanks(machine, &snapshot->banks);
+    snapshot->scheduler = machine->scheduler;
+
+    return true;
+}
+
+void machineRestoreSnapshot(Machine_t *machine, const MachineSnapshot_t *snapshot)
+{
+    copyRegisters(&machine->cpu, &snapshot->cpu);
+    if(snapshot->ram != NULL && snapshot->ramSize == machine->cpu.ram.memorySize)
+    {
+        memcpy(machine->cpu.ram.data, snapshot->ram, snapshot->ramSize);
+    }
+
+    memcpy(machine->vdp.registers, snapshot->vdpRegisters, TMS_REGISTER_COUNT);
+    if(snapshot->vram != NULL && snapshot->vramSize == machine->vdp.vram.memorySize)
+    {
+        memcpy(machine->vdp.vram.data, snapshot->vram, snapshot->vramSize);
+    }
+    machine->vdp.vramAddress = snapshot->vramAddress;
+    machine->vdp.mode = snapshot->vdpMode;
+
+    machineSetBanks(machine, &snapshot->banks);
+    machine->scheduler = snapshot->scheduler;
+
+    machineSyncState(machine);
+    machineInvalidate(machine, CPU_RAM_START_ADDRESS, CPU_RAM_SIZE);
+}
+
+void machineSnapshotDestroy(MachineSnapshot_t *snapshot)
+{
+    free(snapshot->ram);
+    free(snapshot->vram);
+    memset(snapshot, 0x00, sizeof(MachineSnapshot_t));
+}
+
+static bool attachSharedRom(Machine_t *machine, const RomImage_t *image)
+{
+    if(image == NULL)
+    {
+        return false;
+    }
+
+    // The previous image stays mapped until the new one replaced it
+    if(mapImage(machine, image->data, image->size) == false)
+    {
+        romStoreRelease(machine->romStore, image);
+        return false;
+    }
+
+    if(machine->rom != NULL)
+    {
+        romStoreRelease(machine->romStore, machine->rom);
+    }
+    machine->rom = image;
+
+    return true;
+}
+
+static bool attachPrivateRom(Machine_t *machine, RomImage_t *image)
+{
+    if(mapImage(machine, image->data, image->size) == false)
+    {
+        return false;
+    }
+
+    romImageClose(&machine->privateRom);
+    machine->privateRom = *image;
+    machine->rom = &machine->privateRom;
+    romImageInit(image);
+
+    return true;
+}
+
+static bool initLayout(Machine_t *machine)
+{
+    ZilogZ80_t *cpu = &machine->cpu;
+
+    switch(machine->mapperType)
+    {
+        case MACHINE_MAPPER_NONE:
+            return true;
+        case MACHINE_MAPPER_GENERIC_16K:
+            // Tools replace ioContext, the ports keep the machine through their own context
+            cpu->outputCallback[MACHINE_BANK_PORT] = bankPort0Write;
+            cpu->outputCallback[MACHINE_BANK_PORT + 1] = bankPort1Write;
+            cpu->inputCallback[MACHINE_BANK_PORT] = bankPort0Read;
+            cpu->inputCallback[MACHINE_BANK_PORT + 1] = bankPort1Read;
+            cpu->portContext[MACHINE_BANK_PORT] = machine;
+            cpu->portContext[MACHINE_BANK_PORT + 1] = machine;
+            return true;
+        default:
+            break;
+    }
+
+    machine->slots = (MsxSlots_t *)malloc(sizeof(MsxSlots_t));
+    if(machine->slots == NULL)
+    {
+        return false;
+    }
+
+    // Slot 0 gets the ROM window and RAM zilogZ80Init mapped, the CPU map follows the slots
+    msxSlotsInit(machine->slots, &cpu->memoryMap);
+    MemoryMap_t *flat = msxSlotsGetSlotMap(machine->slots, 0, 0);
+    memoryMapMapRegion(flat, cpu->rom.memoryStartAddress, cpu->rom.memorySize, cpu->rom.data, false);
+    memoryMapMapRegion(flat, cpu->ram.memoryStartAddress, cpu->ram.memorySize, cpu->ram.data, true);
+    msxSlotsRefresh(machine->slots);
+
+    cpu->outputCallback[MACHINE_SLOT_PORT] = slotPortWrite;
+    cpu->inputCallback[MACHINE_SLOT_PORT] = slotPortRead;
+    cpu->portContext[MACHINE_SLOT_PORT] = machine;
+
+    return true;
+}
+
+static bool mapImage(Machine_t *machine, byte_t *data, size_t size)
+{
+    ZilogZ80_t *cpu = &machine->cpu;
+    size_t bankSize = layoutBankSize(machine->mapperType);
+
+    if(bankSize != 0 && (size < bankSize || (size % bankSize) != 0))
+    {
+        setError(C80_ERROR_ROM_FILE_FORMAT_ERROR);
+        return false;
+    }
+
+    switch(machine->mapperType)
+    {
+        case MACHINE_MAPPER_NONE:
+            zilogZ80MapRom(cpu, data, size);
+            machineInvalidate(machine, CPU_ROM_START_ADDRESS, CPU_ROM_SIZE);
+            return true;
+        case MACHINE_MAPPER_GENERIC_16K:
+            // The ROM window memory keeps describing bank 0, the mapper pages over the map
+            zilogZ80MapRom(cpu, data, size);
+            mapperInitGeneric(&machine->mapper, &cpu->memoryMap, 0, GENERIC_WINDOW_COUNT, data, size, false);
+            break;
+        default:
+        {
+            static const MapperType_t cartridgeTypes[] =
+            {
+                [MACHINE_MAPPER_ASCII8] = MAPPER_TYPE_ASCII8,
+                [MACHINE_MAPPER_ASCII16] = MAPPER_TYPE_ASCII16,
+                [MACHINE_MAPPER_KONAMI] = MAPPER_TYPE_KONAMI,
+                [MACHINE_MAPPER_KONAMI_SCC] = MAPPER_TYPE_KONAMI_SCC
+            };
+
+            // Slot 0 everywhere, the ROM window is written through the CPU map into slot 0
+            machine->slots->primarySelect = 0x00;
+            memset(machine->slots->secondarySelect, 0x00, sizeof(machine->slots->secondarySelect));
+            msxSlotsRefresh(machine->slots);
+
+            zilogZ80MapRom(cpu, data, size);
+            memoryMapCopyPages(msxSlotsGetSlotMap(machine->slots, 0, 0), &cpu->memoryMap,
+                               CPU_ROM_START_ADDRESS, CPU_ROM_SIZE);
+
+            mapperInit(&machine->mapper, cartridgeTypes[machine->mapperType],
+                       msxSlotsGetSlotMap(machine->slots, CARTRIDGE_SLOT, 0), data, size);
+            msxSlotsAttachMapper(machine->slots, &machine->mapper);
+            break;
+        }
+    }
+
+    machineInvalidate(machine, 0x0000, 0x10000);
+
+    return true;
+}
+
+static size_t layoutBankSize(MachineMapper mapperType)
+{
+    switch(mapperType)
+    {
+        case MACHINE_MAPPER_ASCII8:
+        case MACHINE_MAPPER_KONAMI:
+        case MACHINE_MAPPER_KONAMI_SCC:
+            return 0x2000;
+        case MACHINE_MAPPER_GENERIC_16K:
+        case MACHINE_MAPPER_ASCII16:
+            return 0x4000;
+        case MACHINE_MAPPER_NONE:
+        default:
+            return 0;
+    }
+}
+
+static void bankPort0Write(void *context, byte_t value)
+{
+    Machine_t *machine = (Machine_t *)context;
+
+    // No image, no banks to select
+    if(machine->mapper.image != NULL)
+    {
+        mapperSelectBank(&machine->mapper, 0, value);
+    }
+}
+
+static void bankPort1Write(void *context, byte_t value)
+{
+    Machine_t *machine = (Machine_t *)context;
+
+    if(machine->mapper.image != NULL)
+    {
+        mapperSelectBank(&machine->mapper, 1, value);
+    }
+}
+
+static void bankPort0Read(void *context, byte_t *value)
+{
+    *value = (byte_t)mapperGetBank(&((Machine_t *)context)->mapper, 0);
+}
+
+static void bankPort1Read(void *context, byte_t *value)
+{
+    *value = (byte_t)mapperGetBank(&((Machine_t *)context)->mapper, 1);
+}
+
+static void slotPortWrite(void *context, byte_t value)
+{
+    msxSlotsWritePrimary(((Machine_t *)context)->slots, value);
+}
+
+static void slotPortRead(void *context, byte_t *value)
+{
+    *value = msxSlotsReadPrimary(((Machine_t *)context)->slots);
+}
+
+static qword_t hashBytes(qword_t hash, const byte_t *data, size_t size)
+{
+    if(data == NULL)
+    {
+        return hash;
+    }
+
+    for(size_t idx = 0; idx < size; idx++)
+    {
+        hash ^= data[idx];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+static void copyRegisters(ZilogZ80_t *destination, const ZilogZ80_t *source)
+{
+    destination->A = source->A;
+    destination->B = source->B;
+    destination->C = source->C;
+    destination->D = source->D;
+    destination->E = source->E;
+    destination->H = source->H;
+    destination->L = source->L;
+
+    destination->A_ = source->A_;
+    destination->B_ = source->B_;
+    destination->C_ = source->C_;
+    destination->D_ = source->D_;
+    destination->E_ = source->E_;
+    destination->H_ = source->H_;
+    destination->L_ = source->L_;
+
+    destination->F = source->F;
+    destination->F_ = source->F_;
+
+    destination->SP = source->SP;
+    destination->PC = source->PC;
+    destination->IX = source->IX;
+    destination->IY = source->IY;
+    destination->I = source->I;
+    destination->R = source->R;
+
+    destination->interruptStatus = source->interruptStatus;
+    destination->interruptMode = source->interruptMode;
+    destination->isHaltered = source->isHaltered;
+    destination->instructionPC = source->instructionPC;
+
+    destination->cyclesInFrame = source->cyclesInFrame;
+    destination->totalCycles = source->totalCycles;
+}
+
+static bool saveMemory(byte_t **buffer, size_t *bufferSize, const Memory_t *memory)
+{
+    if(memory->data == NULL)
+    {
+        *bufferSize = 0;
+        return true;
+    }
+
+    if(*buffer == NULL || *bufferSize != memory->memorySize)
+    {
+        byte_t *data = (byte_t *)realloc(*buffer, memory->memorySize);
+        if(data == NULL)
+        {
+            return false;
+        }
+
+        *buffer = data;
+        *bufferSize = memory->memorySize;
+    }
+
+    memcpy(*buffer, memory->data, memory->memorySize);
+
+    return true;
+}
@@ -0,0 +1,332 @@
+#ifndef CILOGC80_MACHINE_H
+#define CILOGC80_MACHINE_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "utils/utils.h"
+#include "utils/error_handler.h"
+#include "cpu/cpu.h"
+#include "graphics_unit/graphics_unit.h"
+#include "emulator/rom_loader.h"
+#include "emulator/rom_store.h"
+#include "memory/mapper.h"
+#include "memory/msx_slots.h"
+#include "machine/machine_backend.h"
+
+/** @brief Default CPU clock (MSX) */
+#define MACHINE_DEFAULT_FREQUENCY_MHZ 3.579545f
+/** @brief Default frame rate the scheduler slices execution into */
+#define MACHINE_DEFAULT_FRAME_RATE 60
+/** @brief Port selecting the bank of the first generic 16K window, the next port selects the second */
+#define MACHINE_BANK_PORT 0xFC
+/** @brief Primary slot select port of the cartridge layouts */
+#define MACHINE_SLOT_PORT 0xA8
+
+/**
+ * @brief Enum struct for defining how a ROM image is mapped into the address space.
+ * The cartridge layouts keep the flat layout in slot 0 and plug the image as a cartridge
+ * into slot 1 (0x4000-0xBFFF), @ref MACHINE_SLOT_PORT selects the slot of every 16K page
+ * (slot 0 everywhere after reset)
+ */
+typedef enum MachineMapper
+{
+    /** @brief Flat layout: the first 16K of the image in the ROM window, RAM at 0x8000 */
+    MACHINE_MAPPER_NONE = 0,
+    /** @brief 16K banks of the image at 0x0000 and 0x4000, selected through @ref MACHINE_BANK_PORT */
+    MACHINE_MAPPER_GENERIC_16K,
+    /** @brief Cartridge with an ASCII 8K mapper (@ref MAPPER_TYPE_ASCII8) */
+    MACHINE_MAPPER_ASCII8,
+    /** @brief Cartridge with an ASCII 16K mapper (@ref MAPPER_TYPE_ASCII16) */
+    MACHINE_MAPPER_ASCII16,
+    /** @brief Cartridge with a Konami mapper (@ref MAPPER_TYPE_KONAMI) */
+    MACHINE_MAPPER_KONAMI,
+    /** @brief Cartridge with a Konami SCC mapper (@ref MAPPER_TYPE_KONAMI_SCC) */
+    MACHINE_MAPPER_KONAMI_SCC
+} MachineMapper;
+
+/**
+ * @brief Machine creation parameters
+ */
+typedef struct MachineConfig_t
+{
+    /** @brief CPU clock in MHz */
+    float frequencyMHz;
+    /** @brief Frames per second (scheduler slice size) */
+    int frameRate;
+    /** @brief Optional store shared between machines, ROMs are loaded privately if NULL */
+    RomStore_t *romStore;
+    /** @brief Execution backend, NULL for the default (the reference core) */
+    const MachineBackend_t *backend;
+    /** @brief Layout ROM images are mapped with */
+    MachineMapper mapper;
+} MachineConfig_t;
+
+/**
+ * @brief Splits emulated time into frames. Cycles an instruction runs past the end of a
+ * frame are taken from the next frame, so the long term rate is exact
+ */
+typedef struct MachineScheduler_t
+{
+    /** @brief Cycles per frame */
+    long cyclesPerFrame;
+    /** @brief Cycles already executed in the current frame */
+    long frameCycles;
+    /** @brief Number of completed frames */
+    qword_t frameCount;
+    /** @brief Cycles executed since the last reset */
+    qword_t totalCycles;
+} MachineScheduler_t;
+
+/**
+ * @brief Bank and slot registers, the part of the memory layout the guest switches
+ */
+typedef struct MachineBanks_t
+{
+    /** @brief Bank selected in every mapper window */
+    size_t banks[MAPPER_MAX_WINDOWS];
+    /** @brief Slot select registers of the cartridge layouts */
+    byte_t primarySlotSelect;
+    byte_t secondarySlotSelect[MSX_SLOT_COUNT];
+} MachineBanks_t;
+
+/**
+ * @brief Complete emulated machine. All emulation state lives in here, machines share
+ * nothing but read-only ROM images, so any number of them can run on different threads
+ * (one thread per machine at a time)
+ */
+typedef struct Machine_t
+{
+    ZilogZ80_t cpu;
+    TMS9918 vdp;
+    MachineScheduler_t scheduler;
+
+    /** @brief Errors raised while this machine was running */
+    ErrorStack_t errors;
+
+    /** @brief Store the ROM was acquired from (NULL = private ROM) */
+    RomStore_t *romStore;
+    /** @brief ROM currently mapped, either from the store or privateRom */
+    const RomImage_t *rom;
+    RomImage_t privateRom;
+
+    /** @brief Layout the ROM is mapped with and the mapper paging it (unused without a ROM) */
+    MachineMapper mapperType;
+    Mapper_t mapper;
+    /** @brief Slots of the cartridge layouts, NULL for the other layouts */
+    MsxSlots_t *slots;
+
+    /** @brief Backend @ref machineRun executes on and its per machine state */
+    const MachineBackend_t *backend;
+    void *backendState;
+
+    /** @brief Free for the owner of the machine */
+    void *userData;
+} Machine_t;
+
+/**
+ * @brief Guest visible state of a machine kept in memory: CPU registers, RAM, video, bank
+ * registers and the scheduler. The ROM, memory map, watchpoints, I/O callbacks and attached
+ * profiles are not part of it, restoring only rewinds the guest
+ */
+typedef struct MachineSnapshot_t
+{
+    /** @brief Only the registers, interrupt state and cycle counters are used */
+    ZilogZ80_t cpu;
+    byte_t *ram;
+    size_t ramSize;
+
+    byte_t vdpRegisters[TMS_REGISTER_COUNT];
+    byte_t *vram;
+    size_t vramSize;
+    word_t vramAddress;
+    TMS9918_Mode vdpMode;
+
+    MachineBanks_t banks;
+    MachineScheduler_t scheduler;
+} MachineSnapshot_t;
+
+/**
+ * @brief Returns the default machine configuration
+ *
+ * @return MachineConfig_t
+ */
+MachineConfig_t machineDefaultConfig();
+
+/**
+ * @brief Returns the command line name of a layout ("none", "generic16k", "ascii8",
+ * "ascii16", "konami", "scc")
+ *
+ * @param mapper
+ * @return const char* NULL for unknown layouts
+ */
+const char *machineMapperName(MachineMapper mapper);
+
+/**
+ * @brief Finds a layout by its command line name
+ *
+ * @param name
+ * @param mapper Set if the name is known
+ * @return bool False if there is no layout with that name
+ */
+bool machineMapperFind(const char *name, MachineMapper *mapper);
+
+/**
+ * @brief Initializes a machine
+ *
+ * @param machine
+ * @param config Configuration, NULL for @ref machineDefaultConfig
+ * @return bool False if the machine could not be initialized (see machine->errors)
+ */
+bool machineInit(Machine_t *machine, const MachineConfig_t *config);
+
+/**
+ * @brief Releases everything owned by the machine
+ *
+ * @param machine
+ */
+void machineDestroy(Machine_t *machine);
+
+/**
+ * @brief Resets CPU, video, bank registers and scheduler. The ROM stays loaded
+ *
+ * @param machine
+ */
+void machineReset(Machine_t *machine);
+
+/**
+ * @brief Loads a ROM file and maps it with the layout of the machine, the whole image is
+ * reachable through the mapper (see @ref MachineMapper). Mapping a new image restores the
+ * power-on bank and slot selection. The previous ROM stays mapped if loading fails
+ *
+ * @param machine
+ * @param filename
+ * @param format
+ * @return bool
+ */
+bool machineLoadRom(Machine_t *machine, const char *filename, RomImageFormat format);
+
+/**
+ * @brief Loads a ROM from memory and maps it into the ROM window (see @ref machineLoadRom)
+ *
+ * @param machine
+ * @param data ROM contents, copied (or shared through the store)
+ * @param size
+ * @return bool False on error, also if a mapper layout is used and the image is not a whole
+ * number of banks (see machine->errors)
+ */
+bool machineLoadRomData(Machine_t *machine, const byte_t *data, size_t size);
+
+/**
+ * @brief Switches the execution backend. The new backend starts from the current state of
+ * the machine, the previous one is kept if the new one cannot be created
+ *
+ * @param machine
+ * @param backend NULL for the default backend
+ * @return bool False if out of memory or the backend cannot run the memory layout
+ */
+bool machineSetBackend(Machine_t *machine, const MachineBackend_t *backend);
+
+/**
+ * @brief Tells the backend the host changed guest memory (loads, debugger writes)
+ *
+ * @param machine
+ * @param address
+ * @param size
+ */
+void machineInvalidate(Machine_t *machine, word_t address, size_t size);
+
+/**
+ * @brief Tells the backend the host changed the CPU registers
+ *
+ * @param machine
+ */
+void machineSyncState(Machine_t *machine);
+
+/**
+ * @brief Executes one instruction. Always runs on the reference core, single stepping is
+ * for debugging, the backend is synchronized afterwards
+ *
+ * @param machine
+ * @return int Cycle count of the instruction
+ */
+int machineStep(Machine_t *machine);
+
+/**
+ * @brief Runs the machine for a number of cycles on its backend (see @ref zilogZ80Run)
+ *
+ * @param machine
+ * @param cycleBudget
+ * @return StopReason
+ */
+StopReason machineRun(Machine_t *machine, long cycleBudget);
+
+/**
+ * @brief Runs the machine for one scheduler frame
+ *
+ * @param machine
+ * @return StopReason
+ */
+StopReason machineRunFrame(Machine_t *machine);
+
+/**
+ * @brief Hash (64 bit FNV-1a) of the guest visible state: CPU registers, RAM and VRAM.
+ * Equal machines always have equal hashes, host pointers and counters are not included
+ *
+ * @param machine
+ * @return qword_t
+ */
+qword_t machineHashState(const Machine_t *machine);
+
+/**
+ * @brief Hash (64 bit FNV-1a) of the ROM image (of the ROM window before a ROM was loaded),
+ * tells apart machines running different ROMs
+ *
+ * @param machine
+ * @return qword_t
+ */
+qword_t machineHashRom(const Machine_t *machine);
+
+/**
+ * @brief Returns the bank and slot registers. Zero for the flat layout
+ *
+ * @param machine
+ * @param banks
+ */
+void machineGetBanks(const Machine_t *machine, MachineBanks_t *banks);
+
+/**
+ * @brief Selects banks and slots (e.g. from a saved state) and tells the backend
+ *
+ * @param machine
+ * @param banks Banks wrap around the bank count of the image
+ */
+void machineSetBanks(Machine_t *machine, const MachineBanks_t *banks);
+
+/**
+ * @brief Copies the guest state into a snapshot, the buffers are allocated by the first
+ * save and reused after that
+ *
+ * @param machine
+ * @param snapshot Zero initialized, or used by a previous save
+ * @return bool False if out of memory
+ */
+bool machineSaveSnapshot(const Machine_t *machine, MachineSnapshot_t *snapshot);
+
+/**
+ * @brief Puts the machine back into the state of a snapshot of the same machine type and
+ * synchronizes the backend
+ *
+ * @param machine
+ * @param snapshot
+ */
+void machineRestoreSnapshot(Machine_t *machine, const MachineSnapshot_t *snapshot);
+
+/**
+ * @brief Releases the buffers of a snapshot
+ *
+ * @param snapshot
+ */
+void machineSnapshotDestroy(MachineSnapshot_t *snapshot);
+
+#endif // CILOGC80_MACHINE_H
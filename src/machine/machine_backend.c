@@ -0,0 +1,230 @@
+#include "machine/machine_backend.h"
+
+#include <string.h>
+
+#include "machine/machine.h"
+#include "cpu/lane_core.h"
+
+/**
+ * @brief State of the lane backend: a lane core of which only lane 0 runs
+ */
+typedef struct LaneBackendState_t
+{
+    LaneCore_t lanes;
+} LaneBackendState_t;
+
+/* ---------------------------- Reference backend --------------------------- */
+/**
+ * @brief The reference core runs on the machine in place and has no state
+ */
+static bool referenceInit(Machine_t *machine, void **state);
+static void referenceDestroy(Machine_t *machine, void *state);
+static StopReason referenceRun(Machine_t *machine, void *state, long cycleBudget);
+static void referenceInvalidate(Machine_t *machine, void *state, word_t address, size_t size);
+static void referenceSyncState(Machine_t *machine, void *state);
+/* -------------------------------------------------------------------------- */
+
+/* ------------------------------ Lane backend ------------------------------ */
+/**
+ * @brief Allocates a lane core, halts lanes 1 to LANE_COUNT - 1 and copies the machine into
+ * lane 0. Fails for machines with a mapper, lane memory is a flat copy of the address space
+ */
+static bool laneInit(Machine_t *machine, void **state);
+static void laneDestroy(Machine_t *machine, void *state);
+
+/**
+ * @brief Steps lane 0 until the budget is used up, it halted or a stop was requested, then
+ * publishes registers and the writable pages of the machine
+ */
+static StopReason laneRun(Machine_t *machine, void *state, long cycleBudget);
+
+/**
+ * @brief Copies the changed range from the memory map of the machine into the lane memory
+ */
+static void laneInvalidate(Machine_t *machine, void *state, word_t address, size_t size);
+
+/**
+ * @brief Copies the registers of the machine into lane 0
+ */
+static void laneSyncState(Machine_t *machine, void *state);
+/* -------------------------------------------------------------------------- */
+
+static const MachineBackend_t backends[] = {
+    { "reference", "Instruction handlers of the CPU core, runs on the machine in place",
+      referenceInit, referenceDestroy, referenceRun, referenceInvalidate, referenceSyncState },
+    { "lane", "Lane 0 of the lane core (default memory layout, no watchpoints, profiles or traces)",
+      laneInit, laneDestroy, laneRun, laneInvalidate, laneSyncState }};
+
+size_t machineBackendCount()
+{
+    return sizeof(backends) / sizeof(backends[0]);
+}
+
+const MachineBackend_t *machineBackendGet(size_t index)
+{
+    return (index < machineBackendCount()) ? &backends[index] : NULL;
+}
+
+const MachineBackend_t *machineBackendFind(const char *name)
+{
+    for(size_t idx = 0; name != NULL && idx < machineBackendCount(); idx++)
+    {
+        if(strcmp(backends[idx].name, name) == 0)
+        {
+            return &backends[idx];
+        }
+    }
+
+    return NULL;
+}
+
+static bool referenceInit(Machine_t *machine, void **state)
+{
+    (void)machine;
+    *state = NULL;
+
+    return true;
+}
+
+static void referenceDestroy(Machine_t *machine, void *state)
+{
+    (void)machine;
+    (void)state;
+}
+
+static StopReason referenceRun(Machine_t *machine, void *state, long cycleBudget)
+{
+    (void)state;
+
+    return zilogZ80Run(&machine->cpu, cycleBudget);
+}
+
+static void referenceInvalidate(Machine_t *machine, void *state, word_t address, size_t size)
+{
+    (void)machine;
+    (void)state;
+    (void)address;
+    (void)size;
+}
+
+static void referenceSyncState(Machine_t *machine, void *state)
+{
+    (void)machine;
+    (void)state;
+}
+
+static bool laneInit(Machine_t *machine, void **state)
+{
+    // Bank and slot switches of the guest would never reach the flat copy
+    if(machine->mapperType != MACHINE_MAPPER_NONE)
+    {
+        return false;
+    }
+
+    LaneBackendState_t *lane = (LaneBackendState_t *)malloc(sizeof(LaneBackendState_t));
+
+    if(lane == NULL || laneCoreInit(&lane->lanes) == false)
+    {
+        free(lane);
+        return false;
+    }
+
+    for(int idx = 1; idx < LANE_COUNT; idx++)
+    {
+        lane->lanes.isHalted[idx] = 1;
+    }
+
+    laneInvalidate(machine, lane, 0x0000, LANE_MEMORY_SIZE);
+    laneSyncState(machine, lane);
+
+    *state = lane;
+
+    return true;
+}
+
+static void laneDestroy(Machine_t *machine, void *state)
+{
+    LaneBackendState_t *lane = (LaneBackendState_t *)state;
+    (void)machine;
+
+    laneCoreDestroy(&lane->lanes);
+    free(lane);
+}
+
+static StopReason laneRun(Machine_t *machine, void *state, long cycleBudget)
+{
+    LaneCore_t *lanes = &((LaneBackendState_t *)state)->lanes;
+    ZilogZ80_t *cpu = &machine->cpu;
+    ZilogZ80_t *scalar = &lanes->scalarCores[0];
+    long cycles = 0;
+    long instructions = 0;
+
+    // I/O of the scalar fallback goes to the devices of the machine, a callback stops the
+    // run through zilogZ80RequestStop(&machine->cpu)
+    memcpy(scalar->inputCallback, cpu->inputCallback, sizeof(cpu->inputCallback));
+    memcpy(scalar->outputCallback, cpu->outputCallback, sizeof(cpu->outputCallback));
+    memcpy(scalar->portContext, cpu->portContext, sizeof(cpu->portContext));
+    scalar->ioContext = cpu->ioContext;
+
+    cpu->stopReason = STOP_REASON_NONE;
+
+    while(cpu->stopReason == STOP_REASON_NONE)
+    {
+        if(lanes->isHalted[0] != 0)
+        {
+            cpu->stopReason = STOP_REASON_HALT;
+            cpu->stopPC = cpu->instructionPC;
+            break;
+        }
+        if(cycles >= cycleBudget)
+        {
+            cpu->stopReason = STOP_REASON_BUDGET;
+            cpu->stopPC = lanes->PC[0];
+            break;
+        }
+
+        qword_t laneCycles = lanes->cycles[0];
+        cpu->instructionPC = lanes->PC[0];
+
+        laneCoreStep(lanes);
+        cycles += (long)(lanes->cycles[0] - laneCycles);
+        instructions++;
+    }
+
+    laneCoreGetState(lanes, 0, cpu);
+    cpu->cyclesInFrame -= (int)cycles;
+    cpu->totalCycles += (int)cycles;
+    cpu->runCycles = cycles;
+    cpu->runInstructions = instructions;
+
+    // Lane kernels never write memory and the ROM window is read-only, only pages the
+    // machine can write to can have changed
+    const byte_t *memory = laneCoreMemory(lanes, 0);
+    for(size_t page = 0; page < MEMORY_PAGE_COUNT; page++)
+    {
+        byte_t *writeData = cpu->memoryMap.pages[page].writeData;
+
+        if(writeData != NULL)
+        {
+            memcpy(writeData, memory + (page << MEMORY_PAGE_SHIFT), MEMORY_PAGE_SIZE);
+        }
+    }
+
+    return cpu->stopReason;
+}
+
+static void laneInvalidate(Machine_t *machine, void *state, word_t address, size_t size)
+{
+    byte_t *memory = laneCoreMemory(&((LaneBackendState_t *)state)->lanes, 0);
+    size_t end = ((size_t)address + size < LANE_MEMORY_SIZE) ? (size_t)address + size : LANE_MEMORY_SIZE;
+
+    for(size_t idx = address; idx < end; idx++)
+    {
+        memory[idx] = memoryMapPeekByte(&machine->cpu.memoryMap, (word_t)idx);
+    }
+}
+
+static void laneSyncState(Machine_t *machine, void *state)
+{
+    laneCoreSetState(&((LaneBackendState_t *)state)->lanes, 0, &machine->cpu);
+}
@@ -0,0 +1,76 @@
+#ifndef CILOGC80_MACHINE_BACKEND_H
+#define CILOGC80_MACHINE_BACKEND_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "utils/utils.h"
+#include "cpu/cpu.h"
+
+struct Machine_t;
+
+/**
+ * @brief Execution backend of a machine. The machine (its CPU registers, memory map and
+ * I/O callbacks) is always the authoritative state between two runs: a backend starts
+ * every run from its own copy, and publishes registers, memory and the run statistics
+ * back into machine->cpu before run returns. Hosts that change the machine behind the
+ * backend's back tell it through invalidate (memory) and syncState (registers).
+ *
+ * Backends are stateless tables, everything a backend needs per machine lives in the
+ * state returned by init, so machines on different threads can share a backend
+ */
+typedef struct MachineBackend_t
+{
+    /** @brief Short lower case name used by the command line tools ("reference", "lane") */
+    const char *name;
+    const char *description;
+
+    /**
+     * @brief Creates the per machine state and copies the machine into it
+     *
+     * @return bool False if out of memory or the backend cannot run the memory layout of the
+     * machine (*state is left untouched)
+     */
+    bool (*init)(struct Machine_t *machine, void **state);
+
+    /** @brief Releases the state created by init, the machine keeps the published state */
+    void (*destroy)(struct Machine_t *machine, void *state);
+
+    /**
+     * @brief Executes instructions until the budget is used up, the CPU halted or
+     * @ref zilogZ80RequestStop was called on machine->cpu. Sets stopReason, stopPC,
+     * runCycles and runInstructions of machine->cpu like @ref zilogZ80Run
+     */
+    StopReason (*run)(struct Machine_t *machine, void *state, long cycleBudget);
+
+    /** @brief The host changed guest memory in [address, address + size) */
+    void (*invalidate)(struct Machine_t *machine, void *state, word_t address, size_t size);
+
+    /** @brief The host changed the CPU registers (reset, debugger, single step) */
+    void (*syncState)(struct Machine_t *machine, void *state);
+} MachineBackend_t;
+
+/**
+ * @brief Returns the number of registered backends
+ *
+ * @return size_t
+ */
+size_t machineBackendCount();
+
+/**
+ * @brief Returns a registered backend, index 0 is the default (the reference core)
+ *
+ * @param index
+ * @return const MachineBackend_t* NULL if index is out of range
+ */
+const MachineBackend_t *machineBackendGet(size_t index);
+
+/**
+ * @brief Finds a backend by name
+ *
+ * @param name
+ * @return const MachineBackend_t* NULL if there is no backend with that name
+ */
+const MachineBackend_t *machineBackendFind(const char *name);
+
+#endif // CILOGC80_MACHINE_BACKEND_H
@@ -0,0 +1,459 @@
+#include "machine/save_state.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/error_handler.h"
+
+/** @brief Suffix of the file a state is written to before it replaces the target */
+#define TEMPORARY_SUFFIX ".tmp"
+
+/**
+ * @brief Section while a state is being written
+ */
+typedef struct SectionSource_t
+{
+    SaveStateSectionType type;
+    const void *data;
+    size_t size;
+} SectionSource_t;
+
+/**
+ * @brief Rounds a size up to the next multiple of @ref SAVE_STATE_ALIGNMENT
+ *
+ * @param size
+ * @return qword_t
+ */
+static qword_t alignSize(qword_t size);
+
+/**
+ * @brief Writes the header page and every section followed by its padding
+ *
+ * @param stream
+ * @param header
+ * @param sources
+ * @param sections
+ * @return bool False if a write failed
+ */
+static bool writeSections(FILE *stream, const SaveStateHeader_t *header, const SectionSource_t *sources,
+                          const SaveStateSection_t *sections);
+
+/**
+ * @brief Copies registers, interrupt state and cycle counters into the CPU section layout
+ *
+ * @param state
+ * @param cpu
+ */
+static void packCpu(SaveStateCpu_t *state, const ZilogZ80_t *cpu);
+
+/**
+ * @brief Copies a CPU section back into the registers, memory and callbacks are untouched
+ *
+ * @param cpu
+ * @param state
+ */
+static void unpackCpu(ZilogZ80_t *cpu, const SaveStateCpu_t *state);
+
+/**
+ * @brief Copies the layout and the bank and slot registers into the bank section layout
+ *
+ * @param state
+ * @param machine
+ */
+static void packBanks(SaveStateBanks_t *state, const Machine_t *machine);
+
+/* ---------------------------------- Writer -------------------------------- */
+bool saveStateWrite(const Machine_t *machine, const char *filename, const void *hostData, size_t hostSize)
+{
+    SaveStateCpu_t cpu;
+    packCpu(&cpu, &machine->cpu);
+
+    SaveStateScheduler_t scheduler = {
+        .cyclesPerFrame = (qword_t)machine->scheduler.cyclesPerFrame,
+        .frameCycles = (qword_t)machine->scheduler.frameCycles,
+        .frameCount = machine->scheduler.frameCount,
+        .totalCycles = machine->scheduler.totalCycles};
+
+    SaveStateVdp_t vdp = {
+        .vramAddress = machine->vdp.vramAddress,
+        .reserved = 0,
+        .mode = (dword_t)machine->vdp.mode};
+    memcpy(vdp.registers, machine->vdp.registers, TMS_REGISTER_COUNT);
+
+    SaveStateBanks_t banks;
+    packBanks(&banks, machine);
+
+    SectionSource_t sources[] =
+    {
+        { SAVE_STATE_SECTION_CPU, &cpu, sizeof(cpu) },
+        { SAVE_STATE_SECTION_SCHEDULER, &scheduler, sizeof(scheduler) },
+        { SAVE_STATE_SECTION_VDP, &vdp, sizeof(vdp) },
+        { SAVE_STATE_SECTION_RAM, machine->cpu.ram.data, (machine->cpu.ram.data != NULL) ? machine->cpu.ram.memorySize : 0 },
+        { SAVE_STATE_SECTION_VRAM, machine->vdp.vram.data, (machine->vdp.vram.data != NULL) ? machine->vdp.vram.memorySize : 0 },
+        { SAVE_STATE_SECTION_BANKS, &banks, sizeof(banks) },
+        { SAVE_STATE_SECTION_HOST, hostData, hostSize }
+    };
+    size_t sectionCount = (hostData != NULL) ? 7 : 6;
+
+    SaveStateSection_t sections[SAVE_STATE_MAX_SECTIONS];
+    qword_t offset = SAVE_STATE_ALIGNMENT;
+
+    for(size_t idx = 0; idx < sectionCount; idx++)
+    {
+        sections[idx] = (SaveStateSection_t){
+            .type = (dword_t)sources[idx].type,
+            .reserved = 0,
+            .offset = offset,
+            .size = sources[idx].size};
+        offset += alignSize(sources[idx].size);
+    }
+
+    SaveStateHeader_t header = {
+        .version = SAVE_STATE_VERSION,
+        .alignment = SAVE_STATE_ALIGNMENT,
+        .sectionCount = (dword_t)sectionCount,
+        .reserved = 0,
+        .romHash = machineHashRom(machine),
+        .fileSize = offset};
+    memcpy(header.magic, SAVE_STATE_MAGIC, sizeof(header.magic));
+
+    size_t nameLength = strlen(filename);
+    char *temporaryName = (char *)malloc(nameLength + sizeof(TEMPORARY_SUFFIX));
+    if(temporaryName == NULL)
+    {
+        setError(C80_ERROR_STATE_FILE_WRITE_ERROR);
+        return false;
+    }
+    memcpy(temporaryName, filename, nameLength);
+    memcpy(temporaryName + nameLength, TEMPORARY_SUFFIX, sizeof(TEMPORARY_SUFFIX));
+
+    FILE *stream = fopen(temporaryName, "wb");
+    bool isWritten = (stream != NULL) && writeSections(stream, &header, sources, sections);
+
+    if(stream != NULL && fclose(stream) != 0)
+    {
+        isWritten = false;
+    }
+
+#if defined(_WIN32)
+    // rename does not replace existing files on Windows
+    if(isWritten == true)
+    {
+        remove(filename);
+    }
+#endif
+
+    if(isWritten == false || rename(temporaryName, filename) != 0)
+    {
+        setError(C80_ERROR_STATE_FILE_WRITE_ERROR);
+        remove(temporaryName);
+        free(temporaryName);
+        return false;
+    }
+
+    free(temporaryName);
+
+    return true;
+}
+
+/* ---------------------------------- Reader -------------------------------- */
+bool saveStateOpen(SaveStateFile_t *file, const char *filename)
+{
+    memset(file, 0x00, sizeof(SaveStateFile_t));
+
+    if(fileMapOpen(&file->map, filename) == false)
+    {
+        setError(C80_ERROR_STATE_FILE_NOT_FOUND);
+        return false;
+    }
+
+    if(file->map.size < SAVE_STATE_ALIGNMENT)
+    {
+        setError(C80_ERROR_STATE_FILE_FORMAT_ERROR);
+        saveStateClose(file);
+        return false;
+    }
+
+    memcpy(&file->header, file->map.data, sizeof(SaveStateHeader_t));
+
+    if(memcmp(file->header.magic, SAVE_STATE_MAGIC, sizeof(file->header.magic)) != 0
+        || file->header.version != SAVE_STATE_VERSION
+        || file->header.alignment != SAVE_STATE_ALIGNMENT
+        || file->header.sectionCount > SAVE_STATE_MAX_SECTIONS
+        || file->header.fileSize != file->map.size)
+    {
+        setError(C80_ERROR_STATE_FILE_FORMAT_ERROR);
+        saveStateClose(file);
+        return false;
+    }
+
+    file->sections = (const SaveStateSection_t *)(file->map.data + sizeof(SaveStateHeader_t));
+
+    for(dword_t idx = 0; idx < file->header.sectionCount; idx++)
+    {
+        const SaveStateSection_t *section = &file->sections[idx];
+
+        if(section->offset % SAVE_STATE_ALIGNMENT != 0 || section->offset < SAVE_STATE_ALIGNMENT
+            || section->offset > file->map.size || section->size > file->map.size - section->offset)
+        {
+            setError(C80_ERROR_STATE_FILE_FORMAT_ERROR);
+            saveStateClose(file);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void saveStateClose(SaveStateFile_t *file)
+{
+    if(file == NULL)
+    {
+        return;
+    }
+
+    fileMapClose(&file->map);
+    memset(file, 0x00, sizeof(SaveStateFile_t));
+}
+
+const byte_t *saveStateSection(const SaveStateFile_t *file, SaveStateSectionType type, size_t *size)
+{
+    for(dword_t idx = 0; idx < file->header.sectionCount; idx++)
+    {
+        if(file->sections[idx].type == (dword_t)type)
+        {
+            if(size != NULL)
+            {
+                *size = (size_t)file->sections[idx].size;
+            }
+            return file->map.data + file->sections[idx].offset;
+        }
+    }
+
+    if(size != NULL)
+    {
+        *size = 0;
+    }
+
+    return NULL;
+}
+
+bool saveStateApply(const SaveStateFile_t *file, Machine_t *machine)
+{
+    size_t cpuSize, schedulerSize, vdpSize, ramSize, vramSize, banksSize;
+    const byte_t *cpuData = saveStateSection(file, SAVE_STATE_SECTION_CPU, &cpuSize);
+    const byte_t *schedulerData = saveStateSection(file, SAVE_STATE_SECTION_SCHEDULER, &schedulerSize);
+    const byte_t *vdpData = saveStateSection(file, SAVE_STATE_SECTION_VDP, &vdpSize);
+    const byte_t *ram = saveStateSection(file, SAVE_STATE_SECTION_RAM, &ramSize);
+    const byte_t *vram = saveStateSection(file, SAVE_STATE_SECTION_VRAM, &vramSize);
+    const byte_t *banksData = saveStateSection(file, SAVE_STATE_SECTION_BANKS, &banksSize);
+
+    if(cpuData == NULL || cpuSize != sizeof(SaveStateCpu_t)
+        || schedulerData == NULL || schedulerSize != sizeof(SaveStateScheduler_t)
+        || vdpData == NULL || vdpSize != sizeof(SaveStateVdp_t)
+        || ram == NULL || vram == NULL
+        || banksData == NULL || banksSize != sizeof(SaveStateBanks_t))
+    {
+        setError(C80_ERROR_STATE_FILE_FORMAT_ERROR);
+        return false;
+    }
+
+    SaveStateCpu_t cpu;
+    SaveStateScheduler_t scheduler;
+    SaveStateVdp_t vdp;
+    SaveStateBanks_t banks;
+    memcpy(&cpu, cpuData, sizeof(cpu));
+    memcpy(&scheduler, schedulerData, sizeof(scheduler));
+    memcpy(&vdp, vdpData, sizeof(vdp));
+    memcpy(&banks, banksData, sizeof(banks));
+
+    if(cpu.interruptMode > INTERRUPT_MODE_2 || cpu.interruptStatus > INTERRUPTS_DISABLED || vdp.mode > TEXT_MODE)
+    {
+        setError(C80_ERROR_STATE_FILE_FORMAT_ERROR);
+        return false;
+    }
+
+    // Another ROM or memory layout would make the rest of the state meaningless
+    if(file->header.romHash != machineHashRom(machine)
+        || banks.mapper != (dword_t)machine->mapperType
+        || ramSize != ((machine->cpu.ram.data != NULL) ? machine->cpu.ram.memorySize : 0)
+        || vramSize != ((machine->vdp.vram.data != NULL) ? machine->vdp.vram.memorySize : 0))
+    {
+        setError(C80_ERROR_STATE_FILE_ROM_MISMATCH);
+        return false;
+    }
+
+    unpackCpu(&machine->cpu, &cpu);
+
+    // Page aligned in the mapping, a straight copy at memory speed
+    if(ramSize > 0)
+    {
+        memcpy(machine->cpu.ram.data, ram, ramSize);
+    }
+    if(vramSize > 0)
+    {
+        memcpy(machine->vdp.vram.data, vram, vramSize);
+    }
+
+    memcpy(machine->vdp.registers, vdp.registers, TMS_REGISTER_COUNT);
+    machine->vdp.vramAddress = vdp.vramAddress;
+    machine->vdp.mode = (TMS9918_Mode)vdp.mode;
+
+    MachineBanks_t machineBanks;
+    memset(&machineBanks, 0x00, sizeof(MachineBanks_t));
+    for(size_t window = 0; window < MAPPER_MAX_WINDOWS; window++)
+    {
+        machineBanks.banks[window] = banks.banks[window];
+    }
+    machineBanks.primarySlotSelect = banks.primarySlotSelect;
+    memcpy(machineBanks.secondarySlotSelect, banks.secondarySlotSelect, MSX_SLOT_COUNT);
+    machineSetBanks(machine, &machineBanks);
+
+    machine->scheduler.cyclesPerFrame = (long)scheduler.cyclesPerFrame;
+    machine->scheduler.frameCycles = (long)scheduler.frameCycles;
+    machine->scheduler.frameCount = scheduler.frameCount;
+    machine->scheduler.totalCycles = scheduler.totalCycles;
+
+    machineSyncState(machine);
+    machineInvalidate(machine, CPU_RAM_START_ADDRESS, CPU_RAM_SIZE);
+
+    return true;
+}
+
+bool saveStateLoad(Machine_t *machine, const char *filename)
+{
+    ErrorStack_t *previousErrors = errorStackSetCurrent(&machine->errors);
+    SaveStateFile_t file;
+
+    bool isApplied = saveStateOpen(&file, filename) && saveStateApply(&file, machine);
+    saveStateClose(&file);
+
+    errorStackSetCurrent(previousErrors);
+
+    return isApplied;
+}
+
+static qword_t alignSize(qword_t size)
+{
+    return (size + SAVE_STATE_ALIGNMENT - 1) / SAVE_STATE_ALIGNMENT * SAVE_STATE_ALIGNMENT;
+}
+
+static bool writeSections(FILE *stream, const SaveStateHeader_t *header, const SectionSource_t *sources,
+                          const SaveStateSection_t *sections)
+{
+    static const byte_t padding[SAVE_STATE_ALIGNMENT] = { 0 };
+    byte_t page[SAVE_STATE_ALIGNMENT] = { 0 };
+
+    memcpy(page, header, sizeof(SaveStateHeader_t));
+    memcpy(page + sizeof(SaveStateHeader_t), sections, header->sectionCount * sizeof(SaveStateSection_t));
+
+    if(fwrite(page, 1, sizeof(page), stream) != sizeof(page))
+    {
+        return false;
+    }
+
+    for(dword_t idx = 0; idx < header->sectionCount; idx++)
+    {
+        size_t size = sources[idx].size;
+        size_t paddingSize = (size_t)(alignSize(size) - size);
+
+        if((size > 0 && fwrite(sources[idx].data, 1, size, stream) != size)
+            || (paddingSize > 0 && fwrite(padding, 1, paddingSize, stream) != paddingSize))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void packCpu(SaveStateCpu_t *state, const ZilogZ80_t *cpu)
+{
+    memset(state, 0x00, sizeof(SaveStateCpu_t));
+
+    state->A = cpu->A;
+    state->B = cpu->B;
+    state->C = cpu->C;
+    state->D = cpu->D;
+    state->E = cpu->E;
+    state->H = cpu->H;
+    state->L = cpu->L;
+    state->F = zilogZ80FlagsToByte(cpu->F);
+
+    state->A_ = cpu->A_;
+    state->B_ = cpu->B_;
+    state->C_ = cpu->C_;
+    state->D_ = cpu->D_;
+    state->E_ = cpu->E_;
+    state->H_ = cpu->H_;
+    state->L_ = cpu->L_;
+    state->F_ = zilogZ80FlagsToByte(cpu->F_);
+
+    state->SP = cpu->SP;
+    state->PC = cpu->PC;
+    state->IX = cpu->IX;
+    state->IY = cpu->IY;
+    state->instructionPC = cpu->instructionPC;
+    state->I = cpu->I;
+    state->R = cpu->R;
+
+    state->interruptStatus = (byte_t)cpu->interruptStatus;
+    state->interruptMode = (byte_t)cpu->interruptMode;
+    state->isHaltered = (cpu->isHaltered == true) ? 1 : 0;
+
+    state->cyclesInFrame = (dword_t)cpu->cyclesInFrame;
+    state->totalCycles = (dword_t)cpu->totalCycles;
+}
+
+static void unpackCpu(ZilogZ80_t *cpu, const SaveStateCpu_t *state)
+{
+    cpu->A = state->A;
+    cpu->B = state->B;
+    cpu->C = state->C;
+    cpu->D = state->D;
+    cpu->E = state->E;
+    cpu->H = state->H;
+    cpu->L = state->L;
+    cpu->F = zilogZ80FlagsFromByte(state->F);
+
+    cpu->A_ = state->A_;
+    cpu->B_ = state->B_;
+    cpu->C_ = state->C_;
+    cpu->D_ = state->D_;
+    cpu->E_ = state->E_;
+    cpu->H_ = state->H_;
+    cpu->L_ = state->L_;
+    cpu->F_ = zilogZ80FlagsFromByte(state->F_);
+
+    cpu->SP = state->SP;
+    cpu->PC = state->PC;
+    cpu->IX = state->IX;
+    cpu->IY = state->IY;
+    cpu->instructionPC = state->instructionPC;
+    cpu->I = state->I;
+    cpu->R = state->R;
+
+    cpu->interruptStatus = (InterruptStatus)state->interruptStatus;
+    cpu->interruptMode = (InterruptMode)state->interruptMode;
+    cpu->isHaltered = (state->isHaltered != 0);
+
+    cpu->cyclesInFrame = (int)state->cyclesInFrame;
+    cpu->totalCycles = (int)state->totalCycles;
+}
+
+static void packBanks(SaveStateBanks_t *state, const Machine_t *machine)
+{
+    MachineBanks_t banks;
+    machineGetBanks(machine, &banks);
+
+    memset(state, 0x00, sizeof(SaveStateBanks_t));
+
+    state->mapper = (dword_t)machine->mapperType;
+    for(size_t window = 0; window < MAPPER_MAX_WINDOWS; window++)
+    {
+        state->banks[window] = (dword_t)banks.banks[window];
+    }
+    state->primarySlotSelect = banks.primarySlotSelect;
+    memcpy(state->secondarySlotSelect, banks.secondarySlotSelect, MSX_SLOT_COUNT);
+}
@@ -0,0 +1,188 @@
+#ifndef CILOGC80_SAVE_STATE_H
+#define CILOGC80_SAVE_STATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "utils/utils.h"
+#include "utils/file_map.h"
+#include "machine/machine.h"
+
+/** @brief Magic of a save state file */
+#define SAVE_STATE_MAGIC "C80STATE"
+#define SAVE_STATE_VERSION 2
+/**
+ * @brief Every section starts at a multiple of this, so a mapped file hands out page aligned
+ * RAM and VRAM that can be copied (or mapped) without any parsing
+ */
+#define SAVE_STATE_ALIGNMENT 4096
+/** @brief Sections a file may have, the section table has to fit the header page */
+#define SAVE_STATE_MAX_SECTIONS 16
+
+/**
+ * @brief Enum struct for defining the section types of a save state
+ */
+typedef enum SaveStateSectionType
+{
+    SAVE_STATE_SECTION_CPU = 1,
+    SAVE_STATE_SECTION_SCHEDULER,
+    SAVE_STATE_SECTION_VDP,
+    SAVE_STATE_SECTION_RAM,
+    SAVE_STATE_SECTION_VRAM,
+    /** @brief Optional, written and read by the owner of the machine (e.g. batch job I/O) */
+    SAVE_STATE_SECTION_HOST,
+    SAVE_STATE_SECTION_BANKS
+} SaveStateSectionType;
+
+/**
+ * @brief File header, followed by the section table. Header and table fill the first page
+ */
+typedef struct SaveStateHeader_t
+{
+    char magic[8];
+    dword_t version;
+    /** @brief @ref SAVE_STATE_ALIGNMENT of the writer */
+    dword_t alignment;
+    dword_t sectionCount;
+    dword_t reserved;
+    /** @brief @ref machineHashRom of the saved machine, states only load on the same ROM */
+    qword_t romHash;
+    qword_t fileSize;
+} SaveStateHeader_t;
+
+/**
+ * @brief Section table entry
+ */
+typedef struct SaveStateSection_t
+{
+    dword_t type;
+    dword_t reserved;
+    /** @brief File offset, a multiple of the alignment */
+    qword_t offset;
+    qword_t size;
+} SaveStateSection_t;
+
+/**
+ * @brief CPU section. Fixed layout with explicit widths, nothing depends on the host struct
+ */
+typedef struct SaveStateCpu_t
+{
+    byte_t A, B, C, D, E, H, L, F;
+    byte_t A_, B_, C_, D_, E_, H_, L_, F_;
+    word_t SP, PC, IX, IY, instructionPC;
+    byte_t I, R;
+    byte_t interruptStatus;
+    byte_t interruptMode;
+    byte_t isHaltered;
+    byte_t reserved[3];
+    dword_t cyclesInFrame;
+    dword_t totalCycles;
+} SaveStateCpu_t;
+
+/**
+ * @brief Scheduler section
+ */
+typedef struct SaveStateScheduler_t
+{
+    qword_t cyclesPerFrame;
+    qword_t frameCycles;
+    qword_t frameCount;
+    qword_t totalCycles;
+} SaveStateScheduler_t;
+
+/**
+ * @brief VDP section, the VRAM has a section of its own
+ */
+typedef struct SaveStateVdp_t
+{
+    byte_t registers[TMS_REGISTER_COUNT];
+    word_t vramAddress;
+    word_t reserved;
+    dword_t mode;
+} SaveStateVdp_t;
+
+/**
+ * @brief Bank section: the layout of the machine and the bank and slot registers
+ */
+typedef struct SaveStateBanks_t
+{
+    /** @brief @ref MachineMapper of the saved machine, states only load on the same layout */
+    dword_t mapper;
+    dword_t banks[MAPPER_MAX_WINDOWS];
+    byte_t primarySlotSelect;
+    byte_t secondarySlotSelect[MSX_SLOT_COUNT];
+    byte_t reserved[3];
+} SaveStateBanks_t;
+
+/**
+ * @brief Opened save state. Sections point into the mapping, they are valid until
+ * @ref saveStateClose
+ */
+typedef struct SaveStateFile_t
+{
+    FileMap_t map;
+    SaveStateHeader_t header;
+    const SaveStateSection_t *sections;
+} SaveStateFile_t;
+
+/**
+ * @brief Writes the machine state to a file: CPU, scheduler, VDP, RAM, VRAM, banks and an
+ * optional host section. The file is written next to the target and renamed over it, so an
+ * interrupted save never destroys the previous state
+ *
+ * @param machine
+ * @param filename
+ * @param hostData Contents of the host section, NULL for none
+ * @param hostSize
+ * @return bool False if the file could not be written (see error handler)
+ */
+bool saveStateWrite(const Machine_t *machine, const char *filename, const void *hostData, size_t hostSize);
+
+/**
+ * @brief Maps a save state and checks its header and section table
+ *
+ * @param file
+ * @param filename
+ * @return bool False if the file is missing or malformed (see error handler)
+ */
+bool saveStateOpen(SaveStateFile_t *file, const char *filename);
+
+/**
+ * @brief Unmaps a save state
+ *
+ * @param file
+ */
+void saveStateClose(SaveStateFile_t *file);
+
+/**
+ * @brief Returns a section of an opened save state
+ *
+ * @param file
+ * @param type
+ * @param size Size of the section, may be NULL
+ * @return const byte_t* NULL if the file has no such section
+ */
+const byte_t *saveStateSection(const SaveStateFile_t *file, SaveStateSectionType type, size_t *size);
+
+/**
+ * @brief Puts the machine into the state of an opened save state and synchronizes the
+ * backend. Every section is checked first, a state that does not fit leaves the machine as
+ * it was
+ *
+ * @param file
+ * @param machine
+ * @return bool False if the state belongs to another ROM, memory layout or mapper (see error
+ * handler)
+ */
+bool saveStateApply(const SaveStateFile_t *file, Machine_t *machine);
+
+/**
+ * @brief Opens, applies and closes a save state
+ *
+ * @param machine
+ * @param filename
+ * @return bool False on error (see machine->errors)
+ */
+bool saveStateLoad(Machine_t *machine, const char *filename);
+
+#endif // CILOGC80_SAVE_STATE_H
@@ -0,0 +1,218 @@
+#include "mapper.h"
+
+#include <string.h>
+
+#include "utils/error_handler.h"
+
+/** @brief First address of the cartridge windows */
+#define CARTRIDGE_WINDOW_START 0x4000
+/** @brief Size of the cartridge area containing windows and bank registers */
+#define CARTRIDGE_AREA_SIZE 0x8000
+
+#define BANK_SIZE_8K 0x2000
+#define BANK_SIZE_16K 0x4000
+
+/**
+ * @brief Write handler decoding the bank registers of the cartridge mappers
+ *
+ * @param context Mapper
+ * @param address
+ * @param value Selected bank
+ */
+static void cartridgeRegisterWrite(void *context, word_t address, byte_t value);
+
+/**
+ * @brief Maps every window with its currently selected bank
+ *
+ * @param mapper
+ */
+static void mapAllWindows(Mapper_t *mapper);
+
+bool mapperInit(Mapper_t *mapper, MapperType_t type, MemoryMap_t *map, byte_t *image, size_t imageSize)
+{
+    if(mapper == NULL || map == NULL || image == NULL)
+    {
+        setError(C80_ERROR_MEMORY_MAP_ERROR);
+        return false;
+    }
+
+    memset(mapper, 0x00, sizeof(Mapper_t));
+
+    mapper->type = type;
+    mapper->map = map;
+    mapper->image = image;
+    mapper->imageSize = imageSize;
+    mapper->isWritable = false;
+    mapper->windowStartAddress = CARTRIDGE_WINDOW_START;
+
+    switch(type)
+    {
+        case MAPPER_TYPE_ASCII8:
+        case MAPPER_TYPE_KONAMI:
+        case MAPPER_TYPE_KONAMI_SCC:
+            mapper->bankSize = BANK_SIZE_8K;
+            mapper->windowCount = 4;
+            break;
+        case MAPPER_TYPE_ASCII16:
+            mapper->bankSize = BANK_SIZE_16K;
+            mapper->windowCount = 2;
+            break;
+        case MAPPER_TYPE_GENERIC_16K:
+        default:
+            setError(C80_ERROR_MEMORY_MAP_ERROR);
+            return false;
+    }
+
+    if(imageSize < mapper->bankSize || (imageSize % mapper->bankSize) != 0)
+    {
+        setError(C80_ERROR_ROM_FILE_TOO_LARGE);
+        return false;
+    }
+    mapper->bankCount = imageSize / mapper->bankSize;
+
+    mapperReset(mapper);
+    memoryMapSetWriteHandler(map, CARTRIDGE_WINDOW_START, CARTRIDGE_AREA_SIZE, cartridgeRegisterWrite, mapper);
+
+    return true;
+}
+
+bool mapperInitGeneric(Mapper_t *mapper, MemoryMap_t *map, size_t firstWindow, size_t windowCount,
+                       byte_t *image, size_t imageSize, bool isWritable)
+{
+    if(mapper == NULL || map == NULL || image == NULL
+        || windowCount == 0 || windowCount > MAPPER_MAX_WINDOWS || (firstWindow + windowCount) > 4
+        || imageSize < BANK_SIZE_16K || (imageSize % BANK_SIZE_16K) != 0)
+    {
+        setError(C80_ERROR_MEMORY_MAP_ERROR);
+        return false;
+    }
+
+    memset(mapper, 0x00, sizeof(Mapper_t));
+
+    mapper->type = MAPPER_TYPE_GENERIC_16K;
+    mapper->map = map;
+    mapper->image = image;
+    mapper->imageSize = imageSize;
+    mapper->isWritable = isWritable;
+    mapper->bankSize = BANK_SIZE_16K;
+    mapper->bankCount = imageSize / BANK_SIZE_16K;
+    mapper->windowStartAddress = (word_t)(firstWindow * BANK_SIZE_16K);
+    mapper->windowCount = windowCount;
+
+    // Generic windows are plain memory, nothing may stay from a previous mapping
+    memoryMapUnmap(map, mapper->windowStartAddress, windowCount * BANK_SIZE_16K);
+    mapperReset(mapper);
+
+    return true;
+}
+
+void mapperSelectBank(Mapper_t *mapper, size_t window, size_t bank)
+{
+    if(mapper == NULL || window >= mapper->windowCount)
+    {
+        return;
+    }
+
+    bank %= mapper->bankCount;
+    mapper->banks[window] = bank;
+
+    word_t windowAddress = (word_t)(mapper->windowStartAddress + window * mapper->bankSize);
+    byte_t *bankData = mapper->image + bank * mapper->bankSize;
+
+    memoryMapSetReadData(mapper->map, windowAddress, mapper->bankSize, bankData);
+    if(mapper->isWritable == true)
+    {
+        memoryMapSetWriteData(mapper->map, windowAddress, mapper->bankSize, bankData);
+    }
+
+    if(mapper->remapCallback != NULL)
+    {
+        mapper->remapCallback(mapper->remapContext, mapper->map, windowAddress, mapper->bankSize);
+    }
+}
+
+size_t mapperGetBank(const Mapper_t *mapper, size_t window)
+{
+    if(mapper == NULL || window >= mapper->windowCount)
+    {
+        return 0;
+    }
+
+    return mapper->banks[window];
+}
+
+void mapperReset(Mapper_t *mapper)
+{
+    if(mapper == NULL)
+    {
+        return;
+    }
+
+    for(size_t window = 0; window < mapper->windowCount; window++)
+    {
+        // Konami carts power up with banks 0-3, everything else starts at bank 0 in every
+        // cartridge window and with an identity mapping for generic paging
+        switch(mapper->type)
+        {
+            case MAPPER_TYPE_KONAMI:
+            case MAPPER_TYPE_KONAMI_SCC:
+            case MAPPER_TYPE_GENERIC_16K:
+                mapper->banks[window] = window % mapper->bankCount;
+                break;
+            default:
+                mapper->banks[window] = 0;
+                break;
+        }
+    }
+
+    mapAllWindows(mapper);
+}
+
+static void cartridgeRegisterWrite(void *context, word_t address, byte_t value)
+{
+    Mapper_t *mapper = (Mapper_t *)context;
+
+    switch(mapper->type)
+    {
+        case MAPPER_TYPE_ASCII8:
+            if(address >= 0x6000 && address < 0x8000)
+            {
+                mapperSelectBank(mapper, (address >> 11) & 0x03, value);
+            }
+            break;
+        case MAPPER_TYPE_ASCII16:
+            if(address >= 0x6000 && address < 0x6800)
+            {
+                mapperSelectBank(mapper, 0, value);
+            }
+            else if(address >= 0x7000 && address < 0x7800)
+            {
+                mapperSelectBank(mapper, 1, value);
+            }
+            break;
+        case MAPPER_TYPE_KONAMI:
+            // First window is fixed to bank 0
+            if(address >= 0x6000)
+            {
+                mapperSelectBank(mapper, (address - CARTRIDGE_WINDOW_START) >> 13, value);
+            }
+            break;
+        case MAPPER_TYPE_KONAMI_SCC:
+            if((address & 0x1800) == 0x1000)
+            {
+                mapperSelectBank(mapper, (address - CARTRIDGE_WINDOW_START) >> 13, value);
+            }
+            break;
+        case MAPPER_TYPE_GENERIC_16K:
+        default:
+            break;
+    }
+}
+
+static void mapAllWindows(Mapper_t *mapper)
+{
+    for(size_t window = 0; window < mapper->windowCount; window++)
+    {
+        mapperSelectBank(mapper, window, mapper->banks[window]);
+    }
+}
@@ -0,0 +1,130 @@
+#ifndef CILOG_C80_MAPPER_H
+#define CILOG_C80_MAPPER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "utils/utils.h"
+#include "memory/memory_map.h"
+
+/** @brief Maximum number of switchable windows of a mapper */
+#define MAPPER_MAX_WINDOWS 4
+
+/**
+ * @brief Enum struct for defining the supported bank switching schemes
+ */
+typedef enum MapperType_t
+{
+    /** @brief Generic paging: 16K windows selected through @ref mapperSelectBank (e.g. from an I/O port) */
+    MAPPER_TYPE_GENERIC_16K = 0,
+    /** @brief ASCII 8K cartridge: 4 x 8K windows at 0x4000, registers at 0x6000/0x6800/0x7000/0x7800 */
+    MAPPER_TYPE_ASCII8,
+    /** @brief ASCII 16K cartridge: 2 x 16K windows at 0x4000, registers at 0x6000/0x7000 */
+    MAPPER_TYPE_ASCII16,
+    /** @brief Konami cartridge: 4 x 8K windows at 0x4000 (first fixed), registers at 0x6000/0x8000/0xA000 */
+    MAPPER_TYPE_KONAMI,
+    /** @brief Konami SCC cartridge: 4 x 8K windows at 0x4000, registers at 0x5000/0x7000/0x9000/0xB000 */
+    MAPPER_TYPE_KONAMI_SCC
+} MapperType_t;
+
+/**
+ * @brief Callback invoked after a bank switch changed the page table of the mapper
+ *
+ * @param context
+ * @param map Page table that was changed
+ * @param startAddress First address of the window that changed
+ * @param size Size of the window
+ */
+typedef void (*MapperRemapCallback_t)(void *context, MemoryMap_t *map, word_t startAddress, size_t size);
+
+/**
+ * @brief Bank switching controller that pages a large image into windows of a memory map.
+ * Switching a bank only rewrites page table entries, the image is never copied
+ */
+typedef struct Mapper_t
+{
+    MapperType_t type;
+
+    /** @brief Page table the mapper is plugged into */
+    MemoryMap_t *map;
+
+    /** @brief Banked image (ROM or RAM), not owned by the mapper */
+    byte_t *image;
+    /** @brief Size of the image in bytes (multiple of bankSize) */
+    size_t imageSize;
+    /** @brief True if the windows can be written to (RAM) */
+    bool isWritable;
+
+    /** @brief Size of one bank / window */
+    size_t bankSize;
+    /** @brief Number of banks in the image */
+    size_t bankCount;
+
+    /** @brief Address of the first window */
+    word_t windowStartAddress;
+    /** @brief Number of windows */
+    size_t windowCount;
+    /** @brief Bank currently selected in each window */
+    size_t banks[MAPPER_MAX_WINDOWS];
+
+    /** @brief Optional callback after a bank switch (e.g. slot selection mirroring the change) */
+    MapperRemapCallback_t remapCallback;
+    /** @brief Context of the remap callback */
+    void *remapContext;
+} Mapper_t;
+
+/**
+ * @brief Initializes a cartridge mapper and maps its windows. For @ref MAPPER_TYPE_GENERIC_16K
+ * use @ref mapperInitGeneric instead
+ *
+ * @param mapper
+ * @param type Cartridge mapper type
+ * @param map Page table the cartridge is plugged into
+ * @param image Cartridge ROM image
+ * @param imageSize Size of the image (multiple of 8K / 16K)
+ * @return bool False if the image does not fit the mapper type
+ */
+bool mapperInit(Mapper_t *mapper, MapperType_t type, MemoryMap_t *map, byte_t *image, size_t imageSize);
+
+/**
+ * @brief Initializes a generic 16K paging mapper over a range of 16K windows
+ *
+ * @param mapper
+ * @param map Page table to map into
+ * @param firstWindow Index of the first 16K window (0 = 0x0000, 3 = 0xC000)
+ * @param windowCount Number of consecutive 16K windows to page
+ * @param image ROM or RAM image (multiple of 16K)
+ * @param imageSize
+ * @param isWritable True for RAM images
+ * @return bool False if the image or the window range is invalid
+ */
+bool mapperInitGeneric(Mapper_t *mapper, MemoryMap_t *map, size_t firstWindow, size_t windowCount,
+                       byte_t *image, size_t imageSize, bool isWritable);
+
+/**
+ * @brief Selects the bank shown in a window (bank number wraps around the bank count)
+ *
+ * @param mapper
+ * @param window
+ * @param bank
+ */
+void mapperSelectBank(Mapper_t *mapper, size_t window, size_t bank);
+
+/**
+ * @brief Returns the bank currently selected in a window
+ *
+ * @param mapper
+ * @param window
+ * @return size_t
+ */
+size_t mapperGetBank(const Mapper_t *mapper, size_t window);
+
+/**
+ * @brief Restores the power-on bank selection
+ *
+ * @param mapper
+ */
+void mapperReset(Mapper_t *mapper);
+
+#endif // CILOG_C80_MAPPER_H
@@ -9,6 +9,7 @@ void memoryInit(Memory_t* memory, size_t memoryStartAddress, size_t memorySize)
 {
     memory->memoryStartAddress = memoryStartAddress;
     memory->memorySize = memorySize;
+    memory->isExternal = false;
 
     memory->data = (byte_t*) malloc(sizeof(byte_t) * memorySize);
 
@@ -21,6 +22,24 @@ void memoryInit(Memory_t* memory, size_t memoryStartAddress, size_t memorySize)
     memset(memory->data, 0x00, memory->memorySize);
 }
 
+void memoryAttach(Memory_t* memory, byte_t* data, size_t memorySize)
+{
+    if(memory == NULL || data == NULL)
+    {
+        setError(C80_ERROR_MEMORY_INIT_ERROR);
+        return;
+    }
+
+    if(memory->isExternal == false && memory->data != NULL)
+    {
+        free(memory->data);
+    }
+
+    memory->data = data;
+    memory->memorySize = memorySize;
+    memory->isExternal = true;
+}
+
 void memoryDestroy(Memory_t* memory)
 {
     if(memory == NULL || memory->data == NULL)
@@ -29,11 +48,20 @@ void memoryDestroy(Memory_t* memory)
         return;
     }
 
-    free(memory->data);
+    if(memory->isExternal == false)
+    {
+        free(memory->data);
+    }
+    memory->data = NULL;
 }
 
 void memoryReset(Memory_t *memory)
 {
+    if(memory->isExternal == true)
+    {
+        return;
+    }
+
     memset(memory->data, 0x00, memory->memorySize);
 }
 
@@ -6,12 +6,17 @@
 
 #include "utils/utils.h"
 
+#include <stdbool.h>
+
 typedef struct Memory_t
 {
     byte_t* data;
 
     size_t memoryStartAddress;
     size_t memorySize;
+
+    /** @brief True if data is owned by someone else (e.g. a memory mapped ROM file) */
+    bool isExternal;
 } Memory_t;
 
 /**
@@ -21,6 +26,16 @@ typedef struct Memory_t
  */
 void memoryInit(Memory_t* memory, size_t memoryStartAddress, size_t memorySize);
 
+/**
+ * @brief Replaces the storage of the memory object with external storage, without copying.
+ * Owned storage is freed, external storage is never freed or cleared by the memory object
+ * 
+ * @param memory 
+ * @param data 
+ * @param memorySize 
+ */
+void memoryAttach(Memory_t* memory, byte_t* data, size_t memorySize);
+
 /**
  * @brief Destroys the memory object
  * 
@@ -0,0 +1,404 @@
+#include "memory_map.h"
+
+#include <string.h>
+
+#include "utils/clock.h"
+#include "utils/error_handler.h"
+
+/**
+ * @brief Checks that a region is page aligned and fits into the address space
+ *
+ * @param startAddress
+ * @param size
+ * @return bool
+ */
+static bool isValidRegion(word_t startAddress, size_t size);
+
+/**
+ * @brief Recomputes the fast path pointers of a page from its description
+ *
+ * @param map
+ * @param pageIndex
+ */
+static void updateFastPath(MemoryMap_t *map, size_t pageIndex);
+
+/**
+ * @brief Recomputes the trap bits of every page from the active watchpoints
+ *
+ * @param map
+ */
+static void updateTrapFlags(MemoryMap_t *map);
+
+/**
+ * @brief Records a hit for every active watchpoint matching the access
+ *
+ * @param map
+ * @param address
+ * @param value
+ * @param access @ref WATCHPOINT_READ or @ref WATCHPOINT_WRITE
+ */
+static void checkWatchpoints(MemoryMap_t *map, word_t address, byte_t value, WatchpointType access);
+
+/**
+ * @brief Adds a timed slow path access to the attached host cost
+ *
+ * @param map
+ * @param path
+ * @param startTicks @ref clockNowTicks before the access
+ */
+static void recordHostCost(MemoryMap_t *map, HostPath path, qword_t startTicks);
+
+void memoryMapInit(MemoryMap_t *map)
+{
+    if(map == NULL)
+    {
+        return;
+    }
+
+    memset(map, 0x00, sizeof(MemoryMap_t));
+}
+
+void memoryMapMapRegion(MemoryMap_t *map, word_t startAddress, size_t size, byte_t *data, bool isWritable)
+{
+    if(map == NULL || data == NULL || isValidRegion(startAddress, size) == false)
+    {
+        setError(C80_ERROR_MEMORY_MAP_ERROR);
+        return;
+    }
+
+    size_t firstPage = startAddress >> MEMORY_PAGE_SHIFT;
+    size_t pageCount = size >> MEMORY_PAGE_SHIFT;
+
+    for(size_t idx = 0; idx < pageCount; idx++)
+    {
+        MemoryPage_t *page = &map->pages[firstPage + idx];
+        byte_t *pageData = data + (idx << MEMORY_PAGE_SHIFT);
+
+        *page = (MemoryPage_t){
+            .readData = pageData,
+            .writeData = isWritable ? pageData : NULL,
+            .readHandler = NULL,
+            .writeHandler = NULL,
+            .readContext = NULL,
+            .writeContext = NULL};
+
+        updateFastPath(map, firstPage + idx);
+    }
+}
+
+void memoryMapMapHandler(MemoryMap_t *map, word_t startAddress, size_t size,
+                         MemoryReadHandler_t readHandler, MemoryWriteHandler_t writeHandler, void *context)
+{
+    if(map == NULL || isValidRegion(startAddress, size) == false)
+    {
+        setError(C80_ERROR_MEMORY_MAP_ERROR);
+        return;
+    }
+
+    size_t firstPage = startAddress >> MEMORY_PAGE_SHIFT;
+    size_t pageCount = size >> MEMORY_PAGE_SHIFT;
+
+    for(size_t idx = 0; idx < pageCount; idx++)
+    {
+        map->pages[firstPage + idx] = (MemoryPage_t){
+            .readData = NULL,
+            .writeData = NULL,
+            .readHandler = readHandler,
+            .writeHandler = writeHandler,
+            .readContext = context,
+            .writeContext = context};
+
+        updateFastPath(map, firstPage + idx);
+    }
+}
+
+void memoryMapUnmap(MemoryMap_t *map, word_t startAddress, size_t size)
+{
+    if(map == NULL || isValidRegion(startAddress, size) == false)
+    {
+        setError(C80_ERROR_MEMORY_MAP_ERROR);
+        return;
+    }
+
+    size_t firstPage = startAddress >> MEMORY_PAGE_SHIFT;
+    size_t pageCount = size >> MEMORY_PAGE_SHIFT;
+
+    for(size_t idx = 0; idx < pageCount; idx++)
+    {
+        memset(&map->pages[firstPage + idx], 0x00, sizeof(MemoryPage_t));
+        updateFastPath(map, firstPage + idx);
+    }
+}
+
+void memoryMapSetReadData(MemoryMap_t *map, word_t startAddress, size_t size, byte_t *data)
+{
+    if(map == NULL || isValidRegion(startAddress, size) == false)
+    {
+        setError(C80_ERROR_MEMORY_MAP_ERROR);
+        return;
+    }
+
+    size_t firstPage = startAddress >> MEMORY_PAGE_SHIFT;
+    size_t pageCount = size >> MEMORY_PAGE_SHIFT;
+
+    for(size_t idx = 0; idx < pageCount; idx++)
+    {
+        map->pages[firstPage + idx].readData = (data != NULL) ? data + (idx << MEMORY_PAGE_SHIFT) : NULL;
+        updateFastPath(map, firstPage + idx);
+    }
+}
+
+void memoryMapSetWriteData(MemoryMap_t *map, word_t startAddress, size_t size, byte_t *data)
+{
+    if(map == NULL || isValidRegion(startAddress, size) == false)
+    {
+        setError(C80_ERROR_MEMORY_MAP_ERROR);
+        return;
+    }
+
+    size_t firstPage = startAddress >> MEMORY_PAGE_SHIFT;
+    size_t pageCount = size >> MEMORY_PAGE_SHIFT;
+
+    for(size_t idx = 0; idx < pageCount; idx++)
+    {
+        map->pages[firstPage + idx].writeData = (data != NULL) ? data + (idx << MEMORY_PAGE_SHIFT) : NULL;
+        updateFastPath(map, firstPage + idx);
+    }
+}
+
+void memoryMapSetWriteHandler(MemoryMap_t *map, word_t startAddress, size_t size,
+                              MemoryWriteHandler_t writeHandler, void *context)
+{
+    if(map == NULL || isValidRegion(startAddress, size) == false)
+    {
+        setError(C80_ERROR_MEMORY_MAP_ERROR);
+        return;
+    }
+
+    size_t firstPage = startAddress >> MEMORY_PAGE_SHIFT;
+    size_t pageCount = size >> MEMORY_PAGE_SHIFT;
+
+    for(size_t idx = 0; idx < pageCount; idx++)
+    {
+        MemoryPage_t *page = &map->pages[firstPage + idx];
+
+        page->writeData = NULL;
+        page->writeHandler = writeHandler;
+        page->writeContext = context;
+        updateFastPath(map, firstPage + idx);
+    }
+}
+
+void memoryMapCopyPages(MemoryMap_t *destination, const MemoryMap_t *source, word_t startAddress, size_t size)
+{
+    if(destination == NULL || source == NULL || isValidRegion(startAddress, size) == false)
+    {
+        setError(C80_ERROR_MEMORY_MAP_ERROR);
+        return;
+    }
+
+    size_t firstPage = startAddress >> MEMORY_PAGE_SHIFT;
+    size_t pageCount = size >> MEMORY_PAGE_SHIFT;
+
+    for(size_t idx = 0; idx < pageCount; idx++)
+    {
+        destination->pages[firstPage + idx] = source->pages[firstPage + idx];
+        updateFastPath(destination, firstPage + idx);
+    }
+}
+
+int memoryMapAddWatchpoint(MemoryMap_t *map, word_t startAddress, word_t endAddress,
+                           WatchpointType type, WatchpointAction action)
+{
+    if(map == NULL || endAddress < startAddress)
+    {
+        return -1;
+    }
+
+    for(int idx = 0; idx < MEMORY_MAX_WATCHPOINTS; idx++)
+    {
+        Watchpoint_t *watchpoint = &map->watchpoints[idx];
+        if(watchpoint->isActive == false)
+        {
+            *watchpoint = (Watchpoint_t){
+                .startAddress = startAddress,
+                .endAddress = endAddress,
+                .type = type,
+                .action = action,
+                .isActive = true};
+
+            updateTrapFlags(map);
+            return idx;
+        }
+    }
+
+    return -1;
+}
+
+void memoryMapRemoveWatchpoint(MemoryMap_t *map, int index)
+{
+    if(map == NULL || index < 0 || index >= MEMORY_MAX_WATCHPOINTS)
+    {
+        return;
+    }
+
+    map->watchpoints[index].isActive = false;
+    updateTrapFlags(map);
+}
+
+void memoryMapClearWatchpoints(MemoryMap_t *map)
+{
+    if(map == NULL)
+    {
+        return;
+    }
+
+    memset(map->watchpoints, 0x00, sizeof(map->watchpoints));
+    updateTrapFlags(map);
+}
+
+void memoryMapClearHits(MemoryMap_t *map)
+{
+    map->pendingHitCount = 0;
+}
+
+byte_t memoryMapPeekByte(const MemoryMap_t *map, word_t address)
+{
+    const MemoryPage_t *page = &map->pages[address >> MEMORY_PAGE_SHIFT];
+
+    return (page->readData != NULL) ? page->readData[address & MEMORY_PAGE_MASK] : MEMORY_OPEN_BUS;
+}
+
+byte_t memoryMapReadByteSlow(MemoryMap_t *map, word_t address)
+{
+    const MemoryPage_t *page = &map->pages[address >> MEMORY_PAGE_SHIFT];
+    byte_t value = MEMORY_OPEN_BUS;
+    qword_t startTicks = (map->hostCost != NULL) ? clockNowTicks() : 0;
+    HostPath path = HOST_PATH_SLOW_MEMORY;
+
+    if(page->readData != NULL)
+    {
+        value = page->readData[address & MEMORY_PAGE_MASK];
+    }
+    else if(page->readHandler != NULL)
+    {
+        value = page->readHandler(page->readContext, address);
+        path = HOST_PATH_MEMORY_HANDLER;
+    }
+
+    if((map->trapFlags[address >> MEMORY_PAGE_SHIFT] & MEMORY_TRAP_READ) != 0)
+    {
+        checkWatchpoints(map, address, value, WATCHPOINT_READ);
+    }
+
+    if(map->hostCost != NULL)
+    {
+        recordHostCost(map, path, startTicks);
+    }
+
+    return value;
+}
+
+void memoryMapWriteByteSlow(MemoryMap_t *map, word_t address, byte_t value)
+{
+    const MemoryPage_t *page = &map->pages[address >> MEMORY_PAGE_SHIFT];
+    qword_t startTicks = (map->hostCost != NULL) ? clockNowTicks() : 0;
+    HostPath path = HOST_PATH_SLOW_MEMORY;
+
+    if((map->trapFlags[address >> MEMORY_PAGE_SHIFT] & MEMORY_TRAP_WRITE) != 0)
+    {
+        checkWatchpoints(map, address, value, WATCHPOINT_WRITE);
+    }
+
+    if(page->writeData != NULL)
+    {
+        page->writeData[address & MEMORY_PAGE_MASK] = value;
+    }
+    else if(page->writeHandler != NULL)
+    {
+        page->writeHandler(page->writeContext, address, value);
+        path = HOST_PATH_MEMORY_HANDLER;
+    }
+
+    if(map->hostCost != NULL)
+    {
+        recordHostCost(map, path, startTicks);
+    }
+}
+
+static bool isValidRegion(word_t startAddress, size_t size)
+{
+    return (startAddress & MEMORY_PAGE_MASK) == 0
+        && (size & MEMORY_PAGE_MASK) == 0
+        && size > 0
+        && ((size_t)startAddress + size) <= 0x10000;
+}
+
+static void updateFastPath(MemoryMap_t *map, size_t pageIndex)
+{
+    const MemoryPage_t *page = &map->pages[pageIndex];
+
+    byte_t trapFlags = map->trapFlags[pageIndex];
+
+    map->readPages[pageIndex] = (trapFlags & MEMORY_TRAP_READ) ? NULL : page->readData;
+    map->writePages[pageIndex] = (trapFlags & MEMORY_TRAP_WRITE) ? NULL : page->writeData;
+}
+
+static void updateTrapFlags(MemoryMap_t *map)
+{
+    memset(map->trapFlags, 0x00, sizeof(map->trapFlags));
+
+    for(size_t idx = 0; idx < MEMORY_MAX_WATCHPOINTS; idx++)
+    {
+        const Watchpoint_t *watchpoint = &map->watchpoints[idx];
+        if(watchpoint->isActive == false)
+        {
+            continue;
+        }
+
+        size_t firstPage = watchpoint->startAddress >> MEMORY_PAGE_SHIFT;
+        size_t lastPage = watchpoint->endAddress >> MEMORY_PAGE_SHIFT;
+        for(size_t pageIndex = firstPage; pageIndex <= lastPage; pageIndex++)
+        {
+            map->trapFlags[pageIndex] |= (byte_t)watchpoint->type;
+        }
+    }
+
+    for(size_t pageIndex = 0; pageIndex < MEMORY_PAGE_COUNT; pageIndex++)
+    {
+        updateFastPath(map, pageIndex);
+    }
+}
+
+static void checkWatchpoints(MemoryMap_t *map, word_t address, byte_t value, WatchpointType access)
+{
+    for(int idx = 0; idx < MEMORY_MAX_WATCHPOINTS; idx++)
+    {
+        const Watchpoint_t *watchpoint = &map->watchpoints[idx];
+
+        if(watchpoint->isActive == false
+            || (watchpoint->type & access) == 0
+            || address < watchpoint->startAddress
+            || address > watchpoint->endAddress)
+        {
+            continue;
+        }
+
+        if(map->pendingHitCount < MEMORY_MAX_PENDING_HITS)
+        {
+            map->pendingHits[map->pendingHitCount] = (WatchpointHit_t){
+                .watchpoint = idx,
+                .access = access,
+                .action = watchpoint->action,
+                .address = address,
+                .value = value};
+            map->pendingHitCount++;
+        }
+    }
+}
+
+static void recordHostCost(MemoryMap_t *map, HostPath path, qword_t startTicks)
+{
+    map->hostCost->accesses[path]++;
+    map->hostCost->ticks[path] += clockNowTicks() - startTicks;
+}
@@ -0,0 +1,364 @@
+#ifndef CILOG_C80_MEMORY_MAP_H
+#define CILOG_C80_MEMORY_MAP_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "utils/utils.h"
+#include "utils/host_cost.h"
+
+/** @brief Number of address bits covered by one page */
+#define MEMORY_PAGE_SHIFT 10
+/** @brief Size of one page of the address space (1K) */
+#define MEMORY_PAGE_SIZE (1 << MEMORY_PAGE_SHIFT)
+/** @brief Mask for the offset of an address inside its page */
+#define MEMORY_PAGE_MASK (MEMORY_PAGE_SIZE - 1)
+/** @brief Number of pages in the 64K address space */
+#define MEMORY_PAGE_COUNT (0x10000 >> MEMORY_PAGE_SHIFT)
+
+/** @brief Value returned when reading from an unmapped page (open bus) */
+#define MEMORY_OPEN_BUS 0xFF
+
+/** @brief Maximum number of watchpoints of a memory map */
+#define MEMORY_MAX_WATCHPOINTS 32
+/** @brief Maximum number of watchpoint hits recorded during one instruction */
+#define MEMORY_MAX_PENDING_HITS 8
+
+/** @brief Trap bit: reads of the page take the slow path and check watchpoints */
+#define MEMORY_TRAP_READ 0x01
+/** @brief Trap bit: writes to the page take the slow path and check watchpoints */
+#define MEMORY_TRAP_WRITE 0x02
+
+/**
+ * @brief Enum struct for defining the accesses a watchpoint reacts to
+ */
+typedef enum WatchpointType
+{
+    WATCHPOINT_READ = MEMORY_TRAP_READ,
+    WATCHPOINT_WRITE = MEMORY_TRAP_WRITE,
+    WATCHPOINT_ACCESS = MEMORY_TRAP_READ | MEMORY_TRAP_WRITE
+} WatchpointType;
+
+/**
+ * @brief Enum struct for defining what happens when a watchpoint is hit
+ */
+typedef enum WatchpointAction
+{
+    /** @brief Stop the run loop after the instruction */
+    WATCHPOINT_ACTION_BREAK = 0,
+    /** @brief Log the hit and continue */
+    WATCHPOINT_ACTION_LOG
+} WatchpointAction;
+
+/**
+ * @brief Watched address range
+ */
+typedef struct Watchpoint_t
+{
+    word_t startAddress;
+    /** @brief Last watched address (inclusive) */
+    word_t endAddress;
+    WatchpointType type;
+    WatchpointAction action;
+    bool isActive;
+} Watchpoint_t;
+
+/**
+ * @brief Description of a single watchpoint hit
+ */
+typedef struct WatchpointHit_t
+{
+    /** @brief Index of the watchpoint that was hit */
+    int watchpoint;
+    /** @brief Kind of access that triggered the hit (@ref WATCHPOINT_READ or @ref WATCHPOINT_WRITE) */
+    WatchpointType access;
+    WatchpointAction action;
+    word_t address;
+    byte_t value;
+} WatchpointHit_t;
+
+/**
+ * @brief Device read callback of a memory mapped I/O page
+ *
+ * @param context Read context of the page (see @ref MemoryPage_t)
+ * @param address Full 16 bit address of the access
+ * @return byte_t Value seen by the CPU
+ */
+typedef byte_t (*MemoryReadHandler_t)(void *context, word_t address);
+
+/**
+ * @brief Device write callback of a memory mapped I/O page
+ *
+ * @param context Write context of the page (see @ref MemoryPage_t)
+ * @param address Full 16 bit address of the access
+ * @param value Value written by the CPU
+ */
+typedef void (*MemoryWriteHandler_t)(void *context, word_t address, byte_t value);
+
+/**
+ * @brief Description of a single page of the address space
+ */
+typedef struct MemoryPage_t
+{
+    /** @brief Backing storage for reads, NULL if reads go to the handler */
+    byte_t *readData;
+    /** @brief Backing storage for writes, NULL if writes go to the handler or are dropped */
+    byte_t *writeData;
+
+    /** @brief Device read callback, used if readData is NULL */
+    MemoryReadHandler_t readHandler;
+    /** @brief Device write callback, used if writeData is NULL */
+    MemoryWriteHandler_t writeHandler;
+    /** @brief Context handed to the read callback */
+    void *readContext;
+    /** @brief Context handed to the write callback, may belong to another device than the read side */
+    void *writeContext;
+} MemoryPage_t;
+
+/**
+ * @brief Page table of the 64K address space
+ *
+ * The readPages / writePages arrays are what the CPU looks at on every access. They hold a
+ * pointer to the start of the page for plain RAM / ROM pages and NULL for every page that
+ * has to take the slow path (memory mapped I/O, unmapped or read-only, watched).
+ */
+typedef struct MemoryMap_t
+{
+    /** @brief Fast path pointers for reads (NULL = slow path) */
+    byte_t *readPages[MEMORY_PAGE_COUNT];
+    /** @brief Fast path pointers for writes (NULL = slow path) */
+    byte_t *writePages[MEMORY_PAGE_COUNT];
+
+    /** @brief Full page descriptions used by the slow path */
+    MemoryPage_t pages[MEMORY_PAGE_COUNT];
+
+    /** @brief Trap bits of every page, a set bit diverts that access type to the slow path */
+    byte_t trapFlags[MEMORY_PAGE_COUNT];
+    /** @brief Watchpoints, the trap bits are derived from them */
+    Watchpoint_t watchpoints[MEMORY_MAX_WATCHPOINTS];
+
+    /** @brief Hits recorded since the last call of @ref memoryMapClearHits */
+    WatchpointHit_t pendingHits[MEMORY_MAX_PENDING_HITS];
+    size_t pendingHitCount;
+
+    /** @brief Slow path timings of the host cost profiler, NULL (the default) disables them */
+    HostPathCost_t *hostCost;
+} MemoryMap_t;
+
+/**
+ * @brief Initializes the memory map with every page unmapped
+ *
+ * @param map
+ */
+void memoryMapInit(MemoryMap_t *map);
+
+/**
+ * @brief Maps plain memory into the address space. Start address and size have to be page aligned
+ *
+ * @param map
+ * @param startAddress First address of the region
+ * @param size Size of the region in bytes
+ * @param data Backing storage of at least size bytes
+ * @param isWritable False for ROM, writes to the region are dropped
+ */
+void memoryMapMapRegion(MemoryMap_t *map, word_t startAddress, size_t size, byte_t *data, bool isWritable);
+
+/**
+ * @brief Maps a device into the address space. Start address and size have to be page aligned.
+ * Either handler may be NULL (reads return @ref MEMORY_OPEN_BUS, writes are dropped)
+ *
+ * @param map
+ * @param startAddress First address of the region
+ * @param size Size of the region in bytes
+ * @param readHandler
+ * @param writeHandler
+ * @param context Passed to both handlers
+ */
+void memoryMapMapHandler(MemoryMap_t *map, word_t startAddress, size_t size,
+                         MemoryReadHandler_t readHandler, MemoryWriteHandler_t writeHandler, void *context);
+
+/**
+ * @brief Removes every mapping of a region. Start address and size have to be page aligned
+ *
+ * @param map
+ * @param startAddress
+ * @param size
+ */
+void memoryMapUnmap(MemoryMap_t *map, word_t startAddress, size_t size);
+
+/**
+ * @brief Replaces the read side of a region without touching its write side or handlers.
+ * Only page table entries are rewritten, nothing is copied (used for bank switching)
+ *
+ * @param map
+ * @param startAddress
+ * @param size
+ * @param data New backing storage for reads, NULL to send reads to the read handler
+ */
+void memoryMapSetReadData(MemoryMap_t *map, word_t startAddress, size_t size, byte_t *data);
+
+/**
+ * @brief Replaces the write side of a region without touching its read side or handlers
+ *
+ * @param map
+ * @param startAddress
+ * @param size
+ * @param data New backing storage for writes, NULL to send writes to the write handler
+ */
+void memoryMapSetWriteData(MemoryMap_t *map, word_t startAddress, size_t size, byte_t *data);
+
+/**
+ * @brief Installs a write handler on a region while keeping its read side (e.g. bank registers
+ * that sit on top of cartridge ROM). The read handler keeps its own context, so the two sides
+ * may belong to different devices
+ *
+ * @param map
+ * @param startAddress
+ * @param size
+ * @param writeHandler
+ * @param context Passed to the write handler only
+ */
+void memoryMapSetWriteHandler(MemoryMap_t *map, word_t startAddress, size_t size,
+                              MemoryWriteHandler_t writeHandler, void *context);
+
+/**
+ * @brief Copies the page descriptions of a region from one map into another
+ *
+ * @param destination
+ * @param source
+ * @param startAddress
+ * @param size
+ */
+void memoryMapCopyPages(MemoryMap_t *destination, const MemoryMap_t *source, word_t startAddress, size_t size);
+
+/**
+ * @brief Adds a watchpoint on an address range. Only the pages holding the range lose their
+ * fast path for the watched access type
+ *
+ * @param map
+ * @param startAddress First watched address
+ * @param endAddress Last watched address (inclusive)
+ * @param type
+ * @param action
+ * @return int Index of the watchpoint, -1 if all watchpoints are in use
+ */
+int memoryMapAddWatchpoint(MemoryMap_t *map, word_t startAddress, word_t endAddress,
+                           WatchpointType type, WatchpointAction action);
+
+/**
+ * @brief Removes a watchpoint and restores the fast path of pages that are no longer watched
+ *
+ * @param map
+ * @param index Index returned by @ref memoryMapAddWatchpoint
+ */
+void memoryMapRemoveWatchpoint(MemoryMap_t *map, int index);
+
+/**
+ * @brief Removes every watchpoint
+ *
+ * @param map
+ */
+void memoryMapClearWatchpoints(MemoryMap_t *map);
+
+/**
+ * @brief Forgets the recorded watchpoint hits
+ *
+ * @param map
+ */
+void memoryMapClearHits(MemoryMap_t *map);
+
+/**
+ * @brief Reads a byte without side effects: no device handlers, no watchpoints. Meant for
+ * debuggers and profilers looking at code
+ *
+ * @param map
+ * @param address
+ * @return byte_t @ref MEMORY_OPEN_BUS for pages without backing storage
+ */
+byte_t memoryMapPeekByte(const MemoryMap_t *map, word_t address);
+
+/**
+ * @brief Slow path of @ref memoryMapReadByte (handlers, unmapped pages, watchpoints)
+ *
+ * @param map
+ * @param address
+ * @return byte_t
+ */
+byte_t memoryMapReadByteSlow(MemoryMap_t *map, word_t address);
+
+/**
+ * @brief Slow path of @ref memoryMapWriteByte (handlers, ROM, unmapped pages, watchpoints)
+ *
+ * @param map
+ * @param address
+ * @param value
+ */
+void memoryMapWriteByteSlow(MemoryMap_t *map, word_t address, byte_t value);
+
+/**
+ * @brief Reads a byte from the address space
+ *
+ * @param map
+ * @param address
+ * @return byte_t
+ */
+static inline byte_t memoryMapReadByte(MemoryMap_t *map, word_t address)
+{
+    byte_t *page = map->readPages[address >> MEMORY_PAGE_SHIFT];
+    if(page != NULL)
+    {
+        return page[address & MEMORY_PAGE_MASK];
+    }
+
+    return memoryMapReadByteSlow(map, address);
+}
+
+/**
+ * @brief Writes a byte to the address space
+ *
+ * @param map
+ * @param address
+ * @param value
+ */
+static inline void memoryMapWriteByte(MemoryMap_t *map, word_t address, byte_t value)
+{
+    byte_t *page = map->writePages[address >> MEMORY_PAGE_SHIFT];
+    if(page != NULL)
+    {
+        page[address & MEMORY_PAGE_MASK] = value;
+        return;
+    }
+
+    memoryMapWriteByteSlow(map, address, value);
+}
+
+/**
+ * @brief Reads a little endian word from the address space (wraps around at 0xFFFF)
+ *
+ * @param map
+ * @param address
+ * @return word_t
+ */
+static inline word_t memoryMapReadWord(MemoryMap_t *map, word_t address)
+{
+    byte_t lowerByte = memoryMapReadByte(map, address);
+    byte_t upperByte = memoryMapReadByte(map, (word_t)(address + 1));
+
+    return TO_WORD(upperByte, lowerByte);
+}
+
+/**
+ * @brief Writes a little endian word to the address space (wraps around at 0xFFFF)
+ *
+ * @param map
+ * @param address
+ * @param value
+ */
+static inline void memoryMapWriteWord(MemoryMap_t *map, word_t address, word_t value)
+{
+    memoryMapWriteByte(map, address, LOWER_BYTE(value));
+    memoryMapWriteByte(map, (word_t)(address + 1), UPPER_BYTE(value));
+}
+
+#endif // CILOG_C80_MEMORY_MAP_H
@@ -0,0 +1,201 @@
+#include "msx_slots.h"
+
+#include <string.h>
+
+#include "utils/error_handler.h"
+
+/**
+ * @brief Returns the page table currently selected for a 16K page
+ *
+ * @param slots
+ * @param page
+ * @return MemoryMap_t*
+ */
+static MemoryMap_t *selectedSlotMap(MsxSlots_t *slots, size_t page);
+
+/**
+ * @brief Copies the page table entries of the selected slot of a 16K page into the CPU map
+ *
+ * @param slots
+ * @param page
+ */
+static void refreshPage(MsxSlots_t *slots, size_t page);
+
+/**
+ * @brief Mapper callback mirroring bank switches of visible slots into the CPU map
+ */
+static void onMapperRemap(void *context, MemoryMap_t *map, word_t startAddress, size_t size);
+
+/**
+ * @brief Read handler of the last CPU page while an expanded slot is visible in page 3
+ */
+static byte_t subslotRegisterRead(void *context, word_t address);
+
+/**
+ * @brief Write handler of the last CPU page while an expanded slot is visible in page 3
+ */
+static void subslotRegisterWrite(void *context, word_t address, byte_t value);
+
+void msxSlotsInit(MsxSlots_t *slots, MemoryMap_t *map)
+{
+    if(slots == NULL || map == NULL)
+    {
+        setError(C80_ERROR_MEMORY_MAP_ERROR);
+        return;
+    }
+
+    memset(slots, 0x00, sizeof(MsxSlots_t));
+    slots->map = map;
+
+    for(size_t slot = 0; slot < MSX_SLOT_COUNT; slot++)
+    {
+        for(size_t subslot = 0; subslot < MSX_SUBSLOT_COUNT; subslot++)
+        {
+            memoryMapInit(&slots->slots[slot][subslot]);
+        }
+    }
+
+    msxSlotsRefresh(slots);
+}
+
+void msxSlotsSetExpanded(MsxSlots_t *slots, size_t slot, bool isExpanded)
+{
+    if(slots == NULL || slot >= MSX_SLOT_COUNT)
+    {
+        return;
+    }
+
+    slots->isExpanded[slot] = isExpanded;
+    slots->secondarySelect[slot] = 0x00;
+    msxSlotsRefresh(slots);
+}
+
+MemoryMap_t *msxSlotsGetSlotMap(MsxSlots_t *slots, size_t slot, size_t subslot)
+{
+    if(slots == NULL || slot >= MSX_SLOT_COUNT || subslot >= MSX_SUBSLOT_COUNT)
+    {
+        return NULL;
+    }
+
+    return &slots->slots[slot][subslot];
+}
+
+void msxSlotsAttachMapper(MsxSlots_t *slots, Mapper_t *mapper)
+{
+    if(slots == NULL || mapper == NULL)
+    {
+        return;
+    }
+
+    mapper->remapCallback = onMapperRemap;
+    mapper->remapContext = slots;
+    msxSlotsRefresh(slots);
+}
+
+void msxSlotsWritePrimary(MsxSlots_t *slots, byte_t value)
+{
+    byte_t changed = slots->primarySelect ^ value;
+    slots->primarySelect = value;
+
+    for(size_t page = 0; page < MSX_SLOT_PAGE_COUNT; page++)
+    {
+        if(((changed >> (page * 2)) & 0x03) != 0)
+        {
+            refreshPage(slots, page);
+        }
+    }
+}
+
+byte_t msxSlotsReadPrimary(const MsxSlots_t *slots)
+{
+    return slots->primarySelect;
+}
+
+void msxSlotsRefresh(MsxSlots_t *slots)
+{
+    for(size_t page = 0; page < MSX_SLOT_PAGE_COUNT; page++)
+    {
+        refreshPage(slots, page);
+    }
+}
+
+static MemoryMap_t *selectedSlotMap(MsxSlots_t *slots, size_t page)
+{
+    size_t slot = (slots->primarySelect >> (page * 2)) & 0x03;
+    size_t subslot = 0;
+
+    if(slots->isExpanded[slot] == true)
+    {
+        subslot = (slots->secondarySelect[slot] >> (page * 2)) & 0x03;
+    }
+
+    return &slots->slots[slot][subslot];
+}
+
+static void refreshPage(MsxSlots_t *slots, size_t page)
+{
+    word_t pageAddress = (word_t)(page * MSX_SLOT_PAGE_SIZE);
+    memoryMapCopyPages(slots->map, selectedSlotMap(slots, page), pageAddress, MSX_SLOT_PAGE_SIZE);
+
+    // The secondary slot register overlays the last page of an expanded slot
+    size_t topSlot = (slots->primarySelect >> 6) & 0x03;
+    if(page == (MSX_SLOT_PAGE_COUNT - 1) && slots->isExpanded[topSlot] == true)
+    {
+        memoryMapMapHandler(slots->map, MSX_SUBSLOT_REGISTER & ~MEMORY_PAGE_MASK, MEMORY_PAGE_SIZE,
+                            subslotRegisterRead, subslotRegisterWrite, slots);
+    }
+}
+
+static void onMapperRemap(void *context, MemoryMap_t *map, word_t startAddress, size_t size)
+{
+    MsxSlots_t *slots = (MsxSlots_t *)context;
+
+    size_t firstPage = startAddress / MSX_SLOT_PAGE_SIZE;
+    size_t lastPage = (startAddress + size - 1) / MSX_SLOT_PAGE_SIZE;
+
+    for(size_t page = firstPage; page <= lastPage && page < MSX_SLOT_PAGE_COUNT; page++)
+    {
+        if(selectedSlotMap(slots, page) == map)
+        {
+            refreshPage(slots, page);
+        }
+    }
+}
+
+static byte_t subslotRegisterRead(void *context, word_t address)
+{
+    MsxSlots_t *slots = (MsxSlots_t *)context;
+    size_t topSlot = (slots->primarySelect >> 6) & 0x03;
+
+    if(address == MSX_SUBSLOT_REGISTER)
+    {
+        // The register reads back inverted
+        return (byte_t)~slots->secondarySelect[topSlot];
+    }
+
+    return memoryMapReadByte(selectedSlotMap(slots, MSX_SLOT_PAGE_COUNT - 1), address);
+}
+
+static void subslotRegisterWrite(void *context, word_t address, byte_t value)
+{
+    MsxSlots_t *slots = (MsxSlots_t *)context;
+    size_t topSlot = (slots->primarySelect >> 6) & 0x03;
+
+    if(address == MSX_SUBSLOT_REGISTER)
+    {
+        byte_t changed = slots->secondarySelect[topSlot] ^ value;
+        slots->secondarySelect[topSlot] = value;
+
+        for(size_t page = 0; page < MSX_SLOT_PAGE_COUNT; page++)
+        {
+            size_t slot = (slots->primarySelect >> (page * 2)) & 0x03;
+            if(slot == topSlot && ((changed >> (page * 2)) & 0x03) != 0)
+            {
+                refreshPage(slots, page);
+            }
+        }
+        return;
+    }
+
+    memoryMapWriteByte(selectedSlotMap(slots, MSX_SLOT_PAGE_COUNT - 1), address, value);
+}
@@ -0,0 +1,104 @@
+#ifndef CILOG_C80_MSX_SLOTS_H
+#define CILOG_C80_MSX_SLOTS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "utils/utils.h"
+#include "memory/memory_map.h"
+#include "memory/mapper.h"
+
+#define MSX_SLOT_COUNT 4
+#define MSX_SUBSLOT_COUNT 4
+/** @brief Size of the 16K pages selected by the slot registers */
+#define MSX_SLOT_PAGE_SIZE 0x4000
+/** @brief Number of 16K pages in the address space */
+#define MSX_SLOT_PAGE_COUNT 4
+/** @brief Address of the secondary slot select register in expanded slots */
+#define MSX_SUBSLOT_REGISTER 0xFFFF
+
+/**
+ * @brief MSX style primary / secondary slot selection.
+ *
+ * Every slot / subslot owns its own page table that devices and mappers are mapped into.
+ * Selecting a slot copies the page table entries of the selected slot for the affected 16K
+ * page into the CPU memory map, memory is never copied.
+ */
+typedef struct MsxSlots_t
+{
+    /** @brief Memory map seen by the CPU */
+    MemoryMap_t *map;
+
+    /** @brief Page tables of every slot / subslot */
+    MemoryMap_t slots[MSX_SLOT_COUNT][MSX_SUBSLOT_COUNT];
+    /** @brief True if the primary slot is expanded into subslots */
+    bool isExpanded[MSX_SLOT_COUNT];
+
+    /** @brief Primary slot select register (I/O port 0xA8) */
+    byte_t primarySelect;
+    /** @brief Secondary slot select register of every primary slot */
+    byte_t secondarySelect[MSX_SLOT_COUNT];
+} MsxSlots_t;
+
+/**
+ * @brief Initializes the slot system with empty slots, slot 0 selected everywhere
+ *
+ * @param slots
+ * @param map Memory map seen by the CPU
+ */
+void msxSlotsInit(MsxSlots_t *slots, MemoryMap_t *map);
+
+/**
+ * @brief Marks a primary slot as expanded into four subslots
+ *
+ * @param slots
+ * @param slot
+ * @param isExpanded
+ */
+void msxSlotsSetExpanded(MsxSlots_t *slots, size_t slot, bool isExpanded);
+
+/**
+ * @brief Returns the page table of a slot / subslot to map memory, devices or mappers into.
+ * Call @ref msxSlotsRefresh afterwards if the slot is currently visible
+ *
+ * @param slots
+ * @param slot
+ * @param subslot Ignored (0) for non expanded slots
+ * @return MemoryMap_t*
+ */
+MemoryMap_t *msxSlotsGetSlotMap(MsxSlots_t *slots, size_t slot, size_t subslot);
+
+/**
+ * @brief Plugs a mapper living in one of the slot page tables into the slot system so that
+ * its bank switches are mirrored into the CPU memory map if its slot is visible
+ *
+ * @param slots
+ * @param mapper
+ */
+void msxSlotsAttachMapper(MsxSlots_t *slots, Mapper_t *mapper);
+
+/**
+ * @brief Writes the primary slot select register (I/O port 0xA8)
+ *
+ * @param slots
+ * @param value Two bits per 16K page, page 0 in bits 0-1
+ */
+void msxSlotsWritePrimary(MsxSlots_t *slots, byte_t value);
+
+/**
+ * @brief Reads the primary slot select register (I/O port 0xA8)
+ *
+ * @param slots
+ * @return byte_t
+ */
+byte_t msxSlotsReadPrimary(const MsxSlots_t *slots);
+
+/**
+ * @brief Rebuilds the CPU memory map from the current slot selection
+ *
+ * @param slots
+ */
+void msxSlotsRefresh(MsxSlots_t *slots);
+
+#endif // CILOG_C80_MSX_SLOTS_H
@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch/batch_runner.h"
+#include "cpu/opcode_profile.h"
+#include "emulator/symbol_table.h"
+
+/**
+ * @brief Prints the command line help
+ *
+ * @param program
+ */
+static void printUsage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [options] <manifest>\n"
+            "Runs every job of the manifest (\"rom [input|-] [max-cycles]\" per line) and writes\n"
+            "one JSON result per job.\n"
+            "\n"
+            "  -j <workers>   Worker threads (default: one per logical processor)\n"
+            "  -s <cycles>    Cycles per time slice (default: %d)\n"
+            "  -o <file>      Output file (default: stdout)\n"
+            "  -C <file>      Merge the executed addresses and branch edges of all jobs, write\n"
+            "                 them to file as an lcov tracefile if it ends in .info, as JSON\n"
+            "                 otherwise\n"
+            "  -S <file>      Symbols (.sym, .map or .lst listing) for the coverage report\n"
+            "  -d <dir>       Save the state of every job to dir every -k cycles; a job whose\n"
+            "                 state file is found there resumes from it\n"
+            "  -k <cycles>    Cycles between two checkpoints of a job (default: %ld)\n",
+            program, BATCH_DEFAULT_SLICE_CYCLES, BATCH_DEFAULT_CHECKPOINT_CYCLES);
+}
+
+int main(int argc, char *argv[])
+{
+    BatchRunner_t runner;
+    const char *manifestPath = NULL;
+    const char *outputPath = NULL;
+    const char *coveragePath = NULL;
+    const char *symbolPath = NULL;
+
+    batchRunnerInit(&runner);
+
+    for(int idx = 1; idx < argc; idx++)
+    {
+        if(strcmp(argv[idx], "-j") == 0 && idx + 1 < argc)
+        {
+            runner.workerCount = atoi(argv[++idx]);
+        }
+        else if(strcmp(argv[idx], "-s") == 0 && idx + 1 < argc)
+        {
+            runner.sliceCycles = strtol(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-o") == 0 && idx + 1 < argc)
+        {
+            outputPath = argv[++idx];
+        }
+        else if(strcmp(argv[idx], "-C") == 0 && idx + 1 < argc)
+        {
+            coveragePath = argv[++idx];
+        }
+        else if(strcmp(argv[idx], "-S") == 0 && idx + 1 < argc)
+        {
+            symbolPath = argv[++idx];
+        }
+        else if(strcmp(argv[idx], "-d") == 0 && idx + 1 < argc)
+        {
+            runner.stateDirectory = argv[++idx];
+        }
+        else if(strcmp(argv[idx], "-k") == 0 && idx + 1 < argc)
+        {
+            runner.checkpointCycles = strtol(argv[++idx], NULL, 0);
+        }
+        else if(argv[idx][0] != '-' && manifestPath == NULL)
+        {
+            manifestPath = argv[idx];
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(manifestPath == NULL || runner.sliceCycles <= 0 || runner.checkpointCycles <= 0)
+    {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+#if CILOGC80_OPCODE_PROFILE == 0
+    if(coveragePath != NULL)
+    {
+        fprintf(stderr, "-C needs the coverage hooks, this build was configured with "
+                        "-DCILOGC80_OPCODE_PROFILE=OFF\n");
+        return EXIT_FAILURE;
+    }
+#endif
+
+    if(batchRunnerLoadManifest(&runner, manifestPath) == false)
+    {
+        fprintf(stderr, "Could not read manifest %s\n", manifestPath);
+        batchRunnerDestroy(&runner);
+        return EXIT_FAILURE;
+    }
+
+    SymbolTable_t symbols;
+    symbolTableInit(&symbols);
+
+    if(symbolPath != NULL && symbolTableLoadFile(&symbols, symbolPath) == false)
+    {
+        fprintf(stderr, "Could not load %s\n", symbolPath);
+        symbolTableDestroy(&symbols);
+        batchRunnerDestroy(&runner);
+        return EXIT_FAILURE;
+    }
+
+    if(coveragePath != NULL)
+    {
+        runner.coverage = coverageCreate();
+    }
+
+    if(batchRunnerRun(&runner) == false)
+    {
+        fprintf(stderr, "Could not start the worker threads\n");
+        coverageDestroy(runner.coverage);
+        symbolTableDestroy(&symbols);
+        batchRunnerDestroy(&runner);
+        return EXIT_FAILURE;
+    }
+
+    FILE *output = (outputPath != NULL) ? fopen(outputPath, "w") : stdout;
+    if(output == NULL)
+    {
+        fprintf(stderr, "Could not open %s\n", outputPath);
+        coverageDestroy(runner.coverage);
+        symbolTableDestroy(&symbols);
+        batchRunnerDestroy(&runner);
+        return EXIT_FAILURE;
+    }
+
+    batchRunnerWriteResults(&runner, output);
+
+    if(output != stdout)
+    {
+        fclose(output);
+    }
+
+    int exitCode = EXIT_SUCCESS;
+    if(runner.coverage != NULL)
+    {
+        if(coverageSaveFile(runner.coverage, coveragePath, manifestPath,
+                            (symbols.count > 0) ? &symbols : NULL) == false)
+        {
+            fprintf(stderr, "Could not write %s\n", coveragePath);
+            exitCode = EXIT_FAILURE;
+        }
+        coverageDestroy(runner.coverage);
+    }
+    symbolTableDestroy(&symbols);
+    batchRunnerDestroy(&runner);
+
+    return exitCode;
+}
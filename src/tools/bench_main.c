@@ -0,0 +1,330 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench/benchmark.h"
+#include "bench/bench_compare.h"
+#include "bench/bench_workloads.h"
+#include "bench/opcode_bench.h"
+
+/** @brief Built-in workloads plus ROM files given on the command line */
+#define BENCH_MAX_WORKLOADS 64
+
+/** @brief Exit code if a workload is significantly slower than the baseline */
+#define BENCH_EXIT_REGRESSION 2
+
+/**
+ * @brief Prints the command line help
+ *
+ * @param program
+ */
+static void printUsage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [options] [rom ...]\n"
+            "       %s -O [-g <group>] [-i <iterations>] [-t <rows>]\n"
+            "Runs the built-in workloads and the given ROM files for a fixed number of emulated\n"
+            "cycles and reports the emulated speed in MHz.\n"
+            "\n"
+            "  -c <cycles>   Emulated cycles per run (default: %ld)\n"
+            "  -r <repeats>  Measured runs per workload (default: %d, max: %d)\n"
+            "  -w <name>     Only run workloads whose name contains <name>\n"
+            "  -o <file>     Write the results as JSON\n"
+            "  -n            No warmup run\n"
+            "  -B <backend>  Execution backend (see -L, default: %s)\n"
+            "  -L            List the execution backends\n"
+            "  -l            List the built-in workloads\n"
+            "  -b <file>     Compare with a baseline written by -o, exits with %d on regressions\n"
+            "  -T <percent>  Slowdown that counts as a regression (default: %.0f)\n"
+            "\n"
+            "Opcode microbenchmarks (-O) time every opcode on its own and print host ns per\n"
+            "opcode, slowest first:\n"
+            "  -g <group>    main, cb, ed, dd, fd, ddcb or fdcb (default: all). Only the main\n"
+            "                group is decoded by the core so far, the others are skipped\n"
+            "  -i <count>    Executions per opcode (default: %ld)\n"
+            "  -t <rows>     Only print the slowest <rows> opcodes\n",
+            program, program, BENCHMARK_DEFAULT_CYCLES, BENCHMARK_DEFAULT_REPEATS, BENCHMARK_MAX_REPEATS,
+            machineBackendGet(0)->name, BENCH_EXIT_REGRESSION, BENCH_COMPARE_DEFAULT_THRESHOLD * 100.0, OPCODE_BENCH_DEFAULT_ITERATIONS);
+}
+
+/**
+ * @brief Returns the file name without directories
+ *
+ * @param path
+ * @return const char*
+ */
+static const char *baseName(const char *path)
+{
+    const char *slash = strrchr(path, '/');
+    const char *backslash = strrchr(path, '\\');
+
+    if(backslash != NULL && (slash == NULL || backslash > slash))
+    {
+        slash = backslash;
+    }
+
+    return (slash != NULL) ? slash + 1 : path;
+}
+
+/**
+ * @brief Runs the opcode microbenchmarks of one or all groups and prints them sorted
+ *
+ * @param config
+ * @param group
+ * @param isAllGroups
+ * @param limit Rows to print, 0 prints all
+ * @return int Exit code
+ */
+static int runOpcodeBenchmarks(const OpcodeBenchConfig_t *config, OpcodeGroup group, bool isAllGroups, size_t limit)
+{
+    OpcodeBenchResult_t *results = (OpcodeBenchResult_t *)calloc(OPCODE_BENCH_MAX_RESULTS, sizeof(OpcodeBenchResult_t));
+    size_t count = 0;
+
+    if(results == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    if(isAllGroups == false && opcodeBenchIsGroupDecoded(group) == false)
+    {
+        fprintf(stderr, "The %s group is not decoded by the core yet, its opcodes can not be timed\n",
+                opcodeGroupName(group));
+        free(results);
+        return EXIT_FAILURE;
+    }
+
+    for(int idx = 0; idx < OPCODE_GROUP_COUNT; idx++)
+    {
+        if(isAllGroups == false && idx != (int)group)
+        {
+            continue;
+        }
+        if(opcodeBenchIsGroupDecoded((OpcodeGroup)idx) == false)
+        {
+            fprintf(stderr, "Skipping the %s group, it is not decoded by the core yet\n",
+                    opcodeGroupName((OpcodeGroup)idx));
+            continue;
+        }
+
+        size_t groupCount = opcodeBenchRunGroup((OpcodeGroup)idx, config, &results[count]);
+        if(groupCount == 0)
+        {
+            fprintf(stderr, "Could not create the CPU\n");
+            free(results);
+            return EXIT_FAILURE;
+        }
+        count += groupCount;
+    }
+
+    opcodeBenchSort(results, count);
+    opcodeBenchPrintTable(stdout, results, count, limit);
+
+    free(results);
+
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+    BenchmarkConfig_t config = benchmarkDefaultConfig();
+    const char *filter = NULL;
+    const char *outputPath = NULL;
+    const char *baselinePath = NULL;
+    double threshold = BENCH_COMPARE_DEFAULT_THRESHOLD;
+    const char *romPaths[BENCH_MAX_WORKLOADS];
+    size_t romCount = 0;
+    OpcodeBenchConfig_t opcodeConfig = opcodeBenchDefaultConfig();
+    OpcodeGroup opcodeGroup = OPCODE_GROUP_MAIN;
+    bool isOpcodeMode = false;
+    bool isAllGroups = true;
+    size_t rowLimit = 0;
+
+    for(int idx = 1; idx < argc; idx++)
+    {
+        if(strcmp(argv[idx], "-c") == 0 && idx + 1 < argc)
+        {
+            config.cycles = strtol(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-r") == 0 && idx + 1 < argc)
+        {
+            config.repeats = atoi(argv[++idx]);
+        }
+        else if(strcmp(argv[idx], "-w") == 0 && idx + 1 < argc)
+        {
+            filter = argv[++idx];
+        }
+        else if(strcmp(argv[idx], "-o") == 0 && idx + 1 < argc)
+        {
+            outputPath = argv[++idx];
+        }
+        else if(strcmp(argv[idx], "-b") == 0 && idx + 1 < argc)
+        {
+            baselinePath = argv[++idx];
+        }
+        else if(strcmp(argv[idx], "-T") == 0 && idx + 1 < argc)
+        {
+            threshold = strtod(argv[++idx], NULL) / 100.0;
+        }
+        else if(strcmp(argv[idx], "-O") == 0)
+        {
+            isOpcodeMode = true;
+        }
+        else if(strcmp(argv[idx], "-g") == 0 && idx + 1 < argc)
+        {
+            if(opcodeGroupFromName(argv[++idx], &opcodeGroup) == false)
+            {
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            isAllGroups = false;
+        }
+        else if(strcmp(argv[idx], "-i") == 0 && idx + 1 < argc)
+        {
+            opcodeConfig.iterations = strtol(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-t") == 0 && idx + 1 < argc)
+        {
+            rowLimit = (size_t)strtoul(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-n") == 0)
+        {
+            config.isWarmup = false;
+        }
+        else if(strcmp(argv[idx], "-B") == 0 && idx + 1 < argc)
+        {
+            config.backend = machineBackendFind(argv[++idx]);
+            if(config.backend == NULL)
+            {
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if(strcmp(argv[idx], "-L") == 0)
+        {
+            for(size_t backend = 0; backend < machineBackendCount(); backend++)
+            {
+                printf("%-12s %s\n", machineBackendGet(backend)->name, machineBackendGet(backend)->description);
+            }
+            return EXIT_SUCCESS;
+        }
+        else if(strcmp(argv[idx], "-l") == 0)
+        {
+            for(size_t workload = 0; workload < benchWorkloadCount(); workload++)
+            {
+                printf("%-12s %s\n", benchWorkloadGet(workload)->name, benchWorkloadGet(workload)->description);
+            }
+            return EXIT_SUCCESS;
+        }
+        else if(argv[idx][0] != '-' && romCount + benchWorkloadCount() < BENCH_MAX_WORKLOADS)
+        {
+            romPaths[romCount++] = argv[idx];
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(config.cycles <= 0 || config.repeats <= 0 || config.repeats > BENCHMARK_MAX_REPEATS
+       || opcodeConfig.iterations <= 0 || threshold < 0.0)
+    {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if(isOpcodeMode == true)
+    {
+        return runOpcodeBenchmarks(&opcodeConfig, opcodeGroup, isAllGroups, rowLimit);
+    }
+
+    // Load the baseline first, a typo should not cost a whole benchmark run
+    BenchBaseline_t baseline = { NULL, 0 };
+    if(baselinePath != NULL && benchBaselineLoad(baselinePath, &baseline) == false)
+    {
+        fprintf(stderr, "Could not read baseline %s\n", baselinePath);
+        return EXIT_FAILURE;
+    }
+
+    BenchmarkResult_t *results = (BenchmarkResult_t *)calloc(BENCH_MAX_WORKLOADS, sizeof(BenchmarkResult_t));
+    byte_t *rom = (byte_t *)malloc(BENCH_ROM_SIZE);
+    size_t resultCount = 0;
+    bool isFailed = false;
+
+    if(results == NULL || rom == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        free(results);
+        free(rom);
+        benchBaselineDestroy(&baseline);
+        return EXIT_FAILURE;
+    }
+
+    for(size_t idx = 0; idx < benchWorkloadCount(); idx++)
+    {
+        const BenchWorkload_t *workload = benchWorkloadGet(idx);
+        if(filter != NULL && strstr(workload->name, filter) == NULL)
+        {
+            continue;
+        }
+
+        benchWorkloadBuildRom(workload, rom);
+        if(benchmarkRunRom(workload->name, rom, BENCH_ROM_SIZE, &config, &results[resultCount]) == false)
+        {
+            isFailed = true;
+        }
+        resultCount++;
+    }
+
+    for(size_t idx = 0; idx < romCount; idx++)
+    {
+        const char *name = baseName(romPaths[idx]);
+        if(filter != NULL && strstr(name, filter) == NULL)
+        {
+            continue;
+        }
+
+        if(benchmarkRunFile(name, romPaths[idx], &config, &results[resultCount]) == false)
+        {
+            fprintf(stderr, "Could not load %s\n", romPaths[idx]);
+            isFailed = true;
+        }
+        resultCount++;
+    }
+
+    benchmarkPrintTable(stdout, results, resultCount);
+
+    if(outputPath != NULL)
+    {
+        FILE *output = fopen(outputPath, "w");
+        if(output == NULL)
+        {
+            fprintf(stderr, "Could not open %s\n", outputPath);
+            isFailed = true;
+        }
+        else
+        {
+            benchmarkWriteJson(output, &config, results, resultCount);
+            fclose(output);
+        }
+    }
+
+    size_t regressionCount = 0;
+    if(baselinePath != NULL)
+    {
+        printf("\n");
+        regressionCount = benchCompareAll(stdout, &baseline, results, resultCount, threshold);
+        benchBaselineDestroy(&baseline);
+    }
+
+    free(results);
+    free(rom);
+
+    if(isFailed == true)
+    {
+        return EXIT_FAILURE;
+    }
+
+    return (regressionCount > 0) ? BENCH_EXIT_REGRESSION : EXIT_SUCCESS;
+}
@@ -0,0 +1,447 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+
+#include "fuzz/fuzzer.h"
+#include "emulator/symbol_table.h"
+
+/** @brief Exit code if crashes or hangs were found (replay: the test case did not end ok) */
+#define FUZZ_EXIT_FOUND 1
+/** @brief Exit code on errors */
+#define FUZZ_EXIT_ERROR 2
+/** @brief Bytes of a test case shown in the findings list */
+#define FUZZ_PRINT_INPUT_SIZE 48
+
+/** @brief Fuzzer stopped by Ctrl+C */
+static Fuzzer_t *activeFuzzer = NULL;
+
+/**
+ * @brief Prints the command line help
+ *
+ * @param program
+ */
+static void printUsage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [options] <rom> [seed ...]\n"
+            "Fuzzes the input a ROM reads from a port. The ROM runs once until its first read of the\n"
+            "port, every test case then starts from that state. Test cases reaching new code or\n"
+            "branches are kept and mutated further. Ctrl+C stops. Exits with 0 if nothing was found,\n"
+            "%d if there were crashes or hangs and %d on errors.\n"
+            "\n"
+            "  -p <port>     Input port (default: 0x%02X)\n"
+            "  -x <port>     Port that ends a test case when written to (default: none)\n"
+            "  -c <cycles>   Cycles a test case may run before it is a hang (default: %ld)\n"
+            "  -m <bytes>    Largest test case (default: %d)\n"
+            "  -s <address>  Lowest valid stack pointer, pushes below it are crashes. The %d bytes\n"
+            "                below it must not be used otherwise\n"
+            "  -w <a>[:<b>]  Writes to address a (to b) are crashes, up to %d times\n"
+            "  -j <workers>  Worker threads (default: one per logical processor)\n"
+            "  -n <count>    Stop after count test cases\n"
+            "  -t <seconds>  Stop after seconds\n"
+            "  -r <seed>     Random seed (default: 1)\n"
+            "  -o <dir>      Write the corpus and the findings to files in the existing directory\n"
+            "  -C <file>     Write the coverage of corpus and findings, lcov if it ends in .info\n"
+            "  -S <file>     Symbols (.sym, .map or .lst listing) for findings and coverage\n"
+            "  -R <file>     Run the test case in file once and print how it ended\n"
+            "  -q            Do not print progress\n",
+            program, FUZZ_EXIT_FOUND, FUZZ_EXIT_ERROR, FUZZ_DEFAULT_INPUT_PORT, FUZZ_DEFAULT_MAX_CYCLES,
+            FUZZ_DEFAULT_MAX_INPUT_SIZE, FUZZ_STACK_GUARD_SIZE, FUZZ_MAX_WATCHPOINTS);
+}
+
+/**
+ * @brief SIGINT handler, lets the workers finish their test case
+ *
+ * @param signalNumber
+ */
+static void stopFuzzer(int signalNumber)
+{
+    (void)signalNumber;
+
+    if(activeFuzzer != NULL)
+    {
+        fuzzerStop(activeFuzzer);
+    }
+}
+
+/**
+ * @brief Progress line, once a second
+ *
+ * @param context Unused
+ * @param fuzzer
+ */
+static void printProgress(void *context, const Fuzzer_t *fuzzer)
+{
+    (void)context;
+
+    fprintf(stderr, "\rexecs: %llu  corpus: %zu  coverage: %zu addresses, %zu edges  crashes: %llu  hangs: %llu   ",
+            (unsigned long long)fuzzer->executions, fuzzer->corpusCount, fuzzer->coverage->addressCount,
+            fuzzer->coverage->edgeCount,
+            (unsigned long long)(fuzzer->executions - fuzzer->outcomes[FUZZ_OUTCOME_OK]
+                                 - fuzzer->outcomes[FUZZ_OUTCOME_HANG]),
+            (unsigned long long)fuzzer->outcomes[FUZZ_OUTCOME_HANG]);
+}
+
+/**
+ * @brief Prints a test case as a C string literal, cut after FUZZ_PRINT_INPUT_SIZE bytes
+ *
+ * @param stream
+ * @param data
+ * @param size
+ */
+static void printInput(FILE *stream, const byte_t *data, size_t size)
+{
+    fputc('"', stream);
+    for(size_t idx = 0; idx < size && idx < FUZZ_PRINT_INPUT_SIZE; idx++)
+    {
+        if(data[idx] == '\n')
+        {
+            fputs("\\n", stream);
+        }
+        else if(data[idx] == '"' || data[idx] == '\\')
+        {
+            fprintf(stream, "\\%c", data[idx]);
+        }
+        else if(data[idx] >= 0x20 && data[idx] < 0x7F)
+        {
+            fputc(data[idx], stream);
+        }
+        else
+        {
+            fprintf(stream, "\\x%02X", data[idx]);
+        }
+    }
+    fputc('"', stream);
+    if(size > FUZZ_PRINT_INPUT_SIZE)
+    {
+        fprintf(stream, "... (%zu bytes)", size);
+    }
+}
+
+/**
+ * @brief Prints an address with the symbol it belongs to
+ *
+ * @param stream
+ * @param symbols
+ * @param address
+ */
+static void printLocation(FILE *stream, const SymbolTable_t *symbols, word_t address)
+{
+    const Symbol_t *symbol = symbolTableLookup(symbols, address);
+
+    fprintf(stream, "0x%04X", (unsigned int)address);
+    if(symbol != NULL)
+    {
+        fprintf(stream, (symbol->address == address) ? " (%s)" : " (%s+0x%X)", symbol->name,
+                (unsigned int)(address - symbol->address));
+    }
+}
+
+/**
+ * @brief Reads a whole file into a heap buffer
+ *
+ * @param filename
+ * @param size
+ * @return byte_t* NULL on error
+ */
+static byte_t *readFile(const char *filename, size_t *size)
+{
+    FILE *file = fopen(filename, "rb");
+    if(file == NULL)
+    {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    // One extra byte so empty files still get a buffer
+    byte_t *data = (fileSize >= 0) ? (byte_t *)malloc((size_t)fileSize + 1) : NULL;
+    if(data != NULL && fread(data, 1, (size_t)fileSize, file) != (size_t)fileSize)
+    {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+
+    *size = (data != NULL) ? (size_t)fileSize : 0;
+
+    return data;
+}
+
+/**
+ * @brief Writes a buffer to a file
+ *
+ * @param filename
+ * @param data
+ * @param size
+ * @return bool
+ */
+static bool writeFile(const char *filename, const byte_t *data, size_t size)
+{
+    FILE *file = fopen(filename, "wb");
+    if(file == NULL)
+    {
+        return false;
+    }
+
+    bool isWritten = fwrite(data, 1, size, file) == size;
+
+    return (fclose(file) == 0) && isWritten;
+}
+
+/**
+ * @brief Writes corpus-NNNNNN.bin for every corpus entry and <outcome>-<pc>.bin for every
+ * finding into a directory
+ *
+ * @param fuzzer
+ * @param directory
+ * @return bool
+ */
+static bool writeOutput(const Fuzzer_t *fuzzer, const char *directory)
+{
+    char filename[4096];
+    bool isWritten = true;
+
+    for(size_t idx = 0; idx < fuzzer->corpusCount; idx++)
+    {
+        snprintf(filename, sizeof(filename), "%s/corpus-%06zu.bin", directory, idx);
+        isWritten &= writeFile(filename, fuzzer->corpus[idx].data, fuzzer->corpus[idx].size);
+    }
+
+    for(size_t idx = 0; idx < fuzzer->findingCount; idx++)
+    {
+        const FuzzFinding_t *finding = &fuzzer->findings[idx];
+
+        snprintf(filename, sizeof(filename), "%s/%s-%04X.bin", directory, fuzzerOutcomeName(finding->outcome),
+                 (unsigned int)finding->pc);
+        isWritten &= writeFile(filename, finding->input.data, finding->input.size);
+    }
+
+    return isWritten;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *romPath = NULL;
+    const char *seedPaths[256];
+    int seedCount = 0;
+    const char *outputPath = NULL;
+    const char *coveragePath = NULL;
+    const char *symbolPath = NULL;
+    const char *replayPath = NULL;
+    bool isQuiet = false;
+    long inputPort = FUZZ_DEFAULT_INPUT_PORT;
+    long exitPort = -1;
+    FuzzConfig_t config = fuzzerDefaultConfig();
+
+    for(int idx = 1; idx < argc; idx++)
+    {
+        if(strcmp(argv[idx], "-p") == 0 && idx + 1 < argc)
+        {
+            inputPort = strtol(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-x") == 0 && idx + 1 < argc)
+        {
+            exitPort = strtol(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-c") == 0 && idx + 1 < argc)
+        {
+            config.maxCycles = strtol(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-m") == 0 && idx + 1 < argc)
+        {
+            config.maxInputSize = (size_t)strtoul(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-s") == 0 && idx + 1 < argc)
+        {
+            config.stackBound = strtol(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-w") == 0 && idx + 1 < argc && config.watchCount < FUZZ_MAX_WATCHPOINTS)
+        {
+            char *end;
+            config.watchStart[config.watchCount] = (word_t)strtoul(argv[++idx], &end, 0);
+            config.watchEnd[config.watchCount] = (*end == ':') ? (word_t)strtoul(end + 1, NULL, 0)
+                                                               : config.watchStart[config.watchCount];
+            config.watchCount++;
+        }
+        else if(strcmp(argv[idx], "-j") == 0 && idx + 1 < argc)
+        {
+            config.workerCount = atoi(argv[++idx]);
+        }
+        else if(strcmp(argv[idx], "-n") == 0 && idx + 1 < argc)
+        {
+            config.maxExecutions = strtoull(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-t") == 0 && idx + 1 < argc)
+        {
+            config.maxSeconds = atof(argv[++idx]);
+        }
+        else if(strcmp(argv[idx], "-r") == 0 && idx + 1 < argc)
+        {
+            config.seed = (dword_t)strtoul(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-o") == 0 && idx + 1 < argc)
+        {
+            outputPath = argv[++idx];
+        }
+        else if(strcmp(argv[idx], "-C") == 0 && idx + 1 < argc)
+        {
+            coveragePath = argv[++idx];
+        }
+        else if(strcmp(argv[idx], "-S") == 0 && idx + 1 < argc)
+        {
+            symbolPath = argv[++idx];
+        }
+        else if(strcmp(argv[idx], "-R") == 0 && idx + 1 < argc)
+        {
+            replayPath = argv[++idx];
+        }
+        else if(strcmp(argv[idx], "-q") == 0)
+        {
+            isQuiet = true;
+        }
+        else if(argv[idx][0] != '-' && romPath == NULL)
+        {
+            romPath = argv[idx];
+        }
+        else if(argv[idx][0] != '-' && seedCount < (int)(sizeof(seedPaths) / sizeof(seedPaths[0])))
+        {
+            seedPaths[seedCount++] = argv[idx];
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return FUZZ_EXIT_ERROR;
+        }
+    }
+
+    if(romPath == NULL || inputPort < 0 || inputPort > 0xFF || exitPort < -1 || exitPort > 0xFF
+        || config.maxCycles <= 0 || config.maxInputSize == 0 || config.stackBound > 0x10000 || config.workerCount < 0)
+    {
+        printUsage(argv[0]);
+        return FUZZ_EXIT_ERROR;
+    }
+    config.inputPort = (byte_t)inputPort;
+    config.exitPort = (int)exitPort;
+
+    SymbolTable_t symbols;
+    symbolTableInit(&symbols);
+
+    if(symbolPath != NULL && symbolTableLoadFile(&symbols, symbolPath) == false)
+    {
+        fprintf(stderr, "Could not load %s\n", symbolPath);
+        symbolTableDestroy(&symbols);
+        return FUZZ_EXIT_ERROR;
+    }
+
+    Fuzzer_t fuzzer;
+    if(fuzzerInit(&fuzzer, &config, romPath) == false)
+    {
+        fprintf(stderr, "Could not start %s: not loadable, or no read of port 0x%02X within the first cycles\n",
+                romPath, (unsigned int)inputPort);
+        symbolTableDestroy(&symbols);
+        return FUZZ_EXIT_ERROR;
+    }
+
+    int exitCode = EXIT_SUCCESS;
+
+    if(replayPath != NULL)
+    {
+        size_t size;
+        byte_t *data = readFile(replayPath, &size);
+        word_t pc = 0;
+        FuzzOutcome outcome = (data != NULL) ? fuzzerReplay(&fuzzer, data, size, &pc) : FUZZ_OUTCOME_COUNT;
+
+        if(outcome == FUZZ_OUTCOME_COUNT)
+        {
+            fprintf(stderr, "Could not run %s\n", replayPath);
+            exitCode = FUZZ_EXIT_ERROR;
+        }
+        else
+        {
+            printf("%s", fuzzerOutcomeName(outcome));
+            if(outcome != FUZZ_OUTCOME_OK)
+            {
+                printf(" at ");
+                printLocation(stdout, &symbols, pc);
+                exitCode = FUZZ_EXIT_FOUND;
+            }
+            printf("\n");
+        }
+
+        free(data);
+        fuzzerDestroy(&fuzzer);
+        symbolTableDestroy(&symbols);
+        return exitCode;
+    }
+
+    for(int idx = 0; idx < seedCount; idx++)
+    {
+        size_t size;
+        byte_t *data = readFile(seedPaths[idx], &size);
+
+        if(data == NULL || fuzzerAddSeed(&fuzzer, data, size) == false)
+        {
+            fprintf(stderr, "Could not read seed %s\n", seedPaths[idx]);
+            free(data);
+            fuzzerDestroy(&fuzzer);
+            symbolTableDestroy(&symbols);
+            return FUZZ_EXIT_ERROR;
+        }
+        free(data);
+    }
+
+    activeFuzzer = &fuzzer;
+    signal(SIGINT, stopFuzzer);
+
+    bool isRun = fuzzerRun(&fuzzer, isQuiet ? NULL : printProgress, NULL);
+
+    signal(SIGINT, SIG_DFL);
+    activeFuzzer = NULL;
+
+    if(isRun == false)
+    {
+        fprintf(stderr, "Could not start the worker threads\n");
+        fuzzerDestroy(&fuzzer);
+        symbolTableDestroy(&symbols);
+        return FUZZ_EXIT_ERROR;
+    }
+
+    if(isQuiet == false)
+    {
+        fprintf(stderr, "\n");
+    }
+
+    for(size_t idx = 0; idx < fuzzer.findingCount; idx++)
+    {
+        const FuzzFinding_t *finding = &fuzzer.findings[idx];
+
+        printf("%-15s ", fuzzerOutcomeName(finding->outcome));
+        printLocation(stdout, &symbols, finding->pc);
+        printf("  %llu test cases, first: ", (unsigned long long)finding->count);
+        printInput(stdout, finding->input.data, finding->input.size);
+        printf("\n");
+        exitCode = FUZZ_EXIT_FOUND;
+    }
+
+    if(outputPath != NULL && writeOutput(&fuzzer, outputPath) == false)
+    {
+        fprintf(stderr, "Could not write to %s\n", outputPath);
+        exitCode = FUZZ_EXIT_ERROR;
+    }
+
+    if(coveragePath != NULL
+        && coverageSaveFile(fuzzer.coverage, coveragePath, romPath, (symbols.count > 0) ? &symbols : NULL) == false)
+    {
+        fprintf(stderr, "Could not write %s\n", coveragePath);
+        exitCode = FUZZ_EXIT_ERROR;
+    }
+
+    fuzzerDestroy(&fuzzer);
+    symbolTableDestroy(&symbols);
+
+    return exitCode;
+}
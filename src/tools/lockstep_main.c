@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu/lockstep.h"
+#include "emulator/rom_loader.h"
+#include "utils/error_handler.h"
+
+/** @brief Default cycle budget */
+#define LOCKSTEP_DEFAULT_MAX_CYCLES 100000000L
+/** @brief Exit code on a mismatch */
+#define LOCKSTEP_EXIT_MISMATCH 1
+/** @brief Exit code if the ROM could not be loaded */
+#define LOCKSTEP_EXIT_ERROR 2
+
+/**
+ * @brief Prints the command line help
+ *
+ * @param program
+ */
+static void printUsage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [options] <rom>\n"
+            "Runs a ROM on the reference core and on the lane core in lockstep and stops at the\n"
+            "first instruction they disagree on (registers, cycles, memory writes). Exits with 0\n"
+            "if they agree until HALT or the end of the budget, %d on a mismatch and %d on errors.\n"
+            "\n"
+            "  -c <cycles>   Cycle budget (default: %ld)\n"
+            "  -m <count>    Compare the whole RAM every <count> instructions, 0 for never\n"
+            "                (default: %d, the writes are compared after every instruction)\n"
+            "  -f <format>   ROM format: auto, bin or hex (default: auto)\n",
+            program, LOCKSTEP_EXIT_MISMATCH, LOCKSTEP_EXIT_ERROR, LOCKSTEP_DEFAULT_MAX_CYCLES,
+            LOCKSTEP_DEFAULT_MEMORY_INTERVAL);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *romPath = NULL;
+    long maxCycles = LOCKSTEP_DEFAULT_MAX_CYCLES;
+    long memoryInterval = LOCKSTEP_DEFAULT_MEMORY_INTERVAL;
+    RomImageFormat format = ROM_FORMAT_AUTO;
+
+    for(int idx = 1; idx < argc; idx++)
+    {
+        if(strcmp(argv[idx], "-c") == 0 && idx + 1 < argc)
+        {
+            maxCycles = strtol(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-m") == 0 && idx + 1 < argc)
+        {
+            memoryInterval = strtol(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-f") == 0 && idx + 1 < argc)
+        {
+            const char *name = argv[++idx];
+            format = (strcmp(name, "bin") == 0) ? ROM_FORMAT_BINARY
+                   : (strcmp(name, "hex") == 0) ? ROM_FORMAT_INTEL_HEX
+                   : ROM_FORMAT_AUTO;
+        }
+        else if(argv[idx][0] != '-' && romPath == NULL)
+        {
+            romPath = argv[idx];
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return LOCKSTEP_EXIT_ERROR;
+        }
+    }
+
+    if(romPath == NULL || maxCycles <= 0 || memoryInterval < 0)
+    {
+        printUsage(argv[0]);
+        return LOCKSTEP_EXIT_ERROR;
+    }
+
+    RomImage_t image;
+    romImageInit(&image);
+
+    if(romImageLoadFile(&image, romPath, format, 0) == false || image.baseAddress >= CPU_ROM_SIZE)
+    {
+        const ErrorStack_t *errors = errorStackGetCurrent();
+        fprintf(stderr, "Could not load %s: %s\n", romPath,
+                (errors->topIndex >= 0) ? getErrorMessage(errors->errors[errors->topIndex].error) : "not in the ROM window");
+        romImageClose(&image);
+        return LOCKSTEP_EXIT_ERROR;
+    }
+
+    LockstepRunner_t *runner = (LockstepRunner_t *)malloc(sizeof(LockstepRunner_t));
+    if(runner == NULL || lockstepInit(runner) == false)
+    {
+        fprintf(stderr, "Out of memory\n");
+        free(runner);
+        romImageClose(&image);
+        return LOCKSTEP_EXIT_ERROR;
+    }
+
+    runner->memoryInterval = memoryInterval;
+    lockstepLoadRom(runner, (word_t)image.baseAddress, image.data, image.size);
+    romImageClose(&image);
+
+    LockstepMismatch mismatch = lockstepRun(runner, (qword_t)maxCycles);
+    lockstepDump(stdout, runner);
+
+    lockstepDestroy(runner);
+    free(runner);
+
+    return (mismatch == LOCKSTEP_MISMATCH_NONE) ? EXIT_SUCCESS : LOCKSTEP_EXIT_MISMATCH;
+}
@@ -0,0 +1,489 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "machine/machine.h"
+#include "machine/save_state.h"
+#include "cpu/opcode_profile.h"
+#include "cpu/host_profile.h"
+#include "cpu/pc_profile.h"
+#include "cpu/coverage.h"
+#include "emulator/symbol_table.h"
+#include "trace/trace_ring.h"
+#include "trace/trace_file.h"
+#include "utils/clock.h"
+
+/** @brief Console output port (same as the GUI and the batch runner) */
+#define RUN_CONSOLE_PORT 0x01
+/** @brief Writing a value to this port stops the run, the value is the exit code */
+#define RUN_DEFAULT_EXIT_PORT 0x00
+#define RUN_DEFAULT_MAX_CYCLES 100000000L
+
+/** @brief Opcode rows of the host cost table if -p does not set them */
+#define RUN_DEFAULT_HOST_PROFILE_ROWS 20
+
+/** @brief Exit code if the cycle budget ran out before HALT / exit port */
+#define RUN_EXIT_BUDGET 2
+
+/**
+ * @brief State shared with the I/O callbacks
+ */
+typedef struct RunContext_t
+{
+    Machine_t *machine;
+    int exitCode;
+    bool isExited;
+} RunContext_t;
+
+/**
+ * @brief Prints the command line help
+ *
+ * @param program
+ */
+static void printUsage(const char *program)
+{
+    char backendNames[128] = "";
+    char mapperNames[128] = "";
+
+    for(size_t idx = 0; idx < machineBackendCount(); idx++)
+    {
+        strncat(backendNames, (idx > 0) ? ", " : "", sizeof(backendNames) - strlen(backendNames) - 1);
+        strncat(backendNames, machineBackendGet(idx)->name, sizeof(backendNames) - strlen(backendNames) - 1);
+    }
+    for(int idx = 0; machineMapperName((MachineMapper)idx) != NULL; idx++)
+    {
+        strncat(mapperNames, (idx > 0) ? ", " : "", sizeof(mapperNames) - strlen(mapperNames) - 1);
+        strncat(mapperNames, machineMapperName((MachineMapper)idx), sizeof(mapperNames) - strlen(mapperNames) - 1);
+    }
+
+    fprintf(stderr,
+            "Usage: %s [options] <rom>\n"
+            "Runs a ROM without a window until HALT, a write to the exit port or the end of the\n"
+            "cycle budget. Port 0x%02X output goes to stdout, stats go to stderr.\n"
+            "\n"
+            "  -c <cycles>   Cycle budget (default: %ld)\n"
+            "  -x <port>     Exit port, the written value is the exit code (default: 0x%02X)\n"
+            "  -f <format>   ROM format: auto, bin or hex (default: auto)\n"
+            "  -q            Do not print stats\n"
+            "  -B <backend>  Execution backend: %s (default: %s). Profiles, traces and\n"
+            "                coverage need the reference backend\n"
+            "  -m <mapper>   ROM layout: %s\n"
+            "                (default: %s). generic16k pages 16K banks into 0x0000 / 0x4000\n"
+            "                through ports 0x%02X / 0x%02X, the cartridge mappers plug the ROM into\n"
+            "                slot 1 (port 0x%02X). Needs the reference backend\n"
+            "  -p <rows>     Count executions per opcode and print the most frequent opcodes and\n"
+            "                opcode pairs\n"
+            "  -H <interval> Time about every interval-th instruction with the host cycle counter\n"
+            "                and print where the host time goes (execution, slow memory, devices)\n"
+            "  -g <file>     Sample the guest PC and call stack, write collapsed stacks for\n"
+            "                flamegraph.pl / speedscope to file\n"
+            "  -i <cycles>   Emulated cycles between two guest PC samples (default: %d)\n"
+            "  -S <file>     Symbols (.sym, .map or .lst listing) for the collapsed stacks and\n"
+            "                the coverage report\n"
+            "  -C <file>     Record executed addresses and branch edges, write them to file as an\n"
+            "                lcov tracefile if it ends in .info, as JSON otherwise\n"
+            "  -t <file>     Record every retired instruction (PC, bytes, registers, cycles) to a\n"
+            "                delta compressed trace file\n"
+            "  -k <records>  Records between two keyframes of the trace file (default: %d)\n"
+            "  -l <file>     Continue from a save state of the same ROM instead of the reset state\n"
+            "  -w <file>     Write a save state when the run stops\n"
+            "\n"
+            "Exit code: value written to the exit port, 0 on HALT, %d if the budget ran out,\n"
+            "1 on errors.\n",
+            program, RUN_CONSOLE_PORT, RUN_DEFAULT_MAX_CYCLES, RUN_DEFAULT_EXIT_PORT, backendNames,
+            machineBackendGet(0)->name, mapperNames, machineMapperName(MACHINE_MAPPER_NONE), MACHINE_BANK_PORT,
+            MACHINE_BANK_PORT + 1, MACHINE_SLOT_PORT, PC_PROFILE_DEFAULT_INTERVAL,
+            TRACE_FILE_DEFAULT_KEYFRAME_INTERVAL, RUN_EXIT_BUDGET);
+}
+
+/**
+ * @brief Console output, written straight to stdout
+ *
+ * @param context RunContext_t
+ * @param value
+ */
+static void consoleWrite(void *context, byte_t value)
+{
+    (void)context;
+    putchar(value);
+}
+
+/**
+ * @brief Exit port, stops the machine
+ *
+ * @param context RunContext_t
+ * @param value Exit code
+ */
+static void exitWrite(void *context, byte_t value)
+{
+    RunContext_t *run = (RunContext_t *)context;
+
+    run->exitCode = value;
+    run->isExited = true;
+    zilogZ80RequestStop(&run->machine->cpu);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *romPath = NULL;
+    long maxCycles = RUN_DEFAULT_MAX_CYCLES;
+    long exitPort = RUN_DEFAULT_EXIT_PORT;
+    RomImageFormat format = ROM_FORMAT_AUTO;
+    bool isQuiet = false;
+    long profileRows = 0;
+    long hostInterval = 0;
+    const char *stackPath = NULL;
+    long stackInterval = PC_PROFILE_DEFAULT_INTERVAL;
+    const char *symbolPath = NULL;
+    const char *tracePath = NULL;
+    const char *coveragePath = NULL;
+    const char *loadStatePath = NULL;
+    const char *saveStatePath = NULL;
+    long keyframeInterval = TRACE_FILE_DEFAULT_KEYFRAME_INTERVAL;
+    MachineConfig_t config = machineDefaultConfig();
+
+    for(int idx = 1; idx < argc; idx++)
+    {
+        if(strcmp(argv[idx], "-c") == 0 && idx + 1 < argc)
+        {
+            maxCycles = strtol(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-x") == 0 && idx + 1 < argc)
+        {
+            exitPort = strtol(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-f") == 0 && idx + 1 < argc)
+        {
+            const char *name = argv[++idx];
+            format = (strcmp(name, "bin") == 0) ? ROM_FORMAT_BINARY
+                   : (strcmp(name, "hex") == 0) ? ROM_FORMAT_INTEL_HEX
+                   : ROM_FORMAT_AUTO;
+        }
+        else if(strcmp(argv[idx], "-p") == 0 && idx + 1 < argc)
+        {
+            profileRows = strtol(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-H") == 0 && idx + 1 < argc)
+        {
+            hostInterval = strtol(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-g") == 0 && idx + 1 < argc)
+        {
+            stackPath = argv[++idx];
+        }
+        else if(strcmp(argv[idx], "-i") == 0 && idx + 1 < argc)
+        {
+            stackInterval = strtol(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-S") == 0 && idx + 1 < argc)
+        {
+            symbolPath = argv[++idx];
+        }
+        else if(strcmp(argv[idx], "-t") == 0 && idx + 1 < argc)
+        {
+            tracePath = argv[++idx];
+        }
+        else if(strcmp(argv[idx], "-C") == 0 && idx + 1 < argc)
+        {
+            coveragePath = argv[++idx];
+        }
+        else if(strcmp(argv[idx], "-k") == 0 && idx + 1 < argc)
+        {
+            keyframeInterval = strtol(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-l") == 0 && idx + 1 < argc)
+        {
+            loadStatePath = argv[++idx];
+        }
+        else if(strcmp(argv[idx], "-w") == 0 && idx + 1 < argc)
+        {
+            saveStatePath = argv[++idx];
+        }
+        else if(strcmp(argv[idx], "-q") == 0)
+        {
+            isQuiet = true;
+        }
+        else if(strcmp(argv[idx], "-B") == 0 && idx + 1 < argc)
+        {
+            config.backend = machineBackendFind(argv[++idx]);
+            if(config.backend == NULL)
+            {
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if(strcmp(argv[idx], "-m") == 0 && idx + 1 < argc)
+        {
+            if(machineMapperFind(argv[++idx], &config.mapper) == false)
+            {
+                printUsage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if(argv[idx][0] != '-' && romPath == NULL)
+        {
+            romPath = argv[idx];
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(romPath == NULL || maxCycles <= 0 || profileRows < 0 || hostInterval < 0 || hostInterval > 0x7FFFFFFF
+        || stackInterval < 1 || keyframeInterval < 1 || keyframeInterval > 0x7FFFFFFF
+        || exitPort < 0 || exitPort > 0xFF || exitPort == RUN_CONSOLE_PORT)
+    {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if(config.mapper != MACHINE_MAPPER_NONE && config.backend != NULL && config.backend != machineBackendGet(0))
+    {
+        fprintf(stderr, "-m %s needs the %s backend, the %s backend only runs the flat layout\n",
+                machineMapperName(config.mapper), machineBackendGet(0)->name, config.backend->name);
+        return EXIT_FAILURE;
+    }
+
+#if CILOGC80_OPCODE_PROFILE == 0
+    if(profileRows > 0 || hostInterval > 0 || stackPath != NULL || tracePath != NULL || coveragePath != NULL)
+    {
+        fprintf(stderr, "-p, -H, -g, -t and -C need the profiling hooks, this build was configured with "
+                        "-DCILOGC80_OPCODE_PROFILE=OFF\n");
+        return EXIT_FAILURE;
+    }
+#endif
+
+    SymbolTable_t symbols;
+    symbolTableInit(&symbols);
+
+    if(symbolPath != NULL && symbolTableLoadFile(&symbols, symbolPath) == false)
+    {
+        const ErrorStack_t *errors = errorStackGetCurrent();
+        fprintf(stderr, "Could not load %s: %s\n", symbolPath,
+                (errors->topIndex >= 0) ? getErrorMessage(errors->errors[errors->topIndex].error) : "unknown error");
+        symbolTableDestroy(&symbols);
+        return EXIT_FAILURE;
+    }
+
+    Machine_t machine;
+    RunContext_t run = { &machine, 0, false };
+
+    if(machineInit(&machine, &config) == false || machineLoadRom(&machine, romPath, format) == false)
+    {
+        const char *message = (machine.errors.topIndex >= 0)
+            ? getErrorMessage(machine.errors.errors[machine.errors.topIndex].error)
+            : "unknown error";
+        fprintf(stderr, "Could not load %s: %s\n", romPath, message);
+        machineDestroy(&machine);
+        symbolTableDestroy(&symbols);
+        return EXIT_FAILURE;
+    }
+
+    if(loadStatePath != NULL && saveStateLoad(&machine, loadStatePath) == false)
+    {
+        const char *message = (machine.errors.topIndex >= 0)
+            ? getErrorMessage(machine.errors.errors[machine.errors.topIndex].error)
+            : "unknown error";
+        fprintf(stderr, "Could not load %s: %s\n", loadStatePath, message);
+        machineDestroy(&machine);
+        symbolTableDestroy(&symbols);
+        return EXIT_FAILURE;
+    }
+
+    // The exit port may replace a bank or slot port of the machine, its callback takes the run
+    machine.cpu.ioContext = &run;
+    machine.cpu.outputCallback[RUN_CONSOLE_PORT] = consoleWrite;
+    machine.cpu.outputCallback[exitPort] = exitWrite;
+    machine.cpu.portContext[exitPort] = NULL;
+
+    OpcodeProfile_t *profile = NULL;
+    if(profileRows > 0)
+    {
+        profile = opcodeProfileCreate();
+        machine.cpu.profile = profile;
+    }
+
+    HostProfile_t *hostProfile = NULL;
+    if(hostInterval > 0)
+    {
+        hostProfile = hostProfileCreate((int)hostInterval);
+        machine.cpu.hostProfile = hostProfile;
+    }
+
+    PcProfile_t *pcProfile = NULL;
+    if(stackPath != NULL)
+    {
+        pcProfile = pcProfileCreate(stackInterval);
+        machine.cpu.pcProfile = pcProfile;
+    }
+
+    Coverage_t *coverage = NULL;
+    if(coveragePath != NULL)
+    {
+        coverage = coverageCreate();
+        machine.cpu.coverage = coverage;
+    }
+
+    // Blocking, a trace with holes is useless
+    TraceRing_t *trace = NULL;
+    TraceDrain_t traceDrain;
+    TraceFileWriter_t traceWriter;
+    if(tracePath != NULL)
+    {
+        bool isOpen = traceFileWriterOpen(&traceWriter, tracePath, (dword_t)keyframeInterval);
+        trace = traceRingCreate(TRACE_RING_DEFAULT_CAPACITY, true);
+
+        if(isOpen == false || trace == NULL
+            || traceDrainStart(&traceDrain, trace, traceFileSink, &traceWriter) == false)
+        {
+            fprintf(stderr, "Could not write %s\n", tracePath);
+            if(isOpen == true)
+            {
+                traceFileWriterClose(&traceWriter);
+            }
+            traceRingDestroy(trace);
+            coverageDestroy(coverage);
+            machineDestroy(&machine);
+            symbolTableDestroy(&symbols);
+            return EXIT_FAILURE;
+        }
+        machine.cpu.trace = trace;
+    }
+
+    qword_t startTime = clockNowNanoseconds();
+    StopReason stopReason = machineRun(&machine, maxCycles);
+    qword_t elapsedTime = clockNowNanoseconds() - startTime;
+
+    if(trace != NULL)
+    {
+        machine.cpu.trace = NULL;
+        traceDrainStop(&traceDrain);
+    }
+
+    fflush(stdout);
+
+    int exitCode = run.isExited ? run.exitCode
+                 : (stopReason == STOP_REASON_HALT) ? 0
+                 : RUN_EXIT_BUDGET;
+
+    if(saveStatePath != NULL && saveStateWrite(&machine, saveStatePath, NULL, 0) == false)
+    {
+        fprintf(stderr, "Could not write %s\n", saveStatePath);
+        exitCode = EXIT_FAILURE;
+    }
+
+    if(isQuiet == false)
+    {
+        double seconds = (double)elapsedTime / 1e9;
+        double emulatedMHz = (seconds > 0.0) ? (double)machine.scheduler.totalCycles / seconds / 1e6 : 0.0;
+
+        fprintf(stderr,
+                "stop:      %s\n"
+                "backend:   %s\n"
+                "pc:        0x%04X\n"
+                "cycles:    %llu\n"
+                "host time: %.3f ms\n"
+                "speed:     %.2f MHz emulated\n"
+                "exit code: %d\n",
+                run.isExited ? "exit port" : zilogZ80StopReasonName(stopReason), machine.backend->name,
+                (unsigned int)machine.cpu.stopPC,
+                (unsigned long long)machine.scheduler.totalCycles,
+                seconds * 1e3, emulatedMHz, exitCode);
+    }
+
+    if(profile != NULL)
+    {
+        fprintf(stderr, "\n");
+        opcodeProfileDump(stderr, profile, (size_t)profileRows);
+        machine.cpu.profile = NULL;
+        opcodeProfileDestroy(profile);
+    }
+
+    if(hostProfile != NULL)
+    {
+        fprintf(stderr, "\n");
+        hostProfileDump(stderr, hostProfile, (profileRows > 0) ? (size_t)profileRows : RUN_DEFAULT_HOST_PROFILE_ROWS);
+        machine.cpu.hostProfile = NULL;
+        hostProfileDestroy(hostProfile);
+    }
+
+    if(pcProfile != NULL)
+    {
+        FILE *stackFile = fopen(stackPath, "w");
+
+        if(stackFile == NULL)
+        {
+            fprintf(stderr, "Could not write %s\n", stackPath);
+            exitCode = EXIT_FAILURE;
+        }
+        else
+        {
+            size_t lines = pcProfileWriteCollapsed(pcProfile, stackFile, (symbols.count > 0) ? &symbols : NULL);
+            fclose(stackFile);
+
+            if(isQuiet == false)
+            {
+                fprintf(stderr, "\nguest samples: %llu in %zu stacks written to %s\n",
+                        (unsigned long long)pcProfile->samples, lines, stackPath);
+                if(pcProfile->droppedSamples > 0 || pcProfile->droppedFrames > 0)
+                {
+                    fprintf(stderr, "(%llu samples not recorded, table full; %llu calls deeper than %d levels)\n",
+                            (unsigned long long)pcProfile->droppedSamples,
+                            (unsigned long long)pcProfile->droppedFrames, PC_PROFILE_MAX_DEPTH);
+                }
+            }
+        }
+
+        machine.cpu.pcProfile = NULL;
+        pcProfileDestroy(pcProfile);
+    }
+
+    if(coverage != NULL)
+    {
+        machine.cpu.coverage = NULL;
+
+        if(coverageSaveFile(coverage, coveragePath, romPath, (symbols.count > 0) ? &symbols : NULL) == false)
+        {
+            fprintf(stderr, "Could not write %s\n", coveragePath);
+            exitCode = EXIT_FAILURE;
+        }
+        else if(isQuiet == false)
+        {
+            fprintf(stderr, "\ncoverage: %zu addresses, %zu edges written to %s\n",
+                    coverage->addressCount, coverage->edgeCount, coveragePath);
+            if(coverage->droppedEdges > 0)
+            {
+                fprintf(stderr, "(%llu edges not recorded, table full)\n",
+                        (unsigned long long)coverage->droppedEdges);
+            }
+        }
+
+        coverageDestroy(coverage);
+    }
+
+    if(trace != NULL)
+    {
+        qword_t records = traceWriter.recordCount;
+        qword_t blocks = traceWriter.indexCount + ((traceWriter.blockRecords > 0) ? 1 : 0);
+
+        if(traceFileWriterClose(&traceWriter) == false)
+        {
+            fprintf(stderr, "Could not write %s\n", tracePath);
+            exitCode = EXIT_FAILURE;
+        }
+        else if(isQuiet == false)
+        {
+            fprintf(stderr, "\ntrace: %llu instructions in %llu blocks written to %s\n",
+                    (unsigned long long)records, (unsigned long long)blocks, tracePath);
+        }
+
+        traceRingDestroy(trace);
+    }
+
+    machineDestroy(&machine);
+    symbolTableDestroy(&symbols);
+
+    return exitCode;
+}
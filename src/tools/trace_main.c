@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace/trace_analysis.h"
+#include "emulator/symbol_table.h"
+#include "utils/clock.h"
+#include "utils/error_handler.h"
+
+/** @brief Default rows of the ranked tables */
+#define TRACE_DEFAULT_ROWS 20
+
+/**
+ * @brief Prints the command line help
+ *
+ * @param program
+ */
+static void printUsage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [options] <trace.c80t>...\n"
+            "Analyzes delta compressed traces written by cilogc80-run -t: opcode histogram, hot PCs,\n"
+            "memory heatmap, port summary, I/O timeline and searches.\n"
+            "\n"
+            "  -j <workers>     Worker threads (default: one per logical processor)\n"
+            "  -n <rows>        Rows of the ranked tables (default: %d)\n"
+            "  -e <events>      I/O events on the timeline (default: %d)\n"
+            "  -f <condition>   Find the first record matching a condition, up to %d times:\n"
+            "                   <field><op><value>, fields a f b c d e h l af bc de hl sp ix iy\n"
+            "                   pc i r cycle read write in out, ops == != < <= > >= &\n"
+            "                   (e.g. -f hl==0x8000 -f write==0xC000 -f out==0x01)\n"
+            "  -S <file>        Symbol file for the hot PCs and addresses\n",
+            program, TRACE_DEFAULT_ROWS, TRACE_DEFAULT_TIMELINE_EVENTS, TRACE_MAX_CONDITIONS);
+}
+
+/**
+ * @brief Prints the message of the top of the error stack
+ *
+ * @param action
+ * @param path
+ */
+static void printError(const char *action, const char *path)
+{
+    const ErrorStack_t *errors = errorStackGetCurrent();
+
+    fprintf(stderr, "Could not %s %s: %s\n", action, path,
+            (errors->topIndex >= 0) ? getErrorMessage(errors->errors[errors->topIndex].error) : "unknown error");
+}
+
+int main(int argc, char *argv[])
+{
+    TraceAnalysisOptions_t options;
+    const char *symbolPath = NULL;
+    const char *paths[64];
+    int pathCount = 0;
+    long rows = TRACE_DEFAULT_ROWS;
+    long events = TRACE_DEFAULT_TIMELINE_EVENTS;
+
+    memset(&options, 0x00, sizeof(options));
+
+    for(int idx = 1; idx < argc; idx++)
+    {
+        if(strcmp(argv[idx], "-j") == 0 && idx + 1 < argc)
+        {
+            options.workerCount = atoi(argv[++idx]);
+        }
+        else if(strcmp(argv[idx], "-n") == 0 && idx + 1 < argc)
+        {
+            rows = strtol(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-e") == 0 && idx + 1 < argc)
+        {
+            events = strtol(argv[++idx], NULL, 0);
+        }
+        else if(strcmp(argv[idx], "-f") == 0 && idx + 1 < argc && options.conditionCount < TRACE_MAX_CONDITIONS)
+        {
+            if(traceConditionParse(&options.conditions[options.conditionCount], argv[++idx]) == false)
+            {
+                fprintf(stderr, "Not a condition: %s\n", argv[idx]);
+                return EXIT_FAILURE;
+            }
+            options.conditionCount++;
+        }
+        else if(strcmp(argv[idx], "-S") == 0 && idx + 1 < argc)
+        {
+            symbolPath = argv[++idx];
+        }
+        else if(argv[idx][0] != '-' && pathCount < (int)(sizeof(paths) / sizeof(paths[0])))
+        {
+            paths[pathCount++] = argv[idx];
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if(pathCount == 0 || rows < 0 || events < 0 || events > 0x100000)
+    {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    options.timelineEvents = (size_t)events;
+
+    SymbolTable_t symbols;
+    symbolTableInit(&symbols);
+
+    if(symbolPath != NULL && symbolTableLoadFile(&symbols, symbolPath) == false)
+    {
+        printError("load", symbolPath);
+        symbolTableDestroy(&symbols);
+        return EXIT_FAILURE;
+    }
+
+    int status = EXIT_SUCCESS;
+
+    for(int idx = 0; idx < pathCount; idx++)
+    {
+        TraceFile_t file;
+
+        if(traceFileOpen(&file, paths[idx]) == false)
+        {
+            printError("open", paths[idx]);
+            status = EXIT_FAILURE;
+            continue;
+        }
+
+        TraceAnalysis_t *analysis = traceAnalysisCreate();
+        qword_t start = clockNowNanoseconds();
+
+        if(analysis == NULL || traceAnalyze(&file, &options, analysis) == false)
+        {
+            printError("analyze", paths[idx]);
+            traceAnalysisDestroy(analysis);
+            traceFileClose(&file);
+            status = EXIT_FAILURE;
+            continue;
+        }
+
+        double seconds = (double)(clockNowNanoseconds() - start) / 1e9;
+
+        printf("%s%s: %llu records in %zu blocks%s\n", (idx > 0) ? "\n" : "", paths[idx],
+               (unsigned long long)file.recordCount, file.blockCount,
+               (file.isIndexRebuilt == true) ? " (unfinished, index rebuilt)" : "");
+        traceAnalysisDump(stdout, analysis, &options, (size_t)rows, (symbolPath != NULL) ? &symbols : NULL);
+
+        fprintf(stderr, "%s: analyzed in %.3f s (%.1f M records/s)\n", paths[idx], seconds,
+                (seconds > 0.0) ? (double)file.recordCount / seconds / 1e6 : 0.0);
+
+        traceAnalysisDestroy(analysis);
+        traceFileClose(&file);
+    }
+
+    symbolTableDestroy(&symbols);
+
+    return status;
+}
@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace/trace_diff.h"
+#include "emulator/symbol_table.h"
+#include "utils/clock.h"
+#include "utils/error_handler.h"
+
+/** @brief Exit code if the traces differ, as cmp and diff */
+#define TRACEDIFF_EXIT_DIVERGED 1
+/** @brief Exit code if a trace could not be read */
+#define TRACEDIFF_EXIT_ERROR 2
+
+/**
+ * @brief Prints the command line help
+ *
+ * @param program
+ */
+static void printUsage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [options] <first.c80t> <second.c80t>\n"
+            "Finds the first instruction two traces written by cilogc80-run -t differ in, e.g. the\n"
+            "same ROM run by two builds or with two inputs. Exits with 0 if the traces are identical,\n"
+            "%d if they differ and %d on errors.\n"
+            "\n"
+            "  -S <file>        Symbol file for the divergent PC\n",
+            program, TRACEDIFF_EXIT_DIVERGED, TRACEDIFF_EXIT_ERROR);
+}
+
+/**
+ * @brief Prints the message of the top of the error stack
+ *
+ * @param action
+ * @param path
+ */
+static void printError(const char *action, const char *path)
+{
+    const ErrorStack_t *errors = errorStackGetCurrent();
+
+    fprintf(stderr, "Could not %s %s: %s\n", action, path,
+            (errors->topIndex >= 0) ? getErrorMessage(errors->errors[errors->topIndex].error) : "unknown error");
+}
+
+int main(int argc, char *argv[])
+{
+    const char *symbolPath = NULL;
+    const char *paths[2];
+    int pathCount = 0;
+
+    for(int idx = 1; idx < argc; idx++)
+    {
+        if(strcmp(argv[idx], "-S") == 0 && idx + 1 < argc)
+        {
+            symbolPath = argv[++idx];
+        }
+        else if(argv[idx][0] != '-' && pathCount < 2)
+        {
+            paths[pathCount++] = argv[idx];
+        }
+        else
+        {
+            printUsage(argv[0]);
+            return TRACEDIFF_EXIT_ERROR;
+        }
+    }
+
+    if(pathCount != 2)
+    {
+        printUsage(argv[0]);
+        return TRACEDIFF_EXIT_ERROR;
+    }
+
+    SymbolTable_t symbols;
+    symbolTableInit(&symbols);
+
+    if(symbolPath != NULL && symbolTableLoadFile(&symbols, symbolPath) == false)
+    {
+        printError("load", symbolPath);
+        symbolTableDestroy(&symbols);
+        return TRACEDIFF_EXIT_ERROR;
+    }
+
+    TraceFile_t first;
+    TraceFile_t second;
+
+    if(traceFileOpen(&first, paths[0]) == false)
+    {
+        printError("open", paths[0]);
+        symbolTableDestroy(&symbols);
+        return TRACEDIFF_EXIT_ERROR;
+    }
+    if(traceFileOpen(&second, paths[1]) == false)
+    {
+        printError("open", paths[1]);
+        traceFileClose(&first);
+        symbolTableDestroy(&symbols);
+        return TRACEDIFF_EXIT_ERROR;
+    }
+
+    TraceDivergence_t divergence;
+    qword_t start = clockNowNanoseconds();
+    int status = TRACEDIFF_EXIT_ERROR;
+
+    if(traceDiffFind(&first, &second, &divergence) == false)
+    {
+        printError("compare", paths[1]);
+    }
+    else
+    {
+        traceDiffDump(stdout, &divergence, (symbolPath != NULL) ? &symbols : NULL);
+        fprintf(stderr, "compared in %.3f s\n", (double)(clockNowNanoseconds() - start) / 1e9);
+        status = (divergence.isDiverged == true) ? TRACEDIFF_EXIT_DIVERGED : EXIT_SUCCESS;
+    }
+
+    traceFileClose(&first);
+    traceFileClose(&second);
+    symbolTableDestroy(&symbols);
+
+    return status;
+}
@@ -0,0 +1,1184 @@
+#include "trace/trace_analysis.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch/thread_pool.h"
+#include "utils/threading.h"
+
+/** @brief Characters of the heatmap, coldest first */
+#define HEATMAP_SHADES " .:-=+*#%@"
+
+/**
+ * @brief Range of blocks analyzed by one task
+ */
+typedef struct AnalysisChunk_t
+{
+    size_t firstBlock;
+    /** @brief First block of the next chunk */
+    size_t endBlock;
+
+    /** @brief First I/O events of the chunk, at most timelineEvents */
+    TraceIoEvent_t *events;
+    size_t eventCount;
+} AnalysisChunk_t;
+
+/**
+ * @brief State shared by the workers of one analysis
+ */
+typedef struct Analyzer_t
+{
+    const TraceFile_t *file;
+    const TraceAnalysisOptions_t *options;
+
+    AnalysisChunk_t *chunks;
+    size_t chunkCount;
+    /** @brief Next chunk to hand out */
+    long nextChunk;
+    /** @brief Set by a worker that hit damaged data or ran out of memory */
+    long isFailed;
+} Analyzer_t;
+
+/**
+ * @brief One worker: its own cursor and counters, no sharing while counting
+ */
+typedef struct AnalysisWorker_t
+{
+    Analyzer_t *analyzer;
+    TraceCursor_t *cursor;
+    TraceAnalysis_t *analysis;
+} AnalysisWorker_t;
+
+/**
+ * @brief Count of one index of a counter array, for ranking
+ */
+typedef struct RankedCount_t
+{
+    dword_t index;
+    qword_t count;
+} RankedCount_t;
+
+/**
+ * @brief Thread pool task, analyzes chunks until none are left
+ *
+ * @param argument AnalysisWorker_t
+ * @return ThreadPoolTaskStatus
+ */
+static ThreadPoolTaskStatus analyzeTask(void *argument);
+
+/**
+ * @brief Decodes and counts the records of a chunk
+ *
+ * @param worker
+ * @param chunk
+ * @return bool False on damaged data or out of memory
+ */
+static bool analyzeChunk(AnalysisWorker_t *worker, AnalysisChunk_t *chunk);
+
+/**
+ * @brief Counts what a record shows on its own: opcode, PC, register conditions
+ *
+ * @param worker
+ * @param number Record number
+ * @param record
+ */
+static void countRecord(AnalysisWorker_t *worker, qword_t number, const TraceRecord_t *record);
+
+/**
+ * @brief Counts what needs the previous record: cycles and accesses of the instruction
+ *
+ * @param worker
+ * @param chunk Receives the I/O events
+ * @param number Record number
+ * @param before NULL for the first record of the trace
+ * @param after
+ * @return bool False if out of memory
+ */
+static bool countStep(AnalysisWorker_t *worker, AnalysisChunk_t *chunk, qword_t number, const TraceRecord_t *before,
+                      const TraceRecord_t *after);
+
+/**
+ * @brief Sets a match unless an earlier record already matched
+ *
+ * @param match
+ * @param number
+ * @param record
+ */
+static void updateMatch(TraceMatch_t *match, qword_t number, const TraceRecord_t *record);
+
+/**
+ * @brief Adds the accesses of a DD / FD prefixed instruction
+ *
+ * @param before
+ * @param after
+ * @param base IX or IY before the instruction
+ * @param accesses
+ * @param count
+ * @return int New count
+ */
+static int decodeIndexed(const TraceRecord_t *before, const TraceRecord_t *after, word_t base,
+                         TraceAccess_t *accesses, int count);
+
+/**
+ * @brief Adds the accesses of an ED prefixed instruction
+ *
+ * @param before
+ * @param after
+ * @param accesses
+ * @param count
+ * @return int New count
+ */
+static int decodeExtended(const TraceRecord_t *before, const TraceRecord_t *after, TraceAccess_t *accesses, int count);
+
+/**
+ * @brief Adds the accesses of PUSH, CALL, RST (writes below SP) or POP, RET (reads at SP)
+ *
+ * @param stackPointer SP before the instruction
+ * @param isPush
+ * @param accesses
+ * @param count
+ * @return int New count
+ */
+static int addStackAccesses(word_t stackPointer, bool isPush, TraceAccess_t *accesses, int count);
+
+/**
+ * @brief Appends an access
+ *
+ * @return int New count
+ */
+static int addAccess(TraceAccess_t *accesses, int count, TraceAccessKind kind, word_t address, int value);
+
+/**
+ * @brief Returns a register of a record by its 3 bit encoding (B C D E H L - A)
+ *
+ * @param record
+ * @param index
+ * @return int -1 for index 6
+ */
+static int registerByIndex(const TraceRecord_t *record, int index);
+
+/**
+ * @brief Returns the field of a condition from a record
+ *
+ * @param record
+ * @param field
+ * @return qword_t
+ */
+static qword_t fieldValue(const TraceRecord_t *record, TraceConditionField field);
+
+/**
+ * @brief Applies a condition operator
+ *
+ * @param operation
+ * @param value
+ * @param reference
+ * @return bool
+ */
+static bool compareValue(TraceConditionOperator operation, qword_t value, qword_t reference);
+
+/**
+ * @brief Ranks the non zero entries of a counter array, highest first
+ *
+ * @param counts
+ * @param size
+ * @param ranked size entries
+ * @return size_t Number of non zero entries
+ */
+static size_t rankCounts(const qword_t *counts, size_t size, RankedCount_t *ranked);
+
+/**
+ * @brief Formats an address with the symbol it belongs to ("main+0x12")
+ *
+ * @param symbols NULL if no symbols are loaded
+ * @param address
+ * @param buffer
+ * @param bufferSize
+ * @return const char* buffer
+ */
+static const char *formatLocation(const SymbolTable_t *symbols, word_t address, char *buffer, size_t bufferSize);
+
+/**
+ * @brief Prints a 16 x 16 grid of the 256 byte pages, shaded by accesses on a log scale
+ *
+ * @param stream
+ * @param title
+ * @param counts Accesses per address
+ */
+static void dumpHeatmap(FILE *stream, const char *title, const qword_t *counts);
+
+/**
+ * @brief Returns the number of significant bits, the integer log2 the heatmap is scaled by
+ *
+ * @param value
+ * @return size_t 0 for 0
+ */
+static size_t bitLength(qword_t value);
+
+/**
+ * @brief qsort comparator of @ref RankedCount_t, highest first
+ */
+static int compareRanked(const void *first, const void *second);
+
+static const char *fieldNames[TRACE_FIELD_COUNT] = {
+    "a", "f", "b", "c", "d", "e", "h", "l", "af", "bc", "de", "hl", "sp", "ix", "iy", "pc", "i", "r", "cycle",
+    "read", "write", "in", "out"};
+
+/* ---------------------------------- Analysis ------------------------------ */
+TraceAnalysis_t *traceAnalysisCreate()
+{
+    TraceAnalysis_t *analysis = (TraceAnalysis_t *)calloc(1, sizeof(TraceAnalysis_t));
+
+    if(analysis != NULL)
+    {
+        opcodeProfileClear(&analysis->opcodes);
+    }
+
+    return analysis;
+}
+
+void traceAnalysisDestroy(TraceAnalysis_t *analysis)
+{
+    if(analysis == NULL)
+    {
+        return;
+    }
+
+    free(analysis->events);
+    free(analysis);
+}
+
+void traceAnalysisMerge(TraceAnalysis_t *analysis, const TraceAnalysis_t *other)
+{
+    opcodeProfileMerge(&analysis->opcodes, &other->opcodes);
+
+    for(size_t idx = 0; idx < 0x10000; idx++)
+    {
+        analysis->pcCounts[idx] += other->pcCounts[idx];
+        analysis->pcCycles[idx] += other->pcCycles[idx];
+    }
+
+    for(int kind = 0; kind < TRACE_ACCESS_KIND_COUNT; kind++)
+    {
+        for(size_t idx = 0; idx < 0x10000; idx++)
+        {
+            analysis->accesses[kind][idx] += other->accesses[kind][idx];
+        }
+    }
+
+    for(size_t idx = 0; idx < TRACE_MAX_CONDITIONS; idx++)
+    {
+        const TraceMatch_t *match = &other->matches[idx];
+
+        if(match->isFound == true
+            && (analysis->matches[idx].isFound == false || match->record < analysis->matches[idx].record))
+        {
+            analysis->matches[idx] = *match;
+        }
+    }
+}
+
+bool traceAnalyze(const TraceFile_t *file, const TraceAnalysisOptions_t *options, TraceAnalysis_t *analysis)
+{
+    Analyzer_t analyzer;
+    ThreadPool_t pool;
+    bool isGood = true;
+
+    memset(&analyzer, 0x00, sizeof(analyzer));
+    analyzer.file = file;
+    analyzer.options = options;
+
+    if(file->blockCount == 0)
+    {
+        return true;
+    }
+
+    if(threadPoolInit(&pool, options->workerCount) == false)
+    {
+        return false;
+    }
+
+    // Enough chunks to keep every worker busy until the end
+    size_t workerCount = (size_t)pool.workerCount;
+    analyzer.chunkCount = workerCount * TRACE_CHUNKS_PER_WORKER;
+    if(analyzer.chunkCount > file->blockCount)
+    {
+        analyzer.chunkCount = file->blockCount;
+    }
+
+    analyzer.chunks = (AnalysisChunk_t *)calloc(analyzer.chunkCount, sizeof(AnalysisChunk_t));
+    AnalysisWorker_t *workers = (AnalysisWorker_t *)calloc(workerCount, sizeof(AnalysisWorker_t));
+
+    if(analyzer.chunks == NULL || workers == NULL)
+    {
+        isGood = false;
+    }
+
+    for(size_t idx = 0; isGood == true && idx < analyzer.chunkCount; idx++)
+    {
+        analyzer.chunks[idx].firstBlock = idx * file->blockCount / analyzer.chunkCount;
+        analyzer.chunks[idx].endBlock = (idx + 1) * file->blockCount / analyzer.chunkCount;
+    }
+
+    for(size_t idx = 0; isGood == true && idx < workerCount; idx++)
+    {
+        workers[idx].analyzer = &analyzer;
+        workers[idx].cursor = traceCursorCreate(file);
+        workers[idx].analysis = traceAnalysisCreate();
+
+        isGood = workers[idx].cursor != NULL && workers[idx].analysis != NULL
+            && threadPoolSubmit(&pool, analyzeTask, &workers[idx]) == true;
+    }
+
+    threadPoolWait(&pool);
+    threadPoolDestroy(&pool);
+
+    isGood = isGood == true && atomicLoad(&analyzer.isFailed) == 0;
+
+    // Counters merge in any order, the timeline is assembled in chunk order
+    for(size_t idx = 0; workers != NULL && idx < workerCount; idx++)
+    {
+        if(isGood == true)
+        {
+            traceAnalysisMerge(analysis, workers[idx].analysis);
+        }
+        traceCursorDestroy(workers[idx].cursor);
+        traceAnalysisDestroy(workers[idx].analysis);
+    }
+
+    if(isGood == true && options->timelineEvents > 0)
+    {
+        analysis->events = (TraceIoEvent_t *)malloc(options->timelineEvents * sizeof(TraceIoEvent_t));
+        isGood = analysis->events != NULL;
+    }
+
+    for(size_t idx = 0; analyzer.chunks != NULL && idx < analyzer.chunkCount; idx++)
+    {
+        const AnalysisChunk_t *chunk = &analyzer.chunks[idx];
+
+        for(size_t event = 0; isGood == true && event < chunk->eventCount
+            && analysis->eventCount < options->timelineEvents; event++)
+        {
+            analysis->events[analysis->eventCount++] = chunk->events[event];
+        }
+        free(chunk->events);
+    }
+
+    free(analyzer.chunks);
+    free(workers);
+
+    return isGood;
+}
+
+static ThreadPoolTaskStatus analyzeTask(void *argument)
+{
+    AnalysisWorker_t *worker = (AnalysisWorker_t *)argument;
+    Analyzer_t *analyzer = worker->analyzer;
+
+    for(;;)
+    {
+        long chunk = atomicAdd(&analyzer->nextChunk, 1);
+
+        if((size_t)chunk >= analyzer->chunkCount || atomicLoad(&analyzer->isFailed) != 0)
+        {
+            break;
+        }
+
+        if(analyzeChunk(worker, &analyzer->chunks[chunk]) == false)
+        {
+            atomicStore(&analyzer->isFailed, 1);
+            break;
+        }
+    }
+
+    return THREAD_POOL_TASK_DONE;
+}
+
+static bool analyzeChunk(AnalysisWorker_t *worker, AnalysisChunk_t *chunk)
+{
+    const TraceFile_t *file = worker->analyzer->file;
+    TraceCursor_t *cursor = worker->cursor;
+    TraceRecord_t before;
+    TraceRecord_t record;
+    bool hasBefore = false;
+
+    qword_t end = (chunk->endBlock < file->blockCount) ? file->index[chunk->endBlock].firstRecord : file->recordCount;
+
+    // The opcode pair across the seam to the previous chunk is counted by that chunk
+    worker->analysis->opcodes.previousIndex = -1;
+
+    if(traceCursorSeekBlock(cursor, chunk->firstBlock) == false)
+    {
+        return false;
+    }
+
+    while(cursor->recordNumber < end)
+    {
+        qword_t number = cursor->recordNumber;
+
+        if(traceCursorNext(cursor, &record) == false)
+        {
+            return false;
+        }
+
+        countRecord(worker, number, &record);
+
+        // The step into the first record of a chunk is counted by the chunk before
+        if((hasBefore == true || number == 0)
+            && countStep(worker, chunk, number, (hasBefore == true) ? &before : NULL, &record) == false)
+        {
+            return false;
+        }
+
+        before = record;
+        hasBefore = true;
+    }
+
+    // The keyframe of the next chunk, only for the step into it and the opcode pair with the
+    // last record of this chunk
+    if(chunk->endBlock < file->blockCount && hasBefore == true)
+    {
+        byte_t opcode;
+
+        if(traceCursorNext(cursor, &record) == false)
+        {
+            return false;
+        }
+
+        OpcodeGroup group = opcodeProfileDecodeBytes(record.opcode, &opcode);
+        opcodeProfileRecordPair(&worker->analysis->opcodes, group, opcode);
+
+        return countStep(worker, chunk, end, &before, &record);
+    }
+
+    return true;
+}
+
+static void countRecord(AnalysisWorker_t *worker, qword_t number, const TraceRecord_t *record)
+{
+    TraceAnalysis_t *analysis = worker->analysis;
+    const TraceAnalysisOptions_t *options = worker->analyzer->options;
+    byte_t opcode;
+
+    OpcodeGroup group = opcodeProfileDecodeBytes(record->opcode, &opcode);
+    opcodeProfileRecord(&analysis->opcodes, group, opcode, 0);
+    analysis->pcCounts[record->pc]++;
+
+    for(size_t idx = 0; idx < options->conditionCount; idx++)
+    {
+        if(options->conditions[idx].field < TRACE_FIELD_READ
+            && traceConditionMatchesRecord(&options->conditions[idx], record) == true)
+        {
+            updateMatch(&analysis->matches[idx], number, record);
+        }
+    }
+}
+
+static bool countStep(AnalysisWorker_t *worker, AnalysisChunk_t *chunk, qword_t number, const TraceRecord_t *before,
+                      const TraceRecord_t *after)
+{
+    TraceAnalysis_t *analysis = worker->analysis;
+    const TraceAnalysisOptions_t *options = worker->analyzer->options;
+    TraceAccess_t accesses[TRACE_MAX_ACCESSES];
+    byte_t opcode;
+
+    // The trace starts counting cycles at 0
+    qword_t cycles = after->cycle - ((before != NULL) ? before->cycle : 0);
+    OpcodeGroup group = opcodeProfileDecodeBytes(after->opcode, &opcode);
+
+    analysis->opcodes.cycles[group][opcode] += cycles;
+    analysis->opcodes.totalCycles += cycles;
+    analysis->pcCycles[after->pc] += cycles;
+
+    if(before == NULL)
+    {
+        return true;
+    }
+
+    int count = traceDecodeAccesses(before, after, accesses);
+    for(int idx = 0; idx < count; idx++)
+    {
+        const TraceAccess_t *access = &accesses[idx];
+        bool isPort = access->kind == TRACE_ACCESS_IN || access->kind == TRACE_ACCESS_OUT;
+
+        analysis->accesses[access->kind][isPort ? (access->address & 0xFF) : access->address]++;
+
+        if(isPort == true && chunk->eventCount < options->timelineEvents)
+        {
+            if(chunk->events == NULL)
+            {
+                chunk->events = (TraceIoEvent_t *)malloc(options->timelineEvents * sizeof(TraceIoEvent_t));
+                if(chunk->events == NULL)
+                {
+                    return false;
+                }
+            }
+
+            chunk->events[chunk->eventCount++] = (TraceIoEvent_t){
+                .record = number,
+                .cycle = after->cycle,
+                .pc = after->pc,
+                .port = access->address,
+                .value = access->value,
+                .isOutput = access->kind == TRACE_ACCESS_OUT};
+        }
+
+        for(size_t condition = 0; condition < options->conditionCount; condition++)
+        {
+            if(traceConditionMatchesAccess(&options->conditions[condition], access) == true)
+            {
+                updateMatch(&analysis->matches[condition], number, after);
+            }
+        }
+    }
+
+    return true;
+}
+
+static void updateMatch(TraceMatch_t *match, qword_t number, const TraceRecord_t *record)
+{
+    if(match->isFound == true && match->record <= number)
+    {
+        return;
+    }
+
+    match->isFound = true;
+    match->record = number;
+    match->cycle = record->cycle;
+    match->pc = record->pc;
+}
+/* -------------------------------------------------------------------------- */
+
+/* --------------------------------- Accesses ------------------------------- */
+int traceDecodeAccesses(const TraceRecord_t *before, const TraceRecord_t *after, TraceAccess_t *accesses)
+{
+    const byte_t *bytes = after->opcode;
+    word_t address = TO_WORD(bytes[2], bytes[1]);
+    byte_t a = (byte_t)(before->af >> 8);
+    int count = 0;
+
+    switch(bytes[0])
+    {
+    case 0x02:
+        return addAccess(accesses, count, TRACE_ACCESS_WRITE, before->bc, -1);
+    case 0x12:
+        return addAccess(accesses, count, TRACE_ACCESS_WRITE, before->de, -1);
+    case 0x0A:
+        return addAccess(accesses, count, TRACE_ACCESS_READ, before->bc, -1);
+    case 0x1A:
+        return addAccess(accesses, count, TRACE_ACCESS_READ, before->de, -1);
+    case 0x22:
+        count = addAccess(accesses, count, TRACE_ACCESS_WRITE, address, -1);
+        return addAccess(accesses, count, TRACE_ACCESS_WRITE, (word_t)(address + 1), -1);
+    case 0x2A:
+        count = addAccess(accesses, count, TRACE_ACCESS_READ, address, -1);
+        return addAccess(accesses, count, TRACE_ACCESS_READ, (word_t)(address + 1), -1);
+    case 0x32:
+        return addAccess(accesses, count, TRACE_ACCESS_WRITE, address, -1);
+    case 0x3A:
+        return addAccess(accesses, count, TRACE_ACCESS_READ, address, -1);
+    case 0x34:
+    case 0x35:
+        count = addAccess(accesses, count, TRACE_ACCESS_READ, before->hl, -1);
+        return addAccess(accesses, count, TRACE_ACCESS_WRITE, before->hl, -1);
+    case 0x36:
+        return addAccess(accesses, count, TRACE_ACCESS_WRITE, before->hl, -1);
+    case 0xD3:
+        return addAccess(accesses, count, TRACE_ACCESS_OUT, TO_WORD(a, bytes[1]), a);
+    case 0xDB:
+        return addAccess(accesses, count, TRACE_ACCESS_IN, TO_WORD(a, bytes[1]), (byte_t)(after->af >> 8));
+    case 0xE3:
+        count = addStackAccesses(before->sp, false, accesses, count);
+        return addStackAccesses((word_t)(before->sp + 2), true, accesses, count);
+    case 0xC9:
+    case 0xCD:
+        return addStackAccesses(before->sp, bytes[0] == 0xCD, accesses, count);
+    case 0xCB:
+        if((bytes[1] & 0x07) != 0x06)
+        {
+            return 0;
+        }
+        count = addAccess(accesses, count, TRACE_ACCESS_READ, before->hl, -1);
+        // BIT only reads
+        if(bytes[1] < 0x40 || bytes[1] >= 0x80)
+        {
+            count = addAccess(accesses, count, TRACE_ACCESS_WRITE, before->hl, -1);
+        }
+        return count;
+    case 0xED:
+        return decodeExtended(before, after, accesses, count);
+    case 0xDD:
+        return decodeIndexed(before, after, before->ix, accesses, count);
+    case 0xFD:
+        return decodeIndexed(before, after, before->iy, accesses, count);
+    default:
+        break;
+    }
+
+    byte_t opcode = bytes[0];
+
+    if(opcode >= 0x40 && opcode < 0x80 && opcode != 0x76)
+    {
+        if((opcode & 0x07) == 0x06)
+        {
+            return addAccess(accesses, count, TRACE_ACCESS_READ, before->hl, -1);
+        }
+        if((opcode & 0xF8) == 0x70)
+        {
+            return addAccess(accesses, count, TRACE_ACCESS_WRITE, before->hl, -1);
+        }
+    }
+    else if(opcode >= 0x80 && opcode < 0xC0 && (opcode & 0x07) == 0x06)
+    {
+        return addAccess(accesses, count, TRACE_ACCESS_READ, before->hl, -1);
+    }
+    // PUSH, RST, CALL cc / RET cc (taken if SP moved), POP
+    else if((opcode & 0xCF) == 0xC5 || (opcode & 0xC7) == 0xC7
+        || ((opcode & 0xC7) == 0xC4 && after->sp == (word_t)(before->sp - 2)))
+    {
+        return addStackAccesses(before->sp, true, accesses, count);
+    }
+    else if((opcode & 0xCF) == 0xC1 || ((opcode & 0xC7) == 0xC0 && after->sp == (word_t)(before->sp + 2)))
+    {
+        return addStackAccesses(before->sp, false, accesses, count);
+    }
+
+    return count;
+}
+
+static int decodeIndexed(const TraceRecord_t *before, const TraceRecord_t *after, word_t base,
+                         TraceAccess_t *accesses, int count)
+{
+    const byte_t *bytes = after->opcode;
+    byte_t opcode = bytes[1];
+    word_t address = (word_t)(base + (signed char)bytes[2]);
+
+    switch(opcode)
+    {
+    case 0x22:
+        count = addAccess(accesses, count, TRACE_ACCESS_WRITE, TO_WORD(bytes[3], bytes[2]), -1);
+        return addAccess(accesses, count, TRACE_ACCESS_WRITE, (word_t)(TO_WORD(bytes[3], bytes[2]) + 1), -1);
+    case 0x2A:
+        count = addAccess(accesses, count, TRACE_ACCESS_READ, TO_WORD(bytes[3], bytes[2]), -1);
+        return addAccess(accesses, count, TRACE_ACCESS_READ, (word_t)(TO_WORD(bytes[3], bytes[2]) + 1), -1);
+    case 0x34:
+    case 0x35:
+        count = addAccess(accesses, count, TRACE_ACCESS_READ, address, -1);
+        return addAccess(accesses, count, TRACE_ACCESS_WRITE, address, -1);
+    case 0x36:
+        return addAccess(accesses, count, TRACE_ACCESS_WRITE, address, -1);
+    case 0xE1:
+        return addStackAccesses(before->sp, false, accesses, count);
+    case 0xE5:
+        return addStackAccesses(before->sp, true, accesses, count);
+    case 0xE3:
+        count = addStackAccesses(before->sp, false, accesses, count);
+        return addStackAccesses((word_t)(before->sp + 2), true, accesses, count);
+    case 0xCB:
+        // DD CB d op: every operation reads (IX+d), all but BIT write it back
+        count = addAccess(accesses, count, TRACE_ACCESS_READ, address, -1);
+        if(bytes[3] < 0x40 || bytes[3] >= 0x80)
+        {
+            count = addAccess(accesses, count, TRACE_ACCESS_WRITE, address, -1);
+        }
+        return count;
+    default:
+        break;
+    }
+
+    if(opcode >= 0x40 && opcode < 0x80 && opcode != 0x76)
+    {
+        if((opcode & 0x07) == 0x06)
+        {
+            return addAccess(accesses, count, TRACE_ACCESS_READ, address, -1);
+        }
+        if((opcode & 0xF8) == 0x70)
+        {
+            return addAccess(accesses, count, TRACE_ACCESS_WRITE, address, -1);
+        }
+    }
+    else if(opcode >= 0x80 && opcode < 0xC0 && (opcode & 0x07) == 0x06)
+    {
+        return addAccess(accesses, count, TRACE_ACCESS_READ, address, -1);
+    }
+
+    return count;
+}
+
+static int decodeExtended(const TraceRecord_t *before, const TraceRecord_t *after, TraceAccess_t *accesses, int count)
+{
+    const byte_t *bytes = after->opcode;
+    byte_t opcode = bytes[1];
+    word_t address = TO_WORD(bytes[3], bytes[2]);
+
+    if((opcode & 0xC7) == 0x40)
+    {
+        return addAccess(accesses, count, TRACE_ACCESS_IN, before->bc, registerByIndex(after, (opcode >> 3) & 0x07));
+    }
+    if((opcode & 0xC7) == 0x41)
+    {
+        int value = registerByIndex(before, (opcode >> 3) & 0x07);
+        return addAccess(accesses, count, TRACE_ACCESS_OUT, before->bc, (value >= 0) ? value : 0);
+    }
+    if((opcode & 0xCF) == 0x43 || (opcode & 0xCF) == 0x4B)
+    {
+        TraceAccessKind kind = ((opcode & 0x08) != 0) ? TRACE_ACCESS_READ : TRACE_ACCESS_WRITE;
+
+        count = addAccess(accesses, count, kind, address, -1);
+        return addAccess(accesses, count, kind, (word_t)(address + 1), -1);
+    }
+    // RETN, RETI
+    if((opcode & 0xC7) == 0x45)
+    {
+        return addStackAccesses(before->sp, false, accesses, count);
+    }
+
+    switch(opcode)
+    {
+    case 0x67:
+    case 0x6F:
+        count = addAccess(accesses, count, TRACE_ACCESS_READ, before->hl, -1);
+        return addAccess(accesses, count, TRACE_ACCESS_WRITE, before->hl, -1);
+    case 0xA0:
+    case 0xA8:
+    case 0xB0:
+    case 0xB8:
+        count = addAccess(accesses, count, TRACE_ACCESS_READ, before->hl, -1);
+        return addAccess(accesses, count, TRACE_ACCESS_WRITE, before->de, -1);
+    case 0xA1:
+    case 0xA9:
+    case 0xB1:
+    case 0xB9:
+        return addAccess(accesses, count, TRACE_ACCESS_READ, before->hl, -1);
+    case 0xA2:
+    case 0xAA:
+    case 0xB2:
+    case 0xBA:
+        count = addAccess(accesses, count, TRACE_ACCESS_IN, before->bc, -1);
+        return addAccess(accesses, count, TRACE_ACCESS_WRITE, before->hl, -1);
+    case 0xA3:
+    case 0xAB:
+    case 0xB3:
+    case 0xBB:
+        // B is decremented before it goes on the bus
+        count = addAccess(accesses, count, TRACE_ACCESS_READ, before->hl, -1);
+        return addAccess(accesses, count, TRACE_ACCESS_OUT, (word_t)(before->bc - 0x0100), -1);
+    default:
+        return count;
+    }
+}
+
+static int addStackAccesses(word_t stackPointer, bool isPush, TraceAccess_t *accesses, int count)
+{
+    if(isPush == true)
+    {
+        count = addAccess(accesses, count, TRACE_ACCESS_WRITE, (word_t)(stackPointer - 1), -1);
+        return addAccess(accesses, count, TRACE_ACCESS_WRITE, (word_t)(stackPointer - 2), -1);
+    }
+
+    count = addAccess(accesses, count, TRACE_ACCESS_READ, stackPointer, -1);
+    return addAccess(accesses, count, TRACE_ACCESS_READ, (word_t)(stackPointer + 1), -1);
+}
+
+static int addAccess(TraceAccess_t *accesses, int count, TraceAccessKind kind, word_t address, int value)
+{
+    accesses[count] = (TraceAccess_t){ .kind = kind, .address = address, .value = value };
+
+    return count + 1;
+}
+
+static int registerByIndex(const TraceRecord_t *record, int index)
+{
+    switch(index)
+    {
+    case 0:
+        return record->bc >> 8;
+    case 1:
+        return record->bc & 0xFF;
+    case 2:
+        return record->de >> 8;
+    case 3:
+        return record->de & 0xFF;
+    case 4:
+        return record->hl >> 8;
+    case 5:
+        return record->hl & 0xFF;
+    case 7:
+        return record->af >> 8;
+    default:
+        return -1;
+    }
+}
+/* -------------------------------------------------------------------------- */
+
+/* -------------------------------- Conditions ------------------------------ */
+bool traceConditionParse(TraceCondition_t *condition, const char *text)
+{
+    static const struct
+    {
+        const char *symbol;
+        TraceConditionOperator operation;
+    } operators[] = {
+        { "==", TRACE_OPERATOR_EQUAL },
+        { "!=", TRACE_OPERATOR_NOT_EQUAL },
+        { "<=", TRACE_OPERATOR_LESS_EQUAL },
+        { ">=", TRACE_OPERATOR_GREATER_EQUAL },
+        { "<", TRACE_OPERATOR_LESS },
+        { ">", TRACE_OPERATOR_GREATER },
+        { "&", TRACE_OPERATOR_ANY_BITS }};
+
+    size_t nameLength = 0;
+    while((text[nameLength] >= 'a' && text[nameLength] <= 'z') || (text[nameLength] >= 'A' && text[nameLength] <= 'Z'))
+    {
+        nameLength++;
+    }
+
+    bool isFieldKnown = false;
+    for(int field = 0; field < TRACE_FIELD_COUNT; field++)
+    {
+        if(strlen(fieldNames[field]) == nameLength && strncmp(fieldNames[field], text, nameLength) == 0)
+        {
+            condition->field = (TraceConditionField)field;
+            isFieldKnown = true;
+            break;
+        }
+    }
+    if(isFieldKnown == false)
+    {
+        return false;
+    }
+
+    const char *cursor = text + nameLength;
+    bool isOperatorKnown = false;
+    for(size_t idx = 0; idx < sizeof(operators) / sizeof(operators[0]); idx++)
+    {
+        size_t length = strlen(operators[idx].symbol);
+
+        if(strncmp(cursor, operators[idx].symbol, length) == 0)
+        {
+            condition->operation = operators[idx].operation;
+            cursor += length;
+            isOperatorKnown = true;
+            break;
+        }
+    }
+
+    char *end;
+    condition->value = (qword_t)strtoull(cursor, &end, 0);
+    if(isOperatorKnown == false || end == cursor || *end != '\0')
+    {
+        return false;
+    }
+
+    snprintf(condition->text, sizeof(condition->text), "%s", text);
+
+    return true;
+}
+
+bool traceConditionMatchesRecord(const TraceCondition_t *condition, const TraceRecord_t *record)
+{
+    return compareValue(condition->operation, fieldValue(record, condition->field), condition->value);
+}
+
+bool traceConditionMatchesAccess(const TraceCondition_t *condition, const TraceAccess_t *access)
+{
+    static const TraceConditionField accessFields[TRACE_ACCESS_KIND_COUNT] = {
+        TRACE_FIELD_READ, TRACE_FIELD_WRITE, TRACE_FIELD_IN, TRACE_FIELD_OUT};
+
+    if(condition->field != accessFields[access->kind])
+    {
+        return false;
+    }
+
+    bool isPort = access->kind == TRACE_ACCESS_IN || access->kind == TRACE_ACCESS_OUT;
+
+    return compareValue(condition->operation, isPort ? (access->address & 0xFF) : access->address, condition->value);
+}
+
+static qword_t fieldValue(const TraceRecord_t *record, TraceConditionField field)
+{
+    switch(field)
+    {
+    case TRACE_FIELD_A:
+        return record->af >> 8;
+    case TRACE_FIELD_F:
+        return record->af & 0xFF;
+    case TRACE_FIELD_B:
+        return record->bc >> 8;
+    case TRACE_FIELD_C:
+        return record->bc & 0xFF;
+    case TRACE_FIELD_D:
+        return record->de >> 8;
+    case TRACE_FIELD_E:
+        return record->de & 0xFF;
+    case TRACE_FIELD_H:
+        return record->hl >> 8;
+    case TRACE_FIELD_L:
+        return record->hl & 0xFF;
+    case TRACE_FIELD_AF:
+        return record->af;
+    case TRACE_FIELD_BC:
+        return record->bc;
+    case TRACE_FIELD_DE:
+        return record->de;
+    case TRACE_FIELD_HL:
+        return record->hl;
+    case TRACE_FIELD_SP:
+        return record->sp;
+    case TRACE_FIELD_IX:
+        return record->ix;
+    case TRACE_FIELD_IY:
+        return record->iy;
+    case TRACE_FIELD_PC:
+        return record->pc;
+    case TRACE_FIELD_I:
+        return record->i;
+    case TRACE_FIELD_R:
+        return record->r;
+    case TRACE_FIELD_CYCLE:
+        return record->cycle;
+    default:
+        return 0;
+    }
+}
+
+static bool compareValue(TraceConditionOperator operation, qword_t value, qword_t reference)
+{
+    switch(operation)
+    {
+    case TRACE_OPERATOR_EQUAL:
+        return value == reference;
+    case TRACE_OPERATOR_NOT_EQUAL:
+        return value != reference;
+    case TRACE_OPERATOR_LESS:
+        return value < reference;
+    case TRACE_OPERATOR_LESS_EQUAL:
+        return value <= reference;
+    case TRACE_OPERATOR_GREATER:
+        return value > reference;
+    case TRACE_OPERATOR_GREATER_EQUAL:
+        return value >= reference;
+    case TRACE_OPERATOR_ANY_BITS:
+        return (value & reference) != 0;
+    default:
+        return false;
+    }
+}
+/* -------------------------------------------------------------------------- */
+
+/* ---------------------------------- Output -------------------------------- */
+void traceAnalysisDump(FILE *stream, const TraceAnalysis_t *analysis, const TraceAnalysisOptions_t *options,
+                       size_t rows, const SymbolTable_t *symbols)
+{
+    RankedCount_t *ranked = (RankedCount_t *)malloc(0x10000 * sizeof(RankedCount_t));
+    qword_t *memory = (qword_t *)malloc(0x10000 * sizeof(qword_t));
+    char location[SYMBOL_MAX_NAME + 16];
+
+    if(ranked == NULL || memory == NULL)
+    {
+        free(ranked);
+        free(memory);
+        return;
+    }
+
+    opcodeProfileDump(stream, &analysis->opcodes, rows);
+
+    double instructions = (analysis->opcodes.instructions > 0) ? (double)analysis->opcodes.instructions : 1.0;
+    double totalCycles = (analysis->opcodes.totalCycles > 0) ? (double)analysis->opcodes.totalCycles : 1.0;
+
+    fprintf(stream, "\n%-6s %-24s %14s %7s %14s %7s\n", "pc", "location", "count", "%", "cycles", "% cyc");
+    size_t count = rankCounts(analysis->pcCounts, 0x10000, ranked);
+    for(size_t idx = 0; idx < count && idx < rows; idx++)
+    {
+        word_t pc = (word_t)ranked[idx].index;
+
+        fprintf(stream, "0x%04X %-24s %14llu %6.2f%% %14llu %6.2f%%\n", (unsigned int)pc,
+                formatLocation(symbols, pc, location, sizeof(location)),
+                (unsigned long long)analysis->pcCounts[pc], (double)analysis->pcCounts[pc] / instructions * 100.0,
+                (unsigned long long)analysis->pcCycles[pc], (double)analysis->pcCycles[pc] / totalCycles * 100.0);
+    }
+
+    fprintf(stream, "\n");
+    dumpHeatmap(stream, "memory reads", analysis->accesses[TRACE_ACCESS_READ]);
+    fprintf(stream, "\n");
+    dumpHeatmap(stream, "memory writes", analysis->accesses[TRACE_ACCESS_WRITE]);
+
+    for(size_t idx = 0; idx < 0x10000; idx++)
+    {
+        memory[idx] = analysis->accesses[TRACE_ACCESS_READ][idx] + analysis->accesses[TRACE_ACCESS_WRITE][idx];
+    }
+
+    fprintf(stream, "\n%-7s %-24s %14s %14s\n", "address", "location", "reads", "writes");
+    count = rankCounts(memory, 0x10000, ranked);
+    for(size_t idx = 0; idx < count && idx < rows; idx++)
+    {
+        word_t address = (word_t)ranked[idx].index;
+
+        fprintf(stream, "0x%04X  %-24s %14llu %14llu\n", (unsigned int)address,
+                formatLocation(symbols, address, location, sizeof(location)),
+                (unsigned long long)analysis->accesses[TRACE_ACCESS_READ][address],
+                (unsigned long long)analysis->accesses[TRACE_ACCESS_WRITE][address]);
+    }
+
+    fprintf(stream, "\n%-7s %14s %14s\n", "port", "in", "out");
+    for(size_t port = 0; port < 0x100; port++)
+    {
+        qword_t inputs = analysis->accesses[TRACE_ACCESS_IN][port];
+        qword_t outputs = analysis->accesses[TRACE_ACCESS_OUT][port];
+
+        if(inputs > 0 || outputs > 0)
+        {
+            fprintf(stream, "0x%02X    %14llu %14llu\n", (unsigned int)port, (unsigned long long)inputs,
+                    (unsigned long long)outputs);
+        }
+    }
+
+    if(analysis->eventCount > 0)
+    {
+        fprintf(stream, "\n%14s %14s %-6s %-4s %-6s %s\n", "record", "cycle", "pc", "dir", "port", "value");
+        for(size_t idx = 0; idx < analysis->eventCount; idx++)
+        {
+            const TraceIoEvent_t *event = &analysis->events[idx];
+            char value[8] = "?";
+
+            if(event->value >= 0)
+            {
+                snprintf(value, sizeof(value), "0x%02X", (unsigned int)(event->value & 0xFF));
+            }
+
+            fprintf(stream, "%14llu %14llu 0x%04X %-4s 0x%04X %s\n", (unsigned long long)event->record,
+                    (unsigned long long)event->cycle, (unsigned int)event->pc, event->isOutput ? "out" : "in",
+                    (unsigned int)event->port, value);
+        }
+    }
+
+    if(options->conditionCount > 0)
+    {
+        fprintf(stream, "\n");
+    }
+    for(size_t idx = 0; idx < options->conditionCount; idx++)
+    {
+        const TraceMatch_t *match = &analysis->matches[idx];
+
+        if(match->isFound == true)
+        {
+            fprintf(stream, "%-20s record %llu, pc 0x%04X (%s), cycle %llu\n", options->conditions[idx].text,
+                    (unsigned long long)match->record, (unsigned int)match->pc,
+                    formatLocation(symbols, match->pc, location, sizeof(location)),
+                    (unsigned long long)match->cycle);
+        }
+        else
+        {
+            fprintf(stream, "%-20s not found\n", options->conditions[idx].text);
+        }
+    }
+
+    free(ranked);
+    free(memory);
+}
+
+static void dumpHeatmap(FILE *stream, const char *title, const qword_t *counts)
+{
+    static const char shades[] = HEATMAP_SHADES;
+    qword_t pages[0x100];
+    qword_t maximum = 0;
+
+    memset(pages, 0x00, sizeof(pages));
+    for(size_t idx = 0; idx < 0x10000; idx++)
+    {
+        pages[idx >> 8] += counts[idx];
+    }
+    for(size_t page = 0; page < 0x100; page++)
+    {
+        maximum = (pages[page] > maximum) ? pages[page] : maximum;
+    }
+
+    // Powers of two of the busiest page spread over the visible shades
+    size_t scale = (maximum > 1) ? bitLength(maximum) - 1 : 1;
+
+    fprintf(stream, "%s per 256 byte page (log scale, '%c' = %llu)\n", title, shades[sizeof(shades) - 2],
+            (unsigned long long)maximum);
+    fprintf(stream, "        0 1 2 3 4 5 6 7 8 9 A B C D E F\n");
+
+    for(size_t row = 0; row < 0x10; row++)
+    {
+        fprintf(stream, "0x%X000 ", (unsigned int)row);
+        for(size_t column = 0; column < 0x10; column++)
+        {
+            qword_t value = pages[row * 0x10 + column];
+            size_t shade = 0;
+
+            if(value > 0 && maximum > 0)
+            {
+                // Anything accessed is at least the lightest visible shade
+                shade = 1 + (bitLength(value) - 1) * (sizeof(shades) - 3) / scale;
+            }
+            fprintf(stream, " %c", shades[shade]);
+        }
+        fprintf(stream, "\n");
+    }
+}
+
+static size_t rankCounts(const qword_t *counts, size_t size, RankedCount_t *ranked)
+{
+    size_t count = 0;
+
+    for(size_t idx = 0; idx < size; idx++)
+    {
+        if(counts[idx] > 0)
+        {
+            ranked[count].index = (dword_t)idx;
+            ranked[count].count = counts[idx];
+            count++;
+        }
+    }
+
+    qsort(ranked, count, sizeof(RankedCount_t), compareRanked);
+
+    return count;
+}
+
+static const char *formatLocation(const SymbolTable_t *symbols, word_t address, char *buffer, size_t bufferSize)
+{
+    const Symbol_t *symbol = (symbols != NULL) ? symbolTableLookup(symbols, address) : NULL;
+
+    if(symbol == NULL)
+    {
+        snprintf(buffer, bufferSize, "-");
+    }
+    else if(symbol->address == address)
+    {
+        snprintf(buffer, bufferSize, "%s", symbol->name);
+    }
+    else
+    {
+        snprintf(buffer, bufferSize, "%s+0x%X", symbol->name, (unsigned int)(address - symbol->address));
+    }
+
+    return buffer;
+}
+
+static int compareRanked(const void *first, const void *second)
+{
+    const RankedCount_t *a = (const RankedCount_t *)first;
+    const RankedCount_t *b = (const RankedCount_t *)second;
+
+    if(a->count != b->count)
+    {
+        return (a->count > b->count) ? -1 : 1;
+    }
+
+    return (a->index < b->index) ? -1 : (a->index > b->index) ? 1 : 0;
+}
+static size_t bitLength(qword_t value)
+{
+    size_t length = 0;
+
+    while(value != 0)
+    {
+        value >>= 1;
+        length++;
+    }
+
+    return length;
+}
+/* -------------------------------------------------------------------------- */
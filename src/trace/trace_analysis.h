@@ -0,0 +1,253 @@
+#ifndef CILOGC80_TRACE_ANALYSIS_H
+#define CILOGC80_TRACE_ANALYSIS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "utils/utils.h"
+#include "cpu/opcode_profile.h"
+#include "emulator/symbol_table.h"
+#include "trace/trace_file.h"
+
+/** @brief Memory and port accesses one instruction can make (EX (SP),HL: two reads, two writes) */
+#define TRACE_MAX_ACCESSES 4
+/** @brief Search conditions evaluated in one pass */
+#define TRACE_MAX_CONDITIONS 8
+/** @brief Default number of I/O events kept for the timeline */
+#define TRACE_DEFAULT_TIMELINE_EVENTS 32
+/** @brief Chunks per worker, more chunks balance better, fewer lose fewer opcode pairs at the seams */
+#define TRACE_CHUNKS_PER_WORKER 8
+
+/**
+ * @brief Enum struct for defining the kinds of accesses derived from a trace
+ */
+typedef enum TraceAccessKind
+{
+    TRACE_ACCESS_READ = 0,
+    TRACE_ACCESS_WRITE,
+    TRACE_ACCESS_IN,
+    TRACE_ACCESS_OUT,
+    TRACE_ACCESS_KIND_COUNT
+} TraceAccessKind;
+
+/**
+ * @brief Memory or port access of an instruction
+ */
+typedef struct TraceAccess_t
+{
+    TraceAccessKind kind;
+    /** @brief Memory address, or the 16 bit port address put on the bus */
+    word_t address;
+    /** @brief Byte transferred by IN / OUT, -1 if the trace does not tell */
+    int value;
+} TraceAccess_t;
+
+/**
+ * @brief Enum struct for defining what a search condition looks at
+ */
+typedef enum TraceConditionField
+{
+    TRACE_FIELD_A = 0,
+    TRACE_FIELD_F,
+    TRACE_FIELD_B,
+    TRACE_FIELD_C,
+    TRACE_FIELD_D,
+    TRACE_FIELD_E,
+    TRACE_FIELD_H,
+    TRACE_FIELD_L,
+    TRACE_FIELD_AF,
+    TRACE_FIELD_BC,
+    TRACE_FIELD_DE,
+    TRACE_FIELD_HL,
+    TRACE_FIELD_SP,
+    TRACE_FIELD_IX,
+    TRACE_FIELD_IY,
+    TRACE_FIELD_PC,
+    TRACE_FIELD_I,
+    TRACE_FIELD_R,
+    TRACE_FIELD_CYCLE,
+    /** @brief Address of a memory read / write, low byte of the port of an IN / OUT */
+    TRACE_FIELD_READ,
+    TRACE_FIELD_WRITE,
+    TRACE_FIELD_IN,
+    TRACE_FIELD_OUT,
+    TRACE_FIELD_COUNT
+} TraceConditionField;
+
+/**
+ * @brief Enum struct for defining the comparisons of a search condition
+ */
+typedef enum TraceConditionOperator
+{
+    TRACE_OPERATOR_EQUAL = 0,
+    TRACE_OPERATOR_NOT_EQUAL,
+    TRACE_OPERATOR_LESS,
+    TRACE_OPERATOR_LESS_EQUAL,
+    TRACE_OPERATOR_GREATER,
+    TRACE_OPERATOR_GREATER_EQUAL,
+    /** @brief Any of the bits of the value set */
+    TRACE_OPERATOR_ANY_BITS
+} TraceConditionOperator;
+
+/**
+ * @brief Search condition, "hl==0x8000", "a>=0x80", "write==0xC000", "out==0x01"
+ */
+typedef struct TraceCondition_t
+{
+    TraceConditionField field;
+    TraceConditionOperator operation;
+    qword_t value;
+    /** @brief Text the condition was parsed from */
+    char text[48];
+} TraceCondition_t;
+
+/**
+ * @brief First record satisfying a condition
+ */
+typedef struct TraceMatch_t
+{
+    bool isFound;
+    qword_t record;
+    qword_t cycle;
+    word_t pc;
+} TraceMatch_t;
+
+/**
+ * @brief IN or OUT on the timeline
+ */
+typedef struct TraceIoEvent_t
+{
+    qword_t record;
+    /** @brief Cycle counter after the instruction */
+    qword_t cycle;
+    word_t pc;
+    word_t port;
+    /** @brief -1 if unknown (block I/O) */
+    int value;
+    bool isOutput;
+} TraceIoEvent_t;
+
+/**
+ * @brief Results of a trace analysis, or the part of them collected by one worker
+ */
+typedef struct TraceAnalysis_t
+{
+    /** @brief Opcode histogram and pairs (pairs crossing chunk seams are not counted) */
+    OpcodeProfile_t opcodes;
+
+    qword_t pcCounts[0x10000];
+    qword_t pcCycles[0x10000];
+
+    /** @brief Accesses per memory address (reads, writes) and per port low byte (IN, OUT) */
+    qword_t accesses[TRACE_ACCESS_KIND_COUNT][0x10000];
+
+    /** @brief First I/O events in trace order */
+    TraceIoEvent_t *events;
+    size_t eventCount;
+
+    TraceMatch_t matches[TRACE_MAX_CONDITIONS];
+} TraceAnalysis_t;
+
+/**
+ * @brief What to look for
+ */
+typedef struct TraceAnalysisOptions_t
+{
+    /** @brief Worker threads, 0 for one per logical processor */
+    int workerCount;
+    /** @brief I/O events kept for the timeline */
+    size_t timelineEvents;
+
+    TraceCondition_t conditions[TRACE_MAX_CONDITIONS];
+    size_t conditionCount;
+} TraceAnalysisOptions_t;
+
+/**
+ * @brief Derives the memory and port accesses of an instruction from the registers before
+ * it (the previous record) and its bytes. Covers every documented Z80 instruction, the
+ * data of memory accesses is not in the trace
+ *
+ * @param before Record of the previous instruction
+ * @param after Record of the instruction
+ * @param accesses TRACE_MAX_ACCESSES entries
+ * @return int Number of accesses
+ */
+int traceDecodeAccesses(const TraceRecord_t *before, const TraceRecord_t *after, TraceAccess_t *accesses);
+
+/**
+ * @brief Parses "<field><operator><value>": fields a f b c d e h l af bc de hl sp ix iy pc i r
+ * cycle read write in out, operators == != < <= > >= &, values in C notation
+ *
+ * @param condition
+ * @param text
+ * @return bool False if the text is not a condition
+ */
+bool traceConditionParse(TraceCondition_t *condition, const char *text);
+
+/**
+ * @brief Tests a register condition against the state after a record. Access conditions
+ * (read, write, in, out) are tested by @ref traceConditionMatchesAccess
+ *
+ * @param condition
+ * @param record
+ * @return bool
+ */
+bool traceConditionMatchesRecord(const TraceCondition_t *condition, const TraceRecord_t *record);
+
+/**
+ * @brief Tests an access condition against an access
+ *
+ * @param condition
+ * @param access
+ * @return bool
+ */
+bool traceConditionMatchesAccess(const TraceCondition_t *condition, const TraceAccess_t *access);
+
+/**
+ * @brief Allocates an empty analysis
+ *
+ * @return TraceAnalysis_t* NULL if out of memory
+ */
+TraceAnalysis_t *traceAnalysisCreate();
+
+/**
+ * @brief Frees an analysis
+ *
+ * @param analysis
+ */
+void traceAnalysisDestroy(TraceAnalysis_t *analysis);
+
+/**
+ * @brief Adds the counters and matches of another analysis (not its events)
+ *
+ * @param analysis
+ * @param other
+ */
+void traceAnalysisMerge(TraceAnalysis_t *analysis, const TraceAnalysis_t *other);
+
+/**
+ * @brief Analyzes a trace file. The blocks are split into chunks at keyframes, workers decode
+ * and count chunks in parallel with their own cursor and counters, which are merged at the end
+ *
+ * @param file
+ * @param options
+ * @param analysis Empty analysis, receives the results
+ * @return bool False if out of memory, the workers could not be started or the file is damaged
+ */
+bool traceAnalyze(const TraceFile_t *file, const TraceAnalysisOptions_t *options, TraceAnalysis_t *analysis);
+
+/**
+ * @brief Prints the opcode histogram, hot PCs, memory heatmap, port summary, I/O timeline
+ * and search results
+ *
+ * @param stream
+ * @param analysis
+ * @param options Conditions the analysis searched for
+ * @param rows Rows of the ranked tables
+ * @param symbols NULL if no symbols are loaded
+ */
+void traceAnalysisDump(FILE *stream, const TraceAnalysis_t *analysis, const TraceAnalysisOptions_t *options,
+                       size_t rows, const SymbolTable_t *symbols);
+
+#endif // CILOGC80_TRACE_ANALYSIS_H
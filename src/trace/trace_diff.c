@@ -0,0 +1,265 @@
+#include "trace/trace_diff.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * @brief Field of a record shown by the dump
+ */
+typedef struct TraceDiffField_t
+{
+    const char *name;
+    size_t offset;
+    /** @brief 8 cycle counter, 4 instruction bytes, 2 register pair, 1 byte */
+    size_t size;
+} TraceDiffField_t;
+
+/**
+ * @brief Reads one record of a trace
+ *
+ * @param cursor
+ * @param recordNumber
+ * @param record
+ * @return bool False if the record does not exist or the trace is damaged
+ */
+static bool readRecord(TraceCursor_t *cursor, qword_t recordNumber, TraceRecord_t *record);
+
+/**
+ * @brief Formats a field of a record
+ *
+ * @param field
+ * @param record
+ * @param buffer
+ * @param bufferSize
+ * @return const char* buffer
+ */
+static const char *formatField(const TraceDiffField_t *field, const TraceRecord_t *record, char *buffer,
+                               size_t bufferSize);
+
+/**
+ * @brief Formats an address with the symbol it belongs to ("main+0x12")
+ *
+ * @param symbols NULL if no symbols are loaded
+ * @param address
+ * @param buffer
+ * @param bufferSize
+ * @return const char* buffer
+ */
+static const char *formatLocation(const SymbolTable_t *symbols, word_t address, char *buffer, size_t bufferSize);
+
+static const TraceDiffField_t diffFields[] = {
+    { "cycle", offsetof(TraceRecord_t, cycle), 8 },
+    { "pc", offsetof(TraceRecord_t, pc), 2 },
+    { "opcode", offsetof(TraceRecord_t, opcode), 4 },
+    { "af", offsetof(TraceRecord_t, af), 2 },
+    { "bc", offsetof(TraceRecord_t, bc), 2 },
+    { "de", offsetof(TraceRecord_t, de), 2 },
+    { "hl", offsetof(TraceRecord_t, hl), 2 },
+    { "sp", offsetof(TraceRecord_t, sp), 2 },
+    { "ix", offsetof(TraceRecord_t, ix), 2 },
+    { "iy", offsetof(TraceRecord_t, iy), 2 },
+    { "af'", offsetof(TraceRecord_t, afShadow), 2 },
+    { "bc'", offsetof(TraceRecord_t, bcShadow), 2 },
+    { "de'", offsetof(TraceRecord_t, deShadow), 2 },
+    { "hl'", offsetof(TraceRecord_t, hlShadow), 2 },
+    { "i", offsetof(TraceRecord_t, i), 1 },
+    { "r", offsetof(TraceRecord_t, r), 1 },
+    { "im", offsetof(TraceRecord_t, interruptMode), 1 },
+    { "flags", offsetof(TraceRecord_t, flags), 1 }};
+
+bool traceRecordEqual(const TraceRecord_t *first, const TraceRecord_t *second)
+{
+    // Every field is naturally aligned, the record has no padding
+    return memcmp(first, second, sizeof(TraceRecord_t)) == 0;
+}
+
+bool traceDiffFind(const TraceFile_t *first, const TraceFile_t *second, TraceDivergence_t *divergence)
+{
+    TraceRecord_t firstRecord;
+    TraceRecord_t secondRecord;
+    bool isGood = true;
+
+    memset(divergence, 0x00, sizeof(TraceDivergence_t));
+    divergence->firstCount = first->recordCount;
+    divergence->secondCount = second->recordCount;
+
+    qword_t common = (first->recordCount < second->recordCount) ? first->recordCount : second->recordCount;
+
+    TraceCursor_t *firstCursor = traceCursorCreate(first);
+    TraceCursor_t *secondCursor = traceCursorCreate(second);
+    if(firstCursor == NULL || secondCursor == NULL)
+    {
+        traceCursorDestroy(firstCursor);
+        traceCursorDestroy(secondCursor);
+        return false;
+    }
+
+    // Keyframes of the first trace inside the common part, probe 0 is record 0
+    size_t probeCount = (common > 0) ? traceFileFindBlock(first, common - 1) + 1 : 0;
+    size_t low = 0;
+    size_t high = probeCount;
+
+    while(isGood == true && low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        qword_t number = first->index[middle].firstRecord;
+
+        isGood = readRecord(firstCursor, number, &firstRecord) == true
+            && readRecord(secondCursor, number, &secondRecord) == true;
+        divergence->probes++;
+
+        if(traceRecordEqual(&firstRecord, &secondRecord) == true)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    // Lockstep from the last agreeing keyframe, the first disagreeing one bounds the window
+    qword_t start = (low > 0) ? first->index[low - 1].firstRecord : 0;
+    qword_t end = (low < probeCount) ? first->index[low].firstRecord + 1 : common;
+
+    if(isGood == true && start < end)
+    {
+        isGood = traceCursorSeek(firstCursor, start) == true && traceCursorSeek(secondCursor, start) == true;
+    }
+
+    for(qword_t number = start; isGood == true && number < end; number++)
+    {
+        isGood = traceCursorNext(firstCursor, &firstRecord) == true
+            && traceCursorNext(secondCursor, &secondRecord) == true;
+        divergence->recordsCompared++;
+
+        if(isGood == true && traceRecordEqual(&firstRecord, &secondRecord) == false)
+        {
+            divergence->isDiverged = true;
+            divergence->record = number;
+            divergence->first = firstRecord;
+            divergence->second = secondRecord;
+            break;
+        }
+
+        divergence->previous = firstRecord;
+        divergence->hasPrevious = true;
+    }
+
+    if(isGood == true && divergence->isDiverged == false && first->recordCount != second->recordCount)
+    {
+        divergence->isDiverged = true;
+        divergence->isLengthDifferent = true;
+        divergence->record = common;
+    }
+
+    traceCursorDestroy(firstCursor);
+    traceCursorDestroy(secondCursor);
+
+    return isGood;
+}
+
+void traceDiffDump(FILE *stream, const TraceDivergence_t *divergence, const SymbolTable_t *symbols)
+{
+    char location[SYMBOL_MAX_NAME + 16];
+
+    if(divergence->isDiverged == false)
+    {
+        fprintf(stream, "identical: %llu records\n", (unsigned long long)divergence->firstCount);
+        return;
+    }
+
+    if(divergence->isLengthDifferent == true)
+    {
+        fprintf(stream, "the traces agree on all %llu common records, first has %llu, second %llu\n",
+                (unsigned long long)divergence->record, (unsigned long long)divergence->firstCount,
+                (unsigned long long)divergence->secondCount);
+    }
+    else
+    {
+        fprintf(stream, "first divergence at record %llu, pc 0x%04X (%s)\n", (unsigned long long)divergence->record,
+                (unsigned int)divergence->first.pc,
+                formatLocation(symbols, divergence->first.pc, location, sizeof(location)));
+    }
+    fprintf(stream, "found with %llu keyframe probes and %llu records compared in lockstep\n",
+            (unsigned long long)divergence->probes, (unsigned long long)divergence->recordsCompared);
+
+    if(divergence->isLengthDifferent == true)
+    {
+        return;
+    }
+
+    fprintf(stream, "\n");
+    traceRecordDumpDiff(stream, "first", "second", (divergence->hasPrevious == true) ? &divergence->previous : NULL,
+                        &divergence->first, &divergence->second);
+}
+
+void traceRecordDumpDiff(FILE *stream, const char *firstLabel, const char *secondLabel,
+                         const TraceRecord_t *previous, const TraceRecord_t *first, const TraceRecord_t *second)
+{
+    char previousText[32];
+    char firstText[32];
+    char secondText[32];
+
+    fprintf(stream, "  %-8s %-20s %-20s %-20s\n", "field", "before", firstLabel, secondLabel);
+    for(size_t idx = 0; idx < sizeof(diffFields) / sizeof(diffFields[0]); idx++)
+    {
+        const TraceDiffField_t *field = &diffFields[idx];
+        bool isDifferent = memcmp((const byte_t *)first + field->offset, (const byte_t *)second + field->offset,
+                                  field->size) != 0;
+
+        fprintf(stream, "%c %-8s %-20s %-20s %-20s\n", isDifferent ? '*' : ' ', field->name,
+                (previous != NULL) ? formatField(field, previous, previousText, sizeof(previousText)) : "-",
+                formatField(field, first, firstText, sizeof(firstText)),
+                formatField(field, second, secondText, sizeof(secondText)));
+    }
+}
+
+static bool readRecord(TraceCursor_t *cursor, qword_t recordNumber, TraceRecord_t *record)
+{
+    return traceCursorSeek(cursor, recordNumber) == true && traceCursorNext(cursor, record) == true;
+}
+
+static const char *formatField(const TraceDiffField_t *field, const TraceRecord_t *record, char *buffer,
+                               size_t bufferSize)
+{
+    const byte_t *value = (const byte_t *)record + field->offset;
+
+    switch(field->size)
+    {
+    case 8:
+        snprintf(buffer, bufferSize, "%llu", (unsigned long long)record->cycle);
+        break;
+    case 4:
+        snprintf(buffer, bufferSize, "%02X %02X %02X %02X", value[0], value[1], value[2], value[3]);
+        break;
+    case 2:
+        snprintf(buffer, bufferSize, "0x%04X", (unsigned int)*(const word_t *)value);
+        break;
+    default:
+        snprintf(buffer, bufferSize, "0x%02X", (unsigned int)value[0]);
+        break;
+    }
+
+    return buffer;
+}
+
+static const char *formatLocation(const SymbolTable_t *symbols, word_t address, char *buffer, size_t bufferSize)
+{
+    const Symbol_t *symbol = (symbols != NULL) ? symbolTableLookup(symbols, address) : NULL;
+
+    if(symbol == NULL)
+    {
+        snprintf(buffer, bufferSize, "-");
+    }
+    else if(symbol->address == address)
+    {
+        snprintf(buffer, bufferSize, "%s", symbol->name);
+    }
+    else
+    {
+        snprintf(buffer, bufferSize, "%s+0x%X", symbol->name, (unsigned int)(address - symbol->address));
+    }
+
+    return buffer;
+}
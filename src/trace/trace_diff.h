@@ -0,0 +1,86 @@
+#ifndef CILOGC80_TRACE_DIFF_H
+#define CILOGC80_TRACE_DIFF_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "utils/utils.h"
+#include "emulator/symbol_table.h"
+#include "trace/trace_file.h"
+
+/**
+ * @brief First difference between two traces
+ */
+typedef struct TraceDivergence_t
+{
+    /** @brief False if the traces are identical */
+    bool isDiverged;
+    /** @brief The records agree but one trace is longer, record is the end of the shorter one */
+    bool isLengthDifferent;
+
+    /** @brief Number of the first differing record */
+    qword_t record;
+    TraceRecord_t first;
+    TraceRecord_t second;
+
+    /** @brief Last record both traces agree on, valid if hasPrevious */
+    bool hasPrevious;
+    TraceRecord_t previous;
+
+    /** @brief Records of the two traces */
+    qword_t firstCount;
+    qword_t secondCount;
+
+    /** @brief Keyframes compared by the bisection */
+    qword_t probes;
+    /** @brief Records compared in lockstep inside the divergent window */
+    qword_t recordsCompared;
+} TraceDivergence_t;
+
+/**
+ * @brief Returns whether two records are equal in every field
+ *
+ * @param first
+ * @param second
+ * @return bool
+ */
+bool traceRecordEqual(const TraceRecord_t *first, const TraceRecord_t *second);
+
+/**
+ * @brief Prints two records field by field next to the record before them, fields that
+ * differ are marked with '*'
+ *
+ * @param stream
+ * @param firstLabel Column title of first
+ * @param secondLabel Column title of second
+ * @param previous NULL if there is no record before
+ * @param first
+ * @param second
+ */
+void traceRecordDumpDiff(FILE *stream, const char *firstLabel, const char *secondLabel,
+                         const TraceRecord_t *previous, const TraceRecord_t *first, const TraceRecord_t *second);
+
+/**
+ * @brief Finds the first record two traces differ in. Bisects over the keyframes of the
+ * first trace (the periodic snapshots of both runs) for the last one both agree on, then
+ * decodes both traces in lockstep from there up to the first disagreeing keyframe. Decodes
+ * O(log blocks) keyframes and at most two blocks of records. Assumes runs that diverged do
+ * not meet again at a keyframe, which the cycle counter in every record makes all but certain
+ *
+ * @param first
+ * @param second
+ * @param divergence
+ * @return bool False if out of memory or a trace is damaged
+ */
+bool traceDiffFind(const TraceFile_t *first, const TraceFile_t *second, TraceDivergence_t *divergence);
+
+/**
+ * @brief Prints the divergence: the last common record and the fields that differ
+ *
+ * @param stream
+ * @param divergence
+ * @param symbols NULL if no symbols are loaded
+ */
+void traceDiffDump(FILE *stream, const TraceDivergence_t *divergence, const SymbolTable_t *symbols);
+
+#endif // CILOGC80_TRACE_DIFF_H
@@ -0,0 +1,860 @@
+#include "trace/trace_file.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils/error_handler.h"
+
+/*
+ * Delta record layout, every field relative to the previous record of the block:
+ *
+ *   control byte     bits 0-3: instruction bytes that differ from the code cache
+ *                    bit 4: PC is not the cached successor of the previous PC
+ *                    bit 5: cycles differ from those cached for the PC
+ *                    bit 6: register mask follows
+ *   PC               zigzag varint of the PC difference (bit 4)
+ *   instruction      one raw byte per bit 0-3
+ *   cycles           varint of the cycle difference (bit 5)
+ *   register mask    varint, bit n set if field n of registerFields changed (bit 6)
+ *   registers        zigzag varint of the difference per changed word, raw changed bytes
+ */
+#define CONTROL_OPCODE_MASK 0x0F
+#define CONTROL_PC 0x10
+#define CONTROL_CYCLES 0x20
+#define CONTROL_REGISTERS 0x40
+
+/** @brief Largest encoded delta record: control, PC, bytes, cycles, mask, 11 words, 4 bytes */
+#define MAX_DELTA_SIZE (1 + 3 + TRACE_OPCODE_BYTES + 10 + 3 + 11 * 3 + 4)
+
+/** @brief Index and header offsets are aligned so the index can be used in place */
+#define INDEX_ALIGNMENT 8
+
+/**
+ * @brief Register field of a record
+ */
+typedef struct RegisterField_t
+{
+    size_t offset;
+    bool isWord;
+} RegisterField_t;
+
+/** @brief Fields covered by the register mask, the most often changed first so the mask stays one byte */
+static const RegisterField_t registerFields[] =
+{
+    { offsetof(TraceRecord_t, af), true },
+    { offsetof(TraceRecord_t, hl), true },
+    { offsetof(TraceRecord_t, bc), true },
+    { offsetof(TraceRecord_t, de), true },
+    { offsetof(TraceRecord_t, sp), true },
+    { offsetof(TraceRecord_t, ix), true },
+    { offsetof(TraceRecord_t, iy), true },
+    { offsetof(TraceRecord_t, afShadow), true },
+    { offsetof(TraceRecord_t, bcShadow), true },
+    { offsetof(TraceRecord_t, deShadow), true },
+    { offsetof(TraceRecord_t, hlShadow), true },
+    { offsetof(TraceRecord_t, i), false },
+    { offsetof(TraceRecord_t, r), false },
+    { offsetof(TraceRecord_t, flags), false },
+    { offsetof(TraceRecord_t, interruptMode), false }
+};
+
+#define REGISTER_FIELD_COUNT (sizeof(registerFields) / sizeof(registerFields[0]))
+
+/**
+ * @brief Invalidates the cache, called at every keyframe
+ *
+ * @param cache
+ */
+static void cacheReset(TraceCodeCache_t *cache);
+
+/**
+ * @brief Remembers the instruction bytes of a record
+ *
+ * @param cache
+ * @param record
+ */
+static void cacheStoreBytes(TraceCodeCache_t *cache, const TraceRecord_t *record);
+
+/**
+ * @brief Delta encodes a record
+ *
+ * @param cache Updated
+ * @param previous
+ * @param record
+ * @param out At least MAX_DELTA_SIZE bytes
+ * @return size_t Bytes written
+ */
+static size_t encodeRecord(TraceCodeCache_t *cache, const TraceRecord_t *previous, const TraceRecord_t *record,
+                           byte_t *out);
+
+/**
+ * @brief Decodes a delta record
+ *
+ * @param cache Updated
+ * @param previous
+ * @param position Advanced past the record
+ * @param end
+ * @param record
+ * @return bool False if the record runs past end
+ */
+static bool decodeRecord(TraceCodeCache_t *cache, const TraceRecord_t *previous, const byte_t **position,
+                         const byte_t *end, TraceRecord_t *record);
+
+/**
+ * @brief Writes the current block and adds it to the index
+ *
+ * @param writer
+ * @return bool
+ */
+static bool flushBlock(TraceFileWriter_t *writer);
+
+/**
+ * @brief Writes to the stream and advances the offset, clears isGood on failure
+ *
+ * @param writer
+ * @param data
+ * @param size
+ * @return bool
+ */
+static bool writeBytes(TraceFileWriter_t *writer, const void *data, size_t size);
+
+/**
+ * @brief Rebuilds the seek index of an unfinished file from the block headers
+ *
+ * @param file
+ * @return bool
+ */
+static bool rebuildIndex(TraceFile_t *file);
+
+static size_t putVarint(byte_t *out, qword_t value);
+static bool getVarint(const byte_t **position, const byte_t *end, qword_t *value);
+static dword_t zigzagEncode(word_t delta);
+static word_t zigzagDecode(qword_t value);
+
+/* ---------------------------------- Writer -------------------------------- */
+bool traceFileWriterOpen(TraceFileWriter_t *writer, const char *filename, dword_t keyframeInterval)
+{
+    memset(writer, 0x00, sizeof(TraceFileWriter_t));
+
+    writer->keyframeInterval = (keyframeInterval > 0) ? keyframeInterval : TRACE_FILE_DEFAULT_KEYFRAME_INTERVAL;
+    writer->cache = (TraceCodeCache_t *)calloc(1, sizeof(TraceCodeCache_t));
+    writer->stream = fopen(filename, "wb");
+
+    if(writer->cache == NULL || writer->stream == NULL)
+    {
+        setError(C80_ERROR_TRACE_FILE_WRITE_ERROR);
+        if(writer->stream != NULL)
+        {
+            fclose(writer->stream);
+        }
+        free(writer->cache);
+        memset(writer, 0x00, sizeof(TraceFileWriter_t));
+        return false;
+    }
+
+    TraceFileHeader_t header;
+    memset(&header, 0x00, sizeof(header));
+    memcpy(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_FILE_VERSION;
+    header.recordSize = (dword_t)sizeof(TraceRecord_t);
+    header.keyframeInterval = writer->keyframeInterval;
+
+    writer->isGood = true;
+
+    return writeBytes(writer, &header, sizeof(header));
+}
+
+bool traceFileWriterAppend(TraceFileWriter_t *writer, const TraceRecord_t *record)
+{
+    if(writer->isGood == false)
+    {
+        return false;
+    }
+
+    if(writer->blockRecords == writer->keyframeInterval && flushBlock(writer) == false)
+    {
+        return false;
+    }
+
+    if(writer->blockRecords == 0)
+    {
+        writer->keyframe = *record;
+        cacheReset(writer->cache);
+        cacheStoreBytes(writer->cache, record);
+    }
+    else
+    {
+        if(writer->payloadSize + MAX_DELTA_SIZE > writer->payloadCapacity)
+        {
+            size_t capacity = (writer->payloadCapacity > 0) ? writer->payloadCapacity * 2 : 64 * 1024;
+            byte_t *payload = (byte_t *)realloc(writer->payload, capacity);
+
+            if(payload == NULL)
+            {
+                setError(C80_ERROR_TRACE_FILE_WRITE_ERROR);
+                writer->isGood = false;
+                return false;
+            }
+            writer->payload = payload;
+            writer->payloadCapacity = capacity;
+        }
+
+        writer->payloadSize += encodeRecord(writer->cache, &writer->previous, record,
+                                            writer->payload + writer->payloadSize);
+    }
+
+    writer->previous = *record;
+    writer->blockRecords++;
+    writer->recordCount++;
+
+    return true;
+}
+
+bool traceFileWriterClose(TraceFileWriter_t *writer)
+{
+    if(writer->stream == NULL)
+    {
+        return false;
+    }
+
+    flushBlock(writer);
+
+    // Pad so a mapped index is aligned
+    static const byte_t padding[INDEX_ALIGNMENT] = { 0 };
+    writeBytes(writer, padding, (size_t)((INDEX_ALIGNMENT - writer->offset % INDEX_ALIGNMENT) % INDEX_ALIGNMENT));
+
+    TraceFileHeader_t header;
+    memset(&header, 0x00, sizeof(header));
+    memcpy(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_FILE_VERSION;
+    header.recordSize = (dword_t)sizeof(TraceRecord_t);
+    header.keyframeInterval = writer->keyframeInterval;
+    header.recordCount = writer->recordCount;
+    header.blockCount = writer->indexCount;
+    header.indexOffset = writer->offset;
+
+    if(writer->indexCount > 0)
+    {
+        writeBytes(writer, writer->index, writer->indexCount * sizeof(TraceIndexEntry_t));
+    }
+
+    if(writer->isGood == true && (fseek(writer->stream, 0, SEEK_SET) != 0
+        || fwrite(&header, sizeof(header), 1, writer->stream) != 1))
+    {
+        setError(C80_ERROR_TRACE_FILE_WRITE_ERROR);
+        writer->isGood = false;
+    }
+
+    if(fclose(writer->stream) != 0 && writer->isGood == true)
+    {
+        setError(C80_ERROR_TRACE_FILE_WRITE_ERROR);
+        writer->isGood = false;
+    }
+
+    bool isGood = writer->isGood;
+
+    free(writer->cache);
+    free(writer->payload);
+    free(writer->index);
+    memset(writer, 0x00, sizeof(TraceFileWriter_t));
+
+    return isGood;
+}
+
+void traceFileSink(void *context, const TraceRecord_t *records, size_t count)
+{
+    TraceFileWriter_t *writer = (TraceFileWriter_t *)context;
+
+    for(size_t idx = 0; idx < count; idx++)
+    {
+        traceFileWriterAppend(writer, &records[idx]);
+    }
+}
+
+static bool flushBlock(TraceFileWriter_t *writer)
+{
+    if(writer->blockRecords == 0)
+    {
+        return true;
+    }
+
+    if(writer->indexCount == writer->indexCapacity)
+    {
+        size_t capacity = (writer->indexCapacity > 0) ? writer->indexCapacity * 2 : 1024;
+        TraceIndexEntry_t *index = (TraceIndexEntry_t *)realloc(writer->index, capacity * sizeof(TraceIndexEntry_t));
+
+        if(index == NULL)
+        {
+            setError(C80_ERROR_TRACE_FILE_WRITE_ERROR);
+            writer->isGood = false;
+            return false;
+        }
+        writer->index = index;
+        writer->indexCapacity = capacity;
+    }
+
+    writer->index[writer->indexCount++] = (TraceIndexEntry_t){
+        .firstRecord = writer->recordCount - writer->blockRecords,
+        .offset = writer->offset};
+
+    TraceBlockHeader_t header = {
+        .magic = TRACE_BLOCK_MAGIC,
+        .recordCount = writer->blockRecords,
+        .payloadSize = (dword_t)writer->payloadSize,
+        .reserved = 0};
+
+    writer->blockRecords = 0;
+    writer->payloadSize = 0;
+
+    return writeBytes(writer, &header, sizeof(header))
+        && writeBytes(writer, &writer->keyframe, sizeof(TraceRecord_t))
+        && writeBytes(writer, writer->payload, header.payloadSize);
+}
+
+static bool writeBytes(TraceFileWriter_t *writer, const void *data, size_t size)
+{
+    if(writer->isGood == false)
+    {
+        return false;
+    }
+
+    if(size > 0 && fwrite(data, 1, size, writer->stream) != size)
+    {
+        setError(C80_ERROR_TRACE_FILE_WRITE_ERROR);
+        writer->isGood = false;
+        return false;
+    }
+
+    writer->offset += size;
+
+    return true;
+}
+/* -------------------------------------------------------------------------- */
+
+/* ---------------------------------- Reader -------------------------------- */
+bool traceFileOpen(TraceFile_t *file, const char *filename)
+{
+    memset(file, 0x00, sizeof(TraceFile_t));
+
+    if(fileMapOpen(&file->map, filename) == false)
+    {
+        setError(C80_ERROR_TRACE_FILE_NOT_FOUND);
+        return false;
+    }
+
+    if(file->map.size < sizeof(TraceFileHeader_t))
+    {
+        setError(C80_ERROR_TRACE_FILE_FORMAT_ERROR);
+        traceFileClose(file);
+        return false;
+    }
+
+    memcpy(&file->header, file->map.data, sizeof(TraceFileHeader_t));
+
+    if(memcmp(file->header.magic, TRACE_FILE_MAGIC, sizeof(file->header.magic)) != 0
+        || file->header.version != TRACE_FILE_VERSION
+        || file->header.recordSize != sizeof(TraceRecord_t))
+    {
+        setError(C80_ERROR_TRACE_FILE_FORMAT_ERROR);
+        traceFileClose(file);
+        return false;
+    }
+
+    if(file->header.indexOffset == 0)
+    {
+        if(rebuildIndex(file) == false)
+        {
+            setError(C80_ERROR_TRACE_FILE_FORMAT_ERROR);
+            traceFileClose(file);
+            return false;
+        }
+        return true;
+    }
+
+    qword_t indexSize = file->header.blockCount * sizeof(TraceIndexEntry_t);
+    if(file->header.indexOffset % INDEX_ALIGNMENT != 0 || file->header.indexOffset > file->map.size
+        || indexSize > file->map.size - file->header.indexOffset)
+    {
+        setError(C80_ERROR_TRACE_FILE_FORMAT_ERROR);
+        traceFileClose(file);
+        return false;
+    }
+
+    file->index = (const TraceIndexEntry_t *)(file->map.data + file->header.indexOffset);
+    file->blockCount = (size_t)file->header.blockCount;
+    file->recordCount = file->header.recordCount;
+
+    return true;
+}
+
+void traceFileClose(TraceFile_t *file)
+{
+    if(file == NULL)
+    {
+        return;
+    }
+
+    if(file->isIndexRebuilt == true)
+    {
+        free((void *)file->index);
+    }
+    fileMapClose(&file->map);
+    memset(file, 0x00, sizeof(TraceFile_t));
+}
+
+size_t traceFileFindBlock(const TraceFile_t *file, qword_t recordNumber)
+{
+    size_t low = 0;
+    size_t high = file->blockCount;
+
+    // Last block starting at or before the record
+    while(high - low > 1)
+    {
+        size_t middle = low + (high - low) / 2;
+
+        if(file->index[middle].firstRecord <= recordNumber)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+static bool rebuildIndex(TraceFile_t *file)
+{
+    TraceIndexEntry_t *index = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    qword_t records = 0;
+    size_t offset = sizeof(TraceFileHeader_t);
+
+    // A writer that never closed leaves whole blocks, a torn last block is ignored
+    while(file->map.size - offset >= sizeof(TraceBlockHeader_t) + sizeof(TraceRecord_t))
+    {
+        TraceBlockHeader_t header;
+        memcpy(&header, file->map.data + offset, sizeof(header));
+
+        size_t blockSize = sizeof(TraceBlockHeader_t) + sizeof(TraceRecord_t) + header.payloadSize;
+        if(header.magic != TRACE_BLOCK_MAGIC || header.recordCount == 0 || blockSize > file->map.size - offset)
+        {
+            break;
+        }
+
+        if(count == capacity)
+        {
+            capacity = (capacity > 0) ? capacity * 2 : 1024;
+            TraceIndexEntry_t *grown = (TraceIndexEntry_t *)realloc(index, capacity * sizeof(TraceIndexEntry_t));
+
+            if(grown == NULL)
+            {
+                free(index);
+                return false;
+            }
+            index = grown;
+        }
+
+        index[count++] = (TraceIndexEntry_t){ .firstRecord = records, .offset = offset };
+        records += header.recordCount;
+        offset += blockSize;
+    }
+
+    file->index = index;
+    file->blockCount = count;
+    file->recordCount = records;
+    file->isIndexRebuilt = true;
+
+    return true;
+}
+/* -------------------------------------------------------------------------- */
+
+/* ---------------------------------- Cursor -------------------------------- */
+TraceCursor_t *traceCursorCreate(const TraceFile_t *file)
+{
+    TraceCursor_t *cursor = (TraceCursor_t *)calloc(1, sizeof(TraceCursor_t));
+    if(cursor == NULL)
+    {
+        return NULL;
+    }
+
+    cursor->cache = (TraceCodeCache_t *)calloc(1, sizeof(TraceCodeCache_t));
+    if(cursor->cache == NULL)
+    {
+        free(cursor);
+        return NULL;
+    }
+
+    cursor->file = file;
+    cursor->block = (size_t)-1;
+
+    return cursor;
+}
+
+void traceCursorDestroy(TraceCursor_t *cursor)
+{
+    if(cursor == NULL)
+    {
+        return;
+    }
+
+    free(cursor->cache);
+    free(cursor);
+}
+
+bool traceCursorSeekBlock(TraceCursor_t *cursor, size_t block)
+{
+    const TraceFile_t *file = cursor->file;
+
+    cursor->remaining = 0;
+
+    if(block >= file->blockCount)
+    {
+        return false;
+    }
+
+    TraceBlockHeader_t header;
+    qword_t offset = file->index[block].offset;
+
+    if(offset > file->map.size || file->map.size - offset < sizeof(header) + sizeof(TraceRecord_t))
+    {
+        setError(C80_ERROR_TRACE_FILE_FORMAT_ERROR);
+        return false;
+    }
+
+    memcpy(&header, file->map.data + offset, sizeof(header));
+
+    if(header.magic != TRACE_BLOCK_MAGIC
+        || file->map.size - offset - sizeof(header) - sizeof(TraceRecord_t) < header.payloadSize)
+    {
+        setError(C80_ERROR_TRACE_FILE_FORMAT_ERROR);
+        return false;
+    }
+
+    cursor->block = block;
+    cursor->position = file->map.data + offset + sizeof(header);
+    cursor->end = cursor->position + sizeof(TraceRecord_t) + header.payloadSize;
+    cursor->remaining = header.recordCount;
+    cursor->isKeyframePending = true;
+    cursor->recordNumber = file->index[block].firstRecord;
+
+    return true;
+}
+
+bool traceCursorSeek(TraceCursor_t *cursor, qword_t recordNumber)
+{
+    TraceRecord_t record;
+
+    if(recordNumber >= cursor->file->recordCount
+        || traceCursorSeekBlock(cursor, traceFileFindBlock(cursor->file, recordNumber)) == false)
+    {
+        return false;
+    }
+
+    while(cursor->recordNumber < recordNumber)
+    {
+        if(traceCursorNext(cursor, &record) == false)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool traceCursorNext(TraceCursor_t *cursor, TraceRecord_t *record)
+{
+    // Before the first block, block + 1 wraps to 0
+    if(cursor->remaining == 0 && traceCursorSeekBlock(cursor, cursor->block + 1) == false)
+    {
+        return false;
+    }
+
+    if(cursor->isKeyframePending == true)
+    {
+        memcpy(record, cursor->position, sizeof(TraceRecord_t));
+        cursor->position += sizeof(TraceRecord_t);
+        cursor->isKeyframePending = false;
+
+        cacheReset(cursor->cache);
+        cacheStoreBytes(cursor->cache, record);
+    }
+    else if(decodeRecord(cursor->cache, &cursor->previous, &cursor->position, cursor->end, record) == false)
+    {
+        setError(C80_ERROR_TRACE_FILE_FORMAT_ERROR);
+        cursor->remaining = 0;
+        cursor->block = cursor->file->blockCount;
+        return false;
+    }
+
+    cursor->previous = *record;
+    cursor->remaining--;
+    cursor->recordNumber++;
+
+    return true;
+}
+/* -------------------------------------------------------------------------- */
+
+/* ------------------------------- Delta coding ----------------------------- */
+static void cacheReset(TraceCodeCache_t *cache)
+{
+    cache->generation++;
+
+    if(cache->generation == 0)
+    {
+        memset(cache->byteStamps, 0x00, sizeof(cache->byteStamps));
+        memset(cache->successorStamps, 0x00, sizeof(cache->successorStamps));
+        memset(cache->cycleStamps, 0x00, sizeof(cache->cycleStamps));
+        cache->generation = 1;
+    }
+}
+
+static void cacheStoreBytes(TraceCodeCache_t *cache, const TraceRecord_t *record)
+{
+    for(word_t idx = 0; idx < TRACE_OPCODE_BYTES; idx++)
+    {
+        word_t address = (word_t)(record->pc + idx);
+
+        cache->bytes[address] = record->opcode[idx];
+        cache->byteStamps[address] = cache->generation;
+    }
+}
+
+static size_t encodeRecord(TraceCodeCache_t *cache, const TraceRecord_t *previous, const TraceRecord_t *record,
+                           byte_t *out)
+{
+    byte_t *cursor = out + 1;
+    byte_t control = 0;
+
+    if(cache->successorStamps[previous->pc] != cache->generation || cache->successors[previous->pc] != record->pc)
+    {
+        control |= CONTROL_PC;
+        cursor += putVarint(cursor, zigzagEncode((word_t)(record->pc - previous->pc)));
+
+        cache->successors[previous->pc] = record->pc;
+        cache->successorStamps[previous->pc] = cache->generation;
+    }
+
+    for(word_t idx = 0; idx < TRACE_OPCODE_BYTES; idx++)
+    {
+        word_t address = (word_t)(record->pc + idx);
+
+        if(cache->byteStamps[address] != cache->generation || cache->bytes[address] != record->opcode[idx])
+        {
+            control |= (byte_t)(1 << idx);
+            *cursor++ = record->opcode[idx];
+        }
+    }
+    cacheStoreBytes(cache, record);
+
+    qword_t cycles = record->cycle - previous->cycle;
+    if(cache->cycleStamps[record->pc] != cache->generation || cache->cycles[record->pc] != cycles)
+    {
+        control |= CONTROL_CYCLES;
+        cursor += putVarint(cursor, cycles);
+
+        cache->cycles[record->pc] = (word_t)cycles;
+        cache->cycleStamps[record->pc] = cache->generation;
+    }
+
+    dword_t mask = 0;
+    for(size_t field = 0; field < REGISTER_FIELD_COUNT; field++)
+    {
+        const byte_t *before = (const byte_t *)previous + registerFields[field].offset;
+        const byte_t *after = (const byte_t *)record + registerFields[field].offset;
+
+        if(memcmp(before, after, registerFields[field].isWord ? sizeof(word_t) : sizeof(byte_t)) != 0)
+        {
+            mask |= 1u << field;
+        }
+    }
+
+    if(mask != 0)
+    {
+        control |= CONTROL_REGISTERS;
+        cursor += putVarint(cursor, mask);
+
+        for(size_t field = 0; field < REGISTER_FIELD_COUNT; field++)
+        {
+            if((mask & (1u << field)) == 0)
+            {
+                continue;
+            }
+
+            const byte_t *before = (const byte_t *)previous + registerFields[field].offset;
+            const byte_t *after = (const byte_t *)record + registerFields[field].offset;
+
+            if(registerFields[field].isWord == true)
+            {
+                cursor += putVarint(cursor, zigzagEncode((word_t)(*(const word_t *)after - *(const word_t *)before)));
+            }
+            else
+            {
+                *cursor++ = *after;
+            }
+        }
+    }
+
+    out[0] = control;
+
+    return (size_t)(cursor - out);
+}
+
+static bool decodeRecord(TraceCodeCache_t *cache, const TraceRecord_t *previous, const byte_t **position,
+                         const byte_t *end, TraceRecord_t *record)
+{
+    const byte_t *cursor = *position;
+    qword_t value;
+
+    if(cursor >= end)
+    {
+        return false;
+    }
+
+    byte_t control = *cursor++;
+    *record = *previous;
+
+    if((control & CONTROL_PC) != 0)
+    {
+        if(getVarint(&cursor, end, &value) == false)
+        {
+            return false;
+        }
+        record->pc = (word_t)(previous->pc + zigzagDecode(value));
+
+        cache->successors[previous->pc] = record->pc;
+        cache->successorStamps[previous->pc] = cache->generation;
+    }
+    else
+    {
+        record->pc = cache->successors[previous->pc];
+    }
+
+    for(word_t idx = 0; idx < TRACE_OPCODE_BYTES; idx++)
+    {
+        if((control & (1 << idx)) != 0)
+        {
+            if(cursor >= end)
+            {
+                return false;
+            }
+            record->opcode[idx] = *cursor++;
+        }
+        else
+        {
+            record->opcode[idx] = cache->bytes[(word_t)(record->pc + idx)];
+        }
+    }
+    cacheStoreBytes(cache, record);
+
+    if((control & CONTROL_CYCLES) != 0)
+    {
+        if(getVarint(&cursor, end, &value) == false)
+        {
+            return false;
+        }
+
+        cache->cycles[record->pc] = (word_t)value;
+        cache->cycleStamps[record->pc] = cache->generation;
+    }
+    else
+    {
+        value = cache->cycles[record->pc];
+    }
+    record->cycle = previous->cycle + value;
+
+    if((control & CONTROL_REGISTERS) != 0)
+    {
+        qword_t mask;
+
+        if(getVarint(&cursor, end, &mask) == false)
+        {
+            return false;
+        }
+
+        for(size_t field = 0; field < REGISTER_FIELD_COUNT; field++)
+        {
+            if((mask & (1u << field)) == 0)
+            {
+                continue;
+            }
+
+            byte_t *after = (byte_t *)record + registerFields[field].offset;
+
+            if(registerFields[field].isWord == true)
+            {
+                if(getVarint(&cursor, end, &value) == false)
+                {
+                    return false;
+                }
+                *(word_t *)after = (word_t)(*(word_t *)after + zigzagDecode(value));
+            }
+            else
+            {
+                if(cursor >= end)
+                {
+                    return false;
+                }
+                *after = *cursor++;
+            }
+        }
+    }
+
+    *position = cursor;
+
+    return true;
+}
+
+static size_t putVarint(byte_t *out, qword_t value)
+{
+    size_t size = 0;
+
+    while(value >= 0x80)
+    {
+        out[size++] = (byte_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[size++] = (byte_t)value;
+
+    return size;
+}
+
+static bool getVarint(const byte_t **position, const byte_t *end, qword_t *value)
+{
+    const byte_t *cursor = *position;
+    qword_t result = 0;
+
+    for(unsigned int shift = 0; shift < 64; shift += 7)
+    {
+        if(cursor >= end)
+        {
+            return false;
+        }
+
+        byte_t current = *cursor++;
+        result |= (qword_t)(current & 0x7F) << shift;
+
+        if((current & 0x80) == 0)
+        {
+            *position = cursor;
+            *value = result;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static dword_t zigzagEncode(word_t delta)
+{
+    return (word_t)((word_t)(delta << 1) ^ (((delta & 0x8000) != 0) ? 0xFFFF : 0x0000));
+}
+
+static word_t zigzagDecode(qword_t value)
+{
+    return (word_t)((word_t)(value >> 1) ^ (((value & 1) != 0) ? 0xFFFF : 0x0000));
+}
+/* -------------------------------------------------------------------------- */
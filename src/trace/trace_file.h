@@ -0,0 +1,256 @@
+#ifndef CILOGC80_TRACE_FILE_H
+#define CILOGC80_TRACE_FILE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "utils/utils.h"
+#include "utils/file_map.h"
+#include "trace/trace_ring.h"
+
+/** @brief Magic of a delta compressed trace file */
+#define TRACE_FILE_MAGIC "C80DELTA"
+#define TRACE_FILE_VERSION 1
+/** @brief Magic of a block header ("CBLK") */
+#define TRACE_BLOCK_MAGIC 0x4B4C4243u
+
+/** @brief Default records per block, every block starts with a full record */
+#define TRACE_FILE_DEFAULT_KEYFRAME_INTERVAL 4096
+/** @brief Addresses covered by the code cache */
+#define TRACE_CODE_CACHE_SIZE 0x10000
+
+/**
+ * @brief File header. recordCount, blockCount and indexOffset are patched when the writer is
+ * closed, an indexOffset of 0 marks a file whose writer never finished (the index is then
+ * rebuilt from the block headers)
+ */
+typedef struct TraceFileHeader_t
+{
+    char magic[8];
+    dword_t version;
+    /** @brief sizeof(TraceRecord_t) of the writer */
+    dword_t recordSize;
+    dword_t keyframeInterval;
+    dword_t reserved;
+    qword_t recordCount;
+    qword_t blockCount;
+    qword_t indexOffset;
+} TraceFileHeader_t;
+
+/**
+ * @brief Header of a block, followed by the keyframe (a full @ref TraceRecord_t) and
+ * payloadSize bytes of delta records
+ */
+typedef struct TraceBlockHeader_t
+{
+    dword_t magic;
+    /** @brief Records of the block, the keyframe included */
+    dword_t recordCount;
+    dword_t payloadSize;
+    dword_t reserved;
+} TraceBlockHeader_t;
+
+/**
+ * @brief Seek index entry, one per block. The index sits at the end of the file
+ */
+typedef struct TraceIndexEntry_t
+{
+    /** @brief Number of the keyframe of the block */
+    qword_t firstRecord;
+    /** @brief File offset of the block header */
+    qword_t offset;
+} TraceIndexEntry_t;
+
+/**
+ * @brief What the delta coder remembers within a block: the instruction bytes last seen at
+ * every address, the PC that followed every PC and the cycles taken at every PC. Entries
+ * are valid if their stamp equals the generation, which moves on at every keyframe
+ */
+typedef struct TraceCodeCache_t
+{
+    dword_t generation;
+
+    dword_t byteStamps[TRACE_CODE_CACHE_SIZE];
+    byte_t bytes[TRACE_CODE_CACHE_SIZE];
+
+    dword_t successorStamps[TRACE_CODE_CACHE_SIZE];
+    word_t successors[TRACE_CODE_CACHE_SIZE];
+
+    dword_t cycleStamps[TRACE_CODE_CACHE_SIZE];
+    word_t cycles[TRACE_CODE_CACHE_SIZE];
+} TraceCodeCache_t;
+
+/**
+ * @brief Writes records to a delta compressed trace file. Records are collected into blocks
+ * in memory, a file only ever holds whole blocks
+ */
+typedef struct TraceFileWriter_t
+{
+    FILE *stream;
+    dword_t keyframeInterval;
+
+    /** @brief Records appended */
+    qword_t recordCount;
+    /** @brief Bytes written to the stream */
+    qword_t offset;
+    /** @brief False once a write failed, later appends are ignored */
+    bool isGood;
+
+    TraceCodeCache_t *cache;
+    TraceRecord_t previous;
+
+    /** @brief Keyframe and payload of the current block */
+    TraceRecord_t keyframe;
+    byte_t *payload;
+    size_t payloadSize;
+    size_t payloadCapacity;
+    dword_t blockRecords;
+
+    TraceIndexEntry_t *index;
+    size_t indexCount;
+    size_t indexCapacity;
+} TraceFileWriter_t;
+
+/**
+ * @brief Opened trace file
+ */
+typedef struct TraceFile_t
+{
+    FileMap_t map;
+    TraceFileHeader_t header;
+
+    /** @brief Points into the mapping, or to a heap copy rebuilt from the block headers */
+    const TraceIndexEntry_t *index;
+    size_t blockCount;
+    qword_t recordCount;
+    bool isIndexRebuilt;
+} TraceFile_t;
+
+/**
+ * @brief Sequential decoder over a @ref TraceFile_t. Several cursors can read one file
+ * concurrently
+ */
+typedef struct TraceCursor_t
+{
+    const TraceFile_t *file;
+    TraceCodeCache_t *cache;
+
+    /** @brief Block being decoded, (size_t)-1 before the first */
+    size_t block;
+    const byte_t *position;
+    const byte_t *end;
+    /** @brief Records of the block not decoded yet */
+    dword_t remaining;
+    bool isKeyframePending;
+
+    /** @brief Number of the record the next @ref traceCursorNext returns */
+    qword_t recordNumber;
+    TraceRecord_t previous;
+} TraceCursor_t;
+
+/**
+ * @brief Creates a trace file and writes a provisional header
+ *
+ * @param writer
+ * @param filename
+ * @param keyframeInterval Records per block, 0 for the default
+ * @return bool False if the file could not be created or out of memory
+ */
+bool traceFileWriterOpen(TraceFileWriter_t *writer, const char *filename, dword_t keyframeInterval);
+
+/**
+ * @brief Appends a record
+ *
+ * @param writer
+ * @param record
+ * @return bool False if writing failed
+ */
+bool traceFileWriterAppend(TraceFileWriter_t *writer, const TraceRecord_t *record);
+
+/**
+ * @brief Writes the last block and the seek index, completes the header and closes the file
+ *
+ * @param writer
+ * @return bool False if any write failed
+ */
+bool traceFileWriterClose(TraceFileWriter_t *writer);
+
+/**
+ * @brief Sink appending drained records to a trace file
+ *
+ * @param context TraceFileWriter_t
+ * @param records
+ * @param count
+ */
+void traceFileSink(void *context, const TraceRecord_t *records, size_t count);
+
+/**
+ * @brief Maps a trace file and loads its seek index. Nothing is decoded
+ *
+ * @param file
+ * @param filename
+ * @return bool
+ */
+bool traceFileOpen(TraceFile_t *file, const char *filename);
+
+/**
+ * @brief Unmaps a trace file, destroy its cursors first
+ *
+ * @param file
+ */
+void traceFileClose(TraceFile_t *file);
+
+/**
+ * @brief Binary search of the seek index
+ *
+ * @param file
+ * @param recordNumber
+ * @return size_t Block holding the record
+ */
+size_t traceFileFindBlock(const TraceFile_t *file, qword_t recordNumber);
+
+/**
+ * @brief Allocates a cursor positioned before the first record
+ *
+ * @param file
+ * @return TraceCursor_t* NULL if out of memory
+ */
+TraceCursor_t *traceCursorCreate(const TraceFile_t *file);
+
+/**
+ * @brief Frees a cursor
+ *
+ * @param cursor
+ */
+void traceCursorDestroy(TraceCursor_t *cursor);
+
+/**
+ * @brief Positions the cursor at the keyframe of a block
+ *
+ * @param cursor
+ * @param block
+ * @return bool False if the block does not exist or its header is damaged
+ */
+bool traceCursorSeekBlock(TraceCursor_t *cursor, size_t block);
+
+/**
+ * @brief Positions the cursor at a record: jumps to the keyframe before it and decodes at
+ * most one block
+ *
+ * @param cursor
+ * @param recordNumber
+ * @return bool False if the record does not exist
+ */
+bool traceCursorSeek(TraceCursor_t *cursor, qword_t recordNumber);
+
+/**
+ * @brief Decodes the next record, continuing into the following blocks
+ *
+ * @param cursor
+ * @param record
+ * @return bool False at the end of the trace or on damaged data
+ */
+bool traceCursorNext(TraceCursor_t *cursor, TraceRecord_t *record);
+
+#endif // CILOGC80_TRACE_FILE_H
@@ -0,0 +1,172 @@
+#include "trace/trace_ring.h"
+
+#include <string.h>
+
+#include "cpu/cpu.h"
+
+/** @brief Drain thread pause while the ring is empty */
+#define TRACE_DRAIN_IDLE_MILLISECONDS 1
+
+/**
+ * @brief Drain thread entry point
+ *
+ * @param argument TraceDrain_t
+ */
+static void drainThread(void *argument);
+
+/**
+ * @brief Hands every record currently in the ring to the sink
+ *
+ * @param drain
+ * @return size_t Records drained
+ */
+static size_t drainAvailable(TraceDrain_t *drain);
+
+TraceRing_t *traceRingCreate(size_t capacity, bool isBlocking)
+{
+    qword_t roundedCapacity = 1;
+    while(roundedCapacity < (qword_t)capacity)
+    {
+        roundedCapacity <<= 1;
+    }
+
+    TraceRing_t *ring = (TraceRing_t *)calloc(1, sizeof(TraceRing_t));
+    if(ring == NULL)
+    {
+        return NULL;
+    }
+
+    ring->records = (TraceRecord_t *)malloc((size_t)roundedCapacity * sizeof(TraceRecord_t));
+    if(ring->records == NULL)
+    {
+        free(ring);
+        return NULL;
+    }
+
+    ring->capacity = roundedCapacity;
+    ring->isBlocking = isBlocking;
+
+    return ring;
+}
+
+void traceRingDestroy(TraceRing_t *ring)
+{
+    if(ring == NULL)
+    {
+        return;
+    }
+
+    free(ring->records);
+    free(ring);
+}
+
+void traceRecordCapture(const ZilogZ80_t *cpu, word_t pc, const byte_t *opcode, qword_t cycle,
+                        TraceRecord_t *record)
+{
+    record->cycle = cycle;
+
+    record->pc = pc;
+    record->sp = cpu->SP;
+    record->ix = cpu->IX;
+    record->iy = cpu->IY;
+    record->af = TO_WORD(cpu->A, zilogZ80FlagsToByte(cpu->F));
+    record->bc = TO_WORD(cpu->B, cpu->C);
+    record->de = TO_WORD(cpu->D, cpu->E);
+    record->hl = TO_WORD(cpu->H, cpu->L);
+    record->afShadow = TO_WORD(cpu->A_, zilogZ80FlagsToByte(cpu->F_));
+    record->bcShadow = TO_WORD(cpu->B_, cpu->C_);
+    record->deShadow = TO_WORD(cpu->D_, cpu->E_);
+    record->hlShadow = TO_WORD(cpu->H_, cpu->L_);
+
+    memcpy(record->opcode, opcode, TRACE_OPCODE_BYTES);
+
+    record->i = cpu->I;
+    record->r = cpu->R;
+    record->flags = (byte_t)((cpu->isHaltered ? TRACE_FLAG_HALTED : 0)
+                           | (cpu->interruptStatus == INTERRUPTS_ENABLED ? TRACE_FLAG_INTERRUPTS_ENABLED : 0));
+    record->interruptMode = (byte_t)cpu->interruptMode;
+}
+
+bool traceRingRecord(TraceRing_t *ring, const ZilogZ80_t *cpu, word_t pc, const byte_t *opcode, int cycles)
+{
+    TraceRecord_t record;
+
+    ring->cycle += (qword_t)cycles;
+    traceRecordCapture(cpu, pc, opcode, ring->cycle, &record);
+
+    return traceRingPush(ring, &record);
+}
+
+size_t traceRingAcquire(TraceRing_t *ring, const TraceRecord_t **records)
+{
+    qword_t tail = ring->tail;
+    qword_t available = atomicLoadAcquire64(&ring->head) - tail;
+    qword_t index = tail & (ring->capacity - 1);
+
+    // Only up to the end of the buffer
+    if(available > ring->capacity - index)
+    {
+        available = ring->capacity - index;
+    }
+
+    *records = &ring->records[index];
+
+    return (size_t)available;
+}
+
+void traceRingRelease(TraceRing_t *ring, size_t count)
+{
+    atomicStoreRelease64(&ring->tail, ring->tail + (qword_t)count);
+}
+
+bool traceDrainStart(TraceDrain_t *drain, TraceRing_t *ring, TraceSink_t sink, void *context)
+{
+    drain->ring = ring;
+    drain->sink = sink;
+    drain->context = context;
+    drain->isStopping = 0;
+    drain->drained = 0;
+
+    return threadCreate(&drain->thread, drainThread, drain);
+}
+
+void traceDrainStop(TraceDrain_t *drain)
+{
+    atomicStore(&drain->isStopping, 1);
+    threadJoin(&drain->thread);
+}
+
+static void drainThread(void *argument)
+{
+    TraceDrain_t *drain = (TraceDrain_t *)argument;
+
+    while(atomicLoad(&drain->isStopping) == 0)
+    {
+        if(drainAvailable(drain) == 0)
+        {
+            threadSleepMilliseconds(TRACE_DRAIN_IDLE_MILLISECONDS);
+        }
+    }
+
+    // The producer is stopped, whatever is left is final
+    drainAvailable(drain);
+}
+
+static size_t drainAvailable(TraceDrain_t *drain)
+{
+    const TraceRecord_t *records;
+    size_t total = 0;
+    size_t count;
+
+    // A wrap around the end of the buffer takes two rounds
+    while((count = traceRingAcquire(drain->ring, &records)) > 0)
+    {
+        drain->sink(drain->context, records, count);
+        traceRingRelease(drain->ring, count);
+        total += count;
+    }
+
+    drain->drained += total;
+
+    return total;
+}
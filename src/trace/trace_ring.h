@@ -0,0 +1,224 @@
+#ifndef CILOGC80_TRACE_RING_H
+#define CILOGC80_TRACE_RING_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "utils/utils.h"
+#include "utils/threading.h"
+
+struct ZilogZ80_t;
+
+/** @brief Default ring capacity in records (2.5 MiB) */
+#define TRACE_RING_DEFAULT_CAPACITY (1 << 16)
+/** @brief Instruction bytes kept per record, the longest Z80 instruction */
+#define TRACE_OPCODE_BYTES 4
+
+/** @brief Record flag: the CPU is halted after the instruction */
+#define TRACE_FLAG_HALTED 0x01
+/** @brief Record flag: interrupts are enabled after the instruction */
+#define TRACE_FLAG_INTERRUPTS_ENABLED 0x02
+
+/**
+ * @brief One retired instruction: its address and bytes, the registers after it and the
+ * cycle counter after it. Fixed size, keyframes of trace files store it as is (little endian hosts)
+ */
+typedef struct TraceRecord_t
+{
+    /** @brief Cycles executed since the trace started, this instruction included */
+    qword_t cycle;
+
+    /** @brief Address of the instruction */
+    word_t pc;
+    word_t sp;
+    word_t ix;
+    word_t iy;
+    /** @brief A in the upper byte, F (S Z - H - P N C) in the lower byte */
+    word_t af;
+    word_t bc;
+    word_t de;
+    word_t hl;
+    word_t afShadow;
+    word_t bcShadow;
+    word_t deShadow;
+    word_t hlShadow;
+
+    /** @brief Bytes at pc before the instruction ran, the unused tail belongs to the next instruction */
+    byte_t opcode[TRACE_OPCODE_BYTES];
+
+    byte_t i;
+    byte_t r;
+    /** @brief TRACE_FLAG_* */
+    byte_t flags;
+    byte_t interruptMode;
+} TraceRecord_t;
+
+/**
+ * @brief Receives drained records, called on the drain thread
+ *
+ * @param context
+ * @param records
+ * @param count
+ */
+typedef void (*TraceSink_t)(void *context, const TraceRecord_t *records, size_t count);
+
+/**
+ * @brief Single producer / single consumer ring of trace records. The emulation thread
+ * appends, one consumer (usually a @ref TraceDrain_t) takes records out. Neither side locks
+ * or allocates, head and tail sit on their own cache lines
+ */
+typedef struct TraceRing_t
+{
+    TraceRecord_t *records;
+    /** @brief Power of 2 */
+    qword_t capacity;
+    /** @brief Wait for room instead of dropping records when the ring is full */
+    bool isBlocking;
+
+    /** @brief Keeps the producer fields on their own cache line */
+    byte_t producerPadding[64];
+    /** @brief Records appended, written by the producer only */
+    qword_t head;
+    /** @brief Cycles of the recorded instructions, source of @ref TraceRecord_t cycle */
+    qword_t cycle;
+    /** @brief Producer copy of tail, refreshed only when the ring looks full */
+    qword_t cachedTail;
+    /** @brief Records lost because the ring was full (non-blocking rings) */
+    qword_t dropped;
+
+    /** @brief Keeps the consumer field on its own cache line */
+    byte_t consumerPadding[64];
+    /** @brief Records consumed, written by the consumer only */
+    qword_t tail;
+    byte_t endPadding[64];
+} TraceRing_t;
+
+/**
+ * @brief Consumer thread moving records from a ring into a sink
+ */
+typedef struct TraceDrain_t
+{
+    TraceRing_t *ring;
+    TraceSink_t sink;
+    void *context;
+
+    Thread_t thread;
+    /** @brief Set by @ref traceDrainStop, the thread empties the ring and exits */
+    long isStopping;
+    /** @brief Records handed to the sink */
+    qword_t drained;
+} TraceDrain_t;
+
+/**
+ * @brief Allocates a ring
+ *
+ * @param capacity Records, rounded up to a power of 2
+ * @param isBlocking True makes a full ring stall the producer, false drops records
+ * @return TraceRing_t* NULL if out of memory
+ */
+TraceRing_t *traceRingCreate(size_t capacity, bool isBlocking);
+
+/**
+ * @brief Frees a ring (detach it from the CPU and stop its drain first)
+ *
+ * @param ring
+ */
+void traceRingDestroy(TraceRing_t *ring);
+
+/**
+ * @brief Fills a record from the CPU state after an instruction
+ *
+ * @param cpu
+ * @param pc Address of the instruction
+ * @param opcode TRACE_OPCODE_BYTES bytes read before the instruction ran
+ * @param cycle Cycle counter after the instruction
+ * @param record
+ */
+void traceRecordCapture(const struct ZilogZ80_t *cpu, word_t pc, const byte_t *opcode, qword_t cycle,
+                        TraceRecord_t *record);
+
+/**
+ * @brief Records a retired instruction (producer side, called by @ref zilogZ80Step while
+ * the ring is attached to the CPU trace field)
+ *
+ * @param ring
+ * @param cpu State after the instruction
+ * @param pc Address of the instruction
+ * @param opcode TRACE_OPCODE_BYTES bytes read before the instruction ran
+ * @param cycles Cycles of the instruction
+ * @return bool False if the record was dropped
+ */
+bool traceRingRecord(TraceRing_t *ring, const struct ZilogZ80_t *cpu, word_t pc, const byte_t *opcode, int cycles);
+
+/**
+ * @brief Appends a record (producer side)
+ *
+ * @param ring
+ * @param record
+ * @return bool False if the record was dropped
+ */
+static inline bool traceRingPush(TraceRing_t *ring, const TraceRecord_t *record)
+{
+    qword_t head = ring->head;
+
+    if(head - ring->cachedTail >= ring->capacity)
+    {
+        ring->cachedTail = atomicLoadAcquire64(&ring->tail);
+
+        while(head - ring->cachedTail >= ring->capacity)
+        {
+            if(ring->isBlocking == false)
+            {
+                ring->dropped++;
+                return false;
+            }
+
+            threadYield();
+            ring->cachedTail = atomicLoadAcquire64(&ring->tail);
+        }
+    }
+
+    ring->records[head & (ring->capacity - 1)] = *record;
+    atomicStoreRelease64(&ring->head, head + 1);
+
+    return true;
+}
+
+/**
+ * @brief Returns the oldest records not consumed yet without copying them (consumer side).
+ * Only the contiguous part up to the end of the buffer is returned, call again after
+ * @ref traceRingRelease for the rest
+ *
+ * @param ring
+ * @param records Set to the first record
+ * @return size_t Number of records available at *records
+ */
+size_t traceRingAcquire(TraceRing_t *ring, const TraceRecord_t **records);
+
+/**
+ * @brief Hands consumed records back to the producer (consumer side)
+ *
+ * @param ring
+ * @param count At most the count returned by @ref traceRingAcquire
+ */
+void traceRingRelease(TraceRing_t *ring, size_t count);
+
+/**
+ * @brief Starts the consumer thread of a ring
+ *
+ * @param drain
+ * @param ring
+ * @param sink
+ * @param context Passed to the sink
+ * @return bool False if the thread could not be started
+ */
+bool traceDrainStart(TraceDrain_t *drain, TraceRing_t *ring, TraceSink_t sink, void *context);
+
+/**
+ * @brief Lets the consumer thread empty the ring and waits for it. Stop the producer first
+ *
+ * @param drain
+ */
+void traceDrainStop(TraceDrain_t *drain);
+
+#endif // CILOGC80_TRACE_RING_H
@@ -0,0 +1,51 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "utils/clock.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+qword_t clockNowNanoseconds()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+
+    // Split to avoid overflowing the multiplication
+    qword_t seconds = (qword_t)(counter.QuadPart / frequency.QuadPart);
+    qword_t remainder = (qword_t)(counter.QuadPart % frequency.QuadPart);
+
+    return seconds * 1000000000ULL + remainder * 1000000000ULL / (qword_t)frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (qword_t)now.tv_sec * 1000000000ULL + (qword_t)now.tv_nsec;
+#endif
+}
+
+double clockTicksPerNanosecond()
+{
+    // Long enough to hide the cost of the reads, short enough for a tool start up
+    const qword_t calibrationTime = 10000000ULL;
+
+    qword_t startTime = clockNowNanoseconds();
+    qword_t startTicks = clockNowTicks();
+    qword_t elapsedTime;
+
+    do
+    {
+        elapsedTime = clockNowNanoseconds() - startTime;
+    } while(elapsedTime < calibrationTime);
+
+    qword_t elapsedTicks = clockNowTicks() - startTicks;
+
+    return (elapsedTicks > 0) ? (double)elapsedTicks / (double)elapsedTime : 1.0;
+}
@@ -0,0 +1,49 @@
+#ifndef CILOGC80_CLOCK_H
+#define CILOGC80_CLOCK_H
+
+#include "utils/utils.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief Returns a monotonic host timestamp in nanoseconds. Only differences between two
+ * timestamps are meaningful
+ * 
+ * @return qword_t 
+ */
+qword_t clockNowNanoseconds();
+
+/**
+ * @brief Measures the rate of @ref clockNowTicks against @ref clockNowNanoseconds. Busy waits
+ * for a few milliseconds, call it once and keep the result
+ *
+ * @return double Ticks per nanosecond, 1.0 if the ticks are nanoseconds
+ */
+double clockTicksPerNanosecond();
+
+/**
+ * @brief Reads the cheapest host cycle counter: the TSC on x86, the virtual counter on ARM64.
+ * Other hosts fall back to @ref clockNowNanoseconds. Not serializing, only meant for
+ * statistical profiling
+ *
+ * @return qword_t
+ */
+static inline qword_t clockNowTicks()
+{
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) \
+    || ((defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)))
+    return (qword_t)__rdtsc();
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+    qword_t ticks;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return clockNowNanoseconds();
+#endif
+}
+
+#endif // CILOGC80_CLOCK_H
@@ -1,23 +1,15 @@
 #include "utils/error_handler.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include "utils/utils.h"
+#include "utils/threading.h"
 
-#define MAX_ERRORS 128
+// Errors never cross threads: each thread has a default stack and machines bind their own
+static C80_THREAD_LOCAL ErrorStack_t defaultErrorStack = { .topIndex = -1 };
+static C80_THREAD_LOCAL ErrorStack_t *currentErrorStack = NULL;
 
-typedef struct
-{
-    C80_Error_t error;
-} Error_t;
-
-typedef struct
-{
-    Error_t errors[MAX_ERRORS];
-    int topIndex;
-} ErrorStack_t;
-
-static ErrorStack_t errorStack;
 static const char *errorMessages[] = 
 {
     "No error",
@@ -29,6 +21,7 @@ static const char *errorMessages[] =
     "Error storing word in memory",
     "Error fetching byte from memory",
     "Error fetching word from memory",
+    "Error mapping memory region",
 
     // ROM errors
     "ROM file not found",
@@ -36,30 +29,89 @@ static const char *errorMessages[] =
     "ROM file is too large",
     "Error reading ROM file",
     "Error writing ROM file",
-    "Error trying to store byte in ROM"
+    "Error trying to store byte in ROM",
+    "Invalid ROM file format",
 
     // CPU errors
     "Error initializing CPU",
     "Error destroying CPU",
-    "Invalid opcode"
+    "Invalid opcode",
+
+    // Symbol file errors
+    "Symbol file not found",
+    "Error reading symbol file",
+    "No symbols found in symbol file",
+
+    // Trace file errors
+    "Trace file not found",
+    "Error writing trace file",
+    "Invalid trace file format",
+
+    // Save state errors
+    "Save state file not found",
+    "Error writing save state file",
+    "Invalid save state file format",
+    "Save state belongs to another ROM"
 };
 
+void errorStackReset(ErrorStack_t *stack)
+{
+    if(stack != NULL)
+    {
+        stack->topIndex = -1;
+    }
+}
+
+ErrorStack_t *errorStackSetCurrent(ErrorStack_t *stack)
+{
+    ErrorStack_t *previous = errorStackGetCurrent();
+    currentErrorStack = stack;
+
+    return previous;
+}
+
+ErrorStack_t *errorStackGetCurrent()
+{
+    return (currentErrorStack != NULL) ? currentErrorStack : &defaultErrorStack;
+}
+
+const char *getErrorMessage(C80_Error_t error)
+{
+    if((size_t)error >= sizeof(errorMessages) / sizeof(errorMessages[0]))
+    {
+        return "Unknown error";
+    }
+
+    return errorMessages[error];
+}
+
 void errorStackInit()
 {
-    errorStack.topIndex = -1;
+    errorStackReset(errorStackGetCurrent());
 }
 
 void pollError()
 {
-    if(errorStack.topIndex >= 0)
+    ErrorStack_t *errorStack = errorStackGetCurrent();
+
+    if(errorStack->topIndex >= 0)
     {
-        printf("Error: %s\n", errorMessages[errorStack.errors[errorStack.topIndex].error]);
+        printf("Error: %s\n", getErrorMessage(errorStack->errors[errorStack->topIndex].error));
     }
 }
 void setError(C80_Error_t error)
 {
-    errorStack.topIndex++;
-    errorStack.errors[errorStack.topIndex].error = error;
+    ErrorStack_t *errorStack = errorStackGetCurrent();
+
+    if(errorStack->topIndex == MAX_ERRORS - 1)
+    {
+        // Drop the oldest error instead of running past the end
+        memmove(&errorStack->errors[0], &errorStack->errors[1], (MAX_ERRORS - 1) * sizeof(Error_t));
+        errorStack->topIndex--;
+    }
+
+    errorStack->topIndex++;
+    errorStack->errors[errorStack->topIndex].error = error;
 
 #if defined(DEBUG_MODE) && (DEBUG_MODE == 1)
     pollError();
@@ -67,28 +119,32 @@ void setError(C80_Error_t error)
 }
 void clearError(C80_Error_t error)
 {
-    for(int i = 0; i <= errorStack.topIndex; i++)
+    ErrorStack_t *errorStack = errorStackGetCurrent();
+
+    for(int i = 0; i <= errorStack->topIndex; i++)
     {
-        if(errorStack.errors[i].error == error)
+        if(errorStack->errors[i].error == error)
         {
-            for(int j = i; j < errorStack.topIndex; j++)
+            for(int j = i; j < errorStack->topIndex; j++)
             {
-                errorStack.errors[j] = errorStack.errors[j + 1];
+                errorStack->errors[j] = errorStack->errors[j + 1];
             }
-            errorStack.topIndex--;
+            errorStack->topIndex--;
             break;
         }
     }
 }
 void clearAllErrors()
 {
-    errorStack.topIndex = -1;
+    errorStackReset(errorStackGetCurrent());
 }
 bool hasError(C80_Error_t error)
 {
-    for(int i = 0; i <= errorStack.topIndex; i++)
+    ErrorStack_t *errorStack = errorStackGetCurrent();
+
+    for(int i = 0; i <= errorStack->topIndex; i++)
     {
-        if(errorStack.errors[i].error == error)
+        if(errorStack->errors[i].error == error)
         {
             return true;
         }
@@ -97,5 +153,5 @@ bool hasError(C80_Error_t error)
 }
 int getErrorCount()
 {
-    return errorStack.topIndex + 1;
+    return errorStackGetCurrent()->topIndex + 1;
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 
 #include <stdbool.h>
 
+#define MAX_ERRORS 128
+
 typedef enum
 {
     C80_ERROR_NONE = 0,
@@ -14,6 +16,7 @@ typedef enum
     C80_ERROR_MEMORY_STORE_WORD_ERROR,
     C80_ERROR_MEMORY_FETCH_BYTE_ERROR,
     C80_ERROR_MEMORY_FETCH_WORD_ERROR,
+    C80_ERROR_MEMORY_MAP_ERROR,
 
     // ROM errors
     C80_ERROR_ROM_FILE_NOT_FOUND,
@@ -22,14 +25,76 @@ typedef enum
     C80_ERROR_ROM_FILE_READ_ERROR,
     C80_ERROR_ROM_FILE_WRITE_ERROR,
     C80_ERROR_ROM_STORE_BYTE_ERROR,
+    C80_ERROR_ROM_FILE_FORMAT_ERROR,
     
     // CPU errors
     C80_ERROR_CPU_INIT_ERROR,
     C80_ERROR_CPU_DESTROY_ERROR,
-    C80_ERROR_CPU_INVALID_OPCODE
+    C80_ERROR_CPU_INVALID_OPCODE,
+
+    // Symbol file errors
+    C80_ERROR_SYMBOL_FILE_NOT_FOUND,
+    C80_ERROR_SYMBOL_FILE_READ_ERROR,
+    C80_ERROR_SYMBOL_FILE_FORMAT_ERROR,
+
+    // Trace file errors
+    C80_ERROR_TRACE_FILE_NOT_FOUND,
+    C80_ERROR_TRACE_FILE_WRITE_ERROR,
+    C80_ERROR_TRACE_FILE_FORMAT_ERROR,
+
+    // Save state errors
+    C80_ERROR_STATE_FILE_NOT_FOUND,
+    C80_ERROR_STATE_FILE_WRITE_ERROR,
+    C80_ERROR_STATE_FILE_FORMAT_ERROR,
+    C80_ERROR_STATE_FILE_ROM_MISMATCH
 
 } C80_Error_t;
 
+typedef struct
+{
+    C80_Error_t error;
+} Error_t;
+
+/**
+ * @brief Error stack, every machine owns one. When full the oldest error is dropped
+ */
+typedef struct
+{
+    Error_t errors[MAX_ERRORS];
+    int topIndex;
+} ErrorStack_t;
+
+/**
+ * @brief Empties an error stack
+ * 
+ * @param stack 
+ */
+void errorStackReset(ErrorStack_t *stack);
+
+/**
+ * @brief Binds an error stack to the calling thread, all error functions below work on it.
+ * Every thread starts with its own default stack
+ * 
+ * @param stack Stack to bind, NULL selects the default stack of the thread
+ * @return ErrorStack_t* Previously bound stack (to restore it afterwards)
+ */
+ErrorStack_t *errorStackSetCurrent(ErrorStack_t *stack);
+
+/**
+ * @brief Returns the error stack bound to the calling thread
+ * 
+ * @return ErrorStack_t* 
+ */
+ErrorStack_t *errorStackGetCurrent();
+
+/**
+ * @brief Returns the message of an error
+ * 
+ * @param error 
+ * @return const char* 
+ */
+const char *getErrorMessage(C80_Error_t error);
+
 void errorStackInit();
 
 void pollError();
@@ -39,4 +104,4 @@ void clearAllErrors();
 bool hasError(C80_Error_t error);
 int getErrorCount();
 
-#endif //ERROR_HANDLER_H
\ No newline at end of file
+#endif //ERROR_HANDLER_H
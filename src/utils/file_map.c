@@ -0,0 +1,111 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "utils/file_map.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/**
+ * @brief Reads the whole file into a heap buffer
+ *
+ * @param map
+ * @param file
+ * @return bool
+ */
+static bool readWholeFile(FileMap_t *map, FILE *file);
+
+bool fileMapOpen(FileMap_t *map, const char *filename)
+{
+    memset(map, 0x00, sizeof(FileMap_t));
+
+    FILE *file = fopen(filename, "rb");
+    if(file == NULL)
+    {
+        return false;
+    }
+
+#if !defined(_WIN32)
+    struct stat status;
+
+    if(fstat(fileno(file), &status) == 0 && status.st_size > 0 && (unsigned long long)status.st_size <= (size_t)-1)
+    {
+        void *mapping = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, fileno(file), 0);
+
+        if(mapping != MAP_FAILED)
+        {
+            map->data = (const byte_t *)mapping;
+            map->size = (size_t)status.st_size;
+            map->isMapped = true;
+            fclose(file);
+
+            return true;
+        }
+    }
+#endif
+
+    bool isRead = readWholeFile(map, file);
+    fclose(file);
+
+    return isRead;
+}
+
+void fileMapClose(FileMap_t *map)
+{
+    if(map == NULL || map->data == NULL)
+    {
+        return;
+    }
+
+#if !defined(_WIN32)
+    if(map->isMapped == true)
+    {
+        munmap((void *)map->data, map->size);
+    }
+    else
+#endif
+    {
+        free((void *)map->data);
+    }
+
+    memset(map, 0x00, sizeof(FileMap_t));
+}
+
+static bool readWholeFile(FileMap_t *map, FILE *file)
+{
+    if(fseek(file, 0, SEEK_END) != 0)
+    {
+        return false;
+    }
+
+    long size = ftell(file);
+    if(size <= 0 || fseek(file, 0, SEEK_SET) != 0)
+    {
+        return false;
+    }
+
+    byte_t *data = (byte_t *)malloc((size_t)size);
+    if(data == NULL)
+    {
+        return false;
+    }
+
+    if(fread(data, 1, (size_t)size, file) != (size_t)size)
+    {
+        free(data);
+        return false;
+    }
+
+    map->data = data;
+    map->size = (size_t)size;
+    map->isMapped = false;
+
+    return true;
+}
@@ -0,0 +1,37 @@
+#ifndef CILOGC80_FILE_MAP_H
+#define CILOGC80_FILE_MAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "utils/utils.h"
+
+/**
+ * @brief Read-only view of a whole file. Memory mapped where the host supports it, read
+ * into a heap buffer otherwise
+ */
+typedef struct FileMap_t
+{
+    const byte_t *data;
+    size_t size;
+    /** @brief True if data is a mapping, false if it is a heap buffer */
+    bool isMapped;
+} FileMap_t;
+
+/**
+ * @brief Maps a file
+ *
+ * @param map
+ * @param filename
+ * @return bool False if the file could not be opened or read, or is empty
+ */
+bool fileMapOpen(FileMap_t *map, const char *filename);
+
+/**
+ * @brief Unmaps a file (or frees its buffer)
+ *
+ * @param map
+ */
+void fileMapClose(FileMap_t *map);
+
+#endif // CILOGC80_FILE_MAP_H
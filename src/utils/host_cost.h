@@ -0,0 +1,30 @@
+#ifndef CILOGC80_HOST_COST_H
+#define CILOGC80_HOST_COST_H
+
+#include "utils/utils.h"
+
+/**
+ * @brief Enum struct for defining the access paths timed by the host cost profiler
+ */
+typedef enum HostPath
+{
+    /** @brief Memory map slow path served from backing storage (watched, ROM writes, unmapped) */
+    HOST_PATH_SLOW_MEMORY = 0,
+    /** @brief Device handlers of memory mapped I/O pages */
+    HOST_PATH_MEMORY_HANDLER,
+    /** @brief I/O port callbacks */
+    HOST_PATH_IO_PORT,
+    HOST_PATH_COUNT
+} HostPath;
+
+/**
+ * @brief Host ticks spent on the access paths during one sampled instruction. The memory map
+ * and the CPU only fill it while a profiler has attached one
+ */
+typedef struct HostPathCost_t
+{
+    qword_t accesses[HOST_PATH_COUNT];
+    qword_t ticks[HOST_PATH_COUNT];
+} HostPathCost_t;
+
+#endif // CILOGC80_HOST_COST_H
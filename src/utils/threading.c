@@ -0,0 +1,185 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+// _SC_NPROCESSORS_ONLN is not part of POSIX.1-2008
+#define _DEFAULT_SOURCE
+#endif
+
+#include "utils/threading.h"
+
+#include <stdlib.h>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
+/**
+ * @brief Entry point and argument of a starting thread
+ */
+typedef struct ThreadStart_t
+{
+    ThreadFunction_t function;
+    void *argument;
+} ThreadStart_t;
+
+#if defined(_WIN32)
+static DWORD WINAPI threadEntry(LPVOID parameter)
+#else
+static void *threadEntry(void *parameter)
+#endif
+{
+    ThreadStart_t start = *(ThreadStart_t *)parameter;
+    free(parameter);
+
+    start.function(start.argument);
+
+    return 0;
+}
+
+void mutexInit(Mutex_t *mutex)
+{
+#if defined(_WIN32)
+    InitializeCriticalSection(&mutex->handle);
+#else
+    pthread_mutex_init(&mutex->handle, NULL);
+#endif
+}
+
+void mutexDestroy(Mutex_t *mutex)
+{
+#if defined(_WIN32)
+    DeleteCriticalSection(&mutex->handle);
+#else
+    pthread_mutex_destroy(&mutex->handle);
+#endif
+}
+
+void mutexLock(Mutex_t *mutex)
+{
+#if defined(_WIN32)
+    EnterCriticalSection(&mutex->handle);
+#else
+    pthread_mutex_lock(&mutex->handle);
+#endif
+}
+
+void mutexUnlock(Mutex_t *mutex)
+{
+#if defined(_WIN32)
+    LeaveCriticalSection(&mutex->handle);
+#else
+    pthread_mutex_unlock(&mutex->handle);
+#endif
+}
+
+void conditionInit(Condition_t *condition)
+{
+#if defined(_WIN32)
+    InitializeConditionVariable(&condition->handle);
+#else
+    pthread_cond_init(&condition->handle, NULL);
+#endif
+}
+
+void conditionDestroy(Condition_t *condition)
+{
+#if !defined(_WIN32)
+    pthread_cond_destroy(&condition->handle);
+#else
+    (void)condition;
+#endif
+}
+
+void conditionWait(Condition_t *condition, Mutex_t *mutex)
+{
+#if defined(_WIN32)
+    SleepConditionVariableCS(&condition->handle, &mutex->handle, INFINITE);
+#else
+    pthread_cond_wait(&condition->handle, &mutex->handle);
+#endif
+}
+
+void conditionSignal(Condition_t *condition)
+{
+#if defined(_WIN32)
+    WakeConditionVariable(&condition->handle);
+#else
+    pthread_cond_signal(&condition->handle);
+#endif
+}
+
+void conditionBroadcast(Condition_t *condition)
+{
+#if defined(_WIN32)
+    WakeAllConditionVariable(&condition->handle);
+#else
+    pthread_cond_broadcast(&condition->handle);
+#endif
+}
+
+bool threadCreate(Thread_t *thread, ThreadFunction_t function, void *argument)
+{
+    ThreadStart_t *start = (ThreadStart_t *)malloc(sizeof(ThreadStart_t));
+    if(start == NULL)
+    {
+        return false;
+    }
+    start->function = function;
+    start->argument = argument;
+
+#if defined(_WIN32)
+    thread->handle = CreateThread(NULL, 0, threadEntry, start, 0, NULL);
+    if(thread->handle == NULL)
+#else
+    if(pthread_create(&thread->handle, NULL, threadEntry, start) != 0)
+#endif
+    {
+        free(start);
+        return false;
+    }
+
+    return true;
+}
+
+void threadJoin(Thread_t *thread)
+{
+#if defined(_WIN32)
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, NULL);
+#endif
+}
+
+int threadHardwareConcurrency()
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int count = (int)info.dwNumberOfProcessors;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+    return (count > 0) ? count : 1;
+}
+
+void threadYield()
+{
+#if defined(_WIN32)
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+void threadSleepMilliseconds(unsigned int milliseconds)
+{
+#if defined(_WIN32)
+    Sleep(milliseconds);
+#else
+    struct timespec duration = { (time_t)(milliseconds / 1000), (long)(milliseconds % 1000) * 1000000L };
+    nanosleep(&duration, NULL);
+#endif
+}
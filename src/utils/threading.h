@@ -0,0 +1,133 @@
+#ifndef CILOGC80_THREADING_H
+#define CILOGC80_THREADING_H
+
+#include <stdbool.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/** @brief Storage class for per-thread variables (C99 has no _Thread_local) */
+#if defined(_MSC_VER)
+#define C80_THREAD_LOCAL __declspec(thread)
+#else
+#define C80_THREAD_LOCAL __thread
+#endif
+
+/**
+ * @brief Mutex wrapper around pthreads / Win32 critical sections
+ */
+typedef struct Mutex_t
+{
+#if defined(_WIN32)
+    CRITICAL_SECTION handle;
+#else
+    pthread_mutex_t handle;
+#endif
+} Mutex_t;
+
+/**
+ * @brief Condition variable, always used together with a @ref Mutex_t
+ */
+typedef struct Condition_t
+{
+#if defined(_WIN32)
+    CONDITION_VARIABLE handle;
+#else
+    pthread_cond_t handle;
+#endif
+} Condition_t;
+
+/**
+ * @brief Thread handle
+ */
+typedef struct Thread_t
+{
+#if defined(_WIN32)
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+} Thread_t;
+
+/**
+ * @brief Thread entry point
+ */
+typedef void (*ThreadFunction_t)(void *argument);
+
+void mutexInit(Mutex_t *mutex);
+void mutexDestroy(Mutex_t *mutex);
+void mutexLock(Mutex_t *mutex);
+void mutexUnlock(Mutex_t *mutex);
+
+void conditionInit(Condition_t *condition);
+void conditionDestroy(Condition_t *condition);
+/**
+ * @brief Releases the mutex, waits for a signal and locks the mutex again. Wakeups can be
+ * spurious, always wait in a loop checking the actual condition
+ * 
+ * @param condition 
+ * @param mutex 
+ */
+void conditionWait(Condition_t *condition, Mutex_t *mutex);
+void conditionSignal(Condition_t *condition);
+void conditionBroadcast(Condition_t *condition);
+
+/**
+ * @brief Starts a thread
+ * 
+ * @param thread 
+ * @param function 
+ * @param argument 
+ * @return bool False if the thread could not be created
+ */
+bool threadCreate(Thread_t *thread, ThreadFunction_t function, void *argument);
+/**
+ * @brief Waits until the thread returned
+ * 
+ * @param thread 
+ */
+void threadJoin(Thread_t *thread);
+/**
+ * @brief Returns the number of logical processors (at least 1)
+ * 
+ * @return int 
+ */
+int threadHardwareConcurrency();
+/**
+ * @brief Gives the rest of the time slice to another thread
+ * 
+ */
+void threadYield();
+/**
+ * @brief Suspends the calling thread
+ * 
+ * @param milliseconds 
+ */
+void threadSleepMilliseconds(unsigned int milliseconds);
+
+/* ---------------------------- Atomic operations --------------------------- */
+// Sequentially consistent, on long so the Win32 Interlocked functions fit
+#if defined(_MSC_VER)
+#define atomicLoad(pointer) InterlockedCompareExchange((pointer), 0, 0)
+#define atomicStore(pointer, value) InterlockedExchange((pointer), (value))
+#define atomicAdd(pointer, value) InterlockedExchangeAdd((pointer), (value))
+#else
+#define atomicLoad(pointer) __atomic_load_n((pointer), __ATOMIC_SEQ_CST)
+#define atomicStore(pointer, value) __atomic_store_n((pointer), (value), __ATOMIC_SEQ_CST)
+#define atomicAdd(pointer, value) __atomic_fetch_add((pointer), (value), __ATOMIC_SEQ_CST)
+#endif
+
+// 64 bit counters of single producer / single consumer queues, acquire / release ordered
+#if defined(_MSC_VER)
+#define atomicLoadAcquire64(pointer) ((qword_t)InterlockedCompareExchange64((volatile LONG64 *)(pointer), 0, 0))
+#define atomicStoreRelease64(pointer, value) InterlockedExchange64((volatile LONG64 *)(pointer), (LONG64)(value))
+#else
+#define atomicLoadAcquire64(pointer) __atomic_load_n((pointer), __ATOMIC_ACQUIRE)
+#define atomicStoreRelease64(pointer, value) __atomic_store_n((pointer), (value), __ATOMIC_RELEASE)
+#endif
+/* -------------------------------------------------------------------------- */
+
+#endif //CILOGC80_THREADING_H
@@ -0,0 +1,129 @@
+#include "unity.h"
+#include "thread_pool.h"
+
+#define TASK_COUNT 1000
+#define SLICES_PER_TASK 5
+
+typedef struct
+{
+    long slices;
+    long runCount;
+} CounterTask_t;
+
+static CounterTask_t tasks[TASK_COUNT];
+static ThreadPool_t pool;
+
+static long isGateOpen;
+static long sliceOrder[2 * SLICES_PER_TASK];
+static long sliceOrderCount;
+
+static ThreadPoolTaskStatus countSlices(void *argument)
+{
+    CounterTask_t *task = (CounterTask_t *)argument;
+
+    task->runCount++;
+    task->slices--;
+
+    return (task->slices > 0) ? THREAD_POOL_TASK_YIELD : THREAD_POOL_TASK_DONE;
+}
+
+static ThreadPoolTaskStatus waitForGate(void *argument)
+{
+    (void)argument;
+
+    while(atomicLoad(&isGateOpen) == 0)
+    {
+        threadYield();
+    }
+
+    return THREAD_POOL_TASK_DONE;
+}
+
+static ThreadPoolTaskStatus recordSlices(void *argument)
+{
+    CounterTask_t *task = (CounterTask_t *)argument;
+
+    sliceOrder[sliceOrderCount++] = (long)(task - tasks);
+
+    return countSlices(argument);
+}
+
+void setUp(void)
+{
+    for(int i = 0; i < TASK_COUNT; i++)
+    {
+        tasks[i].slices = SLICES_PER_TASK;
+        tasks[i].runCount = 0;
+    }
+}
+
+void tearDown(void)
+{
+    // Cleanup resources after each test.
+}
+
+void test_thread_pool_runs_every_slice_once(void)
+{
+    TEST_ASSERT_TRUE(threadPoolInit(&pool, 4));
+
+    for(int i = 0; i < TASK_COUNT; i++)
+    {
+        TEST_ASSERT_TRUE(threadPoolSubmit(&pool, countSlices, &tasks[i]));
+    }
+    threadPoolWait(&pool);
+
+    long sliceCount = 0;
+    for(int i = 0; i < pool.workerCount; i++)
+    {
+        sliceCount += pool.workers[i].sliceCount;
+    }
+    threadPoolDestroy(&pool);
+
+    for(int i = 0; i < TASK_COUNT; i++)
+    {
+        TEST_ASSERT_EQUAL(SLICES_PER_TASK, tasks[i].runCount);
+    }
+    TEST_ASSERT_EQUAL(TASK_COUNT * SLICES_PER_TASK, sliceCount);
+}
+
+void test_thread_pool_can_be_reused_after_wait(void)
+{
+    TEST_ASSERT_TRUE(threadPoolInit(&pool, 2));
+
+    threadPoolSubmit(&pool, countSlices, &tasks[0]);
+    threadPoolWait(&pool);
+    TEST_ASSERT_EQUAL(SLICES_PER_TASK, tasks[0].runCount);
+
+    threadPoolSubmit(&pool, countSlices, &tasks[1]);
+    threadPoolDestroy(&pool);
+    TEST_ASSERT_EQUAL(SLICES_PER_TASK, tasks[1].runCount);
+}
+
+void test_thread_pool_yielded_tasks_take_turns(void)
+{
+    TEST_ASSERT_TRUE(threadPoolInit(&pool, 1));
+    atomicStore(&isGateOpen, 0);
+    sliceOrderCount = 0;
+
+    // Keep the only worker busy until both tasks are queued
+    threadPoolSubmit(&pool, waitForGate, NULL);
+    threadPoolSubmit(&pool, recordSlices, &tasks[0]);
+    threadPoolSubmit(&pool, recordSlices, &tasks[1]);
+    atomicStore(&isGateOpen, 1);
+    threadPoolDestroy(&pool);
+
+    TEST_ASSERT_EQUAL(2 * SLICES_PER_TASK, sliceOrderCount);
+    for(int i = 1; i < sliceOrderCount; i++)
+    {
+        TEST_ASSERT_TRUE(sliceOrder[i] != sliceOrder[i - 1]);
+    }
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_thread_pool_runs_every_slice_once);
+    RUN_TEST(test_thread_pool_can_be_reused_after_wait);
+    RUN_TEST(test_thread_pool_yielded_tasks_take_turns);
+    return UNITY_END();
+}
@@ -0,0 +1,104 @@
+#include "unity.h"
+#include "bench_compare.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_CYCLES 1000000ULL
+#define TEST_RUNS 7
+#define TEST_BASELINE_FILE "test_bench_compare.json"
+
+static BenchmarkResult_t baseline;
+static BenchmarkResult_t current;
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+    remove(TEST_BASELINE_FILE);
+}
+
+/**
+ * @brief Fills a result with runs around a speed, +- 1 % jitter
+ */
+static void makeResult(BenchmarkResult_t *result, const char *name, double mhz)
+{
+    static const double jitter[TEST_RUNS] = { 1.00, 0.99, 1.01, 0.995, 1.005, 0.998, 1.002 };
+
+    memset(result, 0x00, sizeof(BenchmarkResult_t));
+    strncpy(result->name, name, BENCHMARK_MAX_NAME - 1);
+    result->isRun = true;
+    result->runCount = TEST_RUNS;
+    result->cycles = TEST_CYCLES;
+    result->instructions = TEST_CYCLES / 4;
+
+    for(int run = 0; run < TEST_RUNS; run++)
+    {
+        result->nanoseconds[run] = (qword_t)((double)TEST_CYCLES / (mhz * jitter[run]) * 1e3);
+    }
+
+    benchmarkSummarize(result);
+}
+
+void test_bench_compare_same_speed_is_unchanged(void)
+{
+    makeResult(&baseline, "sieve", 500.0);
+    makeResult(&current, "sieve", 500.0);
+
+    BenchComparison_t comparison = benchCompare(&baseline, &current, BENCH_COMPARE_DEFAULT_THRESHOLD);
+
+    TEST_ASSERT_EQUAL(BENCH_VERDICT_UNCHANGED, comparison.verdict);
+    TEST_ASSERT_TRUE(comparison.ratioLow <= 1.0 && comparison.ratioHigh >= 1.0);
+}
+
+void test_bench_compare_detects_regression_and_speedup(void)
+{
+    makeResult(&baseline, "sieve", 500.0);
+    makeResult(&current, "sieve", 400.0);
+
+    TEST_ASSERT_EQUAL(BENCH_VERDICT_REGRESSION, benchCompare(&baseline, &current, 0.05).verdict);
+    TEST_ASSERT_EQUAL(BENCH_VERDICT_FASTER, benchCompare(&current, &baseline, 0.05).verdict);
+    // 20 % slower is below a 30 % threshold
+    TEST_ASSERT_EQUAL(BENCH_VERDICT_UNCHANGED, benchCompare(&baseline, &current, 0.30).verdict);
+    TEST_ASSERT_EQUAL(BENCH_VERDICT_NEW, benchCompare(NULL, &current, 0.05).verdict);
+}
+
+void test_bench_compare_baseline_round_trip(void)
+{
+    BenchmarkResult_t results[2];
+    BenchmarkConfig_t config = benchmarkDefaultConfig();
+    BenchBaseline_t loaded;
+
+    makeResult(&results[0], "crc16", 600.0);
+    makeResult(&results[1], "quote\"name", 300.0);
+
+    FILE *file = fopen(TEST_BASELINE_FILE, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    benchmarkWriteJson(file, &config, results, 2);
+    fclose(file);
+
+    TEST_ASSERT_TRUE(benchBaselineLoad(TEST_BASELINE_FILE, &loaded));
+    TEST_ASSERT_EQUAL(2, loaded.count);
+
+    const BenchmarkResult_t *result = benchBaselineFind(&loaded, "quote\"name");
+    TEST_ASSERT_NOT_NULL(result);
+    TEST_ASSERT_EQUAL(TEST_RUNS, result->runCount);
+    TEST_ASSERT_EQUAL(TEST_CYCLES, result->cycles);
+    TEST_ASSERT_EQUAL(results[1].nanoseconds[3], result->nanoseconds[3]);
+    TEST_ASSERT_TRUE(result->medianMHz > 299.0 && result->medianMHz < 301.0);
+
+    TEST_ASSERT_EQUAL(0, benchCompareAll(stdout, &loaded, results, 2, BENCH_COMPARE_DEFAULT_THRESHOLD));
+
+    benchBaselineDestroy(&loaded);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_compare_same_speed_is_unchanged);
+    RUN_TEST(test_bench_compare_detects_regression_and_speedup);
+    RUN_TEST(test_bench_compare_baseline_round_trip);
+    return UNITY_END();
+}
@@ -0,0 +1,455 @@
+#include "unity.h"
+#include "alu.h"
+#include "cpu.h"
+#include "lane_core.h"
+#include "utils/error_handler.h"
+
+#include <stdint.h>
+#include <string.h>
+
+// S Z H P N C, bits 3 and 5 are not modeled
+#define DOCUMENTED_FLAGS 0xD7
+
+// ADD A,B ... CP B
+#define OPCODE_ALU_B(operation) (byte_t)(0x80 | ((operation) << 3))
+#define OPCODE_INC_A 0x3C
+#define OPCODE_DEC_A 0x3D
+// NEG is ED 44
+#define OPCODE_MISC_PREFIX 0xED
+#define OPCODE_NEG 0x44
+
+// RLCA, RRCA, RLA, RRA, DAA, CPL, SCF, CCF
+static const byte_t accumulatorOpcodes[] = { 0x07, 0x0F, 0x17, 0x1F, 0x27, 0x2F, 0x37, 0x3F };
+
+static ZilogZ80_t cpu;
+static LaneCore_t core;
+
+/* ----------------------------- Reference model ---------------------------- */
+// Written from the Z80 user manual tables, independent of alu.h
+
+static byte_t referenceParity(byte_t value)
+{
+    int count = 0;
+    for(int bit = 0; bit < 8; bit++)
+    {
+        count += (value >> bit) & 0x01;
+    }
+
+    return (count % 2 == 0) ? ALU_FLAG_P : 0;
+}
+
+static byte_t referenceSignZero(byte_t value)
+{
+    return (byte_t)(((value & 0x80) ? ALU_FLAG_S : 0) | ((value == 0) ? ALU_FLAG_Z : 0));
+}
+
+/**
+ * @brief A after an 8 bit ALU operation with operand b, flags in *flags
+ */
+static byte_t referenceAlu(AluOperation operation, byte_t a, byte_t b, int carry, byte_t *flags)
+{
+    int carryIn = (operation == ALU_ADC || operation == ALU_SBC) ? carry : 0;
+    int full, signedResult;
+    bool isHalfCarry;
+    byte_t result;
+
+    switch(operation)
+    {
+        case ALU_ADD:
+        case ALU_ADC:
+            full = a + b + carryIn;
+            signedResult = (int8_t)a + (int8_t)b + carryIn;
+            isHalfCarry = (a & 0x0F) + (b & 0x0F) + carryIn > 0x0F;
+            result = (byte_t)full;
+            *flags = (byte_t)(referenceSignZero(result) | (isHalfCarry ? ALU_FLAG_H : 0)
+                              | ((signedResult < -128 || signedResult > 127) ? ALU_FLAG_P : 0)
+                              | ((full > 0xFF) ? ALU_FLAG_C : 0));
+            return result;
+
+        case ALU_SUB:
+        case ALU_SBC:
+        case ALU_CP:
+            full = a - b - carryIn;
+            signedResult = (int8_t)a - (int8_t)b - carryIn;
+            isHalfCarry = (a & 0x0F) - (b & 0x0F) - carryIn < 0;
+            result = (byte_t)full;
+            *flags = (byte_t)(referenceSignZero(result) | (isHalfCarry ? ALU_FLAG_H : 0)
+                              | ((signedResult < -128 || signedResult > 127) ? ALU_FLAG_P : 0) | ALU_FLAG_N
+                              | ((full < 0) ? ALU_FLAG_C : 0));
+            return (operation == ALU_CP) ? a : result;
+
+        case ALU_AND:
+            result = a & b;
+            *flags = (byte_t)(referenceSignZero(result) | ALU_FLAG_H | referenceParity(result));
+            return result;
+
+        case ALU_XOR:
+            result = a ^ b;
+            *flags = (byte_t)(referenceSignZero(result) | referenceParity(result));
+            return result;
+
+        case ALU_OR:
+        default:
+            result = a | b;
+            *flags = (byte_t)(referenceSignZero(result) | referenceParity(result));
+            return result;
+    }
+}
+
+/**
+ * @brief Value after INC or DEC, C of flags is kept
+ */
+static byte_t referenceIncDec(byte_t value, bool isDecrement, byte_t flags, byte_t *newFlags)
+{
+    byte_t result = (byte_t)(isDecrement ? value - 1 : value + 1);
+    bool isHalfCarry = isDecrement ? (value & 0x0F) == 0x00 : (value & 0x0F) == 0x0F;
+    bool isOverflow = isDecrement ? value == 0x80 : value == 0x7F;
+
+    *newFlags = (byte_t)(referenceSignZero(result) | (isHalfCarry ? ALU_FLAG_H : 0) | (isOverflow ? ALU_FLAG_P : 0)
+                         | (isDecrement ? ALU_FLAG_N : 0) | (flags & ALU_FLAG_C));
+
+    return result;
+}
+
+/**
+ * @brief A after NEG: P only for 0x80, C for everything but 0, H on a borrow from bit 4
+ */
+static byte_t referenceNeg(byte_t a, byte_t *newFlags)
+{
+    byte_t result = (byte_t)(0x100 - a);
+
+    *newFlags = (byte_t)(referenceSignZero(result) | (((a & 0x0F) != 0) ? ALU_FLAG_H : 0)
+                         | ((a == 0x80) ? ALU_FLAG_P : 0) | ALU_FLAG_N | ((a != 0) ? ALU_FLAG_C : 0));
+
+    return result;
+}
+
+/**
+ * @brief DAA after the correction table of the Z80 user manual (by nibbles, H and C)
+ */
+static byte_t referenceDaa(byte_t a, byte_t flags, byte_t *newFlags)
+{
+    int high = a >> 4;
+    int low = a & 0x0F;
+    bool c = (flags & ALU_FLAG_C) != 0;
+    bool h = (flags & ALU_FLAG_H) != 0;
+    bool n = (flags & ALU_FLAG_N) != 0;
+    int correction;
+    bool isCarry;
+
+    if(c == false && high <= 9 && h == false && low <= 9)
+    {
+        correction = 0x00;
+    }
+    else if(c == false && ((high <= 9 && h == true && low <= 9) || (high <= 8 && low >= 10)))
+    {
+        correction = 0x06;
+    }
+    else if((c == false && high >= 10 && h == false && low <= 9) || (c == true && h == false && low <= 9))
+    {
+        correction = 0x60;
+    }
+    else
+    {
+        correction = 0x66;
+    }
+
+    isCarry = c == true || high >= 10 || (high >= 9 && low >= 10);
+
+    byte_t result = (byte_t)(n ? a - correction : a + correction);
+    bool isHalfCarry = n ? (h == true && low <= 5) : (low >= 10);
+
+    *newFlags = (byte_t)(referenceSignZero(result) | (isHalfCarry ? ALU_FLAG_H : 0) | referenceParity(result)
+                         | (flags & ALU_FLAG_N) | (isCarry ? ALU_FLAG_C : 0));
+
+    return result;
+}
+
+/**
+ * @brief A after one of accumulatorOpcodes
+ */
+static byte_t referenceAccumulator(byte_t opcode, byte_t a, byte_t flags, byte_t *newFlags)
+{
+    byte_t kept = (byte_t)(flags & (ALU_FLAG_S | ALU_FLAG_Z | ALU_FLAG_P));
+    byte_t carry = flags & ALU_FLAG_C;
+
+    switch(opcode)
+    {
+        case 0x07:
+            *newFlags = (byte_t)(kept | (a >> 7));
+            return (byte_t)((a << 1) | (a >> 7));
+        case 0x0F:
+            *newFlags = (byte_t)(kept | (a & 0x01));
+            return (byte_t)((a >> 1) | (a << 7));
+        case 0x17:
+            *newFlags = (byte_t)(kept | (a >> 7));
+            return (byte_t)((a << 1) | carry);
+        case 0x1F:
+            *newFlags = (byte_t)(kept | (a & 0x01));
+            return (byte_t)((a >> 1) | (carry << 7));
+        case 0x27:
+            return referenceDaa(a, flags, newFlags);
+        case 0x2F:
+            *newFlags = (byte_t)(flags | ALU_FLAG_H | ALU_FLAG_N);
+            return (byte_t)~a;
+        case 0x37:
+            *newFlags = (byte_t)(kept | ALU_FLAG_C);
+            return a;
+        case 0x3F:
+        default:
+            *newFlags = (byte_t)(kept | (carry ? ALU_FLAG_H : ALU_FLAG_C));
+            return a;
+    }
+}
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Runs opcode at 0x0000 once on the reference core, returns the flags
+ */
+static byte_t stepReferenceCore(byte_t opcode, byte_t a, byte_t b, byte_t flags)
+{
+    cpu.rom.data[0x0000] = opcode;
+    cpu.PC = 0x0000;
+    cpu.A = a;
+    cpu.B = b;
+    cpu.F = zilogZ80FlagsFromByte(flags);
+
+    zilogZ80Step(&cpu);
+
+    return zilogZ80FlagsToByte(cpu.F);
+}
+
+/**
+ * @brief Runs opcode at 0x0000 on all lanes, lane n with A = firstA + n * stepA and
+ * B = firstB + n * stepB
+ */
+static void stepLaneCore(byte_t opcode, int firstA, int stepA, int firstB, int stepB, byte_t flags)
+{
+    for(int lane = 0; lane < LANE_COUNT; lane++)
+    {
+        laneCoreMemory(&core, lane)[0x0000] = opcode;
+        core.PC[lane] = 0x0000;
+        core.registers[LANE_REGISTER_A][lane] = (byte_t)(firstA + lane * stepA);
+        core.registers[LANE_REGISTER_B][lane] = (byte_t)(firstB + lane * stepB);
+        core.F[lane] = flags;
+    }
+
+    TEST_ASSERT_EQUAL(LANE_COUNT, laneCoreStep(&core));
+}
+
+void setUp(void)
+{
+    zilogZ80Init(&cpu);
+    TEST_ASSERT_TRUE(laneCoreInit(&core));
+}
+
+void tearDown(void)
+{
+    laneCoreDestroy(&core);
+    memoryDestroy(&cpu.rom);
+    memoryDestroy(&cpu.ram);
+}
+
+void test_alu_helpers_match_reference_model(void)
+{
+    byte_t flags[0x100];
+    byte_t expected;
+    byte_t result;
+
+    for(int operation = ALU_ADD; operation <= ALU_CP; operation++)
+    {
+        for(int carry = 0; carry <= 1; carry++)
+        {
+            for(int a = 0; a < 0x100; a++)
+            {
+                // One row of operands at a time, the loop bodies are branch free like the lane kernels
+                if(operation == ALU_AND || operation == ALU_XOR || operation == ALU_OR)
+                {
+                    for(int b = 0; b < 0x100; b++)
+                    {
+                        byte_t value = (byte_t)((operation == ALU_AND) ? a & b : (operation == ALU_XOR) ? a ^ b : a | b);
+                        flags[b] = aluLogicFlags(value, operation == ALU_AND);
+                    }
+                }
+                else
+                {
+                    bool isSubstraction = operation >= ALU_SUB;
+                    int carryIn = (operation == ALU_ADC || operation == ALU_SBC) ? carry : 0;
+                    for(int b = 0; b < 0x100; b++)
+                    {
+                        word_t full = isSubstraction ? (word_t)(a - b - carryIn) : (word_t)(a + b + carryIn);
+                        flags[b] = aluFlags((byte_t)a, (byte_t)b, full, isSubstraction);
+                    }
+                }
+
+                for(int b = 0; b < 0x100; b++)
+                {
+                    referenceAlu((AluOperation)operation, (byte_t)a, (byte_t)b, carry, &expected);
+                    TEST_ASSERT_EQUAL_HEX8(expected, flags[b]);
+                }
+            }
+        }
+    }
+
+    for(int value = 0; value < 0x100; value++)
+    {
+        for(int flagsIn = 0; flagsIn < 0x100; flagsIn++)
+        {
+            referenceIncDec((byte_t)value, false, (byte_t)flagsIn, &expected);
+            TEST_ASSERT_EQUAL_HEX8(expected, aluIncDecFlags((byte_t)value, false, (byte_t)flagsIn));
+            referenceIncDec((byte_t)value, true, (byte_t)flagsIn, &expected);
+            TEST_ASSERT_EQUAL_HEX8(expected, aluIncDecFlags((byte_t)value, true, (byte_t)flagsIn));
+
+            byte_t expectedA = referenceDaa((byte_t)value, (byte_t)flagsIn, &expected);
+            TEST_ASSERT_EQUAL_HEX8(expected, aluDaa((byte_t)value, (byte_t)flagsIn, &result));
+            TEST_ASSERT_EQUAL_HEX8(expectedA, result);
+        }
+    }
+
+    // NEG is SUB with A = 0
+    for(int a = 0; a < 0x100; a++)
+    {
+        referenceNeg((byte_t)a, &expected);
+        TEST_ASSERT_EQUAL_HEX8(expected, aluFlags(0x00, (byte_t)a, (word_t)(0 - a), true));
+    }
+
+    // The cases of the original P/V bug: parity instead of overflow
+    TEST_ASSERT_EQUAL_HEX8(0x00, aluIncDecFlags(0x05, false, 0x00));
+    TEST_ASSERT_EQUAL_HEX8(ALU_FLAG_S | ALU_FLAG_H | ALU_FLAG_P, aluIncDecFlags(0x7F, false, 0x00));
+}
+
+void test_reference_core_matches_reference_model(void)
+{
+    byte_t expected;
+
+    for(int operation = ALU_ADD; operation <= ALU_CP; operation++)
+    {
+        for(int carry = 0; carry <= 1; carry++)
+        {
+            // Every other flag set or clear, so stale flags show up
+            byte_t flagsIn = carry ? DOCUMENTED_FLAGS : 0x00;
+
+            for(int a = 0; a < 0x100; a++)
+            {
+                for(int b = 0; b < 0x100; b++)
+                {
+                    byte_t expectedA = referenceAlu((AluOperation)operation, (byte_t)a, (byte_t)b, carry, &expected);
+                    byte_t flags = stepReferenceCore(OPCODE_ALU_B(operation), (byte_t)a, (byte_t)b, flagsIn);
+
+                    TEST_ASSERT_EQUAL_HEX8(expectedA, cpu.A);
+                    TEST_ASSERT_EQUAL_HEX8(expected, flags);
+                }
+            }
+        }
+    }
+
+    for(int value = 0; value < 0x100; value++)
+    {
+        for(int flagsIn = 0; flagsIn < 0x100; flagsIn++)
+        {
+            byte_t documented = (byte_t)(flagsIn & DOCUMENTED_FLAGS);
+
+            for(int isDecrement = 0; isDecrement <= 1; isDecrement++)
+            {
+                byte_t expectedA = referenceIncDec((byte_t)value, isDecrement, documented, &expected);
+                byte_t flags = stepReferenceCore(isDecrement ? OPCODE_DEC_A : OPCODE_INC_A, (byte_t)value, 0, documented);
+
+                TEST_ASSERT_EQUAL_HEX8(expectedA, cpu.A);
+                TEST_ASSERT_EQUAL_HEX8(expected, flags);
+            }
+
+            for(size_t idx = 0; idx < sizeof(accumulatorOpcodes); idx++)
+            {
+                byte_t expectedA = referenceAccumulator(accumulatorOpcodes[idx], (byte_t)value, documented, &expected);
+                byte_t flags = stepReferenceCore(accumulatorOpcodes[idx], (byte_t)value, 0, documented);
+
+                TEST_ASSERT_EQUAL_HEX8(expectedA, cpu.A);
+                TEST_ASSERT_EQUAL_HEX8(expected, flags);
+            }
+        }
+    }
+
+    // INC A taking 5 to 6 leaves P clear
+    TEST_ASSERT_EQUAL_HEX8(0x00, stepReferenceCore(OPCODE_INC_A, 0x05, 0, 0x00));
+    TEST_ASSERT_EQUAL_HEX8(0x06, cpu.A);
+
+    // The ED group is not dispatched yet, so NEG can not be reached: ED 44 has to report an
+    // invalid opcode and leave A alone. Once it is decoded this becomes a model check over
+    // every A like the ones above
+    clearAllErrors();
+    cpu.rom.data[0x0001] = OPCODE_NEG;
+    stepReferenceCore(OPCODE_MISC_PREFIX, 0x01, 0, 0x00);
+    TEST_ASSERT_TRUE(hasError(C80_ERROR_CPU_INVALID_OPCODE));
+    TEST_ASSERT_EQUAL_HEX8(0x01, cpu.A);
+    clearAllErrors();
+}
+
+void test_lane_core_matches_reference_model(void)
+{
+    byte_t expected;
+
+    for(int operation = ALU_ADD; operation <= ALU_CP; operation++)
+    {
+        TEST_ASSERT_TRUE(laneCoreIsVectorOpcode(OPCODE_ALU_B(operation)));
+
+        for(int carry = 0; carry <= 1; carry++)
+        {
+            // Bits 3 and 5 must survive the kernels
+            byte_t flagsIn = carry ? 0xFF : 0x28;
+
+            for(int a = 0; a < 0x100; a++)
+            {
+                for(int firstB = 0; firstB < 0x100; firstB += LANE_COUNT)
+                {
+                    stepLaneCore(OPCODE_ALU_B(operation), a, 0, firstB, 1, flagsIn);
+
+                    for(int lane = 0; lane < LANE_COUNT; lane++)
+                    {
+                        byte_t expectedA = referenceAlu((AluOperation)operation, (byte_t)a, (byte_t)(firstB + lane), carry,
+                                                        &expected);
+
+                        TEST_ASSERT_EQUAL_HEX8(expectedA, core.registers[LANE_REGISTER_A][lane]);
+                        TEST_ASSERT_EQUAL_HEX8(expected | 0x28, core.F[lane]);
+                    }
+                }
+            }
+        }
+    }
+
+    for(int isDecrement = 0; isDecrement <= 1; isDecrement++)
+    {
+        byte_t opcode = isDecrement ? OPCODE_DEC_A : OPCODE_INC_A;
+        TEST_ASSERT_TRUE(laneCoreIsVectorOpcode(opcode));
+
+        for(int flagsIn = 0; flagsIn < 0x100; flagsIn++)
+        {
+            for(int firstA = 0; firstA < 0x100; firstA += LANE_COUNT)
+            {
+                stepLaneCore(opcode, firstA, 1, 0, 0, (byte_t)flagsIn);
+
+                for(int lane = 0; lane < LANE_COUNT; lane++)
+                {
+                    byte_t expectedA = referenceIncDec((byte_t)(firstA + lane), isDecrement, (byte_t)flagsIn, &expected);
+
+                    TEST_ASSERT_EQUAL_HEX8(expectedA, core.registers[LANE_REGISTER_A][lane]);
+                    TEST_ASSERT_EQUAL_HEX8(expected | (flagsIn & 0x28), core.F[lane]);
+                }
+            }
+        }
+    }
+
+    // Every step ran on the kernels
+    TEST_ASSERT_EQUAL(0, core.scalarLaneSteps);
+
+    // NEG (ED 44) has no kernel and no decoded scalar handler yet, see the reference core test
+    TEST_ASSERT_FALSE(laneCoreIsVectorOpcode(OPCODE_MISC_PREFIX));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_alu_helpers_match_reference_model);
+    RUN_TEST(test_reference_core_matches_reference_model);
+    RUN_TEST(test_lane_core_matches_reference_model);
+    return UNITY_END();
+}
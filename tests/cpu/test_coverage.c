@@ -0,0 +1,171 @@
+#include "unity.h"
+#include "cpu.h"
+#include "coverage.h"
+
+#include <string.h>
+
+static ZilogZ80_t cpu;
+static Coverage_t *coverage;
+
+// 0x0000: LD SP,0xF000 / CALL outer / HALT
+// 0x0010: outer: CALL inner / RET
+// 0x0020: inner: LD B,0x10 / loop: DEC B / JP NZ,loop / RET
+static const byte_t program[][2] = { { 0x00, 0x31 }, { 0x01, 0x00 }, { 0x02, 0xF0 }, { 0x03, 0xCD }, { 0x04, 0x10 },
+                                     { 0x05, 0x00 }, { 0x06, 0x76 },
+                                     { 0x10, 0xCD }, { 0x11, 0x20 }, { 0x12, 0x00 }, { 0x13, 0xC9 },
+                                     { 0x20, 0x06 }, { 0x21, 0x10 }, { 0x22, 0x05 }, { 0x23, 0xC2 }, { 0x24, 0x22 },
+                                     { 0x25, 0x00 }, { 0x26, 0xC9 } };
+
+/**
+ * @brief Writes the coverage as lcov (isLcov) or JSON to a buffer
+ */
+static void writeReport(bool isLcov, const SymbolTable_t *symbols, char *buffer, size_t bufferSize)
+{
+    FILE *stream = tmpfile();
+    TEST_ASSERT_NOT_NULL(stream);
+
+    TEST_ASSERT_TRUE(isLcov ? coverageWriteLcov(coverage, stream, "test.bin", symbols)
+                            : coverageWriteJson(coverage, stream, symbols));
+    rewind(stream);
+
+    size_t length = fread(buffer, 1, bufferSize - 1, stream);
+    buffer[length] = '\0';
+    fclose(stream);
+}
+
+void setUp(void)
+{
+    zilogZ80Init(&cpu);
+    coverage = coverageCreate();
+    TEST_ASSERT_NOT_NULL(coverage);
+
+    for(size_t idx = 0; idx < sizeof(program) / sizeof(program[0]); idx++)
+    {
+        cpu.rom.data[program[idx][0]] = program[idx][1];
+    }
+}
+
+void tearDown(void)
+{
+    cpu.coverage = NULL;
+    coverageDestroy(coverage);
+    memoryDestroy(&cpu.rom);
+    memoryDestroy(&cpu.ram);
+}
+
+void test_coverage_records_addresses_and_edges(void)
+{
+    cpu.coverage = coverage;
+    zilogZ80Run(&cpu, 10000);
+
+    // LD SP, CALL, HALT, CALL, RET, LD B, DEC B, JP NZ, RET
+    TEST_ASSERT_EQUAL(9, coverage->addressCount);
+    TEST_ASSERT_TRUE(coverageIsExecuted(coverage, 0x0023));
+    TEST_ASSERT_FALSE(coverageIsExecuted(coverage, 0x0024));
+
+    // Both sides of JP NZ, the calls and the returns
+    TEST_ASSERT_EQUAL(6, coverage->edgeCount);
+    TEST_ASSERT_EQUAL(15, coverageEdgeHits(coverage, 0x0023, 0x0022));
+    TEST_ASSERT_EQUAL(1, coverageEdgeHits(coverage, 0x0023, 0x0026));
+    TEST_ASSERT_EQUAL(1, coverageEdgeHits(coverage, 0x0026, 0x0013));
+    TEST_ASSERT_EQUAL(0, coverageEdgeHits(coverage, 0x0022, 0x0023));
+
+    TEST_ASSERT_EQUAL(COVERAGE_BRANCH_CONDITIONAL, coverageBranchKind(OPCODE_GROUP_MAIN, 0x10));
+    TEST_ASSERT_EQUAL(COVERAGE_BRANCH_CONDITIONAL, coverageBranchKind(OPCODE_GROUP_ED, 0xB0));
+    TEST_ASSERT_EQUAL(COVERAGE_BRANCH_ALWAYS, coverageBranchKind(OPCODE_GROUP_ED, 0x4D));
+    TEST_ASSERT_EQUAL(COVERAGE_BRANCH_ALWAYS, coverageBranchKind(OPCODE_GROUP_FD, 0xE9));
+    TEST_ASSERT_EQUAL(COVERAGE_BRANCH_NONE, coverageBranchKind(OPCODE_GROUP_ED, 0xA0));
+}
+
+void test_coverage_merge_counts_new_entries(void)
+{
+    Coverage_t *other = coverageCreate();
+    TEST_ASSERT_NOT_NULL(other);
+
+    cpu.coverage = coverage;
+    zilogZ80Run(&cpu, 10000);
+
+    // Everything is new to an empty map, nothing the second time
+    TEST_ASSERT_EQUAL(9 + 6, coverageMerge(other, coverage));
+    TEST_ASSERT_EQUAL(0, coverageMerge(other, coverage));
+    TEST_ASSERT_EQUAL(30, coverageEdgeHits(other, 0x0023, 0x0022));
+
+    // JP NZ not taken at its first execution: one new address, one new edge
+    coverageClear(coverage);
+    TEST_ASSERT_EQUAL(0, coverage->addressCount);
+    coverageRecord(coverage, 0x0023, OPCODE_GROUP_MAIN, 0xC2, 0x0026);
+    coverageRecord(coverage, 0x0030, OPCODE_GROUP_MAIN, 0x00, 0x0031);
+    TEST_ASSERT_EQUAL(1, coverageMerge(other, coverage));
+    TEST_ASSERT_EQUAL(10, other->addressCount);
+    TEST_ASSERT_EQUAL(6, other->edgeCount);
+
+    coverageDestroy(other);
+}
+
+void test_coverage_spreads_edges_to_one_target(void)
+{
+    // Calls from 256 sites into the same routine share the low bits of their hash key
+    for(word_t site = 0; site < 256; site++)
+    {
+        coverageRecord(coverage, (word_t)(site * 16), OPCODE_GROUP_MAIN, 0xCD, 0x4000);
+    }
+    TEST_ASSERT_EQUAL(256, coverage->edgeCount);
+    TEST_ASSERT_EQUAL(1, coverageEdgeHits(coverage, 0x0FF0, 0x4000));
+
+    // They must not pile up in one probe sequence
+    size_t run = 0;
+    size_t longestRun = 0;
+    for(size_t idx = 0; idx < coverage->edgeCapacity; idx++)
+    {
+        run = (coverage->edges[idx].hits != 0) ? run + 1 : 0;
+        longestRun = (run > longestRun) ? run : longestRun;
+    }
+    TEST_ASSERT_TRUE(longestRun < 32);
+}
+
+void test_coverage_reports_branches_and_symbols(void)
+{
+    SymbolTable_t symbols;
+    char output[4096];
+
+    symbolTableInit(&symbols);
+    symbolTableAdd(&symbols, "main", 0x0000);
+    symbolTableAdd(&symbols, "outer", 0x0010);
+    symbolTableAdd(&symbols, "inner", 0x0020);
+    symbolTableAdd(&symbols, "loop", 0x0022);
+    symbolTableSort(&symbols);
+
+    cpu.coverage = coverage;
+    zilogZ80Run(&cpu, 10000);
+
+    // Line n is address n - 1
+    writeReport(true, &symbols, output, sizeof(output));
+    TEST_ASSERT_NOT_NULL(strstr(output, "SF:test.bin\n"));
+    TEST_ASSERT_NOT_NULL(strstr(output, "FN:17,outer\n"));
+    TEST_ASSERT_NOT_NULL(strstr(output, "FNDA:1,main\n"));
+    TEST_ASSERT_NOT_NULL(strstr(output, "FNDA:15,loop\n"));
+    TEST_ASSERT_NOT_NULL(strstr(output, "BRDA:36,0,0,15\nBRDA:36,0,1,1\n"));
+    TEST_ASSERT_NOT_NULL(strstr(output, "BRF:2\nBRH:2\n"));
+    TEST_ASSERT_NOT_NULL(strstr(output, "DA:1,1\n"));
+    TEST_ASSERT_NULL(strstr(output, "DA:2,"));
+    TEST_ASSERT_NOT_NULL(strstr(output, "LH:9\nend_of_record\n"));
+
+    writeReport(false, &symbols, output, sizeof(output));
+    TEST_ASSERT_NOT_NULL(strstr(output, "\"address_count\": 9,"));
+    TEST_ASSERT_NOT_NULL(strstr(output, "\"ranges\": [[0, 6], [16, 19], [32, 38]]"));
+    TEST_ASSERT_NOT_NULL(strstr(output, "{\"name\": \"inner\", \"address\": 32, \"entries\": 1, \"executed\": 1}"));
+    TEST_ASSERT_NOT_NULL(strstr(output, "{\"from\": 35, \"to\": 34, \"hits\": 15, \"conditional\": true, "
+                                        "\"from_symbol\": \"loop+0x1\", \"to_symbol\": \"loop\"}"));
+
+    symbolTableDestroy(&symbols);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_coverage_records_addresses_and_edges);
+    RUN_TEST(test_coverage_merge_counts_new_entries);
+    RUN_TEST(test_coverage_spreads_edges_to_one_target);
+    RUN_TEST(test_coverage_reports_branches_and_symbols);
+    return UNITY_END();
+}
@@ -55,10 +55,40 @@ void test_cpu_init_function(void)
     0, 0, 0, 0, 0, 0, 0);
 }
 
+void test_cpu_watchpoint_log_goes_to_the_log_stream(void)
+{
+    // LD A,0x42 / LD (0x8000),A / HALT
+    static const byte_t program[] = { 0x3E, 0x42, 0x32, 0x00, 0x80, 0x76 };
+    ZilogZ80_t cpu;
+    char line[64] = "";
+
+    zilogZ80Init(&cpu);
+    for(size_t idx = 0; idx < sizeof(program); idx++)
+    {
+        cpu.rom.data[idx] = program[idx];
+    }
+
+    cpu.watchpointLog = tmpfile();
+    TEST_ASSERT_NOT_NULL(cpu.watchpointLog);
+    memoryMapAddWatchpoint(&cpu.memoryMap, 0x8000, 0x8000, WATCHPOINT_WRITE, WATCHPOINT_ACTION_LOG);
+
+    // A log hit does not stop the run
+    TEST_ASSERT_EQUAL(STOP_REASON_HALT, zilogZ80Run(&cpu, 1000));
+
+    rewind(cpu.watchpointLog);
+    TEST_ASSERT_NOT_NULL(fgets(line, sizeof(line), cpu.watchpointLog));
+    TEST_ASSERT_EQUAL_STRING("Watchpoint 0: write 0x8000 = 0x42 at PC 0x0002\n", line);
+    fclose(cpu.watchpointLog);
+
+    memoryDestroy(&cpu.rom);
+    memoryDestroy(&cpu.ram);
+}
+
 int main(void)
 {
     UNITY_BEGIN();
     RUN_TEST(test_cpu_init_function);
+    RUN_TEST(test_cpu_watchpoint_log_goes_to_the_log_stream);
 
     return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "unity.h"
+#include "cpu.h"
+#include "host_profile.h"
+
+#include <string.h>
+
+static ZilogZ80_t cpu;
+static HostProfile_t *profile;
+
+static byte_t deviceRead(void *context, word_t address)
+{
+    (void)context;
+    return (byte_t)address;
+}
+
+static void portIn(void *context, byte_t *value)
+{
+    (void)context;
+    *value = 0x42;
+}
+
+void setUp(void)
+{
+    zilogZ80Init(&cpu);
+    profile = hostProfileCreate(1);
+}
+
+void tearDown(void)
+{
+    cpu.hostProfile = NULL;
+    hostProfileDestroy(profile);
+    memoryDestroy(&cpu.rom);
+    memoryDestroy(&cpu.ram);
+}
+
+void test_host_profile_times_every_access_path(void)
+{
+    // LD A,(0x4000) / IN A,(0x10) / LD (0x0100),A / HALT
+    byte_t code[] = { 0x3A, 0x00, 0x40, 0xDB, 0x10, 0x32, 0x00, 0x01, 0x76 };
+    HostProfileEntry_t entries[8];
+
+    memcpy(cpu.rom.data, code, sizeof(code));
+    memoryMapMapHandler(&cpu.memoryMap, 0x4000, MEMORY_PAGE_SIZE, deviceRead, NULL, NULL);
+    cpu.inputCallback[0x10] = portIn;
+    cpu.hostProfile = profile;
+
+    zilogZ80Run(&cpu, 1000);
+
+    TEST_ASSERT_EQUAL(4, profile->instructions);
+    TEST_ASSERT_EQUAL(4, profile->sampledInstructions);
+    TEST_ASSERT_EQUAL(1, profile->paths.accesses[HOST_PATH_MEMORY_HANDLER]);
+    TEST_ASSERT_EQUAL(1, profile->paths.accesses[HOST_PATH_IO_PORT]);
+    // The write to ROM is dropped on the slow path
+    TEST_ASSERT_EQUAL(1, profile->paths.accesses[HOST_PATH_SLOW_MEMORY]);
+    TEST_ASSERT_NULL(cpu.memoryMap.hostCost);
+
+    TEST_ASSERT_EQUAL(4, hostProfileTop(profile, entries, 8));
+    TEST_ASSERT_EQUAL(1, profile->samples[OPCODE_GROUP_MAIN][0xDB]);
+    TEST_ASSERT_TRUE(profile->ticks[OPCODE_GROUP_MAIN][0xDB] >= profile->accessTicks[OPCODE_GROUP_MAIN][0xDB]);
+
+    hostProfileClear(profile);
+    TEST_ASSERT_EQUAL(0, hostProfileTop(profile, entries, 8));
+    TEST_ASSERT_EQUAL(0, profile->paths.accesses[HOST_PATH_IO_PORT]);
+}
+
+void test_host_profile_samples_about_every_interval(void)
+{
+    // loop: JP loop
+    byte_t code[] = { 0xC3, 0x00, 0x00 };
+    HostProfile_t *sparse = hostProfileCreate(100);
+
+    memcpy(cpu.rom.data, code, sizeof(code));
+    cpu.hostProfile = sparse;
+
+    zilogZ80Run(&cpu, 10 * 100000);
+
+    TEST_ASSERT_EQUAL(100000, sparse->instructions);
+    TEST_ASSERT_TRUE(sparse->sampledInstructions > 900 && sparse->sampledInstructions < 1100);
+    TEST_ASSERT_EQUAL(sparse->sampledInstructions, sparse->samples[OPCODE_GROUP_MAIN][0xC3]);
+
+    cpu.hostProfile = NULL;
+    hostProfileDestroy(sparse);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_host_profile_times_every_access_path);
+    RUN_TEST(test_host_profile_samples_about_every_interval);
+    return UNITY_END();
+}
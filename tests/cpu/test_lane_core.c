@@ -0,0 +1,166 @@
+#include "unity.h"
+#include "lane_core.h"
+
+#include <string.h>
+
+#define RANDOM_ROUNDS 64
+
+static LaneCore_t core;
+static unsigned int randomState = 0x12345678;
+
+void setUp(void)
+{
+    laneCoreInit(&core);
+}
+
+void tearDown(void)
+{
+    laneCoreDestroy(&core);
+}
+
+static byte_t randomByte(void)
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+
+    return (byte_t)randomState;
+}
+
+static void randomizeLane(int lane, byte_t opcode)
+{
+    ZilogZ80_t cpu;
+    memset(&cpu, 0x00, sizeof(cpu));
+
+    cpu.A = randomByte();
+    cpu.B = randomByte();
+    cpu.C = randomByte();
+    cpu.D = randomByte();
+    cpu.E = randomByte();
+    cpu.H = randomByte();
+    cpu.L = randomByte();
+    cpu.F = laneCoreUnpackFlags(randomByte());
+    cpu.SP = (word_t)(0x8000 | (randomByte() << 4));
+    // Code in RAM, away from the end of the address space
+    cpu.PC = (word_t)(0x8000 | (randomByte() << 6));
+
+    laneCoreSetState(&core, lane, &cpu);
+
+    byte_t *memory = laneCoreMemory(&core, lane);
+    memory[cpu.PC] = opcode;
+    memory[(word_t)(cpu.PC + 1)] = randomByte();
+    memory[(word_t)(cpu.PC + 2)] = randomByte();
+}
+
+static void checkLane(int lane, const ZilogZ80_t *expected, qword_t expectedCycles)
+{
+    ZilogZ80_t actual;
+    laneCoreGetState(&core, lane, &actual);
+
+    TEST_ASSERT_EQUAL(expected->A, actual.A);
+    TEST_ASSERT_EQUAL(expected->B, actual.B);
+    TEST_ASSERT_EQUAL(expected->C, actual.C);
+    TEST_ASSERT_EQUAL(expected->D, actual.D);
+    TEST_ASSERT_EQUAL(expected->E, actual.E);
+    TEST_ASSERT_EQUAL(expected->H, actual.H);
+    TEST_ASSERT_EQUAL(expected->L, actual.L);
+    TEST_ASSERT_EQUAL(expected->SP, actual.SP);
+    TEST_ASSERT_EQUAL(expected->PC, actual.PC);
+    TEST_ASSERT_EQUAL(laneCorePackFlags(expected->F), laneCorePackFlags(actual.F));
+    TEST_ASSERT_EQUAL(expectedCycles, core.cycles[lane]);
+}
+
+void test_lane_core_flags_round_trip(void)
+{
+    for(int value = 0; value < 0x100; value++)
+    {
+        TEST_ASSERT_EQUAL(value, laneCorePackFlags(laneCoreUnpackFlags((byte_t)value)));
+    }
+}
+
+void test_lane_core_kernels_match_scalar_core(void)
+{
+    for(int opcode = 0; opcode < 0x100; opcode++)
+    {
+        if(laneCoreIsVectorOpcode((byte_t)opcode) == false)
+        {
+            continue;
+        }
+
+        for(int round = 0; round < RANDOM_ROUNDS; round++)
+        {
+            ZilogZ80_t expected[LANE_COUNT];
+            qword_t expectedCycles[LANE_COUNT];
+
+            laneCoreReset(&core);
+            for(int lane = 0; lane < LANE_COUNT; lane++)
+            {
+                randomizeLane(lane, (byte_t)opcode);
+
+                // The scalar core of the lane is the reference, none of the vector opcodes write memory
+                expected[lane] = core.scalarCores[lane];
+                laneCoreGetState(&core, lane, &expected[lane]);
+                expectedCycles[lane] = (qword_t)zilogZ80Step(&expected[lane]);
+            }
+
+            TEST_ASSERT_EQUAL(LANE_COUNT, laneCoreStep(&core));
+
+            for(int lane = 0; lane < LANE_COUNT; lane++)
+            {
+                checkLane(lane, &expected[lane], expectedCycles[lane]);
+            }
+        }
+    }
+}
+
+void test_lane_core_divergent_lanes_fall_back(void)
+{
+    // Even lanes: LD B,5 / DEC B / JP NZ,0x0002 / HALT, odd lanes: LD A,3 / ADD A,A / HALT
+    byte_t loop[] = { 0x06, 0x05, 0x05, 0xC2, 0x02, 0x00, 0x76 };
+    byte_t add[] = { 0x3E, 0x03, 0x87, 0x76 };
+
+    for(int lane = 0; lane < LANE_COUNT; lane++)
+    {
+        if(lane % 2 == 0)
+        {
+            laneCoreLoadRom(&core, lane, loop, sizeof(loop));
+        }
+        else
+        {
+            laneCoreLoadRom(&core, lane, add, sizeof(add));
+        }
+    }
+
+    laneCoreRun(&core, 1000);
+
+    for(int lane = 0; lane < LANE_COUNT; lane++)
+    {
+        ZilogZ80_t cpu;
+        laneCoreGetState(&core, lane, &cpu);
+
+        TEST_ASSERT_TRUE(cpu.isHaltered);
+        if(lane % 2 == 0)
+        {
+            TEST_ASSERT_EQUAL(0, cpu.B);
+            TEST_ASSERT_EQUAL(sizeof(loop), cpu.PC);
+        }
+        else
+        {
+            TEST_ASSERT_EQUAL(6, cpu.A);
+            TEST_ASSERT_EQUAL(sizeof(add), cpu.PC);
+        }
+    }
+
+    TEST_ASSERT_TRUE(core.vectorLaneSteps > 0);
+    TEST_ASSERT_TRUE(core.scalarLaneSteps > 0);
+    TEST_ASSERT_EQUAL(0, laneCoreStep(&core));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_lane_core_flags_round_trip);
+    RUN_TEST(test_lane_core_kernels_match_scalar_core);
+    RUN_TEST(test_lane_core_divergent_lanes_fall_back);
+    return UNITY_END();
+}
@@ -0,0 +1,88 @@
+#include "unity.h"
+#include "lockstep.h"
+
+#include <string.h>
+
+static LockstepRunner_t runner;
+
+/**
+ * @brief Stores A, A + 1, ... at 0x8000 until A reaches 0x20, with a PUSH / POP in the loop.
+ * Mixes lane kernels (LD r,n, INC r, CP n) with scalar fallback instructions
+ */
+static const byte_t program[] = {
+    0x31, 0x00, 0xF0, // LD SP,0xF000
+    0x21, 0x00, 0x80, // LD HL,0x8000
+    0x3E, 0x05,       // LD A,0x05
+    0x77,             // loop: LD (HL),A
+    0x23,             // INC HL
+    0x3C,             // INC A
+    0xC5,             // PUSH BC
+    0xC1,             // POP BC
+    0xFE, 0x20,       // CP 0x20
+    0x20, 0xF7,       // JR NZ,loop
+    0x76              // HALT
+};
+
+void setUp(void)
+{
+    TEST_ASSERT_TRUE(lockstepInit(&runner));
+    lockstepLoadRom(&runner, 0x0000, program, sizeof(program));
+}
+
+void tearDown(void)
+{
+    lockstepDestroy(&runner);
+}
+
+void test_lockstep_backends_agree(void)
+{
+    TEST_ASSERT_EQUAL(LOCKSTEP_MISMATCH_NONE, lockstepRun(&runner, 1000000));
+    TEST_ASSERT_TRUE(runner.reference.isHaltered);
+    TEST_ASSERT_EQUAL(3 + 27 * 7 + 1, runner.instructions);
+    TEST_ASSERT_EQUAL(runner.referenceCycles, runner.candidateCycles);
+    TEST_ASSERT_EQUAL_HEX8(0x1F, runner.reference.ram.data[0x001A]);
+
+    // Both paths of the lane core were compared
+    TEST_ASSERT_TRUE(runner.lanes.vectorLaneSteps > 0);
+    TEST_ASSERT_TRUE(runner.lanes.scalarLaneSteps > 0);
+}
+
+void test_lockstep_stops_at_register_mismatch(void)
+{
+    for(int idx = 0; idx < 5; idx++)
+    {
+        TEST_ASSERT_TRUE(lockstepStep(&runner));
+    }
+
+    // A broken backend: the lane gets A wrong before INC A
+    runner.lanes.registers[LANE_REGISTER_A][0]++;
+
+    TEST_ASSERT_EQUAL(LOCKSTEP_MISMATCH_REGISTERS, lockstepRun(&runner, 1000000));
+    TEST_ASSERT_EQUAL(5, runner.instructions);
+    TEST_ASSERT_EQUAL_HEX16(0x000A, runner.referenceState.pc);
+    TEST_ASSERT_EQUAL_HEX8(0x06, runner.referenceState.af >> 8);
+    TEST_ASSERT_EQUAL_HEX8(0x07, runner.candidateState.af >> 8);
+    TEST_ASSERT_FALSE(lockstepStep(&runner));
+}
+
+void test_lockstep_stops_at_stray_write(void)
+{
+    for(int idx = 0; idx < 5; idx++)
+    {
+        TEST_ASSERT_TRUE(lockstepStep(&runner));
+    }
+
+    laneCoreMemory(&runner.lanes, 0)[0x9000] = 0x55;
+
+    TEST_ASSERT_EQUAL(LOCKSTEP_MISMATCH_MEMORY, lockstepRun(&runner, 1000000));
+    TEST_ASSERT_EQUAL_HEX16(0x9000, runner.memoryAddress);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_lockstep_backends_agree);
+    RUN_TEST(test_lockstep_stops_at_register_mismatch);
+    RUN_TEST(test_lockstep_stops_at_stray_write);
+    return UNITY_END();
+}
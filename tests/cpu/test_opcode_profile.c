@@ -0,0 +1,83 @@
+#include "unity.h"
+#include "cpu.h"
+#include "opcode_profile.h"
+
+#include <string.h>
+
+static ZilogZ80_t cpu;
+static OpcodeProfile_t *profile;
+
+void setUp(void)
+{
+    zilogZ80Init(&cpu);
+    profile = opcodeProfileCreate();
+}
+
+void tearDown(void)
+{
+    cpu.profile = NULL;
+    opcodeProfileDestroy(profile);
+    memoryDestroy(&cpu.rom);
+    memoryDestroy(&cpu.ram);
+}
+
+void test_opcode_profile_decodes_prefixes(void)
+{
+    byte_t code[] = { 0x3E, 0xCB, 0x06, 0xED, 0xB0, 0xDD, 0x21, 0xDD, 0xCB, 0x05, 0x46, 0xFD, 0xCB, 0xFE, 0x7E };
+    byte_t opcode;
+
+    memcpy(cpu.rom.data, code, sizeof(code));
+
+    TEST_ASSERT_EQUAL(OPCODE_GROUP_MAIN, opcodeProfileDecode(&cpu.memoryMap, 0, &opcode));
+    TEST_ASSERT_EQUAL(0x3E, opcode);
+    TEST_ASSERT_EQUAL(OPCODE_GROUP_CB, opcodeProfileDecode(&cpu.memoryMap, 1, &opcode));
+    TEST_ASSERT_EQUAL(0x06, opcode);
+    TEST_ASSERT_EQUAL(OPCODE_GROUP_ED, opcodeProfileDecode(&cpu.memoryMap, 3, &opcode));
+    TEST_ASSERT_EQUAL(0xB0, opcode);
+    TEST_ASSERT_EQUAL(OPCODE_GROUP_DD, opcodeProfileDecode(&cpu.memoryMap, 5, &opcode));
+    TEST_ASSERT_EQUAL(0x21, opcode);
+    TEST_ASSERT_EQUAL(OPCODE_GROUP_DDCB, opcodeProfileDecode(&cpu.memoryMap, 7, &opcode));
+    TEST_ASSERT_EQUAL(0x46, opcode);
+    TEST_ASSERT_EQUAL(OPCODE_GROUP_FDCB, opcodeProfileDecode(&cpu.memoryMap, 11, &opcode));
+    TEST_ASSERT_EQUAL(0x7E, opcode);
+}
+
+void test_opcode_profile_counts_executions_and_pairs(void)
+{
+    // LD B,3 / loop: DEC B / JP NZ,loop / HALT
+    byte_t code[] = { 0x06, 0x03, 0x05, 0xC2, 0x02, 0x00, 0x76 };
+    OpcodeProfileEntry_t entries[8];
+    OpcodePairEntry_t pairs[8];
+
+    memcpy(cpu.rom.data, code, sizeof(code));
+    cpu.profile = profile;
+    zilogZ80Run(&cpu, 1000);
+
+    TEST_ASSERT_EQUAL(3, profile->counts[OPCODE_GROUP_MAIN][0x05]);
+    TEST_ASSERT_EQUAL(3, profile->counts[OPCODE_GROUP_MAIN][0xC2]);
+    TEST_ASSERT_EQUAL(1, profile->counts[OPCODE_GROUP_MAIN][0x76]);
+    TEST_ASSERT_EQUAL(8, profile->instructions);
+    TEST_ASSERT_EQUAL(cpu.runCycles, profile->totalCycles);
+
+    TEST_ASSERT_EQUAL(4, opcodeProfileTop(profile, entries, 8));
+    TEST_ASSERT_EQUAL(3, entries[0].count);
+
+    // DEC B -> JP NZ three times, JP NZ -> DEC B twice, LD B -> DEC B and JP NZ -> HALT once
+    TEST_ASSERT_EQUAL(4, opcodeProfileTopPairs(profile, pairs, 8));
+    TEST_ASSERT_EQUAL(0x05, pairs[0].firstOpcode);
+    TEST_ASSERT_EQUAL(0xC2, pairs[0].secondOpcode);
+    TEST_ASSERT_EQUAL(3, pairs[0].count);
+    TEST_ASSERT_EQUAL(2, pairs[1].count);
+
+    opcodeProfileClear(profile);
+    TEST_ASSERT_EQUAL(0, opcodeProfileTop(profile, entries, 8));
+    TEST_ASSERT_EQUAL(0, opcodeProfileTopPairs(profile, pairs, 8));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_opcode_profile_decodes_prefixes);
+    RUN_TEST(test_opcode_profile_counts_executions_and_pairs);
+    return UNITY_END();
+}
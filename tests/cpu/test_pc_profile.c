@@ -0,0 +1,127 @@
+#include "unity.h"
+#include "cpu.h"
+#include "pc_profile.h"
+
+#include <string.h>
+
+static ZilogZ80_t cpu;
+static PcProfile_t *profile;
+
+// 0x0000: LD SP,0xF000 / CALL outer / HALT
+// 0x0010: outer: CALL inner / RET
+// 0x0020: inner: LD B,0x10 / loop: DEC B / JP NZ,loop / RET
+static const byte_t program[][2] = { { 0x00, 0x31 }, { 0x01, 0x00 }, { 0x02, 0xF0 }, { 0x03, 0xCD }, { 0x04, 0x10 },
+                                     { 0x05, 0x00 }, { 0x06, 0x76 },
+                                     { 0x10, 0xCD }, { 0x11, 0x20 }, { 0x12, 0x00 }, { 0x13, 0xC9 },
+                                     { 0x20, 0x06 }, { 0x21, 0x10 }, { 0x22, 0x05 }, { 0x23, 0xC2 }, { 0x24, 0x22 },
+                                     { 0x25, 0x00 }, { 0x26, 0xC9 } };
+
+/**
+ * @brief Writes the collapsed stacks to a buffer
+ */
+static void writeCollapsed(const SymbolTable_t *symbols, char *buffer, size_t bufferSize)
+{
+    FILE *stream = tmpfile();
+    TEST_ASSERT_NOT_NULL(stream);
+
+    pcProfileWriteCollapsed(profile, stream, symbols);
+    rewind(stream);
+
+    size_t length = fread(buffer, 1, bufferSize - 1, stream);
+    buffer[length] = '\0';
+    fclose(stream);
+}
+
+void setUp(void)
+{
+    zilogZ80Init(&cpu);
+    profile = pcProfileCreate(1);
+
+    for(size_t idx = 0; idx < sizeof(program) / sizeof(program[0]); idx++)
+    {
+        cpu.rom.data[program[idx][0]] = program[idx][1];
+    }
+}
+
+void tearDown(void)
+{
+    cpu.pcProfile = NULL;
+    pcProfileDestroy(profile);
+    memoryDestroy(&cpu.rom);
+    memoryDestroy(&cpu.ram);
+}
+
+void test_pc_profile_rebuilds_call_stacks(void)
+{
+    char output[1024];
+
+    cpu.pcProfile = profile;
+    zilogZ80Run(&cpu, 10000);
+
+    // Every call returned
+    TEST_ASSERT_EQUAL(0, profile->depth);
+    TEST_ASSERT_EQUAL(cpu.runCycles, profile->samples);
+
+    writeCollapsed(NULL, output, sizeof(output));
+
+    // LD SP (10) + CALL (17) + HALT (4) at the outermost level
+    TEST_ASSERT_NOT_NULL(strstr(output, "root 31\n"));
+    // CALL inner (17) + RET (10)
+    TEST_ASSERT_NOT_NULL(strstr(output, "root;sub_0010 27\n"));
+    // LD B (7) + 16 * (DEC B (4) + JP NZ (10)) + RET (10)
+    TEST_ASSERT_NOT_NULL(strstr(output, "root;sub_0010;sub_0020 241\n"));
+}
+
+void test_pc_profile_names_levels_after_symbols(void)
+{
+    SymbolTable_t symbols;
+    char output[1024];
+
+    symbolTableInit(&symbols);
+    symbolTableAdd(&symbols, "main", 0x0000);
+    symbolTableAdd(&symbols, "outer", 0x0010);
+    symbolTableAdd(&symbols, "inner", 0x0020);
+    symbolTableAdd(&symbols, "loop", 0x0022);
+    symbolTableSort(&symbols);
+
+    cpu.pcProfile = profile;
+    zilogZ80Run(&cpu, 10000);
+
+    writeCollapsed(&symbols, output, sizeof(output));
+
+    TEST_ASSERT_NOT_NULL(strstr(output, "main 31\n"));
+    TEST_ASSERT_NOT_NULL(strstr(output, "main;outer 27\n"));
+    TEST_ASSERT_NOT_NULL(strstr(output, "main;outer;inner 7\n"));
+    TEST_ASSERT_NOT_NULL(strstr(output, "main;outer;loop 234\n"));
+
+    symbolTableDestroy(&symbols);
+}
+
+void test_pc_profile_drops_abandoned_frames(void)
+{
+    pcProfileEnter(profile, 0x0100, 0x0003, 0xEFFE);
+    pcProfileEnter(profile, 0x0200, 0x0105, 0xEFFC);
+    TEST_ASSERT_EQUAL(2, profile->depth);
+
+    // POP of the return address, then a jump back
+    pcProfileUnwind(profile, 0xEFFE);
+    TEST_ASSERT_EQUAL(1, profile->depth);
+
+    // Stack reset to its top
+    pcProfileUnwind(profile, 0xF000);
+    TEST_ASSERT_EQUAL(0, profile->depth);
+
+    // Return address pushed below 0x0000 (SP was 0x0000)
+    pcProfileEnter(profile, 0x0100, 0x0003, 0xFFFE);
+    pcProfileUnwind(profile, 0x0000);
+    TEST_ASSERT_EQUAL(0, profile->depth);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_pc_profile_rebuilds_call_stacks);
+    RUN_TEST(test_pc_profile_names_levels_after_symbols);
+    RUN_TEST(test_pc_profile_drops_abandoned_frames);
+    return UNITY_END();
+}
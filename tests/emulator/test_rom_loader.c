@@ -0,0 +1,67 @@
+#include "unity.h"
+#include "rom_loader.h"
+#include "utils/error_handler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static RomImage_t image;
+
+/**
+ * @brief Parses Intel HEX text into the image
+ */
+static bool loadHex(const char *text)
+{
+    FILE *stream = tmpfile();
+    TEST_ASSERT_NOT_NULL(stream);
+
+    fputs(text, stream);
+    rewind(stream);
+    bool isLoaded = romImageLoadIntelHex(&image, stream);
+    fclose(stream);
+
+    return isLoaded;
+}
+
+void setUp(void)
+{
+    romImageInit(&image);
+    clearAllErrors();
+}
+
+void tearDown(void)
+{
+    romImageClose(&image);
+}
+
+void test_rom_loader_intel_hex_extended_linear_address(void)
+{
+    // Two bytes at 0x0100, then two bytes at 0x10000 + 0x0010
+    TEST_ASSERT_TRUE(loadHex(":020100003E01BE\n"
+                             ":020000040001F9\n"
+                             ":02001000C90025\n"
+                             ":00000001FF\n"));
+
+    TEST_ASSERT_EQUAL_HEX8(0x3E, image.data[0x0100]);
+    TEST_ASSERT_EQUAL_HEX8(0xC9, image.data[0x10010]);
+    TEST_ASSERT_EQUAL(2, image.segmentCount);
+}
+
+void test_rom_loader_intel_hex_rejects_short_address_records(void)
+{
+    // Valid checksums, but an address record needs exactly two data bytes
+    TEST_ASSERT_FALSE(loadHex(":00000004FC\n:00000001FF\n"));
+    TEST_ASSERT_TRUE(hasError(C80_ERROR_ROM_FILE_FORMAT_ERROR));
+
+    clearAllErrors();
+    TEST_ASSERT_FALSE(loadHex(":0100000201FC\n:00000001FF\n"));
+    TEST_ASSERT_TRUE(hasError(C80_ERROR_ROM_FILE_FORMAT_ERROR));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_rom_loader_intel_hex_extended_linear_address);
+    RUN_TEST(test_rom_loader_intel_hex_rejects_short_address_records);
+    return UNITY_END();
+}
@@ -0,0 +1,65 @@
+#include "unity.h"
+#include "rom_store.h"
+
+static RomStore_t store;
+static byte_t romA[0x0600];
+static byte_t romB[0x0600];
+
+void setUp(void)
+{
+    romStoreInit(&store);
+    for(int i = 0; i < 0x0600; i++)
+    {
+        romA[i] = (byte_t)i;
+        romB[i] = (byte_t)(i ^ 0xFF);
+    }
+}
+
+void tearDown(void)
+{
+    romStoreDestroy(&store);
+}
+
+void test_rom_store_shares_identical_contents(void)
+{
+    const RomImage_t *first = romStoreAcquireData(&store, romA, sizeof(romA));
+    const RomImage_t *second = romStoreAcquireData(&store, romA, sizeof(romA));
+
+    TEST_ASSERT_NOT_NULL(first);
+    TEST_ASSERT_EQUAL_PTR(first, second);
+    TEST_ASSERT_EQUAL(1, romStoreGetEntryCount(&store));
+
+    // Image is padded to whole pages
+    TEST_ASSERT_EQUAL(2 * MEMORY_PAGE_SIZE, first->size);
+    TEST_ASSERT_EQUAL(0x00, first->data[0x07FF]);
+}
+
+void test_rom_store_keeps_different_contents_apart(void)
+{
+    const RomImage_t *first = romStoreAcquireData(&store, romA, sizeof(romA));
+    const RomImage_t *second = romStoreAcquireData(&store, romB, sizeof(romB));
+
+    TEST_ASSERT_NOT_EQUAL(first, second);
+    TEST_ASSERT_EQUAL(2, romStoreGetEntryCount(&store));
+}
+
+void test_rom_store_release_drops_last_reference(void)
+{
+    const RomImage_t *first = romStoreAcquireData(&store, romA, sizeof(romA));
+    const RomImage_t *second = romStoreAcquireData(&store, romA, sizeof(romA));
+
+    romStoreRelease(&store, first);
+    TEST_ASSERT_EQUAL(1, romStoreGetEntryCount(&store));
+
+    romStoreRelease(&store, second);
+    TEST_ASSERT_EQUAL(0, romStoreGetEntryCount(&store));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_rom_store_shares_identical_contents);
+    RUN_TEST(test_rom_store_keeps_different_contents_apart);
+    RUN_TEST(test_rom_store_release_drops_last_reference);
+    return UNITY_END();
+}
@@ -0,0 +1,80 @@
+#include "unity.h"
+#include "symbol_table.h"
+
+#include <string.h>
+
+static SymbolTable_t table;
+
+/**
+ * @brief Returns a stream holding text
+ */
+static FILE *streamOf(const char *text)
+{
+    FILE *stream = tmpfile();
+    TEST_ASSERT_NOT_NULL(stream);
+
+    fputs(text, stream);
+    rewind(stream);
+
+    return stream;
+}
+
+void setUp(void)
+{
+    symbolTableInit(&table);
+}
+
+void tearDown(void)
+{
+    symbolTableDestroy(&table);
+}
+
+void test_symbol_table_parses_symbol_files(void)
+{
+    FILE *stream = streamOf("; comment\n"
+                            "main: EQU 0x00000100\n"
+                            "print equ 0200H\n"
+                            "crc16 = $0300 ; addr, public\n"
+                            "main.loop: EQU 0x00000104\n"
+                            "00:0400 sieve\n"
+                            ".local EQU 0x0500\n");
+
+    TEST_ASSERT_EQUAL(5, symbolTableLoadSym(&table, stream));
+    fclose(stream);
+    symbolTableSort(&table);
+
+    TEST_ASSERT_NULL(symbolTableLookup(&table, 0x00FF));
+    TEST_ASSERT_EQUAL_STRING("main", symbolTableLookup(&table, 0x0100)->name);
+    // The local label counts as part of its function
+    TEST_ASSERT_EQUAL_STRING("main", symbolTableLookup(&table, 0x0150)->name);
+    TEST_ASSERT_EQUAL_STRING("print", symbolTableLookup(&table, 0x0200)->name);
+    TEST_ASSERT_EQUAL_STRING("crc16", symbolTableLookup(&table, 0x03FF)->name);
+    TEST_ASSERT_EQUAL_STRING("sieve", symbolTableLookup(&table, 0xFFFF)->name);
+}
+
+void test_symbol_table_parses_listings(void)
+{
+    FILE *stream = streamOf("    1  0000              org 0\n"
+                            "    2  0000 3E 01        main: ld a,1 ; start:\n"
+                            "    3  0002 CD 10 00     call wait\n"
+                            "    4  0010              wait:\n"
+                            "    5  0010 C9           ret\n");
+
+    TEST_ASSERT_EQUAL(2, symbolTableLoadListing(&table, stream));
+    fclose(stream);
+    symbolTableSort(&table);
+
+    TEST_ASSERT_EQUAL(2, table.count);
+    TEST_ASSERT_EQUAL_STRING("main", table.symbols[0].name);
+    TEST_ASSERT_EQUAL(0x0000, table.symbols[0].address);
+    TEST_ASSERT_EQUAL_STRING("wait", table.symbols[1].name);
+    TEST_ASSERT_EQUAL(0x0010, table.symbols[1].address);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_symbol_table_parses_symbol_files);
+    RUN_TEST(test_symbol_table_parses_listings);
+    return UNITY_END();
+}
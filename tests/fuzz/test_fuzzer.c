@@ -0,0 +1,125 @@
+#include "unity.h"
+#include "fuzzer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_ROM_FILE "test_fuzzer.bin"
+#define TEST_STACK_BOUND 0x8F00
+
+// Reads a line into 0x8000 like asm/simple-monitor.asm, then parses it:
+// "R..." recurses until the stack runs out, "XY..." runs into an invalid opcode, the rest halts
+// 0x0000: LD SP,0x9000 / LD HL,0x8000
+// 0x0006: loop: IN A,(1) / CP '\n' / JR Z,parse / LD (HL),A / INC HL / JR loop
+// 0x0010: parse: LD A,(0x8000) / CP 'R' / JR Z,recurse / CP 'X' / JR NZ,done
+// 0x001B: LD A,(0x8001) / CP 'Y' / JR NZ,done / ED 02 (the ED group is not decoded)
+// 0x0024: done: HALT
+// 0x0025: recurse: CALL recurse
+static const byte_t program[] = { 0x31, 0x00, 0x90, 0x21, 0x00, 0x80,
+                                  0xDB, 0x01, 0xFE, 0x0A, 0x28, 0x04, 0x77, 0x23, 0x18, 0xF6,
+                                  0x3A, 0x00, 0x80, 0xFE, 0x52, 0x28, 0x0E, 0xFE, 0x58, 0x20, 0x09,
+                                  0x3A, 0x01, 0x80, 0xFE, 0x59, 0x20, 0x02, 0xED, 0x02,
+                                  0x76,
+                                  0xCD, 0x25, 0x00 };
+
+static Fuzzer_t fuzzer;
+static FuzzConfig_t config;
+
+/**
+ * @brief Returns the finding with outcome, NULL if there is none
+ */
+static const FuzzFinding_t *findFinding(FuzzOutcome outcome)
+{
+    for(size_t idx = 0; idx < fuzzer.findingCount; idx++)
+    {
+        if(fuzzer.findings[idx].outcome == outcome)
+        {
+            return &fuzzer.findings[idx];
+        }
+    }
+
+    return NULL;
+}
+
+void setUp(void)
+{
+    FILE *stream = fopen(TEST_ROM_FILE, "wb");
+    TEST_ASSERT_NOT_NULL(stream);
+    TEST_ASSERT_EQUAL(sizeof(program), fwrite(program, 1, sizeof(program), stream));
+    fclose(stream);
+
+    config = fuzzerDefaultConfig();
+    config.stackBound = TEST_STACK_BOUND;
+    config.maxCycles = 100000;
+    config.workerCount = 2;
+}
+
+void tearDown(void)
+{
+    fuzzerDestroy(&fuzzer);
+    remove(TEST_ROM_FILE);
+}
+
+void test_fuzzer_replays_from_the_first_read(void)
+{
+    word_t pc = 0;
+
+    TEST_ASSERT_TRUE(fuzzerInit(&fuzzer, &config, TEST_ROM_FILE));
+
+    // The snapshot is taken right before IN A,(1)
+    TEST_ASSERT_EQUAL_HEX16(0x0006, fuzzer.snapshot.cpu.PC);
+    TEST_ASSERT_EQUAL(10 + 10, fuzzer.bootCycles);
+
+    TEST_ASSERT_EQUAL(FUZZ_OUTCOME_OK, fuzzerReplay(&fuzzer, (const byte_t *)"XZ\n", 3, &pc));
+    TEST_ASSERT_EQUAL(FUZZ_OUTCOME_OK, fuzzerReplay(&fuzzer, (const byte_t *)"XY", 2, &pc));
+
+    TEST_ASSERT_EQUAL(FUZZ_OUTCOME_INVALID_OPCODE, fuzzerReplay(&fuzzer, (const byte_t *)"XY\n", 3, &pc));
+    TEST_ASSERT_EQUAL_HEX16(0x0022, pc);
+
+    TEST_ASSERT_EQUAL(FUZZ_OUTCOME_STACK_OVERFLOW, fuzzerReplay(&fuzzer, (const byte_t *)"R\n", 2, &pc));
+    TEST_ASSERT_EQUAL_HEX16(0x0025, pc);
+
+    // Without a stack bound the recursion runs until the cycle budget is used up
+    config.stackBound = -1;
+    fuzzerDestroy(&fuzzer);
+    TEST_ASSERT_TRUE(fuzzerInit(&fuzzer, &config, TEST_ROM_FILE));
+    TEST_ASSERT_EQUAL(FUZZ_OUTCOME_HANG, fuzzerReplay(&fuzzer, (const byte_t *)"R\n", 2, &pc));
+    TEST_ASSERT_EQUAL_HEX16(0x0025, pc);
+}
+
+void test_fuzzer_finds_crashes(void)
+{
+    config.maxExecutions = 200000;
+
+    TEST_ASSERT_TRUE(fuzzerInit(&fuzzer, &config, TEST_ROM_FILE));
+    TEST_ASSERT_TRUE(fuzzerAddSeed(&fuzzer, (const byte_t *)"hello\n", 6));
+    TEST_ASSERT_TRUE(fuzzerRun(&fuzzer, NULL, NULL));
+
+    TEST_ASSERT_TRUE(fuzzer.executions >= config.maxExecutions);
+
+    const FuzzFinding_t *invalidOpcode = findFinding(FUZZ_OUTCOME_INVALID_OPCODE);
+    TEST_ASSERT_NOT_NULL(invalidOpcode);
+    TEST_ASSERT_EQUAL_HEX16(0x0022, invalidOpcode->pc);
+    TEST_ASSERT_EQUAL_MEMORY("XY", invalidOpcode->input.data, 2);
+
+    const FuzzFinding_t *stackOverflow = findFinding(FUZZ_OUTCOME_STACK_OVERFLOW);
+    TEST_ASSERT_NOT_NULL(stackOverflow);
+    TEST_ASSERT_EQUAL_HEX16(0x0025, stackOverflow->pc);
+    TEST_ASSERT_EQUAL('R', stackOverflow->input.data[0]);
+
+    // Both sides of every branch, the crashing instructions included
+    TEST_ASSERT_TRUE(coverageIsExecuted(fuzzer.coverage, 0x0024));
+    TEST_ASSERT_TRUE(coverageIsExecuted(fuzzer.coverage, 0x0022));
+    TEST_ASSERT_EQUAL(fuzzer.executions, fuzzer.outcomes[FUZZ_OUTCOME_OK] + fuzzer.outcomes[FUZZ_OUTCOME_HANG]
+                                             + fuzzer.outcomes[FUZZ_OUTCOME_INVALID_OPCODE]
+                                             + fuzzer.outcomes[FUZZ_OUTCOME_WATCHPOINT]
+                                             + fuzzer.outcomes[FUZZ_OUTCOME_STACK_OVERFLOW]);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fuzzer_replays_from_the_first_read);
+    RUN_TEST(test_fuzzer_finds_crashes);
+    return UNITY_END();
+}
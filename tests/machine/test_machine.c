@@ -0,0 +1,254 @@
+#include "unity.h"
+#include "machine.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#define THREAD_COUNT 4
+
+// LD A,n / LD (0x8000),A / INC A / JP 0x0002 (loops forever)
+static byte_t program[] = { 0x3E, 0x00, 0x32, 0x00, 0x80, 0x3C, 0xC3, 0x02, 0x00 };
+
+// LD HL,0x8000 / LD A,1 / LD (0x9000),A / loop: LD A,(0x9000) / OUT (0xFD),A / LD A,(0x7FFF) /
+// LD (HL),A / INC HL / LD A,(0x9000) / INC A / LD (0x9000),A / CP 8 / JR NZ,loop / HALT
+// (copies the last byte of banks 1-7 into RAM)
+static const byte_t bankProgram[] =
+{
+    0x21, 0x00, 0x80, 0x3E, 0x01, 0x32, 0x00, 0x90, 0x3A, 0x00, 0x90, 0xD3, MACHINE_BANK_PORT + 1,
+    0x3A, 0xFF, 0x7F, 0x77, 0x23, 0x3A, 0x00, 0x90, 0x3C, 0x32, 0x00, 0x90, 0xFE, 0x08, 0x20, 0xEB,
+    0x76
+};
+
+// LD A,0x04 / OUT (0xA8),A (cartridge slot in 0x4000-0x7FFF), then the same loop with
+// LD (0x6000),A (ASCII 16K bank register) instead of the OUT
+static const byte_t cartridgeProgram[] =
+{
+    0x3E, 0x04, 0xD3, MACHINE_SLOT_PORT, 0x21, 0x00, 0x80, 0x3E, 0x01, 0x32, 0x00, 0x90, 0x3A, 0x00,
+    0x90, 0x32, 0x00, 0x60, 0x3A, 0xFF, 0x7F, 0x77, 0x23, 0x3A, 0x00, 0x90, 0x3C, 0x32, 0x00, 0x90,
+    0xFE, 0x08, 0x20, 0xEA, 0x76
+};
+
+/** @brief 128K, eight 16K banks, twice the address space */
+#define BANKED_IMAGE_SIZE 0x20000
+#define BANK_SIZE 0x4000
+
+static byte_t bankedImage[BANKED_IMAGE_SIZE];
+
+static Machine_t machines[THREAD_COUNT];
+
+void setUp(void)
+{
+    for(int i = 0; i < THREAD_COUNT; i++)
+    {
+        machineInit(&machines[i], NULL);
+    }
+}
+
+void tearDown(void)
+{
+    for(int i = 0; i < THREAD_COUNT; i++)
+    {
+        machineDestroy(&machines[i]);
+    }
+}
+
+static void *runMachine(void *argument)
+{
+    Machine_t *machine = (Machine_t *)argument;
+
+    for(int frame = 0; frame < 10; frame++)
+    {
+        machineRunFrame(machine);
+    }
+
+    return NULL;
+}
+
+void test_machine_instances_are_independent(void)
+{
+    TEST_ASSERT_TRUE(machineLoadRomData(&machines[0], program, sizeof(program)));
+
+    program[1] = 0x40;
+    TEST_ASSERT_TRUE(machineLoadRomData(&machines[1], program, sizeof(program)));
+    program[1] = 0x00;
+
+    machineRun(&machines[0], 7 + 13);
+    machineRun(&machines[1], 7 + 13);
+
+    TEST_ASSERT_EQUAL(0x00, memoryMapReadByte(&machines[0].cpu.memoryMap, 0x8000));
+    TEST_ASSERT_EQUAL(0x40, memoryMapReadByte(&machines[1].cpu.memoryMap, 0x8000));
+}
+
+void test_machine_errors_stay_with_the_machine(void)
+{
+    clearAllErrors();
+
+    TEST_ASSERT_FALSE(machineLoadRom(&machines[0], "does/not/exist.bin", ROM_FORMAT_AUTO));
+
+    TEST_ASSERT_EQUAL(1, machines[0].errors.topIndex + 1);
+    TEST_ASSERT_EQUAL(C80_ERROR_ROM_FILE_NOT_FOUND, machines[0].errors.errors[0].error);
+    TEST_ASSERT_EQUAL(0, machines[1].errors.topIndex + 1);
+    TEST_ASSERT_EQUAL(0, getErrorCount());
+}
+
+void test_machine_runs_concurrently(void)
+{
+    pthread_t threads[THREAD_COUNT];
+
+    for(int i = 0; i < THREAD_COUNT; i++)
+    {
+        machineLoadRomData(&machines[i], program, sizeof(program));
+        pthread_create(&threads[i], NULL, runMachine, &machines[i]);
+    }
+    for(int i = 0; i < THREAD_COUNT; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    for(int i = 0; i < THREAD_COUNT; i++)
+    {
+        TEST_ASSERT_EQUAL(10, machines[i].scheduler.frameCount);
+        TEST_ASSERT_EQUAL(machines[0].cpu.A, machines[i].cpu.A);
+        TEST_ASSERT_EQUAL(machines[0].scheduler.totalCycles, machines[i].scheduler.totalCycles);
+    }
+}
+
+void test_machine_snapshot_restores_state(void)
+{
+    MachineSnapshot_t snapshot = { 0 };
+
+    machineLoadRomData(&machines[0], program, sizeof(program));
+    machineRun(&machines[0], 1000);
+    TEST_ASSERT_TRUE(machineSaveSnapshot(&machines[0], &snapshot));
+
+    byte_t a = machines[0].cpu.A;
+    word_t pc = machines[0].cpu.PC;
+    qword_t totalCycles = machines[0].scheduler.totalCycles;
+
+    // Restoring twice from the same snapshot gives the same run
+    for(int run = 0; run < 2; run++)
+    {
+        machineRun(&machines[0], 5000);
+        TEST_ASSERT_NOT_EQUAL(a, machines[0].cpu.A);
+
+        machineRestoreSnapshot(&machines[0], &snapshot);
+        TEST_ASSERT_EQUAL(a, machines[0].cpu.A);
+        TEST_ASSERT_EQUAL(pc, machines[0].cpu.PC);
+        TEST_ASSERT_EQUAL(totalCycles, machines[0].scheduler.totalCycles);
+        TEST_ASSERT_EQUAL((byte_t)(a - 1), memoryMapReadByte(&machines[0].cpu.memoryMap, 0x8000));
+    }
+
+    machineSnapshotDestroy(&snapshot);
+}
+
+void test_machine_short_rom_reads_zero_past_its_end(void)
+{
+    Machine_t *machine = &machines[0];
+
+    TEST_ASSERT_TRUE(machineLoadRomData(machine, program, sizeof(program)));
+
+    // One page of image, the rest of the 16K window reads 0x00 and stays read-only
+    TEST_ASSERT_EQUAL_HEX8(0x3E, memoryMapReadByte(&machine->cpu.memoryMap, 0x0000));
+    TEST_ASSERT_EQUAL_HEX8(0x00, memoryMapReadByte(&machine->cpu.memoryMap, 0x3FFF));
+    TEST_ASSERT_EQUAL_HEX8(0x00, memoryMapPeekByte(&machine->cpu.memoryMap, 0x2000));
+    memoryMapWriteByte(&machine->cpu.memoryMap, 0x2000, 0x55);
+    TEST_ASSERT_EQUAL_HEX8(0x00, memoryMapReadByte(&machine->cpu.memoryMap, 0x2000));
+}
+
+/**
+ * @brief Puts code into bank 0 and 0xB0 + bank into the last byte of every bank, then
+ * re-creates machines[0] with a mapper and loads the image
+ */
+static void loadBankedImage(MachineMapper mapper, const byte_t *code, size_t codeSize)
+{
+    memset(bankedImage, 0x00, sizeof(bankedImage));
+    memcpy(bankedImage, code, codeSize);
+    for(size_t bank = 0; bank < BANKED_IMAGE_SIZE / BANK_SIZE; bank++)
+    {
+        bankedImage[bank * BANK_SIZE + BANK_SIZE - 1] = (byte_t)(0xB0 + bank);
+    }
+
+    MachineConfig_t config = machineDefaultConfig();
+    config.mapper = mapper;
+
+    machineDestroy(&machines[0]);
+    TEST_ASSERT_TRUE(machineInit(&machines[0], &config));
+    TEST_ASSERT_TRUE(machineLoadRomData(&machines[0], bankedImage, sizeof(bankedImage)));
+}
+
+void test_machine_generic_mapper_switches_banks(void)
+{
+    Machine_t *machine = &machines[0];
+    MachineSnapshot_t snapshot = { 0 };
+
+    loadBankedImage(MACHINE_MAPPER_GENERIC_16K, bankProgram, sizeof(bankProgram));
+    TEST_ASSERT_TRUE(machineSaveSnapshot(machine, &snapshot));
+
+    // Tools replace the I/O context, the bank ports keep working
+    machine->cpu.ioContext = NULL;
+    TEST_ASSERT_EQUAL(STOP_REASON_HALT, machineRun(machine, 100000));
+
+    for(int bank = 1; bank < 8; bank++)
+    {
+        TEST_ASSERT_EQUAL_HEX8(0xB0 + bank, memoryMapReadByte(&machine->cpu.memoryMap, 0x8000 + bank - 1));
+    }
+    TEST_ASSERT_EQUAL(7, mapperGetBank(&machine->mapper, 1));
+    TEST_ASSERT_EQUAL_HEX8(0xB7, memoryMapReadByte(&machine->cpu.memoryMap, 0x7FFF));
+
+    // The snapshot rewinds the bank register, reset selects the power-on banks
+    machineRestoreSnapshot(machine, &snapshot);
+    TEST_ASSERT_EQUAL_HEX8(0xB1, memoryMapReadByte(&machine->cpu.memoryMap, 0x7FFF));
+    mapperSelectBank(&machine->mapper, 1, 5);
+    machineReset(machine);
+    TEST_ASSERT_EQUAL_HEX8(0xB1, memoryMapReadByte(&machine->cpu.memoryMap, 0x7FFF));
+
+    machineSnapshotDestroy(&snapshot);
+}
+
+void test_machine_cartridge_mapper_switches_slots_and_banks(void)
+{
+    Machine_t *machine = &machines[0];
+
+    loadBankedImage(MACHINE_MAPPER_ASCII16, cartridgeProgram, sizeof(cartridgeProgram));
+
+    // Slot 0 has the flat layout, nothing at 0x4000 before the guest selects the cartridge
+    TEST_ASSERT_EQUAL_HEX8(0x3E, memoryMapReadByte(&machine->cpu.memoryMap, 0x0000));
+    TEST_ASSERT_EQUAL_HEX8(MEMORY_OPEN_BUS, memoryMapReadByte(&machine->cpu.memoryMap, 0x7FFF));
+
+    TEST_ASSERT_EQUAL(STOP_REASON_HALT, machineRun(machine, 100000));
+
+    for(int bank = 1; bank < 8; bank++)
+    {
+        TEST_ASSERT_EQUAL_HEX8(0xB0 + bank, memoryMapReadByte(&machine->cpu.memoryMap, 0x8000 + bank - 1));
+    }
+    TEST_ASSERT_EQUAL_HEX8(0x04, machine->slots->primarySelect);
+
+    machineReset(machine);
+    TEST_ASSERT_EQUAL_HEX8(0x00, machine->slots->primarySelect);
+    TEST_ASSERT_EQUAL_HEX8(MEMORY_OPEN_BUS, memoryMapReadByte(&machine->cpu.memoryMap, 0x7FFF));
+}
+
+void test_machine_mapper_rejects_partial_banks(void)
+{
+    loadBankedImage(MACHINE_MAPPER_GENERIC_16K, bankProgram, sizeof(bankProgram));
+
+    // The previous image stays mapped
+    TEST_ASSERT_FALSE(machineLoadRomData(&machines[0], program, sizeof(program)));
+    TEST_ASSERT_EQUAL(C80_ERROR_ROM_FILE_FORMAT_ERROR, machines[0].errors.errors[machines[0].errors.topIndex].error);
+    TEST_ASSERT_EQUAL_HEX8(0x21, memoryMapReadByte(&machines[0].cpu.memoryMap, 0x0000));
+    TEST_ASSERT_EQUAL_HEX8(0xB1, memoryMapReadByte(&machines[0].cpu.memoryMap, 0x7FFF));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_machine_instances_are_independent);
+    RUN_TEST(test_machine_errors_stay_with_the_machine);
+    RUN_TEST(test_machine_runs_concurrently);
+    RUN_TEST(test_machine_snapshot_restores_state);
+    RUN_TEST(test_machine_short_rom_reads_zero_past_its_end);
+    RUN_TEST(test_machine_generic_mapper_switches_banks);
+    RUN_TEST(test_machine_cartridge_mapper_switches_slots_and_banks);
+    RUN_TEST(test_machine_mapper_rejects_partial_banks);
+    return UNITY_END();
+}
@@ -0,0 +1,119 @@
+#include "unity.h"
+#include "machine.h"
+
+#define OUTPUT_PORT 0x10
+
+// LD SP,0xFFF0 / LD HL,0x8000 / LD B,200
+// loop: LD (HL),B / INC HL / ADD A,B / PUSH AF / POP DE / DJNZ loop
+// OUT (0x10),A / HALT
+static const byte_t program[] =
+{
+    0x31, 0xF0, 0xFF, 0x21, 0x00, 0x80, 0x06, 0xC8,
+    0x70, 0x23, 0x80, 0xF5, 0xD1, 0x10, 0xF9,
+    0xD3, OUTPUT_PORT, 0x76
+};
+
+static Machine_t reference;
+static Machine_t candidate;
+
+static void stopOnOutput(void *context, byte_t value)
+{
+    Machine_t *machine = (Machine_t *)context;
+
+    machine->userData = (void *)(size_t)(value + 1);
+    zilogZ80RequestStop(&machine->cpu);
+}
+
+void setUp(void)
+{
+    MachineConfig_t config = machineDefaultConfig();
+    config.backend = machineBackendFind("lane");
+
+    TEST_ASSERT_TRUE(machineInit(&reference, NULL));
+    TEST_ASSERT_TRUE(machineInit(&candidate, &config));
+    TEST_ASSERT_TRUE(machineLoadRomData(&reference, program, sizeof(program)));
+    TEST_ASSERT_TRUE(machineLoadRomData(&candidate, program, sizeof(program)));
+}
+
+void tearDown(void)
+{
+    machineDestroy(&reference);
+    machineDestroy(&candidate);
+}
+
+void test_machine_backend_registry(void)
+{
+    TEST_ASSERT_EQUAL_PTR(machineBackendGet(0), reference.backend);
+    TEST_ASSERT_EQUAL_STRING("reference", machineBackendGet(0)->name);
+    TEST_ASSERT_EQUAL_PTR(machineBackendFind("lane"), candidate.backend);
+    TEST_ASSERT_NULL(machineBackendFind("jit"));
+    TEST_ASSERT_NULL(machineBackendGet(machineBackendCount()));
+}
+
+void test_machine_backends_agree(void)
+{
+    TEST_ASSERT_EQUAL(STOP_REASON_HALT, machineRun(&reference, 100000));
+    TEST_ASSERT_EQUAL(STOP_REASON_HALT, machineRun(&candidate, 100000));
+
+    TEST_ASSERT_EQUAL(reference.cpu.runCycles, candidate.cpu.runCycles);
+    TEST_ASSERT_EQUAL(reference.cpu.runInstructions, candidate.cpu.runInstructions);
+    TEST_ASSERT_EQUAL_HEX16(reference.cpu.stopPC, candidate.cpu.stopPC);
+    TEST_ASSERT_EQUAL_HEX8(200, candidate.cpu.ram.data[0]);
+    TEST_ASSERT_TRUE(machineHashState(&reference) == machineHashState(&candidate));
+}
+
+void test_machine_backend_honors_stop_requests(void)
+{
+    candidate.cpu.outputCallback[OUTPUT_PORT] = stopOnOutput;
+
+    TEST_ASSERT_EQUAL(STOP_REASON_REQUESTED, machineRun(&candidate, 100000));
+    TEST_ASSERT_EQUAL_HEX16(0x000F, candidate.cpu.stopPC);
+    TEST_ASSERT_EQUAL_HEX16(0x0011, candidate.cpu.PC);
+    TEST_ASSERT_TRUE(candidate.userData != NULL);
+}
+
+void test_machine_backend_switch_keeps_state(void)
+{
+    machineRun(&reference, 100000);
+
+    // Start on the reference core, single step, continue on the lane core
+    machineSetBackend(&candidate, NULL);
+    machineRun(&candidate, 1000);
+    machineStep(&candidate);
+    TEST_ASSERT_TRUE(machineSetBackend(&candidate, machineBackendFind("lane")));
+    machineRun(&candidate, 500);
+    candidate.cpu.A = 0x00;
+    machineSyncState(&candidate);
+    machineStep(&candidate);
+    machineRun(&candidate, 100000);
+
+    TEST_ASSERT_TRUE(candidate.cpu.isHaltered);
+    TEST_ASSERT_EQUAL(reference.scheduler.totalCycles, candidate.scheduler.totalCycles);
+    TEST_ASSERT_EQUAL_MEMORY(reference.cpu.ram.data, candidate.cpu.ram.data, 0x100);
+}
+
+void test_machine_lane_backend_refuses_mappers(void)
+{
+    Machine_t banked;
+    MachineConfig_t config = machineDefaultConfig();
+    config.mapper = MACHINE_MAPPER_GENERIC_16K;
+
+    // Bank switches would never reach the flat lane memory, the machine stays on its backend
+    TEST_ASSERT_TRUE(machineInit(&banked, &config));
+    TEST_ASSERT_FALSE(machineSetBackend(&banked, machineBackendFind("lane")));
+    TEST_ASSERT_EQUAL_PTR(machineBackendGet(0), banked.backend);
+    machineDestroy(&banked);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_machine_backend_registry);
+    RUN_TEST(test_machine_backends_agree);
+    RUN_TEST(test_machine_backend_honors_stop_requests);
+    RUN_TEST(test_machine_backend_switch_keeps_state);
+    RUN_TEST(test_machine_lane_backend_refuses_mappers);
+
+    return UNITY_END();
+}
@@ -0,0 +1,174 @@
+#include "unity.h"
+#include "save_state.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_STATE_FILE "test_save_state.c80s"
+
+// LD HL,0x8000 / loop: INC (HL) / INC HL / JR loop (fills the RAM with ever changing bytes)
+static const byte_t program[] = { 0x21, 0x00, 0x80, 0x34, 0x23, 0x18, 0xFC };
+
+// LD A,0x04 / OUT (0xA8),A (cartridge slot in 0x4000-0x7FFF) / LD A,9 / LD (0x6800),A (bank 9
+// into the 8K window at 0x6000) / HALT
+static const byte_t cartridgeProgram[] = { 0x3E, 0x04, 0xD3, MACHINE_SLOT_PORT, 0x3E, 0x09, 0x32, 0x00, 0x68, 0x76 };
+
+/** @brief 128K ASCII 8K cartridge, the last byte of every bank is 0xC0 + bank */
+static byte_t cartridge[0x20000];
+
+static Machine_t machine;
+static Machine_t other;
+
+void setUp(void)
+{
+    TEST_ASSERT_TRUE(machineInit(&machine, NULL));
+    TEST_ASSERT_TRUE(machineInit(&other, NULL));
+    TEST_ASSERT_TRUE(machineLoadRomData(&machine, program, sizeof(program)));
+    TEST_ASSERT_TRUE(machineLoadRomData(&other, program, sizeof(program)));
+}
+
+void tearDown(void)
+{
+    machineDestroy(&machine);
+    machineDestroy(&other);
+    remove(TEST_STATE_FILE);
+}
+
+void test_save_state_resumes_the_run(void)
+{
+    machineRun(&machine, 100000);
+    machine.vdp.vram.data[0x1234] = 0x5A;
+    machine.vdp.registers[1] = 0xE0;
+
+    TEST_ASSERT_TRUE(saveStateWrite(&machine, TEST_STATE_FILE, NULL, 0));
+    qword_t savedHash = machineHashState(&machine);
+    MachineScheduler_t savedScheduler = machine.scheduler;
+
+    machineRun(&machine, 50000);
+    qword_t expectedHash = machineHashState(&machine);
+
+    // Another machine with the same ROM continues exactly where the first one was saved
+    TEST_ASSERT_TRUE(saveStateLoad(&other, TEST_STATE_FILE));
+    TEST_ASSERT_TRUE(savedHash == machineHashState(&other));
+    TEST_ASSERT_TRUE(savedScheduler.totalCycles == other.scheduler.totalCycles);
+    TEST_ASSERT_TRUE(savedScheduler.frameCount == other.scheduler.frameCount);
+    TEST_ASSERT_EQUAL(savedScheduler.frameCycles, other.scheduler.frameCycles);
+    TEST_ASSERT_EQUAL_HEX8(0x5A, other.vdp.vram.data[0x1234]);
+    TEST_ASSERT_EQUAL_HEX8(0xE0, other.vdp.registers[1]);
+
+    machineRun(&other, 50000);
+    TEST_ASSERT_TRUE(expectedHash == machineHashState(&other));
+    TEST_ASSERT_EQUAL_HEX16(machine.cpu.PC, other.cpu.PC);
+
+    // The first machine rewinds the same way
+    TEST_ASSERT_TRUE(saveStateLoad(&machine, TEST_STATE_FILE));
+    TEST_ASSERT_TRUE(savedHash == machineHashState(&machine));
+}
+
+void test_save_state_sections_are_page_aligned(void)
+{
+    const char host[] = "job output";
+    SaveStateFile_t file;
+    size_t size;
+
+    machineRun(&machine, 20000);
+    TEST_ASSERT_TRUE(saveStateWrite(&machine, TEST_STATE_FILE, host, sizeof(host)));
+    TEST_ASSERT_TRUE(saveStateOpen(&file, TEST_STATE_FILE));
+
+    TEST_ASSERT_EQUAL(0, file.map.size % SAVE_STATE_ALIGNMENT);
+    TEST_ASSERT_EQUAL(7, file.header.sectionCount);
+    for(dword_t idx = 0; idx < file.header.sectionCount; idx++)
+    {
+        TEST_ASSERT_EQUAL(0, file.sections[idx].offset % SAVE_STATE_ALIGNMENT);
+    }
+
+    // RAM is stored as is, ready to be used in place
+    const byte_t *ram = saveStateSection(&file, SAVE_STATE_SECTION_RAM, &size);
+    TEST_ASSERT_NOT_NULL(ram);
+    TEST_ASSERT_EQUAL(machine.cpu.ram.memorySize, size);
+    TEST_ASSERT_EQUAL_MEMORY(machine.cpu.ram.data, ram, size);
+
+    const byte_t *hostSection = saveStateSection(&file, SAVE_STATE_SECTION_HOST, &size);
+    TEST_ASSERT_NOT_NULL(hostSection);
+    TEST_ASSERT_EQUAL(sizeof(host), size);
+    TEST_ASSERT_EQUAL_MEMORY(host, hostSection, size);
+
+    saveStateClose(&file);
+}
+
+void test_save_state_rejects_foreign_files(void)
+{
+    static const byte_t otherProgram[] = { 0x76 };
+    errorStackSetCurrent(&other.errors);
+
+    TEST_ASSERT_FALSE(saveStateLoad(&other, "does/not/exist.c80s"));
+    TEST_ASSERT_TRUE(hasError(C80_ERROR_STATE_FILE_NOT_FOUND));
+
+    // A state of another ROM leaves the machine untouched
+    machineRun(&machine, 20000);
+    TEST_ASSERT_TRUE(saveStateWrite(&machine, TEST_STATE_FILE, NULL, 0));
+    TEST_ASSERT_TRUE(machineLoadRomData(&other, otherProgram, sizeof(otherProgram)));
+    qword_t hash = machineHashState(&other);
+
+    TEST_ASSERT_FALSE(saveStateLoad(&other, TEST_STATE_FILE));
+    TEST_ASSERT_TRUE(hasError(C80_ERROR_STATE_FILE_ROM_MISMATCH));
+    TEST_ASSERT_TRUE(hash == machineHashState(&other));
+
+    // Files of another version are not read at all
+    FILE *stream = fopen(TEST_STATE_FILE, "r+b");
+    TEST_ASSERT_NOT_NULL(stream);
+    dword_t version = SAVE_STATE_VERSION + 1;
+    fseek(stream, 8, SEEK_SET);
+    fwrite(&version, sizeof(version), 1, stream);
+    fclose(stream);
+
+    TEST_ASSERT_FALSE(saveStateLoad(&other, TEST_STATE_FILE));
+    TEST_ASSERT_TRUE(hasError(C80_ERROR_STATE_FILE_FORMAT_ERROR));
+
+    errorStackSetCurrent(NULL);
+}
+
+void test_save_state_restores_banks_and_slots(void)
+{
+    MachineConfig_t config = machineDefaultConfig();
+    config.mapper = MACHINE_MAPPER_ASCII8;
+
+    memcpy(cartridge, cartridgeProgram, sizeof(cartridgeProgram));
+    for(size_t bank = 0; bank < sizeof(cartridge) / 0x2000; bank++)
+    {
+        cartridge[bank * 0x2000 + 0x1FFF] = (byte_t)(0xC0 + bank);
+    }
+
+    machineDestroy(&machine);
+    TEST_ASSERT_TRUE(machineInit(&machine, &config));
+    TEST_ASSERT_TRUE(machineLoadRomData(&machine, cartridge, sizeof(cartridge)));
+    TEST_ASSERT_EQUAL(STOP_REASON_HALT, machineRun(&machine, 1000));
+    TEST_ASSERT_EQUAL_HEX8(0xC9, memoryMapReadByte(&machine.cpu.memoryMap, 0x7FFF));
+
+    TEST_ASSERT_TRUE(saveStateWrite(&machine, TEST_STATE_FILE, NULL, 0));
+
+    machineReset(&machine);
+    TEST_ASSERT_EQUAL_HEX8(MEMORY_OPEN_BUS, memoryMapReadByte(&machine.cpu.memoryMap, 0x7FFF));
+
+    TEST_ASSERT_TRUE(saveStateLoad(&machine, TEST_STATE_FILE));
+    TEST_ASSERT_EQUAL_HEX8(0x04, machine.slots->primarySelect);
+    TEST_ASSERT_EQUAL(9, mapperGetBank(&machine.mapper, 1));
+    TEST_ASSERT_EQUAL_HEX8(0xC9, memoryMapReadByte(&machine.cpu.memoryMap, 0x7FFF));
+
+    // Same image, flat layout: the banks would mean nothing there
+    errorStackSetCurrent(&other.errors);
+    TEST_ASSERT_TRUE(machineLoadRomData(&other, cartridge, sizeof(cartridge)));
+    TEST_ASSERT_FALSE(saveStateLoad(&other, TEST_STATE_FILE));
+    TEST_ASSERT_TRUE(hasError(C80_ERROR_STATE_FILE_ROM_MISMATCH));
+    errorStackSetCurrent(NULL);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_save_state_resumes_the_run);
+    RUN_TEST(test_save_state_sections_are_page_aligned);
+    RUN_TEST(test_save_state_rejects_foreign_files);
+    RUN_TEST(test_save_state_restores_banks_and_slots);
+    return UNITY_END();
+}
@@ -0,0 +1,120 @@
+#include "unity.h"
+#include "memory_map.h"
+#include "mapper.h"
+#include "msx_slots.h"
+
+#define IMAGE_SIZE 0x20000
+
+static MemoryMap_t map;
+static Mapper_t mapper;
+static byte_t image[IMAGE_SIZE];
+
+void setUp(void)
+{
+    memoryMapInit(&map);
+
+    // Every 8K bank is filled with its bank number
+    for(int i = 0; i < IMAGE_SIZE; i++)
+    {
+        image[i] = (byte_t)(i / 0x2000);
+    }
+}
+
+void tearDown(void)
+{
+    // Cleanup resources after each test.
+}
+
+void test_mapper_ascii8_bank_switch(void)
+{
+    TEST_ASSERT_TRUE(mapperInit(&mapper, MAPPER_TYPE_ASCII8, &map, image, IMAGE_SIZE));
+
+    TEST_ASSERT_EQUAL(0, memoryMapReadByte(&map, 0x4000));
+    TEST_ASSERT_EQUAL(0, memoryMapReadByte(&map, 0xA000));
+
+    memoryMapWriteByte(&map, 0x6000, 5);
+    memoryMapWriteByte(&map, 0x7800, 9);
+
+    TEST_ASSERT_EQUAL(5, memoryMapReadByte(&map, 0x4000));
+    TEST_ASSERT_EQUAL(9, memoryMapReadByte(&map, 0xBFFF));
+    TEST_ASSERT_EQUAL(5, mapperGetBank(&mapper, 0));
+
+    // Register writes do not reach the ROM image
+    TEST_ASSERT_EQUAL(3, image[0x6000]);
+}
+
+void test_mapper_ascii16_bank_switch(void)
+{
+    TEST_ASSERT_TRUE(mapperInit(&mapper, MAPPER_TYPE_ASCII16, &map, image, IMAGE_SIZE));
+
+    memoryMapWriteByte(&map, 0x7000, 3);
+
+    TEST_ASSERT_EQUAL(0, memoryMapReadByte(&map, 0x4000));
+    TEST_ASSERT_EQUAL(6, memoryMapReadByte(&map, 0x8000));
+    TEST_ASSERT_EQUAL(7, memoryMapReadByte(&map, 0xA000));
+}
+
+void test_mapper_konami_first_window_fixed(void)
+{
+    TEST_ASSERT_TRUE(mapperInit(&mapper, MAPPER_TYPE_KONAMI, &map, image, IMAGE_SIZE));
+
+    TEST_ASSERT_EQUAL(1, memoryMapReadByte(&map, 0x6000));
+
+    memoryMapWriteByte(&map, 0x4000, 7);
+    memoryMapWriteByte(&map, 0xA000, 12);
+
+    TEST_ASSERT_EQUAL(0, memoryMapReadByte(&map, 0x4000));
+    TEST_ASSERT_EQUAL(12, memoryMapReadByte(&map, 0xA000));
+}
+
+void test_mapper_generic_ram_paging(void)
+{
+    TEST_ASSERT_TRUE(mapperInitGeneric(&mapper, &map, 2, 2, image, IMAGE_SIZE, true));
+
+    mapperSelectBank(&mapper, 0, 4);
+    memoryMapWriteByte(&map, 0x8000, 0xAA);
+
+    TEST_ASSERT_EQUAL(0xAA, image[4 * 0x4000]);
+
+    mapperSelectBank(&mapper, 1, 4);
+    TEST_ASSERT_EQUAL(0xAA, memoryMapReadByte(&map, 0xC000));
+}
+
+void test_msx_slots_primary_and_secondary_select(void)
+{
+    static MsxSlots_t slots;
+    static byte_t ram[0x10000];
+
+    msxSlotsInit(&slots, &map);
+    msxSlotsSetExpanded(&slots, 3, true);
+
+    memoryMapMapRegion(msxSlotsGetSlotMap(&slots, 0, 0), 0x0000, 0x8000, image, false);
+    memoryMapMapRegion(msxSlotsGetSlotMap(&slots, 3, 2), 0x0000, 0x10000, ram, true);
+    msxSlotsRefresh(&slots);
+
+    TEST_ASSERT_EQUAL(2, memoryMapReadByte(&map, 0x4000));
+
+    // Page 3 -> slot 3, subslot 2 in every page
+    msxSlotsWritePrimary(&slots, 0xC0);
+    memoryMapWriteByte(&map, MSX_SUBSLOT_REGISTER, 0xAA);
+    TEST_ASSERT_EQUAL(0x55, memoryMapReadByte(&map, MSX_SUBSLOT_REGISTER));
+
+    memoryMapWriteByte(&map, 0xC000, 0x12);
+    TEST_ASSERT_EQUAL(0x12, ram[0xC000]);
+
+    // Page 0 switched to slot 3 as well
+    msxSlotsWritePrimary(&slots, 0xC3);
+    memoryMapWriteByte(&map, 0x0010, 0x34);
+    TEST_ASSERT_EQUAL(0x34, ram[0x0010]);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_mapper_ascii8_bank_switch);
+    RUN_TEST(test_mapper_ascii16_bank_switch);
+    RUN_TEST(test_mapper_konami_first_window_fixed);
+    RUN_TEST(test_mapper_generic_ram_paging);
+    RUN_TEST(test_msx_slots_primary_and_secondary_select);
+    return UNITY_END();
+}
@@ -0,0 +1,163 @@
+#include "unity.h"
+#include "memory_map.h"
+
+static MemoryMap_t map;
+static byte_t ram[0x4000];
+static byte_t rom[0x4000];
+
+static byte_t deviceRegister;
+static word_t deviceLastAddress;
+
+static byte_t deviceRead(void *context, word_t address)
+{
+    deviceLastAddress = address;
+    return *(byte_t *)context;
+}
+
+static void deviceWrite(void *context, word_t address, byte_t value)
+{
+    deviceLastAddress = address;
+    *(byte_t *)context = value;
+}
+
+void setUp(void)
+{
+    memoryMapInit(&map);
+    for(int i = 0; i < 0x4000; i++)
+    {
+        ram[i] = 0x00;
+        rom[i] = (byte_t)i;
+    }
+    deviceRegister = 0x00;
+    deviceLastAddress = 0x0000;
+}
+
+void tearDown(void)
+{
+    // Cleanup resources after each test.
+}
+
+void test_memory_map_unmapped_reads_open_bus(void)
+{
+    TEST_ASSERT_EQUAL(MEMORY_OPEN_BUS, memoryMapReadByte(&map, 0x1234));
+
+    memoryMapWriteByte(&map, 0x1234, 0x42);
+    TEST_ASSERT_EQUAL(MEMORY_OPEN_BUS, memoryMapReadByte(&map, 0x1234));
+}
+
+void test_memory_map_region_fast_path(void)
+{
+    memoryMapMapRegion(&map, 0x0000, sizeof(rom), rom, false);
+    memoryMapMapRegion(&map, 0xC000, sizeof(ram), ram, true);
+
+    TEST_ASSERT_NOT_NULL(map.readPages[0]);
+    TEST_ASSERT_NULL(map.writePages[0]);
+    TEST_ASSERT_NOT_NULL(map.writePages[0xC000 >> MEMORY_PAGE_SHIFT]);
+
+    TEST_ASSERT_EQUAL(0x34, memoryMapReadByte(&map, 0x1234));
+
+    memoryMapWriteByte(&map, 0x1234, 0x99);
+    TEST_ASSERT_EQUAL(0x34, rom[0x1234]);
+
+    memoryMapWriteWord(&map, 0xC010, 0xBEEF);
+    TEST_ASSERT_EQUAL(0xEF, ram[0x0010]);
+    TEST_ASSERT_EQUAL(0xBE, ram[0x0011]);
+    TEST_ASSERT_EQUAL(0xBEEF, memoryMapReadWord(&map, 0xC010));
+}
+
+void test_memory_map_handler_pages(void)
+{
+    memoryMapMapRegion(&map, 0x0000, sizeof(rom), rom, false);
+    memoryMapMapHandler(&map, 0x8000, MEMORY_PAGE_SIZE, deviceRead, deviceWrite, &deviceRegister);
+
+    TEST_ASSERT_NULL(map.readPages[0x8000 >> MEMORY_PAGE_SHIFT]);
+    TEST_ASSERT_NULL(map.writePages[0x8000 >> MEMORY_PAGE_SHIFT]);
+
+    memoryMapWriteByte(&map, 0x8012, 0x5A);
+    TEST_ASSERT_EQUAL(0x5A, deviceRegister);
+    TEST_ASSERT_EQUAL(0x8012, deviceLastAddress);
+
+    TEST_ASSERT_EQUAL(0x5A, memoryMapReadByte(&map, 0x83FF));
+    TEST_ASSERT_EQUAL(0x83FF, deviceLastAddress);
+
+    // Neighbouring page is not affected
+    TEST_ASSERT_EQUAL(MEMORY_OPEN_BUS, memoryMapReadByte(&map, 0x8400));
+}
+
+void test_memory_map_write_handler_keeps_read_context(void)
+{
+    byte_t bankRegister = 0x00;
+
+    // A second device takes over the writes of a page, reads still reach the first one
+    memoryMapMapHandler(&map, 0x8000, MEMORY_PAGE_SIZE, deviceRead, deviceWrite, &deviceRegister);
+    deviceRegister = 0x3C;
+    memoryMapSetWriteHandler(&map, 0x8000, MEMORY_PAGE_SIZE, deviceWrite, &bankRegister);
+
+    memoryMapWriteByte(&map, 0x8001, 0x07);
+    TEST_ASSERT_EQUAL(0x07, bankRegister);
+    TEST_ASSERT_EQUAL(0x3C, deviceRegister);
+    TEST_ASSERT_EQUAL(0x3C, memoryMapReadByte(&map, 0x8002));
+}
+
+void test_memory_map_unmap(void)
+{
+    memoryMapMapRegion(&map, 0xC000, sizeof(ram), ram, true);
+    memoryMapUnmap(&map, 0xC000, MEMORY_PAGE_SIZE);
+
+    TEST_ASSERT_NULL(map.readPages[0xC000 >> MEMORY_PAGE_SHIFT]);
+    TEST_ASSERT_EQUAL(MEMORY_OPEN_BUS, memoryMapReadByte(&map, 0xC000));
+    TEST_ASSERT_NOT_NULL(map.readPages[0xC400 >> MEMORY_PAGE_SHIFT]);
+}
+
+void test_memory_map_word_wraps_around(void)
+{
+    memoryMapMapRegion(&map, 0x0000, sizeof(rom), rom, false);
+    memoryMapMapRegion(&map, 0xC000, sizeof(ram), ram, true);
+
+    ram[0x3FFF] = 0x11;
+    TEST_ASSERT_EQUAL(0x0011, memoryMapReadWord(&map, 0xFFFF));
+}
+
+void test_memory_map_watchpoint_only_traps_watched_pages(void)
+{
+    memoryMapMapRegion(&map, 0xC000, sizeof(ram), ram, true);
+
+    int index = memoryMapAddWatchpoint(&map, 0xC810, 0xC81F, WATCHPOINT_WRITE, WATCHPOINT_ACTION_BREAK);
+    TEST_ASSERT_EQUAL(0, index);
+
+    TEST_ASSERT_NULL(map.writePages[0xC800 >> MEMORY_PAGE_SHIFT]);
+    TEST_ASSERT_NOT_NULL(map.readPages[0xC800 >> MEMORY_PAGE_SHIFT]);
+    TEST_ASSERT_NOT_NULL(map.writePages[0xC400 >> MEMORY_PAGE_SHIFT]);
+
+    // Same page, outside of the range
+    memoryMapWriteByte(&map, 0xC800, 0x01);
+    TEST_ASSERT_EQUAL(0, map.pendingHitCount);
+    TEST_ASSERT_EQUAL(0x01, ram[0x0800]);
+
+    memoryMapWriteByte(&map, 0xC815, 0x77);
+    TEST_ASSERT_EQUAL(1, map.pendingHitCount);
+    TEST_ASSERT_EQUAL(0xC815, map.pendingHits[0].address);
+    TEST_ASSERT_EQUAL(0x77, map.pendingHits[0].value);
+    TEST_ASSERT_EQUAL(WATCHPOINT_WRITE, map.pendingHits[0].access);
+    TEST_ASSERT_EQUAL(0x77, ram[0x0815]);
+
+    // Reads are not watched
+    memoryMapReadByte(&map, 0xC815);
+    TEST_ASSERT_EQUAL(1, map.pendingHitCount);
+
+    memoryMapRemoveWatchpoint(&map, index);
+    TEST_ASSERT_NOT_NULL(map.writePages[0xC800 >> MEMORY_PAGE_SHIFT]);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_memory_map_unmapped_reads_open_bus);
+    RUN_TEST(test_memory_map_region_fast_path);
+    RUN_TEST(test_memory_map_handler_pages);
+    RUN_TEST(test_memory_map_write_handler_keeps_read_context);
+    RUN_TEST(test_memory_map_unmap);
+    RUN_TEST(test_memory_map_word_wraps_around);
+    RUN_TEST(test_memory_map_watchpoint_only_traps_watched_pages);
+    return UNITY_END();
+}
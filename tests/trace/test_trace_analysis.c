@@ -0,0 +1,249 @@
+#include "unity.h"
+#include "trace_analysis.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_TRACE_FILE "test_trace_analysis.c80t"
+#define TEST_RECORDS 20000
+#define TEST_KEYFRAME_INTERVAL 128
+
+static TraceRecord_t records[TEST_RECORDS];
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+    remove(TEST_TRACE_FILE);
+}
+
+/**
+ * @brief Returns a record with the given instruction bytes
+ */
+static TraceRecord_t makeRecord(byte_t first, byte_t second, byte_t third, byte_t fourth)
+{
+    TraceRecord_t record;
+
+    memset(&record, 0x00, sizeof(record));
+    record.opcode[0] = first;
+    record.opcode[1] = second;
+    record.opcode[2] = third;
+    record.opcode[3] = fourth;
+
+    return record;
+}
+
+/**
+ * @brief Writes a trace of a loop storing to (HL) and writing to port 0x10 every 8 records
+ */
+static void writeTrace(void)
+{
+    static const byte_t loop[][TRACE_OPCODE_BYTES] = {
+        { 0x77, 0x23, 0x00, 0x00 },
+        { 0x23, 0x00, 0x00, 0x00 },
+        { 0xD3, 0x10, 0x00, 0x00 },
+        { 0x7E, 0x00, 0x00, 0x00 },
+        { 0xC5, 0x00, 0x00, 0x00 },
+        { 0xC1, 0x00, 0x00, 0x00 },
+        { 0x3C, 0x00, 0x00, 0x00 },
+        { 0x18, 0xF8, 0x00, 0x00 }};
+    static const int loopCycles[] = { 7, 6, 11, 7, 11, 10, 4, 12 };
+    TraceFileWriter_t writer;
+
+    memset(records, 0x00, sizeof(records));
+    for(int idx = 0; idx < TEST_RECORDS; idx++)
+    {
+        TraceRecord_t *record = &records[idx];
+        int step = idx % 8;
+
+        if(idx > 0)
+        {
+            *record = records[idx - 1];
+        }
+
+        record->pc = (word_t)(0x0100 + step);
+        memcpy(record->opcode, loop[step], TRACE_OPCODE_BYTES);
+        record->cycle += (qword_t)loopCycles[step];
+        record->sp = 0xF000;
+        record->hl = (word_t)(0xC000 + idx / 8);
+        record->af = (word_t)((idx / 8) << 8);
+    }
+
+    TEST_ASSERT_TRUE(traceFileWriterOpen(&writer, TEST_TRACE_FILE, TEST_KEYFRAME_INTERVAL));
+    traceFileSink(&writer, records, TEST_RECORDS);
+    TEST_ASSERT_TRUE(traceFileWriterClose(&writer));
+}
+
+void test_trace_decode_accesses(void)
+{
+    TraceAccess_t accesses[TRACE_MAX_ACCESSES];
+    TraceRecord_t before = makeRecord(0x00, 0x00, 0x00, 0x00);
+    TraceRecord_t after;
+
+    before.hl = 0x8000;
+    before.sp = 0xF000;
+    before.bc = 0x0510;
+    before.ix = 0x4000;
+    before.af = 0x4200;
+
+    // LD (HL),A
+    after = makeRecord(0x77, 0x00, 0x00, 0x00);
+    TEST_ASSERT_EQUAL(1, traceDecodeAccesses(&before, &after, accesses));
+    TEST_ASSERT_EQUAL(TRACE_ACCESS_WRITE, accesses[0].kind);
+    TEST_ASSERT_EQUAL_HEX16(0x8000, accesses[0].address);
+
+    // PUSH BC writes below SP
+    after = makeRecord(0xC5, 0x00, 0x00, 0x00);
+    TEST_ASSERT_EQUAL(2, traceDecodeAccesses(&before, &after, accesses));
+    TEST_ASSERT_EQUAL_HEX16(0xEFFF, accesses[0].address);
+    TEST_ASSERT_EQUAL_HEX16(0xEFFE, accesses[1].address);
+
+    // RET NZ only reads the stack if taken
+    after = makeRecord(0xC0, 0x00, 0x00, 0x00);
+    after.sp = 0xF000;
+    TEST_ASSERT_EQUAL(0, traceDecodeAccesses(&before, &after, accesses));
+    after.sp = 0xF002;
+    TEST_ASSERT_EQUAL(2, traceDecodeAccesses(&before, &after, accesses));
+    TEST_ASSERT_EQUAL(TRACE_ACCESS_READ, accesses[0].kind);
+
+    // LD (IX-2),0x55
+    after = makeRecord(0xDD, 0x36, 0xFE, 0x55);
+    TEST_ASSERT_EQUAL(1, traceDecodeAccesses(&before, &after, accesses));
+    TEST_ASSERT_EQUAL_HEX16(0x3FFE, accesses[0].address);
+
+    // BIT 0,(IX+1) reads, SET 0,(IX+1) reads and writes
+    after = makeRecord(0xDD, 0xCB, 0x01, 0x46);
+    TEST_ASSERT_EQUAL(1, traceDecodeAccesses(&before, &after, accesses));
+    after = makeRecord(0xDD, 0xCB, 0x01, 0xC6);
+    TEST_ASSERT_EQUAL(2, traceDecodeAccesses(&before, &after, accesses));
+    TEST_ASSERT_EQUAL_HEX16(0x4001, accesses[1].address);
+
+    // OUT (0x20),A puts A on the high byte of the port
+    after = makeRecord(0xD3, 0x20, 0x00, 0x00);
+    TEST_ASSERT_EQUAL(1, traceDecodeAccesses(&before, &after, accesses));
+    TEST_ASSERT_EQUAL(TRACE_ACCESS_OUT, accesses[0].kind);
+    TEST_ASSERT_EQUAL_HEX16(0x4220, accesses[0].address);
+    TEST_ASSERT_EQUAL(0x42, accesses[0].value);
+
+    // OUTI reads (HL) and outputs to port (B-1)C
+    after = makeRecord(0xED, 0xA3, 0x00, 0x00);
+    TEST_ASSERT_EQUAL(2, traceDecodeAccesses(&before, &after, accesses));
+    TEST_ASSERT_EQUAL_HEX16(0x0410, accesses[1].address);
+    TEST_ASSERT_EQUAL(-1, accesses[1].value);
+
+    // HALT, NOP, ALU on registers
+    after = makeRecord(0x76, 0x00, 0x00, 0x00);
+    TEST_ASSERT_EQUAL(0, traceDecodeAccesses(&before, &after, accesses));
+    after = makeRecord(0x80, 0x00, 0x00, 0x00);
+    TEST_ASSERT_EQUAL(0, traceDecodeAccesses(&before, &after, accesses));
+}
+
+void test_trace_conditions(void)
+{
+    TraceCondition_t condition;
+    TraceRecord_t record = makeRecord(0x00, 0x00, 0x00, 0x00);
+    TraceAccess_t access = { TRACE_ACCESS_WRITE, 0xC000, -1 };
+
+    record.hl = 0x8000;
+    record.af = 0x81FF;
+
+    TEST_ASSERT_TRUE(traceConditionParse(&condition, "hl==0x8000"));
+    TEST_ASSERT_TRUE(traceConditionMatchesRecord(&condition, &record));
+    TEST_ASSERT_TRUE(traceConditionParse(&condition, "a>=128"));
+    TEST_ASSERT_TRUE(traceConditionMatchesRecord(&condition, &record));
+    TEST_ASSERT_TRUE(traceConditionParse(&condition, "f&0x40"));
+    TEST_ASSERT_TRUE(traceConditionMatchesRecord(&condition, &record));
+    TEST_ASSERT_TRUE(traceConditionParse(&condition, "sp!=0"));
+    TEST_ASSERT_FALSE(traceConditionMatchesRecord(&condition, &record));
+
+    TEST_ASSERT_TRUE(traceConditionParse(&condition, "write==0xC000"));
+    TEST_ASSERT_TRUE(traceConditionMatchesAccess(&condition, &access));
+    access.kind = TRACE_ACCESS_READ;
+    TEST_ASSERT_FALSE(traceConditionMatchesAccess(&condition, &access));
+
+    TEST_ASSERT_FALSE(traceConditionParse(&condition, "xy==1"));
+    TEST_ASSERT_FALSE(traceConditionParse(&condition, "hl=1"));
+    TEST_ASSERT_FALSE(traceConditionParse(&condition, "hl==1z"));
+}
+
+void test_trace_analysis_parallel_matches_serial(void)
+{
+    TraceAnalysisOptions_t options;
+    TraceFile_t file;
+
+    writeTrace();
+    TEST_ASSERT_TRUE(traceFileOpen(&file, TEST_TRACE_FILE));
+
+    memset(&options, 0x00, sizeof(options));
+    options.timelineEvents = 16;
+    TEST_ASSERT_TRUE(traceConditionParse(&options.conditions[0], "write==0xC100"));
+    TEST_ASSERT_TRUE(traceConditionParse(&options.conditions[1], "a==0x80"));
+    TEST_ASSERT_TRUE(traceConditionParse(&options.conditions[2], "in==0x10"));
+    options.conditionCount = 3;
+
+    options.workerCount = 1;
+    TraceAnalysis_t *serial = traceAnalysisCreate();
+    TEST_ASSERT_TRUE(traceAnalyze(&file, &options, serial));
+
+    options.workerCount = 4;
+    TraceAnalysis_t *parallel = traceAnalysisCreate();
+    TEST_ASSERT_TRUE(traceAnalyze(&file, &options, parallel));
+
+    TEST_ASSERT_EQUAL(TEST_RECORDS, serial->opcodes.instructions);
+    TEST_ASSERT_EQUAL(records[TEST_RECORDS - 1].cycle, serial->opcodes.totalCycles);
+    TEST_ASSERT_EQUAL(TEST_RECORDS / 8, serial->pcCounts[0x0102]);
+    TEST_ASSERT_EQUAL(TEST_RECORDS / 8, serial->accesses[TRACE_ACCESS_OUT][0x10]);
+    TEST_ASSERT_EQUAL(1, serial->accesses[TRACE_ACCESS_WRITE][0xC100]);
+
+    // Counters, the timeline and the first matches do not depend on the split
+    TEST_ASSERT_EQUAL(0, memcmp(serial->pcCounts, parallel->pcCounts, sizeof(serial->pcCounts)));
+    TEST_ASSERT_EQUAL(0, memcmp(serial->pcCycles, parallel->pcCycles, sizeof(serial->pcCycles)));
+    TEST_ASSERT_EQUAL(0, memcmp(serial->accesses, parallel->accesses, sizeof(serial->accesses)));
+    TEST_ASSERT_EQUAL(0, memcmp(serial->opcodes.counts, parallel->opcodes.counts, sizeof(serial->opcodes.counts)));
+    TEST_ASSERT_EQUAL(serial->opcodes.totalCycles, parallel->opcodes.totalCycles);
+
+    // Every step is one opcode pair, the seams between the chunks included
+    OpcodePairEntry_t serialPairs[8];
+    OpcodePairEntry_t parallelPairs[8];
+    size_t pairCount = opcodeProfileTopPairs(&serial->opcodes, serialPairs, 8);
+    TEST_ASSERT_EQUAL(8, pairCount);
+    TEST_ASSERT_EQUAL(pairCount, opcodeProfileTopPairs(&parallel->opcodes, parallelPairs, 8));
+
+    qword_t pairExecutions = 0;
+    for(size_t idx = 0; idx < pairCount; idx++)
+    {
+        pairExecutions += serialPairs[idx].count;
+        TEST_ASSERT_EQUAL(serialPairs[idx].firstGroup, parallelPairs[idx].firstGroup);
+        TEST_ASSERT_EQUAL_HEX8(serialPairs[idx].firstOpcode, parallelPairs[idx].firstOpcode);
+        TEST_ASSERT_EQUAL_HEX8(serialPairs[idx].secondOpcode, parallelPairs[idx].secondOpcode);
+        TEST_ASSERT_TRUE(serialPairs[idx].count == parallelPairs[idx].count);
+    }
+    TEST_ASSERT_TRUE(pairExecutions == TEST_RECORDS - 1);
+
+    TEST_ASSERT_EQUAL(16, parallel->eventCount);
+    TEST_ASSERT_EQUAL(0, memcmp(serial->events, parallel->events, 16 * sizeof(TraceIoEvent_t)));
+    TEST_ASSERT_EQUAL(2, parallel->events[0].record);
+    TEST_ASSERT_EQUAL_HEX16(0x0010, parallel->events[0].port);
+
+    // HL moves on at step 0, LD (HL),A writes the HL of the record before
+    TEST_ASSERT_TRUE(parallel->matches[0].isFound);
+    TEST_ASSERT_EQUAL(257 * 8, parallel->matches[0].record);
+    TEST_ASSERT_TRUE(parallel->matches[1].isFound);
+    TEST_ASSERT_EQUAL(128 * 8, parallel->matches[1].record);
+    TEST_ASSERT_FALSE(parallel->matches[2].isFound);
+
+    traceAnalysisDestroy(serial);
+    traceAnalysisDestroy(parallel);
+    traceFileClose(&file);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_trace_decode_accesses);
+    RUN_TEST(test_trace_conditions);
+    RUN_TEST(test_trace_analysis_parallel_matches_serial);
+    return UNITY_END();
+}
@@ -0,0 +1,145 @@
+#include "unity.h"
+#include "trace_diff.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_FIRST_FILE "test_trace_diff_first.c80t"
+#define TEST_SECOND_FILE "test_trace_diff_second.c80t"
+#define TEST_RECORDS 10000
+
+static TraceRecord_t records[TEST_RECORDS];
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+    remove(TEST_FIRST_FILE);
+    remove(TEST_SECOND_FILE);
+}
+
+/**
+ * @brief Fills records with a counting loop
+ */
+static void makeRecords(void)
+{
+    static const byte_t loop[][TRACE_OPCODE_BYTES] = {
+        { 0x3C, 0x23, 0x18, 0xFC },
+        { 0x23, 0x18, 0xFC, 0x00 },
+        { 0x18, 0xFC, 0x00, 0x00 }};
+    static const int loopCycles[] = { 4, 6, 12 };
+
+    memset(records, 0x00, sizeof(records));
+    for(int idx = 0; idx < TEST_RECORDS; idx++)
+    {
+        TraceRecord_t *record = &records[idx];
+        int step = idx % 3;
+
+        if(idx > 0)
+        {
+            *record = records[idx - 1];
+        }
+
+        record->pc = (word_t)(0x0100 + step);
+        memcpy(record->opcode, loop[step], TRACE_OPCODE_BYTES);
+        record->cycle += (qword_t)loopCycles[step];
+        record->af += (step == 0) ? 0x0100 : 0;
+        record->hl += (step == 1) ? 1 : 0;
+    }
+}
+
+/**
+ * @brief Writes records to a trace file
+ */
+static void writeRecords(const char *filename, size_t count, dword_t keyframeInterval)
+{
+    TraceFileWriter_t writer;
+
+    TEST_ASSERT_TRUE(traceFileWriterOpen(&writer, filename, keyframeInterval));
+    traceFileSink(&writer, records, count);
+    TEST_ASSERT_TRUE(traceFileWriterClose(&writer));
+}
+
+/**
+ * @brief Compares the two test files
+ */
+static void findDivergence(TraceDivergence_t *divergence)
+{
+    TraceFile_t first;
+    TraceFile_t second;
+
+    TEST_ASSERT_TRUE(traceFileOpen(&first, TEST_FIRST_FILE));
+    TEST_ASSERT_TRUE(traceFileOpen(&second, TEST_SECOND_FILE));
+    TEST_ASSERT_TRUE(traceDiffFind(&first, &second, divergence));
+    traceFileClose(&first);
+    traceFileClose(&second);
+}
+
+void test_trace_diff_identical(void)
+{
+    TraceDivergence_t divergence;
+
+    makeRecords();
+    writeRecords(TEST_FIRST_FILE, TEST_RECORDS, 256);
+    writeRecords(TEST_SECOND_FILE, TEST_RECORDS, 1000);
+
+    findDivergence(&divergence);
+    TEST_ASSERT_FALSE(divergence.isDiverged);
+}
+
+void test_trace_diff_finds_first_differing_record(void)
+{
+    static const qword_t targets[] = { 0, 1, 255, 256, 257, 4321, TEST_RECORDS - 1 };
+    TraceDivergence_t divergence;
+
+    for(size_t idx = 0; idx < sizeof(targets) / sizeof(targets[0]); idx++)
+    {
+        qword_t target = targets[idx];
+
+        makeRecords();
+        writeRecords(TEST_FIRST_FILE, TEST_RECORDS, 256);
+
+        // The second run takes a different branch from the target on
+        for(qword_t record = target; record < TEST_RECORDS; record++)
+        {
+            records[record].cycle += 3;
+        }
+        records[target].bc = 0x1234;
+        writeRecords(TEST_SECOND_FILE, TEST_RECORDS, 100);
+
+        findDivergence(&divergence);
+        TEST_ASSERT_TRUE(divergence.isDiverged);
+        TEST_ASSERT_FALSE(divergence.isLengthDifferent);
+        TEST_ASSERT_EQUAL(target, divergence.record);
+        TEST_ASSERT_EQUAL_HEX16(0x1234, divergence.second.bc);
+        TEST_ASSERT_EQUAL(target > 0, divergence.hasPrevious);
+
+        // Only the window between two keyframes is compared in lockstep
+        TEST_ASSERT_TRUE(divergence.recordsCompared <= 257);
+    }
+}
+
+void test_trace_diff_shorter_trace(void)
+{
+    TraceDivergence_t divergence;
+
+    makeRecords();
+    writeRecords(TEST_FIRST_FILE, TEST_RECORDS, 256);
+    writeRecords(TEST_SECOND_FILE, 5000, 256);
+
+    findDivergence(&divergence);
+    TEST_ASSERT_TRUE(divergence.isDiverged);
+    TEST_ASSERT_TRUE(divergence.isLengthDifferent);
+    TEST_ASSERT_EQUAL(5000, divergence.record);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_trace_diff_identical);
+    RUN_TEST(test_trace_diff_finds_first_differing_record);
+    RUN_TEST(test_trace_diff_shorter_trace);
+    return UNITY_END();
+}
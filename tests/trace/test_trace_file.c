@@ -0,0 +1,185 @@
+#include "unity.h"
+#include "trace_file.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_TRACE_FILE "test_trace_file.c80t"
+#define TEST_RECORDS 5000
+#define TEST_KEYFRAME_INTERVAL 256
+
+static TraceRecord_t records[TEST_RECORDS];
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+    remove(TEST_TRACE_FILE);
+}
+
+/**
+ * @brief Fills records with a trace that looks like a program: a loop over a few instructions
+ * with small register changes, random jumps and register loads, code patched at run time
+ * and a long stall
+ */
+static void makeRecords(void)
+{
+    static const byte_t loop[][TRACE_OPCODE_BYTES] = {
+        { 0x3E, 0x12, 0x23, 0x10 },
+        { 0x23, 0x10, 0xFB, 0xC3 },
+        { 0x10, 0xFB, 0xC3, 0x00 },
+        { 0xC3, 0x00, 0x01, 0x00 }};
+    static const word_t loopPc[] = { 0x0100, 0x0102, 0x0103, 0x0105 };
+    static const int loopCycles[] = { 7, 6, 13, 10 };
+    dword_t random = 12345;
+
+    memset(records, 0x00, sizeof(records));
+
+    for(int idx = 0; idx < TEST_RECORDS; idx++)
+    {
+        TraceRecord_t *record = &records[idx];
+        int step = idx % 4;
+
+        if(idx > 0)
+        {
+            *record = records[idx - 1];
+        }
+
+        record->pc = loopPc[step];
+        memcpy(record->opcode, loop[step], TRACE_OPCODE_BYTES);
+        record->cycle += (qword_t)loopCycles[step];
+        record->hl++;
+        record->af = (word_t)((record->af & 0xFF00) | (idx & 0xD7));
+
+        random = random * 1103515245u + 12345u;
+        if((random >> 16) % 50 == 0)
+        {
+            record->pc = (word_t)(random >> 8);
+            record->bc = (word_t)random;
+            record->sp = (word_t)(random >> 12);
+        }
+        if(idx >= 1000)
+        {
+            record->opcode[1] = (step == 0) ? 0x34 : record->opcode[1];
+        }
+        if(idx == 3000)
+        {
+            record->cycle += 1000000;
+            record->i = 0x3F;
+            record->flags = TRACE_FLAG_HALTED;
+        }
+    }
+}
+
+/**
+ * @brief Writes the records with the test keyframe interval
+ */
+static void writeRecords(void)
+{
+    TraceFileWriter_t writer;
+
+    TEST_ASSERT_TRUE(traceFileWriterOpen(&writer, TEST_TRACE_FILE, TEST_KEYFRAME_INTERVAL));
+    traceFileSink(&writer, records, TEST_RECORDS);
+    TEST_ASSERT_TRUE(traceFileWriterClose(&writer));
+}
+
+void test_trace_file_round_trip(void)
+{
+    TraceFile_t file;
+    TraceRecord_t record;
+
+    makeRecords();
+    writeRecords();
+
+    TEST_ASSERT_TRUE(traceFileOpen(&file, TEST_TRACE_FILE));
+    TEST_ASSERT_EQUAL(TEST_RECORDS, file.recordCount);
+    TEST_ASSERT_EQUAL((TEST_RECORDS + TEST_KEYFRAME_INTERVAL - 1) / TEST_KEYFRAME_INTERVAL, file.blockCount);
+    TEST_ASSERT_FALSE(file.isIndexRebuilt);
+
+    // Loops compress to a few bytes per record
+    TEST_ASSERT_TRUE(file.map.size < TEST_RECORDS * sizeof(TraceRecord_t) / 5);
+
+    TraceCursor_t *cursor = traceCursorCreate(&file);
+    TEST_ASSERT_NOT_NULL(cursor);
+
+    for(int idx = 0; idx < TEST_RECORDS; idx++)
+    {
+        TEST_ASSERT_TRUE(traceCursorNext(cursor, &record));
+        TEST_ASSERT_EQUAL(0, memcmp(&record, &records[idx], sizeof(record)));
+    }
+    TEST_ASSERT_FALSE(traceCursorNext(cursor, &record));
+
+    traceCursorDestroy(cursor);
+    traceFileClose(&file);
+}
+
+void test_trace_file_seeks_to_any_record(void)
+{
+    static const qword_t targets[] = { 0, 1, 255, 256, 257, 3000, 2999, TEST_RECORDS - 1 };
+    TraceFile_t file;
+    TraceRecord_t record;
+
+    makeRecords();
+    writeRecords();
+
+    TEST_ASSERT_TRUE(traceFileOpen(&file, TEST_TRACE_FILE));
+    TraceCursor_t *cursor = traceCursorCreate(&file);
+
+    TEST_ASSERT_EQUAL(0, traceFileFindBlock(&file, 255));
+    TEST_ASSERT_EQUAL(1, traceFileFindBlock(&file, 256));
+
+    for(size_t idx = 0; idx < sizeof(targets) / sizeof(targets[0]); idx++)
+    {
+        TEST_ASSERT_TRUE(traceCursorSeek(cursor, targets[idx]));
+        TEST_ASSERT_TRUE(traceCursorNext(cursor, &record));
+        TEST_ASSERT_EQUAL(0, memcmp(&record, &records[targets[idx]], sizeof(record)));
+    }
+    TEST_ASSERT_FALSE(traceCursorSeek(cursor, TEST_RECORDS));
+
+    traceCursorDestroy(cursor);
+    traceFileClose(&file);
+}
+
+void test_trace_file_without_index_is_rebuilt(void)
+{
+    TraceFile_t file;
+    TraceFileHeader_t header;
+    TraceRecord_t record;
+
+    makeRecords();
+    writeRecords();
+
+    // What a writer that never closed leaves behind
+    FILE *stream = fopen(TEST_TRACE_FILE, "r+b");
+    TEST_ASSERT_NOT_NULL(stream);
+    TEST_ASSERT_EQUAL(1, fread(&header, sizeof(header), 1, stream));
+    header.recordCount = 0;
+    header.blockCount = 0;
+    header.indexOffset = 0;
+    fseek(stream, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, stream);
+    fclose(stream);
+
+    TEST_ASSERT_TRUE(traceFileOpen(&file, TEST_TRACE_FILE));
+    TEST_ASSERT_TRUE(file.isIndexRebuilt);
+    TEST_ASSERT_EQUAL(TEST_RECORDS, file.recordCount);
+
+    TraceCursor_t *cursor = traceCursorCreate(&file);
+    TEST_ASSERT_TRUE(traceCursorSeek(cursor, 4321));
+    TEST_ASSERT_TRUE(traceCursorNext(cursor, &record));
+    TEST_ASSERT_EQUAL(0, memcmp(&record, &records[4321], sizeof(record)));
+
+    traceCursorDestroy(cursor);
+    traceFileClose(&file);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_trace_file_round_trip);
+    RUN_TEST(test_trace_file_seeks_to_any_record);
+    RUN_TEST(test_trace_file_without_index_is_rebuilt);
+    return UNITY_END();
+}
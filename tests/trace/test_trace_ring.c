@@ -0,0 +1,137 @@
+#include "unity.h"
+#include "trace_ring.h"
+#include "cpu/cpu.h"
+
+#include <string.h>
+
+/** @brief Records pushed by the threaded test */
+#define THREADED_RECORDS 200000
+
+/**
+ * @brief Sink of the threaded test, checks that the records arrive complete and in order
+ */
+typedef struct OrderSink_t
+{
+    qword_t expected;
+    bool isInOrder;
+} OrderSink_t;
+
+static void orderSink(void *context, const TraceRecord_t *records, size_t count)
+{
+    OrderSink_t *sink = (OrderSink_t *)context;
+
+    for(size_t idx = 0; idx < count; idx++)
+    {
+        if(records[idx].cycle != sink->expected++)
+        {
+            sink->isInOrder = false;
+        }
+    }
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_trace_ring_wraps_and_drops_when_full(void)
+{
+    TraceRing_t *ring = traceRingCreate(5, false);
+    TraceRecord_t record;
+    const TraceRecord_t *records;
+
+    memset(&record, 0x00, sizeof(record));
+    TEST_ASSERT_NOT_NULL(ring);
+    TEST_ASSERT_EQUAL(8, ring->capacity);
+
+    for(int idx = 0; idx < 10; idx++)
+    {
+        record.cycle = (qword_t)idx;
+        TEST_ASSERT_EQUAL(idx < 8, traceRingPush(ring, &record));
+    }
+    TEST_ASSERT_EQUAL(2, ring->dropped);
+
+    TEST_ASSERT_EQUAL(8, traceRingAcquire(ring, &records));
+    TEST_ASSERT_EQUAL(0, records[0].cycle);
+    traceRingRelease(ring, 6);
+
+    record.cycle = 100;
+    TEST_ASSERT_TRUE(traceRingPush(ring, &record));
+
+    // Up to the end of the buffer first, then the wrapped part
+    TEST_ASSERT_EQUAL(2, traceRingAcquire(ring, &records));
+    TEST_ASSERT_EQUAL(6, records[0].cycle);
+    traceRingRelease(ring, 2);
+    TEST_ASSERT_EQUAL(1, traceRingAcquire(ring, &records));
+    TEST_ASSERT_EQUAL(100, records[0].cycle);
+
+    traceRingDestroy(ring);
+}
+
+void test_trace_drain_delivers_every_record_in_order(void)
+{
+    TraceRing_t *ring = traceRingCreate(1024, true);
+    OrderSink_t sink = { 0, true };
+    TraceDrain_t drain;
+    TraceRecord_t record;
+
+    memset(&record, 0x00, sizeof(record));
+    TEST_ASSERT_TRUE(traceDrainStart(&drain, ring, orderSink, &sink));
+
+    for(qword_t idx = 0; idx < THREADED_RECORDS; idx++)
+    {
+        record.cycle = idx;
+        traceRingPush(ring, &record);
+    }
+
+    traceDrainStop(&drain);
+
+    TEST_ASSERT_TRUE(sink.isInOrder);
+    TEST_ASSERT_EQUAL(THREADED_RECORDS, sink.expected);
+    TEST_ASSERT_EQUAL(THREADED_RECORDS, drain.drained);
+    TEST_ASSERT_EQUAL(0, ring->dropped);
+
+    traceRingDestroy(ring);
+}
+
+void test_trace_records_retired_instructions(void)
+{
+    // LD A,0x12 / LD BC,0x3456 / HALT
+    byte_t code[] = { 0x3E, 0x12, 0x01, 0x56, 0x34, 0x76 };
+    TraceRing_t *ring = traceRingCreate(16, false);
+    const TraceRecord_t *records;
+    ZilogZ80_t cpu;
+
+    zilogZ80Init(&cpu);
+    memcpy(cpu.rom.data, code, sizeof(code));
+    cpu.trace = ring;
+    zilogZ80Run(&cpu, 1000);
+    cpu.trace = NULL;
+
+    TEST_ASSERT_EQUAL(3, traceRingAcquire(ring, &records));
+    TEST_ASSERT_EQUAL(0x0000, records[0].pc);
+    TEST_ASSERT_EQUAL(0x3E, records[0].opcode[0]);
+    TEST_ASSERT_EQUAL(0x12, records[0].opcode[1]);
+    TEST_ASSERT_EQUAL(0x12, records[0].af >> 8);
+    TEST_ASSERT_EQUAL(7, records[0].cycle);
+    TEST_ASSERT_EQUAL(0x0002, records[1].pc);
+    TEST_ASSERT_EQUAL(0x3456, records[1].bc);
+    TEST_ASSERT_EQUAL(17, records[1].cycle);
+    TEST_ASSERT_EQUAL(TRACE_FLAG_HALTED, records[2].flags & TRACE_FLAG_HALTED);
+
+    traceRingDestroy(ring);
+    memoryDestroy(&cpu.rom);
+    memoryDestroy(&cpu.ram);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_trace_ring_wraps_and_drops_when_full);
+    RUN_TEST(test_trace_drain_delivers_every_record_in_order);
+    RUN_TEST(test_trace_records_retired_instructions);
+    return UNITY_END();
+}